@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "meat_quality/cluster/coordinator.hpp"
+#include "meat_quality/cluster/sharded_store.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+constexpr NodeId kClusterNodes = 40000;  // the largest distribution center
+constexpr std::size_t kWindowSamples = 64;
+
+std::vector<RingMember> ring_of(MemberId n) {
+  std::vector<RingMember> members;
+  for (MemberId m = 1; m <= n; ++m) members.push_back({m, 1});
+  return members;
+}
+
+// Recomputing the shard map on a membership change.
+void BM_ShardMapBuild(benchmark::State& state) {
+  const auto members = ring_of(static_cast<MemberId>(state.range(0)));
+  for (auto _ : state) {
+    ShardMap map = ShardMap::build(members, 1);
+    benchmark::DoNotOptimize(map);
+  }
+}
+BENCHMARK(BM_ShardMapBuild)->Arg(4)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+// Ingest through the cluster-wide -> local slot mapping, one member of
+// four, against SampleStore::push on local ids.
+void BM_ShardedPush(benchmark::State& state) {
+  const ShardMap map = ShardMap::build(ring_of(4), 1);
+  ShardedSampleStore store(1, kClusterNodes / 3, kWindowSamples);
+  store.apply(map);
+  std::vector<NodeId> owned;
+  for (NodeId n = 0; n < kClusterNodes; ++n) {
+    if (map.owner_of(n) == 1) owned.push_back(n);
+  }
+  TraceGenerator gen(7);
+  std::uint64_t tick = 0;
+  for (auto _ : state) {
+    for (const NodeId n : owned) store.push(n, gen.sample(n, tick));
+    ++tick;
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(owned.size()));
+}
+BENCHMARK(BM_ShardedPush)->Unit(benchmark::kMicrosecond);
+
+// Full rebalance when a fifth member joins a four-member cluster holding
+// 40k nodes with full windows: export on the old owners, import on the new
+// one. Reports the fraction of nodes moved and the bytes on the wire.
+void BM_ShardRebalance(benchmark::State& state) {
+  const ShardMap before = ShardMap::build(ring_of(4), 1);
+  const ShardMap after = ShardMap::build(ring_of(5), 2);
+  std::size_t moved_nodes = 0, wire_bytes = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<std::unique_ptr<ShardedSampleStore>> members;
+    for (MemberId m = 1; m <= 5; ++m) {
+      members.push_back(
+          std::make_unique<ShardedSampleStore>(m, kClusterNodes / 2, kWindowSamples));
+      members.back()->apply(before);
+    }
+    TraceGenerator gen(7);
+    for (std::uint64_t t = 0; t < kWindowSamples; ++t) {
+      for (NodeId n = 0; n < kClusterNodes; ++n) {
+        members[before.owner_of(n) - 1]->push(n, gen.sample(n, t));
+      }
+    }
+    state.ResumeTiming();
+
+    moved_nodes = wire_bytes = 0;
+    std::vector<Rebalance> plans;
+    for (auto& m : members) plans.push_back(m->apply(after));
+    for (std::size_t i = 0; i < members.size(); ++i) {
+      for (const ShardId s : plans[i].outgoing) {
+        const std::vector<std::uint8_t> blob = members[i]->export_shard(s);
+        wire_bytes += blob.size();
+        moved_nodes += members[after.owner(s) - 1]->import_shard(blob).nodes;
+      }
+    }
+  }
+  state.counters["moved_fraction"] = static_cast<double>(moved_nodes) / kClusterNodes;
+  state.counters["wire_bytes_per_sample"] =
+      static_cast<double>(wire_bytes) / (static_cast<double>(moved_nodes) * kWindowSamples);
+}
+BENCHMARK(BM_ShardRebalance)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+}  // namespace
+}  // namespace meat_quality::bench
@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "meat_quality/core/simd.hpp"
+#include "meat_quality/image/color_lab.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+constexpr std::uint32_t kTile = 256;
+
+// A meat-like tile: reds and pinks with darker lean and brighter fat.
+std::vector<std::uint8_t> make_tile(std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> d(0, 255);
+  std::vector<std::uint8_t> px(std::size_t{kTile} * kTile * 3);
+  for (std::size_t i = 0; i < px.size(); i += 3) {
+    const int base = d(rng);
+    px[i] = static_cast<std::uint8_t>(128 + base / 2);
+    px[i + 1] = static_cast<std::uint8_t>(base / 3 + d(rng) / 8);
+    px[i + 2] = static_cast<std::uint8_t>(base / 3 + d(rng) / 8);
+  }
+  return px;
+}
+
+// Max and mean CIE76 error against the double-precision reference over a
+// lattice covering the whole RGB cube (every 3rd level per axis), converted
+// as whole rows so the vector kernels, not their scalar tails, are measured.
+void report_accuracy(benchmark::State& state, const LabConverter& conv) {
+  std::vector<std::uint8_t> px;
+  for (int r = 0; r < 256; r += 3) {
+    for (int g = 0; g < 256; g += 3) {
+      for (int b = 0; b < 256; b += 3) {
+        px.insert(px.end(), {static_cast<std::uint8_t>(r), static_cast<std::uint8_t>(g),
+                             static_cast<std::uint8_t>(b)});
+      }
+    }
+  }
+  const auto n = static_cast<std::uint32_t>(px.size() / 3);
+  LabImage out(n, 1);
+  conv.convert({px.data(), n, 1, px.size(), PixelFormat::kRgb8}, out.planes());
+  double max_de = 0, sum_de = 0;
+  for (std::uint32_t i = 0; i < n; ++i) {
+    const Lab got{out.planes().l[i], out.planes().a[i], out.planes().b[i]};
+    const double de = delta_e76(got, srgb_to_lab_exact(px[3 * i], px[3 * i + 1], px[3 * i + 2]));
+    max_de = std::max(max_de, de);
+    sum_de += de;
+  }
+  state.counters["max_dE"] = max_de;
+  state.counters["mean_dE"] = sum_de / double(n);
+  state.counters["table_MB"] = double(conv.table_bytes()) / (1 << 20);
+}
+
+void BM_RgbToLab(benchmark::State& state) {
+  const auto mode = static_cast<LabMode>(state.range(0));
+  const LabConverter conv(mode);
+  const std::vector<std::uint8_t> px = make_tile(5);
+  const ImageView tile{px.data(), kTile, kTile, std::size_t{kTile} * 3, PixelFormat::kRgb8};
+  LabImage out(kTile, kTile);
+  for (auto _ : state) {
+    conv.convert(tile, out.planes());
+    benchmark::DoNotOptimize(out.planes().l[0]);
+  }
+  state.SetItemsProcessed(state.iterations() * std::int64_t{kTile} * kTile);
+  report_accuracy(state, conv);
+  state.SetLabel(mode == LabMode::kExact ? "exact"
+                 : mode == LabMode::kLut ? "lut"
+                                         : std::string(simd_level_name(active_simd_level())));
+}
+BENCHMARK(BM_RgbToLab)->DenseRange(0, 2);
+
+}  // namespace
+}  // namespace meat_quality::bench
@@ -0,0 +1,178 @@
+// Compares a Google Benchmark JSON result file against a stored baseline and
+// fails when any benchmark got slower than the tolerance allows.
+//
+//   meat_quality_bench_compare <baseline.json> <results.json> [--tolerance=0.25]
+//
+// Reads the line-per-field layout Google Benchmark's JSON reporter writes.
+// With repetitions, the fastest repetition of each benchmark is compared
+// (the median if only aggregates were reported). Benchmarks measured in
+// real time (".../real_time") compare real time, the rest CPU time. Exits 1
+// on a regression, 2 on bad input.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Run {
+  std::string run_name;
+  std::string run_type;
+  std::string aggregate_name;
+  std::string time_unit = "ns";
+  double real_time = 0;
+  double cpu_time = 0;
+  bool error = false;
+};
+
+struct ResultFile {
+  std::string host;
+  std::string num_cpus;
+  std::map<std::string, double> times_ns;  // run name -> compared time
+  std::vector<std::string> order;
+};
+
+// Value of a `"key": value,` line, quotes stripped; empty if `line` has
+// another key.
+std::string field(const std::string& line, const std::string& key) {
+  const std::string tag = "\"" + key + "\":";
+  const std::size_t at = line.find(tag);
+  if (at == std::string::npos) return {};
+  std::size_t b = line.find_first_not_of(' ', at + tag.size());
+  std::size_t e = line.find_last_not_of(", \r");
+  if (b == std::string::npos || e == std::string::npos || e < b) return {};
+  if (line[b] == '"') ++b;
+  if (line[e] == '"') --e;
+  return line.substr(b, e + 1 - b);
+}
+
+double to_ns(double t, const std::string& unit) {
+  if (unit == "us") return t * 1e3;
+  if (unit == "ms") return t * 1e6;
+  if (unit == "s") return t * 1e9;
+  return t;
+}
+
+bool uses_real_time(const std::string& name) {
+  return name.find("/real_time") != std::string::npos;
+}
+
+bool load(const char* path, ResultFile& out) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "bench_compare: cannot open " << path << "\n";
+    return false;
+  }
+  std::vector<Run> runs;
+  Run cur;
+  bool in_benchmarks = false, in_run = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!in_benchmarks) {
+      if (std::string v = field(line, "host_name"); !v.empty()) out.host = v;
+      if (std::string v = field(line, "num_cpus"); !v.empty()) out.num_cpus = v;
+      if (line.find("\"benchmarks\":") != std::string::npos) in_benchmarks = true;
+      continue;
+    }
+    if (!in_run) {
+      if (line.find('{') != std::string::npos) {
+        in_run = true;
+        cur = {};
+      }
+      continue;
+    }
+    if (line.find('}') != std::string::npos && line.find('"') == std::string::npos) {
+      runs.push_back(cur);
+      in_run = false;
+      continue;
+    }
+    if (std::string v = field(line, "run_name"); !v.empty()) cur.run_name = v;
+    else if (std::string v = field(line, "run_type"); !v.empty()) cur.run_type = v;
+    else if (std::string v = field(line, "aggregate_name"); !v.empty()) cur.aggregate_name = v;
+    else if (std::string v = field(line, "time_unit"); !v.empty()) cur.time_unit = v;
+    else if (std::string v = field(line, "real_time"); !v.empty()) cur.real_time = std::atof(v.c_str());
+    else if (std::string v = field(line, "cpu_time"); !v.empty()) cur.cpu_time = std::atof(v.c_str());
+    else if (field(line, "error_occurred") == "true") cur.error = true;
+  }
+
+  // The fastest repetition is the least disturbed by other load on the
+  // machine. With --benchmark_report_aggregates_only only aggregates are
+  // written; fall back to the median then.
+  std::map<std::string, bool> has_iterations;
+  for (const Run& r : runs) {
+    if (r.run_type == "iteration") has_iterations[r.run_name] = true;
+  }
+  for (const Run& r : runs) {
+    if (r.error || r.run_name.empty()) continue;
+    const bool iteration = r.run_type == "iteration";
+    const bool median = r.run_type == "aggregate" && r.aggregate_name == "median" &&
+                        !has_iterations.count(r.run_name);
+    if (!iteration && !median) continue;
+    const double t =
+        to_ns(uses_real_time(r.run_name) ? r.real_time : r.cpu_time, r.time_unit);
+    auto [it, inserted] = out.times_ns.emplace(r.run_name, t);
+    if (inserted) out.order.push_back(r.run_name);
+    else if (t < it->second) it->second = t;
+  }
+  if (out.times_ns.empty()) {
+    std::cerr << "bench_compare: no benchmark runs in " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  double tolerance = 0.25;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--tolerance=", 0) == 0) tolerance = std::atof(arg.c_str() + 12);
+    else files.push_back(argv[i]);
+  }
+  if (files.size() != 2 || tolerance <= 0) {
+    std::cerr << "usage: meat_quality_bench_compare <baseline.json> <results.json>"
+                 " [--tolerance=0.25]\n";
+    return 2;
+  }
+  ResultFile base, now;
+  if (!load(files[0], base) || !load(files[1], now)) return 2;
+  if (base.host != now.host || base.num_cpus != now.num_cpus) {
+    std::printf("warning: baseline from %s (%s cpus), results from %s (%s cpus)\n",
+                base.host.c_str(), base.num_cpus.c_str(), now.host.c_str(),
+                now.num_cpus.c_str());
+  }
+
+  int regressions = 0;
+  std::printf("%-44s %14s %14s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+  for (const std::string& name : base.order) {
+    const double b = base.times_ns[name];
+    const auto it = now.times_ns.find(name);
+    if (it == now.times_ns.end()) {
+      std::printf("%-44s %14.0f %14s %9s  missing\n", name.c_str(), b, "-", "-");
+      continue;
+    }
+    const double change = it->second / b - 1.0;
+    const bool slower = change > tolerance;
+    regressions += slower ? 1 : 0;
+    std::printf("%-44s %14.0f %14.0f %+8.1f%%%s\n", name.c_str(), b, it->second, change * 100,
+                slower ? "  REGRESSION" : "");
+  }
+  for (const std::string& name : now.order) {
+    if (!base.times_ns.count(name)) {
+      std::printf("%-44s %14s %14.0f %9s  new\n", name.c_str(), "-", now.times_ns[name], "-");
+    }
+  }
+  if (regressions != 0) {
+    std::printf("%d benchmark(s) slower than the %.0f%% tolerance\n", regressions,
+                tolerance * 100);
+    return 1;
+  }
+  std::printf("no regressions beyond %.0f%%\n", tolerance * 100);
+  return 0;
+}
@@ -0,0 +1,214 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/features/feature_pipeline.hpp"
+#include "meat_quality/features/incremental_features.hpp"
+#include "meat_quality/features/sampling_rate.hpp"
+#include "meat_quality/features/window_features.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+// Restores the detected level when a benchmark that forced one finishes.
+struct ScopedSimdLevel {
+  explicit ScopedSimdLevel(SimdLevel level)
+      : previous(active_simd_level()), ok(set_simd_level(level)) {}
+  ~ScopedSimdLevel() { set_simd_level(previous); }
+  SimdLevel previous;
+  bool ok;
+};
+
+// One node, window of state.range(1) samples.
+void BM_WindowFeatures(benchmark::State& state) {
+  ScopedSimdLevel level(static_cast<SimdLevel>(state.range(0)));
+  if (!level.ok) {
+    state.SkipWithError("SIMD level not supported on this CPU");
+    return;
+  }
+  const auto window = static_cast<std::size_t>(state.range(1));
+  SampleStore store(1, window);
+  TraceGenerator(1).fill(store, window);
+  const WindowView view = store.latest(0, window);
+  const FeatureOptions options;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(extract_features(view, options));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(window));
+  state.SetLabel(std::string(simd_level_name(active_simd_level())));
+}
+
+// Every node of a gateway-sized store, one feature pass per node per tick.
+void BM_GatewayTick(benchmark::State& state) {
+  ScopedSimdLevel level(static_cast<SimdLevel>(state.range(0)));
+  if (!level.ok) {
+    state.SkipWithError("SIMD level not supported on this CPU");
+    return;
+  }
+  constexpr std::size_t kNodes = 512;
+  constexpr std::size_t kWindow = 600;  // one minute at 10 Hz
+  SampleStore store(kNodes, kWindow);
+  TraceGenerator(2).fill(store, kWindow);
+  const FeatureOptions options;
+  for (auto _ : state) {
+    for (NodeId n = 0; n < kNodes; ++n) {
+      benchmark::DoNotOptimize(extract_features(store.latest(n, kWindow), options));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNodes);
+  state.SetLabel(std::string(simd_level_name(active_simd_level())));
+}
+
+// The gateway tick for each SKU channel set (state.range(1): 0 gas only,
+// 1 gas + pH, 2 full) through the runtime-configured extract_features()
+// (state.range(2) == 0) or the fused extract_features_fixed<> (1).
+void BM_SkuGatewayTick(benchmark::State& state) {
+  ScopedSimdLevel level(static_cast<SimdLevel>(state.range(0)));
+  if (!level.ok) {
+    state.SkipWithError("SIMD level not supported on this CPU");
+    return;
+  }
+  constexpr std::size_t kNodes = 512;
+  constexpr std::size_t kWindow = 600;
+  SampleStore store(kNodes, kWindow);
+  TraceGenerator(2).fill(store, kWindow);
+  constexpr ChannelMask kSkus[] = {kGasOnlySku, kGasPhSku, kFullSku};
+  const ChannelMask mask = kSkus[state.range(1)];
+  const FeatureOptions options{FeatureOptions{}.ewma_alpha, mask};
+  const bool fixed = state.range(2) == 1;
+  const auto extract = [&](const WindowView& v) {
+    if (!fixed) return extract_features(v, options);
+    switch (state.range(1)) {
+      case 0: return extract_features_fixed<kGasOnlySku>(v);
+      case 1: return extract_features_fixed<kGasPhSku>(v);
+      default: return extract_features_fixed<kFullSku>(v);
+    }
+  };
+  for (auto _ : state) {
+    for (NodeId n = 0; n < kNodes; ++n) {
+      benchmark::DoNotOptimize(extract(store.latest(n, kWindow)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNodes);
+  static constexpr const char* kNames[] = {"gas", "gas+ph", "full"};
+  state.SetLabel(std::string(simd_level_name(active_simd_level())) + " " +
+                 kNames[state.range(1)] + (fixed ? " fixed" : " runtime"));
+}
+
+// One 10 Hz tick of a gateway: every node receives a sample and is scored
+// with the window sliding by one. state.range(0) is the FeatureMode,
+// state.range(1) the window length in samples.
+void BM_SlidingWindowTick(benchmark::State& state) {
+  constexpr std::size_t kNodes = 32;
+  const auto mode = static_cast<FeatureMode>(state.range(0));
+  const auto window = static_cast<std::size_t>(state.range(1));
+  SampleStore store(kNodes, window + 1024);
+  TraceGenerator gen(4);
+  gen.fill(store, window);
+  IncrementalFeatureTracker tracker(store, static_cast<Timestamp>(window - 1) * kTickMicros,
+                                    {}, mode);
+  for (NodeId n = 0; n < kNodes; ++n) tracker.update(n);
+  std::uint64_t tick = window;
+  for (auto _ : state) {
+    for (NodeId n = 0; n < kNodes; ++n) {
+      store.push(n, gen.sample(n, tick));
+      benchmark::DoNotOptimize(tracker.update(n));
+    }
+    ++tick;
+  }
+  state.SetItemsProcessed(state.iterations() * kNodes);
+  state.SetLabel(feature_mode_name(mode));
+  if (mode == FeatureMode::kValidate) {
+    const FeatureDrift& d = tracker.drift();
+    state.counters["max_rel_mean"] = d.max_rel_error[0];
+    state.counters["max_rel_variance"] = d.max_rel_error[1];
+    state.counters["max_rel_slope"] = d.max_rel_error[2];
+  }
+}
+
+// Five simulated hours of kNodes nodes, each reporting at the interval the
+// controller last gave it, over a 10-minute tracker window. Every node
+// starts spoiling within the run. Reports the traffic saved over the whole
+// run and over the first 90 minutes, while every node is still fresh, and
+// the worst delay, against the noise-free trace, before a node's first
+// report at or above the 10 ppm ammonia threshold.
+void BM_AdaptiveSampling(benchmark::State& state) {
+  constexpr std::size_t kNodes = 16;
+  constexpr std::uint64_t kTicks = 5 * 36'000;
+  constexpr std::uint64_t kWindowTicks = 6'000;
+  constexpr std::uint64_t kFreshTicks = 54'000;
+  std::uint64_t sent = 0, sent_fresh = 0;
+  double max_lag_s = 0;
+  for (auto _ : state) {
+    SampleStore store(kNodes, kWindowTicks + 1024);
+    IncrementalFeatureTracker tracker(store, static_cast<Timestamp>(kWindowTicks) * kTickMicros);
+    SamplingRateController rates(kNodes);
+    TraceGenerator gen(5);
+    std::vector<std::uint64_t> next(kNodes, 0), alarm(kNodes, kTicks);
+    sent = 0;
+    sent_fresh = 0;
+    for (std::uint64_t tick = 0; tick < kTicks; ++tick) {
+      for (NodeId n = 0; n < kNodes; ++n) {
+        if (tick < next[n]) continue;
+        const SensorSample s = gen.sample(n, tick);
+        store.push(n, s);
+        ++sent;
+        sent_fresh += tick < kFreshTicks;
+        if (s[Channel::kNh3] >= 10.0f) alarm[n] = std::min(alarm[n], tick);
+        const std::uint32_t interval = rates.update(n, tracker.update(n));
+        next[n] = tick + interval * 1000 / kTickMicros;
+      }
+    }
+    max_lag_s = 0;
+    for (NodeId n = 0; n < kNodes; ++n) {
+      // NH3 = 2 + 3 * expm1(0.4 * (hours - onset)) reaches 10 ppm here.
+      const double crossing_h = 0.2 * (n % 7) + std::log1p(8.0 / 3.0) / 0.4;
+      const double lag = double(alarm[n]) * kTickMicros * 1e-6 - crossing_h * 3600.0;
+      max_lag_s = std::max(max_lag_s, lag);
+    }
+    benchmark::DoNotOptimize(rates.stats());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(sent));
+  state.counters["volume_reduction"] = double(kNodes * kTicks) / double(sent);
+  state.counters["fresh_reduction"] = double(kNodes * kFreshTicks) / double(sent_fresh);
+  state.counters["max_alarm_lag_s"] = max_lag_s;
+}
+
+void simd_levels(benchmark::internal::Benchmark* b,
+                 std::initializer_list<std::int64_t> sizes) {
+  for (SimdLevel l : {SimdLevel::kScalar, SimdLevel::kAvx2, SimdLevel::kAvx512,
+                      SimdLevel::kNeon}) {
+    if (!ScopedSimdLevel(l).ok) continue;
+    for (std::int64_t n : sizes) b->Args({static_cast<std::int64_t>(l), n});
+  }
+}
+
+BENCHMARK(BM_WindowFeatures)->Apply([](benchmark::internal::Benchmark* b) {
+  simd_levels(b, {600, 36'000, 216'000});
+});
+BENCHMARK(BM_GatewayTick)->Apply([](benchmark::internal::Benchmark* b) {
+  simd_levels(b, {0});
+});
+BENCHMARK(BM_SkuGatewayTick)->Apply([](benchmark::internal::Benchmark* b) {
+  for (SimdLevel l : {SimdLevel::kScalar, SimdLevel::kAvx2, SimdLevel::kAvx512,
+                      SimdLevel::kNeon}) {
+    if (!ScopedSimdLevel(l).ok) continue;
+    b->ArgsProduct({{static_cast<std::int64_t>(l)}, {0, 1, 2}, {0, 1}});
+  }
+});
+
+BENCHMARK(BM_SlidingWindowTick)
+    ->ArgsProduct({{static_cast<std::int64_t>(FeatureMode::kFull),
+                    static_cast<std::int64_t>(FeatureMode::kIncremental)},
+                   {600, 36'000, 216'000}})
+    ->Args({static_cast<std::int64_t>(FeatureMode::kValidate), 36'000});
+
+BENCHMARK(BM_AdaptiveSampling)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace meat_quality::bench
@@ -0,0 +1,191 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "meat_quality/core/ingest_queue.hpp"
+#include "meat_quality/features/incremental_features.hpp"
+#include "meat_quality/grading/fusion_grader.hpp"
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/util/alloc_counter.hpp"
+#include "meat_quality/util/arena.hpp"
+#include "synthetic_image.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+// End-to-end grading of one tray: a one-hour sensor window plus, with
+// state.range(0) == 1, two 256x256 image crops. Reports heap allocations
+// per grade, which must be zero once the thread's arena is warm.
+void BM_GradeRequest(benchmark::State& state) {
+  constexpr std::size_t kWindow = 36'000;
+  SampleStore store(1, kWindow);
+  TraceGenerator(7).fill(store, kWindow);
+  const FreshnessClassifier model(ClassifierWeights::random(64, 3));
+  const LabConverter conv(LabMode::kSimd);
+  GradingOptions options;
+  options.window = kMicrosPerHour;
+  const GradingPipeline pipeline(store, model, conv, options);
+
+  const SyntheticImage img = make_carcass_image(1024, 512, 3, 1.0);
+  const ImageView crops[] = {img.view().crop(0, 0, 256, 256), img.view().crop(512, 256, 256, 256)};
+  GradingRequest req;
+  if (state.range(0) == 1) req.crops = crops;
+
+  benchmark::DoNotOptimize(pipeline.grade(req));  // warm the arena
+  const std::uint64_t blocks_before = Arena::heap_blocks_allocated();
+  std::uint64_t allocations = 0;
+  for (auto _ : state) {
+    const std::uint64_t before = thread_heap_allocations();
+    benchmark::DoNotOptimize(pipeline.grade(req));
+    allocations += thread_heap_allocations() - before;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["heap_allocs_per_grade"] =
+      heap_allocation_counting_enabled() ? double(allocations) / double(state.iterations()) : -1.0;
+  state.counters["arena_blocks_added"] = double(Arena::heap_blocks_allocated() - blocks_before);
+  state.SetLabel(state.range(0) == 1 ? "sensor+image" : "sensor");
+}
+BENCHMARK(BM_GradeRequest)->Arg(0)->Arg(1);
+
+// Dashboard traffic: single sensor-only queries over 256 nodes, each node
+// queried many times between its samples (one new sample per 16 queries
+// here), without and with (range(0) == 1) the result cache.
+void BM_RepeatedQueries(benchmark::State& state) {
+  constexpr std::size_t kNodes = 256;
+  constexpr std::size_t kWindow = 36'000;
+  SampleStore store(kNodes, kWindow + 1024);
+  TraceGenerator gen(5);
+  gen.fill(store, kWindow);
+  const FreshnessClassifier model(ClassifierWeights::random(64, 3));
+  const LabConverter conv(LabMode::kSimd);
+  GradingOptions options;
+  options.window = kMicrosPerHour;
+  GradingPipeline pipeline(store, model, conv, options);
+  GradeCache cache;
+  if (state.range(0) == 1) pipeline.set_result_cache(&cache);
+
+  std::uint64_t query = 0;
+  std::uint64_t tick = kWindow;
+  for (auto _ : state) {
+    const auto node = static_cast<NodeId>((query * 97) % kNodes);
+    if (query % 16 == 0) store.push(node, gen.sample(node, tick++));
+    ++query;
+    benchmark::DoNotOptimize(pipeline.grade({node, 0, {}}));
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.range(0) == 1) {
+    const GradeCacheStats s = cache.stats();
+    state.counters["hit_rate"] = double(s.memo_hits + s.feature_hits) / double(state.iterations());
+    state.counters["cache_bytes"] = double(s.bytes);
+  }
+  state.SetLabel(state.range(0) == 1 ? "cached" : "uncached");
+}
+BENCHMARK(BM_RepeatedQueries)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// One full 10 Hz gateway tick: every node's report goes through the ingest
+// queue into the store, then all nodes are graded in one batch from their
+// incrementally maintained one-hour windows, one tray with image crops.
+void BM_GatewayEndToEnd(benchmark::State& state) {
+  constexpr std::size_t kNodes = 256;
+  constexpr std::size_t kWindow = 36'000;
+  SampleStore store(kNodes, kWindow + 1024);
+  TraceGenerator gen(11);
+  gen.fill(store, kWindow);
+  const FreshnessClassifier model(ClassifierWeights::random(64, 3));
+  const LabConverter conv(LabMode::kSimd);
+  GradingOptions options;
+  options.window = kMicrosPerHour;
+  GradingPipeline pipeline(store, model, conv, options);
+  IncrementalFeatureTracker tracker(store, options.window, options.features);
+  pipeline.set_feature_tracker(&tracker);
+
+  const SyntheticImage img = make_carcass_image(1024, 512, 5, 1.0);
+  const ImageView crops[] = {img.view().crop(0, 0, 256, 256), img.view().crop(512, 256, 256, 256)};
+  std::vector<GradingRequest> requests(kNodes);
+  for (NodeId n = 0; n < kNodes; ++n) requests[n].node = n;
+  requests[0].crops = crops;
+  std::vector<GradeResult> results(kNodes);
+
+  IngestQueue queue(4096);
+  std::vector<IngestRecord> batch(512);
+  std::vector<IngestRecord> reports(kNodes);
+  std::uint64_t tick = kWindow;
+  pipeline.grade_batch(requests, results);  // seeds the tracker
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (NodeId n = 0; n < kNodes; ++n) reports[n] = {n, gen.sample(n, tick)};
+    ++tick;
+    state.ResumeTiming();
+    for (const IngestRecord& r : reports) queue.push(r);
+    std::size_t drained = 0;
+    while (drained < kNodes) {
+      drained += drain_batch(queue, store, batch, std::chrono::microseconds{0}).popped;
+    }
+    pipeline.grade_batch(requests, results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNodes);
+}
+BENCHMARK(BM_GatewayEndToEnd)->Unit(benchmark::kMicrosecond);
+
+// Gas, pH and image fusion over 256 trays with two 256x256 crops each:
+// every model on every tray (range(0) == 0) versus the early-exit cascade
+// (1). The random models have no real confidence profile, so the exit
+// margins are set at the quantiles that let the gas model decide 80% of
+// the trays and the pH model half of the rest, as on field data.
+void BM_FusionCascade(benchmark::State& state) {
+  constexpr std::size_t kNodes = 256;
+  constexpr std::size_t kWindow = 36'000;
+  SampleStore store(kNodes, kWindow);
+  TraceGenerator(13).fill(store, kWindow);
+  const FreshnessClassifier gas(ClassifierWeights::random(64, 3));
+  const FreshnessClassifier ph(ClassifierWeights::random(16, 4));
+  const ImageFreshnessModel image(ImageModelWeights::random(5));
+  const LabConverter conv(LabMode::kSimd);
+  FusionOptions options;
+  options.grading.window = kMicrosPerHour;
+
+  const SyntheticImage img = make_carcass_image(1024, 512, 3, 1.0);
+  const ImageView crops[] = {img.view().crop(0, 0, 256, 256), img.view().crop(512, 256, 256, 256)};
+  std::vector<GradingRequest> requests(kNodes);
+  for (NodeId n = 0; n < kNodes; ++n) requests[n] = {n, 0, crops};
+  std::vector<FusedGrade> results(kNodes);
+
+  const auto margin = [](const Prediction& p) {
+    std::array<float, kFreshnessClassCount> q = p.probabilities;
+    std::sort(q.begin(), q.end());
+    return q[kFreshnessClassCount - 1] - q[kFreshnessClassCount - 2];
+  };
+  options.exit_margin = {2.0f, 2.0f, 0.0f};
+  if (state.range(0) == 1) {
+    FusionGrader sensors(store, {&gas, &ph, nullptr}, conv, options);
+    sensors.grade_batch(requests, results);
+    std::vector<float> margins;
+    for (const FusedGrade& r : results) margins.push_back(margin(r.stages[0]));
+    std::sort(margins.begin(), margins.end());
+    options.exit_margin[0] = margins[kNodes / 5];
+    margins.clear();
+    for (const FusedGrade& r : results) {
+      if (margin(r.stages[0]) < options.exit_margin[0]) margins.push_back(margin(r.fused));
+    }
+    std::sort(margins.begin(), margins.end());
+    options.exit_margin[1] = margins[margins.size() / 2];
+  }
+  FusionGrader grader(store, {&gas, &ph, &image}, conv, options);
+
+  for (auto _ : state) {
+    grader.grade_batch(requests, results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  const FusionStats& s = grader.stats();
+  state.SetItemsProcessed(state.iterations() * kNodes);
+  state.counters["image_rate"] = double(s.runs[2]) / double(s.requests);
+  state.counters["gas_exit_rate"] = double(s.exits[0]) / double(s.requests);
+  state.SetLabel(state.range(0) == 1 ? "cascade" : "all models");
+}
+BENCHMARK(BM_FusionCascade)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace meat_quality::bench
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "meat_quality/inference/batching_engine.hpp"
+#include "meat_quality/inference/freshness_classifier.hpp"
+#include "meat_quality/inference/quantized_classifier.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+constexpr std::size_t kHidden = 64;
+
+std::vector<FeatureVector> make_inputs(std::size_t n) {
+  std::vector<FeatureVector> inputs(n);
+  for (std::size_t r = 0; r < n; ++r) {
+    for (std::size_t i = 0; i < kFeatureDim; ++i) {
+      inputs[r][i] = static_cast<float>((r * 31 + i * 7) % 97) / 97.0f;
+    }
+  }
+  return inputs;
+}
+
+// Raw forward pass cost per sample as a function of batch size.
+void BM_ClassifierForward(benchmark::State& state) {
+  const auto batch = static_cast<std::size_t>(state.range(0));
+  const FreshnessClassifier model(ClassifierWeights::random(kHidden, 3));
+  const auto inputs = make_inputs(batch);
+  std::vector<Prediction> out(batch);
+  std::vector<float> scratch(model.scratch_size(batch));
+  for (auto _ : state) {
+    model.predict(inputs.data(), batch, out.data(), scratch);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(batch));
+}
+BENCHMARK(BM_ClassifierForward)->RangeMultiplier(4)->Range(1, 256);
+
+// INT8 forward pass with the portable kernels (range(1) == 0) or the
+// plugin's dot-product kernels (1). Reports how often the INT8 label
+// matches the FP32 one and the parameter memory of both models.
+void BM_ClassifierForwardInt8(benchmark::State& state) {
+  const auto batch = static_cast<std::size_t>(state.range(0));
+  const ClassifierWeights weights = ClassifierWeights::random(kHidden, 3);
+  const FreshnessClassifier fp32(weights);
+  std::unique_ptr<Int8Backend> plugin;
+  if (state.range(1) == 1) {
+#if defined(MEAT_QUALITY_INT8_PLUGIN_PATH)
+    plugin = std::make_unique<Int8Backend>(Int8Backend::load(MEAT_QUALITY_INT8_PLUGIN_PATH));
+#else
+    state.SkipWithError("INT8 plugin not built");
+    return;
+#endif
+  }
+  const auto calibration = make_inputs(256);
+  const QuantizedClassifier model(quantize(weights, calibration),
+                                  plugin ? *plugin : Int8Backend::reference());
+  const auto inputs = make_inputs(batch);
+  std::vector<Prediction> out(batch);
+  std::vector<std::int32_t> scratch(model.scratch_size(batch));
+  for (auto _ : state) {
+    model.predict(inputs.data(), batch, out.data(), scratch);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(batch));
+
+  std::size_t agree = 0;
+  for (std::size_t r = 0; r < batch; ++r) agree += fp32.predict(inputs[r]).label == out[r].label;
+  state.counters["label_agreement"] = double(agree) / double(batch);
+  state.counters["fp32_bytes"] = double(sizeof(float) * (weights.w1.size() + weights.w2.size() +
+                                                         weights.b1.size() + weights.b2.size() +
+                                                         2 * kFeatureDim));
+  state.counters["int8_bytes"] = double(model.weights().parameter_bytes());
+  state.SetLabel(std::string(model.backend_name()));
+}
+BENCHMARK(BM_ClassifierForwardInt8)
+    ->ArgsProduct({benchmark::CreateRange(1, 256, 4), {0, 1}});
+
+// End-to-end engine throughput for a burst of requests under each preset.
+void BM_BatchingEngineBurst(benchmark::State& state) {
+  const FreshnessClassifier model(ClassifierWeights::random(kHidden, 3));
+  BatchingPolicy policy;
+  switch (state.range(0)) {
+    case 0: policy = BatchingPolicy::latency(); break;
+    case 1: policy = BatchingPolicy::balanced(); break;
+    default: policy = BatchingPolicy::throughput(); break;
+  }
+  BatchingEngine engine(model, policy);
+  constexpr std::size_t kBurst = 4096;
+  const auto inputs = make_inputs(kBurst);
+  std::atomic<std::size_t> done{0};
+  const auto on_done = [](void* ctx, const Prediction&) {
+    static_cast<std::atomic<std::size_t>*>(ctx)->fetch_add(1, std::memory_order_relaxed);
+  };
+  for (auto _ : state) {
+    for (const FeatureVector& f : inputs) {
+      while (!engine.submit(f, on_done, &done)) engine.drain();
+    }
+    engine.drain();
+  }
+  const BatchingStats s = engine.stats();
+  state.SetItemsProcessed(state.iterations() * kBurst);
+  state.counters["mean_batch"] = s.mean_batch_size();
+  state.counters["forward_us_per_batch"] =
+      s.batches == 0 ? 0.0 : double(s.forward_ns) / double(s.batches) / 1e3;
+  state.SetLabel(state.range(0) == 0 ? "latency"
+                 : state.range(0) == 1 ? "balanced" : "throughput");
+}
+BENCHMARK(BM_BatchingEngineBurst)->DenseRange(0, 2)->UseRealTime();
+
+}  // namespace
+}  // namespace meat_quality::bench
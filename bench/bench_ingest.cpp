@@ -0,0 +1,351 @@
+#include <benchmark/benchmark.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "meat_quality/core/ingest_queue.hpp"
+#include "meat_quality/core/node_registry.hpp"
+#include "meat_quality/features/spoilage_alert.hpp"
+#include "meat_quality/image/shm_frame_ring.hpp"
+#include "meat_quality/net/partitioned_grader.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+constexpr std::uint32_t kWidth = 1920;
+constexpr std::uint32_t kHeight = 1080;
+
+std::string ring_name() { return "/mq_bench_" + std::to_string(::getpid()); }
+
+// Sum of one byte per cache line: what any first pipeline stage must touch.
+std::uint64_t touch(const ImageView& v) {
+  std::uint64_t sum = 0;
+  for (std::uint32_t y = 0; y < v.height; ++y) {
+    const std::uint8_t* row = v.row(y);
+    for (std::size_t x = 0; x < v.row_bytes(); x += 64) sum += row[x];
+  }
+  return sum;
+}
+
+// Capture daemon publishes, grader maps the slot in place and releases it.
+void BM_ShmFrameZeroCopy(benchmark::State& state) {
+  const std::string name = ring_name();
+  ShmFrameWriter writer(name, kWidth, kHeight, 4);
+  ShmFrameSource source(name);
+  Timestamp ts = 0;
+  for (auto _ : state) {
+    std::uint8_t* px = writer.begin_frame();
+    px[0] = static_cast<std::uint8_t>(ts);
+    writer.publish(++ts);
+    FrameRef frame = source.acquire(std::chrono::milliseconds{0});
+    benchmark::DoNotOptimize(touch(frame.image()));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * std::int64_t{kWidth} * kHeight * 3);
+}
+BENCHMARK(BM_ShmFrameZeroCopy);
+
+// The previous integration: every frame copied into a std::vector first.
+void BM_ShmFrameCopied(benchmark::State& state) {
+  const std::string name = ring_name();
+  ShmFrameWriter writer(name, kWidth, kHeight, 4);
+  ShmFrameSource source(name);
+  std::vector<std::uint8_t> copy;
+  Timestamp ts = 0;
+  for (auto _ : state) {
+    std::uint8_t* px = writer.begin_frame();
+    px[0] = static_cast<std::uint8_t>(ts);
+    writer.publish(++ts);
+    FrameRef frame = source.acquire(std::chrono::milliseconds{0});
+    const ImageView& v = frame.image();
+    copy.assign(v.data, v.data + v.stride * v.height);
+    frame.reset();
+    const ImageView view{copy.data(), v.width, v.height, v.stride, v.format};
+    benchmark::DoNotOptimize(touch(view));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * std::int64_t{kWidth} * kHeight * 3);
+}
+BENCHMARK(BM_ShmFrameCopied);
+
+constexpr std::size_t kBurstPerProducer = 16384;
+constexpr std::size_t kDrainBatch = 256;
+
+// The previous hand-off: every receiver and the grader share one mutex.
+class MutexQueue {
+ public:
+  bool push(const IngestRecord& r) {
+    std::lock_guard lock(mutex_);
+    queue_.push(r);
+    return true;
+  }
+  std::size_t pop_batch(IngestRecord* out, std::size_t max) {
+    std::lock_guard lock(mutex_);
+    std::size_t n = 0;
+    for (; n < max && !queue_.empty(); ++n) {
+      out[n] = queue_.front();
+      queue_.pop();
+    }
+    return n;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::queue<IngestRecord> queue_;
+};
+
+// A door-open burst: `producers` receiver threads each push
+// kBurstPerProducer reports while the grader drains in batches. Reports the
+// worst single push() stall seen by any receiver.
+template <typename Queue>
+void run_burst(benchmark::State& state, Queue& queue) {
+  const auto producers = static_cast<std::size_t>(state.range(0));
+  const std::size_t total = producers * kBurstPerProducer;
+  std::vector<IngestRecord> batch(kDrainBatch);
+  std::int64_t max_stall_ns = 0;
+  for (auto _ : state) {
+    std::atomic<std::int64_t> stall{0};
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+      threads.emplace_back([&, p] {
+        std::int64_t worst = 0;
+        IngestRecord r;
+        r.node = static_cast<NodeId>(p);
+        for (std::size_t i = 0; i < kBurstPerProducer; ++i) {
+          r.sample.timestamp = static_cast<Timestamp>(i);
+          const auto t0 = std::chrono::steady_clock::now();
+          queue.push(r);
+          const auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - t0)
+                              .count();
+          worst = std::max<std::int64_t>(worst, dt);
+        }
+        std::int64_t seen = stall.load(std::memory_order_relaxed);
+        while (worst > seen && !stall.compare_exchange_weak(seen, worst)) {
+        }
+      });
+    }
+    std::size_t drained = 0;
+    while (drained < total) {
+      const std::size_t n = queue.pop_batch(batch.data(), batch.size());
+      if (n == 0) std::this_thread::yield();
+      drained += n;
+    }
+    for (std::thread& t : threads) t.join();
+    max_stall_ns = std::max(max_stall_ns, stall.load());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(total));
+  state.counters["max_push_stall_us"] = static_cast<double>(max_stall_ns) / 1e3;
+}
+
+void BM_IngestQueueBurst(benchmark::State& state) {
+  IngestQueue queue(8192, Backpressure::kBlock);
+  run_burst(state, queue);
+  state.counters["producer_waits"] =
+      static_cast<double>(queue.stats().producer_waits);
+  state.SetLabel("lock-free mpsc");
+}
+BENCHMARK(BM_IngestQueueBurst)->Arg(1)->Arg(4)->Arg(8)->Arg(16)->UseRealTime();
+
+void BM_MutexQueueBurst(benchmark::State& state) {
+  MutexQueue queue;
+  run_burst(state, queue);
+  state.SetLabel("mutex std::queue");
+}
+BENCHMARK(BM_MutexQueueBurst)->Arg(1)->Arg(4)->Arg(8)->Arg(16)->UseRealTime();
+
+// Samples from one producer flowing into a PartitionedGrader split into
+// `partitions` ranges. The topology is faked from the CPUs this process has,
+// so on a single-socket box this measures the routing and per-partition
+// drains rather than the remote-memory traffic partitioning avoids.
+void BM_PartitionedIngest(benchmark::State& state) {
+  constexpr std::size_t kNodes = 4096;
+  constexpr std::size_t kPerNode = 16;
+  const auto partitions = static_cast<std::size_t>(state.range(0));
+  const NumaTopology machine = NumaTopology::detect();
+  std::vector<NumaNode> fake;
+  for (std::size_t p = 0; p < partitions; ++p) {
+    fake.push_back({static_cast<int>(p), machine.node(0).cpus});
+  }
+  const FreshnessClassifier model(ClassifierWeights::random(64, 3));
+  const LabConverter conv(LabMode::kSimd);
+  PartitionedGraderOptions options;
+  options.node_count = kNodes;
+  options.capacity_per_node = kPerNode * 64;
+  PartitionedGrader grader(NumaTopology(std::move(fake)), model, conv, options);
+  grader.start();
+  Timestamp t = 0;
+  for (auto _ : state) {
+    const std::uint64_t target = grader.stats().samples + kNodes * kPerNode;
+    IngestRecord r;
+    for (std::size_t i = 0; i < kPerNode; ++i, ++t) {
+      r.sample.timestamp = t;
+      for (std::size_t n = 0; n < kNodes; ++n) {
+        r.node = static_cast<NodeId>(n);
+        while (!grader.push(r)) std::this_thread::yield();
+      }
+    }
+    while (grader.stats().samples < target) std::this_thread::yield();
+  }
+  grader.stop();
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(kNodes * kPerNode));
+  state.counters["rejected"] = static_cast<double>(grader.stats().rejected);
+}
+BENCHMARK(BM_PartitionedIngest)->Arg(1)->Arg(2)->UseRealTime();
+
+// Time from a temperature breach arriving to its alert during a load spike:
+// 32k routine samples, eight per node at 10 Hz, are queued just ahead of it. range(0) = 0 evaluates
+// the alert rules in the grading loop after each drain, behind a 2 ms
+// grading pass per batch; 1 sends the samples through an AlertLane too.
+void BM_AlertLatency(benchmark::State& state) {
+  constexpr std::size_t kNodes = 4096;
+  constexpr std::size_t kBacklog = 32768;
+  constexpr auto kGradingPass = std::chrono::milliseconds{2};
+  const bool lane_path = state.range(0) == 1;
+  IngestQueue queue(kBacklog * 2, Backpressure::kReject);
+  SampleStore store(kNodes, 64);
+  std::atomic<std::uint64_t> alerted{0};
+  AlertLaneOptions lane_options;
+  lane_options.node_count = kNodes;
+  lane_options.capacity = kBacklog * 2;
+  // Only the limit rule, so each breach raises exactly one alert.
+  lane_options.alerts.max_rise.fill(AlertOptions::kNoLimit);
+  AlertLane lane([&](const SpoilageAlert&) { alerted.fetch_add(1); }, lane_options);
+  lane.start();
+
+  std::atomic<bool> stop{false};
+  std::thread grading([&] {
+    AlertEvaluator evaluator(kNodes, lane_options.alerts);
+    std::array<SpoilageAlert, AlertEvaluator::kMaxAlertsPerSample> raised;
+    std::vector<IngestRecord> batch(kDrainBatch * 2);
+    while (!stop.load(std::memory_order_relaxed)) {
+      const DrainResult r = drain_batch(queue, store, batch, std::chrono::milliseconds{1});
+      if (r.popped == 0) continue;
+      if (!lane_path) {
+        for (std::size_t i = 0; i < r.popped; ++i) {
+          alerted.fetch_add(evaluator.update(batch[i].node, batch[i].sample, raised));
+        }
+      }
+      const auto until = std::chrono::steady_clock::now() + kGradingPass;
+      while (std::chrono::steady_clock::now() < until) {
+      }
+    }
+  });
+
+  constexpr Timestamp kTick = 100'000;
+  Timestamp t = 1;
+  std::uint64_t worst_ns = 0;
+  for (auto _ : state) {
+    const std::uint64_t target = alerted.load() + 1;
+    IngestRecord r;
+    r.sample.values = {1.0f, 0.1f, 100.0f, 3.0f, 80.0f, 6.0f};
+    for (std::size_t i = 0; i < kBacklog; ++i) {
+      r.node = static_cast<NodeId>(1 + i % (kNodes - 1));
+      r.sample.timestamp = (t + static_cast<Timestamp>(i / (kNodes - 1))) * kTick;
+      queue.push(r);
+      if (lane_path) lane.push(r);
+    }
+    t += kBacklog / (kNodes - 1) + 1;
+    const std::uint64_t start = telemetry::now_ns();
+    r.node = 0;
+    r.sample[Channel::kTemperature] = 9.0f;
+    for (int k = 0; k < 2; ++k) {
+      r.sample.timestamp = t++ * kTick;
+      queue.push(r);
+      if (lane_path) lane.push(r);
+    }
+    while (alerted.load() < target) std::this_thread::yield();
+    const std::uint64_t latency = telemetry::now_ns() - start;
+    worst_ns = std::max(worst_ns, latency);
+    state.SetIterationTime(static_cast<double>(latency) * 1e-9);
+
+    // Next iteration: the smoothed level back below the rearm level, both
+    // queues drained.
+    r.sample[Channel::kTemperature] = 3.0f;
+    for (int k = 0; k < 4; ++k) {
+      r.sample.timestamp = t++ * kTick;
+      queue.push(r);
+      if (lane_path) lane.push(r);
+    }
+    while (queue.size_approx() != 0) std::this_thread::yield();
+  }
+  stop.store(true);
+  grading.join();
+  lane.stop();
+  state.counters["worst_ms"] = static_cast<double>(worst_ns) * 1e-6;
+  state.SetLabel(lane_path ? "alert lane" : "grading loop");
+}
+BENCHMARK(BM_AlertLatency)->Arg(0)->Arg(1)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+constexpr std::size_t kRegisteredNodes = 4096;
+
+// The previous registry: a map behind a reader-writer lock.
+class SharedMutexRegistry {
+ public:
+  explicit SharedMutexRegistry(const std::vector<NodeRecord>& records) {
+    for (const NodeRecord& r : records) map_.emplace(r.node, r);
+  }
+  bool lookup(NodeId node, NodeRecord& out) const {
+    std::shared_lock lock(mutex_);
+    const auto it = map_.find(node);
+    if (it == map_.end()) return false;
+    out = it->second;
+    return true;
+  }
+
+ private:
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<NodeId, NodeRecord> map_;
+};
+
+std::vector<NodeRecord> registered_nodes() {
+  std::vector<NodeRecord> records(kRegisteredNodes);
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    records[i].node = static_cast<NodeId>(i);
+    records[i].shard = static_cast<std::uint32_t>(i % 64);
+  }
+  return records;
+}
+
+// The per-sample registry lookup of every receiver thread, with
+// state.threads() receivers looking up nodes at once and no updates.
+template <typename Registry>
+void run_lookups(benchmark::State& state, const Registry& registry) {
+  NodeRecord record;
+  std::uint64_t x = static_cast<std::uint64_t>(state.thread_index()) + 1;
+  std::uint64_t found = 0;
+  for (auto _ : state) {
+    x = x * 6364136223846793005ull + 1442695040888963407ull;
+    found += registry.lookup(static_cast<NodeId>((x >> 33) % kRegisteredNodes), record);
+  }
+  benchmark::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RegistryLookup(benchmark::State& state) {
+  static const NodeRegistry registry(registered_nodes());
+  run_lookups(state, registry);
+  state.SetLabel("rcu snapshot");
+}
+BENCHMARK(BM_RegistryLookup)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+void BM_SharedMutexLookup(benchmark::State& state) {
+  static const SharedMutexRegistry registry(registered_nodes());
+  run_lookups(state, registry);
+  state.SetLabel("shared_mutex map");
+}
+BENCHMARK(BM_SharedMutexLookup)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+}  // namespace
+}  // namespace meat_quality::bench
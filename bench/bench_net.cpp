@@ -0,0 +1,206 @@
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/net/front_end.hpp"
+#include "meat_quality/net/protocol.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+constexpr NodeId kNodes = 256;
+
+int connect_to(std::uint16_t port) {
+  const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) {
+    if (fd >= 0) ::close(fd);
+    return -1;
+  }
+  const int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+  return fd;
+}
+
+bool read_exact(int fd, std::uint8_t* p, std::size_t n) {
+  while (n != 0) {
+    const ssize_t r = ::read(fd, p, n);
+    if (r <= 0) return false;
+    p += r;
+    n -= static_cast<std::size_t>(r);
+  }
+  return true;
+}
+
+// Heap bytes in use, process-wide.
+std::size_t heap_bytes() { return ::mallinfo2().uordblks; }
+
+// A grader behind the front end: one grading thread draining pushes and
+// serving grade queries, as in the FrontEnd example.
+struct Service {
+  Service()
+      : store(kNodes, 4096),
+        classifier(ClassifierWeights::random(32, 1)),
+        pipeline(store, classifier, converter),
+        queue(1 << 16, Backpressure::kReject),
+        front_end(queue, broker, {.port = 0, .threads = 2}) {
+    TraceGenerator(3).fill(store, 3600);
+    front_end.start();
+    grader = std::thread([this] {
+      std::vector<IngestRecord> batch(1024);
+      while (running.load(std::memory_order_relaxed)) {
+        drain_batch(queue, store, batch, std::chrono::microseconds{20});
+        broker.serve(pipeline);
+      }
+    });
+  }
+  ~Service() {
+    // The grading thread keeps serving until every connection has closed.
+    front_end.stop();
+    running = false;
+    grader.join();
+  }
+
+  SampleStore store;
+  FreshnessClassifier classifier;
+  LabConverter converter;
+  GradingPipeline pipeline;
+  IngestQueue queue;
+  GradeBroker broker;
+  FrontEnd front_end;
+  std::atomic<bool> running{true};
+  std::thread grader;
+};
+
+// Round trip of one "grade this tray now" query while `range(0)` other
+// connections sit idle on the same front end.
+void BM_FrontEndGrade(benchmark::State& state) {
+  Service service;
+  const std::size_t heap_before = heap_bytes();
+  std::vector<int> idle;
+  for (std::int64_t i = 0; i < state.range(0); ++i) {
+    const int fd = connect_to(service.front_end.port());
+    if (fd < 0) break;
+    idle.push_back(fd);
+  }
+  while (service.front_end.stats().accepted < idle.size()) std::this_thread::yield();
+  const std::size_t heap_idle = heap_bytes() - heap_before;
+  if (static_cast<std::int64_t>(idle.size()) != state.range(0)) {
+    state.SkipWithError("could not open the idle connections (file descriptor limit?)");
+  }
+
+  const int fd = connect_to(service.front_end.port());
+  std::vector<std::uint8_t> request;
+  std::uint8_t response[wire::kFrameHeaderBytes + wire::kGradeResponseBytes];
+  std::uint64_t id = 0;
+  for (auto _ : state) {
+    request.clear();
+    wire::append_grade_request(request, {id, static_cast<NodeId>(id % kNodes), 0});
+    ++id;
+    if (::write(fd, request.data(), request.size()) != static_cast<ssize_t>(request.size()) ||
+        !read_exact(fd, response, sizeof response)) {
+      state.SkipWithError("connection lost");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (!idle.empty()) {
+    state.counters["bytes_per_idle_connection"] =
+        static_cast<double>(heap_idle) / static_cast<double>(idle.size());
+  }
+  ::close(fd);
+  for (int c : idle) ::close(c);
+}
+BENCHMARK(BM_FrontEndGrade)->Arg(0)->Arg(4096)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Sensor push throughput of one gateway connection in frames of 64 samples.
+void BM_FrontEndPush(benchmark::State& state) {
+  Service service;
+  const int fd = connect_to(service.front_end.port());
+  TraceGenerator gen(9);
+  std::vector<IngestRecord> records(64);
+  std::vector<std::uint8_t> frame;
+  std::uint64_t tick = 3600;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < records.size(); ++i) {
+      const NodeId node = static_cast<NodeId>(i % kNodes);
+      records[i] = {node, gen.sample(node, tick)};
+    }
+    ++tick;
+    frame.clear();
+    wire::append_sensor_push(frame, records);
+    if (::write(fd, frame.data(), frame.size()) != static_cast<ssize_t>(frame.size())) {
+      state.SkipWithError("connection lost");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(records.size()));
+  ::close(fd);
+}
+BENCHMARK(BM_FrontEndPush)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// A truck gateway's uplink batch, 64 samples from each of 16 nodes grouped
+// by node, decoded straight into a SampleStore. state.range(0) picks the
+// framing: 0 = fixed-width kSensorPush, 1 = delta-packed kPackedPush.
+void BM_SensorPushDecode(benchmark::State& state) {
+  constexpr NodeId kGatewayNodes = 16;
+  constexpr std::size_t kPerNode = 64;
+  const bool packed = state.range(0) != 0;
+  TraceGenerator gen(10);
+  std::vector<IngestRecord> records;
+  for (NodeId n = 0; n < kGatewayNodes; ++n) {
+    for (std::size_t i = 0; i < kPerNode; ++i) records.push_back({n, gen.sample(n, 3600 + i)});
+  }
+  std::vector<std::uint8_t> frame;
+  if (packed) {
+    wire::append_packed_push(frame, records);
+  } else {
+    wire::append_sensor_push(frame, records);
+  }
+  const std::span<const std::uint8_t> body(frame.data() + wire::kFrameHeaderBytes,
+                                           frame.size() - wire::kFrameHeaderBytes);
+  SampleStore store(kGatewayNodes, 4096);
+  Timestamp shift = 0;
+  for (auto _ : state) {
+    // Later batches continue in time so the store keeps accepting them.
+    std::uint32_t count = 0;
+    if (packed) {
+      if (!wire::parse_packed_push(body, count)) state.SkipWithError("bad frame");
+      wire::PackedPushReader reader(body);
+      for (IngestRecord r; reader.next(r);) {
+        r.sample.timestamp += shift;
+        store.push(r.node, r.sample);
+      }
+    } else {
+      if (!wire::parse_sensor_push(body, count)) state.SkipWithError("bad frame");
+      for (std::uint32_t i = 0; i < count; ++i) {
+        IngestRecord r = wire::sensor_record(body.data(), i);
+        r.sample.timestamp += shift;
+        store.push(r.node, r.sample);
+      }
+    }
+    shift += static_cast<Timestamp>(kPerNode) * kTickMicros;
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(records.size()));
+  state.counters["bytes_per_sample"] = double(frame.size()) / double(records.size());
+  state.SetLabel(packed ? "packed" : "fixed");
+}
+BENCHMARK(BM_SensorPushDecode)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace meat_quality::bench
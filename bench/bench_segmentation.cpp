@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/grading/batch_image_grader.hpp"
+#include "meat_quality/image/accel_backend.hpp"
+#include "meat_quality/image/color_lab.hpp"
+#include "meat_quality/image/marbling.hpp"
+#include "meat_quality/image/roi.hpp"
+#include "synthetic_image.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+// Full 1080p frame through Lab conversion, thresholding and labelling, on
+// state.range(0) pool threads.
+void BM_MarblingSegmentation(benchmark::State& state) {
+  const SyntheticImage img = make_carcass_image(1920, 1080, 11);
+  WorkStealingPool pool(static_cast<std::size_t>(state.range(0)));
+  const LabConverter conv(LabMode::kSimd);
+  const MarblingSegmenter seg(pool, conv);
+  MarblingResult r;
+  for (auto _ : state) {
+    r = seg.segment(img.view());
+    benchmark::DoNotOptimize(r);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["flecks"] = r.fleck_count;
+  state.counters["fat_ratio"] = r.fat_ratio();
+}
+BENCHMARK(BM_MarblingSegmentation)
+    ->Apply([](benchmark::internal::Benchmark* b) {
+      const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+      for (unsigned t = 1; t < hw; t *= 2) b->Arg(t);
+      b->Arg(hw);
+    })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Same frame, but the meat region is found on the 1/8 pyramid level first
+// and only its tiles are segmented; the detection is part of the timing.
+void BM_MarblingSegmentationRoi(benchmark::State& state) {
+  const SyntheticImage img = make_carcass_image(1920, 1080, 11);
+  WorkStealingPool pool(static_cast<std::size_t>(state.range(0)));
+  const LabConverter conv(LabMode::kSimd);
+  const MarblingSegmenter seg(pool, conv);
+  RoiDetector roi(conv);
+  MarblingResult r;
+  double coverage = 0;
+  for (auto _ : state) {
+    const RoiMap& map = roi.detect(img.view());
+    r = seg.segment(img.view(), map);
+    coverage = map.coverage();
+    benchmark::DoNotOptimize(r);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["flecks"] = r.fleck_count;
+  state.counters["fat_ratio"] = r.fat_ratio();
+  state.counters["roi_coverage"] = coverage;
+}
+BENCHMARK(BM_MarblingSegmentationRoi)
+    ->Apply([](benchmark::internal::Benchmark* b) {
+      const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+      for (unsigned t = 1; t < hw; t *= 2) b->Arg(t);
+      b->Arg(hw);
+    })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// A nightly re-grade batch: 32 archived 960x540 photos through
+// BatchImageGrader. range(0) selects the reference CPU stages (0) or the
+// CUDA plugin (1).
+void BM_BatchImageGrade(benchmark::State& state) {
+  std::unique_ptr<ImageAccelBackend> plugin;
+  if (state.range(0) == 1) {
+#if defined(MEAT_QUALITY_CUDA_PLUGIN_PATH)
+    plugin = std::make_unique<ImageAccelBackend>(
+        ImageAccelBackend::load(MEAT_QUALITY_CUDA_PLUGIN_PATH));
+#else
+    state.SkipWithError("CUDA plugin not built");
+    return;
+#endif
+  }
+  std::vector<SyntheticImage> images;
+  std::vector<ImageView> views;
+  for (std::uint32_t i = 0; i < 32; ++i) images.push_back(make_carcass_image(960, 540, 40 + i));
+  for (const SyntheticImage& img : images) views.push_back(img.view());
+  std::vector<ImageGrade> out(views.size());
+  BatchImageGrader grader(plugin ? *plugin : ImageAccelBackend::reference());
+  for (auto _ : state) {
+    grader.grade(views, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(views.size()));
+  state.counters["flecks"] = out.front().marbling.fleck_count;
+  state.SetLabel(std::string(grader.backend_name()));
+}
+BENCHMARK(BM_BatchImageGrade)->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace meat_quality::bench
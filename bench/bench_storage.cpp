@@ -0,0 +1,246 @@
+#include <benchmark/benchmark.h>
+
+#include <unistd.h>
+
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "meat_quality/grading/replay_engine.hpp"
+#include "meat_quality/storage/segment.hpp"
+#include "meat_quality/storage/snapshot.hpp"
+#include "meat_quality/storage/tiered_history.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+constexpr NodeId kNodes = 4;
+constexpr std::uint64_t kTicks = 24 * 3600 * 10;  // one day at 10 Hz
+constexpr NodeId kReplayNode = 1;
+
+// One day of history for a few nodes, written once, plus the same data for
+// kReplayNode as the CSV dump the audit jobs used to parse.
+struct History {
+  History() {
+    path = (std::filesystem::temp_directory_path() /
+            ("mq_bench_" + std::to_string(::getpid()) + ".seg"))
+               .string();
+    TraceGenerator gen(42);
+    SegmentWriter writer(path);
+    char line[256];
+    for (std::uint64_t t = 0; t < kTicks; ++t) {
+      for (NodeId n = 0; n < kNodes; ++n) {
+        const SensorSample s = gen.sample(n, t);
+        writer.append(n, s);
+        if (n != kReplayNode) continue;
+        const int len = std::snprintf(
+            line, sizeof line, "%lld,%g,%g,%g,%g,%g,%g\n",
+            static_cast<long long>(s.timestamp), s.values[0], s.values[1], s.values[2],
+            s.values[3], s.values[4], s.values[5]);
+        csv.append(line, static_cast<std::size_t>(len));
+      }
+    }
+    writer.finish();
+    segment_bytes = writer.bytes_written();
+  }
+  ~History() { std::filesystem::remove(path); }
+
+  std::string path;
+  std::string csv;
+  std::uint64_t segment_bytes = 0;
+};
+
+const History& history() {
+  static const History h;
+  return h;
+}
+
+void report(benchmark::State& state, std::size_t samples) {
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(samples));
+  state.counters["segment_bytes_per_sample"] =
+      static_cast<double>(history().segment_bytes) / (kNodes * kTicks);
+  state.counters["csv_bytes_per_sample"] =
+      static_cast<double>(history().csv.size()) / kTicks;
+}
+
+// Decodes all of one node's day: every block, every channel.
+void BM_SegmentScan(benchmark::State& state) {
+  SegmentReader reader(history().path);
+  SegmentQuery query;
+  query.node = kReplayNode;
+  std::size_t samples = 0;
+  for (auto _ : state) {
+    double sum = 0;
+    samples = reader.scan(query, [&](const DecodedBlock& b) {
+      for (float v : b.channels[index_of(Channel::kNh3)]) sum += v;
+    }).samples;
+    benchmark::DoNotOptimize(sum);
+  }
+  report(state, samples);
+}
+BENCHMARK(BM_SegmentScan)->Unit(benchmark::kMillisecond);
+
+// Audit query "when did NH3 exceed 20 ppm": per-block max skips the rest.
+void BM_SegmentScanFiltered(benchmark::State& state) {
+  SegmentReader reader(history().path);
+  SegmentQuery query;
+  query.node = kReplayNode;
+  query.channels = mask_of(Channel::kNh3);
+  query.range = ValueRange{Channel::kNh3, 20.0f};
+  std::size_t samples = 0;
+  ScanStats stats;
+  for (auto _ : state) {
+    std::size_t hits = 0;
+    stats = reader.scan(query, [&](const DecodedBlock& b) {
+      for (float v : b.channels[index_of(Channel::kNh3)]) hits += v > 20.0f;
+    });
+    samples = stats.samples;
+    benchmark::DoNotOptimize(hits);
+  }
+  report(state, samples);
+  state.counters["blocks_skipped"] = static_cast<double>(stats.blocks_skipped);
+  state.counters["blocks_considered"] = static_cast<double>(stats.blocks_considered);
+}
+BENCHMARK(BM_SegmentScanFiltered)->Unit(benchmark::kMillisecond);
+
+// Baseline: the same day parsed from an in-memory CSV dump.
+void BM_CsvParse(benchmark::State& state) {
+  const std::string& csv = history().csv;
+  std::size_t samples = 0;
+  for (auto _ : state) {
+    double sum = 0;
+    samples = 0;
+    const char* p = csv.data();
+    const char* end = p + csv.size();
+    while (p < end) {
+      long long ts = 0;
+      p = std::from_chars(p, end, ts).ptr + 1;
+      float v[kChannelCount];
+      for (float& x : v) p = std::from_chars(p, end, x).ptr + 1;
+      sum += v[0] + static_cast<double>(ts & 1);
+      ++samples;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  report(state, samples);
+}
+BENCHMARK(BM_CsvParse)->Unit(benchmark::kMillisecond);
+
+// Audit query: hourly min/max/mean of one node's day. range(0) = 0 leaves
+// the day in its raw segment, so every sample is decoded and rolled up; 1
+// compacts it into the rollup tiers first and reads the 1 h tier.
+void BM_AuditRollup(benchmark::State& state) {
+  const std::filesystem::path root = std::filesystem::temp_directory_path() /
+                                     ("mq_bench_" + std::to_string(::getpid()) + "_tiers");
+  std::filesystem::create_directories(root);
+  std::filesystem::copy_file(history().path, root / "day.mqseg",
+                             std::filesystem::copy_options::overwrite_existing);
+  std::uint64_t rollup_bytes = 0;
+  {
+    TieredHistoryOptions options;
+    options.raw_directory = root.string();
+    options.raw_retention = kDayMicros;
+    TieredHistory tiers(options);
+    if (state.range(0) == 1) {
+      rollup_bytes = tiers.compact(3 * kDayMicros).rollup_bytes_written;
+    }
+    HistoryQuery query;
+    query.node = kReplayNode;
+    query.resolution = kHourMicros;
+    std::vector<rollup::Bucket> out;
+    HistoryStats stats;
+    for (auto _ : state) {
+      out.clear();
+      stats = tiers.query(query, out);
+      benchmark::DoNotOptimize(out.data());
+    }
+    state.counters["buckets"] = static_cast<double>(out.size());
+    state.counters["raw_samples"] = static_cast<double>(stats.raw_samples);
+    state.counters["tier_buckets"] = static_cast<double>(stats.rollup_buckets);
+  }
+  if (rollup_bytes != 0) {
+    state.counters["rollup_bytes_per_raw_byte"] =
+        static_cast<double>(rollup_bytes) / static_cast<double>(history().segment_bytes);
+  }
+  std::filesystem::remove_all(root);
+}
+BENCHMARK(BM_AuditRollup)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Back-test of the whole day: every node graded every 5 minutes over a
+// one-hour window, streamed from the segment through the production
+// pipeline on all cores.
+void BM_ReplayRegrade(benchmark::State& state) {
+  const SegmentReader reader(history().path);
+  const SegmentReader* segments[] = {&reader};
+  const FreshnessClassifier classifier(ClassifierWeights::random(64, 1));
+  const LabConverter converter;
+  WorkStealingPool pool;
+  ReplayOptions options;
+  options.step = 300 * kMicrosPerSecond;
+  options.grading.window = kMicrosPerHour;
+  options.nodes_per_task = 1;  // one task per node keeps every core busy
+  const ReplayEngine engine(pool, classifier, converter, options);
+  ReplayStats stats;
+  for (auto _ : state) {
+    std::uint64_t delivered = 0;
+    stats = engine.run(segments, [&](std::span<const GradeResult> r) { delivered += r.size(); });
+    benchmark::DoNotOptimize(delivered);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(stats.grades));
+  state.counters["samples_replayed"] = static_cast<double>(stats.samples);
+  // Simulated time per second of wall time.
+  state.counters["x_realtime"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * double(kTicks * kTickMicros) / kMicrosPerSecond,
+      benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ReplayRegrade)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+constexpr std::size_t kHidden = 64;
+constexpr std::size_t kCalibratedNodes = 4096;
+
+// Startup the way a grading process does it without a snapshot: build the
+// color LUT and the classifier from scratch.
+void BM_ColdStart(benchmark::State& state) {
+  const ClassifierWeights weights = ClassifierWeights::random(kHidden, 1);
+  for (auto _ : state) {
+    const LabConverter lut(LabMode::kLut);
+    const FreshnessClassifier classifier(weights);
+    benchmark::DoNotOptimize(lut.convert(200, 40, 40));
+    benchmark::DoNotOptimize(classifier.hidden());
+  }
+}
+BENCHMARK(BM_ColdStart)->Unit(benchmark::kMillisecond);
+
+// The same objects (plus per-node calibration) from a mapped snapshot. The
+// file stays in the page cache, as it would for the second process on a
+// gateway; the first conversion touches only the LUT pages it needs.
+void BM_SnapshotLoad(benchmark::State& state) {
+  const std::string path = (std::filesystem::temp_directory_path() /
+                            ("mq_bench_" + std::to_string(::getpid()) + ".snap"))
+                               .string();
+  {
+    const LabConverter lut(LabMode::kLut);
+    const FreshnessClassifier classifier(ClassifierWeights::random(kHidden, 1));
+    const std::vector<NodeCalibration> calibration(kCalibratedNodes, NodeCalibration::identity());
+    write_snapshot(path, {&classifier, &lut, calibration});
+  }
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    const Snapshot snapshot(path);
+    const LabConverter lut = snapshot.lab_converter();
+    const FreshnessClassifier classifier = snapshot.classifier();
+    benchmark::DoNotOptimize(lut.convert(200, 40, 40));
+    benchmark::DoNotOptimize(classifier.hidden());
+    benchmark::DoNotOptimize(snapshot.calibration().data());
+    bytes = snapshot.file_bytes();
+  }
+  state.counters["snapshot_bytes"] = static_cast<double>(bytes);
+  std::filesystem::remove(path);
+}
+BENCHMARK(BM_SnapshotLoad)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace meat_quality::bench
@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "meat_quality/core/ingest_queue.hpp"
+#include "meat_quality/features/incremental_features.hpp"
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/telemetry/telemetry.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality::bench {
+namespace {
+
+void BM_HistogramRecord(benchmark::State& state) {
+  telemetry::Histogram h;
+  std::uint64_t v = 1;
+  for (auto _ : state) {
+    h.record(v);
+    v = v * 6364136223846793005ull + 1442695040888963407ull;
+    v >>= 40;  // spread over ~16M ns
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HistogramRecord);
+
+void BM_StageTimer(benchmark::State& state) {
+  for (auto _ : state) {
+    telemetry::StageTimer timer(telemetry::Stage::kPostprocess);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StageTimer);
+
+// One 10 Hz gateway tick for 256 nodes without images (ingest, incremental
+// features, one batched forward pass) with telemetry off (0) and on (1).
+// The difference is the instrumentation overhead; it must stay below 1%.
+void BM_TelemetryOverhead(benchmark::State& state) {
+  constexpr std::size_t kNodes = 256;
+  constexpr std::size_t kWindow = 36'000;
+  SampleStore store(kNodes, kWindow + 1024);
+  TraceGenerator gen(13);
+  gen.fill(store, kWindow);
+  const FreshnessClassifier model(ClassifierWeights::random(64, 3));
+  const LabConverter conv(LabMode::kSimd);
+  GradingOptions options;
+  options.window = kMicrosPerHour;
+  GradingPipeline pipeline(store, model, conv, options);
+  IncrementalFeatureTracker tracker(store, options.window, options.features);
+  pipeline.set_feature_tracker(&tracker);
+
+  std::vector<GradingRequest> requests(kNodes);
+  for (NodeId n = 0; n < kNodes; ++n) requests[n].node = n;
+  std::vector<GradeResult> results(kNodes);
+  IngestQueue queue(4096);
+  std::vector<IngestRecord> batch(512);
+  std::vector<IngestRecord> reports(kNodes);
+  std::uint64_t tick = kWindow;
+  pipeline.grade_batch(requests, results);
+
+  const bool was_enabled = telemetry::enabled();
+  telemetry::set_enabled(state.range(0) == 1);
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (NodeId n = 0; n < kNodes; ++n) reports[n] = {n, gen.sample(n, tick)};
+    ++tick;
+    state.ResumeTiming();
+    for (const IngestRecord& r : reports) queue.push(r);
+    std::size_t drained = 0;
+    while (drained < kNodes) {
+      drained += drain_batch(queue, store, batch, std::chrono::microseconds{0}).popped;
+    }
+    pipeline.grade_batch(requests, results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  telemetry::set_enabled(was_enabled);
+  state.SetItemsProcessed(state.iterations() * kNodes);
+  state.SetLabel(state.range(0) == 1 ? "telemetry on" : "telemetry off");
+}
+BENCHMARK(BM_TelemetryOverhead)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+void BM_PrometheusExport(benchmark::State& state) {
+  for (int i = 0; i < 1000; ++i) telemetry::record(telemetry::Stage::kInference, 1000 + i);
+  for (auto _ : state) benchmark::DoNotOptimize(telemetry::prometheus_text());
+}
+BENCHMARK(BM_PrometheusExport)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace meat_quality::bench
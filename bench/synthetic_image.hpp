@@ -0,0 +1,63 @@
+#pragma once
+
+// Deterministic synthetic carcass images for benchmarks: a red lean region
+// with round fat flecks, on a grey conveyor belt.
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "meat_quality/image/image_view.hpp"
+
+namespace meat_quality::bench {
+
+struct SyntheticImage {
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  std::vector<std::uint8_t> pixels;
+
+  ImageView view() const noexcept {
+    return {pixels.data(), width, height, std::size_t{width} * 3, PixelFormat::kRgb8};
+  }
+};
+
+/// `meat_fraction` of the width (centered) is meat, the rest belt.
+inline SyntheticImage make_carcass_image(std::uint32_t width, std::uint32_t height,
+                                         std::uint64_t seed, double meat_fraction = 0.6) {
+  SyntheticImage img{width, height, std::vector<std::uint8_t>(std::size_t{width} * height * 3)};
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> jitter(-6, 6);
+  const auto meat_w = static_cast<std::uint32_t>(width * meat_fraction);
+  const std::uint32_t x_begin = (width - meat_w) / 2, x_end = x_begin + meat_w;
+  const std::uint32_t y_begin = height / 8, y_end = height - height / 8;
+  const auto put = [&](std::uint32_t x, std::uint32_t y, int r, int g, int b) {
+    std::uint8_t* p = img.pixels.data() + (std::size_t{y} * width + x) * 3;
+    p[0] = static_cast<std::uint8_t>(std::clamp(r + jitter(rng), 0, 255));
+    p[1] = static_cast<std::uint8_t>(std::clamp(g + jitter(rng), 0, 255));
+    p[2] = static_cast<std::uint8_t>(std::clamp(b + jitter(rng), 0, 255));
+  };
+  for (std::uint32_t y = 0; y < height; ++y) {
+    for (std::uint32_t x = 0; x < width; ++x) {
+      const bool meat = x >= x_begin && x < x_end && y >= y_begin && y < y_end;
+      if (meat) put(x, y, 165, 38, 42);
+      else put(x, y, 92, 94, 98);
+    }
+  }
+  const std::uint32_t flecks = meat_w * (y_end - y_begin) / 2500;
+  for (std::uint32_t k = 0; k < flecks; ++k) {
+    const auto cx = static_cast<int>(x_begin + rng() % meat_w);
+    const auto cy = static_cast<int>(y_begin + rng() % (y_end - y_begin));
+    const int r = 1 + static_cast<int>(rng() % 9);
+    for (int y = cy - r; y <= cy + r; ++y) {
+      for (int x = cx - r; x <= cx + r; ++x) {
+        if ((x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r) continue;
+        if (x < int(x_begin) || x >= int(x_end) || y < int(y_begin) || y >= int(y_end)) continue;
+        put(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), 236, 224, 212);
+      }
+    }
+  }
+  return img;
+}
+
+}  // namespace meat_quality::bench
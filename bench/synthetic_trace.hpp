@@ -0,0 +1,47 @@
+#pragma once
+
+// Deterministic synthetic cold-room traces for benchmarks. Every node follows
+// a slow exponential spoilage curve on the gas channels plus sensor noise, so
+// kernels see realistic value ranges rather than constants.
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality::bench {
+
+inline constexpr Timestamp kTickMicros = 100'000;  // 10 Hz
+
+struct TraceGenerator {
+  explicit TraceGenerator(std::uint64_t seed) : rng(seed) {}
+
+  SensorSample sample(NodeId node, std::uint64_t tick) {
+    const double hours = static_cast<double>(tick) * kTickMicros * 1e-6 / 3600.0;
+    const double onset = 0.2 * (node % 7);  // spoilage onset varies by node
+    const double spoil = std::expm1(0.4 * std::max(0.0, hours - onset));
+    SensorSample s;
+    s.timestamp = static_cast<Timestamp>(tick) * kTickMicros;
+    s[Channel::kNh3] = static_cast<float>(2.0 + 3.0 * spoil + noise(rng) * 0.2);
+    s[Channel::kH2s] = static_cast<float>(0.05 + 0.3 * spoil + noise(rng) * 0.01);
+    s[Channel::kVoc] = static_cast<float>(150.0 + 80.0 * spoil + noise(rng) * 5.0);
+    s[Channel::kTemperature] = static_cast<float>(2.5 + noise(rng) * 0.3);
+    s[Channel::kHumidity] = static_cast<float>(88.0 + noise(rng));
+    s[Channel::kPh] = static_cast<float>(5.6 + 0.1 * spoil + noise(rng) * 0.02);
+    return s;
+  }
+
+  /// Fills every node of `store` with `ticks` consecutive samples.
+  void fill(SampleStore& store, std::uint64_t ticks) {
+    for (std::uint64_t t = 0; t < ticks; ++t) {
+      for (NodeId n = 0; n < store.node_count(); ++n) store.push(n, sample(n, t));
+    }
+  }
+
+  std::mt19937_64 rng;
+  std::normal_distribution<double> noise{0.0, 1.0};
+};
+
+}  // namespace meat_quality::bench
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "meat_quality/cluster/shard_map.hpp"
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality {
+
+struct MemberInfo {
+  MemberId id = 0;
+  std::string address;  ///< where peers send migrated shards; opaque here
+  std::uint32_t weight = 1;
+  Timestamp last_heartbeat = 0;
+};
+
+struct CoordinatorOptions {
+  std::uint32_t shard_count = kDefaultShardCount;
+  std::uint32_t vnodes = 64;
+  /// A member that has not sent a heartbeat for this long is expired.
+  Timestamp lease = 10'000'000;
+};
+
+/// Membership of the grader instances and the shard map derived from it.
+///
+/// Every change of membership bumps the epoch and publishes a new map;
+/// members poll `shard_map()` (or receive it from whatever transport hosts
+/// the coordinator) and feed it to `ShardedSampleStore::apply()`. The
+/// coordinator keeps no sample state, so running it on one grader instance
+/// and restarting it elsewhere on failure only loses heartbeats. All
+/// methods are thread-safe.
+class MembershipCoordinator {
+ public:
+  /// Throws std::invalid_argument for zero shards or vnodes.
+  explicit MembershipCoordinator(CoordinatorOptions options = {});
+
+  /// Adds a member or updates the address and weight of a known one.
+  /// Returns the resulting map.
+  std::shared_ptr<const ShardMap> join(MemberId id, std::string address, std::uint32_t weight,
+                                       Timestamp now);
+
+  /// Renews a member's lease. False if the member is unknown (it expired
+  /// or never joined) and must join again.
+  bool heartbeat(MemberId id, Timestamp now);
+
+  /// Removes a member. False if it was not a member.
+  bool leave(MemberId id);
+
+  /// Removes members whose lease ran out at `now` and returns their ids.
+  std::vector<MemberId> expire(Timestamp now);
+
+  std::shared_ptr<const ShardMap> shard_map() const;
+  std::uint64_t epoch() const;
+  std::vector<MemberInfo> members() const;
+
+  const CoordinatorOptions& options() const noexcept { return options_; }
+
+ private:
+  void publish();  // requires mutex_
+
+  CoordinatorOptions options_;
+  mutable std::mutex mutex_;
+  std::vector<MemberInfo> members_;
+  std::uint64_t epoch_ = 0;
+  std::shared_ptr<const ShardMap> map_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality {
+
+/// Grader instance in a sharded deployment.
+using MemberId = std::uint32_t;
+inline constexpr MemberId kNoMember = std::numeric_limits<MemberId>::max();
+
+/// Sensor nodes are hashed into a fixed number of shards; shards, not
+/// nodes, are what moves between members.
+using ShardId = std::uint32_t;
+inline constexpr std::uint32_t kDefaultShardCount = 4096;
+
+/// 64-bit finalizer of SplitMix64; the hash of node ids and ring points.
+constexpr std::uint64_t mix64(std::uint64_t x) noexcept {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+constexpr ShardId shard_of(NodeId node, std::uint32_t shard_count) noexcept {
+  return static_cast<ShardId>(mix64(node) % shard_count);
+}
+
+struct RingMember {
+  MemberId id = 0;
+  std::uint32_t weight = 1;  ///< relative capacity; virtual nodes scale with it
+};
+
+/// Owner of every shard at one membership epoch.
+class ShardMap {
+ public:
+  ShardMap() = default;
+
+  /// Consistent-hash assignment: every member puts `weight * vnodes` points
+  /// on a 64-bit ring and a shard belongs to the first point at or after
+  /// its own hash. Adding or removing a member only moves the shards whose
+  /// successor point changed, about 1/members of them. Throws
+  /// std::invalid_argument for zero shards, zero vnodes or duplicate ids.
+  static ShardMap build(std::span<const RingMember> members, std::uint64_t epoch,
+                        std::uint32_t shard_count = kDefaultShardCount,
+                        std::uint32_t vnodes = 64);
+
+  std::uint64_t epoch() const noexcept { return epoch_; }
+  std::uint32_t shard_count() const noexcept { return static_cast<std::uint32_t>(owners_.size()); }
+
+  /// kNoMember if the map has no members.
+  MemberId owner(ShardId shard) const noexcept { return owners_[shard]; }
+  MemberId owner_of(NodeId node) const noexcept { return owners_[shard_of(node, shard_count())]; }
+
+  /// Shards owned by `member`, ascending.
+  std::vector<ShardId> shards_of(MemberId member) const;
+
+ private:
+  std::uint64_t epoch_ = 0;
+  std::vector<MemberId> owners_;
+};
+
+struct ShardMove {
+  ShardId shard = 0;
+  MemberId from = kNoMember;
+  MemberId to = kNoMember;
+};
+
+/// Shards whose owner differs between two maps with the same shard count.
+std::vector<ShardMove> moves_between(const ShardMap& before, const ShardMap& after);
+
+}  // namespace meat_quality
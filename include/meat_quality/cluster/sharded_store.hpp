@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "meat_quality/cluster/shard_map.hpp"
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality {
+
+enum class ShardPush : std::uint8_t {
+  kStored,
+  kNotOwned,    ///< the node's shard belongs to another member; forward it
+  kOutOfOrder,  ///< older than the node's newest sample
+  kFull,        ///< no free slot for a new node
+};
+
+constexpr const char* shard_push_name(ShardPush p) noexcept {
+  switch (p) {
+    case ShardPush::kStored: return "stored";
+    case ShardPush::kNotOwned: return "not_owned";
+    case ShardPush::kOutOfOrder: return "out_of_order";
+    case ShardPush::kFull: return "full";
+  }
+  return "unknown";
+}
+
+/// What a new shard map asks of one member.
+struct Rebalance {
+  /// Shards this member holds samples for but no longer owns; send each
+  /// to its new owner with `export_shard()`.
+  std::vector<ShardId> outgoing;
+  /// Shards this member now owns and did not before. Their previous owner
+  /// may send their samples; pushes are accepted in the meantime.
+  std::vector<ShardId> incoming;
+};
+
+struct ShardImport {
+  std::size_t nodes = 0;
+  std::size_t samples = 0;
+  /// Local slots whose contents were replaced; reset any per-slot state
+  /// derived from them (e.g. `IncrementalFeatureTracker::reset()`).
+  std::vector<NodeId> slots;
+};
+
+/// The rolling sample state of one member of a sharded grading service.
+///
+/// Sensor nodes carry cluster-wide ids; the store maps the nodes of the
+/// shards this member owns onto the dense local slots of a `SampleStore`,
+/// so the feature and grading code runs on local slot ids unchanged. When
+/// the shard map changes only the shards that changed owner move: the old
+/// owner exports each one as a compact Gorilla-coded blob and frees its
+/// slots, the new owner imports it and merges whatever it received for
+/// those nodes in the meantime.
+///
+/// Not synchronized, like `SampleStore`.
+class ShardedSampleStore {
+ public:
+  static constexpr NodeId kNoSlot = std::numeric_limits<NodeId>::max();
+
+  /// Throws std::invalid_argument for zero slots or shards.
+  ShardedSampleStore(MemberId self, std::size_t max_nodes, std::size_t capacity_per_node,
+                     std::uint32_t shard_count = kDefaultShardCount);
+
+  MemberId self() const noexcept { return self_; }
+  std::uint32_t shard_count() const noexcept { return static_cast<std::uint32_t>(state_.size()); }
+  /// Epoch of the last applied map; 0 before the first.
+  std::uint64_t epoch() const noexcept { return epoch_; }
+  /// Nodes currently holding a slot.
+  std::size_t node_count() const noexcept { return slots_.size(); }
+
+  /// Slot-indexed samples, for windows and feature extraction.
+  const SampleStore& store() const noexcept { return store_; }
+
+  /// Local slot of `node`, or kNoSlot if it has none.
+  NodeId slot_of(NodeId node) const noexcept;
+
+  bool owns(NodeId node) const noexcept {
+    return state_[shard_of(node, shard_count())] == State::kOwned;
+  }
+
+  /// Switches to `map`. Maps older than the applied one are ignored and
+  /// return an empty plan. Throws std::invalid_argument if the shard count
+  /// differs.
+  Rebalance apply(const ShardMap& map);
+
+  /// Appends a sample of an owned node, allocating its slot on first use
+  /// (which may allocate map storage).
+  ShardPush push(NodeId node, const SensorSample& sample);
+
+  /// Serializes the samples of a shard listed in `Rebalance::outgoing` and
+  /// frees its slots, whose ids are appended to `released` if given.
+  /// Throws std::invalid_argument if this member still owns the shard.
+  std::vector<std::uint8_t> export_shard(ShardId shard,
+                                         std::vector<NodeId>* released = nullptr);
+
+  /// Merges an exported shard. Samples that arrived here for its nodes
+  /// since the map changed are kept after the imported ones. Throws
+  /// std::invalid_argument if the blob is malformed, the shard is not
+  /// owned here, or the blob's epoch is newer than the applied map (apply
+  /// that map first) or older than the shard's last change of owner or
+  /// import (a stale transfer). Throws std::runtime_error if the new nodes
+  /// need more slots than are free. The store is unchanged when it throws.
+  ShardImport import_shard(std::span<const std::uint8_t> blob);
+
+ private:
+  enum class State : std::uint8_t { kNotOwned, kOwned, kLeaving };
+
+  NodeId acquire(NodeId node, ShardId shard);
+
+  MemberId self_;
+  std::uint64_t epoch_ = 0;
+  SampleStore store_;
+  std::vector<State> state_;
+  std::vector<std::uint64_t> transfer_epoch_;     // per shard, see import_shard()
+  std::vector<std::vector<NodeId>> shard_nodes_;  // cluster-wide ids per shard
+  std::unordered_map<NodeId, NodeId> slots_;      // cluster-wide id -> slot
+  std::vector<NodeId> free_slots_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <type_traits>
+
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality {
+
+/// Per-node sensor calibration: `corrected = raw * gain + offset` for each
+/// channel. Trivially copyable so tables can be used in place from a mapped
+/// snapshot.
+struct NodeCalibration {
+  std::array<float, kChannelCount> gain;
+  std::array<float, kChannelCount> offset;
+
+  static constexpr NodeCalibration identity() noexcept {
+    NodeCalibration c{};
+    c.gain.fill(1.0f);
+    return c;
+  }
+
+  void apply(SensorSample& sample) const noexcept {
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      sample.values[c] = sample.values[c] * gain[c] + offset[c];
+    }
+  }
+};
+
+static_assert(std::is_trivially_copyable_v<NodeCalibration>);
+static_assert(sizeof(NodeCalibration) == 2 * kChannelCount * sizeof(float));
+
+}  // namespace meat_quality
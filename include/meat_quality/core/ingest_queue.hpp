@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <span>
+
+#include "meat_quality/core/calibration.hpp"
+#include "meat_quality/core/node_registry.hpp"
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/util/mpsc_queue.hpp"
+
+namespace meat_quality {
+
+/// One decoded sensor report, as produced by a receiver thread.
+struct IngestRecord {
+  NodeId node = 0;
+  SensorSample sample{};
+};
+
+/// Hand-off between the network receiver threads (producers) and the
+/// grading thread that owns the SampleStore (the single consumer).
+using IngestQueue = MpscQueue<IngestRecord>;
+
+struct DrainResult {
+  std::size_t popped = 0;        ///< records taken off the queue
+  std::size_t stored = 0;        ///< records appended to the store
+  std::size_t out_of_order = 0;  ///< older than the node's newest sample
+  std::size_t unknown_node = 0;  ///< node id outside the store
+};
+
+/// Pops one batch of at most `batch.size()` records, waiting up to
+/// `timeout` for the first one, and appends them to `store`. `batch` is
+/// caller-owned scratch so the grading loop never allocates. Records of a
+/// node with an entry in `calibration` are corrected before they are
+/// stored; other nodes are stored as received.
+DrainResult drain_batch(IngestQueue& queue, SampleStore& store,
+                        std::span<IngestRecord> batch,
+                        std::chrono::microseconds timeout,
+                        std::span<const NodeCalibration> calibration = {}) noexcept;
+
+/// As above, correcting each record with its node's calibration in
+/// `registry`; unregistered nodes are stored as received. The batch is
+/// corrected against one snapshot.
+DrainResult drain_batch(IngestQueue& queue, SampleStore& store,
+                        std::span<IngestRecord> batch,
+                        std::chrono::microseconds timeout,
+                        const NodeRegistry& registry) noexcept;
+
+}  // namespace meat_quality
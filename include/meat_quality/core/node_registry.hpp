@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "meat_quality/core/calibration.hpp"
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+
+/// Where a node is installed.
+struct NodeLocation {
+  std::uint32_t site = 0;  ///< plant or warehouse
+  std::uint32_t room = 0;  ///< cold room within the site
+};
+
+/// Everything the ingest and grading paths need to know about one sensor
+/// node. Trivially copyable, so lookups copy it out whole.
+struct NodeRecord {
+  NodeId node = 0;
+  /// Owning shard (`cluster/shard_map.hpp`).
+  std::uint32_t shard = 0;
+  NodeLocation location;
+  NodeCalibration calibration = NodeCalibration::identity();
+  /// Per-channel alert thresholds for the node, after calibration.
+  std::array<float, kChannelCount> limit{};
+};
+
+static_assert(std::is_trivially_copyable_v<NodeRecord>);
+
+struct NodeRegistryStats {
+  std::uint64_t version = 0;  ///< snapshots published, including the first
+  std::size_t nodes = 0;
+  /// Total time updates spent waiting for readers of replaced snapshots.
+  std::uint64_t grace_ns = 0;
+};
+
+/// Read-mostly registry of sensor nodes, looked up for every incoming
+/// sample and changed a few times a day.
+///
+/// Readers see an immutable snapshot: an open-addressing hash table of
+/// records. An update builds a new snapshot off to the side, publishes it
+/// with one atomic pointer store and frees the old one after a grace
+/// period, once no reader can still hold it (RCU). Readers announce
+/// themselves in one of `kReaderSlots` cache-line-sized counters picked per
+/// thread, so a lookup is two uncontended atomic increments, a pointer
+/// load and a probe: wait-free and with no shared cache line written, where
+/// a shared mutex would bounce its reader count between every core.
+/// Updates are serialized and wait for the grace period; they are meant
+/// for an admin thread, not the hot path.
+class NodeRegistry {
+ public:
+  class Snapshot {
+   public:
+    /// nullptr if `node` is not registered.
+    const NodeRecord* find(NodeId node) const noexcept;
+
+    /// Every record, in no particular order.
+    std::span<const NodeRecord> records() const noexcept { return records_; }
+    std::size_t size() const noexcept { return records_.size(); }
+    std::uint64_t version() const noexcept { return version_; }
+
+   private:
+    friend class NodeRegistry;
+
+    struct Slot {
+      NodeId node;
+      std::uint32_t index;  // into records_, kEmpty if unused
+    };
+    static constexpr std::uint32_t kEmpty = std::numeric_limits<std::uint32_t>::max();
+
+    Snapshot(std::vector<NodeRecord> records, std::uint64_t version);
+
+    std::vector<NodeRecord> records_;
+    std::vector<Slot> slots_;  // power-of-two size, linear probing
+    std::uint64_t version_;
+  };
+
+  /// Keeps the snapshot current at the time of read() alive until it is
+  /// destroyed; updates published meanwhile wait for it. Keep it short and
+  /// on one thread.
+  class ReadGuard {
+   public:
+    ReadGuard(ReadGuard&& other) noexcept;
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ReadGuard& operator=(ReadGuard&&) = delete;
+    ~ReadGuard();
+
+    const Snapshot& operator*() const noexcept { return *snapshot_; }
+    const Snapshot* operator->() const noexcept { return snapshot_; }
+
+   private:
+    friend class NodeRegistry;
+    ReadGuard(std::atomic<std::uint32_t>* counter, const Snapshot* snapshot) noexcept
+        : counter_(counter), snapshot_(snapshot) {}
+
+    std::atomic<std::uint32_t>* counter_;
+    const Snapshot* snapshot_;
+  };
+
+  static constexpr std::size_t kReaderSlots = 64;
+
+  /// Throws std::invalid_argument if a node appears twice.
+  explicit NodeRegistry(std::vector<NodeRecord> records = {});
+
+  /// No ReadGuard may outlive the registry.
+  ~NodeRegistry();
+
+  NodeRegistry(const NodeRegistry&) = delete;
+  NodeRegistry& operator=(const NodeRegistry&) = delete;
+
+  /// Pins the current snapshot. Wait-free.
+  ReadGuard read() const noexcept;
+
+  /// Copies `node`'s record to `out`; false if it is not registered.
+  /// Wait-free.
+  bool lookup(NodeId node, NodeRecord& out) const noexcept;
+
+  /// Replaces every record, then waits until no reader holds the previous
+  /// snapshot. Throws std::invalid_argument if a node appears twice.
+  void replace(std::vector<NodeRecord> records);
+
+  /// Adds or overwrites `records` (the last one wins for a repeated node)
+  /// and removes `removed`, as one snapshot; waits like replace().
+  void update(std::span<const NodeRecord> records, std::span<const NodeId> removed = {});
+
+  /// Applies `edit` to a copy of the current records and publishes the
+  /// result like replace(); for changes computed from the current state.
+  void modify(const std::function<void(std::vector<NodeRecord>&)>& edit);
+
+  NodeRegistryStats stats() const;
+
+ private:
+  struct alignas(kCacheLineSize) ReaderSlot {
+    std::atomic<std::uint32_t> readers[2]{};
+  };
+
+  // Publishes `records` and frees the previous snapshot after a grace period.
+  // Caller holds update_mutex_.
+  void publish(std::vector<NodeRecord> records);
+  void wait_for_readers(unsigned phase) const noexcept;
+
+  std::atomic<const Snapshot*> current_;
+  // Low bit picks the reader counter new readers increment.
+  std::atomic<unsigned> phase_{0};
+  mutable std::array<ReaderSlot, kReaderSlots> slots_;
+
+  mutable std::mutex update_mutex_;
+  std::uint64_t grace_ns_ = 0;  // guarded by update_mutex_
+};
+
+}  // namespace meat_quality
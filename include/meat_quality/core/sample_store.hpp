@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+
+/// A logically contiguous run of ring-buffer elements that may wrap around
+/// the end of the ring, and is therefore exposed as at most two contiguous
+/// segments. Kernels should iterate the segments, not the elements.
+template <typename T>
+struct SplitSpan {
+  std::span<const T> first;
+  std::span<const T> second;
+
+  std::size_t size() const noexcept { return first.size() + second.size(); }
+  bool empty() const noexcept { return size() == 0; }
+
+  const T& operator[](std::size_t i) const noexcept {
+    return i < first.size() ? first[i] : second[i - first.size()];
+  }
+
+  const T& front() const noexcept { return (*this)[0]; }
+  const T& back() const noexcept { return (*this)[size() - 1]; }
+
+  /// Calls `fn(std::span<const T>)` for each non-empty segment in order.
+  template <typename Fn>
+  void for_each_segment(Fn&& fn) const {
+    if (!first.empty()) fn(first);
+    if (!second.empty()) fn(second);
+  }
+
+  /// Drops the first `n` elements.
+  SplitSpan drop_front(std::size_t n) const noexcept {
+    if (n >= size()) return {};
+    if (n < first.size()) return {first.subspan(n), second};
+    return {second.subspan(n - first.size()), {}};
+  }
+
+  /// Keeps only the last `n` elements.
+  SplitSpan last(std::size_t n) const noexcept {
+    return n >= size() ? *this : drop_front(size() - n);
+  }
+
+  /// Keeps only the first `n` elements.
+  SplitSpan head(std::size_t n) const noexcept {
+    if (n >= size()) return *this;
+    if (n <= first.size()) return {first.first(n), {}};
+    return {first, second.first(n - first.size())};
+  }
+};
+
+/// Read-only view of a node's samples over some time window. All columns
+/// share the same split point, so `timestamps[i]` and `channel(c)[i]` refer
+/// to the same sample.
+struct WindowView {
+  SplitSpan<Timestamp> timestamps;
+  std::array<SplitSpan<float>, kChannelCount> channels;
+
+  std::size_t size() const noexcept { return timestamps.size(); }
+  bool empty() const noexcept { return timestamps.empty(); }
+
+  const SplitSpan<float>& channel(Channel c) const noexcept {
+    return channels[index_of(c)];
+  }
+
+  SensorSample sample(std::size_t i) const noexcept;
+
+  /// The oldest `n` samples of the window.
+  WindowView head(std::size_t n) const noexcept;
+};
+
+/// Struct-of-arrays sensor sample store with one fixed-capacity ring per
+/// node. Each column (timestamps and every channel) is a single contiguous
+/// allocation of `node_count * capacity` elements, so a node's window is at
+/// most two dense runs per column and pushing never allocates.
+///
+/// The store is not synchronized: a store is owned by one grading thread, or
+/// by one shard, and readers run on that same thread.
+class SampleStore {
+ public:
+  /// `capacity_per_node` is rounded up to the next power of two.
+  SampleStore(std::size_t node_count, std::size_t capacity_per_node);
+
+  std::size_t node_count() const noexcept { return cursors_.size(); }
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  /// Appends a sample, overwriting the node's oldest sample when the ring is
+  /// full. Returns false, and stores nothing, if `sample` is older than the
+  /// node's newest sample; windows rely on timestamps being non-decreasing.
+  bool push(NodeId node, const SensorSample& sample) noexcept;
+
+  /// Column-wise append of `n` samples: `columns[c][i]` is channel `c` of
+  /// sample `i`. Samples older than the node's newest one are skipped.
+  /// Returns the number of samples stored.
+  std::size_t push_columns(NodeId node, const Timestamp* timestamps,
+                           const std::array<const float*, kChannelCount>& columns,
+                           std::size_t n) noexcept;
+
+  /// Number of samples currently held for `node` (at most `capacity()`).
+  std::size_t size(NodeId node) const noexcept;
+
+  /// Total samples ever pushed for `node`, including overwritten ones.
+  std::uint64_t total_pushed(NodeId node) const noexcept {
+    return cursors_[node].head;
+  }
+
+  /// Timestamp of the newest sample, or 0 if the node is empty.
+  Timestamp newest(NodeId node) const noexcept;
+
+  /// All held samples with `timestamp >= since`.
+  WindowView window(NodeId node, Timestamp since) const noexcept;
+
+  /// The newest `n` held samples (fewer if the node holds fewer).
+  WindowView latest(NodeId node, std::size_t n) const noexcept;
+
+  /// Sequence number (position in push order, starting at 0) of the oldest
+  /// sample still held for `node`.
+  std::uint64_t oldest_sequence(NodeId node) const noexcept {
+    return cursors_[node].head - size(node);
+  }
+
+  /// Held samples with sequence number `>= seq`; starts at the oldest held
+  /// sample if `seq` has already been overwritten.
+  WindowView since_sequence(NodeId node, std::uint64_t seq) const noexcept;
+
+  /// Forgets every sample of `node`.
+  void clear(NodeId node) noexcept { cursors_[node] = {}; }
+
+ private:
+  struct Cursor {
+    std::uint64_t head = 0;  // total samples pushed
+    Timestamp newest = 0;
+  };
+
+  WindowView view(NodeId node, std::size_t offset, std::size_t n) const noexcept;
+
+  std::size_t base(NodeId node) const noexcept { return node * capacity_; }
+
+  std::size_t capacity_;
+  std::size_t mask_;
+  std::vector<Cursor> cursors_;
+  AlignedBuffer<Timestamp> timestamps_;
+  std::array<AlignedBuffer<float>, kChannelCount> columns_;
+};
+
+}  // namespace meat_quality
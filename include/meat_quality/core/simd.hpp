@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace meat_quality {
+
+/// Instruction set used by the vectorized kernels (window features, color
+/// conversion, ...). One process-wide level selects the kernels of every
+/// module.
+enum class SimdLevel : std::uint8_t { kScalar, kAvx2, kAvx512, kNeon };
+
+std::string_view simd_level_name(SimdLevel level) noexcept;
+
+/// True if this build has kernels for `level` and the running CPU can run
+/// them.
+bool simd_level_supported(SimdLevel level) noexcept;
+
+/// Best level supported by both this build and the running CPU. The
+/// `MEAT_QUALITY_SIMD` environment variable (`scalar`, `avx2`, `avx512`,
+/// `neon`) caps the choice, which is how benchmarks compare paths.
+SimdLevel detect_simd_level() noexcept;
+
+/// Level currently used by the kernels; detected on first use.
+SimdLevel active_simd_level() noexcept;
+
+/// Forces a level. Returns false, leaving the active level unchanged, if the
+/// build or the CPU does not support it.
+bool set_simd_level(SimdLevel level) noexcept;
+
+}  // namespace meat_quality
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace meat_quality {
+
+/// Microseconds since the Unix epoch.
+using Timestamp = std::int64_t;
+
+/// Dense cold-room sensor node identifier.
+using NodeId = std::uint32_t;
+
+/// Measured channels of a cold-room sensor node, in column order.
+enum class Channel : std::uint8_t {
+  kNh3 = 0,      ///< ammonia, ppm
+  kH2s,          ///< hydrogen sulfide, ppm
+  kVoc,          ///< total volatile organic compounds, ppb
+  kTemperature,  ///< degrees Celsius
+  kHumidity,     ///< relative humidity, percent
+  kPh,           ///< surface pH
+};
+
+inline constexpr std::size_t kChannelCount = 6;
+
+constexpr std::size_t index_of(Channel c) noexcept {
+  return static_cast<std::size_t>(c);
+}
+
+constexpr std::string_view channel_name(Channel c) noexcept {
+  switch (c) {
+    case Channel::kNh3: return "nh3";
+    case Channel::kH2s: return "h2s";
+    case Channel::kVoc: return "voc";
+    case Channel::kTemperature: return "temperature";
+    case Channel::kHumidity: return "humidity";
+    case Channel::kPh: return "ph";
+  }
+  return "unknown";
+}
+
+/// Set of channels, one bit per `Channel`.
+using ChannelMask = std::uint8_t;
+
+constexpr ChannelMask mask_of(Channel c) noexcept {
+  return static_cast<ChannelMask>(1u << index_of(c));
+}
+
+inline constexpr ChannelMask kGasChannels =
+    mask_of(Channel::kNh3) | mask_of(Channel::kH2s) | mask_of(Channel::kVoc);
+inline constexpr ChannelMask kAllChannels = (1u << kChannelCount) - 1;
+
+constexpr bool contains(ChannelMask mask, Channel c) noexcept {
+  return (mask & mask_of(c)) != 0;
+}
+
+/// One reading from a sensor node. Only used at the API boundary; the store
+/// keeps samples column by column.
+struct SensorSample {
+  Timestamp timestamp = 0;
+  std::array<float, kChannelCount> values{};
+
+  float& operator[](Channel c) noexcept { return values[index_of(c)]; }
+  float operator[](Channel c) const noexcept { return values[index_of(c)]; }
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/features/window_features.hpp"
+
+namespace meat_quality {
+
+/// Channel sets of the deployed sensor configurations. The camera of the
+/// full configuration feeds the color path, not the window features.
+inline constexpr ChannelMask kGasOnlySku = kGasChannels;
+inline constexpr ChannelMask kGasPhSku = kGasChannels | mask_of(Channel::kPh);
+inline constexpr ChannelMask kFullSku = kAllChannels;
+
+/// True for channel sets with precompiled fused kernels.
+constexpr bool is_fused_feature_set(ChannelMask mask) noexcept {
+  return mask == kGasOnlySku || mask == kGasPhSku || mask == kFullSku;
+}
+
+/// extract_features() for a channel set fixed at compile time.
+///
+/// For the SKU sets the channel loop is unrolled at compile time and the
+/// SIMD level is resolved once per call; no kernel table is consulted per
+/// channel and segment. On the baseline ISA every channel is folded into a
+/// single pass that converts each block of timestamps once for all
+/// channels. The vectorized levels call their own per-channel kernels
+/// directly, because those are already bound by the vector units. Other
+/// sets fall back to extract_features().
+///
+/// Results match extract_features() up to floating-point summation order.
+template <ChannelMask Mask>
+WindowFeatures extract_features_fixed(const WindowView& window,
+                                      float ewma_alpha = FeatureOptions{}.ewma_alpha) noexcept {
+  static_assert(Mask != 0 && (Mask & ~kAllChannels) == 0, "invalid channel set");
+  return extract_features(window, FeatureOptions{ewma_alpha, Mask});
+}
+
+template <>
+WindowFeatures extract_features_fixed<kGasOnlySku>(const WindowView& window,
+                                                   float ewma_alpha) noexcept;
+template <>
+WindowFeatures extract_features_fixed<kGasPhSku>(const WindowView& window,
+                                                 float ewma_alpha) noexcept;
+template <>
+WindowFeatures extract_features_fixed<kFullSku>(const WindowView& window,
+                                                float ewma_alpha) noexcept;
+
+}  // namespace meat_quality
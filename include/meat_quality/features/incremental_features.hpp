@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/features/window_features.hpp"
+
+namespace meat_quality {
+
+/// How `IncrementalFeatureTracker::update()` produces features.
+enum class FeatureMode : std::uint8_t {
+  kFull,         ///< rescan the whole window with extract_features()
+  kIncremental,  ///< O(1) amortized update of running statistics
+  kValidate,     ///< both; return the incremental result, record the drift
+};
+
+constexpr const char* feature_mode_name(FeatureMode m) noexcept {
+  switch (m) {
+    case FeatureMode::kFull: return "full";
+    case FeatureMode::kIncremental: return "incremental";
+    case FeatureMode::kValidate: return "validate";
+  }
+  return "?";
+}
+
+/// Largest incremental-vs-full differences seen in kValidate mode, per
+/// `ChannelFeatures` field in declaration order (mean, variance, slope,
+/// min, max, ewma). Relative errors divide by max(|full|, 1e-6).
+struct FeatureDrift {
+  static constexpr std::size_t kFields = 6;
+
+  std::uint64_t checks = 0;  ///< channel comparisons made
+  std::array<double, kFields> max_abs_error{};
+  std::array<double, kFields> max_rel_error{};
+  NodeId worst_node = 0;  ///< node of the largest relative error
+};
+
+/// Keeps each node's window features up to date as samples arrive, rather
+/// than rescanning the window on every tick.
+///
+/// Per node and channel it holds Welford-style running moments (mean, M2,
+/// and the time/value co-moment for the slope), which stay centred and
+/// so do not cancel catastrophically as samples are added and removed, plus
+/// monotonic queues for the window min and max. `update()` folds in the
+/// samples pushed to the store since the previous call and ages out those
+/// older than `window` before the newest sample: O(1) amortized per sample,
+/// independent of the window length.
+///
+/// Non-finite readings (a dropped sensor, the wire format's NaN marker) are
+/// left out of a channel's statistics, which divide by the channel's own
+/// count of finite readings; a channel with none in the window has a NaN
+/// mean, min and max. extract_features() applies the same rule, so the
+/// tracker and a rescan agree on windows holding such readings.
+///
+/// The samples themselves stay in the `SampleStore`; the tracker reads the
+/// outgoing ones back from it. If the store has already overwritten them
+/// (capacity smaller than the window plus the update lag), or every
+/// `resync_interval` evictions, the node is rebuilt from its stored window.
+///
+/// The EWMA continues across the whole history instead of restarting at
+/// the window's first sample, so it differs from extract_features() by
+/// about (1 - alpha)^window_samples, which is negligible for windows much
+/// longer than 1/alpha samples.
+///
+/// Same threading rule as the store: one owning thread.
+class IncrementalFeatureTracker {
+ public:
+  static constexpr std::uint64_t kDefaultResyncInterval = std::uint64_t{1} << 22;
+
+  /// `window`: length of the window ending at each node's newest sample.
+  /// The store must outlive the tracker.
+  IncrementalFeatureTracker(const SampleStore& store, Timestamp window,
+                            FeatureOptions options = {},
+                            FeatureMode mode = FeatureMode::kIncremental);
+  ~IncrementalFeatureTracker();
+
+  IncrementalFeatureTracker(const IncrementalFeatureTracker&) = delete;
+  IncrementalFeatureTracker& operator=(const IncrementalFeatureTracker&) = delete;
+
+  /// Brings `node` up to date with the store and returns its features over
+  /// [newest - window, newest].
+  WindowFeatures update(NodeId node) noexcept;
+
+  /// Forgets `node`'s state; the next update() rebuilds it.
+  void reset(NodeId node) noexcept;
+
+  const SampleStore& store() const noexcept { return store_; }
+  Timestamp window() const noexcept { return window_; }
+  const FeatureOptions& options() const noexcept { return options_; }
+
+  FeatureMode mode() const noexcept { return mode_; }
+  void set_mode(FeatureMode mode) noexcept { mode_ = mode; }
+
+  /// Rebuilds after this many evictions bound long-run drift; 0 disables.
+  void set_resync_interval(std::uint64_t evictions) noexcept { resync_interval_ = evictions; }
+
+  const FeatureDrift& drift() const noexcept { return drift_; }
+  void clear_drift() noexcept { drift_ = {}; }
+
+  /// Nodes rebuilt from the store, for any reason.
+  std::uint64_t rebuilds() const noexcept { return rebuilds_; }
+
+ private:
+  struct NodeState;
+
+  WindowFeatures incremental(NodeId node) noexcept;
+  void rebuild(NodeId node, NodeState& s) noexcept;
+  void add(NodeState& s, std::uint64_t seq, Timestamp t, const WindowView& v,
+           std::size_t i) noexcept;
+  void remove(NodeState& s, Timestamp t, const WindowView& v, std::size_t i) noexcept;
+  WindowFeatures snapshot(const NodeState& s) const noexcept;
+  void record_drift(NodeId node, const WindowFeatures& inc,
+                    const WindowFeatures& full) noexcept;
+
+  const SampleStore& store_;
+  Timestamp window_;
+  FeatureOptions options_;
+  FeatureMode mode_;
+  std::uint64_t resync_interval_ = kDefaultResyncInterval;
+  std::vector<NodeState> nodes_;
+  FeatureDrift drift_;
+  std::uint64_t rebuilds_ = 0;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/features/window_features.hpp"
+
+namespace meat_quality {
+
+struct SamplingRateOptions {
+  static constexpr float kNoLimit = std::numeric_limits<float>::infinity();
+
+  /// Spoilage thresholds per channel, in channel units; kNoLimit channels
+  /// never affect the rate. Ammonia, H2S and VOC levels of spoiling meat,
+  /// and the 7 °C chilled-meat limit.
+  std::array<float, kChannelCount> spoilage = {10.0f, 1.0f, 1000.0f, 7.0f, kNoLimit, kNoLimit};
+  /// Report interval at full rate and the longest one a node may be given.
+  std::uint32_t min_interval_ms = 100;
+  std::uint32_t max_interval_ms = 1000;
+  /// Trend look-ahead: each channel is judged at ewma + slope * horizon.
+  Timestamp horizon = Timestamp{15} * 60 * 1'000'000;  // 15 minutes
+  /// A projection at or above this share of a threshold restores the full
+  /// rate at once.
+  float approach = 0.7f;
+  /// Below this share, with noise under `max_noise` of the threshold, the
+  /// node counts as stable.
+  float calm = 0.5f;
+  float max_noise = 0.05f;
+  /// Stable decisions in a row before each doubling of the interval.
+  std::uint32_t patience = 3;
+  /// Samples a window needs before its node may slow down.
+  std::uint32_t min_samples = 30;
+};
+
+struct SamplingRateStats {
+  std::uint64_t decisions = 0;
+  std::uint64_t slowdowns = 0;  ///< interval doubled
+  std::uint64_t speedups = 0;   ///< reset to full rate
+};
+
+/// Chooses each sensor node's report interval from the window features the
+/// grader already maintains (`IncrementalFeatureTracker`). A node whose
+/// channels are quiet and projected well below their spoilage thresholds
+/// has its interval doubled every `patience` decisions, up to
+/// `max_interval_ms`; one projected to approach a threshold goes straight
+/// back to `min_interval_ms`. Slowing down is gradual and speeding up is
+/// immediate, so a rising trend is never sampled more coarsely than the
+/// horizon allows.
+///
+/// `update()` belongs to one thread, like the tracker. The chosen intervals
+/// are published per node and `interval_ms()` and `claim_hint()` may be
+/// called from any thread, e.g. by the front end when it sends rate hints
+/// back to the nodes.
+class SamplingRateController {
+ public:
+  /// Throws std::invalid_argument for a zero or inverted interval range.
+  explicit SamplingRateController(std::size_t node_count, SamplingRateOptions options = {});
+
+  /// Decides `node`'s interval from its current window features and returns
+  /// it. Out-of-range nodes get `min_interval_ms`.
+  std::uint32_t update(NodeId node, const WindowFeatures& features) noexcept;
+
+  /// Last interval published for `node`; `min_interval_ms` until decided.
+  std::uint32_t interval_ms(NodeId node) const noexcept {
+    return node < node_count_ ? published_[node].load(std::memory_order_relaxed)
+                              : options_.min_interval_ms;
+  }
+
+  /// True once per change of `node`'s interval, with the new interval in
+  /// `interval_ms`: the caller won the right to tell the node. Nodes start
+  /// at `min_interval_ms` without a hint; out-of-range nodes never change.
+  bool claim_hint(NodeId node, std::uint32_t& interval_ms) noexcept {
+    if (node >= node_count_) return false;
+    const std::uint32_t now = published_[node].load(std::memory_order_relaxed);
+    std::uint32_t last = hinted_[node].load(std::memory_order_relaxed);
+    while (last != now) {
+      if (hinted_[node].compare_exchange_weak(last, now, std::memory_order_relaxed)) {
+        interval_ms = now;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Expected report volume relative to every node at full rate, in (0, 1].
+  double volume_fraction() const noexcept;
+
+  std::size_t node_count() const noexcept { return node_count_; }
+  const SamplingRateOptions& options() const noexcept { return options_; }
+  const SamplingRateStats& stats() const noexcept { return stats_; }
+
+ private:
+  struct NodeState {
+    std::uint32_t interval_ms = 0;
+    std::uint32_t stable = 0;  // consecutive stable decisions
+  };
+
+  SamplingRateOptions options_;
+  std::size_t node_count_;
+  std::vector<NodeState> nodes_;
+  std::unique_ptr<std::atomic<std::uint32_t>[]> published_;
+  std::unique_ptr<std::atomic<std::uint32_t>[]> hinted_;  // last claimed interval
+  SamplingRateStats stats_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/core/ingest_queue.hpp"
+#include "meat_quality/core/node_registry.hpp"
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/features/incremental_features.hpp"
+#include "meat_quality/telemetry/telemetry.hpp"
+#include "meat_quality/util/mpsc_queue.hpp"
+
+namespace meat_quality {
+
+struct AlertOptions {
+  static constexpr float kNoLimit = std::numeric_limits<float>::infinity();
+
+  /// Level that raises an alert, per channel in channel units; the same
+  /// spoilage thresholds as SamplingRateOptions.
+  std::array<float, kChannelCount> limit = {10.0f, 1.0f, 1000.0f, 7.0f, kNoLimit, kNoLimit};
+  /// Window slope that raises an alert, in channel units per minute.
+  std::array<float, kChannelCount> max_rise = {2.0f, 0.2f, 200.0f, 0.5f, kNoLimit, kNoLimit};
+  /// Length of the window the rise is fitted over.
+  Timestamp window = Timestamp{20} * 1'000'000;  // 20 s
+  /// Samples held per node for the window; should cover `window` at the
+  /// fastest report rate, or the window statistics are rebuilt from the
+  /// held samples on every update.
+  std::size_t history = 256;
+  /// Per-sample smoothing factor of the level that rearms limit alerts.
+  float ewma_alpha = 0.3f;
+  /// Consecutive samples over a limit before it alerts, so a single
+  /// glitched reading does not.
+  std::uint32_t confirm = 2;
+  /// Samples the window needs before a rise is judged.
+  std::uint32_t min_samples = 5;
+  /// An alerted channel rearms once its smoothed level (or window slope)
+  /// falls below this share of the limit (or max_rise).
+  float rearm = 0.9f;
+};
+
+enum class AlertKind : std::uint8_t {
+  kLimit,  ///< a reading at or above the channel limit
+  kRise,   ///< the window slope at or above max_rise
+};
+
+constexpr const char* alert_kind_name(AlertKind k) noexcept {
+  switch (k) {
+    case AlertKind::kLimit: return "limit";
+    case AlertKind::kRise: return "rise";
+  }
+  return "?";
+}
+
+struct SpoilageAlert {
+  NodeId node = 0;
+  Channel channel = Channel::kNh3;
+  AlertKind kind = AlertKind::kLimit;
+  float value = 0;         ///< reading of the triggering sample
+  float level = 0;         ///< smoothed level (EWMA) at that sample
+  float rise_per_min = 0;  ///< window slope at that sample
+  Timestamp at = 0;        ///< timestamp of the triggering sample
+};
+
+/// Threshold rules evaluated on the incremental window statistics of
+/// `IncrementalFeatureTracker`, over a short window of its own: each
+/// sample is appended to the evaluator's `SampleStore` and folded into the
+/// window in O(1) amortized, with no rescan. A limit alert fires on
+/// `confirm` readings in a row and rearms once the EWMA level falls back;
+/// a rise alert fires on the window's least-squares slope. Each fires once
+/// and rearms with hysteresis. Only channels with a finite limit or
+/// max_rise are tracked.
+///
+/// The store is separate from the grading thread's, which the lane
+/// cannot read without locking and which is only as fresh as the last
+/// drain.
+///
+/// One owning thread.
+class AlertEvaluator {
+ public:
+  /// At most one limit and one rise alert per channel.
+  static constexpr std::size_t kMaxAlertsPerSample = 2 * kChannelCount;
+
+  /// Throws std::invalid_argument for zero nodes.
+  explicit AlertEvaluator(std::size_t node_count, AlertOptions options = {});
+
+  /// Folds `sample` into `node`'s window and writes the alerts it raises
+  /// to `out`, returning their number. Samples for unknown nodes, or not
+  /// newer than the node's last one, are ignored. Non-finite readings
+  /// skip their channel.
+  std::size_t update(NodeId node, const SensorSample& sample,
+                     std::span<SpoilageAlert, kMaxAlertsPerSample> out) noexcept;
+
+  /// Forgets `node`'s statistics and alerts.
+  void reset(NodeId node) noexcept;
+
+  std::size_t node_count() const noexcept { return nodes_.size(); }
+  const AlertOptions& options() const noexcept { return options_; }
+
+ private:
+  struct ChannelState {
+    std::uint32_t over = 0;  // consecutive readings over the limit
+    bool limit_raised = false;
+    bool rise_raised = false;
+  };
+  struct NodeState {
+    std::array<ChannelState, kChannelCount> channels{};
+  };
+
+  AlertOptions options_;
+  SampleStore store_;
+  IncrementalFeatureTracker tracker_;
+  std::vector<NodeState> nodes_;
+};
+
+struct AlertLaneOptions {
+  std::size_t node_count = 4096;
+  /// Queued samples; when full the oldest is dropped, so the queueing
+  /// delay stays bounded under a burst.
+  std::size_t capacity = 8192;
+  /// Alerts delivered later than this after their sample arrived count as
+  /// late.
+  std::chrono::microseconds budget{100'000};
+  /// CPUs for the lane thread; empty leaves it unpinned.
+  std::vector<int> cpus;
+  /// If set, samples are corrected with their node's calibration before
+  /// evaluation, as drain_batch() does for the store, so both lanes see the
+  /// same values. Must outlive the lane.
+  const NodeRegistry* registry = nullptr;
+  AlertOptions alerts;
+};
+
+struct AlertLaneStats {
+  std::uint64_t samples = 0;  ///< evaluated
+  std::uint64_t dropped = 0;  ///< evicted from a full lane
+  std::uint64_t alerts = 0;
+  std::uint64_t late = 0;     ///< alerts delivered after the budget
+};
+
+/// Called on the lane thread for every alert; must not block for long.
+using AlertSink = std::function<void(const SpoilageAlert&)>;
+
+/// Priority lane for spoilage alerts, beside the bulk ingest queue. The
+/// receiver threads push every sample into both; a dedicated thread takes
+/// samples off this lane as soon as they arrive, without micro-batching
+/// or waiting for the grading loop, runs the AlertEvaluator and hands
+/// alerts straight to the sink.
+///
+/// Latency from a sample's arrival is recorded per sample evaluated
+/// (telemetry Stage::kAlertLane) and per alert delivered (Stage::kAlert).
+class AlertLane {
+ public:
+  /// Throws std::invalid_argument for a zero capacity.
+  explicit AlertLane(AlertSink sink, AlertLaneOptions options = {});
+
+  /// Calls stop().
+  ~AlertLane();
+
+  AlertLane(const AlertLane&) = delete;
+  AlertLane& operator=(const AlertLane&) = delete;
+
+  /// Starts the lane thread.
+  void start();
+
+  /// Evaluates the samples already queued, then joins the thread.
+  void stop();
+
+  /// Queues a sample from any thread. `received_ns` is telemetry::now_ns()
+  /// when it arrived, the start of its latency. Returns false once stopped.
+  bool push(const IngestRecord& record,
+            std::uint64_t received_ns = telemetry::now_ns()) noexcept {
+    return queue_.push(Item{record, received_ns});
+  }
+
+  AlertLaneStats stats() const noexcept;
+  const AlertLaneOptions& options() const noexcept { return options_; }
+
+ private:
+  // No default member initializers: MpscQueue's nothrow static_asserts
+  // cannot see through them while AlertLane is still incomplete.
+  struct Item {
+    IngestRecord record;
+    std::uint64_t received_ns;
+  };
+
+  void run();
+
+  AlertSink sink_;
+  AlertLaneOptions options_;
+  AlertEvaluator evaluator_;
+  MpscQueue<Item> queue_;
+  std::thread thread_;
+  std::atomic<std::uint64_t> samples_{0};
+  std::atomic<std::uint64_t> alerts_{0};
+  std::atomic<std::uint64_t> late_{0};
+};
+
+}  // namespace meat_quality
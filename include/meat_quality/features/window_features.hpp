@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/simd.hpp"
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality {
+
+/// Rolling-window statistics of one channel.
+struct ChannelFeatures {
+  float mean = 0.0f;
+  float variance = 0.0f;  ///< population variance
+  float slope = 0.0f;     ///< least-squares trend, units per second
+  float min = 0.0f;
+  float max = 0.0f;
+  float ewma = 0.0f;      ///< exponentially weighted mean, newest sample last
+};
+
+struct FeatureOptions {
+  /// Smoothing factor of the EWMA: `s = alpha * x + (1 - alpha) * s`.
+  float ewma_alpha = 0.05f;
+  /// Channels to compute; the rest are left zeroed.
+  ChannelMask channels = kGasChannels | mask_of(Channel::kTemperature);
+};
+
+struct WindowFeatures {
+  std::uint32_t samples = 0;
+  Timestamp start = 0;
+  Timestamp end = 0;
+  ChannelMask channels = 0;
+  std::array<ChannelFeatures, kChannelCount> values{};
+
+  const ChannelFeatures& operator[](Channel c) const noexcept {
+    return values[index_of(c)];
+  }
+};
+
+/// Features of one channel over `timestamps`/`x`, which must have the same
+/// length and split point. An empty window yields all zeros. Non-finite
+/// readings are left out; if none is finite, the mean, min, max and EWMA
+/// are NaN and the variance and slope zero. IncrementalFeatureTracker
+/// follows the same rule.
+ChannelFeatures compute_channel_features(const SplitSpan<Timestamp>& timestamps,
+                                         const SplitSpan<float>& x,
+                                         float ewma_alpha) noexcept;
+
+/// Features of every channel in `options.channels` over `window`.
+WindowFeatures extract_features(const WindowView& window,
+                                const FeatureOptions& options = {}) noexcept;
+
+}  // namespace meat_quality
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/image/accel_backend.hpp"
+#include "meat_quality/image/marbling.hpp"
+
+namespace meat_quality {
+
+struct BatchImageOptions {
+  /// Images per submission; two submissions are in flight at a time.
+  std::size_t batch = 16;
+  /// Accelerator device index, passed to the backend.
+  int device = 0;
+  /// a* histogram of the color summary.
+  GradingOptions grading;
+  /// Pixel classes and the minimum fleck size; `tile` is unused.
+  MarblingOptions marbling;
+};
+
+/// Visual grade of one image.
+struct ImageGrade {
+  ColorSummary color;
+  MarblingResult marbling;
+};
+
+/// Offline grader for archived carcass photos, e.g. the central lab's
+/// nightly re-grade. The per-pixel stages (L*a*b*, pixel classes, color
+/// sums and histogram) run on an `ImageAccelBackend`; fleck labelling and
+/// percentiles run on the calling thread. Images are staged in page-locked
+/// buffers and submitted in batches, two in flight: while the device
+/// converts one batch, the CPU stages the next and labels the previous.
+///
+/// With the reference backend the results equal summarize_color() and
+/// MarblingSegmenter on the same images. One grader per thread.
+class BatchImageGrader {
+ public:
+  /// Opens a context on `backend`, which must outlive the grader. Throws
+  /// std::invalid_argument for a zero batch and std::runtime_error if the
+  /// backend cannot open the device.
+  explicit BatchImageGrader(const ImageAccelBackend& backend, BatchImageOptions options = {});
+  ~BatchImageGrader();
+
+  BatchImageGrader(const BatchImageGrader&) = delete;
+  BatchImageGrader& operator=(const BatchImageGrader&) = delete;
+
+  /// Grades `images` (RGB8) into `out`, which must be the same size.
+  /// Throws std::invalid_argument for other formats or a size mismatch and
+  /// std::runtime_error if the backend fails.
+  void grade(std::span<const ImageView> images, std::span<ImageGrade> out);
+
+  std::string_view backend_name() const noexcept { return backend_.name(); }
+  const BatchImageOptions& options() const noexcept { return options_; }
+
+ private:
+  // Page-locked buffer from the backend, grown on demand.
+  struct HostBuffer {
+    void* data = nullptr;
+    std::size_t bytes = 0;
+  };
+
+  struct Slot {
+    std::vector<mq_image_job> jobs;
+    std::vector<std::size_t> images;  // index into the grade() call per job
+    std::vector<HostBuffer> rgb;
+    std::vector<HostBuffer> classes;
+    std::vector<std::uint32_t> histograms;  // batch * redness_bins
+    std::size_t count = 0;                   // jobs in the submission
+    std::int64_t ticket = -1;
+  };
+
+  void reserve(HostBuffer& buffer, std::size_t bytes);
+  void submit(Slot& slot, std::span<const ImageView> images, std::size_t first);
+  void finish(Slot& slot, std::span<ImageGrade> out);
+
+  const ImageAccelBackend& backend_;
+  BatchImageOptions options_;
+  mq_image_params params_{};
+  void* ctx_ = nullptr;
+  std::array<Slot, 2> slots_;
+};
+
+}  // namespace meat_quality
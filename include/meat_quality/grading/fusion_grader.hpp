@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "meat_quality/grading/grading_pipeline.hpp"
+
+namespace meat_quality {
+
+/// Models of the fusion cascade, cheapest first.
+enum class FusionStage : std::uint8_t { kGas = 0, kPh, kImage };
+
+inline constexpr std::size_t kFusionStageCount = 3;
+
+std::string_view fusion_stage_name(FusionStage s) noexcept;
+
+/// Color statistics in image-model order: mean L*, a*, b*, then the a*
+/// p10, p50 and p90.
+inline constexpr std::size_t kImageFeatureDim = 6;
+
+using ImageFeatureVector = std::array<float, kImageFeatureDim>;
+
+ImageFeatureVector to_image_features(const ColorSummary& color) noexcept;
+
+/// Parameters of the image model. `w` is input-major like
+/// `ClassifierWeights`.
+struct ImageModelWeights {
+  std::array<float, kImageFeatureDim> input_mean{};
+  std::array<float, kImageFeatureDim> input_scale{};  ///< multiplies (x - mean)
+  std::array<float, kImageFeatureDim * kFreshnessClassCount> w{};
+  std::array<float, kFreshnessClassCount> b{};
+
+  /// Deterministic pseudo-random weights, for benchmarks and smoke runs.
+  static ImageModelWeights random(std::uint64_t seed);
+};
+
+/// Fresh / semi-fresh / spoiled from the color statistics of a tray's
+/// crops: standardize, dense, softmax. Almost all of its cost is the
+/// L*a*b* conversion behind the statistics, not the model itself.
+class ImageFreshnessModel {
+ public:
+  explicit ImageFreshnessModel(const ImageModelWeights& weights) noexcept : weights_(weights) {}
+
+  Prediction predict(const ColorSummary& color) const noexcept;
+
+ private:
+  ImageModelWeights weights_;
+};
+
+/// The cascade's models; they must outlive the grader. `gas` is required,
+/// a null `ph` or `image` stage is skipped.
+struct FusionModels {
+  const FreshnessClassifier* gas = nullptr;
+  const FreshnessClassifier* ph = nullptr;
+  const ImageFreshnessModel* image = nullptr;
+};
+
+struct FusionOptions {
+  /// Sensor window and color histogram; `grading.features.channels` is
+  /// replaced by each sensor stage's own channels.
+  GradingOptions grading;
+  ChannelMask gas_channels = kGasChannels;
+  ChannelMask ph_channels = mask_of(Channel::kPh);
+  /// After stage `s`, a tray whose fused top-two probability margin is at
+  /// least `exit_margin[s]` is decided and skips the remaining stages. A
+  /// margin above 1 always runs the next stage; the last one is unused.
+  std::array<float, kFusionStageCount> exit_margin{0.5f, 0.4f, 0.0f};
+  /// Exponent of each stage's probabilities in the fused prediction.
+  std::array<float, kFusionStageCount> weight{1.0f, 1.0f, 1.0f};
+};
+
+struct FusedGrade {
+  NodeId node = 0;
+  Timestamp at = 0;
+  std::uint32_t samples = 0;
+  /// Normalized product of the stage predictions run so far, each raised
+  /// to its weight.
+  Prediction fused;
+  /// Each stage's own prediction; valid where ran().
+  std::array<Prediction, kFusionStageCount> stages{};
+  std::uint8_t stage_mask = 0;
+  bool has_color = false;
+  ColorSummary color;
+
+  bool ran(FusionStage s) const noexcept {
+    return (stage_mask & (1u << static_cast<unsigned>(s))) != 0;
+  }
+};
+
+struct FusionStats {
+  std::uint64_t requests = 0;
+  /// Trays each stage was run on.
+  std::array<std::uint64_t, kFusionStageCount> runs{};
+  /// Trays decided by each stage, i.e. that ran no later one.
+  std::array<std::uint64_t, kFusionStageCount> exits{};
+};
+
+/// Early-exit ensemble over the gas, pH and image models. Every tray is
+/// graded by the gas model; only trays it leaves undecided (fused margin
+/// below the stage's `exit_margin`) go on to the pH model, and only those
+/// still undecided have their crops converted and scored by the image
+/// model. Since the gas model settles most trays, the average grade costs
+/// little more than one sensor pass while borderline trays still get every
+/// model. The sensor stages are `GradingPipeline`s restricted to their
+/// channels, so scratch comes from the request arena as there.
+///
+/// Reads the store without locking, like GradingPipeline; not thread-safe
+/// (one grader per thread).
+class FusionGrader {
+ public:
+  /// The store and converter must outlive the grader. Throws
+  /// std::invalid_argument without a gas model.
+  FusionGrader(const SampleStore& store, FusionModels models, const LabConverter& converter,
+               FusionOptions options = {});
+
+  FusedGrade grade(const GradingRequest& request);
+
+  /// Grades `requests`, one batched classifier pass per sensor stage over
+  /// the trays still undecided. `out` must have the same size.
+  void grade_batch(std::span<const GradingRequest> requests, std::span<FusedGrade> out);
+
+  const FusionOptions& options() const noexcept { return options_; }
+  const FusionStats& stats() const noexcept { return stats_; }
+  void reset_stats() noexcept { stats_ = {}; }
+
+ private:
+  static GradingOptions stage_options(const FusionOptions& options, ChannelMask channels);
+
+  FusionModels models_;
+  const LabConverter& converter_;
+  FusionOptions options_;
+  GradingPipeline gas_;
+  std::optional<GradingPipeline> ph_;
+  FusionStats stats_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/inference/freshness_classifier.hpp"
+
+namespace meat_quality {
+
+struct GradeCacheOptions {
+  /// Upper bound on the cache's memory, entries, index and per-node memo,
+  /// all allocated up front. A quarter goes to the memo, which covers node
+  /// ids below `max_bytes / 4` divided by the size of one memo entry
+  /// (about 26k nodes at the default); higher ids are cached without one.
+  std::size_t max_bytes = std::size_t{4} << 20;
+  /// Width of the window-end buckets: queries whose window ends in the
+  /// same bucket may share a result.
+  Timestamp bucket = 10'000'000;
+  /// Mantissa bits kept of each feature before hashing. Feature vectors
+  /// that agree to about 2^-bits relative share a prediction.
+  unsigned mantissa_bits = 12;
+};
+
+struct GradeCacheKey {
+  NodeId node = 0;
+  std::int64_t bucket = 0;
+  std::uint64_t features = 0;  ///< hash of the quantized feature vector
+
+  bool operator==(const GradeCacheKey&) const = default;
+};
+
+struct GradeCacheStats {
+  std::uint64_t memo_hits = 0;     ///< no new samples: served without features
+  std::uint64_t feature_hits = 0;  ///< features recomputed, inference skipped
+  std::uint64_t misses = 0;
+  std::uint64_t evictions = 0;
+  std::size_t entries = 0;
+  std::size_t bytes = 0;
+};
+
+/// Bounded cache of sensor predictions for repeated grade queries.
+///
+/// Entries are keyed on (node, window-end bucket, quantized feature hash)
+/// and evicted with CLOCK. Each node also has a memo of the key its last
+/// result was stored under and the store generation (`total_pushed`) it
+/// saw: while no new sample lands, a repeated query is answered from the
+/// memo without even extracting features. A new sample invalidates the
+/// memo; the query then recomputes features, and if they quantize to the
+/// same vector it still skips the classifier.
+///
+/// Not synchronized; used by the grading thread that owns the store.
+class GradeCache {
+ public:
+  /// Throws std::invalid_argument if `max_bytes` does not fit a minimal
+  /// table, or for a zero bucket or mantissa width outside [1, 23].
+  explicit GradeCache(GradeCacheOptions options = {});
+
+  const GradeCacheOptions& options() const noexcept { return options_; }
+
+  std::int64_t bucket_of(Timestamp at) const noexcept {
+    return at >= 0 ? at / options_.bucket : (at - options_.bucket + 1) / options_.bucket;
+  }
+  std::uint64_t hash_features(const FeatureVector& features) const noexcept;
+
+  /// Memo lookup: the node's last result if it is for `bucket` and the
+  /// node has not received samples since (`generation` unchanged).
+  bool find_current(NodeId node, std::int64_t bucket, std::uint64_t generation,
+                    Prediction& prediction, std::uint32_t& samples) noexcept;
+
+  /// Entry lookup after extracting features; on a hit the node's memo is
+  /// pointed at it for `generation`.
+  bool find(const GradeCacheKey& key, std::uint64_t generation, Prediction& prediction) noexcept;
+
+  /// Stores a result and points the node's memo at it.
+  void insert(const GradeCacheKey& key, std::uint64_t generation, const Prediction& prediction,
+              std::uint32_t samples) noexcept;
+
+  /// Forgets the node's memo, e.g. when its store slot is reassigned.
+  void invalidate(NodeId node) noexcept;
+
+  /// Drops everything, e.g. when the model changes.
+  void clear() noexcept;
+
+  GradeCacheStats stats() const noexcept;
+
+ private:
+  struct Entry {
+    GradeCacheKey key;
+    std::uint64_t hash = 0;
+    Prediction prediction;
+    std::uint32_t samples = 0;
+    bool used = false;
+    bool referenced = false;
+  };
+  struct Memo {
+    std::uint64_t generation = 0;
+    GradeCacheKey key;
+    bool valid = false;
+  };
+
+  std::size_t locate(const GradeCacheKey& key, std::uint64_t hash) const noexcept;
+  void erase_index(std::size_t pos) noexcept;
+  std::uint32_t take_slot() noexcept;
+  Memo* memo(NodeId node) noexcept;
+
+  GradeCacheOptions options_;
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> index_;  // entry + 1, 0 when empty; linear probing
+  std::size_t index_mask_ = 0;
+  std::vector<Memo> memo_;  // indexed by node; never resized after construction
+  std::size_t hand_ = 0;
+  std::size_t size_ = 0;
+  GradeCacheStats stats_;
+};
+
+}  // namespace meat_quality
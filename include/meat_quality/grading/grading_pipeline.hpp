@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/features/incremental_features.hpp"
+#include "meat_quality/grading/grade_cache.hpp"
+#include "meat_quality/features/window_features.hpp"
+#include "meat_quality/image/color_lab.hpp"
+#include "meat_quality/inference/freshness_classifier.hpp"
+#include "meat_quality/inference/quantized_classifier.hpp"
+
+namespace meat_quality {
+
+inline constexpr Timestamp kMicrosPerSecond = 1'000'000;
+inline constexpr Timestamp kMicrosPerHour = 3600 * kMicrosPerSecond;
+
+struct GradingOptions {
+  /// Length of the sensor window ending at the request time.
+  Timestamp window = 6 * kMicrosPerHour;
+  FeatureOptions features;
+  /// a* histogram used for the redness percentiles, over [a_min, a_max).
+  std::uint32_t redness_bins = 64;
+  float a_min = -16.0f;
+  float a_max = 48.0f;
+};
+
+/// Color statistics over all crops of a request.
+struct ColorSummary {
+  std::uint64_t pixels = 0;
+  float mean_l = 0.0f;
+  float mean_a = 0.0f;
+  float mean_b = 0.0f;
+  float a_p10 = 0.0f;  ///< a* percentiles, histogram resolution
+  float a_p50 = 0.0f;
+  float a_p90 = 0.0f;
+};
+
+/// Color statistics of `crops` (RGB8) exactly as the pipeline computes
+/// them for a request; for offline feature export.
+ColorSummary summarize_color(std::span<const ImageView> crops, const LabConverter& converter,
+                             const GradingOptions& options = {});
+
+/// Color statistics from accumulated ones: `histogram` holds the options'
+/// `redness_bins` a* counts over `pixels` pixels, `sum_*` the channel sums.
+/// For stages that accumulate elsewhere, e.g. on an accelerator.
+ColorSummary color_summary(std::span<const std::uint32_t> histogram, std::uint64_t pixels,
+                           double sum_l, double sum_a, double sum_b,
+                           const GradingOptions& options = {}) noexcept;
+
+struct GradingRequest {
+  NodeId node = 0;
+  /// End of the sensor window; 0 means the node's newest sample.
+  Timestamp at = 0;
+  /// Optional tray crops (RGB8), e.g. views into a `FrameRef`.
+  std::span<const ImageView> crops;
+};
+
+struct GradeResult {
+  NodeId node = 0;
+  Timestamp at = 0;
+  std::uint32_t samples = 0;
+  Prediction sensor;
+  bool has_color = false;
+  ColorSummary color;
+};
+
+/// One grading pass: sensor window -> features -> classifier, plus color
+/// statistics of any image crops. Every temporary (feature vectors,
+/// classifier activations, L*a*b* strips, histograms) comes from a
+/// per-request `ScopedArena`, so a warmed-up pipeline grades without heap
+/// allocation.
+///
+/// Reads the store without locking; call from the thread that owns it.
+class GradingPipeline {
+ public:
+  /// The store, classifier and converter must outlive the pipeline.
+  GradingPipeline(const SampleStore& store, const FreshnessClassifier& classifier,
+                  const LabConverter& converter, GradingOptions options = {});
+
+  GradeResult grade(const GradingRequest& request) const;
+
+  /// Grades `requests` with a single batched classifier pass. `out` must
+  /// have the same size.
+  void grade_batch(std::span<const GradingRequest> requests, std::span<GradeResult> out) const;
+
+  const GradingOptions& options() const noexcept { return options_; }
+  const SampleStore& store() const noexcept { return store_; }
+
+  /// Serves requests for a node's newest sample (`at == 0`) from `tracker`
+  /// instead of rescanning the window; past instants still rescan. The
+  /// tracker must read the same store with the same window and feature
+  /// options (std::invalid_argument otherwise) and outlive the pipeline.
+  /// nullptr switches back to rescans.
+  void set_feature_tracker(IncrementalFeatureTracker* tracker);
+
+  /// Runs the sensor model through `classifier` (the INT8 form of the
+  /// pipeline's model) instead of the FP32 one; it must outlive the
+  /// pipeline. nullptr switches back to FP32.
+  void set_quantized_classifier(const QuantizedClassifier* classifier) noexcept {
+    quantized_ = classifier;
+    if (cache_ != nullptr) cache_->clear();
+  }
+
+  /// Serves repeated queries from `cache` (see GradeCache); it must
+  /// outlive the pipeline and is cleared when the model changes. Color
+  /// statistics are always computed. nullptr disables caching.
+  void set_result_cache(GradeCache* cache) noexcept { cache_ = cache; }
+
+ private:
+  const SampleStore& store_;
+  const FreshnessClassifier& classifier_;
+  const LabConverter& converter_;
+  GradingOptions options_;
+  IncrementalFeatureTracker* tracker_ = nullptr;
+  const QuantizedClassifier* quantized_ = nullptr;
+  GradeCache* cache_ = nullptr;
+};
+
+}  // namespace meat_quality
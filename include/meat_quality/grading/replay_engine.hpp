@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/storage/segment.hpp"
+#include "meat_quality/util/work_stealing_pool.hpp"
+
+namespace meat_quality {
+
+struct ReplayOptions {
+  /// Grade instants: `from`, `from + step`, ... up to `to`. The defaults
+  /// cover everything in the segments.
+  Timestamp from = std::numeric_limits<Timestamp>::min();
+  Timestamp to = std::numeric_limits<Timestamp>::max();
+  Timestamp step = 60 * kMicrosPerSecond;
+  /// Nodes to re-grade; empty means every node found in the segments.
+  std::span<const NodeId> nodes;
+  /// Ring size of the production store. Results only match production if
+  /// this is the same, since it bounds what a window can see.
+  std::size_t capacity_per_node = 65536;
+  /// Nodes replayed together by one task; also the classifier batch size.
+  /// A task holds `nodes_per_task * capacity_per_node` samples.
+  std::size_t nodes_per_task = 32;
+  /// Results handed to the sink per call.
+  std::size_t output_batch = 4096;
+  GradingOptions grading;
+  /// INT8 model to grade with instead of the FP32 one, as in production.
+  const QuantizedClassifier* quantized = nullptr;
+};
+
+struct ReplayStats {
+  std::uint64_t nodes = 0;
+  std::uint64_t samples = 0;  ///< replayed into the task stores
+  std::uint64_t grades = 0;
+  std::uint64_t batches = 0;  ///< grade_batch() calls
+};
+
+/// Re-grades stored history at full speed, e.g. to back-test a new model.
+///
+/// Nodes are split into tasks on a `WorkStealingPool`. Each task streams
+/// its nodes' blocks out of the segments into a private `SampleStore`, in
+/// lockstep up to each grade instant, and grades all of them in one
+/// `GradingPipeline::grade_batch()`. The store sees exactly the samples a
+/// production store of the same capacity would have held at that instant,
+/// and the pipeline is the production one, so results match
+/// `grade({node, instant})` in production. They are bit-identical when
+/// both stores wrapped at the same sample, e.g. both started at the first
+/// one replayed; otherwise the window splits differently across the ring
+/// and feature sums round differently.
+class ReplayEngine {
+ public:
+  /// Receives results in batches of at most `output_batch`, grouped by
+  /// task and in time order within a node. Calls are serialized but come
+  /// from pool threads.
+  using Sink = std::function<void(std::span<const GradeResult>)>;
+
+  /// Archived tray crops (RGB8) for a node at a grade instant, or an empty
+  /// span. Called from pool threads; the views must stay valid until the
+  /// sink has received the result.
+  using CropSource = std::function<std::span<const ImageView>(NodeId, Timestamp)>;
+
+  /// The pool, classifier and converter must outlive the engine. Throws
+  /// std::invalid_argument for a zero step, capacity or task size.
+  ReplayEngine(WorkStealingPool& pool, const FreshnessClassifier& classifier,
+               const LabConverter& converter, ReplayOptions options = {});
+
+  /// Replays `segments`, given oldest first; a node's samples that are
+  /// older than ones already replayed (overlapping segments) are dropped,
+  /// as the production store would. Blocks until done and rethrows the
+  /// first exception of a task or the sink.
+  ReplayStats run(std::span<const SegmentReader* const> segments, const Sink& sink,
+                  const CropSource& crops = {}) const;
+
+  const ReplayOptions& options() const noexcept { return options_; }
+
+ private:
+  WorkStealingPool& pool_;
+  const FreshnessClassifier& classifier_;
+  const LabConverter& converter_;
+  ReplayOptions options_;
+};
+
+}  // namespace meat_quality
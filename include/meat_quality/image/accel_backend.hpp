@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "meat_quality/image/image_accel.h"
+
+namespace meat_quality {
+
+/// Per-pixel stages of batch image grading (`image/image_accel.h`): either
+/// the CPU implementation built into the library or an accelerator plugin
+/// loaded with dlopen(). Edge builds never link a GPU runtime; the central
+/// lab installs the plugin next to the library.
+class ImageAccelBackend {
+ public:
+  /// Conventional file name, found through the dynamic loader's search path.
+  static constexpr const char* kDefaultPlugin = "libmeat_quality_cuda.so";
+
+  /// CPU stages using LabConverter's kSimd mode; always available. Its
+  /// submit() runs the jobs before returning.
+  static const ImageAccelBackend& reference() noexcept;
+
+  /// Loads a plugin. Throws std::runtime_error if the file cannot be
+  /// loaded, has no entry point, or speaks another ABI.
+  static ImageAccelBackend load(const std::string& path = kDefaultPlugin);
+
+  ImageAccelBackend(ImageAccelBackend&& other) noexcept;
+  ImageAccelBackend& operator=(ImageAccelBackend&& other) noexcept;
+  ~ImageAccelBackend();
+
+  std::string_view name() const noexcept { return table_->name; }
+  const mq_image_accel& table() const noexcept { return *table_; }
+
+ private:
+  ImageAccelBackend(void* handle, const mq_image_accel* table) noexcept
+      : handle_(handle), table_(table) {}
+
+  void* handle_ = nullptr;  ///< dlopen() handle; null for the reference stages
+  const mq_image_accel* table_ = nullptr;
+};
+
+}  // namespace meat_quality
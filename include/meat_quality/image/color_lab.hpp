@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "meat_quality/image/image_view.hpp"
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+
+/// CIE L*a*b* color (D65 white). L* in [0, 100]; a* is the red-green axis
+/// used for redness grading.
+struct Lab {
+  float l = 0.0f;
+  float a = 0.0f;
+  float b = 0.0f;
+};
+
+/// Reference sRGB -> L*a*b* in double precision, with the exact sRGB
+/// transfer function and cube root.
+Lab srgb_to_lab_exact(std::uint8_t r, std::uint8_t g, std::uint8_t b) noexcept;
+
+/// CIE76 color difference.
+float delta_e76(const Lab& x, const Lab& y) noexcept;
+
+/// Planar float output of a conversion: three planes of `height` rows,
+/// `stride` floats apart. May point into a larger `LabImage`.
+struct LabPlanes {
+  float* l = nullptr;
+  float* a = nullptr;
+  float* b = nullptr;
+  std::size_t stride = 0;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+
+  /// Planes of the sub-rectangle at (x, y), clipped to this one.
+  LabPlanes crop(std::uint32_t x, std::uint32_t y, std::uint32_t w,
+                 std::uint32_t h) const noexcept;
+};
+
+/// Owning planar L*a*b* image; rows are padded to a cache line.
+class LabImage {
+ public:
+  LabImage() = default;
+  LabImage(std::uint32_t width, std::uint32_t height);
+
+  const LabPlanes& planes() const noexcept { return planes_; }
+
+ private:
+  AlignedBuffer<float> storage_;
+  LabPlanes planes_;
+};
+
+enum class LabMode : std::uint8_t {
+  kExact,  ///< per-pixel pow() and cbrt(); the accuracy reference
+  kSimd,   ///< table-driven linearization, vectorized matrix and cube root
+  kLut,    ///< trilinear interpolation in a precomputed RGB -> Lab grid
+};
+
+/// Converts RGB tiles to planar L*a*b*. Immutable after construction and
+/// safe to share between threads.
+class LabConverter {
+ public:
+  /// `lut_grid` is the number of grid points per RGB axis for `kLut`
+  /// (65 -> about 4.4 MB); ignored by the other modes.
+  explicit LabConverter(LabMode mode = LabMode::kSimd, std::uint32_t lut_grid = 65);
+
+  /// `kLut` converter over a grid built elsewhere (e.g. in a mapped
+  /// snapshot), used in place; it must outlive the converter. Throws
+  /// std::invalid_argument if `lut` does not hold `lut_grid`^3 entries.
+  LabConverter(std::span<const float> lut, std::uint32_t lut_grid);
+
+  LabMode mode() const noexcept { return mode_; }
+
+  /// Grid points per axis and the grid itself, (L, a, b, pad) per entry;
+  /// empty unless the mode is `kLut`.
+  std::uint32_t lut_grid() const noexcept { return grid_; }
+  std::span<const float> lut() const noexcept {
+    return borrowed_lut_.empty() ? std::span<const float>(lut_.data(), lut_.size()) : borrowed_lut_;
+  }
+
+  /// Bytes of lookup tables held by this converter.
+  std::size_t table_bytes() const noexcept;
+
+  /// Converts `rgb` (kRgb8) into `out`, which must be at least as large.
+  /// Throws std::invalid_argument otherwise.
+  void convert(const ImageView& rgb, const LabPlanes& out) const;
+
+  /// Single-pixel conversion in this converter's mode.
+  Lab convert(std::uint8_t r, std::uint8_t g, std::uint8_t b) const noexcept;
+
+ private:
+  void convert_exact(const ImageView& rgb, const LabPlanes& out) const noexcept;
+  void convert_simd(const ImageView& rgb, const LabPlanes& out) const noexcept;
+  void convert_lut(const ImageView& rgb, const LabPlanes& out) const noexcept;
+  void build_lut_weights() noexcept;
+
+  LabMode mode_;
+  std::uint32_t grid_ = 0;
+  AlignedBuffer<float> lut_;              // grid^3 entries of (L, a, b, pad)
+  std::span<const float> borrowed_lut_;   // used instead of lut_ if set
+  std::uint32_t lut_index_[256] = {};     // lower grid index per channel value
+  float lut_weight_[256] = {};            // fraction towards the next index
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/image/image_view.hpp"
+
+namespace meat_quality {
+
+class FrameSource;
+
+/// A captured frame living in a buffer owned by its `FrameSource` (a V4L2
+/// mmap buffer, a shared-memory slot). Frames are never copied; they are
+/// handed to the pipeline through reference-counted `FrameRef`s and the
+/// buffer goes back to the source when the last reference is dropped.
+class Frame {
+ public:
+  ImageView image;
+  std::uint64_t sequence = 0;
+  Timestamp timestamp = 0;
+
+ private:
+  friend class FrameRef;
+  friend class FrameSource;
+
+  std::atomic<std::uint32_t> refs_{0};
+  FrameSource* owner_ = nullptr;
+  std::uint32_t index_ = 0;  // buffer index within the owner
+};
+
+/// Shared handle to a `Frame`. Copying is an atomic increment; no handle
+/// operation allocates.
+class FrameRef {
+ public:
+  FrameRef() = default;
+  FrameRef(const FrameRef& other) noexcept : frame_(other.frame_) { retain(); }
+  FrameRef(FrameRef&& other) noexcept : frame_(std::exchange(other.frame_, nullptr)) {}
+
+  FrameRef& operator=(const FrameRef& other) noexcept {
+    if (frame_ != other.frame_) {
+      other.retain();
+      reset();
+      frame_ = other.frame_;
+    }
+    return *this;
+  }
+
+  FrameRef& operator=(FrameRef&& other) noexcept {
+    if (this != &other) {
+      reset();
+      frame_ = std::exchange(other.frame_, nullptr);
+    }
+    return *this;
+  }
+
+  ~FrameRef() { reset(); }
+
+  /// Drops this reference, recycling the buffer if it was the last one.
+  void reset() noexcept;
+
+  explicit operator bool() const noexcept { return frame_ != nullptr; }
+  const Frame* operator->() const noexcept { return frame_; }
+  const Frame& operator*() const noexcept { return *frame_; }
+  const ImageView& image() const noexcept { return frame_->image; }
+
+  std::uint32_t use_count() const noexcept {
+    return frame_ ? frame_->refs_.load(std::memory_order_relaxed) : 0;
+  }
+
+ private:
+  friend class FrameSource;
+  explicit FrameRef(Frame* frame) noexcept : frame_(frame) {}
+
+  void retain() const noexcept {
+    if (frame_) frame_->refs_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Frame* frame_ = nullptr;
+};
+
+/// Producer of zero-copy frames. Sources preallocate one `Frame` per buffer;
+/// a source must outlive every `FrameRef` it handed out.
+class FrameSource {
+ public:
+  virtual ~FrameSource() = default;
+
+  /// Waits up to `timeout` for the next frame. Returns an empty ref on
+  /// timeout or when no free buffer is left to capture into.
+  virtual FrameRef acquire(std::chrono::milliseconds timeout) = 0;
+
+  /// Frames currently held by the pipeline.
+  std::uint32_t in_flight() const noexcept {
+    return in_flight_.load(std::memory_order_relaxed);
+  }
+
+ protected:
+  /// Wraps buffer `index` in a fresh reference; `frame` must be idle.
+  FrameRef hand_out(Frame& frame, std::uint32_t index) noexcept {
+    frame.owner_ = this;
+    frame.index_ = index;
+    frame.refs_.store(1, std::memory_order_relaxed);
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    return FrameRef(&frame);
+  }
+
+  /// Returns buffer `index` to the driver or producer. Called from
+  /// whichever thread drops the last reference.
+  virtual void recycle(std::uint32_t index) noexcept = 0;
+
+ private:
+  friend class FrameRef;
+  void release(Frame& frame) noexcept {
+    in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    recycle(frame.index_);
+  }
+
+  std::atomic<std::uint32_t> in_flight_{0};
+};
+
+inline void FrameRef::reset() noexcept {
+  if (frame_ == nullptr) return;
+  Frame* f = std::exchange(frame_, nullptr);
+  if (f->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) f->owner_->release(*f);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,84 @@
+/* C ABI between the library and an image accelerator plugin
+ * (libmeat_quality_cuda.so). The plugin runs the per-pixel stages of
+ * batch image grading on a GPU: L*a*b* conversion, fat/lean/background
+ * classification and the color statistics and a* histogram. The library
+ * keeps the parts that are cheap or branchy (connected-component labelling
+ * of the fat mask, percentiles, classification) on the CPU. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MQ_IMAGE_ACCEL_ABI 1u
+
+/* Name of the entry point looked up with dlsym(). */
+#define MQ_IMAGE_ACCEL_ENTRY "mq_image_accel_plugin"
+
+/* Pixel class codes written to mq_image_job::classes. */
+#define MQ_PIXEL_BACKGROUND 0u
+#define MQ_PIXEL_LEAN 1u
+#define MQ_PIXEL_FAT 2u
+
+/* Fat is L* >= fat_min_l and a* <= fat_max_a; lean is otherwise a* >=
+ * lean_min_a; the rest is background. a* is binned into `redness_bins`
+ * bins over [a_min, a_max), clamping outliers into the end bins. */
+typedef struct mq_image_params {
+  float fat_min_l;
+  float fat_max_a;
+  float lean_min_a;
+  float a_min;
+  float a_max;
+  uint32_t redness_bins;
+} mq_image_params;
+
+/* One RGB8 image. `rgb` and `classes` must come from alloc_host() so that
+ * copies can run asynchronously; `histogram` may be any memory. Outputs are
+ * valid once wait() returns for the ticket the job was submitted with. */
+typedef struct mq_image_job {
+  const uint8_t* rgb;
+  uint32_t width;
+  uint32_t height;
+  size_t stride;        /* bytes between rgb rows */
+  uint8_t* classes;     /* out: width * height pixel classes, rows back to back */
+  uint32_t* histogram;  /* out: redness_bins a* counts */
+  double sum_l;         /* out: sums of L*, a* and b* */
+  double sum_a;
+  double sum_b;
+  uint64_t fat_pixels;  /* out */
+  uint64_t lean_pixels; /* out */
+} mq_image_job;
+
+typedef struct mq_image_accel {
+  uint32_t abi;     /* MQ_IMAGE_ACCEL_ABI */
+  const char* name; /* e.g. "cuda" */
+
+  /* Opens `device` with its own streams and device buffers. Returns NULL
+   * and writes a message to `error` on failure. */
+  void* (*create)(int device, char* error, size_t error_size);
+  void (*destroy)(void* ctx);
+
+  /* Page-locked host memory; NULL on failure. */
+  void* (*alloc_host)(void* ctx, size_t bytes);
+  void (*free_host)(void* ctx, void* p);
+
+  /* Queues `n` jobs and returns a ticket (>= 0), or -1 on failure. Copies
+   * and kernels of consecutive submissions overlap, so the caller can
+   * prepare or post-process one batch while the device works on another.
+   * `jobs` must stay valid until wait() returns for the ticket. */
+  int64_t (*submit)(void* ctx, mq_image_job* jobs, size_t n, const mq_image_params* params);
+
+  /* Blocks until ticket `ticket` is complete; 0 on success. */
+  int (*wait)(void* ctx, int64_t ticket);
+} mq_image_accel;
+
+/* Returns the plugin's function table, or NULL if it does not speak
+ * `abi`. The table is static. */
+typedef const mq_image_accel* (*mq_image_accel_entry_fn)(uint32_t abi);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace meat_quality {
+
+enum class PixelFormat : std::uint8_t { kGray8, kRgb8 };
+
+constexpr std::size_t bytes_per_pixel(PixelFormat f) noexcept {
+  return f == PixelFormat::kRgb8 ? 3 : 1;
+}
+
+/// Non-owning, strided view of interleaved 8-bit pixels (an HWC tensor).
+/// Views over camera frames point straight into driver or shared-memory
+/// buffers; whoever holds the view must also hold the `FrameRef`.
+struct ImageView {
+  const std::uint8_t* data = nullptr;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  std::size_t stride = 0;  ///< bytes between row starts
+  PixelFormat format = PixelFormat::kRgb8;
+
+  bool empty() const noexcept { return width == 0 || height == 0; }
+
+  std::size_t row_bytes() const noexcept { return width * bytes_per_pixel(format); }
+
+  /// True if rows are back to back, so the view is one dense run.
+  bool contiguous() const noexcept { return stride == row_bytes(); }
+
+  const std::uint8_t* row(std::uint32_t y) const noexcept { return data + y * stride; }
+
+  const std::uint8_t* pixel(std::uint32_t x, std::uint32_t y) const noexcept {
+    return row(y) + x * bytes_per_pixel(format);
+  }
+
+  /// Sub-rectangle clipped to the view; shares the same pixels.
+  ImageView crop(std::uint32_t x, std::uint32_t y, std::uint32_t w,
+                 std::uint32_t h) const noexcept {
+    if (x >= width || y >= height) return {nullptr, 0, 0, stride, format};
+    if (w > width - x) w = width - x;
+    if (h > height - y) h = height - y;
+    return {pixel(x, y), w, h, stride, format};
+  }
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "meat_quality/image/color_lab.hpp"
+#include "meat_quality/image/image_view.hpp"
+#include "meat_quality/image/roi.hpp"
+#include "meat_quality/util/work_stealing_pool.hpp"
+
+namespace meat_quality {
+
+/// Pixel classes and scoring knobs for intramuscular fat segmentation, all
+/// on L*a*b* values: fat is light and weakly red, lean is strongly red, and
+/// anything else (belt, tray, bone) is ignored.
+struct MarblingOptions {
+  float fat_min_l = 62.0f;
+  float fat_max_a = 14.0f;
+  float lean_min_a = 18.0f;
+  /// Tile edge in pixels; tiles are the unit of parallel work.
+  std::uint32_t tile = 256;
+  /// Connected fat regions smaller than this are noise, not flecks.
+  std::uint32_t min_fleck_pixels = 4;
+};
+
+struct MarblingResult {
+  std::uint64_t fat_pixels = 0;
+  std::uint64_t lean_pixels = 0;
+  std::uint32_t fleck_count = 0;   ///< fat components >= min_fleck_pixels
+  std::uint32_t largest_fleck = 0; ///< pixels in the largest component
+  std::uint32_t tiles = 0;          ///< tiles segmented
+  std::uint32_t skipped_tiles = 0;  ///< tiles outside the region of interest
+
+  /// Fat share of the muscle area, in [0, 1].
+  double fat_ratio() const noexcept {
+    const auto muscle = fat_pixels + lean_pixels;
+    return muscle == 0 ? 0.0 : double(fat_pixels) / double(muscle);
+  }
+
+  /// Flecks per 10k muscle pixels; fine marbling scores high.
+  double fleck_density() const noexcept {
+    const auto muscle = fat_pixels + lean_pixels;
+    return muscle == 0 ? 0.0 : 1e4 * fleck_count / double(muscle);
+  }
+};
+
+/// Marbling scores from a pixel-class mask already computed elsewhere, e.g.
+/// by an accelerator (MQ_PIXEL_* codes of `image/image_accel.h`, rows back
+/// to back). Same 4-connected labelling as MarblingSegmenter, in one pass
+/// on the calling thread; the class thresholds in `options` are unused.
+MarblingResult label_marbling(const std::uint8_t* classes, std::uint32_t width,
+                              std::uint32_t height, const MarblingOptions& options = {});
+
+/// Tile-parallel marbling segmentation. Each tile is converted to L*a*b*,
+/// thresholded and labelled (4-connected) independently on the pool;
+/// components that cross tile edges are then joined with a union-find over
+/// the tile borders only.
+class MarblingSegmenter {
+ public:
+  /// `pool` and `converter` must outlive the segmenter.
+  MarblingSegmenter(WorkStealingPool& pool, const LabConverter& converter,
+                    MarblingOptions options = {});
+
+  /// Segments a whole RGB image and waits for the result.
+  MarblingResult segment(const ImageView& rgb) const;
+
+  /// Segments only the tiles of `roi`, which must have been detected on
+  /// `rgb` with this segmenter's tile size; background tiles cost nothing.
+  /// Throws std::invalid_argument if the map does not match.
+  MarblingResult segment(const ImageView& rgb, const RoiMap& roi) const;
+
+  /// Incremental form for images that arrive in pieces (decoding, camera
+  /// readout): schedule tiles as their rows become available, then
+  /// `finish()`. Tiles run as soon as they are added.
+  class Job {
+   public:
+    /// Tile column/row index; the tile's pixels must stay valid until
+    /// `finish()` returns. Tiles outside the job's region are ignored.
+    void add_tile(std::uint32_t tx, std::uint32_t ty);
+
+    /// Schedules every tile whose rows lie entirely below `rows_ready`.
+    void add_rows(std::uint32_t rows_ready);
+
+    /// Waits for the scheduled tiles (scheduling any not yet added) and
+    /// merges tile borders.
+    MarblingResult finish();
+
+    std::uint32_t tiles_x() const noexcept { return tiles_x_; }
+    std::uint32_t tiles_y() const noexcept { return tiles_y_; }
+
+    ~Job();
+    Job(Job&&) = delete;
+
+   private:
+    friend class MarblingSegmenter;
+    struct Tile;
+    Job(const MarblingSegmenter& owner, const ImageView& rgb, const RoiMap* roi);
+    void process(Tile& tile) const;
+
+    const MarblingSegmenter& owner_;
+    ImageView rgb_;
+    std::uint32_t tiles_x_ = 0;
+    std::uint32_t tiles_y_ = 0;
+    std::uint32_t rows_scheduled_ = 0;  // tile rows fully scheduled
+    std::vector<std::unique_ptr<Tile>> tiles_;
+    TaskGroup group_;
+  };
+
+  /// With `roi`, the job covers only its tiles; see segment(). The map is
+  /// read here and need not outlive the call.
+  std::unique_ptr<Job> begin(const ImageView& rgb, const RoiMap* roi = nullptr) const;
+
+  const MarblingOptions& options() const noexcept { return options_; }
+
+ private:
+  WorkStealingPool& pool_;
+  const LabConverter& converter_;
+  MarblingOptions options_;
+};
+
+}  // namespace meat_quality
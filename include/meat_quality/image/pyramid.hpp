@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "meat_quality/image/image_view.hpp"
+
+namespace meat_quality {
+
+/// Halving image pyramid: level 0 is the input view, level k+1 averages
+/// 2×2 blocks of level k (odd trailing rows and columns are dropped).
+/// Storage is kept across `build()` calls, so a camera thread rebuilding
+/// it per frame allocates only on the first frame.
+class ImagePyramid {
+ public:
+  /// Rebuilds up to `levels` halvings of `base` (kGray8 or kRgb8). Stops
+  /// early once a level would be narrower or shorter than one pixel. The
+  /// base pixels must stay valid while level 0 is used.
+  void build(const ImageView& base, std::uint32_t levels);
+
+  /// Levels built, including the base.
+  std::uint32_t levels() const noexcept { return static_cast<std::uint32_t>(views_.size()); }
+
+  const ImageView& level(std::uint32_t k) const noexcept { return views_[k]; }
+  const ImageView& coarsest() const noexcept { return views_.back(); }
+
+ private:
+  std::vector<ImageView> views_;
+  std::vector<std::vector<std::uint8_t>> storage_;  // level k at [k - 1]
+  std::vector<std::uint16_t> column_sums_;           // one row, while halving
+};
+
+}  // namespace meat_quality
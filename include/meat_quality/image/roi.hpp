@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "meat_quality/image/color_lab.hpp"
+#include "meat_quality/image/image_view.hpp"
+#include "meat_quality/image/pyramid.hpp"
+
+namespace meat_quality {
+
+struct RoiOptions {
+  /// Tile edge in full-resolution pixels; match MarblingOptions::tile so
+  /// the map can drive the segmenter.
+  std::uint32_t tile = 256;
+  /// Pyramid level classified for meat: 3 is 1/8 scale, 240×135 for 1080p.
+  std::uint32_t level = 3;
+  /// A coarse pixel with a* at least this is meat. Lower than the
+  /// segmenter's lean threshold, since coarse pixels mix lean with fat.
+  float meat_min_a = 12.0f;
+  /// Coarse pixels added around every meat pixel, so a fat cap or rim
+  /// with little red of its own still falls inside the region.
+  std::uint32_t margin = 2;
+};
+
+/// Tiles of a frame that hold meat, on the segmenter's tile grid.
+class RoiMap {
+ public:
+  RoiMap() = default;
+  RoiMap(std::uint32_t width, std::uint32_t height, std::uint32_t tile);
+
+  std::uint32_t tile() const noexcept { return tile_; }
+  std::uint32_t width() const noexcept { return width_; }
+  std::uint32_t height() const noexcept { return height_; }
+  std::uint32_t tiles_x() const noexcept { return tiles_x_; }
+  std::uint32_t tiles_y() const noexcept { return tiles_y_; }
+
+  bool contains(std::uint32_t tx, std::uint32_t ty) const noexcept {
+    return tx < tiles_x_ && ty < tiles_y_ && mask_[std::size_t{ty} * tiles_x_ + tx] != 0;
+  }
+  void insert(std::uint32_t tx, std::uint32_t ty) noexcept;
+
+  /// Tiles in the region.
+  std::uint32_t selected() const noexcept { return selected_; }
+  /// Full-resolution pixels in the region's tiles.
+  std::uint64_t pixels() const noexcept;
+  /// Share of the frame's pixels in the region, in [0, 1].
+  double coverage() const noexcept;
+
+  /// Appends the region of `rgb` as crops, one per horizontal run of
+  /// selected tiles, e.g. for `GradingRequest::crops`. `rgb` must be the
+  /// frame the map was built for. Returns the number appended.
+  std::size_t crops(const ImageView& rgb, std::vector<ImageView>& out) const;
+
+ private:
+  std::uint32_t width_ = 0;
+  std::uint32_t height_ = 0;
+  std::uint32_t tile_ = 0;
+  std::uint32_t tiles_x_ = 0;
+  std::uint32_t tiles_y_ = 0;
+  std::uint32_t selected_ = 0;
+  std::vector<std::uint8_t> mask_;
+};
+
+/// Locates the meat in a cutting-table frame on a coarse pyramid level, so
+/// the full-resolution stages (L*a*b* conversion, marbling segmentation,
+/// crops for the classifiers) skip the belt and tray around it. The
+/// coarse level costs one pass over the frame plus 1/64 of a Lab pass.
+///
+/// Keeps its pyramid and scratch between frames; use one per camera
+/// thread.
+class RoiDetector {
+ public:
+  /// `converter` must outlive the detector. Throws std::invalid_argument
+  /// on a zero tile size.
+  explicit RoiDetector(const LabConverter& converter, RoiOptions options = {});
+
+  /// Region of `rgb` (kRgb8). Valid until the next call. Throws
+  /// std::invalid_argument for other formats.
+  const RoiMap& detect(const ImageView& rgb);
+
+  /// Pyramid of the last frame.
+  const ImagePyramid& pyramid() const noexcept { return pyramid_; }
+
+  const RoiOptions& options() const noexcept { return options_; }
+
+ private:
+  const LabConverter& converter_;
+  RoiOptions options_;
+  ImagePyramid pyramid_;
+  LabImage lab_;
+  RoiMap map_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "meat_quality/image/frame.hpp"
+
+namespace meat_quality {
+
+/// Shared-memory frame ring between the capture daemon and graders.
+///
+/// Layout of the POSIX shared-memory object: `ShmRingHeader`, then
+/// `slot_count` `ShmSlotHeader`s, then `slot_count` pixel buffers of
+/// `slot_bytes` each, every part aligned to a page. A slot cycles
+/// free -> writing -> ready -> reading -> free; the daemon only writes free
+/// slots (or, when the grader lags, steals the oldest ready one) and the
+/// grader maps the pixels in place.
+namespace shm {
+
+inline constexpr std::uint32_t kMagic = 0x4d514652;  // "MQFR"
+inline constexpr std::uint32_t kVersion = 1;
+
+enum SlotState : std::uint32_t { kFree = 0, kWriting, kReady, kReading };
+
+struct alignas(64) RingHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t slot_count;
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t format;  ///< PixelFormat
+  std::uint64_t stride;
+  std::uint64_t slot_bytes;
+  std::uint64_t slots_offset;  ///< offset of the slot headers
+  std::uint64_t data_offset;   ///< offset of slot 0 pixels
+  /// Bumped on every publish; the futex word readers sleep on.
+  alignas(64) std::atomic<std::uint32_t> published;
+  std::atomic<std::uint64_t> next_sequence;
+  std::atomic<std::uint64_t> dropped;  ///< ready frames overwritten unread
+};
+
+struct alignas(64) SlotHeader {
+  std::atomic<std::uint32_t> state;
+  std::uint64_t sequence;
+  std::int64_t timestamp;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+}  // namespace shm
+
+/// Owning mapping of a ring segment; shared by the writer and reader sides.
+class ShmMapping {
+ public:
+  ShmMapping(void* base, std::size_t size) noexcept : base_(base), size_(size) {}
+  ~ShmMapping();
+  ShmMapping(const ShmMapping&) = delete;
+  ShmMapping& operator=(const ShmMapping&) = delete;
+
+  shm::RingHeader& header() const noexcept { return *static_cast<shm::RingHeader*>(base_); }
+  shm::SlotHeader& slot(std::uint32_t i) const noexcept;
+  std::uint8_t* pixels(std::uint32_t i) const noexcept;
+
+ private:
+  void* base_;
+  std::size_t size_;
+};
+
+/// Producer side, used by the capture daemon (and by benchmarks).
+class ShmFrameWriter {
+ public:
+  /// Creates (or truncates) shared-memory object `name` ("/mq_cam0").
+  /// Throws std::system_error on failure.
+  ShmFrameWriter(const std::string& name, std::uint32_t width, std::uint32_t height,
+                 std::uint32_t slot_count, PixelFormat format = PixelFormat::kRgb8);
+  ~ShmFrameWriter();
+
+  ShmFrameWriter(const ShmFrameWriter&) = delete;
+  ShmFrameWriter& operator=(const ShmFrameWriter&) = delete;
+
+  /// Claims a slot to capture into and returns its pixels (`stride()` bytes
+  /// per row), or nullptr if every slot is being read.
+  std::uint8_t* begin_frame() noexcept;
+
+  /// Publishes the slot claimed by `begin_frame` and wakes readers.
+  void publish(Timestamp timestamp) noexcept;
+
+  std::size_t stride() const noexcept { return ring_->header().stride; }
+  std::uint64_t dropped() const noexcept { return ring_->header().dropped.load(); }
+
+ private:
+  std::string name_;
+  std::unique_ptr<ShmMapping> ring_;
+  std::int64_t claimed_ = -1;
+};
+
+/// Consumer side: maps an existing ring and hands out its slots as frames,
+/// oldest ready frame first.
+class ShmFrameSource final : public FrameSource {
+ public:
+  /// Throws std::system_error if the object cannot be mapped and
+  /// std::runtime_error if it is not a compatible ring.
+  explicit ShmFrameSource(const std::string& name);
+  ~ShmFrameSource() override;
+
+  FrameRef acquire(std::chrono::milliseconds timeout) override;
+
+ private:
+  void recycle(std::uint32_t index) noexcept override;
+  FrameRef try_acquire() noexcept;
+
+  std::unique_ptr<ShmMapping> ring_;
+  std::unique_ptr<Frame[]> frames_;
+};
+
+}  // namespace meat_quality
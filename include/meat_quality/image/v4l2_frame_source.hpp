@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "meat_quality/image/frame.hpp"
+
+namespace meat_quality {
+
+struct V4l2Options {
+  std::string device = "/dev/video0";
+  std::uint32_t width = 1920;
+  std::uint32_t height = 1080;
+  /// Driver buffers. Frames held by the pipeline are not available for
+  /// capture, so this bounds how far the slowest stage may lag.
+  std::uint32_t buffer_count = 8;
+};
+
+/// Streams RGB24 frames from a V4L2 capture device using driver mmap
+/// buffers. Frames alias the driver buffers directly and are requeued to the
+/// driver when their last `FrameRef` is dropped.
+class V4l2FrameSource final : public FrameSource {
+ public:
+  /// Opens, configures and starts streaming. Throws std::system_error on
+  /// device errors and std::runtime_error if the device cannot deliver
+  /// RGB24 at the requested size (converting would cost a copy).
+  explicit V4l2FrameSource(const V4l2Options& options);
+  ~V4l2FrameSource() override;
+
+  V4l2FrameSource(const V4l2FrameSource&) = delete;
+  V4l2FrameSource& operator=(const V4l2FrameSource&) = delete;
+
+  FrameRef acquire(std::chrono::milliseconds timeout) override;
+
+  std::uint32_t width() const noexcept { return width_; }
+  std::uint32_t height() const noexcept { return height_; }
+
+ private:
+  struct Mapping {
+    void* start = nullptr;
+    std::size_t length = 0;
+  };
+
+  void recycle(std::uint32_t index) noexcept override;
+  void queue_buffer(std::uint32_t index);
+
+  int fd_ = -1;
+  std::uint32_t width_ = 0;
+  std::uint32_t height_ = 0;
+  std::size_t stride_ = 0;
+  std::vector<Mapping> mappings_;
+  std::unique_ptr<Frame[]> frames_;
+  std::mutex queue_mutex_;  // QBUF may come from any pipeline thread
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/inference/freshness_classifier.hpp"
+
+namespace meat_quality {
+
+/// When a micro-batch is closed: as soon as `max_batch` requests are
+/// waiting, or when the oldest waiting request has waited `max_wait`.
+struct BatchingPolicy {
+  std::size_t max_batch = 64;
+  std::chrono::microseconds max_wait{500};
+  /// Requests that may wait at once; `submit` fails beyond this.
+  std::size_t queue_capacity = 8192;
+
+  /// Large batches, long wait: best requests/s for audit bursts.
+  static BatchingPolicy throughput() noexcept { return {256, std::chrono::microseconds{2000}, 16384}; }
+  static BatchingPolicy balanced() noexcept { return {}; }
+  /// Small batches, short wait: best tail latency for interactive queries.
+  static BatchingPolicy latency() noexcept { return {8, std::chrono::microseconds{50}, 4096}; }
+};
+
+/// Cumulative engine counters. Batch sizes are bucketed by power of two:
+/// bucket `k` counts batches of size in `[2^k, 2^(k+1))`.
+struct BatchingStats {
+  static constexpr std::size_t kSizeBuckets = 16;
+
+  std::uint64_t requests = 0;
+  std::uint64_t batches = 0;
+  std::uint64_t rejected = 0;
+  std::uint64_t forward_ns = 0;     ///< total time in forward passes
+  std::uint64_t queue_wait_ns = 0;  ///< summed wait of each batch's oldest request
+  std::uint64_t last_batch_size = 0;
+  std::uint64_t last_forward_ns = 0;
+  std::uint64_t max_forward_ns = 0;
+  std::array<std::uint64_t, kSizeBuckets> batch_size_buckets{};
+
+  double mean_batch_size() const noexcept {
+    return batches == 0 ? 0.0 : double(requests) / double(batches);
+  }
+};
+
+/// Serves a `FreshnessClassifier` with dynamic micro-batching: requests from
+/// any thread are queued, a worker thread closes batches according to the
+/// `BatchingPolicy` and runs one forward pass per batch.
+class BatchingEngine {
+ public:
+  /// Completion hook for the allocation-free `submit`. Runs on the worker
+  /// thread; it must be quick and must not submit to the same engine.
+  using Callback = void (*)(void* context, const Prediction& prediction);
+
+  /// `classifier` must outlive the engine.
+  BatchingEngine(const FreshnessClassifier& classifier, BatchingPolicy policy = {});
+  ~BatchingEngine();
+
+  BatchingEngine(const BatchingEngine&) = delete;
+  BatchingEngine& operator=(const BatchingEngine&) = delete;
+
+  /// Queues a request. Returns false if the queue is full or the engine is
+  /// stopping; `callback` is then never called.
+  bool submit(const FeatureVector& features, Callback callback, void* context);
+
+  /// Queues a request and returns its result as a future. The future holds
+  /// std::runtime_error if the request was rejected.
+  std::future<Prediction> submit(const FeatureVector& features);
+
+  /// Blocks until every queued request has completed.
+  void drain();
+
+  /// Stops accepting requests, completes the queued ones and joins the
+  /// worker. Idempotent; also run by the destructor.
+  void stop();
+
+  const BatchingPolicy& policy() const noexcept { return policy_; }
+  BatchingStats stats() const;
+
+ private:
+  struct Request {
+    FeatureVector features;
+    Callback callback;
+    void* context;
+    std::chrono::steady_clock::time_point enqueued;
+  };
+
+  void run();
+  void process(std::vector<Request>& batch);
+
+  const FreshnessClassifier& classifier_;
+  const BatchingPolicy policy_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  std::vector<Request> pending_;
+  bool stopping_ = false;
+  bool busy_ = false;
+
+  // Worker-owned buffers, sized once for `max_batch`.
+  std::vector<FeatureVector> inputs_;
+  std::vector<Prediction> outputs_;
+  std::vector<float> scratch_;
+
+  BatchingStats stats_;  // guarded by mutex_
+  std::thread worker_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "meat_quality/features/window_features.hpp"
+
+namespace meat_quality {
+
+/// `kUnknown` is not a class the models predict: it marks a result that
+/// could not be computed (non-finite logits) and has no probabilities.
+enum class FreshnessClass : std::uint8_t { kFresh = 0, kSemiFresh, kSpoiled, kUnknown };
+
+inline constexpr std::size_t kFreshnessClassCount = 3;
+
+std::string_view freshness_class_name(FreshnessClass c) noexcept;
+
+/// Per-channel features in model order: mean, variance, slope, min, max, ewma.
+inline constexpr std::size_t kFeaturesPerChannel = 6;
+inline constexpr std::size_t kFeatureDim = kChannelCount * kFeaturesPerChannel;
+
+using FeatureVector = std::array<float, kFeatureDim>;
+
+/// Name of input `index`, e.g. "nh3_slope"; used for exported feature
+/// columns.
+std::string feature_name(std::size_t index);
+
+/// Flattens window features into the classifier's input layout. Channels not
+/// computed for the window are zero; a channel without finite readings
+/// passes its NaN statistics through, for the classifier to treat as
+/// missing.
+FeatureVector to_feature_vector(const WindowFeatures& features) noexcept;
+
+struct Prediction {
+  FreshnessClass label = FreshnessClass::kFresh;
+  std::array<float, kFreshnessClassCount> probabilities{};
+
+  float confidence() const noexcept {
+    return label != FreshnessClass::kUnknown ? probabilities[static_cast<std::size_t>(label)]
+                                             : 0.0f;
+  }
+};
+
+/// Softmax of class logits into `out`. Any non-finite logit gives
+/// `kUnknown` with zero probabilities rather than an arbitrary class.
+void softmax(const float* logits, Prediction& out) noexcept;
+
+/// Non-owning view of classifier parameters, e.g. in a mapped snapshot.
+/// Same layout and shapes as `ClassifierWeights`.
+struct ClassifierView {
+  std::size_t hidden = 0;
+  std::span<const float> input_mean;
+  std::span<const float> input_scale;
+  std::span<const float> w1;
+  std::span<const float> b1;
+  std::span<const float> w2;
+  std::span<const float> b2;
+};
+
+/// Parameters of the two-layer sensor classifier. Dense weights are stored
+/// input-major (`w[i * out + o]`) so the inner loop runs over outputs.
+struct ClassifierWeights {
+  std::size_t hidden = 0;
+  std::vector<float> input_mean;   ///< kFeatureDim
+  std::vector<float> input_scale;  ///< kFeatureDim, multiplies (x - mean)
+  std::vector<float> w1;           ///< kFeatureDim * hidden
+  std::vector<float> b1;           ///< hidden
+  std::vector<float> w2;           ///< hidden * kFreshnessClassCount
+  std::vector<float> b2;           ///< kFreshnessClassCount
+
+  /// Deterministic pseudo-random weights, for benchmarks and smoke runs.
+  static ClassifierWeights random(std::size_t hidden, std::uint64_t seed);
+
+  ClassifierView view() const noexcept {
+    return {hidden, input_mean, input_scale, w1, b1, w2, b2};
+  }
+};
+
+/// Fresh / semi-fresh / spoiled classifier over sensor window features:
+/// standardize, dense + ReLU, dense, softmax. A non-finite feature (e.g. a
+/// channel that dropped out for the whole window) is taken as missing and
+/// standardizes to 0, its training mean, so the other channels still
+/// decide. Stateless after construction and safe to call from several
+/// threads.
+class FreshnessClassifier {
+ public:
+  /// Throws std::invalid_argument if the weight shapes are inconsistent.
+  explicit FreshnessClassifier(ClassifierWeights weights);
+
+  /// Uses parameters owned elsewhere in place; they must outlive the
+  /// classifier. Throws std::invalid_argument like the owning constructor.
+  explicit FreshnessClassifier(const ClassifierView& view);
+
+  std::size_t hidden() const noexcept { return view().hidden; }
+
+  /// The parameters in use, owned or borrowed.
+  ClassifierView view() const noexcept { return borrowed_ ? borrowed_view_ : weights_.view(); }
+
+  /// Scratch floats `predict` needs for a batch of `batch` rows.
+  std::size_t scratch_size(std::size_t batch) const noexcept {
+    return batch * (kFeatureDim + hidden() + kFreshnessClassCount);
+  }
+
+  /// One forward pass over `batch` row-major feature vectors. `scratch` must
+  /// hold at least `scratch_size(batch)` floats.
+  void predict(const FeatureVector* inputs, std::size_t batch, Prediction* out,
+               std::span<float> scratch) const noexcept;
+
+  /// Convenience single-sample path; allocates its scratch per call.
+  Prediction predict(const FeatureVector& input) const;
+
+ private:
+  ClassifierWeights weights_;  // empty when borrowed
+  ClassifierView borrowed_view_;
+  bool borrowed_ = false;
+};
+
+}  // namespace meat_quality
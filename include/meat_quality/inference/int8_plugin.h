@@ -0,0 +1,46 @@
+/* C ABI between the library and an INT8 kernel plugin
+ * (libmeat_quality_int8.so). The library quantizes and packs the model and
+ * does the float parts of the forward pass; the plugin only provides the
+ * integer matrix product, built for instruction sets the baseline library
+ * cannot assume (AVX-VNNI, AVX-512 VNNI, Armv8.2 dot product). */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MQ_INT8_PLUGIN_ABI 1u
+
+/* Name of the entry point looked up with dlsym(). */
+#define MQ_INT8_PLUGIN_ENTRY "mq_int8_plugin_kernels"
+
+/* y[r * out + o] = bias[o] + sum_j a[r * k + j] * W[o][j], in int32.
+ *
+ * `a` holds `rows` rows of `k` uint8 activations. `k` is a multiple of 4
+ * and `out` of 16. `w` is W packed in blocks of 16 outputs by 4 inputs:
+ *   w[((o / 16) * (k / 4) + j / 4) * 64 + (o % 16) * 4 + j % 4] = W[o][j]
+ * `w_sums[o]` is sum_j W[o][j]; kernels built on signed-by-signed dot
+ * products (Arm SDOT) compute with a - 128 and add 128 * w_sums[o] back.
+ * The activation zero point is the library's business: it is folded into
+ * `bias`. None of the arithmetic saturates. */
+typedef void (*mq_int8_gemm_fn)(const uint8_t* a, size_t rows, size_t k, const int8_t* w,
+                                size_t out, const int32_t* bias, const int32_t* w_sums,
+                                int32_t* y);
+
+typedef struct mq_int8_kernels {
+  uint32_t abi;     /* MQ_INT8_PLUGIN_ABI */
+  const char* name; /* kernel variant, e.g. "avx512_vnni" */
+  mq_int8_gemm_fn gemm;
+} mq_int8_kernels;
+
+/* Returns the best kernels allowed by `simd_level` (the host's
+ * meat_quality::SimdLevel value) on the running CPU, or NULL if the plugin
+ * does not speak `abi`. The table is static. */
+typedef const mq_int8_kernels* (*mq_int8_plugin_entry_fn)(uint32_t abi, int simd_level);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "meat_quality/inference/freshness_classifier.hpp"
+#include "meat_quality/inference/int8_plugin.h"
+
+namespace meat_quality {
+
+struct CalibrationOptions {
+  /// Quantile of |activation| over the calibration set that maps to the
+  /// end of the 8-bit range; rarer outliers clip. 1.0 keeps the maximum.
+  double clip_quantile = 0.9999;
+};
+
+/// One dense layer with int8 weights, quantized per output channel, and
+/// uint8 activations quantized per tensor with a zero point. Dimensions
+/// are padded to the kernel layout (inputs to 4, outputs to 16); padded
+/// weights are zero.
+struct QuantizedLayer {
+  std::size_t in = 0;          ///< logical input width
+  std::size_t out = 0;         ///< logical output width
+  std::size_t k = 0;           ///< padded input width
+  std::size_t out_padded = 0;  ///< padded output width
+  float in_scale = 1.0f;       ///< real activation = in_scale * (q - in_zero_point)
+  std::uint8_t in_zero_point = 0;
+  std::vector<std::int8_t> w;        ///< packed as in int8_plugin.h, out_padded * k
+  std::vector<float> w_scale;        ///< out_padded; real weight = w_scale * q
+  std::vector<std::int32_t> bias;    ///< out_padded, with the zero point folded in
+  std::vector<std::int32_t> w_sums;  ///< out_padded
+};
+
+/// INT8 form of `ClassifierWeights`. Standardization stays in float.
+struct QuantizedWeights {
+  std::size_t hidden = 0;
+  std::vector<float> input_mean;
+  std::vector<float> input_scale;
+  QuantizedLayer l1;  ///< features -> hidden, ReLU
+  QuantizedLayer l2;  ///< hidden -> class logits
+
+  /// Bytes of model parameters, for comparison with the FP32 model's
+  /// `sizeof(float)` per weight.
+  std::size_t parameter_bytes() const noexcept;
+};
+
+/// Quantizes `weights`, choosing activation ranges from the model's
+/// activations on `calibration` (a few hundred representative feature
+/// vectors is plenty). Throws std::invalid_argument on empty calibration
+/// data or inconsistent weight shapes.
+QuantizedWeights quantize(const ClassifierWeights& weights,
+                          std::span<const FeatureVector> calibration,
+                          CalibrationOptions options = {});
+
+/// Integer matrix-product kernels: either the portable ones built into the
+/// library or those of an INT8 plugin loaded with dlopen().
+class Int8Backend {
+ public:
+  /// Conventional file name, found through the dynamic loader's search path.
+  static constexpr const char* kDefaultPlugin = "libmeat_quality_int8.so";
+
+  /// Portable C++ kernels; always available.
+  static const Int8Backend& reference() noexcept;
+
+  /// Loads a plugin and selects its kernels for the active SIMD level.
+  /// Throws std::runtime_error if the file cannot be loaded, has no entry
+  /// point, or speaks another ABI.
+  static Int8Backend load(const std::string& path = kDefaultPlugin);
+
+  Int8Backend(Int8Backend&& other) noexcept;
+  Int8Backend& operator=(Int8Backend&& other) noexcept;
+  ~Int8Backend();
+
+  std::string_view name() const noexcept { return kernels_->name; }
+  mq_int8_gemm_fn gemm() const noexcept { return kernels_->gemm; }
+
+ private:
+  Int8Backend(void* handle, const mq_int8_kernels* kernels) noexcept
+      : handle_(handle), kernels_(kernels) {}
+
+  void* handle_ = nullptr;  ///< dlopen() handle; null for the reference kernels
+  const mq_int8_kernels* kernels_ = nullptr;
+};
+
+/// INT8 execution of the freshness classifier: same inputs and outputs as
+/// `FreshnessClassifier`, a quarter of the weight memory, and integer
+/// dot-product kernels. Missing (non-finite) features quantize to the zero
+/// point, the training mean, as they standardize to 0 in FP32. Stateless after construction and safe to call from
+/// several threads.
+class QuantizedClassifier {
+ public:
+  /// The backend must outlive the classifier. Throws std::invalid_argument
+  /// if the layer shapes are inconsistent.
+  explicit QuantizedClassifier(QuantizedWeights weights,
+                               const Int8Backend& backend = Int8Backend::reference());
+
+  std::size_t hidden() const noexcept { return weights_.hidden; }
+  const QuantizedWeights& weights() const noexcept { return weights_; }
+  std::string_view backend_name() const noexcept { return backend_.name(); }
+
+  /// Scratch int32 words `predict` needs for a batch of `batch` rows.
+  std::size_t scratch_size(std::size_t batch) const noexcept;
+
+  void predict(const FeatureVector* inputs, std::size_t batch, Prediction* out,
+               std::span<std::int32_t> scratch) const noexcept;
+
+  /// Convenience single-sample path; allocates its scratch per call.
+  Prediction predict(const FeatureVector& input) const;
+
+ private:
+  QuantizedWeights weights_;
+  const Int8Backend& backend_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace meat_quality {
+
+class EventLoop;
+
+/// Return type of a fire-and-forget coroutine: it starts running when
+/// called and frees its frame when it finishes. Connection handlers own
+/// their state in the frame and must not let exceptions escape.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+/// Registration of one file descriptor with an event loop and the
+/// coroutines waiting for it to become readable or writable.
+struct IoHandle {
+  int fd = -1;
+  std::coroutine_handle<> reader;
+  std::coroutine_handle<> writer;
+  IoHandle* prev = nullptr;
+  IoHandle* next = nullptr;
+};
+
+/// Single-threaded epoll reactor that resumes coroutines.
+///
+/// Descriptors are registered once, edge-triggered, for both directions. A
+/// coroutine performs non-blocking I/O until it would block and then
+/// awaits `readable()` or `writable()`; the loop resumes it on the next
+/// edge. An idle connection costs its coroutine frame and one epoll entry,
+/// not a thread and its stack. Everything except `post()` and `stop()`
+/// must be called on the loop thread.
+class EventLoop {
+ public:
+  /// Throws std::system_error if epoll or the wakeup eventfd cannot be
+  /// created.
+  EventLoop();
+  ~EventLoop();
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  /// Runs until `stop()` was called and every task has finished.
+  void run();
+
+  /// Requests the loop to wind down, from any thread: every registered
+  /// descriptor is shut down so that waiting tasks see EOF or an error and
+  /// return. Tasks suspended on something else (a pending grade) finish
+  /// when that resumes them.
+  void stop() noexcept;
+
+  /// Resumes `h` on the loop thread; callable from any thread.
+  void post(std::coroutine_handle<> h);
+
+  /// Registers a non-blocking descriptor. Throws std::system_error.
+  IoHandle* attach(int fd);
+
+  /// Deregisters and closes the descriptor. The handle is freed after the
+  /// current batch of events, so events already fetched for it are safe.
+  void detach(IoHandle* io) noexcept;
+
+  bool stopping() const noexcept { return stop_.load(std::memory_order_relaxed); }
+
+  /// Counts a task as live for the lifetime of the token; `run()` does not
+  /// return while any exists.
+  class TaskToken {
+   public:
+    explicit TaskToken(EventLoop& loop) noexcept : loop_(loop) { ++loop_.live_tasks_; }
+    ~TaskToken() { --loop_.live_tasks_; }
+    TaskToken(const TaskToken&) = delete;
+    TaskToken& operator=(const TaskToken&) = delete;
+
+   private:
+    EventLoop& loop_;
+  };
+
+  struct IoAwaiter {
+    IoHandle* io;
+    bool write;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { (write ? io->writer : io->reader) = h; }
+    void await_resume() const noexcept {}
+  };
+
+  /// Suspends until the next readable (or error/hang-up) edge. Await only
+  /// after a read returned EAGAIN.
+  IoAwaiter readable(IoHandle* io) noexcept { return {io, false}; }
+  IoAwaiter writable(IoHandle* io) noexcept { return {io, true}; }
+
+  std::size_t live_tasks() const noexcept { return live_tasks_; }
+
+ private:
+  void shut_down_all();
+  void run_posted();
+
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::atomic<bool> stop_{false};
+  bool shut_down_ = false;
+  std::size_t live_tasks_ = 0;
+  IoHandle* handles_ = nullptr;  // intrusive list of attached handles
+  std::vector<IoHandle*> graveyard_;
+
+  std::mutex posted_mutex_;
+  std::vector<std::coroutine_handle<>> posted_;
+  std::vector<std::coroutine_handle<>> running_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/core/ingest_queue.hpp"
+#include "meat_quality/features/sampling_rate.hpp"
+#include "meat_quality/features/spoilage_alert.hpp"
+#include "meat_quality/net/event_loop.hpp"
+#include "meat_quality/net/grade_broker.hpp"
+#include "meat_quality/net/partitioned_grader.hpp"
+
+namespace meat_quality {
+
+struct FrontEndOptions {
+  std::string host = "0.0.0.0";
+  std::uint16_t port = 0;  ///< 0 picks a free port; see FrontEnd::port()
+  std::size_t threads = 2;
+  int backlog = 1024;
+  /// Larger frames close the connection.
+  std::size_t max_frame = std::size_t{1} << 20;
+  /// Initial per-connection read buffer; grows for larger frames and
+  /// shrinks back once they are consumed.
+  std::size_t read_buffer = 4096;
+  /// If set, a push connection gets a kRateHint frame when the interval
+  /// chosen for one of its nodes changes (nodes start at the full rate).
+  /// Each change is sent once, on the connection that next carries the
+  /// node, since the node keeps the interval it was told. Must outlive the
+  /// front end.
+  SamplingRateController* rates = nullptr;
+  /// If set, every pushed sample is also queued on this alert lane, stamped
+  /// with its arrival time, ahead of the ingest queue. Must outlive the
+  /// front end.
+  AlertLane* alerts = nullptr;
+};
+
+struct FrontEndStats {
+  std::uint64_t accepted = 0;
+  std::uint64_t open = 0;
+  std::uint64_t samples = 0;          ///< pushed into the ingest queue
+  std::uint64_t samples_dropped = 0;  ///< refused by the ingest queue
+  std::uint64_t grades = 0;
+  std::uint64_t protocol_errors = 0;  ///< connections closed for bad frames
+  std::uint64_t rate_hints = 0;
+};
+
+/// TCP front end for sensor pushes and grade queries (`net/protocol.hpp`).
+///
+/// A few event-loop threads each accept on their own SO_REUSEPORT socket
+/// and run one coroutine per connection. Sensor pushes go into the ingest
+/// queue; grade queries suspend their connection on the `GradeBroker` until
+/// the grading thread answers. Neither ever blocks a loop thread, so the
+/// ingest queue must not use Backpressure::kBlock.
+///
+///     FrontEnd net(queue, broker, {.port = 7400});
+///     net.start();
+///     while (running) {  // the grading thread
+///       drain_batch(queue, store, batch, 1ms);
+///       broker.serve(pipeline);
+///     }
+///     net.stop();
+class FrontEnd {
+ public:
+  /// Binds the listening sockets. Throws std::system_error, or
+  /// std::invalid_argument for a blocking ingest queue, zero threads or a
+  /// bad address. The queue and broker must outlive the front end.
+  FrontEnd(IngestQueue& ingest, GradeBroker& grades, FrontEndOptions options = {});
+
+  /// Routes pushes and grades to the partitions of a started `grader`
+  /// instead, which must outlive the front end.
+  FrontEnd(PartitionedGrader& grader, FrontEndOptions options = {});
+  ~FrontEnd();
+
+  FrontEnd(const FrontEnd&) = delete;
+  FrontEnd& operator=(const FrontEnd&) = delete;
+
+  /// Starts the event-loop threads.
+  void start();
+
+  /// Closes every connection and joins the threads. Connections waiting
+  /// for a grade finish once it arrives, so keep serving the broker until
+  /// this returns.
+  void stop();
+
+  std::uint16_t port() const noexcept { return port_; }
+  FrontEndStats stats() const noexcept;
+
+ private:
+  struct Worker {
+    EventLoop loop;
+    int listen_fd = -1;
+    std::thread thread;
+  };
+
+  void open_listeners();
+  Detached accept_loop(Worker& worker);
+  Detached serve_connection(EventLoop& loop, int fd);
+
+  bool push(const IngestRecord& record) noexcept {
+    return grader_ != nullptr ? grader_->push(record) : ingest_->push(record);
+  }
+  GradeBroker::Awaiter grade(EventLoop& loop, const GradingRequest& request,
+                             GradeResult& result) noexcept {
+    return grader_ != nullptr ? grader_->grade(loop, request, result)
+                              : grades_->grade(loop, request, result);
+  }
+
+  // Either a queue and a broker, or a partitioned grader.
+  IngestQueue* ingest_ = nullptr;
+  GradeBroker* grades_ = nullptr;
+  PartitionedGrader* grader_ = nullptr;
+  FrontEndOptions options_;
+  std::uint16_t port_ = 0;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  std::atomic<std::uint64_t> accepted_{0};
+  std::atomic<std::uint64_t> closed_{0};
+  std::atomic<std::uint64_t> samples_{0};
+  std::atomic<std::uint64_t> samples_dropped_{0};
+  std::atomic<std::uint64_t> grades_served_{0};
+  std::atomic<std::uint64_t> protocol_errors_{0};
+  std::atomic<std::uint64_t> rate_hints_{0};
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <vector>
+
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/net/event_loop.hpp"
+#include "meat_quality/net/protocol.hpp"
+#include "meat_quality/util/mpsc_queue.hpp"
+
+namespace meat_quality {
+
+/// Hand-off of grade requests from event-loop coroutines to the grading
+/// thread that owns the store.
+///
+/// A coroutine awaits `grade()`: its request is queued and the coroutine
+/// suspends without blocking its loop. The grading thread calls `serve()`
+/// between ingest drains; that grades everything queued with one batched
+/// pass and resumes each coroutine on its own loop. A full queue fails the
+/// request with kOverloaded instead of stalling the loop.
+class GradeBroker {
+ public:
+  class Awaiter {
+   public:
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) noexcept;
+    wire::GradeStatus await_resume() const noexcept { return status_; }
+
+   private:
+    friend class GradeBroker;
+    Awaiter(GradeBroker& broker, EventLoop& loop, const GradingRequest& request,
+            GradeResult& result) noexcept
+        : broker_(broker), loop_(loop), request_(request), result_(result) {}
+
+    GradeBroker& broker_;
+    EventLoop& loop_;
+    GradingRequest request_;
+    GradeResult& result_;
+    wire::GradeStatus status_ = wire::GradeStatus::kOk;
+    std::coroutine_handle<> handle_;
+  };
+
+  /// `capacity` bounds queued requests; `max_batch` bounds one `serve()`.
+  /// Requests name global node ids; the served store holds ids
+  /// [`node_base`, `node_base + node_count()`) as its nodes 0, 1, ...
+  explicit GradeBroker(std::size_t capacity = 4096, std::size_t max_batch = 256,
+                       NodeId node_base = 0);
+
+  /// `co_await broker.grade(loop, request, result)` yields the status;
+  /// `result` is filled in when it is kOk. Call on `loop`'s thread.
+  Awaiter grade(EventLoop& loop, const GradingRequest& request, GradeResult& result) noexcept {
+    return Awaiter(*this, loop, request, result);
+  }
+
+  /// Grading thread: grades up to `max_batch` queued requests, waiting up
+  /// to `timeout` for the first. Returns the number completed.
+  std::size_t serve(const GradingPipeline& pipeline,
+                    std::chrono::microseconds timeout = std::chrono::microseconds{0});
+
+  /// Fails further requests with kShuttingDown; `serve()` still completes
+  /// the ones already queued.
+  void close() noexcept { queue_.close(); }
+
+  std::size_t pending() const noexcept { return queue_.size_approx(); }
+
+ private:
+  MpscQueue<Awaiter*> queue_;
+  NodeId node_base_;
+  std::vector<Awaiter*> batch_;
+  std::vector<GradingRequest> requests_;
+  std::vector<GradeResult> results_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/core/ingest_queue.hpp"
+#include "meat_quality/core/node_registry.hpp"
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/net/grade_broker.hpp"
+#include "meat_quality/util/numa.hpp"
+
+namespace meat_quality {
+
+struct PartitionedGraderOptions {
+  std::size_t node_count = 4096;
+  std::size_t capacity_per_node = 36'000;
+  /// Per partition.
+  std::size_t queue_capacity = 65536;
+  std::size_t drain_batch = 512;
+  std::size_t grade_capacity = 4096;
+  /// Longest an idle partition waits for samples before serving grades.
+  std::chrono::microseconds poll{200};
+  GradingOptions grading;
+  /// If set, push() corrects each sample with its node's calibration from
+  /// this registry, on the producer's thread. Must outlive the grader.
+  const NodeRegistry* registry = nullptr;
+};
+
+struct PartitionedGraderStats {
+  std::uint64_t samples = 0;   ///< stored into the partition stores
+  std::uint64_t rejected = 0;  ///< refused by a full queue, out of order or unknown node
+  std::uint64_t grades = 0;
+};
+
+/// Grading service split by NUMA node: node ids are divided into one
+/// contiguous range per socket, and each range has its own ingest queue,
+/// sample store, grade broker and grading thread pinned to that socket.
+///
+/// Everything a partition touches on the hot path is allocated by its own
+/// pinned thread, so first-touch places it in the socket's local memory;
+/// the classifier is copied per partition for the same reason. `push()`
+/// and `grade()` route by node id, so producers on either socket hand a
+/// sample straight to the socket that owns its window.
+class PartitionedGrader {
+ public:
+  /// Builds nothing but the node ranges; see start(). The converter must
+  /// outlive the grader; the classifier is copied.
+  PartitionedGrader(const NumaTopology& topology, const FreshnessClassifier& classifier,
+                    const LabConverter& converter, PartitionedGraderOptions options = {});
+
+  /// Calls stop().
+  ~PartitionedGrader();
+
+  PartitionedGrader(const PartitionedGrader&) = delete;
+  PartitionedGrader& operator=(const PartitionedGrader&) = delete;
+
+  /// Starts the partition threads and waits until each has built its
+  /// state. Throws what a partition thread threw while doing so.
+  void start();
+
+  /// Answers the grades already queued, then joins the threads. Samples
+  /// still queued are dropped.
+  void stop();
+
+  std::size_t partition_count() const noexcept { return partitions_.size(); }
+
+  /// Partition owning `node`; node ids at or beyond `node_count` map to
+  /// the last one, whose broker reports them unknown.
+  std::size_t partition_of(NodeId node) const noexcept {
+    const std::size_t p = std::size_t{node} * partitions_.size() / options_.node_count;
+    return p < partitions_.size() ? p : partitions_.size() - 1;
+  }
+
+  /// Queues a sample on its partition; callable from any thread. Returns
+  /// false if the partition's queue refused it or the grader is stopped.
+  bool push(const IngestRecord& record) noexcept;
+
+  /// `co_await grader.grade(loop, request, result)`, routed to the owning
+  /// partition; see GradeBroker::grade(). Call only after start().
+  GradeBroker::Awaiter grade(EventLoop& loop, const GradingRequest& request,
+                             GradeResult& result) noexcept {
+    return partitions_[partition_of(request.node)]->broker->grade(loop, request, result);
+  }
+
+  PartitionedGraderStats stats() const noexcept;
+
+ private:
+  struct Partition {
+    std::vector<int> cpus;
+    NodeId first = 0;
+    std::size_t nodes = 0;
+    // Built by the partition thread.
+    std::unique_ptr<IngestQueue> queue;
+    std::unique_ptr<GradeBroker> broker;
+    std::thread thread;
+    std::atomic<bool> ready{false};
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> rejected{0};
+    std::atomic<std::uint64_t> grades{0};
+    std::exception_ptr error;  // from building the state
+  };
+
+  void run(Partition& p);
+
+  const FreshnessClassifier classifier_;
+  const LabConverter& converter_;
+  PartitionedGraderOptions options_;
+  std::vector<std::unique_ptr<Partition>> partitions_;
+  std::atomic<bool> stop_{false};
+  std::atomic<std::size_t> started_{0};
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,162 @@
+#pragma once
+
+// Wire format of the network front end. Every message is a frame: a u32
+// body length, then a u8 frame type, then the body. All integers and
+// floats are little-endian.
+//
+//   kSensorPush     u32 count, then count records of
+//                   { u32 node, i64 timestamp, f32 values[kChannelCount] }
+//   kGradeRequest   u64 request id, u32 node, i64 at (0: newest sample)
+//   kGradeResponse  u64 request id, u8 GradeStatus, u8 label, u16 0,
+//                   u32 samples, i64 at, f32 probabilities[classes]
+//   kRateHint       u32 node, u32 report interval in milliseconds
+//   kPackedPush     varint count, then runs of one node's records:
+//                   { varint node, varint n, n records }. A record is a
+//                   zigzag-varint timestamp and kChannelCount zigzag-varint
+//                   fixed-point values (see kPackedScale), each a delta
+//                   from the run's previous record; the first record of a
+//                   run is relative to zero.
+//
+// Pushes are not acknowledged, but the server may answer them with rate
+// hints asking a node to report more or less often. Grade requests on one
+// connection are answered in order.
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "meat_quality/core/ingest_queue.hpp"
+#include "meat_quality/grading/grading_pipeline.hpp"
+
+namespace meat_quality::wire {
+
+enum class FrameType : std::uint8_t {
+  kSensorPush = 1,
+  kGradeRequest = 2,
+  kGradeResponse = 3,
+  kRateHint = 4,
+  kPackedPush = 5,
+};
+
+enum class GradeStatus : std::uint8_t {
+  kOk = 0,
+  kUnknownNode = 1,  ///< node id outside the grader's store
+  kOverloaded = 2,   ///< the grading queue was full; retry later
+  kShuttingDown = 3,
+};
+
+constexpr const char* grade_status_name(GradeStatus s) noexcept {
+  switch (s) {
+    case GradeStatus::kOk: return "ok";
+    case GradeStatus::kUnknownNode: return "unknown_node";
+    case GradeStatus::kOverloaded: return "overloaded";
+    case GradeStatus::kShuttingDown: return "shutting_down";
+  }
+  return "unknown";
+}
+
+inline constexpr std::size_t kFrameHeaderBytes = 5;
+inline constexpr std::size_t kSampleRecordBytes = 4 + 8 + 4 * kChannelCount;
+inline constexpr std::size_t kGradeRequestBytes = 8 + 4 + 8;
+inline constexpr std::size_t kGradeResponseBytes = 8 + 4 + 4 + 8 + 4 * kFreshnessClassCount;
+inline constexpr std::size_t kRateHintBytes = 4 + 4;
+
+struct GradeRequestFrame {
+  std::uint64_t id = 0;
+  NodeId node = 0;
+  Timestamp at = 0;
+};
+
+struct GradeResponseFrame {
+  std::uint64_t id = 0;
+  GradeStatus status = GradeStatus::kOk;
+  GradeResult result;  ///< node, at, samples and sensor prediction only
+};
+
+/// Fixed-point steps per channel unit in kPackedPush values: 0.01 ppm NH3,
+/// 1 ppb H2S, 0.1 ppb VOC, 0.01 °C, 0.01 %RH and 0.001 pH. Values round
+/// to the nearest step; a non-finite value travels as a marker and decodes
+/// as NaN.
+inline constexpr float kPackedScale[kChannelCount] = {100.0f, 1000.0f, 10.0f,
+                                                      100.0f, 100.0f,  1000.0f};
+
+/// Longest kPackedPush record: a 10-byte varint timestamp delta and
+/// 5-byte varint value deltas.
+inline constexpr std::size_t kMaxPackedRecordBytes = 10 + 5 * kChannelCount;
+
+struct RateHintFrame {
+  NodeId node = 0;
+  std::uint32_t interval_ms = 0;
+};
+
+/// Reads a frame header. `length` counts the type byte and the body.
+void parse_frame_header(const std::uint8_t* p, std::uint32_t& length, FrameType& type) noexcept;
+
+/// Appends one sensor-push frame carrying `records`.
+void append_sensor_push(std::vector<std::uint8_t>& out, std::span<const IngestRecord> records);
+void append_grade_request(std::vector<std::uint8_t>& out, const GradeRequestFrame& request);
+void append_grade_response(std::vector<std::uint8_t>& out, const GradeResponseFrame& response);
+void append_rate_hint(std::vector<std::uint8_t>& out, const RateHintFrame& hint);
+
+/// Appends one kPackedPush frame carrying `records`. Consecutive records
+/// of the same node share a run, so group a gateway's batch by node (and
+/// by time within a node) for the best packing.
+void append_packed_push(std::vector<std::uint8_t>& out, std::span<const IngestRecord> records);
+
+/// Sample `i` of a sensor-push body whose size was validated against its
+/// count.
+IngestRecord sensor_record(const std::uint8_t* body, std::size_t i) noexcept;
+
+/// Body parsers; false if the body has the wrong size or bad values.
+bool parse_sensor_push(std::span<const std::uint8_t> body, std::uint32_t& count) noexcept;
+bool parse_grade_request(std::span<const std::uint8_t> body, GradeRequestFrame& out) noexcept;
+bool parse_grade_response(std::span<const std::uint8_t> body, GradeResponseFrame& out) noexcept;
+bool parse_rate_hint(std::span<const std::uint8_t> body, RateHintFrame& out) noexcept;
+
+/// Checks a kPackedPush body end to end and reads its record count,
+/// decoding and dropping the records.
+bool parse_packed_push(std::span<const std::uint8_t> body, std::uint32_t& count) noexcept;
+
+/// Decodes the records of a kPackedPush body one at a time and without
+/// allocating, so they can go straight into an ingest queue or a
+/// `SampleStore`. The body is checked as it is read, so there is no need
+/// to parse_packed_push() it first; records before a malformed one are
+/// returned, so check failed() once next() returns false:
+///
+///     PackedPushReader reader(body);
+///     for (IngestRecord r; reader.next(r);) store.push(r.node, r.sample);
+///     if (reader.failed()) drop_connection();
+class PackedPushReader {
+ public:
+  explicit PackedPushReader(std::span<const std::uint8_t> body) noexcept;
+
+  /// Next record; false once the body is exhausted or found malformed.
+  bool next(IngestRecord& out) noexcept;
+
+  /// True if decoding stopped at a malformed record, or the records did
+  /// not add up to the declared count.
+  bool failed() const noexcept { return failed_; }
+
+  /// Record count declared by the body.
+  std::uint32_t count() const noexcept { return count_; }
+
+ private:
+  bool fail() noexcept {
+    failed_ = true;
+    p_ = end_;
+    return false;
+  }
+
+  const std::uint8_t* p_;
+  const std::uint8_t* end_;
+  bool failed_ = false;
+  std::uint32_t count_ = 0;
+  std::uint64_t read_ = 0;
+  std::uint64_t run_left_ = 0;
+  NodeId node_ = 0;
+  std::int64_t timestamp_ = 0;
+  std::int64_t values_[kChannelCount] = {};
+};
+
+}  // namespace meat_quality::wire
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "meat_quality/net/event_loop.hpp"
+
+namespace meat_quality {
+
+/// Non-blocking stream socket registered with an event loop. The I/O calls
+/// return a byte count, 0 at end of stream, or a negated errno; -EAGAIN
+/// means await `readable()` / `writable()` and retry.
+class AsyncSocket {
+ public:
+  static constexpr std::ptrdiff_t kWouldBlock = -EAGAIN;
+
+  /// Takes ownership of `fd`, makes it non-blocking and registers it.
+  /// Throws std::system_error; `fd` is closed in that case too.
+  AsyncSocket(EventLoop& loop, int fd);
+  ~AsyncSocket();
+
+  AsyncSocket(const AsyncSocket&) = delete;
+  AsyncSocket& operator=(const AsyncSocket&) = delete;
+
+  std::ptrdiff_t read(void* data, std::size_t size) noexcept;
+  std::ptrdiff_t write(const void* data, std::size_t size) noexcept;
+
+  /// Accepts a connection of a listening socket: the new descriptor, or a
+  /// negated errno.
+  int accept() noexcept;
+
+  EventLoop::IoAwaiter readable() noexcept { return loop_.readable(io_); }
+  EventLoop::IoAwaiter writable() noexcept { return loop_.writable(io_); }
+
+  int fd() const noexcept { return io_->fd; }
+  EventLoop& loop() const noexcept { return loop_; }
+
+ private:
+  EventLoop& loop_;
+  IoHandle* io_;
+};
+
+/// Bound, listening TCP socket with SO_REUSEPORT, so that every event loop
+/// of a server can listen on the same port and the kernel spreads incoming
+/// connections over them. Port 0 picks a free port. Throws
+/// std::system_error; std::invalid_argument for an unparsable address.
+int listen_tcp(const std::string& host, std::uint16_t port, int backlog);
+
+/// Port a socket is bound to.
+std::uint16_t local_port(int fd);
+
+}  // namespace meat_quality
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace meat_quality {
+
+/// On-disk layout of an exported training feature matrix.
+///
+/// `FileHeader`, then `column_count` `ColumnEntry`s, then one array of
+/// `rows` values per column, each starting on a cache line. All values are
+/// little-endian, so a column can be mapped straight into numpy
+/// (`np.memmap(path, dtype, offset=entry.offset, shape=(rows,))`). The
+/// header's magic is written last: a file whose magic does not match was
+/// not finished.
+namespace feature_matrix {
+
+inline constexpr std::uint64_t kMagic = 0x0031544d46514d;  // "MQFMT1"
+inline constexpr std::uint32_t kVersion = 1;
+inline constexpr std::size_t kMaxNameBytes = 47;
+
+enum class ColumnType : std::uint32_t {
+  kU32 = 1,
+  kI32 = 2,
+  kI64 = 3,
+  kF32 = 4,
+};
+
+constexpr std::size_t column_type_size(ColumnType t) noexcept {
+  return t == ColumnType::kI64 ? 8 : 4;
+}
+
+template <typename T>
+constexpr ColumnType column_type_of() noexcept;
+template <>
+constexpr ColumnType column_type_of<std::uint32_t>() noexcept { return ColumnType::kU32; }
+template <>
+constexpr ColumnType column_type_of<std::int32_t>() noexcept { return ColumnType::kI32; }
+template <>
+constexpr ColumnType column_type_of<std::int64_t>() noexcept { return ColumnType::kI64; }
+template <>
+constexpr ColumnType column_type_of<float>() noexcept { return ColumnType::kF32; }
+
+struct FileHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t column_count;
+  std::uint64_t rows;
+  std::uint64_t reserved;
+};
+
+struct ColumnEntry {
+  char name[kMaxNameBytes + 1];  ///< NUL-terminated
+  ColumnType type;
+  std::uint32_t reserved;
+  std::uint64_t offset;  ///< of the values, from the start of the file
+};
+
+static_assert(sizeof(FileHeader) == 32);
+static_assert(sizeof(ColumnEntry) == 64);
+
+}  // namespace feature_matrix
+
+struct ColumnSpec {
+  std::string name;
+  feature_matrix::ColumnType type;
+};
+
+/// Writes a feature matrix whose shape is known up front. The file is
+/// sized on construction and every `write()` goes straight to the column's
+/// slice with `pwrite`, so threads filling disjoint row ranges need no
+/// coordination and the bytes do not depend on who wrote what first.
+class FeatureMatrixWriter {
+ public:
+  /// Creates (or truncates) `path`. Throws std::invalid_argument for empty
+  /// or over-long column names and std::system_error on I/O failure.
+  FeatureMatrixWriter(const std::string& path, std::uint64_t rows,
+                      std::span<const ColumnSpec> columns);
+
+  /// Closes the file without finishing it if `finish()` was not called.
+  ~FeatureMatrixWriter();
+
+  FeatureMatrixWriter(const FeatureMatrixWriter&) = delete;
+  FeatureMatrixWriter& operator=(const FeatureMatrixWriter&) = delete;
+
+  std::uint64_t rows() const noexcept { return rows_; }
+  std::size_t column_count() const noexcept { return entries_.size(); }
+
+  /// Stores `values` as rows [first_row, first_row + size) of `column`.
+  /// Thread-safe for disjoint ranges. Throws std::invalid_argument if the
+  /// type or range does not fit the column and std::system_error on I/O
+  /// failure.
+  template <typename T>
+  void write(std::size_t column, std::uint64_t first_row, std::span<const T> values) {
+    write_raw(column, feature_matrix::column_type_of<T>(), first_row, values.data(),
+              values.size());
+  }
+
+  /// Writes the header, syncs and closes. Throws std::system_error.
+  void finish();
+
+ private:
+  void write_raw(std::size_t column, feature_matrix::ColumnType type, std::uint64_t first_row,
+                 const void* data, std::size_t count);
+  void write_at(const void* data, std::size_t n, std::uint64_t offset);
+
+  int fd_ = -1;
+  std::uint64_t rows_;
+  std::vector<feature_matrix::ColumnEntry> entries_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality {
+
+/// On-disk layout of a rollup file: sensor history downsampled into
+/// fixed-length buckets holding per-channel min, max and mean.
+///
+/// `FileHeader`, then every node's buckets back to back (node-major, oldest
+/// first), then the index (one `NodeEntry` per node, sorted by node), then
+/// the `Trailer`. All integers are little-endian and every struct is read
+/// in place from the mapping. Buckets are fixed-size so that a query is a
+/// binary search and a span, with nothing to decode.
+namespace rollup {
+
+inline constexpr std::uint64_t kMagic = 0x314c4f52514d;  // "MQROL1"
+inline constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t channel_count;
+  std::int64_t resolution;  ///< bucket length, microseconds
+  /// Time range of the history summarized, inclusive.
+  std::int64_t from;
+  std::int64_t to;
+};
+
+struct Bucket {
+  std::int64_t t;       ///< bucket start, a multiple of the resolution
+  std::uint32_t count;  ///< samples summarized
+  std::uint32_t reserved;
+  /// NaN readings are left out; a channel with none left is NaN.
+  std::array<float, kChannelCount> min;
+  std::array<float, kChannelCount> max;
+  std::array<float, kChannelCount> mean;
+  /// Non-NaN readings per channel, the weight of its mean when merged.
+  std::array<std::uint32_t, kChannelCount> readings;
+};
+
+struct NodeEntry {
+  std::uint32_t node;
+  std::uint32_t reserved;
+  std::uint64_t first;  ///< index of the node's first bucket
+  std::uint64_t count;
+};
+
+struct Trailer {
+  std::uint64_t index_offset;
+  std::uint64_t node_count;
+  std::uint64_t magic;
+};
+
+static_assert(sizeof(FileHeader) == 40);
+static_assert(sizeof(Bucket) == 112);
+static_assert(sizeof(NodeEntry) == 24);
+static_assert(sizeof(Trailer) == 24);
+
+/// Start of the bucket of length `resolution` holding `t`.
+constexpr Timestamp bucket_start(Timestamp t, Timestamp resolution) noexcept {
+  const Timestamp r = t % resolution;
+  return t - (r < 0 ? r + resolution : r);
+}
+
+}  // namespace rollup
+
+/// Builds one bucket from samples or from finer buckets. Means are summed
+/// in double and weighted by each channel's reading count, so rolling
+/// 1-minute buckets up into hours gives what rolling the samples up would,
+/// to float rounding.
+class RollupAccumulator {
+ public:
+  void reset(Timestamp t) noexcept;
+
+  void add(const SensorSample& sample) noexcept;
+  void add(const rollup::Bucket& finer) noexcept;
+
+  Timestamp start() const noexcept { return t_; }
+  bool empty() const noexcept { return count_ == 0; }
+  rollup::Bucket bucket() const noexcept;
+
+ private:
+  Timestamp t_ = 0;
+  std::uint64_t count_ = 0;
+  std::array<double, kChannelCount> sum_{};
+  std::array<std::uint64_t, kChannelCount> weight_{};
+  std::array<float, kChannelCount> min_{};
+  std::array<float, kChannelCount> max_{};
+};
+
+/// Writes a rollup file. Input arrives one node at a time, in increasing
+/// node order, each node oldest first; only the open bucket and the index
+/// are held in memory. Not thread-safe.
+class RollupWriter {
+ public:
+  /// Creates (or truncates) `path`. Throws std::invalid_argument for a
+  /// non-positive resolution and std::system_error on failure.
+  RollupWriter(const std::string& path, Timestamp resolution);
+
+  /// Calls finish() if it has not been called; errors are swallowed.
+  ~RollupWriter();
+
+  RollupWriter(const RollupWriter&) = delete;
+  RollupWriter& operator=(const RollupWriter&) = delete;
+
+  /// Folds a raw sample into its bucket. Returns false, and adds nothing,
+  /// for a node below the current one or a sample older than the node's
+  /// previous input.
+  bool append(NodeId node, const SensorSample& sample);
+
+  /// Closes the open bucket, writes the index and the header's time range,
+  /// and closes the file. Throws std::system_error on I/O failure.
+  void finish();
+
+  Timestamp resolution() const noexcept { return resolution_; }
+  std::uint64_t buckets_written() const noexcept { return buckets_; }
+  std::uint64_t bytes_written() const noexcept { return offset_ + pending_.size(); }
+
+ private:
+  void close_bucket();
+  void flush();
+
+  int fd_ = -1;
+  Timestamp resolution_;
+  std::vector<rollup::NodeEntry> index_;
+  std::vector<std::uint8_t> pending_;  // buffered writes
+  RollupAccumulator open_;
+  Timestamp newest_ = std::numeric_limits<Timestamp>::min();
+  Timestamp from_ = std::numeric_limits<Timestamp>::max();
+  Timestamp to_ = std::numeric_limits<Timestamp>::min();
+  std::uint64_t offset_ = 0;
+  std::uint64_t buckets_ = 0;
+};
+
+/// Read-only view of a rollup file through `mmap`; buckets are returned in
+/// place. Concurrent reads are safe.
+class RollupReader {
+ public:
+  /// Throws std::system_error if the file cannot be mapped and
+  /// std::runtime_error if it is not a valid rollup file.
+  explicit RollupReader(const std::string& path);
+  ~RollupReader();
+
+  RollupReader(const RollupReader&) = delete;
+  RollupReader& operator=(const RollupReader&) = delete;
+
+  Timestamp resolution() const noexcept { return header().resolution; }
+  /// Time range of the history summarized, inclusive.
+  Timestamp from() const noexcept { return header().from; }
+  Timestamp to() const noexcept { return header().to; }
+  std::size_t file_bytes() const noexcept { return size_; }
+
+  std::span<const rollup::NodeEntry> nodes() const noexcept { return index_; }
+
+  /// `node`'s buckets overlapping [from, to], oldest first.
+  std::span<const rollup::Bucket> buckets(
+      NodeId node, Timestamp from = std::numeric_limits<Timestamp>::min(),
+      Timestamp to = std::numeric_limits<Timestamp>::max()) const noexcept;
+
+ private:
+  const rollup::FileHeader& header() const noexcept {
+    return *static_cast<const rollup::FileHeader*>(base_);
+  }
+  const std::uint8_t* bytes() const noexcept {
+    return static_cast<const std::uint8_t*>(base_);
+  }
+
+  void* base_ = nullptr;
+  std::size_t size_ = 0;
+  std::span<const rollup::NodeEntry> index_;
+  const rollup::Bucket* buckets_ = nullptr;
+  std::uint64_t bucket_count_ = 0;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+
+/// On-disk layout of a sensor history segment file.
+///
+/// `FileHeader`, then the compressed blocks back to back (each 8-byte
+/// aligned), then the index (`block_count` `BlockEntry`s sorted by node and
+/// time), then the `Trailer`. All integers are little-endian and every
+/// struct is read in place from the mapping.
+///
+/// A block holds up to `block_samples` consecutive samples of one node as
+/// independent bit streams, one per column: timestamps as delta-of-delta,
+/// each channel as Gorilla XOR of successive float bit patterns. Since the
+/// index records where every column starts, a scan decodes only the
+/// channels it asks for, and skips blocks whose time range or per-channel
+/// min/max cannot match without touching their payload.
+namespace segment {
+
+inline constexpr std::uint64_t kMagic = 0x0031474553514d;  // "MQSEG1"
+inline constexpr std::uint32_t kVersion = 1;
+inline constexpr std::size_t kColumnCount = kChannelCount + 1;
+
+struct FileHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t channel_count;
+  std::uint32_t block_samples;
+  std::uint32_t reserved;
+};
+
+struct BlockEntry {
+  std::uint64_t offset;  ///< of the block payload, from the start of the file
+  std::uint32_t bytes;   ///< payload size
+  std::uint32_t node;
+  std::uint32_t count;   ///< samples in the block
+  /// Payload-relative start of each column stream: timestamps, then one per
+  /// channel in `Channel` order.
+  std::array<std::uint32_t, kColumnCount> column_offset;
+  std::int64_t t_min;
+  std::int64_t t_max;
+  /// Range of the block's finite readings per channel; NaN for a channel
+  /// without any.
+  std::array<float, kChannelCount> min;
+  std::array<float, kChannelCount> max;
+};
+
+struct Trailer {
+  std::uint64_t index_offset;
+  std::uint64_t block_count;
+  std::uint64_t magic;
+};
+
+static_assert(sizeof(FileHeader) == 24);
+static_assert(sizeof(BlockEntry) % 8 == 0);
+static_assert(sizeof(Trailer) == 24);
+
+}  // namespace segment
+
+/// Writes a segment file. Samples are buffered per node and compressed one
+/// block at a time; `finish()` writes the index. Not thread-safe.
+class SegmentWriter {
+ public:
+  static constexpr std::uint32_t kDefaultBlockSamples = 1024;
+
+  /// Creates (or truncates) `path`. Throws std::system_error on failure.
+  explicit SegmentWriter(const std::string& path,
+                         std::uint32_t block_samples = kDefaultBlockSamples);
+
+  /// Calls finish() if it has not been called; errors are swallowed.
+  ~SegmentWriter();
+
+  SegmentWriter(const SegmentWriter&) = delete;
+  SegmentWriter& operator=(const SegmentWriter&) = delete;
+
+  /// Returns false, and writes nothing, if `sample` is older than the
+  /// node's previous sample.
+  bool append(NodeId node, const SensorSample& sample);
+
+  /// Appends every sample of a window. Returns the number accepted.
+  std::size_t append(NodeId node, const WindowView& window);
+
+  /// Flushes partial blocks, writes the index and closes the file. Throws
+  /// std::system_error on I/O failure.
+  void finish();
+
+  std::uint64_t samples_written() const noexcept { return samples_; }
+  std::uint64_t bytes_written() const noexcept { return offset_; }
+
+ private:
+  struct NodeBuffer {
+    std::vector<Timestamp> timestamps;
+    std::array<std::vector<float>, kChannelCount> channels;
+    Timestamp newest = std::numeric_limits<Timestamp>::min();
+  };
+
+  void flush_block(NodeId node, NodeBuffer& buf);
+  void write_bytes(const void* data, std::size_t n);
+
+  int fd_ = -1;
+  std::uint32_t block_samples_;
+  std::unordered_map<NodeId, NodeBuffer> nodes_;  // cluster-wide ids are sparse
+  std::vector<segment::BlockEntry> index_;
+  std::vector<std::uint8_t> scratch_;
+  std::uint64_t offset_ = 0;
+  std::uint64_t samples_ = 0;
+};
+
+/// Block-level filter on one channel: blocks whose [min, max] does not
+/// overlap [lo, hi] are skipped. Samples inside kept blocks are not
+/// filtered individually.
+struct ValueRange {
+  Channel channel;
+  float lo = -std::numeric_limits<float>::infinity();
+  float hi = std::numeric_limits<float>::infinity();
+};
+
+struct SegmentQuery {
+  NodeId node = 0;
+  Timestamp from = std::numeric_limits<Timestamp>::min();
+  Timestamp to = std::numeric_limits<Timestamp>::max();  ///< inclusive
+  ChannelMask channels = kAllChannels;  ///< columns to decode
+  std::optional<ValueRange> range;
+};
+
+/// One decoded block, trimmed to the query's time range. Channels not in
+/// the query's mask are empty spans.
+struct DecodedBlock {
+  const segment::BlockEntry* entry = nullptr;
+  std::span<const Timestamp> timestamps;
+  std::array<std::span<const float>, kChannelCount> channels;
+
+  std::size_t size() const noexcept { return timestamps.size(); }
+};
+
+struct ScanStats {
+  std::size_t blocks_considered = 0;  ///< node's blocks overlapping the time range
+  std::size_t blocks_skipped = 0;     ///< of those, rejected by the value range
+  std::size_t samples = 0;            ///< samples handed to the visitor
+};
+
+/// Read-only view of a segment file through `mmap`. The header and index
+/// are used in place; only the blocks a scan selects are decoded.
+/// Concurrent scans on one reader are safe.
+class SegmentReader {
+ public:
+  /// Throws std::system_error if the file cannot be mapped and
+  /// std::runtime_error if it is not a valid segment.
+  explicit SegmentReader(const std::string& path);
+  ~SegmentReader();
+
+  SegmentReader(const SegmentReader&) = delete;
+  SegmentReader& operator=(const SegmentReader&) = delete;
+
+  std::uint32_t block_samples() const noexcept { return header().block_samples; }
+  std::size_t file_bytes() const noexcept { return size_; }
+
+  /// The whole index, sorted by node, then time.
+  std::span<const segment::BlockEntry> blocks() const noexcept { return index_; }
+
+  /// Index entries of `node`'s blocks overlapping [from, to].
+  std::span<const segment::BlockEntry> blocks(NodeId node, Timestamp from,
+                                              Timestamp to) const noexcept;
+
+  /// Decodes the timestamps and the `channels` columns of `entry` into
+  /// arrays of at least `entry.count` elements. Entries of other columns
+  /// may be null.
+  void decode(const segment::BlockEntry& entry, Timestamp* timestamps,
+              const std::array<float*, kChannelCount>& columns,
+              ChannelMask channels = kAllChannels) const noexcept;
+
+  /// Calls `visit(const DecodedBlock&)` for every block matching `query`,
+  /// oldest first. The spans are valid only during the call.
+  template <typename Visitor>
+  ScanStats scan(const SegmentQuery& query, Visitor&& visit) const;
+
+  /// Appends the matching samples to `store` (every channel is decoded).
+  /// Returns the number stored.
+  std::size_t replay(const SegmentQuery& query, SampleStore& store) const;
+
+ private:
+  const segment::FileHeader& header() const noexcept {
+    return *static_cast<const segment::FileHeader*>(base_);
+  }
+  const std::uint8_t* bytes() const noexcept {
+    return static_cast<const std::uint8_t*>(base_);
+  }
+
+  void* base_ = nullptr;
+  std::size_t size_ = 0;
+  std::span<const segment::BlockEntry> index_;
+};
+
+template <typename Visitor>
+ScanStats SegmentReader::scan(const SegmentQuery& query, Visitor&& visit) const {
+  ScanStats stats;
+  const std::size_t n = block_samples();
+  AlignedBuffer<Timestamp> ts(n);
+  std::array<AlignedBuffer<float>, kChannelCount> cols;
+  std::array<float*, kChannelCount> out{};
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(query.channels, static_cast<Channel>(c))) continue;
+    cols[c] = AlignedBuffer<float>(n);
+    out[c] = cols[c].data();
+  }
+  for (const segment::BlockEntry& e : blocks(query.node, query.from, query.to)) {
+    ++stats.blocks_considered;
+    if (query.range) {
+      const std::size_t c = index_of(query.range->channel);
+      if (e.max[c] < query.range->lo || e.min[c] > query.range->hi) {
+        ++stats.blocks_skipped;
+        continue;
+      }
+    }
+    decode(e, ts.data(), out, query.channels);
+    const Timestamp* first = ts.data();
+    const Timestamp* last = ts.data() + e.count;
+    const Timestamp* begin =
+        e.t_min >= query.from ? first : std::lower_bound(first, last, query.from);
+    const Timestamp* end =
+        e.t_max <= query.to ? last : std::upper_bound(begin, last, query.to);
+    if (begin == end) continue;
+    const auto off = static_cast<std::size_t>(begin - first);
+    const auto len = static_cast<std::size_t>(end - begin);
+    DecodedBlock block;
+    block.entry = &e;
+    block.timestamps = {begin, len};
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      if (out[c] != nullptr) block.channels[c] = {out[c] + off, len};
+    }
+    stats.samples += len;
+    visit(static_cast<const DecodedBlock&>(block));
+  }
+  return stats;
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "meat_quality/core/calibration.hpp"
+#include "meat_quality/image/color_lab.hpp"
+#include "meat_quality/inference/freshness_classifier.hpp"
+
+namespace meat_quality {
+
+/// On-disk layout of a startup snapshot: everything a grading process
+/// would otherwise build or parse before serving, stored the way it is
+/// used in memory.
+///
+/// `FileHeader`, then `section_count` `Section` entries, then the section
+/// payloads, each starting on a cache line. Payloads are plain
+/// little-endian float arrays (and `NodeCalibration` records), so a loaded
+/// snapshot points into the mapping instead of copying out of it, and
+/// processes mapping the same file share its page-cache pages.
+///
+/// A classifier section holds `input_mean`, `input_scale`, `w1`, `b1`,
+/// `w2` and `b2` in that order, each cache-line aligned; `param` is the
+/// hidden width. A LUT section holds the `LabConverter` grid; `param` is
+/// the points per axis. A calibration section holds one `NodeCalibration`
+/// per node; `count` is the node count.
+namespace snapshot {
+
+inline constexpr std::uint64_t kMagic = 0x003150414e53514d;  // "MQSNAP1"
+inline constexpr std::uint32_t kVersion = 1;
+
+enum class SectionKind : std::uint32_t {
+  kClassifier = 1,
+  kLabLut = 2,
+  kCalibration = 3,
+};
+
+struct FileHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t channel_count;
+  std::uint32_t feature_dim;
+  std::uint32_t section_count;
+  std::uint64_t file_bytes;  ///< catches truncated copies
+};
+
+struct Section {
+  SectionKind kind;
+  std::uint32_t param;
+  std::uint64_t offset;  ///< of the payload, from the start of the file
+  std::uint64_t bytes;
+  std::uint64_t count;
+};
+
+static_assert(sizeof(FileHeader) == 32);
+static_assert(sizeof(Section) == 32);
+
+}  // namespace snapshot
+
+/// What to put into a snapshot; null or empty parts are left out.
+struct SnapshotContents {
+  const FreshnessClassifier* classifier = nullptr;
+  const LabConverter* lab = nullptr;  ///< must be a `kLut` converter
+  std::span<const NodeCalibration> calibration;
+};
+
+/// Writes a snapshot next to `path` and renames it into place, so running
+/// processes that mapped the previous file keep their view of it. Throws
+/// std::invalid_argument for a non-LUT converter and std::system_error on
+/// I/O failure.
+void write_snapshot(const std::string& path, const SnapshotContents& contents);
+
+/// Read-only mapping of a snapshot file. Loading validates the header and
+/// section table only; payload pages are faulted in (or found already
+/// resident from another process) on first use. Objects handed out borrow
+/// the mapping and must not outlive the snapshot.
+class Snapshot {
+ public:
+  /// Throws std::system_error if the file cannot be mapped and
+  /// std::runtime_error if it is not a valid snapshot.
+  explicit Snapshot(const std::string& path);
+  ~Snapshot();
+
+  Snapshot(const Snapshot&) = delete;
+  Snapshot& operator=(const Snapshot&) = delete;
+
+  std::size_t file_bytes() const noexcept { return size_; }
+
+  std::optional<ClassifierView> classifier_view() const noexcept;
+
+  /// Classifier over the mapped weights. Throws std::runtime_error if the
+  /// snapshot has none.
+  FreshnessClassifier classifier() const;
+
+  /// `kLut` converter over the mapped grid. Throws std::runtime_error if
+  /// the snapshot has none.
+  LabConverter lab_converter() const;
+
+  /// Per-node calibration, indexed by node id; empty if absent.
+  std::span<const NodeCalibration> calibration() const noexcept { return calibration_; }
+
+  /// Asks the kernel to read the whole file ahead, e.g. right after start
+  /// so the first grades do not wait on page faults.
+  void prefetch() const noexcept;
+
+ private:
+  const snapshot::Section* find(snapshot::SectionKind kind) const noexcept;
+
+  void* base_ = nullptr;
+  std::size_t size_ = 0;
+  std::span<const snapshot::Section> sections_;
+  std::span<const NodeCalibration> calibration_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/storage/rollup.hpp"
+#include "meat_quality/storage/segment.hpp"
+
+namespace meat_quality {
+
+inline constexpr Timestamp kMinuteMicros = Timestamp{60} * 1'000'000;
+inline constexpr Timestamp kHourMicros = 60 * kMinuteMicros;
+inline constexpr Timestamp kDayMicros = 24 * kHourMicros;
+
+struct RollupTier {
+  Timestamp resolution = kHourMicros;
+  /// Where the tier's files live, e.g. a cheaper volume. Created if missing.
+  std::string directory;
+  /// Files whose history ended longer ago than this are deleted.
+  Timestamp retention = std::numeric_limits<Timestamp>::max();
+};
+
+struct TieredHistoryOptions {
+  /// Full-resolution segments (`*.mqseg`), the hot tier.
+  std::string raw_directory;
+  /// Raw segments whose history ended longer ago than this are rolled up
+  /// into every tier and deleted.
+  Timestamp raw_retention = 7 * kDayMicros;
+  /// Finest first, each resolution a multiple of the previous one. Empty
+  /// means default_tiers(raw_directory).
+  std::vector<RollupTier> tiers;
+  /// Period of the background compaction pass; see start().
+  std::chrono::milliseconds compact_interval{60'000};
+
+  /// 1 minute for 90 days, 15 minutes for two years and 1 hour forever, in
+  /// subdirectories of `root`.
+  static std::vector<RollupTier> default_tiers(const std::string& root);
+};
+
+struct HistoryQuery {
+  NodeId node = 0;
+  Timestamp from = std::numeric_limits<Timestamp>::min();
+  Timestamp to = std::numeric_limits<Timestamp>::max();  ///< inclusive
+  /// Bucket length of the result.
+  Timestamp resolution = kHourMicros;
+};
+
+struct HistoryStats {
+  /// Rollup tier read, or -1 if none has a resolution dividing the query's.
+  int tier = -1;
+  std::size_t rollup_buckets = 0;  ///< tier buckets folded into the result
+  std::size_t raw_samples = 0;     ///< raw samples folded into the result
+};
+
+struct CompactionStats {
+  std::uint64_t passes = 0;
+  std::uint64_t segments_compacted = 0;  ///< raw segments rolled up and deleted
+  std::uint64_t rollups_written = 0;
+  std::uint64_t rollups_expired = 0;     ///< deleted past their tier's retention
+  std::uint64_t raw_bytes_removed = 0;
+  std::uint64_t rollup_bytes_written = 0;
+  std::uint64_t errors = 0;              ///< background passes that threw
+};
+
+/// Sensor history kept at decreasing resolution as it ages. Recent data
+/// stays in raw segments, read through `mmap`. Once a segment is older than
+/// the raw retention, a compaction pass streams it once into one rollup
+/// file per tier (min, max and mean per bucket, `storage/rollup.hpp`) and
+/// deletes it; each tier later drops its files past its own retention.
+///
+/// A query asks for buckets of some resolution and is answered from the
+/// coarsest tier whose resolution divides it, plus any raw segments in the
+/// range rolled up on the fly, so an audit over months of hourly data reads
+/// a few hundred fixed-size buckets instead of decoding millions of
+/// samples. A raw segment is swapped for its rollups atomically, so every
+/// interval is counted once.
+///
+/// Queries, add_segment() and compaction may run concurrently; a query
+/// holds the files it reads open, so deleting them does not disturb it.
+class TieredHistory {
+ public:
+  /// Creates the directories and opens the files already in them, finishing
+  /// an interrupted compaction. Throws std::invalid_argument for a bad tier
+  /// list, std::system_error on I/O failure and std::runtime_error for a
+  /// corrupt file.
+  explicit TieredHistory(TieredHistoryOptions options);
+
+  /// Calls stop().
+  ~TieredHistory();
+
+  TieredHistory(const TieredHistory&) = delete;
+  TieredHistory& operator=(const TieredHistory&) = delete;
+
+  /// Registers a finished segment in the raw directory. Its file name must
+  /// be unique, since the rollups are named after it.
+  void add_segment(const std::string& path);
+
+  /// One compaction pass as of `now`: rolls up and deletes raw segments past
+  /// the raw retention, then expires rollup files. Returns what it did.
+  CompactionStats compact(Timestamp now);
+
+  /// Starts a background thread running compact() with the wall clock
+  /// every `compact_interval`.
+  void start();
+  void stop();
+
+  /// Appends `q.node`'s buckets of `q.resolution` overlapping [from, to] to
+  /// `out`, oldest first. Throws std::invalid_argument for a non-positive
+  /// resolution.
+  HistoryStats query(const HistoryQuery& q, std::vector<rollup::Bucket>& out) const;
+
+  std::size_t raw_segments() const;
+  /// Files in tier `k`.
+  std::size_t rollup_files(std::size_t k) const;
+  const std::vector<RollupTier>& tiers() const noexcept { return options_.tiers; }
+
+  /// Cumulative over every pass, including background ones.
+  CompactionStats stats() const;
+
+ private:
+  struct RawFile {
+    std::string path;
+    Timestamp from = 0;
+    Timestamp to = 0;
+    std::shared_ptr<const SegmentReader> reader;
+  };
+  struct RollupFile {
+    std::string path;
+    std::shared_ptr<const RollupReader> reader;
+  };
+
+  RawFile open_raw(const std::string& path) const;
+  std::string rollup_path(std::size_t tier, const std::string& raw_path) const;
+  void roll_up(const RawFile& raw, CompactionStats& stats);
+  void run();
+
+  TieredHistoryOptions options_;
+  mutable std::mutex mutex_;  // guards the catalog and stats
+  std::vector<RawFile> raw_;  // sorted by `from`
+  std::vector<std::vector<RollupFile>> rollups_;  // per tier, sorted by from()
+  CompactionStats stats_;
+
+  std::mutex compact_mutex_;  // one pass at a time
+  std::thread thread_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+}  // namespace meat_quality
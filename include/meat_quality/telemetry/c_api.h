@@ -0,0 +1,50 @@
+/* C interface to the process-wide telemetry, for embedding the library in
+ * gateways written in other languages. Mirrors meat_quality/telemetry/
+ * telemetry.hpp; stage and counter numbers are the C++ enum values. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+  MQ_STAGE_INGEST = 0,
+  MQ_STAGE_FEATURES = 1,
+  MQ_STAGE_INFERENCE = 2,
+  MQ_STAGE_COLOR = 3,
+  MQ_STAGE_POSTPROCESS = 4,
+  MQ_STAGE_ALERT_LANE = 5,
+  MQ_STAGE_ALERT = 6,
+};
+
+enum {
+  MQ_COUNTER_SAMPLES_INGESTED = 0,
+  MQ_COUNTER_SAMPLES_REJECTED = 1,
+  MQ_COUNTER_GRADES = 2,
+  MQ_COUNTER_BATCHES = 3,
+  MQ_COUNTER_HEAP_ALLOCATIONS = 4,
+  MQ_COUNTER_ALERTS = 5,
+};
+
+/* Writes the Prometheus text exposition into `buf` (NUL-terminated,
+ * truncated to `size`) and returns its full length without the NUL, so a
+ * call with size 0 sizes the buffer. */
+size_t mq_telemetry_prometheus(char* buf, size_t size);
+
+/* Latency of `stage` at quantile `q` in [0, 1], in seconds; 0 for an
+ * unknown stage or no samples. */
+double mq_telemetry_stage_quantile(int stage, double q);
+
+/* Number of latencies recorded for `stage`. */
+uint64_t mq_telemetry_stage_count(int stage);
+
+uint64_t mq_telemetry_counter(int counter);
+
+void mq_telemetry_set_enabled(int on);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace meat_quality::telemetry {
+
+/// Log-linear bucketing in the style of HdrHistogram: every power of two is
+/// split into 2^kSubBucketBits equal buckets, so any recorded value is known
+/// to within 1/32 (about 3%) from 1 up to 2^kMaxExponent (about 18 minutes
+/// in nanoseconds). Larger values land in the last bucket.
+inline constexpr unsigned kSubBucketBits = 5;
+inline constexpr unsigned kSubBuckets = 1u << kSubBucketBits;
+inline constexpr unsigned kMaxExponent = 40;
+inline constexpr std::size_t kBucketCount =
+    std::size_t{kMaxExponent - kSubBucketBits + 2} * kSubBuckets;
+
+constexpr std::size_t bucket_of(std::uint64_t v) noexcept {
+  if (v < kSubBuckets) return static_cast<std::size_t>(v);
+  const unsigned e = static_cast<unsigned>(std::bit_width(v)) - 1;  // >= kSubBucketBits
+  if (e > kMaxExponent) return kBucketCount - 1;
+  const unsigned shift = e - kSubBucketBits;
+  return std::size_t{shift + 1} * kSubBuckets + ((v >> shift) & (kSubBuckets - 1));
+}
+
+/// Smallest value that maps to bucket `b`.
+constexpr std::uint64_t bucket_lower(std::size_t b) noexcept {
+  if (b < kSubBuckets) return b;
+  const unsigned shift = static_cast<unsigned>(b / kSubBuckets) - 1;
+  return (std::uint64_t{kSubBuckets} + (b % kSubBuckets)) << shift;
+}
+
+/// Width of bucket `b` (1 for the exact low buckets).
+constexpr std::uint64_t bucket_width(std::size_t b) noexcept {
+  return b < kSubBuckets ? 1 : std::uint64_t{1} << (b / kSubBuckets - 1);
+}
+
+/// Plain copy of one or more merged histograms.
+struct HistogramSnapshot {
+  std::vector<std::uint64_t> counts = std::vector<std::uint64_t>(kBucketCount);
+  std::uint64_t count = 0;
+  std::uint64_t sum = 0;
+  std::uint64_t max = 0;
+
+  double mean() const noexcept {
+    return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+  }
+
+  /// Value at quantile `q` in [0, 1]: the midpoint of the bucket holding
+  /// it, clamped to the recorded maximum. 0 when empty.
+  std::uint64_t quantile(double q) const noexcept;
+
+  void merge(const HistogramSnapshot& other) noexcept;
+};
+
+/// Single-writer histogram; any thread may read it while it is written.
+/// `record()` is a handful of relaxed loads and stores with no
+/// read-modify-write, so the owning thread never stalls on other cores.
+class Histogram {
+ public:
+  void record(std::uint64_t v) noexcept {
+    bump(counts_[bucket_of(v)], 1);
+    bump(count_, 1);
+    bump(sum_, v);
+    if (v > max_.load(std::memory_order_relaxed)) max_.store(v, std::memory_order_relaxed);
+  }
+
+  /// Adds this histogram's current contents to `out`.
+  void add_to(HistogramSnapshot& out) const noexcept;
+
+ private:
+  static void bump(std::atomic<std::uint64_t>& a, std::uint64_t n) noexcept {
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<std::uint64_t>, kBucketCount> counts_{};
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::uint64_t> sum_{0};
+  std::atomic<std::uint64_t> max_{0};
+};
+
+}  // namespace meat_quality::telemetry
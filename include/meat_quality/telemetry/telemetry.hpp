@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "meat_quality/telemetry/histogram.hpp"
+
+/// Always-on, low-overhead instrumentation of the grading path.
+///
+/// Every thread that records gets its own block of histograms and counters,
+/// which only that thread writes. `snapshot()` walks the blocks with relaxed
+/// loads and merges them, so neither side takes a lock and recording never
+/// contends across cores. Blocks of exited threads keep their totals and are
+/// handed to the next new thread.
+namespace meat_quality::telemetry {
+
+/// Pipeline stages with a latency histogram (nanoseconds).
+enum class Stage : std::uint8_t {
+  kIngest,       ///< one drain_batch() from queue into the sample store
+  kFeatures,     ///< window features of one grade_batch() call
+  kInference,    ///< one classifier forward pass over a batch
+  kColor,        ///< color statistics of one request's image crops
+  kPostprocess,  ///< copying a batch's model outputs into its results
+  kAlertLane,    ///< arrival to evaluation of one sample on the alert lane
+  kAlert,        ///< arrival to delivery of one spoilage alert
+};
+inline constexpr std::size_t kStageCount = 7;
+
+/// Non-latency distributions.
+enum class Distribution : std::uint8_t {
+  kBatchSize,   ///< requests per classifier pass
+  kQueueDepth,  ///< ingest queue depth seen by each drain
+};
+inline constexpr std::size_t kDistributionCount = 2;
+
+enum class Counter : std::uint8_t {
+  kSamplesIngested,  ///< samples appended to a store by drain_batch()
+  kSamplesRejected,  ///< out of order or for an unknown node
+  kGrades,           ///< grading results produced
+  kBatches,          ///< classifier passes
+  kHeapAllocations,  ///< operator new calls inside grading (needs counting_new)
+  kAlerts,           ///< spoilage alerts raised by the alert lane
+};
+inline constexpr std::size_t kCounterCount = 6;
+
+constexpr const char* stage_name(Stage s) noexcept {
+  switch (s) {
+    case Stage::kIngest: return "ingest";
+    case Stage::kFeatures: return "features";
+    case Stage::kInference: return "inference";
+    case Stage::kColor: return "color";
+    case Stage::kPostprocess: return "postprocess";
+    case Stage::kAlertLane: return "alert_lane";
+    case Stage::kAlert: return "alert";
+  }
+  return "?";
+}
+
+constexpr const char* distribution_name(Distribution d) noexcept {
+  switch (d) {
+    case Distribution::kBatchSize: return "batch_size";
+    case Distribution::kQueueDepth: return "queue_depth";
+  }
+  return "?";
+}
+
+constexpr const char* counter_name(Counter c) noexcept {
+  switch (c) {
+    case Counter::kSamplesIngested: return "samples_ingested";
+    case Counter::kSamplesRejected: return "samples_rejected";
+    case Counter::kGrades: return "grades";
+    case Counter::kBatches: return "batches";
+    case Counter::kHeapAllocations: return "heap_allocations";
+    case Counter::kAlerts: return "alerts";
+  }
+  return "?";
+}
+
+/// Global switch, on by default. Disabled recording returns immediately.
+void set_enabled(bool on) noexcept;
+bool enabled() noexcept;
+
+void record(Stage stage, std::uint64_t nanoseconds) noexcept;
+void observe(Distribution d, std::uint64_t value) noexcept;
+void add(Counter c, std::uint64_t n = 1) noexcept;
+
+inline std::uint64_t now_ns() noexcept {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+}
+
+/// Records the lifetime of the scope into a stage histogram.
+class StageTimer {
+ public:
+  explicit StageTimer(Stage stage) noexcept : stage_(stage), start_(now_ns()) {}
+  ~StageTimer() { record(stage_, now_ns() - start_); }
+
+  StageTimer(const StageTimer&) = delete;
+  StageTimer& operator=(const StageTimer&) = delete;
+
+ private:
+  Stage stage_;
+  std::uint64_t start_;
+};
+
+/// Process-wide totals since start.
+struct Snapshot {
+  std::array<HistogramSnapshot, kStageCount> stages;
+  std::array<HistogramSnapshot, kDistributionCount> distributions;
+  std::array<std::uint64_t, kCounterCount> counters{};
+  std::size_t threads = 0;  ///< per-thread blocks merged
+
+  const HistogramSnapshot& operator[](Stage s) const noexcept {
+    return stages[static_cast<std::size_t>(s)];
+  }
+  const HistogramSnapshot& operator[](Distribution d) const noexcept {
+    return distributions[static_cast<std::size_t>(d)];
+  }
+  std::uint64_t operator[](Counter c) const noexcept {
+    return counters[static_cast<std::size_t>(c)];
+  }
+};
+
+Snapshot snapshot();
+
+/// Prometheus text exposition format (version 0.0.4): stage latencies as
+/// summaries in seconds, distributions as summaries, counters as `_total`.
+std::string prometheus_text(const Snapshot& s);
+inline std::string prometheus_text() { return prometheus_text(snapshot()); }
+
+}  // namespace meat_quality::telemetry
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace meat_quality {
+
+inline constexpr std::size_t kCacheLineSize = 64;
+
+/// Fixed-size, cache-line aligned array of trivially copyable elements.
+/// Zero-initialized on construction; never reallocates.
+template <typename T, std::size_t Alignment = kCacheLineSize>
+class AlignedBuffer {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0);
+
+ public:
+  AlignedBuffer() = default;
+
+  explicit AlignedBuffer(std::size_t size) : size_(size) {
+    if (size_ == 0) return;
+    data_ = static_cast<T*>(
+        ::operator new(size_ * sizeof(T), std::align_val_t{Alignment}));
+    std::memset(static_cast<void*>(data_), 0, size_ * sizeof(T));
+  }
+
+  AlignedBuffer(AlignedBuffer&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+    if (this != &other) {
+      release();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+  ~AlignedBuffer() { release(); }
+
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  T& operator[](std::size_t i) noexcept { return data_[i]; }
+  const T& operator[](std::size_t i) const noexcept { return data_[i]; }
+
+ private:
+  void release() noexcept {
+    if (data_ != nullptr) {
+      ::operator delete(data_, std::align_val_t{Alignment});
+      data_ = nullptr;
+    }
+  }
+
+  T* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace meat_quality {
+
+/// Heap allocations (`operator new` calls) made so far by the calling
+/// thread. Counting is opt-in: it only happens in programs that link the
+/// `meat_quality::counting_new` target, which replaces the global
+/// allocation operators. Benchmarks use it to prove a hot path is
+/// allocation-free.
+std::uint64_t thread_heap_allocations() noexcept;
+
+/// True if `meat_quality::counting_new` is linked in.
+bool heap_allocation_counting_enabled() noexcept;
+
+namespace detail {
+void count_heap_allocation() noexcept;
+void enable_heap_allocation_counting() noexcept;
+}  // namespace detail
+
+}  // namespace meat_quality
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace meat_quality {
+
+/// Bump allocator for per-request scratch memory. Allocation is a pointer
+/// bump; nothing is freed individually. `reset()` rewinds to the first block
+/// in O(1) and keeps every block for reuse, so once an arena has grown to a
+/// request's peak it never touches the heap again.
+class Arena {
+ public:
+  static constexpr std::size_t kDefaultBlockSize = 256 * 1024;
+
+  explicit Arena(std::size_t block_size = kDefaultBlockSize) noexcept
+      : block_size_(block_size) {}
+  ~Arena();
+
+  Arena(Arena&& other) noexcept;
+  Arena& operator=(Arena&& other) noexcept;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /// Uninitialized storage. `alignment` must be a power of two.
+  void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+    if (cursor_ != nullptr) {
+      std::byte* p = align_up(cursor_, alignment);
+      if (p <= end_ && bytes <= static_cast<std::size_t>(end_ - p)) {
+        cursor_ = p + bytes;
+        return p;
+      }
+    }
+    return allocate_slow(bytes, alignment);
+  }
+
+  /// `n` default-initialized elements (left uninitialized for trivial `T`).
+  /// Destructors never run, so `T` must be trivially destructible.
+  template <typename T>
+  std::span<T> allocate_span(std::size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    T* p = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    std::uninitialized_default_construct_n(p, n);
+    return {p, n};
+  }
+
+  /// Like `allocate_span` but value-initialized (zeroed for arithmetic `T`).
+  template <typename T>
+  std::span<T> allocate_zeroed(std::size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    T* p = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    std::uninitialized_value_construct_n(p, n);
+    return {p, n};
+  }
+
+  /// Rewinds to the first block. Every pointer handed out becomes invalid.
+  void reset() noexcept;
+
+  /// Bytes handed out since the last reset (including alignment padding).
+  std::size_t used() const noexcept;
+  /// Bytes of blocks owned.
+  std::size_t reserved() const noexcept { return reserved_; }
+  std::size_t block_count() const noexcept { return blocks_; }
+
+  /// Blocks obtained from the heap by every arena in the process. Flat in
+  /// steady state; a rising count means some request outgrew its arena.
+  static std::uint64_t heap_blocks_allocated() noexcept;
+
+ private:
+  struct Block {
+    Block* next;
+    std::size_t size;  // usable bytes after the header
+    std::byte* data() noexcept { return reinterpret_cast<std::byte*>(this + 1); }
+  };
+
+  static std::byte* align_up(std::byte* p, std::size_t alignment) noexcept {
+    const auto v = reinterpret_cast<std::uintptr_t>(p);
+    return reinterpret_cast<std::byte*>((v + alignment - 1) & ~(alignment - 1));
+  }
+
+  void* allocate_slow(std::size_t bytes, std::size_t alignment);
+  void enter(Block* block) noexcept;
+  void release() noexcept;
+
+  std::size_t block_size_;
+  Block* head_ = nullptr;
+  Block* current_ = nullptr;
+  std::byte* cursor_ = nullptr;
+  std::byte* end_ = nullptr;
+  std::size_t used_before_current_ = 0;  // bytes used in blocks before current_
+  std::size_t reserved_ = 0;
+  std::size_t blocks_ = 0;
+};
+
+/// Standard allocator over an `Arena`, for containers that live within one
+/// request. `deallocate` is a no-op; memory returns on `Arena::reset()`.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, std::size_t) noexcept {}
+
+  Arena* arena() const noexcept { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const noexcept {
+    return arena_ == other.arena();
+  }
+
+ private:
+  Arena* arena_;
+};
+
+/// Borrows an arena from the calling thread's pool for one request and
+/// resets it on destruction. Nested scopes on one thread get distinct
+/// arenas. After warm-up, borrowing and returning never allocate.
+class ScopedArena {
+ public:
+  ScopedArena();
+  ~ScopedArena();
+
+  ScopedArena(const ScopedArena&) = delete;
+  ScopedArena& operator=(const ScopedArena&) = delete;
+
+  Arena& operator*() const noexcept { return *arena_; }
+  Arena* operator->() const noexcept { return arena_; }
+  Arena& get() const noexcept { return *arena_; }
+
+ private:
+  Arena* arena_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+
+/// What a producer does when the queue is full.
+enum class Backpressure : std::uint8_t {
+  kBlock,       ///< wait until the consumer frees a slot (or the queue closes)
+  kDropOldest,  ///< discard the oldest queued element to make room
+  kReject,      ///< fail the push immediately
+};
+
+constexpr const char* backpressure_name(Backpressure p) noexcept {
+  switch (p) {
+    case Backpressure::kBlock: return "block";
+    case Backpressure::kDropOldest: return "drop_oldest";
+    case Backpressure::kReject: return "reject";
+  }
+  return "?";
+}
+
+struct MpscQueueStats {
+  std::uint64_t pushed = 0;          ///< elements accepted by push()
+  std::uint64_t popped = 0;          ///< elements handed to the consumer
+  std::uint64_t dropped = 0;         ///< elements discarded by kDropOldest
+  std::uint64_t rejected = 0;        ///< pushes refused (kReject or closed)
+  std::uint64_t producer_waits = 0;  ///< pushes that found the queue full
+};
+
+/// Bounded lock-free multi-producer/single-consumer queue.
+///
+/// Each slot carries a sequence number (Vyukov's bounded queue): a producer
+/// claims a position with one CAS on the tail and publishes by bumping the
+/// slot's sequence, so producers never serialize on a lock and a slow
+/// producer only delays the slot it claimed. The consumer claims a whole
+/// run of ready slots with one CAS on the head, which is what makes
+/// `pop_batch()` cheap. The head is a CAS rather than a plain store only
+/// because kDropOldest producers also advance it to evict.
+///
+/// Blocking is confined to the slow paths: full-queue producers under
+/// kBlock park on an atomic epoch, and a consumer waiting for data parks on
+/// a condition variable that producers touch only while it is asleep.
+template <typename T>
+class MpscQueue {
+  static_assert(std::is_nothrow_default_constructible_v<T>);
+  static_assert(std::is_nothrow_move_assignable_v<T>);
+
+ public:
+  /// `capacity` is rounded up to the next power of two.
+  explicit MpscQueue(std::size_t capacity,
+                     Backpressure policy = Backpressure::kBlock)
+      : policy_(policy) {
+    if (capacity == 0) throw std::invalid_argument("MpscQueue: zero capacity");
+    capacity_ = std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity);
+    mask_ = capacity_ - 1;
+    slots_ = std::make_unique<Slot[]>(capacity_);
+    for (std::size_t i = 0; i < capacity_; ++i)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  std::size_t capacity() const noexcept { return capacity_; }
+  Backpressure policy() const noexcept { return policy_; }
+
+  /// Enqueues `value` according to the backpressure policy. Returns false
+  /// if the value was refused: the queue is closed, or full under kReject.
+  /// Safe to call from any number of threads.
+  bool push(T value) noexcept {
+    if (closed_.load(std::memory_order_relaxed)) return refuse();
+    if (!try_push(value)) {
+      if (policy_ == Backpressure::kReject) return refuse();
+      producer_waits_.fetch_add(1, std::memory_order_relaxed);
+      if (!push_slow(value)) return refuse();
+    }
+    wake_consumer();
+    return true;
+  }
+
+  /// Moves up to `max` of the oldest elements into `out` without waiting.
+  /// Consumer thread only.
+  std::size_t pop_batch(T* out, std::size_t max) noexcept {
+    if (max == 0) return 0;
+    std::uint64_t pos;
+    const std::size_t n = claim(max, pos);
+    for (std::size_t i = 0; i < n; ++i) {
+      Slot& s = slots_[(pos + i) & mask_];
+      out[i] = std::move(s.value);
+      s.sequence.store(pos + i + capacity_, std::memory_order_release);
+    }
+    if (n != 0) {
+      popped_.store(popped_.load(std::memory_order_relaxed) + n,
+                    std::memory_order_relaxed);
+      wake_producers();
+    }
+    return n;
+  }
+
+  /// Like pop_batch(), but waits up to `timeout` for the first element.
+  /// Returns 0 on timeout, or once the queue is closed and drained.
+  std::size_t pop_batch(T* out, std::size_t max,
+                        std::chrono::microseconds timeout) noexcept {
+    if (std::size_t n = pop_batch(out, max); n != 0) return n;
+    for (int spin = 0; spin < kConsumerSpins; ++spin) {
+      std::this_thread::yield();
+      if (std::size_t n = pop_batch(out, max); n != 0) return n;
+    }
+    consumer_waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (std::size_t n = pop_batch(out, max); n != 0) {
+      consumer_waiting_.store(false, std::memory_order_relaxed);
+      return n;
+    }
+    {
+      std::unique_lock lock(sleep_mutex_);
+      sleep_cv_.wait_for(lock, timeout, [&] {
+        return ready() || closed_.load(std::memory_order_relaxed);
+      });
+    }
+    consumer_waiting_.store(false, std::memory_order_relaxed);
+    return pop_batch(out, max);
+  }
+
+  bool try_pop(T& out) noexcept { return pop_batch(&out, 1) == 1; }
+
+  /// Refuses further pushes and wakes every waiting producer and the
+  /// consumer. Elements already queued can still be popped.
+  void close() noexcept {
+    closed_.store(true, std::memory_order_seq_cst);
+    space_epoch_.fetch_add(1, std::memory_order_release);
+    space_epoch_.notify_all();
+    std::lock_guard lock(sleep_mutex_);
+    sleep_cv_.notify_all();
+  }
+
+  bool closed() const noexcept { return closed_.load(std::memory_order_relaxed); }
+
+  /// Queued elements, including ones whose producer has not finished
+  /// publishing yet. Exact only when no push or pop is in progress.
+  std::size_t size_approx() const noexcept {
+    const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+  }
+
+  MpscQueueStats stats() const noexcept {
+    MpscQueueStats s;
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.popped = popped_.load(std::memory_order_relaxed);
+    s.pushed = tail_.load(std::memory_order_relaxed);
+    s.rejected = rejected_.load(std::memory_order_relaxed);
+    s.producer_waits = producer_waits_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+ private:
+  static constexpr int kConsumerSpins = 64;
+  static constexpr int kProducerSpins = 64;
+
+  struct Slot {
+    std::atomic<std::uint64_t> sequence{0};
+    T value{};
+  };
+
+  // Vyukov enqueue: the slot at `pos` is free when its sequence equals pos.
+  bool try_push(T& value) noexcept {
+    std::uint64_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& s = slots_[pos & mask_];
+      const std::uint64_t seq = s.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::int64_t>(seq - pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          s.value = std::move(value);
+          s.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // the slot still holds an element from a lap ago
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool push_slow(T& value) noexcept {
+    if (policy_ == Backpressure::kDropOldest) {
+      while (!try_push(value)) {
+        if (closed_.load(std::memory_order_relaxed)) return false;
+        // The head slot may be claimed but not yet published; just retry.
+        if (!evict_oldest()) std::this_thread::yield();
+      }
+      return true;
+    }
+    for (int spin = 0; spin < kProducerSpins; ++spin) {
+      std::this_thread::yield();
+      if (try_push(value)) return true;
+    }
+    for (;;) {
+      const std::uint32_t epoch = space_epoch_.load(std::memory_order_acquire);
+      producers_waiting_.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const bool pushed = !closed_.load(std::memory_order_relaxed) && try_push(value);
+      if (!pushed && !closed_.load(std::memory_order_relaxed))
+        space_epoch_.wait(epoch, std::memory_order_acquire);
+      producers_waiting_.fetch_sub(1, std::memory_order_relaxed);
+      if (pushed) return true;
+      if (closed_.load(std::memory_order_relaxed)) return false;
+    }
+  }
+
+  // Claims the longest run (up to `max`) of published slots at the head.
+  std::size_t claim(std::size_t max, std::uint64_t& pos) noexcept {
+    pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      std::size_t n = 0;
+      while (n < max &&
+             slots_[(pos + n) & mask_].sequence.load(std::memory_order_acquire) ==
+                 pos + n + 1)
+        ++n;
+      if (n == 0) {
+        const std::uint64_t seq =
+            slots_[pos & mask_].sequence.load(std::memory_order_acquire);
+        if (static_cast<std::int64_t>(seq - (pos + 1)) < 0) return 0;  // empty
+        pos = head_.load(std::memory_order_relaxed);  // an evictor moved it
+        continue;
+      }
+      if (head_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+        return n;
+    }
+  }
+
+  bool evict_oldest() noexcept {
+    std::uint64_t pos;
+    if (claim(1, pos) == 0) return false;
+    Slot& s = slots_[pos & mask_];
+    s.value = T{};
+    s.sequence.store(pos + capacity_, std::memory_order_release);
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool ready() const noexcept {
+    const std::uint64_t pos = head_.load(std::memory_order_relaxed);
+    return slots_[pos & mask_].sequence.load(std::memory_order_acquire) == pos + 1;
+  }
+
+  bool refuse() noexcept {
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  void wake_consumer() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_waiting_.load(std::memory_order_relaxed)) {
+      { std::lock_guard lock(sleep_mutex_); }
+      sleep_cv_.notify_one();
+    }
+  }
+
+  void wake_producers() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (producers_waiting_.load(std::memory_order_relaxed) != 0) {
+      space_epoch_.fetch_add(1, std::memory_order_release);
+      space_epoch_.notify_all();
+    }
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t capacity_ = 0;
+  std::size_t mask_ = 0;
+  Backpressure policy_;
+
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> tail_{0};
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> head_{0};
+  std::atomic<std::uint64_t> popped_{0};  // written by the consumer only
+  alignas(kCacheLineSize) std::atomic<std::uint32_t> space_epoch_{0};
+  std::atomic<std::uint32_t> producers_waiting_{0};
+  std::atomic<bool> consumer_waiting_{false};
+  std::atomic<bool> closed_{false};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<std::uint64_t> rejected_{0};
+  std::atomic<std::uint64_t> producer_waits_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+};
+
+}  // namespace meat_quality
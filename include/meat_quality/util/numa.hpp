@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace meat_quality {
+
+/// One NUMA node (socket) and the CPUs attached to it.
+struct NumaNode {
+  int id = 0;
+  std::vector<int> cpus;
+};
+
+/// NUMA layout of the machine, read from /sys/devices/system/node. No
+/// libnuma dependency: memory placement relies on the kernel's default
+/// first-touch policy, so state is made local by constructing it on a
+/// thread pinned to the node that will use it.
+class NumaTopology {
+ public:
+  /// The running machine. Without NUMA information (non-Linux, containers
+  /// hiding sysfs) this is one node holding every CPU the process may use.
+  static NumaTopology detect();
+
+  /// An explicit layout, e.g. to split a single socket for testing. Nodes
+  /// without CPUs are dropped; an empty list means one node with CPU 0.
+  explicit NumaTopology(std::vector<NumaNode> nodes);
+
+  std::size_t node_count() const noexcept { return nodes_.size(); }
+  const NumaNode& node(std::size_t i) const noexcept { return nodes_[i]; }
+  std::span<const NumaNode> nodes() const noexcept { return nodes_; }
+
+ private:
+  std::vector<NumaNode> nodes_;
+};
+
+/// Restricts the calling thread to `cpus`. Returns false if the platform
+/// or the process's own affinity mask does not allow it.
+bool pin_current_thread(std::span<const int> cpus) noexcept;
+
+/// CPU the calling thread is running on, or -1 if unknown.
+int current_cpu() noexcept;
+
+}  // namespace meat_quality
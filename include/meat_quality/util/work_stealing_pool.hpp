@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace meat_quality {
+
+/// Fixed-size thread pool with one task deque per worker. A worker pushes
+/// and pops its own deque at the back (newest first, cache-warm) and, when
+/// empty, steals the oldest task from the front of another worker's deque.
+/// Tasks submitted from outside the pool are spread round robin.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  /// `threads == 0` means one worker per hardware thread, or per entry of
+  /// `cpus` if given. With `cpus`, worker `i` is pinned to `cpus[i %
+  /// cpus.size()]`, e.g. one pool per socket from `NumaTopology`; tasks
+  /// and their arenas then stay on that socket's cores and memory.
+  explicit WorkStealingPool(std::size_t threads = 0, std::span<const int> cpus = {});
+
+  /// Runs every queued task, then joins the workers.
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  std::size_t thread_count() const noexcept { return threads_.size(); }
+
+  void submit(Task task);
+
+  /// Runs one queued task on the calling thread, if any. Lets a thread that
+  /// waits on pool work help instead of blocking.
+  bool run_one();
+
+  /// Index of the calling worker thread of this pool, or -1.
+  int current_worker() const noexcept;
+
+ private:
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void worker_loop(std::size_t index);
+  bool pop(std::size_t index, Task& out);
+  bool steal(std::size_t thief, Task& out);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<std::size_t> queued_{0};
+  std::atomic<std::size_t> next_queue_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  bool stopping_ = false;  // guarded by sleep_mutex_
+};
+
+/// A set of pool tasks that can be waited on together. `wait()` helps run
+/// pool tasks and rethrows the first exception thrown by a task of the
+/// group.
+class TaskGroup {
+ public:
+  explicit TaskGroup(WorkStealingPool& pool) noexcept : pool_(pool) {}
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  void run(std::function<void()> task);
+  void wait();
+
+ private:
+  WorkStealingPool& pool_;
+  std::atomic<std::size_t> outstanding_{0};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+}  // namespace meat_quality
@@ -0,0 +1,94 @@
+#include "meat_quality/cluster/coordinator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace meat_quality {
+
+MembershipCoordinator::MembershipCoordinator(CoordinatorOptions options) : options_(options) {
+  if (options_.shard_count == 0 || options_.vnodes == 0) {
+    throw std::invalid_argument("MembershipCoordinator: shard_count and vnodes must be positive");
+  }
+  publish();
+}
+
+void MembershipCoordinator::publish() {
+  std::vector<RingMember> ring;
+  ring.reserve(members_.size());
+  for (const MemberInfo& m : members_) ring.push_back({m.id, m.weight});
+  map_ = std::make_shared<const ShardMap>(
+      ShardMap::build(ring, epoch_, options_.shard_count, options_.vnodes));
+}
+
+std::shared_ptr<const ShardMap> MembershipCoordinator::join(MemberId id, std::string address,
+                                                            std::uint32_t weight,
+                                                            Timestamp now) {
+  std::lock_guard lock(mutex_);
+  auto it = std::find_if(members_.begin(), members_.end(),
+                         [id](const MemberInfo& m) { return m.id == id; });
+  if (it == members_.end()) {
+    members_.push_back({id, std::move(address), weight, now});
+  } else {
+    it->address = std::move(address);
+    it->last_heartbeat = now;
+    // Only a weight change moves shards; an address change is not a new epoch.
+    if (it->weight == weight) return map_;
+    it->weight = weight;
+  }
+  ++epoch_;
+  publish();
+  return map_;
+}
+
+bool MembershipCoordinator::heartbeat(MemberId id, Timestamp now) {
+  std::lock_guard lock(mutex_);
+  for (MemberInfo& m : members_) {
+    if (m.id == id) {
+      m.last_heartbeat = std::max(m.last_heartbeat, now);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MembershipCoordinator::leave(MemberId id) {
+  std::lock_guard lock(mutex_);
+  const auto removed = std::erase_if(members_, [id](const MemberInfo& m) { return m.id == id; });
+  if (removed == 0) return false;
+  ++epoch_;
+  publish();
+  return true;
+}
+
+std::vector<MemberId> MembershipCoordinator::expire(Timestamp now) {
+  std::lock_guard lock(mutex_);
+  std::vector<MemberId> expired;
+  std::erase_if(members_, [&](const MemberInfo& m) {
+    if (now - m.last_heartbeat <= options_.lease) return false;
+    expired.push_back(m.id);
+    return true;
+  });
+  if (!expired.empty()) {
+    ++epoch_;
+    publish();
+  }
+  return expired;
+}
+
+std::shared_ptr<const ShardMap> MembershipCoordinator::shard_map() const {
+  std::lock_guard lock(mutex_);
+  return map_;
+}
+
+std::uint64_t MembershipCoordinator::epoch() const {
+  std::lock_guard lock(mutex_);
+  return epoch_;
+}
+
+std::vector<MemberInfo> MembershipCoordinator::members() const {
+  std::lock_guard lock(mutex_);
+  return members_;
+}
+
+}  // namespace meat_quality
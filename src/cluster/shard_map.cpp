@@ -0,0 +1,62 @@
+#include "meat_quality/cluster/shard_map.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace meat_quality {
+
+ShardMap ShardMap::build(std::span<const RingMember> members, std::uint64_t epoch,
+                         std::uint32_t shard_count, std::uint32_t vnodes) {
+  if (shard_count == 0 || vnodes == 0) {
+    throw std::invalid_argument("ShardMap: shard_count and vnodes must be positive");
+  }
+  std::vector<std::pair<std::uint64_t, MemberId>> ring;
+  for (const RingMember& m : members) {
+    for (const RingMember& other : members) {
+      if (&other != &m && other.id == m.id) {
+        throw std::invalid_argument("ShardMap: duplicate member id");
+      }
+    }
+    const std::uint64_t points = std::uint64_t{std::max(1u, m.weight)} * vnodes;
+    for (std::uint64_t v = 0; v < points; ++v) {
+      ring.emplace_back(mix64((std::uint64_t{m.id} << 32) ^ mix64(v)), m.id);
+    }
+  }
+  std::sort(ring.begin(), ring.end());
+
+  ShardMap map;
+  map.epoch_ = epoch;
+  map.owners_.assign(shard_count, kNoMember);
+  if (ring.empty()) return map;
+  for (ShardId s = 0; s < shard_count; ++s) {
+    // Shard points are hashed separately from node ids so that neighbouring
+    // shards do not land next to each other on the ring.
+    const std::uint64_t h = mix64(0x5eed0000'00000000ull ^ s);
+    auto it = std::lower_bound(ring.begin(), ring.end(), std::pair{h, MemberId{0}});
+    if (it == ring.end()) it = ring.begin();
+    map.owners_[s] = it->second;
+  }
+  return map;
+}
+
+std::vector<ShardId> ShardMap::shards_of(MemberId member) const {
+  std::vector<ShardId> out;
+  for (ShardId s = 0; s < owners_.size(); ++s) {
+    if (owners_[s] == member) out.push_back(s);
+  }
+  return out;
+}
+
+std::vector<ShardMove> moves_between(const ShardMap& before, const ShardMap& after) {
+  if (before.shard_count() != after.shard_count()) {
+    throw std::invalid_argument("moves_between: shard counts differ");
+  }
+  std::vector<ShardMove> moves;
+  for (ShardId s = 0; s < before.shard_count(); ++s) {
+    if (before.owner(s) != after.owner(s)) moves.push_back({s, before.owner(s), after.owner(s)});
+  }
+  return moves;
+}
+
+}  // namespace meat_quality
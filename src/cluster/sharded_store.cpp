@@ -0,0 +1,292 @@
+#include "meat_quality/cluster/sharded_store.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include "../storage/gorilla.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Shard blob: header, then per node its id, sample count and the byte
+// length of each column, then the columns (timestamps, then the channels),
+// then a checksum of everything before it and eight bytes of zero padding
+// for the bit readers. Native byte order; members of one service share an
+// architecture.
+constexpr std::uint32_t kBlobMagic = 0x5853514d;  // "MQSX"
+constexpr std::uint16_t kBlobVersion = 1;
+constexpr std::size_t kColumns = kChannelCount + 1;
+constexpr std::size_t kTrailer = sizeof(std::uint64_t) + 8;
+
+struct BlobHeader {
+  std::uint32_t magic;
+  std::uint16_t version;
+  std::uint16_t channels;
+  std::uint32_t shard;
+  std::uint32_t shard_count;
+  std::uint64_t epoch;
+  std::uint32_t nodes;
+  std::uint32_t reserved;
+};
+
+struct NodeHeader {
+  std::uint32_t node;
+  std::uint32_t count;
+  std::uint32_t column_bytes[kColumns];
+};
+
+// FNV-1a; catches truncation and corruption in transit, not tampering.
+std::uint64_t checksum(const std::uint8_t* p, std::size_t n) noexcept {
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  for (std::size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 0x100000001b3ull;
+  return h;
+}
+
+template <typename T>
+void append(std::vector<std::uint8_t>& out, const T& v) {
+  const auto* p = reinterpret_cast<const std::uint8_t*>(&v);
+  out.insert(out.end(), p, p + sizeof v);
+}
+
+[[noreturn]] void malformed() {
+  throw std::invalid_argument("ShardedSampleStore: malformed shard blob");
+}
+
+}  // namespace
+
+ShardedSampleStore::ShardedSampleStore(MemberId self, std::size_t max_nodes,
+                                       std::size_t capacity_per_node, std::uint32_t shard_count)
+    : self_(self), store_(max_nodes, capacity_per_node) {
+  if (max_nodes == 0 || max_nodes >= kNoSlot || shard_count == 0) {
+    throw std::invalid_argument("ShardedSampleStore: invalid node or shard count");
+  }
+  state_.assign(shard_count, State::kNotOwned);
+  transfer_epoch_.assign(shard_count, 0);
+  shard_nodes_.resize(shard_count);
+  slots_.reserve(max_nodes);
+  free_slots_.resize(max_nodes);
+  // Lowest slots first, so a lightly loaded member touches little memory.
+  for (std::size_t i = 0; i < max_nodes; ++i) {
+    free_slots_[i] = static_cast<NodeId>(max_nodes - 1 - i);
+  }
+}
+
+NodeId ShardedSampleStore::slot_of(NodeId node) const noexcept {
+  const auto it = slots_.find(node);
+  return it == slots_.end() ? kNoSlot : it->second;
+}
+
+Rebalance ShardedSampleStore::apply(const ShardMap& map) {
+  if (map.shard_count() != shard_count()) {
+    throw std::invalid_argument("ShardedSampleStore: shard map has a different shard count");
+  }
+  Rebalance plan;
+  if (map.epoch() < epoch_) return plan;
+  epoch_ = map.epoch();
+  for (ShardId s = 0; s < shard_count(); ++s) {
+    const bool mine = map.owner(s) == self_;
+    State& st = state_[s];
+    if (mine) {
+      // A shard that comes back before it was exported still has its data.
+      if (st == State::kNotOwned) plan.incoming.push_back(s);
+      // Only a member that lost it at this epoch or later can send it now.
+      if (st != State::kOwned) transfer_epoch_[s] = epoch_;
+      st = State::kOwned;
+    } else if (st == State::kOwned || st == State::kLeaving) {
+      if (shard_nodes_[s].empty()) {
+        st = State::kNotOwned;
+      } else {
+        st = State::kLeaving;
+        plan.outgoing.push_back(s);
+      }
+    }
+  }
+  return plan;
+}
+
+NodeId ShardedSampleStore::acquire(NodeId node, ShardId shard) {
+  const auto it = slots_.find(node);
+  if (it != slots_.end()) return it->second;
+  if (free_slots_.empty()) return kNoSlot;
+  const NodeId slot = free_slots_.back();
+  free_slots_.pop_back();
+  slots_.emplace(node, slot);
+  shard_nodes_[shard].push_back(node);
+  return slot;
+}
+
+ShardPush ShardedSampleStore::push(NodeId node, const SensorSample& sample) {
+  const ShardId shard = shard_of(node, shard_count());
+  if (state_[shard] != State::kOwned) return ShardPush::kNotOwned;
+  const NodeId slot = acquire(node, shard);
+  if (slot == kNoSlot) return ShardPush::kFull;
+  return store_.push(slot, sample) ? ShardPush::kStored : ShardPush::kOutOfOrder;
+}
+
+std::vector<std::uint8_t> ShardedSampleStore::export_shard(ShardId shard,
+                                                           std::vector<NodeId>* released) {
+  if (shard >= shard_count() || state_[shard] == State::kOwned) {
+    throw std::invalid_argument("ShardedSampleStore: cannot export an owned shard");
+  }
+  std::vector<NodeId>& nodes = shard_nodes_[shard];
+  std::vector<std::uint8_t> out;
+  const BlobHeader header{kBlobMagic, kBlobVersion, static_cast<std::uint16_t>(kChannelCount),
+                          shard, shard_count(), epoch_,
+                          static_cast<std::uint32_t>(nodes.size()), 0};
+  append(out, header);
+
+  std::vector<Timestamp> t;
+  std::vector<float> x;
+  std::vector<std::uint8_t> column;
+  for (const NodeId node : nodes) {
+    const NodeId slot = slots_.at(node);
+    const WindowView w = store_.window(slot, 0);
+    NodeHeader nh{node, static_cast<std::uint32_t>(w.size()), {}};
+    const std::size_t nh_at = out.size();
+    append(out, nh);
+    if (!w.empty()) {
+      const auto encode = [&](std::size_t c, auto&& fn) {
+        column.clear();
+        gorilla::detail::BitWriter bw(column);
+        fn(bw);
+        bw.finish();
+        nh.column_bytes[c] = static_cast<std::uint32_t>(column.size());
+        out.insert(out.end(), column.begin(), column.end());
+      };
+      t.assign(w.timestamps.first.begin(), w.timestamps.first.end());
+      t.insert(t.end(), w.timestamps.second.begin(), w.timestamps.second.end());
+      encode(0, [&](gorilla::detail::BitWriter& bw) {
+        gorilla::detail::encode_timestamps(t.data(), t.size(), bw);
+      });
+      for (std::size_t c = 0; c < kChannelCount; ++c) {
+        x.assign(w.channels[c].first.begin(), w.channels[c].first.end());
+        x.insert(x.end(), w.channels[c].second.begin(), w.channels[c].second.end());
+        encode(c + 1, [&](gorilla::detail::BitWriter& bw) {
+          gorilla::detail::encode_floats(x.data(), x.size(), bw);
+        });
+      }
+      std::memcpy(out.data() + nh_at, &nh, sizeof nh);
+    }
+    store_.clear(slot);
+    slots_.erase(node);
+    free_slots_.push_back(slot);
+    if (released != nullptr) released->push_back(slot);
+  }
+  append(out, checksum(out.data(), out.size()));
+  out.resize(out.size() + 8, 0);
+  nodes.clear();
+  nodes.shrink_to_fit();
+  state_[shard] = State::kNotOwned;
+  return out;
+}
+
+ShardImport ShardedSampleStore::import_shard(std::span<const std::uint8_t> blob) {
+  if (blob.size() < sizeof(BlobHeader) + kTrailer) malformed();
+  const std::size_t body = blob.size() - kTrailer;
+  std::uint64_t sum;
+  std::memcpy(&sum, blob.data() + body, sizeof sum);
+  if (sum != checksum(blob.data(), body)) malformed();
+  BlobHeader header;
+  std::memcpy(&header, blob.data(), sizeof header);
+  if (header.magic != kBlobMagic || header.version != kBlobVersion ||
+      header.channels != kChannelCount || header.shard_count != shard_count() ||
+      header.shard >= shard_count()) {
+    malformed();
+  }
+  if (state_[header.shard] != State::kOwned) {
+    throw std::invalid_argument("ShardedSampleStore: imported shard is not owned here");
+  }
+  if (header.epoch > epoch_) {
+    throw std::invalid_argument("ShardedSampleStore: shard blob is from a newer map");
+  }
+  if (header.epoch < transfer_epoch_[header.shard]) {
+    throw std::invalid_argument("ShardedSampleStore: shard blob predates the last transfer");
+  }
+
+  // Validate the whole layout before touching any slot.
+  struct Entry {
+    NodeHeader header;
+    std::size_t column_at[kColumns];
+  };
+  // Every node needs at least its header, so a larger count is a lie
+  // rather than a reason to allocate.
+  if (header.nodes > (body - sizeof header) / sizeof(NodeHeader)) malformed();
+  std::vector<Entry> entries(header.nodes);
+  std::size_t at = sizeof header;
+  for (Entry& e : entries) {
+    if (body - at < sizeof e.header) malformed();
+    std::memcpy(&e.header, blob.data() + at, sizeof e.header);
+    at += sizeof e.header;
+    if (shard_of(e.header.node, shard_count()) != header.shard) malformed();
+    for (std::size_t c = 0; c < kColumns; ++c) {
+      const std::uint32_t bytes = e.header.column_bytes[c];
+      if ((e.header.count == 0) != (bytes == 0) || body - at < bytes) malformed();
+      // Each sample after the first costs at least one bit, so a count the
+      // column cannot hold would size the decode buffers from garbage.
+      const std::uint64_t first_bits = c == 0 ? 64 : 32;
+      if (e.header.count != 0 &&
+          std::uint64_t{bytes} * 8 < first_bits + (e.header.count - 1)) {
+        malformed();
+      }
+      e.column_at[c] = at;
+      at += bytes;
+    }
+  }
+  if (at != body) malformed();
+
+  // Claim slots only once they are known to suffice, so that running out
+  // leaves the store as it was.
+  std::vector<NodeId> ids(entries.size());
+  for (std::size_t i = 0; i < entries.size(); ++i) ids[i] = entries[i].header.node;
+  std::sort(ids.begin(), ids.end());
+  if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) malformed();
+  const auto fresh = std::count_if(ids.begin(), ids.end(),
+                                   [&](NodeId node) { return !slots_.contains(node); });
+  if (static_cast<std::size_t>(fresh) > free_slots_.size()) {
+    throw std::runtime_error("ShardedSampleStore: out of node slots");
+  }
+
+  ShardImport result;
+  std::vector<Timestamp> t;
+  std::array<std::vector<float>, kChannelCount> x;
+  std::vector<SensorSample> held;
+  for (const Entry& e : entries) {
+    const NodeId slot = acquire(e.header.node, header.shard);
+    // Samples pushed here since the map changed are newer than the export.
+    held.clear();
+    const WindowView mine = store_.window(slot, 0);
+    for (std::size_t j = 0; j < mine.size(); ++j) held.push_back(mine.sample(j));
+    store_.clear(slot);
+
+    const std::uint32_t n = e.header.count;
+    if (n != 0) {
+      const auto column = [&](std::size_t k) {
+        const std::uint8_t* p = blob.data() + e.column_at[k];
+        return gorilla::detail::BitReader(p, p + e.header.column_bytes[k]);
+      };
+      t.resize(n);
+      gorilla::detail::BitReader rt = column(0);
+      gorilla::detail::decode_timestamps(rt, n, t.data());
+      std::array<const float*, kChannelCount> columns;
+      for (std::size_t c = 0; c < kChannelCount; ++c) {
+        x[c].resize(n);
+        gorilla::detail::BitReader r = column(c + 1);
+        gorilla::detail::decode_floats(r, n, x[c].data());
+        columns[c] = x[c].data();
+      }
+      result.samples += store_.push_columns(slot, t.data(), columns, n);
+    }
+    const Timestamp newest = store_.newest(slot);
+    for (const SensorSample& s : held) {
+      if ((n == 0 || s.timestamp > newest) && store_.push(slot, s)) ++result.samples;
+    }
+    ++result.nodes;
+    result.slots.push_back(slot);
+  }
+  transfer_epoch_[header.shard] = header.epoch;
+  return result;
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,58 @@
+#include "meat_quality/core/ingest_queue.hpp"
+
+#include "meat_quality/telemetry/telemetry.hpp"
+
+namespace meat_quality {
+namespace {
+
+// `calibrate(records)` corrects a popped batch in place before it is stored.
+template <typename Calibrate>
+DrainResult drain(IngestQueue& queue, SampleStore& store, std::span<IngestRecord> batch,
+                  std::chrono::microseconds timeout, Calibrate&& calibrate) noexcept {
+  DrainResult r;
+  telemetry::observe(telemetry::Distribution::kQueueDepth, queue.size_approx());
+  r.popped = queue.pop_batch(batch.data(), batch.size(), timeout);
+  if (r.popped == 0) return r;
+  telemetry::StageTimer timer(telemetry::Stage::kIngest);
+  calibrate(batch.first(r.popped));
+  for (std::size_t i = 0; i < r.popped; ++i) {
+    const IngestRecord& rec = batch[i];
+    if (rec.node >= store.node_count()) {
+      ++r.unknown_node;
+    } else if (store.push(rec.node, rec.sample)) {
+      ++r.stored;
+    } else {
+      ++r.out_of_order;
+    }
+  }
+  telemetry::add(telemetry::Counter::kSamplesIngested, r.stored);
+  telemetry::add(telemetry::Counter::kSamplesRejected, r.out_of_order + r.unknown_node);
+  return r;
+}
+
+}  // namespace
+
+DrainResult drain_batch(IngestQueue& queue, SampleStore& store,
+                        std::span<IngestRecord> batch,
+                        std::chrono::microseconds timeout,
+                        std::span<const NodeCalibration> calibration) noexcept {
+  return drain(queue, store, batch, timeout, [calibration](std::span<IngestRecord> records) {
+    for (IngestRecord& rec : records) {
+      if (rec.node < calibration.size()) calibration[rec.node].apply(rec.sample);
+    }
+  });
+}
+
+DrainResult drain_batch(IngestQueue& queue, SampleStore& store,
+                        std::span<IngestRecord> batch,
+                        std::chrono::microseconds timeout,
+                        const NodeRegistry& registry) noexcept {
+  return drain(queue, store, batch, timeout, [&registry](std::span<IngestRecord> records) {
+    const NodeRegistry::ReadGuard snapshot = registry.read();
+    for (IngestRecord& rec : records) {
+      if (const NodeRecord* node = snapshot->find(rec.node)) node->calibration.apply(rec.sample);
+    }
+  });
+}
+
+}  // namespace meat_quality
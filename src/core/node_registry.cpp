@@ -0,0 +1,162 @@
+#include "meat_quality/core/node_registry.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "meat_quality/cluster/shard_map.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Smallest power of two keeping the table at most half full.
+std::size_t table_size(std::size_t records) noexcept {
+  std::size_t size = 16;
+  while (size < 2 * records) size <<= 1;
+  return size;
+}
+
+// Reader counter slot of the calling thread, assigned round-robin on first
+// use; threads beyond kReaderSlots share slots, which only costs contention.
+std::size_t reader_slot() noexcept {
+  static std::atomic<std::size_t> next{0};
+  thread_local const std::size_t slot =
+      next.fetch_add(1, std::memory_order_relaxed) % NodeRegistry::kReaderSlots;
+  return slot;
+}
+
+}  // namespace
+
+NodeRegistry::Snapshot::Snapshot(std::vector<NodeRecord> records, std::uint64_t version)
+    : records_(std::move(records)),
+      slots_(table_size(records_.size()), Slot{0, kEmpty}),
+      version_(version) {
+  const std::size_t mask = slots_.size() - 1;
+  for (std::size_t r = 0; r < records_.size(); ++r) {
+    const NodeId node = records_[r].node;
+    std::size_t i = mix64(node) & mask;
+    for (; slots_[i].index != kEmpty; i = (i + 1) & mask) {
+      if (slots_[i].node == node) {
+        throw std::invalid_argument("NodeRegistry: node " + std::to_string(node) +
+                                    " registered twice");
+      }
+    }
+    slots_[i] = {node, static_cast<std::uint32_t>(r)};
+  }
+}
+
+const NodeRecord* NodeRegistry::Snapshot::find(NodeId node) const noexcept {
+  const std::size_t mask = slots_.size() - 1;
+  for (std::size_t i = mix64(node) & mask;; i = (i + 1) & mask) {
+    const Slot& s = slots_[i];
+    if (s.index == kEmpty) return nullptr;
+    if (s.node == node) return &records_[s.index];
+  }
+}
+
+NodeRegistry::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+    : counter_(std::exchange(other.counter_, nullptr)), snapshot_(other.snapshot_) {}
+
+NodeRegistry::ReadGuard::~ReadGuard() {
+  if (counter_ != nullptr) counter_->fetch_sub(1, std::memory_order_release);
+}
+
+NodeRegistry::NodeRegistry(std::vector<NodeRecord> records)
+    : current_(new Snapshot(std::move(records), 1)) {}
+
+NodeRegistry::~NodeRegistry() { delete current_.load(std::memory_order_relaxed); }
+
+NodeRegistry::ReadGuard NodeRegistry::read() const noexcept {
+  // Sequentially consistent throughout: a reader that increments after an
+  // updater has seen its counter at zero must also see the new snapshot.
+  ReaderSlot& slot = slots_[reader_slot()];
+  std::atomic<std::uint32_t>* counter = &slot.readers[phase_.load() & 1];
+  counter->fetch_add(1);
+  return {counter, current_.load()};
+}
+
+bool NodeRegistry::lookup(NodeId node, NodeRecord& out) const noexcept {
+  const ReadGuard snapshot = read();
+  const NodeRecord* r = snapshot->find(node);
+  if (r == nullptr) return false;
+  out = *r;
+  return true;
+}
+
+void NodeRegistry::replace(std::vector<NodeRecord> records) {
+  std::lock_guard lock(update_mutex_);
+  publish(std::move(records));
+}
+
+void NodeRegistry::update(std::span<const NodeRecord> records, std::span<const NodeId> removed) {
+  std::lock_guard lock(update_mutex_);
+  // Writers are serialized, so the current snapshot cannot be freed here.
+  const Snapshot& now = *current_.load();
+  std::vector<NodeRecord> next(now.records().begin(), now.records().end());
+  std::unordered_map<NodeId, std::size_t> position;
+  position.reserve(next.size() + records.size());
+  for (std::size_t i = 0; i < next.size(); ++i) position.emplace(next[i].node, i);
+  for (const NodeRecord& r : records) {
+    const auto [it, added] = position.emplace(r.node, next.size());
+    if (added) {
+      next.push_back(r);
+    } else {
+      next[it->second] = r;
+    }
+  }
+  if (!removed.empty()) {
+    const std::unordered_set<NodeId> gone(removed.begin(), removed.end());
+    std::erase_if(next, [&](const NodeRecord& r) { return gone.contains(r.node); });
+  }
+  publish(std::move(next));
+}
+
+void NodeRegistry::modify(const std::function<void(std::vector<NodeRecord>&)>& edit) {
+  std::lock_guard lock(update_mutex_);
+  const Snapshot& now = *current_.load();
+  std::vector<NodeRecord> next(now.records().begin(), now.records().end());
+  edit(next);
+  publish(std::move(next));
+}
+
+void NodeRegistry::publish(std::vector<NodeRecord> records) {
+  const Snapshot* old = current_.load();
+  const Snapshot* next = new Snapshot(std::move(records), old->version() + 1);
+  current_.store(next);
+
+  // Flip the phase so new readers count on the other side, drain the side
+  // they left, then do the same for the other side. A reader counted on
+  // either side before the store has then finished, and any later one sees
+  // `next`.
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 2; ++i) wait_for_readers(phase_.fetch_add(1) & 1);
+  grace_ns_ += static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                           start)
+          .count());
+  delete old;
+}
+
+void NodeRegistry::wait_for_readers(unsigned phase) const noexcept {
+  for (const ReaderSlot& slot : slots_) {
+    while (slot.readers[phase].load() != 0) std::this_thread::yield();
+  }
+}
+
+NodeRegistryStats NodeRegistry::stats() const {
+  NodeRegistryStats s;
+  {
+    const ReadGuard snapshot = read();
+    s.version = snapshot->version();
+    s.nodes = snapshot->size();
+  }
+  std::lock_guard lock(update_mutex_);
+  s.grace_ns = grace_ns_;
+  return s;
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,120 @@
+#include "meat_quality/core/sample_store.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace meat_quality {
+
+SensorSample WindowView::sample(std::size_t i) const noexcept {
+  SensorSample s;
+  s.timestamp = timestamps[i];
+  for (std::size_t c = 0; c < kChannelCount; ++c) s.values[c] = channels[c][i];
+  return s;
+}
+
+WindowView WindowView::head(std::size_t n) const noexcept {
+  WindowView w;
+  w.timestamps = timestamps.head(n);
+  for (std::size_t c = 0; c < kChannelCount; ++c) w.channels[c] = channels[c].head(n);
+  return w;
+}
+
+SampleStore::SampleStore(std::size_t node_count, std::size_t capacity_per_node)
+    : capacity_(std::bit_ceil(capacity_per_node == 0 ? 1 : capacity_per_node)),
+      mask_(capacity_ - 1),
+      cursors_(node_count),
+      timestamps_(node_count * capacity_) {
+  if (node_count == 0) throw std::invalid_argument("SampleStore: no nodes");
+  for (auto& column : columns_) column = AlignedBuffer<float>(node_count * capacity_);
+}
+
+bool SampleStore::push(NodeId node, const SensorSample& sample) noexcept {
+  Cursor& cur = cursors_[node];
+  if (cur.head != 0 && sample.timestamp < cur.newest) return false;
+  const std::size_t at = base(node) + (cur.head & mask_);
+  timestamps_[at] = sample.timestamp;
+  for (std::size_t c = 0; c < kChannelCount; ++c) columns_[c][at] = sample.values[c];
+  cur.newest = sample.timestamp;
+  ++cur.head;
+  return true;
+}
+
+std::size_t SampleStore::push_columns(
+    NodeId node, const Timestamp* timestamps,
+    const std::array<const float*, kChannelCount>& columns,
+    std::size_t n) noexcept {
+  Cursor& cur = cursors_[node];
+  const std::size_t b = base(node);
+  std::size_t stored = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (cur.head != 0 && timestamps[i] < cur.newest) continue;
+    const std::size_t at = b + (cur.head & mask_);
+    timestamps_[at] = timestamps[i];
+    for (std::size_t c = 0; c < kChannelCount; ++c) columns_[c][at] = columns[c][i];
+    cur.newest = timestamps[i];
+    ++cur.head;
+    ++stored;
+  }
+  return stored;
+}
+
+std::size_t SampleStore::size(NodeId node) const noexcept {
+  const std::uint64_t head = cursors_[node].head;
+  return head < capacity_ ? static_cast<std::size_t>(head) : capacity_;
+}
+
+Timestamp SampleStore::newest(NodeId node) const noexcept {
+  return cursors_[node].head == 0 ? 0 : cursors_[node].newest;
+}
+
+WindowView SampleStore::view(NodeId node, std::size_t offset,
+                             std::size_t n) const noexcept {
+  WindowView w;
+  if (n == 0) return w;
+  const std::uint64_t head = cursors_[node].head;
+  const std::size_t held = size(node);
+  // Physical index of the oldest requested sample.
+  const std::size_t start = static_cast<std::size_t>((head - held + offset) & mask_);
+  const std::size_t first_n = std::min(n, capacity_ - start);
+  const std::size_t second_n = n - first_n;
+  const std::size_t b = base(node);
+
+  w.timestamps.first = {timestamps_.data() + b + start, first_n};
+  w.timestamps.second = {timestamps_.data() + b, second_n};
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    w.channels[c].first = {columns_[c].data() + b + start, first_n};
+    w.channels[c].second = {columns_[c].data() + b, second_n};
+  }
+  return w;
+}
+
+WindowView SampleStore::window(NodeId node, Timestamp since) const noexcept {
+  const std::size_t held = size(node);
+  const WindowView all = view(node, 0, held);
+  // Timestamps are non-decreasing in logical order; binary search the split
+  // span for the first sample at or after `since`.
+  std::size_t lo = 0, hi = held;
+  while (lo < hi) {
+    const std::size_t mid = lo + (hi - lo) / 2;
+    if (all.timestamps[mid] < since) lo = mid + 1;
+    else hi = mid;
+  }
+  return view(node, lo, held - lo);
+}
+
+WindowView SampleStore::latest(NodeId node, std::size_t n) const noexcept {
+  const std::size_t held = size(node);
+  if (n > held) n = held;
+  return view(node, held - n, n);
+}
+
+WindowView SampleStore::since_sequence(NodeId node, std::uint64_t seq) const noexcept {
+  const std::size_t held = size(node);
+  const std::uint64_t oldest = cursors_[node].head - held;
+  const std::size_t offset =
+      seq <= oldest ? 0 : static_cast<std::size_t>(std::min<std::uint64_t>(seq - oldest, held));
+  return view(node, offset, held - offset);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,83 @@
+#include "meat_quality/core/simd.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <optional>
+
+namespace meat_quality {
+namespace {
+
+std::atomic<SimdLevel>& active() noexcept {
+  static std::atomic<SimdLevel> level{detect_simd_level()};
+  return level;
+}
+
+}  // namespace
+
+std::string_view simd_level_name(SimdLevel level) noexcept {
+  switch (level) {
+    case SimdLevel::kScalar: return "scalar";
+    case SimdLevel::kAvx2: return "avx2";
+    case SimdLevel::kAvx512: return "avx512";
+    case SimdLevel::kNeon: return "neon";
+  }
+  return "unknown";
+}
+
+bool simd_level_supported(SimdLevel level) noexcept {
+  switch (level) {
+    case SimdLevel::kScalar:
+      return true;
+    case SimdLevel::kAvx2:
+#if defined(MEAT_QUALITY_HAVE_AVX2)
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+      return false;
+#endif
+    case SimdLevel::kAvx512:
+#if defined(MEAT_QUALITY_HAVE_AVX512)
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512dq");
+#else
+      return false;
+#endif
+    case SimdLevel::kNeon:
+#if defined(MEAT_QUALITY_HAVE_NEON)
+      return true;  // Advanced SIMD is mandatory on AArch64.
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+SimdLevel detect_simd_level() noexcept {
+  // Without an override every level is allowed; with one, only that level
+  // and the x86 levels below it.
+  std::optional<SimdLevel> cap;
+  if (const char* env = std::getenv("MEAT_QUALITY_SIMD")) {
+    for (SimdLevel l : {SimdLevel::kScalar, SimdLevel::kAvx2,
+                        SimdLevel::kAvx512, SimdLevel::kNeon}) {
+      if (std::string_view(env) == simd_level_name(l)) cap = l;
+    }
+  }
+  const auto allowed = [&cap](SimdLevel l) {
+    return !cap || *cap == l || (*cap == SimdLevel::kAvx512 && l == SimdLevel::kAvx2);
+  };
+  for (SimdLevel l : {SimdLevel::kAvx512, SimdLevel::kAvx2, SimdLevel::kNeon}) {
+    if (allowed(l) && simd_level_supported(l)) return l;
+  }
+  return SimdLevel::kScalar;
+}
+
+SimdLevel active_simd_level() noexcept {
+  return active().load(std::memory_order_relaxed);
+}
+
+bool set_simd_level(SimdLevel level) noexcept {
+  if (!simd_level_supported(level)) return false;
+  active().store(level, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace meat_quality
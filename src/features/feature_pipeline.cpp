@@ -0,0 +1,57 @@
+#include "meat_quality/features/feature_pipeline.hpp"
+
+#include "fused_kernels.hpp"
+
+namespace meat_quality {
+namespace detail {
+namespace {
+
+float ewma_scalar(const float* x, std::size_t n, float alpha, float state) {
+  return ewma_tail(x, n, alpha, state);
+}
+
+}  // namespace
+
+// Two lanes fit the baseline 128-bit registers of both x86-64 and AArch64.
+const FusedKernelTable kScalarFusedKernels = make_fused_kernels<2, ewma_scalar>();
+
+}  // namespace detail
+
+namespace {
+
+const detail::FusedKernelTable& fused_table() noexcept {
+  switch (active_simd_level()) {
+#if defined(MEAT_QUALITY_HAVE_AVX2)
+    case SimdLevel::kAvx2: return detail::kAvx2FusedKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX512)
+    case SimdLevel::kAvx512: return detail::kAvx512FusedKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_NEON)
+    case SimdLevel::kNeon: return detail::kNeonFusedKernels;
+#endif
+    default: return detail::kScalarFusedKernels;
+  }
+}
+
+}  // namespace
+
+template <>
+WindowFeatures extract_features_fixed<kGasOnlySku>(const WindowView& window,
+                                                   float ewma_alpha) noexcept {
+  return fused_table().gas_only(window, ewma_alpha);
+}
+
+template <>
+WindowFeatures extract_features_fixed<kGasPhSku>(const WindowView& window,
+                                                 float ewma_alpha) noexcept {
+  return fused_table().gas_ph(window, ewma_alpha);
+}
+
+template <>
+WindowFeatures extract_features_fixed<kFullSku>(const WindowView& window,
+                                                float ewma_alpha) noexcept {
+  return fused_table().full(window, ewma_alpha);
+}
+
+}  // namespace meat_quality
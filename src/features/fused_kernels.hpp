@@ -0,0 +1,276 @@
+#pragma once
+
+// Fused all-channels-in-one-pass feature kernels for the fixed channel sets
+// of feature_pipeline.hpp. The kernel is a template over the channel set and
+// the vector width, written with GCC/Clang vector extensions so that each
+// per-ISA translation unit that includes this header instantiates it with
+// its own target flags (xmm, ymm, zmm or NEON registers).
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "kernels.hpp"
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/features/feature_pipeline.hpp"
+
+namespace meat_quality::detail {
+
+using FusedExtractFn = WindowFeatures (*)(const WindowView& window, float ewma_alpha);
+
+struct FusedKernelTable {
+  FusedExtractFn gas_only;
+  FusedExtractFn gas_ph;
+  FusedExtractFn full;
+};
+
+extern const FusedKernelTable kScalarFusedKernels;
+#if defined(MEAT_QUALITY_HAVE_AVX2)
+extern const FusedKernelTable kAvx2FusedKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX512)
+extern const FusedKernelTable kAvx512FusedKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_NEON)
+extern const FusedKernelTable kNeonFusedKernels;
+#endif
+
+// Internal linkage for the same reason as the helpers in kernels.hpp: every
+// including translation unit must keep its own, differently compiled copy.
+namespace {
+
+using AccumulateFn = void (*)(const Timestamp* t, const float* x, std::size_t n, Timestamp t0,
+                              float shift, MomentAccumulator& acc);
+using EwmaFn = float (*)(const float* x, std::size_t n, float alpha, float state);
+
+template <ChannelMask Mask>
+constexpr auto channel_indices() noexcept {
+  std::array<std::size_t, std::popcount(static_cast<unsigned>(Mask))> idx{};
+  std::size_t j = 0;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (contains(Mask, static_cast<Channel>(c))) idx[j++] = c;
+  }
+  return idx;
+}
+
+template <int W>
+struct Lanes {
+  typedef double d __attribute__((vector_size(8 * W)));
+  typedef float f __attribute__((vector_size(4 * W)));
+  typedef std::int64_t i __attribute__((vector_size(8 * W)));
+
+  template <typename V, typename T>
+  static V load(const T* p) noexcept {
+    V v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  template <typename V>
+  static auto hsum(V v) noexcept {
+    auto s = v[0];
+    for (int k = 1; k < W; ++k) s += v[k];
+    return s;
+  }
+};
+
+template <ChannelMask Mask, int W>
+struct FusedState {
+  static constexpr auto kIdx = channel_indices<Mask>();
+  static constexpr std::size_t kN = kIdx.size();
+  using L = Lanes<W>;
+
+  typename L::d st{}, stt{};
+  std::array<typename L::d, kN> sx{}, sxx{}, stx{};
+  std::array<typename L::f, kN> mn{}, mx{};
+  std::array<MomentAccumulator, kN> tail{};  // scalar tails and the totals
+  std::array<float, kN> shift{};
+};
+
+template <std::size_t N, typename Fn>
+inline void for_each_index(Fn&& fn) {
+  [&]<std::size_t... J>(std::index_sequence<J...>) {
+    (fn(std::integral_constant<std::size_t, J>{}), ...);
+  }(std::make_index_sequence<N>{});
+}
+
+// Samples converted to seconds per block. The block of converted
+// timestamps stays in L1 while every channel is folded in, so each channel
+// loop only keeps its own five accumulators in registers.
+inline constexpr std::size_t kFusedBlock = 256;
+
+// Adds samples [0, n) of one segment. `x[j]` is the segment of channel
+// kIdx[j]. Time sums and the timestamp conversion are shared by all
+// channels.
+template <ChannelMask Mask, int W>
+inline void fused_accumulate(FusedState<Mask, W>& s, const Timestamp* t,
+                             const std::array<const float*, FusedState<Mask, W>::kN>& x,
+                             std::size_t n, Timestamp t0) noexcept {
+  using S = FusedState<Mask, W>;
+  using L = typename S::L;
+  using VD = typename L::d;
+  using VI = typename L::i;
+  using VF = typename L::f;
+  // Exact int64 -> double for 0 <= v < 2^52: splice v into the mantissa of
+  // 2^52 and subtract 2^52.
+  const VI magic_bits = VI{} + static_cast<std::int64_t>(0x4330000000000000);
+  const VD magic = VD{} + 0x1p52;
+
+  alignas(64) double td[kFusedBlock];
+  const std::size_t vec_end = n - n % W;
+  for (std::size_t b0 = 0; b0 < vec_end; b0 += kFusedBlock) {
+    const std::size_t len = vec_end - b0 < kFusedBlock ? vec_end - b0 : kFusedBlock;
+    for (std::size_t i = 0; i < len; i += W) {
+      const VI ti = L::template load<VI>(t + b0 + i) - t0;
+      const VD v = ((VD)(ti | magic_bits) - magic) * kMicrosToSeconds;
+      s.st += v;
+      s.stt += v * v;
+      std::memcpy(td + i, &v, sizeof(v));
+    }
+    for_each_index<S::kN>([&](auto j) {
+      const float* xj = x[j] + b0;
+      const VD shift = VD{} + static_cast<double>(s.shift[j]);
+      // Two interleaved sets of accumulators halve the add latency chain.
+      VD sx[2] = {s.sx[j], VD{}}, sxx[2] = {s.sxx[j], VD{}}, stx[2] = {s.stx[j], VD{}};
+      VF mn = s.mn[j], mx = s.mx[j];
+      const auto step = [&](std::size_t i, int a) {
+        const VF xf = L::template load<VF>(xj + i);
+        const VD xd = __builtin_convertvector(xf, VD) - shift;
+        const VD tv = L::template load<VD>(td + i);
+        sx[a] += xd;
+        sxx[a] += xd * xd;
+        stx[a] += tv * xd;
+        mn = xf < mn ? xf : mn;
+        mx = xf > mx ? xf : mx;
+      };
+      std::size_t i = 0;
+      for (; i + 2 * W <= len; i += 2 * W) {
+        step(i, 0);
+        step(i + W, 1);
+      }
+      if (i < len) step(i, 0);
+      s.sx[j] = sx[0] + sx[1];
+      s.sxx[j] = sxx[0] + sxx[1];
+      s.stx[j] = stx[0] + stx[1];
+      s.mn[j] = mn;
+      s.mx[j] = mx;
+    });
+  }
+  for_each_index<S::kN>([&](auto j) {
+    accumulate_tail(t + vec_end, x[j] + vec_end, n - vec_end, t0, s.shift[j], s.tail[j]);
+    s.tail[j].n += static_cast<double>(vec_end);
+  });
+}
+
+template <ChannelMask Mask, int W, EwmaFn Ewma>
+WindowFeatures fused_extract(const WindowView& window, float ewma_alpha) {
+  using S = FusedState<Mask, W>;
+  WindowFeatures out;
+  out.channels = Mask;
+  out.samples = static_cast<std::uint32_t>(window.size());
+  if (window.empty()) return out;
+  out.start = window.timestamps.front();
+  out.end = window.timestamps.back();
+
+  S s;
+  for_each_index<S::kN>([&](auto j) {
+    const float first = window.channels[S::kIdx[j]].front();
+    s.shift[j] = first;
+    s.mn[j] = typename S::L::f{} + first;
+    s.mx[j] = s.mn[j];
+    s.tail[j].min = s.tail[j].max = first;
+  });
+
+  const Timestamp t0 = out.start;
+  const auto segment = [&](bool second) {
+    const auto& ts = second ? window.timestamps.second : window.timestamps.first;
+    if (ts.empty()) return;
+    std::array<const float*, S::kN> x;
+    for_each_index<S::kN>([&](auto j) {
+      const auto& ch = window.channels[S::kIdx[j]];
+      x[j] = (second ? ch.second : ch.first).data();
+    });
+    fused_accumulate<Mask, W>(s, ts.data(), x, ts.size(), t0);
+  };
+  segment(false);
+  segment(true);
+
+  using L = typename S::L;
+  const double st = L::hsum(s.st), stt = L::hsum(s.stt);
+  for_each_index<S::kN>([&](auto j) {
+    MomentAccumulator acc = s.tail[j];
+    acc.sum_t += st;
+    acc.sum_tt += stt;
+    acc.sum_x += L::hsum(s.sx[j]);
+    acc.sum_xx += L::hsum(s.sxx[j]);
+    acc.sum_tx += L::hsum(s.stx[j]);
+    const SplitSpan<float>& ch = window.channels[S::kIdx[j]];
+    if (!std::isfinite(acc.sum_x)) {
+      out.values[S::kIdx[j]] = finite_channel_features(window.timestamps, ch, ewma_alpha);
+      return;
+    }
+    for (int k = 0; k < W; ++k) {
+      acc.min = s.mn[j][k] < acc.min ? s.mn[j][k] : acc.min;
+      acc.max = s.mx[j][k] > acc.max ? s.mx[j][k] : acc.max;
+    }
+    // The first sample seeds the EWMA state.
+    float state = Ewma(ch.first.data() + 1, ch.first.size() - 1, ewma_alpha, s.shift[j]);
+    if (!ch.second.empty()) state = Ewma(ch.second.data(), ch.second.size(), ewma_alpha, state);
+    out.values[S::kIdx[j]] = finish_features(acc, s.shift[j], state);
+  });
+  return out;
+}
+
+// Per-channel composition of one ISA's hand-written kernels, for ISAs whose
+// accumulate kernel already saturates the vector units: the channel loop is
+// unrolled and the kernels are called directly, so they inline, but each
+// channel still converts the timestamps itself.
+template <ChannelMask Mask, AccumulateFn Accumulate, EwmaFn Ewma>
+WindowFeatures composed_extract(const WindowView& window, float ewma_alpha) {
+  constexpr auto kIdx = channel_indices<Mask>();
+  WindowFeatures out;
+  out.channels = Mask;
+  out.samples = static_cast<std::uint32_t>(window.size());
+  if (window.empty()) return out;
+  out.start = window.timestamps.front();
+  out.end = window.timestamps.back();
+  const SplitSpan<Timestamp>& t = window.timestamps;
+  for_each_index<kIdx.size()>([&](auto j) {
+    const SplitSpan<float>& x = window.channels[kIdx[j]];
+    const float shift = x.front();
+    MomentAccumulator acc;
+    acc.min = acc.max = shift;
+    Accumulate(t.first.data(), x.first.data(), x.first.size(), out.start, shift, acc);
+    if (!x.second.empty()) {
+      Accumulate(t.second.data(), x.second.data(), x.second.size(), out.start, shift, acc);
+    }
+    if (!std::isfinite(acc.sum_x)) {
+      out.values[kIdx[j]] = finite_channel_features(t, x, ewma_alpha);
+      return;
+    }
+    float state = Ewma(x.first.data() + 1, x.first.size() - 1, ewma_alpha, shift);
+    if (!x.second.empty()) state = Ewma(x.second.data(), x.second.size(), ewma_alpha, state);
+    out.values[kIdx[j]] = finish_features(acc, shift, state);
+  });
+  return out;
+}
+
+template <AccumulateFn Accumulate, EwmaFn Ewma>
+constexpr FusedKernelTable make_composed_kernels() noexcept {
+  return {composed_extract<kGasOnlySku, Accumulate, Ewma>,
+          composed_extract<kGasPhSku, Accumulate, Ewma>,
+          composed_extract<kFullSku, Accumulate, Ewma>};
+}
+
+template <int W, EwmaFn Ewma>
+constexpr FusedKernelTable make_fused_kernels() noexcept {
+  return {fused_extract<kGasOnlySku, W, Ewma>, fused_extract<kGasPhSku, W, Ewma>,
+          fused_extract<kFullSku, W, Ewma>};
+}
+
+}  // namespace
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,290 @@
+#include "meat_quality/features/incremental_features.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace meat_quality {
+namespace {
+
+constexpr double kDriftFloor = 1e-6;
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+/// Sliding-window extremum: values in the queue are monotonic, so the
+/// front is the window min (or max). Each sample enters and leaves once.
+/// A power-of-two ring that only grows, so the steady state never
+/// allocates.
+template <bool kMin>
+class MonotonicQueue {
+ public:
+  void push(std::uint64_t seq, float v) {
+    if (std::isnan(v)) return;
+    while (size_ != 0 && !better(back().value, v)) --size_;
+    if (size_ == ring_.size()) grow();
+    ring_[(head_ + size_) & (ring_.size() - 1)] = {seq, v};
+    ++size_;
+  }
+
+  /// Drops entries older than `seq`.
+  void expire(std::uint64_t seq) noexcept {
+    while (size_ != 0 && ring_[head_].seq < seq) {
+      head_ = (head_ + 1) & (ring_.size() - 1);
+      --size_;
+    }
+  }
+
+  /// NaN if every sample in the window was NaN.
+  float front() const noexcept {
+    return size_ != 0 ? ring_[head_].value : std::numeric_limits<float>::quiet_NaN();
+  }
+  void clear() noexcept { head_ = size_ = 0; }
+
+ private:
+  struct Entry {
+    std::uint64_t seq;
+    float value;
+  };
+
+  // An older entry stays ahead of a newer value only if strictly better.
+  static bool better(float a, float b) noexcept { return kMin ? a < b : a > b; }
+
+  const Entry& back() const noexcept {
+    return ring_[(head_ + size_ - 1) & (ring_.size() - 1)];
+  }
+
+  void grow() {
+    std::vector<Entry> bigger(ring_.empty() ? 64 : ring_.size() * 2);
+    for (std::size_t i = 0; i < size_; ++i) bigger[i] = ring_[(head_ + i) & (ring_.size() - 1)];
+    ring_ = std::move(bigger);
+    head_ = 0;
+  }
+
+  std::vector<Entry> ring_;
+  std::size_t head_ = 0;
+  std::size_t size_ = 0;
+};
+
+}  // namespace
+
+struct IncrementalFeatureTracker::NodeState {
+  // Moments over the channel's finite readings only, so each channel keeps
+  // its own count and time moments.
+  struct Channel {
+    double n = 0;
+    double mean_t = 0;  // seconds since t_ref
+    double m2_t = 0;
+    double mean = 0;  // mean of x
+    double m2 = 0;    // sum of squared deviations of x
+    double c_tx = 0;  // sum of (t - mean_t)(x - mean_x)
+    float ewma = std::numeric_limits<float>::quiet_NaN();  // until the first finite reading
+    MonotonicQueue<true> min;
+    MonotonicQueue<false> max;
+  };
+
+  bool seeded = false;
+  std::uint64_t next = 0;    // sequence of the first sample not yet added
+  std::uint64_t oldest = 0;  // sequence of the oldest sample in the window
+  std::uint64_t evictions = 0;  // since the last rebuild
+  Timestamp t_ref = 0;
+  Timestamp start = 0;
+  Timestamp end = 0;
+  std::uint64_t n = 0;  // samples in the window, finite or not
+  std::array<Channel, kChannelCount> ch;
+};
+
+IncrementalFeatureTracker::IncrementalFeatureTracker(const SampleStore& store,
+                                                     Timestamp window,
+                                                     FeatureOptions options,
+                                                     FeatureMode mode)
+    : store_(store),
+      window_(window),
+      options_(options),
+      mode_(mode),
+      nodes_(store.node_count()) {}
+
+IncrementalFeatureTracker::~IncrementalFeatureTracker() = default;
+
+void IncrementalFeatureTracker::reset(NodeId node) noexcept { nodes_[node].seeded = false; }
+
+WindowFeatures IncrementalFeatureTracker::update(NodeId node) noexcept {
+  switch (mode_) {
+    case FeatureMode::kFull:
+      return extract_features(store_.window(node, store_.newest(node) - window_), options_);
+    case FeatureMode::kIncremental:
+      return incremental(node);
+    case FeatureMode::kValidate: {
+      const WindowFeatures inc = incremental(node);
+      const WindowFeatures full =
+          extract_features(store_.window(node, store_.newest(node) - window_), options_);
+      record_drift(node, inc, full);
+      return inc;
+    }
+  }
+  return {};
+}
+
+WindowFeatures IncrementalFeatureTracker::incremental(NodeId node) noexcept {
+  NodeState& s = nodes_[node];
+  const std::uint64_t head = store_.total_pushed(node);
+  // Rebuild when the outgoing samples are gone from the store or the
+  // periodic resync is due.
+  if (!s.seeded || s.oldest < store_.oldest_sequence(node) ||
+      (resync_interval_ != 0 && s.evictions >= resync_interval_)) {
+    rebuild(node, s);
+    return snapshot(s);
+  }
+  if (s.next == head) return snapshot(s);
+
+  const WindowView fresh = store_.since_sequence(node, s.next);
+  for (std::size_t i = 0; i < fresh.size(); ++i) {
+    add(s, s.next + i, fresh.timestamps[i], fresh, i);
+  }
+  s.next = head;
+
+  const Timestamp cutoff = store_.newest(node) - window_;
+  const WindowView old = store_.since_sequence(node, s.oldest);
+  std::size_t k = 0;
+  while (k < old.size() && old.timestamps[k] < cutoff) {
+    remove(s, old.timestamps[k], old, k);
+    ++k;
+  }
+  s.oldest += k;
+  s.evictions += k;
+  if (k != 0 && k < old.size()) s.start = old.timestamps[k];
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(options_.channels, static_cast<Channel>(c))) continue;
+    s.ch[c].min.expire(s.oldest);
+    s.ch[c].max.expire(s.oldest);
+  }
+  return snapshot(s);
+}
+
+void IncrementalFeatureTracker::rebuild(NodeId node, NodeState& s) noexcept {
+  ++rebuilds_;
+  // Field by field rather than `s = {}`, which would free the queue rings.
+  s.seeded = true;
+  s.next = store_.total_pushed(node);
+  s.oldest = s.next;
+  s.evictions = 0;
+  s.start = s.end = 0;
+  s.n = 0;
+  for (NodeState::Channel& ch : s.ch) {
+    ch.n = ch.mean_t = ch.m2_t = 0;
+    ch.mean = ch.m2 = ch.c_tx = 0;
+    ch.ewma = std::numeric_limits<float>::quiet_NaN();
+    ch.min.clear();
+    ch.max.clear();
+  }
+  if (s.next == 0) return;
+  const WindowView w = store_.window(node, store_.newest(node) - window_);
+  s.oldest = s.next - w.size();
+  s.t_ref = w.timestamps.front();
+  s.start = s.t_ref;
+  for (std::size_t i = 0; i < w.size(); ++i) add(s, s.oldest + i, w.timestamps[i], w, i);
+}
+
+void IncrementalFeatureTracker::add(NodeState& s, std::uint64_t seq, Timestamp t,
+                                    const WindowView& v, std::size_t i) noexcept {
+  const double td = static_cast<double>(t - s.t_ref) * 1e-6;
+  ++s.n;
+  s.end = t;
+  const float alpha = options_.ewma_alpha;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(options_.channels, static_cast<Channel>(c))) continue;
+    NodeState::Channel& ch = s.ch[c];
+    const float x = v.channels[c][i];
+    // Skipped here and in remove() alike, so a NaN reading cannot stick in
+    // the running sums after it leaves the window.
+    if (!std::isfinite(x)) continue;
+    ch.n += 1;
+    const double dt = td - ch.mean_t;
+    ch.mean_t += dt / ch.n;
+    ch.m2_t += dt * (td - ch.mean_t);
+    const double dx = x - ch.mean;
+    ch.mean += dx / ch.n;
+    ch.m2 += dx * (x - ch.mean);
+    ch.c_tx += dt * (x - ch.mean);
+    // The first finite reading seeds the EWMA.
+    ch.ewma = std::isnan(ch.ewma) ? x : ch.ewma + alpha * (x - ch.ewma);
+    ch.min.push(seq, x);
+    ch.max.push(seq, x);
+  }
+}
+
+void IncrementalFeatureTracker::remove(NodeState& s, Timestamp t, const WindowView& v,
+                                       std::size_t i) noexcept {
+  if (s.n != 0) --s.n;
+  const double td = static_cast<double>(t - s.t_ref) * 1e-6;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(options_.channels, static_cast<Channel>(c))) continue;
+    NodeState::Channel& ch = s.ch[c];
+    const float x = v.channels[c][i];
+    if (!std::isfinite(x)) continue;
+    if (ch.n <= 1) {
+      ch.n = ch.mean_t = ch.m2_t = 0;
+      ch.mean = ch.m2 = ch.c_tx = 0;
+      continue;
+    }
+    // Exact inverse of the Welford step in add().
+    ch.n -= 1;
+    const double dt_new = td - ch.mean_t;
+    ch.mean_t -= dt_new / ch.n;
+    const double dt = td - ch.mean_t;
+    ch.m2_t -= dt * dt_new;
+    const double dx_new = x - ch.mean;
+    ch.mean -= dx_new / ch.n;
+    ch.m2 -= (x - ch.mean) * dx_new;
+    ch.c_tx -= dt * dx_new;
+  }
+}
+
+WindowFeatures IncrementalFeatureTracker::snapshot(const NodeState& s) const noexcept {
+  WindowFeatures out;
+  out.channels = options_.channels;
+  out.samples = static_cast<std::uint32_t>(s.n);
+  if (s.n == 0) return out;
+  out.start = s.start;
+  out.end = s.end;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(options_.channels, static_cast<Channel>(c))) continue;
+    const NodeState::Channel& ch = s.ch[c];
+    ChannelFeatures& f = out.values[c];
+    // A channel with no finite reading in the window has a NaN mean, like
+    // its min and max.
+    f.mean = ch.n != 0 ? static_cast<float>(ch.mean) : std::numeric_limits<float>::quiet_NaN();
+    f.variance = ch.n != 0 ? static_cast<float>(std::max(0.0, ch.m2 / ch.n)) : 0.0f;
+    f.slope = ch.m2_t > 0 ? static_cast<float>(ch.c_tx / ch.m2_t) : 0.0f;
+    f.min = ch.min.front();
+    f.max = ch.max.front();
+    f.ewma = ch.ewma;
+  }
+  return out;
+}
+
+void IncrementalFeatureTracker::record_drift(NodeId node, const WindowFeatures& inc,
+                                             const WindowFeatures& full) noexcept {
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(options_.channels, static_cast<Channel>(c))) continue;
+    const ChannelFeatures& a = inc.values[c];
+    const ChannelFeatures& b = full.values[c];
+    const std::array<float, FeatureDrift::kFields> av = {a.mean, a.variance, a.slope,
+                                                         a.min,  a.max,      a.ewma};
+    const std::array<float, FeatureDrift::kFields> bv = {b.mean, b.variance, b.slope,
+                                                         b.min,  b.max,      b.ewma};
+    for (std::size_t k = 0; k < FeatureDrift::kFields; ++k) {
+      // NaN on one side only is a disagreement, not a comparison that fails.
+      const bool a_nan = std::isnan(av[k]), b_nan = std::isnan(bv[k]);
+      const double abs_err = a_nan || b_nan ? (a_nan == b_nan ? 0.0 : kInfinity)
+                                            : std::fabs(static_cast<double>(av[k]) - bv[k]);
+      const double rel_err = abs_err / std::max(std::fabs(static_cast<double>(bv[k])), kDriftFloor);
+      drift_.max_abs_error[k] = std::max(drift_.max_abs_error[k], abs_err);
+      if (rel_err > drift_.max_rel_error[k]) {
+        drift_.max_rel_error[k] = rel_err;
+        drift_.worst_node = node;
+      }
+    }
+    ++drift_.checks;
+  }
+}
+
+}  // namespace meat_quality
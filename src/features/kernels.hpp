@@ -0,0 +1,116 @@
+#pragma once
+
+// Internal interface between the feature dispatcher and the per-ISA kernel
+// translation units. Each kernel file is compiled with its own target flags
+// and must not be called unless the CPU supports them.
+
+#include <cstddef>
+
+#include "meat_quality/core/sample_store.hpp"
+#include "meat_quality/core/types.hpp"
+#include "meat_quality/features/window_features.hpp"
+
+namespace meat_quality::detail {
+
+/// Partial sums over a window. `x` is shifted by the first sample of the
+/// window and `t` is seconds since the first timestamp, which keeps the
+/// variance and regression sums well conditioned.
+struct MomentAccumulator {
+  double n = 0;
+  double sum_x = 0;
+  double sum_xx = 0;
+  double sum_t = 0;
+  double sum_tt = 0;
+  double sum_tx = 0;
+  float min = 0;
+  float max = 0;
+};
+
+struct FeatureKernelTable {
+  /// Adds `n` samples to `acc`. Requires `t[i] >= t0`. `acc.min`/`acc.max`
+  /// must be seeded with a sample of the window before the first call.
+  void (*accumulate)(const Timestamp* t, const float* x, std::size_t n,
+                     Timestamp t0, float shift, MomentAccumulator& acc);
+  /// Runs the EWMA recurrence over `n` samples starting from `state`.
+  float (*ewma)(const float* x, std::size_t n, float alpha, float state);
+};
+
+extern const FeatureKernelTable kScalarKernels;
+#if defined(MEAT_QUALITY_HAVE_AVX2)
+extern const FeatureKernelTable kAvx2Kernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX512)
+extern const FeatureKernelTable kAvx512Kernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_NEON)
+extern const FeatureKernelTable kNeonKernels;
+#endif
+
+inline constexpr double kMicrosToSeconds = 1e-6;
+
+/// Turns a channel's partial sums into its features. `shift` is the value
+/// the sums were taken relative to; `ewma` the final EWMA state.
+inline ChannelFeatures finish_features(const MomentAccumulator& acc, float shift,
+                                       float ewma) noexcept {
+  const double n = acc.n;
+  const double mean_shifted = acc.sum_x / n;
+  double variance = acc.sum_xx / n - mean_shifted * mean_shifted;
+  if (variance < 0) variance = 0;
+  const double denom = n * acc.sum_tt - acc.sum_t * acc.sum_t;
+  const double slope =
+      denom > 0 ? (n * acc.sum_tx - acc.sum_t * acc.sum_x) / denom : 0.0;
+
+  ChannelFeatures f;
+  f.mean = static_cast<float>(shift + mean_shifted);
+  f.variance = static_cast<float>(variance);
+  f.slope = static_cast<float>(slope);
+  f.min = acc.min;
+  f.max = acc.max;
+  f.ewma = ewma;
+  return f;
+}
+
+/// Features over the finite readings of `x` only, one sample at a time. The
+/// kernels' sums come out non-finite as soon as one reading is, which costs
+/// nothing to check; such a channel is recomputed with this instead. With no
+/// finite reading the mean, min, max and EWMA are NaN and the rest zero,
+/// like IncrementalFeatureTracker.
+ChannelFeatures finite_channel_features(const SplitSpan<Timestamp>& timestamps,
+                                        const SplitSpan<float>& x, float ewma_alpha) noexcept;
+
+/// Blocked EWMA kernels stop once the weight left for older history,
+/// relative to the newest sample, drops below this.
+inline constexpr float kEwmaCutoff = 1e-9f;
+
+// The helpers below are compiled into every kernel file with that file's
+// target flags, so each translation unit must get its own copy: an inline
+// definition shared across units could resolve to the AVX-512 build.
+namespace {
+
+/// Adds the scalar tail `[0, n)` to `acc`; shared by every kernel file.
+inline void accumulate_tail(const Timestamp* t, const float* x, std::size_t n,
+                            Timestamp t0, float shift,
+                            MomentAccumulator& acc) noexcept {
+  for (std::size_t i = 0; i < n; ++i) {
+    const double xd = static_cast<double>(x[i]) - shift;
+    const double td = static_cast<double>(t[i] - t0) * kMicrosToSeconds;
+    acc.sum_x += xd;
+    acc.sum_xx += xd * xd;
+    acc.sum_t += td;
+    acc.sum_tt += td * td;
+    acc.sum_tx += td * xd;
+    acc.min = x[i] < acc.min ? x[i] : acc.min;
+    acc.max = x[i] > acc.max ? x[i] : acc.max;
+  }
+  acc.n += static_cast<double>(n);
+}
+
+inline float ewma_tail(const float* x, std::size_t n, float alpha,
+                       float state) noexcept {
+  for (std::size_t i = 0; i < n; ++i) state += alpha * (x[i] - state);
+  return state;
+}
+
+}  // namespace
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,117 @@
+// Compiled with -mavx2 -mfma; only reached when the CPU reports both.
+
+#include <immintrin.h>
+
+#include "fused_kernels.hpp"
+#include "kernels.hpp"
+
+namespace meat_quality::detail {
+namespace {
+
+// Exact int64 -> double for 0 <= v < 2^52: splice v into the mantissa of
+// 2^52 and subtract 2^52. Window-relative timestamps are far below that.
+inline __m256d small_i64_to_pd(__m256i v) noexcept {
+  const __m256d magic = _mm256_set1_pd(0x1p52);
+  return _mm256_sub_pd(
+      _mm256_castsi256_pd(_mm256_or_si256(v, _mm256_castpd_si256(magic))),
+      magic);
+}
+
+inline double hsum(__m256d v) noexcept {
+  const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+inline float hsum(__m256 v) noexcept {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_add_ss(s, _mm_movehdup_ps(s)));
+}
+
+inline float hmin(__m256 v) noexcept {
+  __m128 s = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_min_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_min_ss(s, _mm_movehdup_ps(s)));
+}
+
+inline float hmax(__m256 v) noexcept {
+  __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_max_ss(s, _mm_movehdup_ps(s)));
+}
+
+void accumulate_avx2(const Timestamp* t, const float* x, std::size_t n,
+                     Timestamp t0, float shift, MomentAccumulator& acc) {
+  const __m256d vshift = _mm256_set1_pd(shift);
+  const __m256d vscale = _mm256_set1_pd(kMicrosToSeconds);
+  const __m256i vt0 = _mm256_set1_epi64x(t0);
+  __m256d sx = _mm256_setzero_pd(), sxx = _mm256_setzero_pd();
+  __m256d st = _mm256_setzero_pd(), stt = _mm256_setzero_pd();
+  __m256d stx = _mm256_setzero_pd();
+  __m256 vmin = _mm256_set1_ps(acc.min), vmax = _mm256_set1_ps(acc.max);
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 xv = _mm256_loadu_ps(x + i);
+    vmin = _mm256_min_ps(vmin, xv);
+    vmax = _mm256_max_ps(vmax, xv);
+    for (int h = 0; h < 2; ++h) {
+      const __m128 xh = h == 0 ? _mm256_castps256_ps128(xv) : _mm256_extractf128_ps(xv, 1);
+      const __m256d xd = _mm256_sub_pd(_mm256_cvtps_pd(xh), vshift);
+      const __m256i ti = _mm256_sub_epi64(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + i + 4 * h)), vt0);
+      const __m256d td = _mm256_mul_pd(small_i64_to_pd(ti), vscale);
+      sx = _mm256_add_pd(sx, xd);
+      sxx = _mm256_fmadd_pd(xd, xd, sxx);
+      st = _mm256_add_pd(st, td);
+      stt = _mm256_fmadd_pd(td, td, stt);
+      stx = _mm256_fmadd_pd(td, xd, stx);
+    }
+  }
+  acc.sum_x += hsum(sx);
+  acc.sum_xx += hsum(sxx);
+  acc.sum_t += hsum(st);
+  acc.sum_tt += hsum(stt);
+  acc.sum_tx += hsum(stx);
+  acc.min = hmin(vmin);
+  acc.max = hmax(vmax);
+  acc.n += static_cast<double>(i);
+  accumulate_tail(t + i, x + i, n - i, t0, shift, acc);
+}
+
+// s_n = d^n * s_0 + sum_i alpha * d^(n-1-i) * x_i with d = 1 - alpha. The
+// blocks are walked newest first with a running block weight f = d^(8k), so
+// the walk can stop once the remaining history cannot move the result by a
+// float ulp. Besides bounding the work to a few time constants, this keeps f
+// out of the denormal range, where multiplying would stall the pipeline.
+float ewma_avx2(const float* x, std::size_t n, float alpha, float state) {
+  const std::size_t blocks = n / 8;
+  const std::size_t r = n - 8 * blocks;  // oldest samples, not blocked
+  state = ewma_tail(x, r, alpha, state);
+  if (blocks == 0) return state;
+  const float d = 1.0f - alpha;
+  alignas(32) float w[8];
+  float dk = 1.0f;  // d^(7-j), then d^8
+  for (int j = 7; j >= 0; --j) {
+    w[j] = alpha * dk;
+    dk *= d;
+  }
+  const float cutoff = kEwmaCutoff * (1.0f - dk);
+  const __m256 vw = _mm256_load_ps(w);
+  __m256 sum = _mm256_setzero_ps();
+  float f = 1.0f;
+  for (std::size_t b = blocks; b-- > 0;) {
+    sum = _mm256_fmadd_ps(_mm256_mul_ps(vw, _mm256_set1_ps(f)),
+                          _mm256_loadu_ps(x + r + 8 * b), sum);
+    f *= dk;
+    if (f < cutoff) return hsum(sum);
+  }
+  return f * state + hsum(sum);
+}
+
+}  // namespace
+
+const FeatureKernelTable kAvx2Kernels = {accumulate_avx2, ewma_avx2};
+const FusedKernelTable kAvx2FusedKernels = make_composed_kernels<accumulate_avx2, ewma_avx2>();
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,86 @@
+// Compiled with -mavx512f -mavx512dq; only reached when the CPU reports both.
+
+// GCC 12 reports the intentionally undefined passthrough operands inside its
+// own AVX-512 intrinsics as uninitialized.
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+#include <immintrin.h>
+
+#include "fused_kernels.hpp"
+#include "kernels.hpp"
+
+namespace meat_quality::detail {
+namespace {
+
+void accumulate_avx512(const Timestamp* t, const float* x, std::size_t n,
+                       Timestamp t0, float shift, MomentAccumulator& acc) {
+  const __m512d vshift = _mm512_set1_pd(shift);
+  const __m512d vscale = _mm512_set1_pd(kMicrosToSeconds);
+  const __m512i vt0 = _mm512_set1_epi64(t0);
+  __m512d sx = _mm512_setzero_pd(), sxx = _mm512_setzero_pd();
+  __m512d st = _mm512_setzero_pd(), stt = _mm512_setzero_pd();
+  __m512d stx = _mm512_setzero_pd();
+  __m512 vmin = _mm512_set1_ps(acc.min), vmax = _mm512_set1_ps(acc.max);
+
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512 xv = _mm512_loadu_ps(x + i);
+    vmin = _mm512_min_ps(vmin, xv);
+    vmax = _mm512_max_ps(vmax, xv);
+    for (int h = 0; h < 2; ++h) {
+      const __m256 xh = h == 0 ? _mm512_castps512_ps256(xv)
+                               : _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(xv), 1));
+      const __m512d xd = _mm512_sub_pd(_mm512_cvtps_pd(xh), vshift);
+      const __m512i ti = _mm512_sub_epi64(_mm512_loadu_si512(t + i + 8 * h), vt0);
+      const __m512d td = _mm512_mul_pd(_mm512_cvtepi64_pd(ti), vscale);
+      sx = _mm512_add_pd(sx, xd);
+      sxx = _mm512_fmadd_pd(xd, xd, sxx);
+      st = _mm512_add_pd(st, td);
+      stt = _mm512_fmadd_pd(td, td, stt);
+      stx = _mm512_fmadd_pd(td, xd, stx);
+    }
+  }
+  acc.sum_x += _mm512_reduce_add_pd(sx);
+  acc.sum_xx += _mm512_reduce_add_pd(sxx);
+  acc.sum_t += _mm512_reduce_add_pd(st);
+  acc.sum_tt += _mm512_reduce_add_pd(stt);
+  acc.sum_tx += _mm512_reduce_add_pd(stx);
+  acc.min = _mm512_reduce_min_ps(vmin);
+  acc.max = _mm512_reduce_max_ps(vmax);
+  acc.n += static_cast<double>(i);
+  accumulate_tail(t + i, x + i, n - i, t0, shift, acc);
+}
+
+// Same newest-first block walk as the AVX2 kernel, 16 lanes wide.
+float ewma_avx512(const float* x, std::size_t n, float alpha, float state) {
+  const std::size_t blocks = n / 16;
+  const std::size_t r = n - 16 * blocks;  // oldest samples, not blocked
+  state = ewma_tail(x, r, alpha, state);
+  if (blocks == 0) return state;
+  const float d = 1.0f - alpha;
+  alignas(64) float w[16];
+  float dk = 1.0f;  // d^(15-j), then d^16
+  for (int j = 15; j >= 0; --j) {
+    w[j] = alpha * dk;
+    dk *= d;
+  }
+  const float cutoff = kEwmaCutoff * (1.0f - dk);
+  const __m512 vw = _mm512_load_ps(w);
+  __m512 sum = _mm512_setzero_ps();
+  float f = 1.0f;
+  for (std::size_t b = blocks; b-- > 0;) {
+    sum = _mm512_fmadd_ps(_mm512_mul_ps(vw, _mm512_set1_ps(f)),
+                          _mm512_loadu_ps(x + r + 16 * b), sum);
+    f *= dk;
+    if (f < cutoff) return _mm512_reduce_add_ps(sum);
+  }
+  return f * state + _mm512_reduce_add_ps(sum);
+}
+
+}  // namespace
+
+const FeatureKernelTable kAvx512Kernels = {accumulate_avx512, ewma_avx512};
+const FusedKernelTable kAvx512FusedKernels = make_composed_kernels<accumulate_avx512, ewma_avx512>();
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,79 @@
+// AArch64 Advanced SIMD kernels; NEON is part of the base architecture.
+
+#include <arm_neon.h>
+
+#include "fused_kernels.hpp"
+#include "kernels.hpp"
+
+namespace meat_quality::detail {
+namespace {
+
+void accumulate_neon(const Timestamp* t, const float* x, std::size_t n,
+                     Timestamp t0, float shift, MomentAccumulator& acc) {
+  const float64x2_t vshift = vdupq_n_f64(shift);
+  const float64x2_t vscale = vdupq_n_f64(kMicrosToSeconds);
+  const int64x2_t vt0 = vdupq_n_s64(t0);
+  float64x2_t sx = vdupq_n_f64(0), sxx = vdupq_n_f64(0);
+  float64x2_t st = vdupq_n_f64(0), stt = vdupq_n_f64(0);
+  float64x2_t stx = vdupq_n_f64(0);
+  float32x4_t vmin = vdupq_n_f32(acc.min), vmax = vdupq_n_f32(acc.max);
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t xv = vld1q_f32(x + i);
+    vmin = vminq_f32(vmin, xv);
+    vmax = vmaxq_f32(vmax, xv);
+    const float64x2_t xd[2] = {vsubq_f64(vcvt_f64_f32(vget_low_f32(xv)), vshift),
+                               vsubq_f64(vcvt_high_f64_f32(xv), vshift)};
+    for (int h = 0; h < 2; ++h) {
+      const int64x2_t ti = vsubq_s64(vld1q_s64(t + i + 2 * h), vt0);
+      const float64x2_t td = vmulq_f64(vcvtq_f64_s64(ti), vscale);
+      sx = vaddq_f64(sx, xd[h]);
+      sxx = vfmaq_f64(sxx, xd[h], xd[h]);
+      st = vaddq_f64(st, td);
+      stt = vfmaq_f64(stt, td, td);
+      stx = vfmaq_f64(stx, td, xd[h]);
+    }
+  }
+  acc.sum_x += vaddvq_f64(sx);
+  acc.sum_xx += vaddvq_f64(sxx);
+  acc.sum_t += vaddvq_f64(st);
+  acc.sum_tt += vaddvq_f64(stt);
+  acc.sum_tx += vaddvq_f64(stx);
+  acc.min = vminvq_f32(vmin);
+  acc.max = vmaxvq_f32(vmax);
+  acc.n += static_cast<double>(i);
+  accumulate_tail(t + i, x + i, n - i, t0, shift, acc);
+}
+
+// Same newest-first block walk as the AVX2 kernel, 4 lanes wide.
+float ewma_neon(const float* x, std::size_t n, float alpha, float state) {
+  const std::size_t blocks = n / 4;
+  const std::size_t r = n - 4 * blocks;  // oldest samples, not blocked
+  state = ewma_tail(x, r, alpha, state);
+  if (blocks == 0) return state;
+  const float d = 1.0f - alpha;
+  float w[4];
+  float dk = 1.0f;  // d^(3-j), then d^4
+  for (int j = 3; j >= 0; --j) {
+    w[j] = alpha * dk;
+    dk *= d;
+  }
+  const float cutoff = kEwmaCutoff * (1.0f - dk);
+  const float32x4_t vw = vld1q_f32(w);
+  float32x4_t sum = vdupq_n_f32(0);
+  float f = 1.0f;
+  for (std::size_t b = blocks; b-- > 0;) {
+    sum = vfmaq_f32(sum, vmulq_n_f32(vw, f), vld1q_f32(x + r + 4 * b));
+    f *= dk;
+    if (f < cutoff) return vaddvq_f32(sum);
+  }
+  return f * state + vaddvq_f32(sum);
+}
+
+}  // namespace
+
+const FeatureKernelTable kNeonKernels = {accumulate_neon, ewma_neon};
+const FusedKernelTable kNeonFusedKernels = make_composed_kernels<accumulate_neon, ewma_neon>();
+
+}  // namespace meat_quality::detail
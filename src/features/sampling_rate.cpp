@@ -0,0 +1,73 @@
+#include "meat_quality/features/sampling_rate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace meat_quality {
+
+SamplingRateController::SamplingRateController(std::size_t node_count,
+                                               SamplingRateOptions options)
+    : options_(options),
+      node_count_(node_count),
+      nodes_(node_count),
+      published_(new std::atomic<std::uint32_t>[node_count]),
+      hinted_(new std::atomic<std::uint32_t>[node_count]) {
+  if (options_.min_interval_ms == 0 || options_.max_interval_ms < options_.min_interval_ms) {
+    throw std::invalid_argument("SamplingRateController: bad interval range");
+  }
+  for (std::size_t n = 0; n < node_count_; ++n) {
+    nodes_[n].interval_ms = options_.min_interval_ms;
+    published_[n].store(options_.min_interval_ms, std::memory_order_relaxed);
+    hinted_[n].store(options_.min_interval_ms, std::memory_order_relaxed);
+  }
+}
+
+std::uint32_t SamplingRateController::update(NodeId node,
+                                             const WindowFeatures& features) noexcept {
+  if (node >= node_count_) return options_.min_interval_ms;
+  NodeState& s = nodes_[node];
+  ++stats_.decisions;
+
+  // Worst channel, as a share of its threshold: the trend-projected level
+  // decides how close the node is, the window's spread how noisy it is.
+  const float horizon_s = static_cast<float>(options_.horizon) * 1e-6f;
+  bool approaching = false;
+  bool calm = features.samples >= options_.min_samples;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    const float limit = options_.spoilage[c];
+    if ((features.channels & (1u << c)) == 0 || !std::isfinite(limit) || limit <= 0.0f) continue;
+    const ChannelFeatures& f = features.values[c];
+    const float projected = f.ewma + std::max(f.slope, 0.0f) * horizon_s;
+    if (projected >= options_.approach * limit) approaching = true;
+    if (projected >= options_.calm * limit ||
+        std::sqrt(std::max(f.variance, 0.0f)) > options_.max_noise * limit) {
+      calm = false;
+    }
+  }
+
+  if (approaching) {
+    if (s.interval_ms != options_.min_interval_ms) ++stats_.speedups;
+    s.interval_ms = options_.min_interval_ms;
+    s.stable = 0;
+  } else if (calm) {
+    if (++s.stable >= options_.patience && s.interval_ms < options_.max_interval_ms) {
+      s.interval_ms = std::min(options_.max_interval_ms, s.interval_ms * 2);
+      s.stable = 0;
+      ++stats_.slowdowns;
+    }
+  } else {
+    s.stable = 0;  // hold the current rate
+  }
+  published_[node].store(s.interval_ms, std::memory_order_relaxed);
+  return s.interval_ms;
+}
+
+double SamplingRateController::volume_fraction() const noexcept {
+  if (nodes_.empty()) return 1.0;
+  double sum = 0;
+  for (const NodeState& s : nodes_) sum += double(options_.min_interval_ms) / s.interval_ms;
+  return sum / double(nodes_.size());
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,149 @@
+#include "meat_quality/features/spoilage_alert.hpp"
+
+#include <cmath>
+#include <utility>
+
+#include "meat_quality/util/numa.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Samples taken off the lane per wake-up; whatever is ready, never waited
+// for.
+constexpr std::size_t kLaneBatch = 64;
+
+// Longest the idle lane thread sleeps before rechecking for stop().
+constexpr std::chrono::microseconds kLaneIdle{10'000};
+
+// Only channels with a rule are worth tracking.
+FeatureOptions tracked_features(const AlertOptions& o) noexcept {
+  FeatureOptions f;
+  f.ewma_alpha = o.ewma_alpha;
+  f.channels = 0;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (std::isfinite(o.limit[c]) || std::isfinite(o.max_rise[c])) {
+      f.channels |= mask_of(static_cast<Channel>(c));
+    }
+  }
+  return f;
+}
+
+}  // namespace
+
+AlertEvaluator::AlertEvaluator(std::size_t node_count, AlertOptions options)
+    : options_(options),
+      store_(node_count, options.history),
+      tracker_(store_, options.window, tracked_features(options)),
+      nodes_(node_count) {}
+
+void AlertEvaluator::reset(NodeId node) noexcept {
+  if (node >= nodes_.size()) return;
+  store_.clear(node);
+  tracker_.reset(node);
+  nodes_[node] = NodeState{};
+}
+
+std::size_t AlertEvaluator::update(NodeId node, const SensorSample& sample,
+                                   std::span<SpoilageAlert, kMaxAlertsPerSample> out) noexcept {
+  if (node >= nodes_.size()) return 0;
+  if (store_.total_pushed(node) != 0 && sample.timestamp <= store_.newest(node)) return 0;
+  store_.push(node, sample);
+  const WindowFeatures window = tracker_.update(node);
+  NodeState& s = nodes_[node];
+
+  std::size_t n = 0;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(window.channels, static_cast<Channel>(c))) continue;
+    const float v = sample.values[c];
+    if (!std::isfinite(v)) continue;
+    ChannelState& ch = s.channels[c];
+    const ChannelFeatures& f = window.values[c];
+    const float rise = f.slope * 60.0f;
+
+    const float limit = options_.limit[c];
+    ch.over = v >= limit ? ch.over + 1 : 0;
+    if (f.ewma < options_.rearm * limit) ch.limit_raised = false;
+    if (!ch.limit_raised && ch.over >= options_.confirm) {
+      ch.limit_raised = true;
+      out[n++] = {node, static_cast<Channel>(c), AlertKind::kLimit, v, f.ewma, rise,
+                  sample.timestamp};
+    }
+
+    const float max_rise = options_.max_rise[c];
+    if (rise < options_.rearm * max_rise) ch.rise_raised = false;
+    if (!ch.rise_raised && window.samples >= options_.min_samples && rise >= max_rise) {
+      ch.rise_raised = true;
+      out[n++] = {node, static_cast<Channel>(c), AlertKind::kRise, v, f.ewma, rise,
+                  sample.timestamp};
+    }
+  }
+  return n;
+}
+
+AlertLane::AlertLane(AlertSink sink, AlertLaneOptions options)
+    : sink_(std::move(sink)),
+      options_(std::move(options)),
+      evaluator_(options_.node_count, options_.alerts),
+      queue_(options_.capacity, Backpressure::kDropOldest) {}
+
+AlertLane::~AlertLane() { stop(); }
+
+void AlertLane::start() {
+  if (thread_.joinable() || queue_.closed()) return;
+  thread_ = std::thread([this] { run(); });
+}
+
+void AlertLane::stop() {
+  queue_.close();
+  if (thread_.joinable()) thread_.join();
+}
+
+AlertLaneStats AlertLane::stats() const noexcept {
+  AlertLaneStats s;
+  s.samples = samples_.load(std::memory_order_relaxed);
+  s.dropped = queue_.stats().dropped;
+  s.alerts = alerts_.load(std::memory_order_relaxed);
+  s.late = late_.load(std::memory_order_relaxed);
+  return s;
+}
+
+void AlertLane::run() {
+  if (!options_.cpus.empty()) pin_current_thread(options_.cpus);
+  const auto budget_ns = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(options_.budget).count());
+  Item batch[kLaneBatch];
+  std::array<SpoilageAlert, AlertEvaluator::kMaxAlertsPerSample> raised;
+  for (;;) {
+    const std::size_t n = queue_.pop_batch(batch, kLaneBatch, kLaneIdle);
+    if (n == 0) {
+      if (queue_.closed() && queue_.size_approx() == 0) break;
+      continue;
+    }
+    if (options_.registry != nullptr) {
+      // Released before evaluation, so a slow sink does not hold up updates.
+      const NodeRegistry::ReadGuard snapshot = options_.registry->read();
+      for (std::size_t i = 0; i < n; ++i) {
+        IngestRecord& rec = batch[i].record;
+        if (const NodeRecord* node = snapshot->find(rec.node)) node->calibration.apply(rec.sample);
+      }
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      const IngestRecord& rec = batch[i].record;
+      const std::size_t k = evaluator_.update(rec.node, rec.sample, raised);
+      telemetry::record(telemetry::Stage::kAlertLane, telemetry::now_ns() - batch[i].received_ns);
+      for (std::size_t a = 0; a < k; ++a) {
+        sink_(raised[a]);
+        const std::uint64_t latency = telemetry::now_ns() - batch[i].received_ns;
+        telemetry::record(telemetry::Stage::kAlert, latency);
+        if (latency > budget_ns) late_.fetch_add(1, std::memory_order_relaxed);
+      }
+      if (k != 0) {
+        alerts_.fetch_add(k, std::memory_order_relaxed);
+        telemetry::add(telemetry::Counter::kAlerts, k);
+      }
+    }
+    samples_.fetch_add(n, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace meat_quality
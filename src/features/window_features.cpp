@@ -0,0 +1,119 @@
+#include "meat_quality/features/window_features.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include "kernels.hpp"
+
+namespace meat_quality {
+namespace detail {
+namespace {
+
+void accumulate_scalar(const Timestamp* t, const float* x, std::size_t n,
+                       Timestamp t0, float shift, MomentAccumulator& acc) {
+  accumulate_tail(t, x, n, t0, shift, acc);
+}
+
+float ewma_scalar(const float* x, std::size_t n, float alpha, float state) {
+  return ewma_tail(x, n, alpha, state);
+}
+
+}  // namespace
+
+const FeatureKernelTable kScalarKernels = {accumulate_scalar, ewma_scalar};
+
+ChannelFeatures finite_channel_features(const SplitSpan<Timestamp>& timestamps,
+                                        const SplitSpan<float>& x, float ewma_alpha) noexcept {
+  const Timestamp t0 = timestamps.front();
+  MomentAccumulator acc;
+  float shift = 0.0f;
+  float state = 0.0f;
+  const auto fold = [&](const Timestamp* t, const float* v, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!std::isfinite(v[i])) continue;
+      // The first finite reading is the shift and seeds the EWMA.
+      if (acc.n == 0) {
+        shift = state = acc.min = acc.max = v[i];
+      } else {
+        state += ewma_alpha * (v[i] - state);
+      }
+      accumulate_tail(t + i, v + i, 1, t0, shift, acc);
+    }
+  };
+  fold(timestamps.first.data(), x.first.data(), x.first.size());
+  fold(timestamps.second.data(), x.second.data(), x.second.size());
+  if (acc.n == 0) {
+    constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+    return {kNaN, 0.0f, 0.0f, kNaN, kNaN, kNaN};
+  }
+  return finish_features(acc, shift, state);
+}
+
+}  // namespace detail
+
+namespace {
+
+const detail::FeatureKernelTable* table_for(SimdLevel level) noexcept {
+  switch (level) {
+#if defined(MEAT_QUALITY_HAVE_AVX2)
+    case SimdLevel::kAvx2: return &detail::kAvx2Kernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX512)
+    case SimdLevel::kAvx512: return &detail::kAvx512Kernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_NEON)
+    case SimdLevel::kNeon: return &detail::kNeonKernels;
+#endif
+    default: return &detail::kScalarKernels;
+  }
+}
+
+}  // namespace
+
+ChannelFeatures compute_channel_features(const SplitSpan<Timestamp>& timestamps,
+                                         const SplitSpan<float>& x,
+                                         float ewma_alpha) noexcept {
+  if (x.empty()) return {};
+  const detail::FeatureKernelTable& k = *table_for(active_simd_level());
+
+  const Timestamp t0 = timestamps.front();
+  const float shift = x.front();
+  detail::MomentAccumulator acc;
+  acc.min = acc.max = shift;
+  k.accumulate(timestamps.first.data(), x.first.data(), x.first.size(), t0,
+               shift, acc);
+  if (!x.second.empty()) {
+    k.accumulate(timestamps.second.data(), x.second.data(), x.second.size(),
+                 t0, shift, acc);
+  }
+  if (!std::isfinite(acc.sum_x)) {
+    return detail::finite_channel_features(timestamps, x, ewma_alpha);
+  }
+
+  // The first sample seeds the EWMA state.
+  float state = k.ewma(x.first.data() + 1, x.first.size() - 1, ewma_alpha, shift);
+  if (!x.second.empty()) {
+    state = k.ewma(x.second.data(), x.second.size(), ewma_alpha, state);
+  }
+
+  return detail::finish_features(acc, shift, state);
+}
+
+WindowFeatures extract_features(const WindowView& window,
+                                const FeatureOptions& options) noexcept {
+  WindowFeatures out;
+  out.channels = options.channels;
+  out.samples = static_cast<std::uint32_t>(window.size());
+  if (window.empty()) return out;
+  out.start = window.timestamps.front();
+  out.end = window.timestamps.back();
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(options.channels, static_cast<Channel>(c))) continue;
+    out.values[c] = compute_channel_features(window.timestamps,
+                                             window.channels[c],
+                                             options.ewma_alpha);
+  }
+  return out;
+}
+
+}  // namespace meat_quality
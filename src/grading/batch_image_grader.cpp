@@ -0,0 +1,120 @@
+#include "meat_quality/grading/batch_image_grader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace meat_quality {
+
+BatchImageGrader::BatchImageGrader(const ImageAccelBackend& backend, BatchImageOptions options)
+    : backend_(backend), options_(options) {
+  if (options_.batch == 0) throw std::invalid_argument("BatchImageGrader: zero batch size");
+  const MarblingOptions& m = options_.marbling;
+  const GradingOptions& g = options_.grading;
+  params_ = {m.fat_min_l, m.fat_max_a, m.lean_min_a, g.a_min, g.a_max,
+             std::max(1u, g.redness_bins)};
+  char error[256] = "unknown error";
+  ctx_ = backend_.table().create(options_.device, error, sizeof error);
+  if (ctx_ == nullptr) {
+    throw std::runtime_error("BatchImageGrader: " + std::string(backend_.name()) +
+                             " backend cannot open device " + std::to_string(options_.device) +
+                             ": " + error);
+  }
+  for (Slot& s : slots_) {
+    s.jobs.resize(options_.batch);
+    s.images.resize(options_.batch);
+    s.rgb.resize(options_.batch);
+    s.classes.resize(options_.batch);
+    s.histograms.resize(options_.batch * params_.redness_bins);
+  }
+}
+
+BatchImageGrader::~BatchImageGrader() {
+  const mq_image_accel& t = backend_.table();
+  for (Slot& s : slots_) {
+    // The device may still be writing into the buffers.
+    if (s.ticket >= 0) t.wait(ctx_, s.ticket);
+    for (HostBuffer& b : s.rgb) t.free_host(ctx_, b.data);
+    for (HostBuffer& b : s.classes) t.free_host(ctx_, b.data);
+  }
+  t.destroy(ctx_);
+}
+
+void BatchImageGrader::reserve(HostBuffer& buffer, std::size_t bytes) {
+  if (buffer.bytes >= bytes) return;
+  const mq_image_accel& t = backend_.table();
+  t.free_host(ctx_, buffer.data);
+  buffer = {};
+  buffer.data = t.alloc_host(ctx_, bytes);
+  if (buffer.data == nullptr) throw std::runtime_error("BatchImageGrader: out of pinned memory");
+  buffer.bytes = bytes;
+}
+
+void BatchImageGrader::grade(std::span<const ImageView> images, std::span<ImageGrade> out) {
+  if (out.size() != images.size()) {
+    throw std::invalid_argument("BatchImageGrader: result span size mismatch");
+  }
+  for (const ImageView& v : images) {
+    if (v.format != PixelFormat::kRgb8) {
+      throw std::invalid_argument("BatchImageGrader: RGB8 input required");
+    }
+  }
+  // A previous call that threw may have left a submission in flight.
+  for (Slot& s : slots_) {
+    if (s.ticket >= 0) backend_.table().wait(ctx_, std::exchange(s.ticket, -1));
+  }
+  std::size_t k = 0;
+  for (std::size_t first = 0; first < images.size(); first += options_.batch, ++k) {
+    submit(slots_[k % 2], images, first);
+    if (k > 0) finish(slots_[(k - 1) % 2], out);
+  }
+  if (k > 0) finish(slots_[(k - 1) % 2], out);
+}
+
+void BatchImageGrader::submit(Slot& slot, std::span<const ImageView> images, std::size_t first) {
+  const std::size_t n = std::min(options_.batch, images.size() - first);
+  for (std::size_t i = 0; i < n; ++i) {
+    const ImageView& v = images[first + i];
+    const std::size_t row = v.row_bytes();
+    const std::size_t pixels = std::size_t{v.width} * v.height;
+    reserve(slot.rgb[i], std::max<std::size_t>(1, row * v.height));
+    reserve(slot.classes[i], std::max<std::size_t>(1, pixels));
+    auto* staged = static_cast<std::uint8_t*>(slot.rgb[i].data);
+    if (v.contiguous()) {
+      std::memcpy(staged, v.data, row * v.height);
+    } else {
+      for (std::uint32_t y = 0; y < v.height; ++y) std::memcpy(staged + y * row, v.row(y), row);
+    }
+    mq_image_job& job = slot.jobs[i];
+    job = {};
+    job.rgb = staged;
+    job.width = v.width;
+    job.height = v.height;
+    job.stride = row;
+    job.classes = static_cast<std::uint8_t*>(slot.classes[i].data);
+    job.histogram = slot.histograms.data() + i * params_.redness_bins;
+    slot.images[i] = first + i;
+  }
+  slot.ticket = backend_.table().submit(ctx_, slot.jobs.data(), n, &params_);
+  if (slot.ticket < 0) throw std::runtime_error("BatchImageGrader: submit failed");
+  slot.count = n;
+}
+
+void BatchImageGrader::finish(Slot& slot, std::span<ImageGrade> out) {
+  const std::int64_t ticket = std::exchange(slot.ticket, -1);
+  if (backend_.table().wait(ctx_, ticket) != 0) {
+    throw std::runtime_error("BatchImageGrader: device work failed");
+  }
+  for (std::size_t i = 0; i < slot.count; ++i) {
+    const mq_image_job& job = slot.jobs[i];
+    ImageGrade& g = out[slot.images[i]];
+    const std::uint64_t pixels = std::uint64_t{job.width} * job.height;
+    g.color = color_summary({job.histogram, params_.redness_bins}, pixels, job.sum_l, job.sum_a,
+                            job.sum_b, options_.grading);
+    g.marbling = label_marbling(job.classes, job.width, job.height, options_.marbling);
+  }
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,186 @@
+#include "meat_quality/grading/fusion_grader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "meat_quality/telemetry/telemetry.hpp"
+#include "meat_quality/util/arena.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Floor on a stage probability before its log is taken, so one confident
+// zero cannot veto the other stages outright.
+constexpr float kMinProbability = 1e-6f;
+
+using LogProbabilities = std::array<float, kFreshnessClassCount>;
+
+// Top-two probability difference; 1 for a certain prediction, 0 for a tie.
+float margin(const Prediction& p) noexcept {
+  float first = 0.0f, second = 0.0f;
+  for (const float q : p.probabilities) {
+    if (q > first) {
+      second = first;
+      first = q;
+    } else if (q > second) {
+      second = q;
+    }
+  }
+  return first - second;
+}
+
+const FreshnessClassifier& require_gas(const FusionModels& models) {
+  if (models.gas == nullptr) throw std::invalid_argument("FusionGrader: no gas model");
+  return *models.gas;
+}
+
+}  // namespace
+
+std::string_view fusion_stage_name(FusionStage s) noexcept {
+  switch (s) {
+    case FusionStage::kGas: return "gas";
+    case FusionStage::kPh: return "ph";
+    case FusionStage::kImage: return "image";
+  }
+  return "unknown";
+}
+
+ImageFeatureVector to_image_features(const ColorSummary& color) noexcept {
+  return {color.mean_l, color.mean_a, color.mean_b, color.a_p10, color.a_p50, color.a_p90};
+}
+
+ImageModelWeights ImageModelWeights::random(std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  ImageModelWeights w;
+  // Roughly centred on a fresh cut's color, about one unit per 10 L*a*b*.
+  w.input_mean = {45.0f, 20.0f, 10.0f, 10.0f, 20.0f, 30.0f};
+  w.input_scale.fill(0.1f);
+  for (float& x : w.w) x = normal(rng) / std::sqrt(float(kImageFeatureDim));
+  for (float& x : w.b) x = normal(rng) * 0.1f;
+  return w;
+}
+
+Prediction ImageFreshnessModel::predict(const ColorSummary& color) const noexcept {
+  const ImageFeatureVector x = to_image_features(color);
+  float logits[kFreshnessClassCount];
+  std::copy(weights_.b.begin(), weights_.b.end(), logits);
+  for (std::size_t i = 0; i < kImageFeatureDim; ++i) {
+    const float v = (x[i] - weights_.input_mean[i]) * weights_.input_scale[i];
+    const float* row = weights_.w.data() + i * kFreshnessClassCount;
+    for (std::size_t k = 0; k < kFreshnessClassCount; ++k) logits[k] += v * row[k];
+  }
+  Prediction p;
+  softmax(logits, p);
+  return p;
+}
+
+GradingOptions FusionGrader::stage_options(const FusionOptions& options, ChannelMask channels) {
+  GradingOptions g = options.grading;
+  g.features.channels = channels;
+  return g;
+}
+
+FusionGrader::FusionGrader(const SampleStore& store, FusionModels models,
+                           const LabConverter& converter, FusionOptions options)
+    : models_(models),
+      converter_(converter),
+      options_(options),
+      gas_(store, require_gas(models), converter, stage_options(options, options.gas_channels)) {
+  if (models_.ph != nullptr) {
+    ph_.emplace(store, *models_.ph, converter, stage_options(options_, options_.ph_channels));
+  }
+}
+
+FusedGrade FusionGrader::grade(const GradingRequest& request) {
+  FusedGrade result;
+  grade_batch({&request, 1}, {&result, 1});
+  return result;
+}
+
+void FusionGrader::grade_batch(std::span<const GradingRequest> requests,
+                               std::span<FusedGrade> out) {
+  if (out.size() != requests.size()) {
+    throw std::invalid_argument("FusionGrader: result span size mismatch");
+  }
+  if (requests.empty()) return;
+  ScopedArena scratch;
+  const std::size_t n = requests.size();
+  // Crop-free copies of the requests still undecided, the sensor stages'
+  // results for them, and their index into `requests`; the first
+  // `undecided` entries are live.
+  std::span<GradingRequest> sensor = scratch->allocate_span<GradingRequest>(n);
+  std::span<GradeResult> results = scratch->allocate_span<GradeResult>(n);
+  std::span<std::uint32_t> pending = scratch->allocate_span<std::uint32_t>(n);
+  std::span<LogProbabilities> pooled = scratch->allocate_zeroed<LogProbabilities>(n);
+  std::size_t undecided = n;
+
+  const auto apply = [&](std::size_t i, FusionStage s, const Prediction& p) {
+    const auto k = static_cast<std::size_t>(s);
+    FusedGrade& g = out[i];
+    g.stages[k] = p;
+    g.stage_mask |= static_cast<std::uint8_t>(1u << k);
+    for (std::size_t c = 0; c < kFreshnessClassCount; ++c) {
+      pooled[i][c] += options_.weight[k] * std::log(std::max(p.probabilities[c], kMinProbability));
+    }
+    softmax(pooled[i].data(), g.fused);
+    ++stats_.runs[k];
+  };
+  // Drops the trays stage `s` decided from `pending`.
+  const auto settle = [&](FusionStage s) {
+    const float exit_margin = options_.exit_margin[static_cast<std::size_t>(s)];
+    std::size_t kept = 0;
+    for (std::size_t j = 0; j < undecided; ++j) {
+      if (margin(out[pending[j]].fused) < exit_margin) pending[kept++] = pending[j];
+    }
+    undecided = kept;
+  };
+
+  for (std::size_t i = 0; i < n; ++i) sensor[i] = {requests[i].node, requests[i].at, {}};
+  gas_.grade_batch(sensor, results);
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = {};
+    out[i].node = results[i].node;
+    out[i].at = results[i].at;
+    out[i].samples = results[i].samples;
+    pending[i] = static_cast<std::uint32_t>(i);
+    apply(i, FusionStage::kGas, results[i].sensor);
+  }
+  settle(FusionStage::kGas);
+
+  if (ph_.has_value() && undecided != 0) {
+    // The gas stage resolved `at`, so both stages see the same window.
+    for (std::size_t j = 0; j < undecided; ++j) {
+      sensor[j] = {out[pending[j]].node, out[pending[j]].at, {}};
+    }
+    ph_->grade_batch(sensor.first(undecided), results.first(undecided));
+    for (std::size_t j = 0; j < undecided; ++j) {
+      apply(pending[j], FusionStage::kPh, results[j].sensor);
+    }
+    settle(FusionStage::kPh);
+  }
+
+  if (models_.image != nullptr) {
+    for (std::size_t j = 0; j < undecided; ++j) {
+      const std::size_t i = pending[j];
+      if (requests[i].crops.empty()) continue;
+      {
+        telemetry::StageTimer timer(telemetry::Stage::kColor);
+        out[i].color = summarize_color(requests[i].crops, converter_, options_.grading);
+      }
+      out[i].has_color = true;
+      apply(i, FusionStage::kImage, models_.image->predict(out[i].color));
+    }
+  }
+
+  stats_.requests += n;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t last = kFusionStageCount - 1;
+    while (!out[i].ran(static_cast<FusionStage>(last))) --last;
+    ++stats_.exits[last];
+  }
+}
+
+}  // namespace meat_quality
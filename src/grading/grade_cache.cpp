@@ -0,0 +1,173 @@
+#include "meat_quality/grading/grade_cache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace meat_quality {
+namespace {
+
+constexpr std::uint64_t mix(std::uint64_t h, std::uint64_t v) noexcept {
+  h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+  h = (h ^ (h >> 31)) * 0x7fb5d329728ea185ull;
+  return h ^ (h >> 27);
+}
+
+std::uint64_t hash_key(const GradeCacheKey& k) noexcept {
+  return mix(mix(mix(0, k.node), static_cast<std::uint64_t>(k.bucket)), k.features);
+}
+
+}  // namespace
+
+GradeCache::GradeCache(GradeCacheOptions options) : options_(options) {
+  if (options_.bucket <= 0 || options_.mantissa_bits == 0 || options_.mantissa_bits > 23) {
+    throw std::invalid_argument("GradeCache: invalid bucket or mantissa width");
+  }
+  // A quarter of the budget goes to the per-node memo, the rest to the
+  // entries and an index with at least twice as many slots. Both are sized
+  // here so that no lookup or insert allocates.
+  const std::size_t memo_nodes = options_.max_bytes / 4 / sizeof(Memo);
+  const std::size_t table_bytes = options_.max_bytes - memo_nodes * sizeof(Memo);
+  std::size_t capacity = std::bit_floor(table_bytes / (sizeof(Entry) + 2 * sizeof(std::uint32_t)));
+  if (capacity < 16) throw std::invalid_argument("GradeCache: max_bytes too small");
+  entries_.resize(capacity);
+  index_.assign(2 * capacity, 0);
+  index_mask_ = index_.size() - 1;
+  memo_.resize(memo_nodes);
+}
+
+std::uint64_t GradeCache::hash_features(const FeatureVector& features) const noexcept {
+  const unsigned drop = 23 - options_.mantissa_bits;
+  const std::uint32_t half = std::uint32_t{1} << drop >> 1;
+  std::uint64_t h = 0;
+  for (float v : features) {
+    // Round to nearest at the kept precision; -0 and +0 hash alike.
+    std::uint32_t bits = v == 0.0f ? 0 : std::bit_cast<std::uint32_t>(v);
+    bits = (bits + half) >> drop;
+    h = mix(h, bits);
+  }
+  return h;
+}
+
+GradeCache::Memo* GradeCache::memo(NodeId node) noexcept {
+  return node < memo_.size() ? &memo_[node] : nullptr;
+}
+
+std::size_t GradeCache::locate(const GradeCacheKey& key, std::uint64_t hash) const noexcept {
+  for (std::size_t pos = hash & index_mask_;; pos = (pos + 1) & index_mask_) {
+    const std::uint32_t e = index_[pos];
+    if (e == 0) return index_.size();
+    const Entry& entry = entries_[e - 1];
+    if (entry.hash == hash && entry.key == key) return pos;
+  }
+}
+
+void GradeCache::erase_index(std::size_t pos) noexcept {
+  // Backward-shift deletion keeps probe sequences unbroken without
+  // tombstones.
+  std::size_t hole = pos;
+  for (std::size_t next = (hole + 1) & index_mask_;; next = (next + 1) & index_mask_) {
+    const std::uint32_t e = index_[next];
+    if (e == 0) break;
+    const std::size_t home = entries_[e - 1].hash & index_mask_;
+    // Move `next` into the hole unless its home lies cyclically in (hole, next].
+    if (((next - home) & index_mask_) >= ((next - hole) & index_mask_)) {
+      index_[hole] = e;
+      hole = next;
+    }
+  }
+  index_[hole] = 0;
+}
+
+std::uint32_t GradeCache::take_slot() noexcept {
+  for (;;) {
+    Entry& e = entries_[hand_];
+    const auto slot = static_cast<std::uint32_t>(hand_);
+    hand_ = (hand_ + 1) % entries_.size();
+    if (!e.used) {
+      ++size_;
+      return slot;
+    }
+    if (e.referenced) {
+      e.referenced = false;
+      continue;
+    }
+    erase_index(locate(e.key, e.hash));
+    e.used = false;
+    ++stats_.evictions;
+    return slot;
+  }
+}
+
+bool GradeCache::find(const GradeCacheKey& key, std::uint64_t generation,
+                      Prediction& prediction) noexcept {
+  const std::size_t pos = locate(key, hash_key(key));
+  if (pos == index_.size()) {
+    ++stats_.misses;
+    return false;
+  }
+  Entry& e = entries_[index_[pos] - 1];
+  e.referenced = true;
+  prediction = e.prediction;
+  if (Memo* m = memo(key.node)) *m = {generation, key, true};
+  ++stats_.feature_hits;
+  return true;
+}
+
+bool GradeCache::find_current(NodeId node, std::int64_t bucket, std::uint64_t generation,
+                              Prediction& prediction, std::uint32_t& samples) noexcept {
+  if (node >= memo_.size()) return false;
+  const Memo& m = memo_[node];
+  if (!m.valid || m.generation != generation || m.key.bucket != bucket) return false;
+  const std::size_t pos = locate(m.key, hash_key(m.key));
+  if (pos == index_.size()) return false;  // evicted since
+  Entry& e = entries_[index_[pos] - 1];
+  e.referenced = true;
+  prediction = e.prediction;
+  samples = e.samples;
+  ++stats_.memo_hits;
+  return true;
+}
+
+void GradeCache::insert(const GradeCacheKey& key, std::uint64_t generation,
+                        const Prediction& prediction, std::uint32_t samples) noexcept {
+  const std::uint64_t hash = hash_key(key);
+  std::size_t pos = locate(key, hash);
+  if (pos == index_.size()) {
+    const std::uint32_t slot = take_slot();
+    Entry& e = entries_[slot];
+    e.key = key;
+    e.hash = hash;
+    e.used = true;
+    e.referenced = false;
+    for (pos = hash & index_mask_; index_[pos] != 0; pos = (pos + 1) & index_mask_) {
+    }
+    index_[pos] = slot + 1;
+  }
+  Entry& e = entries_[index_[pos] - 1];
+  e.prediction = prediction;
+  e.samples = samples;
+  if (Memo* m = memo(key.node)) *m = {generation, key, true};
+}
+
+void GradeCache::invalidate(NodeId node) noexcept {
+  if (node < memo_.size()) memo_[node].valid = false;
+}
+
+void GradeCache::clear() noexcept {
+  for (Entry& e : entries_) e.used = false;
+  std::fill(index_.begin(), index_.end(), 0);
+  for (Memo& m : memo_) m.valid = false;
+  hand_ = 0;
+  size_ = 0;
+}
+
+GradeCacheStats GradeCache::stats() const noexcept {
+  GradeCacheStats s = stats_;
+  s.entries = size_;
+  s.bytes = entries_.size() * sizeof(Entry) + index_.size() * sizeof(std::uint32_t) +
+            memo_.size() * sizeof(Memo);
+  return s;
+}
+
+}  // namespace meat_quality
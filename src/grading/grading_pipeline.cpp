@@ -0,0 +1,206 @@
+#include "meat_quality/grading/grading_pipeline.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "meat_quality/telemetry/telemetry.hpp"
+#include "meat_quality/util/alloc_counter.hpp"
+#include "meat_quality/util/arena.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Rows converted per L*a*b* strip; bounds scratch for large crops.
+constexpr std::uint32_t kStripRows = 16;
+
+float percentile(std::span<const std::uint32_t> hist, std::uint64_t total, double q,
+                 float lo, float bin_width) noexcept {
+  const auto target = static_cast<std::uint64_t>(q * double(total));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < hist.size(); ++i) {
+    seen += hist[i];
+    if (seen > target) return lo + (float(i) + 0.5f) * bin_width;
+  }
+  return lo + float(hist.size()) * bin_width;
+}
+
+ColorSummary summarize_crops(std::span<const ImageView> crops, const LabConverter& converter,
+                             const GradingOptions& opt, Arena& arena) {
+  const std::uint32_t bins = std::max(1u, opt.redness_bins);
+  const float bin_width = (opt.a_max - opt.a_min) / float(bins);
+  std::span<std::uint32_t> hist = arena.allocate_zeroed<std::uint32_t>(bins);
+
+  std::uint32_t max_width = 0;
+  for (const ImageView& c : crops) max_width = std::max(max_width, c.width);
+  const std::size_t plane = std::size_t{max_width} * kStripRows;
+  std::span<float> strip = arena.allocate_span<float>(3 * plane);
+  const LabPlanes lab{strip.data(), strip.data() + plane, strip.data() + 2 * plane, max_width,
+                      max_width, kStripRows};
+
+  std::uint64_t pixels = 0;
+  double sum_l = 0, sum_a = 0, sum_b = 0;
+  for (const ImageView& crop : crops) {
+    for (std::uint32_t y0 = 0; y0 < crop.height; y0 += kStripRows) {
+      const ImageView rows = crop.crop(0, y0, crop.width, kStripRows);
+      converter.convert(rows, lab);
+      for (std::uint32_t y = 0; y < rows.height; ++y) {
+        const float* l = lab.l + y * lab.stride;
+        const float* a = lab.a + y * lab.stride;
+        const float* b = lab.b + y * lab.stride;
+        for (std::uint32_t x = 0; x < rows.width; ++x) {
+          sum_l += l[x];
+          sum_a += a[x];
+          sum_b += b[x];
+          const float pos = (a[x] - opt.a_min) / bin_width;
+          const auto bin = static_cast<std::uint32_t>(std::clamp(pos, 0.0f, float(bins - 1)));
+          ++hist[bin];
+        }
+      }
+      pixels += std::uint64_t{rows.width} * rows.height;
+    }
+  }
+  return color_summary(hist, pixels, sum_l, sum_a, sum_b, opt);
+}
+
+}  // namespace
+
+ColorSummary color_summary(std::span<const std::uint32_t> histogram, std::uint64_t pixels,
+                           double sum_l, double sum_a, double sum_b,
+                           const GradingOptions& options) noexcept {
+  ColorSummary s;
+  s.pixels = pixels;
+  if (pixels == 0 || histogram.empty()) return s;
+  const float bin_width = (options.a_max - options.a_min) / float(histogram.size());
+  const double n = double(pixels);
+  s.mean_l = static_cast<float>(sum_l / n);
+  s.mean_a = static_cast<float>(sum_a / n);
+  s.mean_b = static_cast<float>(sum_b / n);
+  s.a_p10 = percentile(histogram, pixels, 0.10, options.a_min, bin_width);
+  s.a_p50 = percentile(histogram, pixels, 0.50, options.a_min, bin_width);
+  s.a_p90 = percentile(histogram, pixels, 0.90, options.a_min, bin_width);
+  return s;
+}
+
+ColorSummary summarize_color(std::span<const ImageView> crops, const LabConverter& converter,
+                             const GradingOptions& options) {
+  ScopedArena scratch;
+  return summarize_crops(crops, converter, options, *scratch);
+}
+
+GradingPipeline::GradingPipeline(const SampleStore& store, const FreshnessClassifier& classifier,
+                                 const LabConverter& converter, GradingOptions options)
+    : store_(store), classifier_(classifier), converter_(converter), options_(options) {}
+
+void GradingPipeline::set_feature_tracker(IncrementalFeatureTracker* tracker) {
+  if (tracker != nullptr &&
+      (&tracker->store() != &store_ || tracker->window() != options_.window ||
+       tracker->options().channels != options_.features.channels ||
+       tracker->options().ewma_alpha != options_.features.ewma_alpha)) {
+    throw std::invalid_argument("GradingPipeline: tracker does not match the pipeline");
+  }
+  tracker_ = tracker;
+}
+
+GradeResult GradingPipeline::grade(const GradingRequest& request) const {
+  GradeResult result;
+  grade_batch({&request, 1}, {&result, 1});
+  return result;
+}
+
+void GradingPipeline::grade_batch(std::span<const GradingRequest> requests,
+                                  std::span<GradeResult> out) const {
+  if (out.size() != requests.size()) {
+    throw std::invalid_argument("GradingPipeline: result span size mismatch");
+  }
+  if (requests.empty()) return;
+  const std::uint64_t allocations_before = thread_heap_allocations();
+  ScopedArena scratch;
+  const std::size_t n = requests.size();
+  std::span<FeatureVector> features = scratch->allocate_span<FeatureVector>(n);
+  std::span<Prediction> predictions = scratch->allocate_span<Prediction>(n);
+  // Requests that still need the classifier, with their cache keys; the
+  // first `misses` rows of `features` are theirs.
+  std::span<std::uint32_t> pending = scratch->allocate_span<std::uint32_t>(n);
+  std::span<GradeCacheKey> keys;
+  std::span<std::uint64_t> generations;
+  if (cache_ != nullptr) {
+    keys = scratch->allocate_span<GradeCacheKey>(n);
+    generations = scratch->allocate_span<std::uint64_t>(n);
+  }
+  std::size_t misses = 0;
+
+  {
+    telemetry::StageTimer timer(telemetry::Stage::kFeatures);
+    for (std::size_t i = 0; i < n; ++i) {
+      const GradingRequest& req = requests[i];
+      GradeResult& r = out[i];
+      r = {};
+      r.node = req.node;
+      r.at = req.at != 0 ? req.at : store_.newest(req.node);
+      std::uint64_t generation = 0;
+      std::int64_t bucket = 0;
+      if (cache_ != nullptr) {
+        generation = store_.total_pushed(req.node);
+        bucket = cache_->bucket_of(r.at);
+        if (cache_->find_current(req.node, bucket, generation, r.sensor, r.samples)) continue;
+      }
+      FeatureVector& fv = features[misses];
+      if (req.at == 0 && tracker_ != nullptr) {
+        const WindowFeatures f = tracker_->update(req.node);
+        r.samples = f.samples;
+        fv = to_feature_vector(f);
+      } else {
+        WindowView window = store_.window(req.node, r.at - options_.window);
+        // Drop samples newer than `at` when grading a past instant.
+        std::size_t keep = window.size();
+        while (keep > 0 && window.timestamps[keep - 1] > r.at) --keep;
+        window = window.head(keep);
+        r.samples = static_cast<std::uint32_t>(window.size());
+        fv = to_feature_vector(extract_features(window, options_.features));
+      }
+      if (cache_ != nullptr) {
+        const GradeCacheKey key{req.node, bucket, cache_->hash_features(fv)};
+        if (cache_->find(key, generation, r.sensor)) continue;
+        keys[misses] = key;
+        generations[misses] = generation;
+      }
+      pending[misses++] = static_cast<std::uint32_t>(i);
+    }
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    if (requests[i].crops.empty()) continue;
+    telemetry::StageTimer timer(telemetry::Stage::kColor);
+    out[i].has_color = true;
+    out[i].color = summarize_crops(requests[i].crops, converter_, options_, *scratch);
+  }
+
+  if (misses != 0) {
+    telemetry::StageTimer timer(telemetry::Stage::kInference);
+    if (quantized_ != nullptr) {
+      quantized_->predict(features.data(), misses, predictions.data(),
+                          scratch->allocate_span<std::int32_t>(quantized_->scratch_size(misses)));
+    } else {
+      classifier_.predict(features.data(), misses, predictions.data(),
+                          scratch->allocate_span<float>(classifier_.scratch_size(misses)));
+    }
+  }
+  {
+    telemetry::StageTimer timer(telemetry::Stage::kPostprocess);
+    for (std::size_t j = 0; j < misses; ++j) {
+      GradeResult& r = out[pending[j]];
+      r.sensor = predictions[j];
+      if (cache_ != nullptr) cache_->insert(keys[j], generations[j], r.sensor, r.samples);
+    }
+  }
+  telemetry::add(telemetry::Counter::kGrades, n);
+  // Both describe classifier passes, so requests served from the cache
+  // count in neither.
+  if (misses != 0) {
+    telemetry::add(telemetry::Counter::kBatches);
+    telemetry::observe(telemetry::Distribution::kBatchSize, misses);
+  }
+  telemetry::add(telemetry::Counter::kHeapAllocations,
+                 thread_heap_allocations() - allocations_before);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,171 @@
+#include "meat_quality/grading/replay_engine.hpp"
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+namespace {
+
+Timestamp saturating_sub(Timestamp t, Timestamp d) noexcept {
+  return t < std::numeric_limits<Timestamp>::min() + d ? std::numeric_limits<Timestamp>::min()
+                                                       : t - d;
+}
+
+struct BlockRef {
+  const SegmentReader* reader;
+  const segment::BlockEntry* entry;
+};
+
+// One node's position in its history: the blocks left to replay and the
+// decoded block being pushed.
+class NodeCursor {
+ public:
+  NodeCursor(NodeId node, std::vector<BlockRef> blocks, std::size_t block_samples)
+      : node_(node), blocks_(std::move(blocks)), timestamps_(block_samples) {
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      columns_[c] = AlignedBuffer<float>(block_samples);
+      decoded_[c] = columns_[c].data();
+    }
+  }
+
+  NodeId node() const noexcept { return node_; }
+
+  // Pushes every remaining sample up to and including `t` into `store` as
+  // node `slot`. Returns the number of samples pushed.
+  std::size_t advance(SampleStore& store, NodeId slot, Timestamp t) noexcept {
+    std::size_t pushed = 0;
+    for (;;) {
+      if (pos_ == count_) {
+        if (next_ == blocks_.size() || blocks_[next_].entry->t_min > t) break;
+        const BlockRef& b = blocks_[next_++];
+        b.reader->decode(*b.entry, timestamps_.data(), decoded_);
+        count_ = b.entry->count;
+        pos_ = 0;
+      }
+      const Timestamp* ts = timestamps_.data();
+      const auto end =
+          static_cast<std::size_t>(std::upper_bound(ts + pos_, ts + count_, t) - ts);
+      if (end == pos_) break;
+      std::array<const float*, kChannelCount> cols;
+      for (std::size_t c = 0; c < kChannelCount; ++c) cols[c] = decoded_[c] + pos_;
+      store.push_columns(slot, ts + pos_, cols, end - pos_);
+      pushed += end - pos_;
+      pos_ = end;
+      if (pos_ < count_) break;
+    }
+    return pushed;
+  }
+
+ private:
+  NodeId node_;
+  std::vector<BlockRef> blocks_;
+  std::size_t next_ = 0;
+  AlignedBuffer<Timestamp> timestamps_;
+  std::array<AlignedBuffer<float>, kChannelCount> columns_;
+  std::array<float*, kChannelCount> decoded_{};
+  std::size_t count_ = 0;
+  std::size_t pos_ = 0;
+};
+
+}  // namespace
+
+ReplayEngine::ReplayEngine(WorkStealingPool& pool, const FreshnessClassifier& classifier,
+                           const LabConverter& converter, ReplayOptions options)
+    : pool_(pool), classifier_(classifier), converter_(converter), options_(options) {
+  if (options_.step <= 0 || options_.capacity_per_node == 0 || options_.nodes_per_task == 0 ||
+      options_.output_batch == 0) {
+    throw std::invalid_argument("ReplayEngine: step, capacity and batch sizes must be positive");
+  }
+}
+
+ReplayStats ReplayEngine::run(std::span<const SegmentReader* const> segments, const Sink& sink,
+                              const CropSource& crops) const {
+  std::vector<NodeId> nodes(options_.nodes.begin(), options_.nodes.end());
+  Timestamp first = std::numeric_limits<Timestamp>::max();
+  Timestamp last = std::numeric_limits<Timestamp>::min();
+  std::size_t block_samples = 0;
+  for (const SegmentReader* r : segments) {
+    block_samples = std::max<std::size_t>(block_samples, r->block_samples());
+    for (const segment::BlockEntry& e : r->blocks()) {
+      first = std::min(first, e.t_min);
+      last = std::max(last, e.t_max);
+      if (options_.nodes.empty()) nodes.push_back(e.node);
+    }
+  }
+  std::sort(nodes.begin(), nodes.end());
+  nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+  ReplayStats stats;
+  stats.nodes = nodes.size();
+  const Timestamp from =
+      options_.from != std::numeric_limits<Timestamp>::min() ? options_.from : first;
+  const Timestamp to = std::min(options_.to, last);
+  if (nodes.empty() || from > to) return stats;
+
+  std::mutex sink_mutex;
+  const auto replay_task = [&](std::span<const NodeId> task_nodes) {
+    const auto n = static_cast<NodeId>(task_nodes.size());
+    std::vector<NodeCursor> cursors;
+    cursors.reserve(n);
+    for (NodeId node : task_nodes) {
+      std::vector<BlockRef> blocks;
+      for (const SegmentReader* r : segments) {
+        for (const segment::BlockEntry& e :
+             r->blocks(node, saturating_sub(from, options_.grading.window), to)) {
+          blocks.push_back({r, &e});
+        }
+      }
+      cursors.emplace_back(node, std::move(blocks), block_samples);
+    }
+    SampleStore store(n, options_.capacity_per_node);
+    GradingPipeline pipeline(store, classifier_, converter_, options_.grading);
+    pipeline.set_quantized_classifier(options_.quantized);
+    std::vector<GradingRequest> requests(n);
+    std::vector<GradeResult> results(n);
+    std::vector<GradeResult> output;
+    output.reserve(options_.output_batch);
+    ReplayStats local;
+    const auto flush = [&] {
+      std::lock_guard lock(sink_mutex);
+      sink(output);
+      output.clear();
+    };
+
+    for (Timestamp t = from;; t += options_.step) {
+      for (NodeId k = 0; k < n; ++k) {
+        local.samples += cursors[k].advance(store, k, t);
+        requests[k] = {k, t, crops ? crops(cursors[k].node(), t) : std::span<const ImageView>{}};
+      }
+      pipeline.grade_batch(requests, results);
+      ++local.batches;
+      local.grades += n;
+      for (NodeId k = 0; k < n; ++k) {
+        results[k].node = cursors[k].node();
+        output.push_back(results[k]);
+        if (output.size() == options_.output_batch) flush();
+      }
+      if (t > to - options_.step) break;
+    }
+    if (!output.empty()) flush();
+    std::lock_guard lock(sink_mutex);
+    stats.samples += local.samples;
+    stats.grades += local.grades;
+    stats.batches += local.batches;
+  };
+
+  TaskGroup group(pool_);
+  const std::span<const NodeId> all(nodes);
+  for (std::size_t i = 0; i < all.size(); i += options_.nodes_per_task) {
+    const auto chunk = all.subspan(i, std::min(options_.nodes_per_task, all.size() - i));
+    group.run([&replay_task, chunk] { replay_task(chunk); });
+  }
+  group.wait();
+  return stats;
+}
+
+}  // namespace meat_quality
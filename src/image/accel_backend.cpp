@@ -0,0 +1,145 @@
+#include "meat_quality/image/accel_backend.hpp"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "meat_quality/image/color_lab.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Rows converted per L*a*b* strip.
+constexpr std::uint32_t kStripRows = 16;
+
+struct ReferenceContext {
+  LabConverter converter{LabMode::kSimd};
+  LabImage strip;
+  std::int64_t tickets = 0;
+};
+
+void run_job(ReferenceContext& ctx, mq_image_job& job, const mq_image_params& p) {
+  const std::uint32_t bins = std::max(1u, p.redness_bins);
+  const float bin_width = (p.a_max - p.a_min) / float(bins);
+  std::fill(job.histogram, job.histogram + bins, 0u);
+  job.sum_l = job.sum_a = job.sum_b = 0;
+  job.fat_pixels = job.lean_pixels = 0;
+  if (ctx.strip.planes().width < job.width) ctx.strip = LabImage(job.width, kStripRows);
+  const LabPlanes& lab = ctx.strip.planes();
+  const ImageView rgb{job.rgb, job.width, job.height, job.stride, PixelFormat::kRgb8};
+  for (std::uint32_t y0 = 0; y0 < job.height; y0 += kStripRows) {
+    const ImageView rows = rgb.crop(0, y0, job.width, kStripRows);
+    ctx.converter.convert(rows, lab);
+    for (std::uint32_t y = 0; y < rows.height; ++y) {
+      const float* l = lab.l + y * lab.stride;
+      const float* a = lab.a + y * lab.stride;
+      const float* b = lab.b + y * lab.stride;
+      std::uint8_t* cls = job.classes + std::size_t{y0 + y} * job.width;
+      for (std::uint32_t x = 0; x < rows.width; ++x) {
+        job.sum_l += l[x];
+        job.sum_a += a[x];
+        job.sum_b += b[x];
+        const float pos = (a[x] - p.a_min) / bin_width;
+        ++job.histogram[static_cast<std::uint32_t>(std::clamp(pos, 0.0f, float(bins - 1)))];
+        if (l[x] >= p.fat_min_l && a[x] <= p.fat_max_a) {
+          cls[x] = MQ_PIXEL_FAT;
+          ++job.fat_pixels;
+        } else if (a[x] >= p.lean_min_a) {
+          cls[x] = MQ_PIXEL_LEAN;
+          ++job.lean_pixels;
+        } else {
+          cls[x] = MQ_PIXEL_BACKGROUND;
+        }
+      }
+    }
+  }
+}
+
+void* reference_create(int, char* error, std::size_t error_size) {
+  try {
+    return new ReferenceContext;
+  } catch (const std::exception& e) {
+    std::snprintf(error, error_size, "%s", e.what());
+    return nullptr;
+  }
+}
+
+void reference_destroy(void* ctx) { delete static_cast<ReferenceContext*>(ctx); }
+
+void* reference_alloc_host(void*, std::size_t bytes) {
+  return ::operator new(bytes, std::align_val_t{kCacheLineSize}, std::nothrow);
+}
+
+void reference_free_host(void*, void* p) {
+  ::operator delete(p, std::align_val_t{kCacheLineSize});
+}
+
+std::int64_t reference_submit(void* ctx, mq_image_job* jobs, std::size_t n,
+                              const mq_image_params* params) {
+  auto& c = *static_cast<ReferenceContext*>(ctx);
+  try {
+    for (std::size_t i = 0; i < n; ++i) run_job(c, jobs[i], *params);
+  } catch (const std::exception&) {
+    return -1;
+  }
+  return c.tickets++;
+}
+
+int reference_wait(void*, std::int64_t) { return 0; }
+
+constexpr mq_image_accel kReferenceTable{
+    .abi = MQ_IMAGE_ACCEL_ABI,
+    .name = "cpu",
+    .create = reference_create,
+    .destroy = reference_destroy,
+    .alloc_host = reference_alloc_host,
+    .free_host = reference_free_host,
+    .submit = reference_submit,
+    .wait = reference_wait,
+};
+
+}  // namespace
+
+const ImageAccelBackend& ImageAccelBackend::reference() noexcept {
+  static const ImageAccelBackend backend(nullptr, &kReferenceTable);
+  return backend;
+}
+
+ImageAccelBackend ImageAccelBackend::load(const std::string& path) {
+  void* handle = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    throw std::runtime_error("ImageAccelBackend: cannot load " + path + ": " + ::dlerror());
+  }
+  auto entry =
+      reinterpret_cast<mq_image_accel_entry_fn>(::dlsym(handle, MQ_IMAGE_ACCEL_ENTRY));
+  const mq_image_accel* table = entry != nullptr ? entry(MQ_IMAGE_ACCEL_ABI) : nullptr;
+  if (table == nullptr || table->abi != MQ_IMAGE_ACCEL_ABI || table->create == nullptr ||
+      table->destroy == nullptr || table->alloc_host == nullptr || table->free_host == nullptr ||
+      table->submit == nullptr || table->wait == nullptr) {
+    ::dlclose(handle);
+    throw std::runtime_error("ImageAccelBackend: " + path + " is not a compatible plugin");
+  }
+  return ImageAccelBackend(handle, table);
+}
+
+ImageAccelBackend::ImageAccelBackend(ImageAccelBackend&& other) noexcept
+    : handle_(std::exchange(other.handle_, nullptr)), table_(other.table_) {}
+
+ImageAccelBackend& ImageAccelBackend::operator=(ImageAccelBackend&& other) noexcept {
+  if (this != &other) {
+    if (handle_ != nullptr) ::dlclose(handle_);
+    handle_ = std::exchange(other.handle_, nullptr);
+    table_ = other.table_;
+  }
+  return *this;
+}
+
+ImageAccelBackend::~ImageAccelBackend() {
+  if (handle_ != nullptr) ::dlclose(handle_);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,328 @@
+// Entry point of libmeat_quality_cuda.so: the per-pixel image stages of
+// `image/image_accel.h` on an NVIDIA GPU. Each context has two streams and
+// alternates submissions between them, so one batch's copies overlap the
+// previous batch's kernels. Within a submission the jobs share one device
+// image buffer and run in stream order.
+
+#include <cuda_runtime.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "lab_kernels.hpp"
+#include "meat_quality/image/image_accel.h"
+
+namespace {
+
+namespace mq = meat_quality::detail;
+
+constexpr int kThreads = 256;
+constexpr int kStreams = 2;
+// Shared-memory histogram limit per block.
+constexpr uint32_t kMaxBins = 8192;
+
+__constant__ float c_linear[256];
+__constant__ float c_rgb_to_xyz[9] = {
+    mq::kRgbToXyz[0][0], mq::kRgbToXyz[0][1], mq::kRgbToXyz[0][2],
+    mq::kRgbToXyz[1][0], mq::kRgbToXyz[1][1], mq::kRgbToXyz[1][2],
+    mq::kRgbToXyz[2][0], mq::kRgbToXyz[2][1], mq::kRgbToXyz[2][2],
+};
+
+struct Accum {
+  double sum_l;
+  double sum_a;
+  double sum_b;
+  unsigned long long fat;
+  unsigned long long lean;
+};
+
+__device__ float lab_f(float t) {
+  return t > mq::kLabEpsilon ? cbrtf(t) : mq::kLabSlope * t + mq::kLabOffset;
+}
+
+template <typename T>
+__device__ T warp_sum(T v) {
+  for (int offset = 16; offset > 0; offset /= 2) v += __shfl_down_sync(0xffffffffu, v, offset);
+  return v;
+}
+
+// One image: L*a*b* per pixel, pixel class, and block-local sums and a*
+// histogram folded into `acc` and `hist` with one atomic per warp or bin.
+__global__ void classify_kernel(const uint8_t* rgb, uint32_t width, uint32_t height,
+                                mq_image_params p, uint8_t* classes, Accum* acc,
+                                uint32_t* hist) {
+  extern __shared__ uint32_t block_hist[];
+  const uint32_t bins = p.redness_bins;
+  for (uint32_t i = threadIdx.x; i < bins; i += blockDim.x) block_hist[i] = 0;
+  __syncthreads();
+
+  const float bin_width = (p.a_max - p.a_min) / float(bins);
+  const size_t pixels = size_t{width} * height;
+  double sl = 0, sa = 0, sb = 0;
+  unsigned long long fat = 0, lean = 0;
+  for (size_t i = size_t{blockIdx.x} * blockDim.x + threadIdx.x; i < pixels;
+       i += size_t{gridDim.x} * blockDim.x) {
+    const float r = c_linear[rgb[3 * i]];
+    const float g = c_linear[rgb[3 * i + 1]];
+    const float b = c_linear[rgb[3 * i + 2]];
+    const float fx = lab_f(c_rgb_to_xyz[0] * r + c_rgb_to_xyz[1] * g + c_rgb_to_xyz[2] * b);
+    const float fy = lab_f(c_rgb_to_xyz[3] * r + c_rgb_to_xyz[4] * g + c_rgb_to_xyz[5] * b);
+    const float fz = lab_f(c_rgb_to_xyz[6] * r + c_rgb_to_xyz[7] * g + c_rgb_to_xyz[8] * b);
+    const float l = 116.0f * fy - 16.0f;
+    const float a = 500.0f * (fx - fy);
+    const float bb = 200.0f * (fy - fz);
+    sl += l;
+    sa += a;
+    sb += bb;
+    const float pos = fminf(fmaxf((a - p.a_min) / bin_width, 0.0f), float(bins - 1));
+    atomicAdd(&block_hist[static_cast<uint32_t>(pos)], 1u);
+    uint8_t cls = MQ_PIXEL_BACKGROUND;
+    if (l >= p.fat_min_l && a <= p.fat_max_a) {
+      cls = MQ_PIXEL_FAT;
+      ++fat;
+    } else if (a >= p.lean_min_a) {
+      cls = MQ_PIXEL_LEAN;
+      ++lean;
+    }
+    classes[i] = cls;
+  }
+
+  sl = warp_sum(sl);
+  sa = warp_sum(sa);
+  sb = warp_sum(sb);
+  fat = warp_sum(fat);
+  lean = warp_sum(lean);
+  if ((threadIdx.x & 31) == 0) {
+    atomicAdd(&acc->sum_l, sl);
+    atomicAdd(&acc->sum_a, sa);
+    atomicAdd(&acc->sum_b, sb);
+    atomicAdd(&acc->fat, fat);
+    atomicAdd(&acc->lean, lean);
+  }
+  __syncthreads();
+  for (uint32_t i = threadIdx.x; i < bins; i += blockDim.x) {
+    if (block_hist[i] != 0) atomicAdd(&hist[i], block_hist[i]);
+  }
+}
+
+// Device buffer grown on demand; only resized while its stream is idle.
+template <typename T>
+struct DeviceBuffer {
+  T* data = nullptr;
+  size_t count = 0;
+
+  bool reserve(size_t n) {
+    if (count >= n) return true;
+    cudaFree(data);
+    data = nullptr;
+    count = 0;
+    if (cudaMalloc(&data, n * sizeof(T)) != cudaSuccess) return false;
+    count = n;
+    return true;
+  }
+  void release() {
+    cudaFree(data);
+    data = nullptr;
+    count = 0;
+  }
+};
+
+template <typename T>
+struct PinnedBuffer {
+  T* data = nullptr;
+  size_t count = 0;
+
+  bool reserve(size_t n) {
+    if (count >= n) return true;
+    cudaFreeHost(data);
+    data = nullptr;
+    count = 0;
+    if (cudaMallocHost(&data, n * sizeof(T)) != cudaSuccess) return false;
+    count = n;
+    return true;
+  }
+  void release() {
+    cudaFreeHost(data);
+    data = nullptr;
+    count = 0;
+  }
+};
+
+struct Stream {
+  cudaStream_t stream = nullptr;
+  DeviceBuffer<uint8_t> rgb;
+  DeviceBuffer<uint8_t> classes;
+  DeviceBuffer<Accum> acc;
+  DeviceBuffer<uint32_t> hist;
+  PinnedBuffer<Accum> host_acc;
+  PinnedBuffer<uint32_t> host_hist;
+  mq_image_job* jobs = nullptr;
+  size_t n = 0;
+  uint32_t bins = 0;
+  int64_t ticket = -1;  // submission in flight
+};
+
+struct Context {
+  int device = 0;
+  int blocks_per_image = 0;
+  int64_t next_ticket = 0;
+  int64_t done_ticket = -1;  // newest ticket whose outputs are delivered
+  int failed = 0;            // sticky: a submission failed on the device
+  Stream streams[kStreams];
+};
+
+// Waits for the stream's submission and hands its outputs to the jobs.
+int complete(Context& ctx, Stream& st) {
+  if (st.ticket < 0) return 0;
+  const cudaError_t err = cudaStreamSynchronize(st.stream);
+  if (err == cudaSuccess) {
+    for (size_t i = 0; i < st.n; ++i) {
+      mq_image_job& job = st.jobs[i];
+      const Accum& a = st.host_acc.data[i];
+      job.sum_l = a.sum_l;
+      job.sum_a = a.sum_a;
+      job.sum_b = a.sum_b;
+      job.fat_pixels = a.fat;
+      job.lean_pixels = a.lean;
+      std::memcpy(job.histogram, st.host_hist.data + i * st.bins, st.bins * sizeof(uint32_t));
+    }
+  } else {
+    ctx.failed = 1;
+  }
+  if (st.ticket > ctx.done_ticket) ctx.done_ticket = st.ticket;
+  st.ticket = -1;
+  return err == cudaSuccess ? 0 : -1;
+}
+
+void* cuda_create(int device, char* error, size_t error_size) {
+  cudaError_t err = cudaSetDevice(device);
+  float linear[256];
+  for (int i = 0; i < 256; ++i) {
+    const double c = i / 255.0;
+    linear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+  }
+  if (err == cudaSuccess) err = cudaMemcpyToSymbol(c_linear, linear, sizeof linear);
+  int sms = 0;
+  if (err == cudaSuccess) err = cudaDeviceGetAttribute(&sms, cudaDevAttrMultiProcessorCount, device);
+  auto* ctx = err == cudaSuccess ? new (std::nothrow) Context : nullptr;
+  if (ctx != nullptr) {
+    ctx->device = device;
+    ctx->blocks_per_image = 8 * sms;
+    for (Stream& st : ctx->streams) {
+      if (err == cudaSuccess) err = cudaStreamCreateWithFlags(&st.stream, cudaStreamNonBlocking);
+    }
+  }
+  if (ctx == nullptr || err != cudaSuccess) {
+    std::snprintf(error, error_size, "%s",
+                  err != cudaSuccess ? cudaGetErrorString(err) : "out of memory");
+    if (ctx != nullptr) {
+      for (Stream& st : ctx->streams) {
+        if (st.stream != nullptr) cudaStreamDestroy(st.stream);
+      }
+      delete ctx;
+    }
+    return nullptr;
+  }
+  return ctx;
+}
+
+void cuda_destroy(void* p) {
+  auto* ctx = static_cast<Context*>(p);
+  cudaSetDevice(ctx->device);
+  for (Stream& st : ctx->streams) {
+    cudaStreamSynchronize(st.stream);
+    st.rgb.release();
+    st.classes.release();
+    st.acc.release();
+    st.hist.release();
+    st.host_acc.release();
+    st.host_hist.release();
+    cudaStreamDestroy(st.stream);
+  }
+  delete ctx;
+}
+
+void* cuda_alloc_host(void* p, size_t bytes) {
+  cudaSetDevice(static_cast<Context*>(p)->device);
+  void* out = nullptr;
+  return cudaMallocHost(&out, bytes) == cudaSuccess ? out : nullptr;
+}
+
+void cuda_free_host(void* p, void* ptr) {
+  cudaSetDevice(static_cast<Context*>(p)->device);
+  cudaFreeHost(ptr);
+}
+
+int64_t cuda_submit(void* p, mq_image_job* jobs, size_t n, const mq_image_params* params) {
+  auto& ctx = *static_cast<Context*>(p);
+  const uint32_t bins = params->redness_bins;
+  if (ctx.failed || bins == 0 || bins > kMaxBins) return -1;
+  cudaSetDevice(ctx.device);
+  const int64_t ticket = ctx.next_ticket++;
+  Stream& st = ctx.streams[ticket % kStreams];
+  if (complete(ctx, st) != 0) return -1;
+
+  size_t max_pixels = 1;
+  for (size_t i = 0; i < n; ++i) {
+    const size_t px = size_t{jobs[i].width} * jobs[i].height;
+    if (px > max_pixels) max_pixels = px;
+  }
+  if (!st.rgb.reserve(3 * max_pixels) || !st.classes.reserve(max_pixels) ||
+      !st.acc.reserve(n + 1) || !st.hist.reserve((n + 1) * bins) ||
+      !st.host_acc.reserve(n + 1) || !st.host_hist.reserve((n + 1) * bins)) {
+    return -1;
+  }
+  cudaMemsetAsync(st.acc.data, 0, n * sizeof(Accum), st.stream);
+  cudaMemsetAsync(st.hist.data, 0, n * bins * sizeof(uint32_t), st.stream);
+  for (size_t i = 0; i < n; ++i) {
+    const mq_image_job& job = jobs[i];
+    const size_t pixels = size_t{job.width} * job.height;
+    if (pixels == 0) continue;
+    const size_t row = size_t{job.width} * 3;
+    cudaMemcpy2DAsync(st.rgb.data, row, job.rgb, job.stride, row, job.height,
+                      cudaMemcpyHostToDevice, st.stream);
+    const size_t needed = (pixels + kThreads - 1) / kThreads;
+    const int blocks = static_cast<int>(
+        needed < size_t(ctx.blocks_per_image) ? needed : size_t(ctx.blocks_per_image));
+    classify_kernel<<<blocks, kThreads, bins * sizeof(uint32_t), st.stream>>>(
+        st.rgb.data, job.width, job.height, *params, st.classes.data, st.acc.data + i,
+        st.hist.data + i * bins);
+    cudaMemcpyAsync(job.classes, st.classes.data, pixels, cudaMemcpyDeviceToHost, st.stream);
+  }
+  cudaMemcpyAsync(st.host_acc.data, st.acc.data, n * sizeof(Accum), cudaMemcpyDeviceToHost,
+                  st.stream);
+  cudaMemcpyAsync(st.host_hist.data, st.hist.data, n * bins * sizeof(uint32_t),
+                  cudaMemcpyDeviceToHost, st.stream);
+  if (cudaGetLastError() != cudaSuccess) {
+    ctx.failed = 1;
+    return -1;
+  }
+  st.jobs = jobs;
+  st.n = n;
+  st.bins = bins;
+  st.ticket = ticket;
+  return ticket;
+}
+
+int cuda_wait(void* p, int64_t ticket) {
+  auto& ctx = *static_cast<Context*>(p);
+  cudaSetDevice(ctx.device);
+  Stream& st = ctx.streams[ticket % kStreams];
+  if (st.ticket == ticket) return complete(ctx, st);
+  // Already delivered when a later submission reused the stream.
+  return ticket <= ctx.done_ticket && !ctx.failed ? 0 : -1;
+}
+
+constexpr mq_image_accel kCudaTable{
+    MQ_IMAGE_ACCEL_ABI, "cuda", cuda_create, cuda_destroy, cuda_alloc_host, cuda_free_host,
+    cuda_submit,        cuda_wait,
+};
+
+}  // namespace
+
+extern "C" __attribute__((visibility("default"))) const mq_image_accel*
+mq_image_accel_plugin(uint32_t abi) {
+  return abi == MQ_IMAGE_ACCEL_ABI ? &kCudaTable : nullptr;
+}
@@ -0,0 +1,259 @@
+#include "meat_quality/image/color_lab.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include "lab_kernels.hpp"
+#include "meat_quality/core/simd.hpp"
+
+namespace meat_quality {
+namespace detail {
+namespace {
+
+float lab_f(float t) noexcept {
+  return t > kLabEpsilon ? std::cbrt(t) : kLabSlope * t + kLabOffset;
+}
+
+void linear_rgb_to_lab_scalar(const float* r, const float* g, const float* b,
+                              std::size_t n, float* l, float* a, float* bb) {
+  for (std::size_t i = 0; i < n; ++i) {
+    const float fx = lab_f(kRgbToXyz[0][0] * r[i] + kRgbToXyz[0][1] * g[i] + kRgbToXyz[0][2] * b[i]);
+    const float fy = lab_f(kRgbToXyz[1][0] * r[i] + kRgbToXyz[1][1] * g[i] + kRgbToXyz[1][2] * b[i]);
+    const float fz = lab_f(kRgbToXyz[2][0] * r[i] + kRgbToXyz[2][1] * g[i] + kRgbToXyz[2][2] * b[i]);
+    l[i] = 116.0f * fy - 16.0f;
+    a[i] = 500.0f * (fx - fy);
+    bb[i] = 200.0f * (fy - fz);
+  }
+}
+
+}  // namespace
+
+const LabKernelTable kScalarLabKernels = {linear_rgb_to_lab_scalar};
+
+}  // namespace detail
+
+namespace {
+
+// Pixels per deinterleave + convert chunk; three planar rows stay in L1.
+constexpr std::size_t kChunk = 256;
+
+double srgb_to_linear(double c) noexcept {
+  return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+double lab_f_exact(double t) noexcept {
+  constexpr double eps = 216.0 / 24389.0;
+  return t > eps ? std::cbrt(t) : (24389.0 / 27.0 * t + 16.0) / 116.0;
+}
+
+// r, g, b in [0, 1], gamma encoded.
+Lab unit_srgb_to_lab(double r, double g, double b) noexcept {
+  r = srgb_to_linear(r);
+  g = srgb_to_linear(g);
+  b = srgb_to_linear(b);
+  const double x = (0.4124564 * r + 0.3575761 * g + 0.1804375 * b) / 0.95047;
+  const double y = 0.2126729 * r + 0.7151522 * g + 0.0721750 * b;
+  const double z = (0.0193339 * r + 0.1191920 * g + 0.9503041 * b) / 1.08883;
+  const double fx = lab_f_exact(x), fy = lab_f_exact(y), fz = lab_f_exact(z);
+  return {static_cast<float>(116.0 * fy - 16.0), static_cast<float>(500.0 * (fx - fy)),
+          static_cast<float>(200.0 * (fy - fz))};
+}
+
+const std::array<float, 256>& linearization_table() noexcept {
+  static const std::array<float, 256> table = [] {
+    std::array<float, 256> t{};
+    for (int i = 0; i < 256; ++i) t[i] = static_cast<float>(srgb_to_linear(i / 255.0));
+    return t;
+  }();
+  return table;
+}
+
+const detail::LabKernelTable& lab_kernels() noexcept {
+  switch (active_simd_level()) {
+#if defined(MEAT_QUALITY_HAVE_AVX2)
+    case SimdLevel::kAvx2: return detail::kAvx2LabKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX512)
+    case SimdLevel::kAvx512: return detail::kAvx512LabKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_NEON)
+    case SimdLevel::kNeon: return detail::kNeonLabKernels;
+#endif
+    default: return detail::kScalarLabKernels;
+  }
+}
+
+}  // namespace
+
+Lab srgb_to_lab_exact(std::uint8_t r, std::uint8_t g, std::uint8_t b) noexcept {
+  return unit_srgb_to_lab(r / 255.0, g / 255.0, b / 255.0);
+}
+
+float delta_e76(const Lab& x, const Lab& y) noexcept {
+  const float dl = x.l - y.l, da = x.a - y.a, db = x.b - y.b;
+  return std::sqrt(dl * dl + da * da + db * db);
+}
+
+LabPlanes LabPlanes::crop(std::uint32_t x, std::uint32_t y, std::uint32_t w,
+                          std::uint32_t h) const noexcept {
+  if (x >= width || y >= height) return {nullptr, nullptr, nullptr, stride, 0, 0};
+  w = std::min(w, width - x);
+  h = std::min(h, height - y);
+  const std::size_t off = y * stride + x;
+  return {l + off, a + off, b + off, stride, w, h};
+}
+
+LabImage::LabImage(std::uint32_t width, std::uint32_t height) {
+  constexpr std::size_t kLineFloats = kCacheLineSize / sizeof(float);
+  const std::size_t stride = (std::size_t{width} + kLineFloats - 1) / kLineFloats * kLineFloats;
+  const std::size_t plane = stride * height;
+  storage_ = AlignedBuffer<float>(3 * plane);
+  float* base = storage_.data();
+  planes_ = {base, base + plane, base + 2 * plane, stride, width, height};
+}
+
+LabConverter::LabConverter(LabMode mode, std::uint32_t lut_grid) : mode_(mode) {
+  if (mode_ != LabMode::kLut) return;
+  if (lut_grid < 2 || lut_grid > 256) {
+    throw std::invalid_argument("LabConverter: LUT grid must be in [2, 256]");
+  }
+  grid_ = lut_grid;
+  const std::uint32_t n = grid_;
+  lut_ = AlignedBuffer<float>(std::size_t{n} * n * n * 4);
+  for (std::uint32_t ri = 0; ri < n; ++ri) {
+    for (std::uint32_t gi = 0; gi < n; ++gi) {
+      for (std::uint32_t bi = 0; bi < n; ++bi) {
+        const double s = 1.0 / (n - 1);
+        const Lab v = unit_srgb_to_lab(ri * s, gi * s, bi * s);
+        float* e = lut_.data() + ((std::size_t{ri} * n + gi) * n + bi) * 4;
+        e[0] = v.l;
+        e[1] = v.a;
+        e[2] = v.b;
+      }
+    }
+  }
+  build_lut_weights();
+}
+
+LabConverter::LabConverter(std::span<const float> lut, std::uint32_t lut_grid)
+    : mode_(LabMode::kLut), grid_(lut_grid), borrowed_lut_(lut) {
+  if (lut_grid < 2 || lut_grid > 256 ||
+      lut.size() != std::size_t{lut_grid} * lut_grid * lut_grid * 4) {
+    throw std::invalid_argument("LabConverter: LUT does not match its grid size");
+  }
+  build_lut_weights();
+}
+
+void LabConverter::build_lut_weights() noexcept {
+  const std::uint32_t n = grid_;
+  for (int c = 0; c < 256; ++c) {
+    const float pos = c * float(n - 1) / 255.0f;
+    const auto idx = std::min(static_cast<std::uint32_t>(pos), n - 2);
+    lut_index_[c] = idx;
+    lut_weight_[c] = pos - static_cast<float>(idx);
+  }
+}
+
+std::size_t LabConverter::table_bytes() const noexcept {
+  switch (mode_) {
+    case LabMode::kExact: return 0;
+    case LabMode::kSimd: return sizeof(float) * 256;
+    case LabMode::kLut: return lut().size_bytes() + sizeof(lut_index_) + sizeof(lut_weight_);
+  }
+  return 0;
+}
+
+void LabConverter::convert(const ImageView& rgb, const LabPlanes& out) const {
+  if (rgb.format != PixelFormat::kRgb8 || out.width < rgb.width || out.height < rgb.height) {
+    throw std::invalid_argument("LabConverter: RGB8 input must fit the output planes");
+  }
+  switch (mode_) {
+    case LabMode::kExact: convert_exact(rgb, out); break;
+    case LabMode::kSimd: convert_simd(rgb, out); break;
+    case LabMode::kLut: convert_lut(rgb, out); break;
+  }
+}
+
+Lab LabConverter::convert(std::uint8_t r, std::uint8_t g, std::uint8_t b) const noexcept {
+  const std::uint8_t px[3] = {r, g, b};
+  const ImageView in{px, 1, 1, 3, PixelFormat::kRgb8};
+  Lab v;
+  const LabPlanes out{&v.l, &v.a, &v.b, 1, 1, 1};
+  switch (mode_) {
+    case LabMode::kExact: convert_exact(in, out); break;
+    case LabMode::kSimd: convert_simd(in, out); break;
+    case LabMode::kLut: convert_lut(in, out); break;
+  }
+  return v;
+}
+
+void LabConverter::convert_exact(const ImageView& rgb, const LabPlanes& out) const noexcept {
+  for (std::uint32_t y = 0; y < rgb.height; ++y) {
+    const std::uint8_t* p = rgb.row(y);
+    float* l = out.l + y * out.stride;
+    float* a = out.a + y * out.stride;
+    float* b = out.b + y * out.stride;
+    for (std::uint32_t x = 0; x < rgb.width; ++x, p += 3) {
+      const Lab v = srgb_to_lab_exact(p[0], p[1], p[2]);
+      l[x] = v.l;
+      a[x] = v.a;
+      b[x] = v.b;
+    }
+  }
+}
+
+void LabConverter::convert_simd(const ImageView& rgb, const LabPlanes& out) const noexcept {
+  const std::array<float, 256>& lin = linearization_table();
+  const detail::LabKernelTable& k = lab_kernels();
+  alignas(kCacheLineSize) float r[kChunk];
+  alignas(kCacheLineSize) float g[kChunk];
+  alignas(kCacheLineSize) float b[kChunk];
+  for (std::uint32_t y = 0; y < rgb.height; ++y) {
+    const std::uint8_t* row = rgb.row(y);
+    const std::size_t o = y * out.stride;
+    for (std::uint32_t x0 = 0; x0 < rgb.width; x0 += kChunk) {
+      const std::size_t n = std::min<std::size_t>(kChunk, rgb.width - x0);
+      const std::uint8_t* p = row + std::size_t{x0} * 3;
+      for (std::size_t i = 0; i < n; ++i, p += 3) {
+        r[i] = lin[p[0]];
+        g[i] = lin[p[1]];
+        b[i] = lin[p[2]];
+      }
+      k.linear_rgb_to_lab(r, g, b, n, out.l + o + x0, out.a + o + x0, out.b + o + x0);
+    }
+  }
+}
+
+void LabConverter::convert_lut(const ImageView& rgb, const LabPlanes& out) const noexcept {
+  const std::size_t n = grid_;
+  const std::size_t sr = n * n * 4, sg = n * 4, sb = 4;
+  const float* lut = this->lut().data();
+  for (std::uint32_t y = 0; y < rgb.height; ++y) {
+    const std::uint8_t* p = rgb.row(y);
+    float* l = out.l + y * out.stride;
+    float* a = out.a + y * out.stride;
+    float* b = out.b + y * out.stride;
+    for (std::uint32_t x = 0; x < rgb.width; ++x, p += 3) {
+      const float wr = lut_weight_[p[0]], wg = lut_weight_[p[1]], wb = lut_weight_[p[2]];
+      const float* c000 = lut + lut_index_[p[0]] * sr + lut_index_[p[1]] * sg + lut_index_[p[2]] * sb;
+      // Four lanes (L, a, b, pad) so the blend maps onto one 128-bit vector.
+      float acc[4];
+      for (int ch = 0; ch < 4; ++ch) {
+        const float c00 = c000[ch] + wb * (c000[sb + ch] - c000[ch]);
+        const float c01 = c000[sg + ch] + wb * (c000[sg + sb + ch] - c000[sg + ch]);
+        const float c10 = c000[sr + ch] + wb * (c000[sr + sb + ch] - c000[sr + ch]);
+        const float c11 = c000[sr + sg + ch] + wb * (c000[sr + sg + sb + ch] - c000[sr + sg + ch]);
+        const float c0 = c00 + wg * (c01 - c00);
+        const float c1 = c10 + wg * (c11 - c10);
+        acc[ch] = c0 + wr * (c1 - c0);
+      }
+      l[x] = acc[0];
+      a[x] = acc[1];
+      b[x] = acc[2];
+    }
+  }
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,40 @@
+#pragma once
+
+// Internal interface between LabConverter and the per-ISA conversion kernels.
+// Each kernel file is compiled with its own target flags.
+
+#include <cstddef>
+
+namespace meat_quality::detail {
+
+// Linear sRGB -> XYZ (D65), with the white point divided out of the X and Z
+// rows so that f() below can be applied directly.
+inline constexpr float kRgbToXyz[3][3] = {
+    {0.4124564f / 0.95047f, 0.3575761f / 0.95047f, 0.1804375f / 0.95047f},
+    {0.2126729f, 0.7151522f, 0.0721750f},
+    {0.0193339f / 1.08883f, 0.1191920f / 1.08883f, 0.9503041f / 1.08883f},
+};
+
+// f(t) = cbrt(t) above kLabEpsilon, kLabSlope * t + 4/29 below it.
+inline constexpr float kLabEpsilon = 216.0f / 24389.0f;
+inline constexpr float kLabSlope = 24389.0f / 27.0f / 116.0f;
+inline constexpr float kLabOffset = 4.0f / 29.0f;
+
+struct LabKernelTable {
+  /// Converts `n` linear-RGB pixels (planar) to planar L*a*b*.
+  void (*linear_rgb_to_lab)(const float* r, const float* g, const float* b,
+                            std::size_t n, float* l, float* a, float* bb);
+};
+
+extern const LabKernelTable kScalarLabKernels;
+#if defined(MEAT_QUALITY_HAVE_AVX2)
+extern const LabKernelTable kAvx2LabKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX512)
+extern const LabKernelTable kAvx512LabKernels;
+#endif
+#if defined(MEAT_QUALITY_HAVE_NEON)
+extern const LabKernelTable kNeonLabKernels;
+#endif
+
+}  // namespace meat_quality::detail
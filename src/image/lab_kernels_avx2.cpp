@@ -0,0 +1,62 @@
+// Compiled with -mavx2 -mfma; only reached when the CPU reports both.
+
+#include <immintrin.h>
+
+#include "lab_kernels.hpp"
+
+namespace meat_quality::detail {
+namespace {
+
+// Cube root for t > 0: bit-level initial guess (exponent / 3), then two
+// Halley steps, each of which cubes the relative error (~3% -> 1e-14).
+inline __m256 cbrt_ps(__m256 t) noexcept {
+  const __m256 third = _mm256_set1_ps(1.0f / 3.0f);
+  const __m256i bits = _mm256_castps_si256(t);
+  const __m256i guess = _mm256_add_epi32(
+      _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(bits), third)),
+      _mm256_set1_epi32(0x2a5137a0));
+  __m256 y = _mm256_castsi256_ps(guess);
+  for (int i = 0; i < 2; ++i) {
+    const __m256 y3 = _mm256_mul_ps(_mm256_mul_ps(y, y), y);
+    const __m256 num = _mm256_fmadd_ps(_mm256_set1_ps(2.0f), t, y3);
+    const __m256 den = _mm256_fmadd_ps(_mm256_set1_ps(2.0f), y3, t);
+    y = _mm256_mul_ps(y, _mm256_div_ps(num, den));
+  }
+  return y;
+}
+
+inline __m256 lab_f(__m256 t) noexcept {
+  const __m256 lin = _mm256_fmadd_ps(t, _mm256_set1_ps(kLabSlope), _mm256_set1_ps(kLabOffset));
+  // Keep the cube root's input positive; those lanes take the linear arm.
+  const __m256 root = cbrt_ps(_mm256_max_ps(t, _mm256_set1_ps(kLabEpsilon)));
+  return _mm256_blendv_ps(lin, root, _mm256_cmp_ps(t, _mm256_set1_ps(kLabEpsilon), _CMP_GT_OQ));
+}
+
+inline __m256 dot3(const float (&m)[3], __m256 r, __m256 g, __m256 b) noexcept {
+  return _mm256_fmadd_ps(_mm256_set1_ps(m[2]), b,
+                         _mm256_fmadd_ps(_mm256_set1_ps(m[1]), g,
+                                         _mm256_mul_ps(_mm256_set1_ps(m[0]), r)));
+}
+
+void linear_rgb_to_lab_avx2(const float* r, const float* g, const float* b,
+                            std::size_t n, float* l, float* a, float* bb) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 vr = _mm256_loadu_ps(r + i);
+    const __m256 vg = _mm256_loadu_ps(g + i);
+    const __m256 vb = _mm256_loadu_ps(b + i);
+    const __m256 fx = lab_f(dot3(kRgbToXyz[0], vr, vg, vb));
+    const __m256 fy = lab_f(dot3(kRgbToXyz[1], vr, vg, vb));
+    const __m256 fz = lab_f(dot3(kRgbToXyz[2], vr, vg, vb));
+    _mm256_storeu_ps(l + i, _mm256_fmsub_ps(_mm256_set1_ps(116.0f), fy, _mm256_set1_ps(16.0f)));
+    _mm256_storeu_ps(a + i, _mm256_mul_ps(_mm256_set1_ps(500.0f), _mm256_sub_ps(fx, fy)));
+    _mm256_storeu_ps(bb + i, _mm256_mul_ps(_mm256_set1_ps(200.0f), _mm256_sub_ps(fy, fz)));
+  }
+  if (i < n) kScalarLabKernels.linear_rgb_to_lab(r + i, g + i, b + i, n - i, l + i, a + i, bb + i);
+}
+
+}  // namespace
+
+const LabKernelTable kAvx2LabKernels = {linear_rgb_to_lab_avx2};
+
+}  // namespace meat_quality::detail
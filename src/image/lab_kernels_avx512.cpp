@@ -0,0 +1,65 @@
+// Compiled with -mavx512f -mavx512dq; only reached when the CPU reports both.
+
+// GCC 12 reports the intentionally undefined passthrough operands inside its
+// own AVX-512 intrinsics as uninitialized.
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+#include <immintrin.h>
+
+#include "lab_kernels.hpp"
+
+namespace meat_quality::detail {
+namespace {
+
+// Same bit-guess + two Halley steps as the AVX2 kernel.
+inline __m512 cbrt_ps(__m512 t) noexcept {
+  const __m512i bits = _mm512_castps_si512(t);
+  const __m512i guess = _mm512_add_epi32(
+      _mm512_cvttps_epi32(_mm512_mul_ps(_mm512_cvtepi32_ps(bits), _mm512_set1_ps(1.0f / 3.0f))),
+      _mm512_set1_epi32(0x2a5137a0));
+  __m512 y = _mm512_castsi512_ps(guess);
+  for (int i = 0; i < 2; ++i) {
+    const __m512 y3 = _mm512_mul_ps(_mm512_mul_ps(y, y), y);
+    const __m512 num = _mm512_fmadd_ps(_mm512_set1_ps(2.0f), t, y3);
+    const __m512 den = _mm512_fmadd_ps(_mm512_set1_ps(2.0f), y3, t);
+    y = _mm512_mul_ps(y, _mm512_div_ps(num, den));
+  }
+  return y;
+}
+
+inline __m512 lab_f(__m512 t) noexcept {
+  const __m512 lin = _mm512_fmadd_ps(t, _mm512_set1_ps(kLabSlope), _mm512_set1_ps(kLabOffset));
+  const __m512 root = cbrt_ps(_mm512_max_ps(t, _mm512_set1_ps(kLabEpsilon)));
+  const __mmask16 above = _mm512_cmp_ps_mask(t, _mm512_set1_ps(kLabEpsilon), _CMP_GT_OQ);
+  return _mm512_mask_blend_ps(above, lin, root);
+}
+
+inline __m512 dot3(const float (&m)[3], __m512 r, __m512 g, __m512 b) noexcept {
+  return _mm512_fmadd_ps(_mm512_set1_ps(m[2]), b,
+                         _mm512_fmadd_ps(_mm512_set1_ps(m[1]), g,
+                                         _mm512_mul_ps(_mm512_set1_ps(m[0]), r)));
+}
+
+void linear_rgb_to_lab_avx512(const float* r, const float* g, const float* b,
+                              std::size_t n, float* l, float* a, float* bb) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512 vr = _mm512_loadu_ps(r + i);
+    const __m512 vg = _mm512_loadu_ps(g + i);
+    const __m512 vb = _mm512_loadu_ps(b + i);
+    const __m512 fx = lab_f(dot3(kRgbToXyz[0], vr, vg, vb));
+    const __m512 fy = lab_f(dot3(kRgbToXyz[1], vr, vg, vb));
+    const __m512 fz = lab_f(dot3(kRgbToXyz[2], vr, vg, vb));
+    _mm512_storeu_ps(l + i, _mm512_fmsub_ps(_mm512_set1_ps(116.0f), fy, _mm512_set1_ps(16.0f)));
+    _mm512_storeu_ps(a + i, _mm512_mul_ps(_mm512_set1_ps(500.0f), _mm512_sub_ps(fx, fy)));
+    _mm512_storeu_ps(bb + i, _mm512_mul_ps(_mm512_set1_ps(200.0f), _mm512_sub_ps(fy, fz)));
+  }
+  if (i < n) kScalarLabKernels.linear_rgb_to_lab(r + i, g + i, b + i, n - i, l + i, a + i, bb + i);
+}
+
+}  // namespace
+
+const LabKernelTable kAvx512LabKernels = {linear_rgb_to_lab_avx512};
+
+}  // namespace meat_quality::detail
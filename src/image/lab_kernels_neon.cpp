@@ -0,0 +1,59 @@
+// AArch64 Advanced SIMD kernels; NEON is part of the base architecture.
+
+#include <arm_neon.h>
+
+#include "lab_kernels.hpp"
+
+namespace meat_quality::detail {
+namespace {
+
+// Same bit-guess + two Halley steps as the AVX2 kernel.
+inline float32x4_t cbrt_ps(float32x4_t t) noexcept {
+  const int32x4_t bits = vreinterpretq_s32_f32(t);
+  const int32x4_t guess =
+      vaddq_s32(vcvtq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(bits), 1.0f / 3.0f)),
+                vdupq_n_s32(0x2a5137a0));
+  float32x4_t y = vreinterpretq_f32_s32(guess);
+  for (int i = 0; i < 2; ++i) {
+    const float32x4_t y3 = vmulq_f32(vmulq_f32(y, y), y);
+    const float32x4_t num = vfmaq_n_f32(y3, t, 2.0f);
+    const float32x4_t den = vfmaq_n_f32(t, y3, 2.0f);
+    y = vmulq_f32(y, vdivq_f32(num, den));
+  }
+  return y;
+}
+
+inline float32x4_t lab_f(float32x4_t t) noexcept {
+  const float32x4_t eps = vdupq_n_f32(kLabEpsilon);
+  const float32x4_t lin = vfmaq_n_f32(vdupq_n_f32(kLabOffset), t, kLabSlope);
+  const float32x4_t root = cbrt_ps(vmaxq_f32(t, eps));
+  return vbslq_f32(vcgtq_f32(t, eps), root, lin);
+}
+
+inline float32x4_t dot3(const float (&m)[3], float32x4_t r, float32x4_t g,
+                        float32x4_t b) noexcept {
+  return vfmaq_n_f32(vfmaq_n_f32(vmulq_n_f32(r, m[0]), g, m[1]), b, m[2]);
+}
+
+void linear_rgb_to_lab_neon(const float* r, const float* g, const float* b,
+                            std::size_t n, float* l, float* a, float* bb) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t vr = vld1q_f32(r + i);
+    const float32x4_t vg = vld1q_f32(g + i);
+    const float32x4_t vb = vld1q_f32(b + i);
+    const float32x4_t fx = lab_f(dot3(kRgbToXyz[0], vr, vg, vb));
+    const float32x4_t fy = lab_f(dot3(kRgbToXyz[1], vr, vg, vb));
+    const float32x4_t fz = lab_f(dot3(kRgbToXyz[2], vr, vg, vb));
+    vst1q_f32(l + i, vsubq_f32(vmulq_n_f32(fy, 116.0f), vdupq_n_f32(16.0f)));
+    vst1q_f32(a + i, vmulq_n_f32(vsubq_f32(fx, fy), 500.0f));
+    vst1q_f32(bb + i, vmulq_n_f32(vsubq_f32(fy, fz), 200.0f));
+  }
+  if (i < n) kScalarLabKernels.linear_rgb_to_lab(r + i, g + i, b + i, n - i, l + i, a + i, bb + i);
+}
+
+}  // namespace
+
+const LabKernelTable kNeonLabKernels = {linear_rgb_to_lab_neon};
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,276 @@
+#include "meat_quality/image/marbling.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+
+#include "meat_quality/image/image_accel.h"
+
+namespace meat_quality {
+namespace {
+
+std::uint32_t find_root(std::vector<std::uint32_t>& parent, std::uint32_t x) noexcept {
+  while (parent[x] != x) {
+    parent[x] = parent[parent[x]];  // path halving
+    x = parent[x];
+  }
+  return x;
+}
+
+void unite(std::vector<std::uint32_t>& parent, std::uint32_t a, std::uint32_t b) noexcept {
+  a = find_root(parent, a);
+  b = find_root(parent, b);
+  if (a == b) return;
+  if (a < b) std::swap(a, b);
+  parent[a] = b;
+}
+
+// Per-thread buffers reused across tiles. Label 0 is "not fat".
+struct TileScratch {
+  std::vector<std::uint32_t> labels;
+  std::vector<std::uint32_t> parent;
+  std::vector<std::uint32_t> compact;
+  LabImage row;
+};
+
+thread_local TileScratch tls_scratch;
+
+}  // namespace
+
+MarblingResult label_marbling(const std::uint8_t* classes, std::uint32_t width,
+                              std::uint32_t height, const MarblingOptions& options) {
+  MarblingResult result;
+  if (width == 0 || height == 0) return result;
+  result.tiles = 1;
+  TileScratch& s = tls_scratch;
+  s.labels.assign(std::size_t{width} * height, 0);
+  s.parent.assign(1, 0);
+  for (std::uint32_t y = 0; y < height; ++y) {
+    const std::uint8_t* cls = classes + std::size_t{y} * width;
+    std::uint32_t* row = s.labels.data() + std::size_t{y} * width;
+    const std::uint32_t* up = y > 0 ? row - width : nullptr;
+    for (std::uint32_t x = 0; x < width; ++x) {
+      if (cls[x] == MQ_PIXEL_LEAN) ++result.lean_pixels;
+      if (cls[x] != MQ_PIXEL_FAT) continue;
+      ++result.fat_pixels;
+      const std::uint32_t left = x > 0 ? row[x - 1] : 0;
+      const std::uint32_t above = up != nullptr ? up[x] : 0;
+      if (left == 0 && above == 0) {
+        row[x] = static_cast<std::uint32_t>(s.parent.size());
+        s.parent.push_back(row[x]);
+      } else if (left != 0 && above != 0) {
+        row[x] = std::min(left, above);
+        if (left != above) unite(s.parent, left, above);
+      } else {
+        row[x] = left | above;
+      }
+    }
+  }
+  std::vector<std::uint32_t>& area = s.compact;
+  area.assign(s.parent.size(), 0);
+  for (const std::uint32_t label : s.labels) {
+    if (label != 0) ++area[find_root(s.parent, label)];
+  }
+  for (std::uint32_t i = 1; i < s.parent.size(); ++i) {
+    if (s.parent[i] != i) continue;
+    if (area[i] >= options.min_fleck_pixels) ++result.fleck_count;
+    result.largest_fleck = std::max(result.largest_fleck, area[i]);
+  }
+  return result;
+}
+
+struct MarblingSegmenter::Job::Tile {
+  std::uint32_t x0 = 0, y0 = 0, w = 0, h = 0;
+  bool in_roi = true;
+  std::atomic<bool> scheduled{false};
+  std::uint64_t fat = 0;
+  std::uint64_t lean = 0;
+  std::vector<std::uint32_t> areas;  // pixels per component, component k at [k - 1]
+  // Component id (0 = none) of the border pixels, for the cross-tile merge.
+  std::vector<std::uint32_t> top, bottom, left, right;
+};
+
+MarblingSegmenter::MarblingSegmenter(WorkStealingPool& pool, const LabConverter& converter,
+                                     MarblingOptions options)
+    : pool_(pool), converter_(converter), options_(options) {
+  if (options_.tile == 0) throw std::invalid_argument("MarblingSegmenter: zero tile size");
+}
+
+std::unique_ptr<MarblingSegmenter::Job> MarblingSegmenter::begin(const ImageView& rgb,
+                                                                const RoiMap* roi) const {
+  if (rgb.format != PixelFormat::kRgb8) {
+    throw std::invalid_argument("MarblingSegmenter: RGB8 input required");
+  }
+  if (roi != nullptr && (roi->tile() != options_.tile || roi->width() != rgb.width ||
+                         roi->height() != rgb.height)) {
+    throw std::invalid_argument("MarblingSegmenter: region map does not match the image");
+  }
+  return std::unique_ptr<Job>(new Job(*this, rgb, roi));
+}
+
+MarblingResult MarblingSegmenter::segment(const ImageView& rgb) const {
+  return begin(rgb)->finish();
+}
+
+MarblingResult MarblingSegmenter::segment(const ImageView& rgb, const RoiMap& roi) const {
+  return begin(rgb, &roi)->finish();
+}
+
+MarblingSegmenter::Job::Job(const MarblingSegmenter& owner, const ImageView& rgb,
+                            const RoiMap* roi)
+    : owner_(owner), rgb_(rgb), group_(owner.pool_) {
+  const std::uint32_t t = owner_.options_.tile;
+  tiles_x_ = (rgb.width + t - 1) / t;
+  tiles_y_ = (rgb.height + t - 1) / t;
+  tiles_.reserve(std::size_t{tiles_x_} * tiles_y_);
+  for (std::uint32_t ty = 0; ty < tiles_y_; ++ty) {
+    for (std::uint32_t tx = 0; tx < tiles_x_; ++tx) {
+      auto tile = std::make_unique<Tile>();
+      tile->x0 = tx * t;
+      tile->y0 = ty * t;
+      tile->w = std::min(t, rgb.width - tile->x0);
+      tile->h = std::min(t, rgb.height - tile->y0);
+      tile->in_roi = roi == nullptr || roi->contains(tx, ty);
+      tiles_.push_back(std::move(tile));
+    }
+  }
+}
+
+MarblingSegmenter::Job::~Job() {
+  // Tasks reference the tiles; never let them outlive the job.
+  try {
+    group_.wait();
+  } catch (...) {
+  }
+}
+
+void MarblingSegmenter::Job::add_tile(std::uint32_t tx, std::uint32_t ty) {
+  if (tx >= tiles_x_ || ty >= tiles_y_) return;
+  Tile& tile = *tiles_[std::size_t{ty} * tiles_x_ + tx];
+  if (!tile.in_roi || tile.scheduled.exchange(true)) return;
+  group_.run([this, &tile] { process(tile); });
+}
+
+void MarblingSegmenter::Job::add_rows(std::uint32_t rows_ready) {
+  const std::uint32_t t = owner_.options_.tile;
+  while (rows_scheduled_ < tiles_y_) {
+    const std::uint32_t bottom = std::min(rgb_.height, (rows_scheduled_ + 1) * t);
+    if (bottom > rows_ready) break;
+    for (std::uint32_t tx = 0; tx < tiles_x_; ++tx) add_tile(tx, rows_scheduled_);
+    ++rows_scheduled_;
+  }
+}
+
+void MarblingSegmenter::Job::process(Tile& tile) const {
+  const MarblingOptions& opt = owner_.options_;
+  TileScratch& s = tls_scratch;
+  const std::uint32_t w = tile.w, h = tile.h;
+  s.labels.assign(std::size_t{w} * h, 0);
+  s.parent.assign(1, 0);
+  if (s.row.planes().width < w) s.row = LabImage(opt.tile, 1);
+  const LabPlanes& lab = s.row.planes();
+
+  // Pass 1: classify and assign provisional labels, recording equivalences
+  // between the left and upper neighbours.
+  for (std::uint32_t y = 0; y < h; ++y) {
+    owner_.converter_.convert(rgb_.crop(tile.x0, tile.y0 + y, w, 1), lab);
+    std::uint32_t* row = s.labels.data() + std::size_t{y} * w;
+    const std::uint32_t* up = y > 0 ? row - w : nullptr;
+    for (std::uint32_t x = 0; x < w; ++x) {
+      const float l = lab.l[x], a = lab.a[x];
+      if (l >= opt.fat_min_l && a <= opt.fat_max_a) {
+        ++tile.fat;
+        const std::uint32_t left = x > 0 ? row[x - 1] : 0;
+        const std::uint32_t above = up != nullptr ? up[x] : 0;
+        if (left == 0 && above == 0) {
+          row[x] = static_cast<std::uint32_t>(s.parent.size());
+          s.parent.push_back(row[x]);
+        } else if (left != 0 && above != 0) {
+          row[x] = std::min(left, above);
+          if (left != above) unite(s.parent, left, above);
+        } else {
+          row[x] = left | above;
+        }
+      } else if (a >= opt.lean_min_a) {
+        ++tile.lean;
+      }
+    }
+  }
+
+  // Pass 2: compact roots to 1..k and count component areas.
+  s.compact.assign(s.parent.size(), 0);
+  std::uint32_t next = 0;
+  for (std::uint32_t i = 1; i < s.parent.size(); ++i) {
+    const std::uint32_t r = find_root(s.parent, i);
+    if (s.compact[r] == 0) s.compact[r] = ++next;
+    s.compact[i] = s.compact[r];
+  }
+  tile.areas.assign(next, 0);
+  for (std::uint32_t& label : s.labels) {
+    if (label == 0) continue;
+    label = s.compact[label];
+    ++tile.areas[label - 1];
+  }
+
+  const std::uint32_t* lbl = s.labels.data();
+  tile.top.assign(lbl, lbl + w);
+  tile.bottom.assign(lbl + std::size_t{h - 1} * w, lbl + std::size_t{h} * w);
+  tile.left.resize(h);
+  tile.right.resize(h);
+  for (std::uint32_t y = 0; y < h; ++y) {
+    tile.left[y] = lbl[std::size_t{y} * w];
+    tile.right[y] = lbl[std::size_t{y} * w + w - 1];
+  }
+}
+
+MarblingResult MarblingSegmenter::Job::finish() {
+  for (std::uint32_t ty = 0; ty < tiles_y_; ++ty) {
+    for (std::uint32_t tx = 0; tx < tiles_x_; ++tx) add_tile(tx, ty);
+  }
+  rows_scheduled_ = tiles_y_;
+  group_.wait();
+
+  MarblingResult result;
+  std::vector<std::uint32_t> offset(tiles_.size() + 1, 0);
+  for (std::size_t i = 0; i < tiles_.size(); ++i) {
+    ++(tiles_[i]->in_roi ? result.tiles : result.skipped_tiles);
+    offset[i + 1] = offset[i] + static_cast<std::uint32_t>(tiles_[i]->areas.size());
+    result.fat_pixels += tiles_[i]->fat;
+    result.lean_pixels += tiles_[i]->lean;
+  }
+  std::vector<std::uint32_t> parent(offset.back());
+  std::iota(parent.begin(), parent.end(), 0u);
+
+  const auto join_edge = [&](std::size_t a, const std::vector<std::uint32_t>& ea,
+                             std::size_t b, const std::vector<std::uint32_t>& eb) {
+    if (ea.size() != eb.size()) return;  // one side outside the region
+    for (std::size_t k = 0; k < ea.size(); ++k) {
+      if (ea[k] != 0 && eb[k] != 0) unite(parent, offset[a] + ea[k] - 1, offset[b] + eb[k] - 1);
+    }
+  };
+  for (std::uint32_t ty = 0; ty < tiles_y_; ++ty) {
+    for (std::uint32_t tx = 0; tx < tiles_x_; ++tx) {
+      const std::size_t i = std::size_t{ty} * tiles_x_ + tx;
+      if (tx + 1 < tiles_x_) join_edge(i, tiles_[i]->right, i + 1, tiles_[i + 1]->left);
+      if (ty + 1 < tiles_y_) {
+        join_edge(i, tiles_[i]->bottom, i + tiles_x_, tiles_[i + tiles_x_]->top);
+      }
+    }
+  }
+
+  std::vector<std::uint32_t> area(parent.size(), 0);
+  for (std::size_t i = 0; i < tiles_.size(); ++i) {
+    for (std::size_t k = 0; k < tiles_[i]->areas.size(); ++k) {
+      area[find_root(parent, offset[i] + static_cast<std::uint32_t>(k))] += tiles_[i]->areas[k];
+    }
+  }
+  for (std::uint32_t g = 0; g < parent.size(); ++g) {
+    if (parent[g] != g) continue;
+    if (area[g] >= owner_.options_.min_fleck_pixels) ++result.fleck_count;
+    result.largest_fleck = std::max(result.largest_fleck, area[g]);
+  }
+  return result;
+}
+
+}  // namespace meat_quality
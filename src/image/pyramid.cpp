@@ -0,0 +1,55 @@
+#include "meat_quality/image/pyramid.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Rounded 2×2 box average of `src` into `dst` (half the size, same
+// format). Rows are first summed vertically, which vectorizes over the
+// interleaved bytes, then pairs of pixels are folded; the pixel size is a
+// template argument so that loop unrolls.
+template <std::size_t Bpp>
+void halve(const ImageView& src, std::uint8_t* dst, std::uint32_t w, std::uint32_t h,
+           std::vector<std::uint16_t>& column_sums) {
+  const std::size_t in_row = std::size_t{w} * 2 * Bpp;
+  const std::size_t out_row = std::size_t{w} * Bpp;
+  column_sums.resize(in_row);
+  std::uint16_t* __restrict sum = column_sums.data();
+  for (std::uint32_t y = 0; y < h; ++y) {
+    const std::uint8_t* __restrict a = src.row(2 * y);
+    const std::uint8_t* __restrict b = src.row(2 * y + 1);
+    for (std::size_t i = 0; i < in_row; ++i) {
+      sum[i] = static_cast<std::uint16_t>(a[i] + b[i]);
+    }
+    std::uint8_t* __restrict out = dst + y * out_row;
+    for (std::uint32_t x = 0; x < w; ++x) {
+      for (std::size_t c = 0; c < Bpp; ++c) {
+        const std::size_t i = 2 * Bpp * x + c;
+        out[Bpp * x + c] = static_cast<std::uint8_t>((sum[i] + sum[i + Bpp] + 2) >> 2);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void ImagePyramid::build(const ImageView& base, std::uint32_t levels) {
+  views_.clear();
+  views_.push_back(base);
+  for (std::uint32_t k = 1; k <= levels; ++k) {
+    const ImageView src = views_.back();
+    const std::uint32_t w = src.width / 2, h = src.height / 2;
+    if (w == 0 || h == 0) break;
+    if (storage_.size() < k) storage_.emplace_back();
+    std::vector<std::uint8_t>& buf = storage_[k - 1];
+    const std::size_t stride = w * bytes_per_pixel(src.format);
+    buf.resize(stride * h);
+    if (src.format == PixelFormat::kRgb8) {
+      halve<3>(src, buf.data(), w, h, column_sums_);
+    } else {
+      halve<1>(src, buf.data(), w, h, column_sums_);
+    }
+    views_.push_back({buf.data(), w, h, stride, src.format});
+  }
+}
+
+}  // namespace meat_quality
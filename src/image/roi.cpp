@@ -0,0 +1,98 @@
+#include "meat_quality/image/roi.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace meat_quality {
+
+RoiMap::RoiMap(std::uint32_t width, std::uint32_t height, std::uint32_t tile)
+    : width_(width), height_(height), tile_(tile) {
+  if (tile_ == 0) throw std::invalid_argument("RoiMap: zero tile size");
+  tiles_x_ = (width + tile - 1) / tile;
+  tiles_y_ = (height + tile - 1) / tile;
+  mask_.assign(std::size_t{tiles_x_} * tiles_y_, 0);
+}
+
+void RoiMap::insert(std::uint32_t tx, std::uint32_t ty) noexcept {
+  if (tx >= tiles_x_ || ty >= tiles_y_) return;
+  std::uint8_t& m = mask_[std::size_t{ty} * tiles_x_ + tx];
+  selected_ += m == 0;
+  m = 1;
+}
+
+std::uint64_t RoiMap::pixels() const noexcept {
+  std::uint64_t n = 0;
+  for (std::uint32_t ty = 0; ty < tiles_y_; ++ty) {
+    const std::uint32_t h = std::min(tile_, height_ - ty * tile_);
+    for (std::uint32_t tx = 0; tx < tiles_x_; ++tx) {
+      if (contains(tx, ty)) n += std::uint64_t{std::min(tile_, width_ - tx * tile_)} * h;
+    }
+  }
+  return n;
+}
+
+double RoiMap::coverage() const noexcept {
+  const std::uint64_t total = std::uint64_t{width_} * height_;
+  return total == 0 ? 0.0 : double(pixels()) / double(total);
+}
+
+std::size_t RoiMap::crops(const ImageView& rgb, std::vector<ImageView>& out) const {
+  const std::size_t before = out.size();
+  for (std::uint32_t ty = 0; ty < tiles_y_; ++ty) {
+    for (std::uint32_t tx = 0; tx < tiles_x_;) {
+      if (!contains(tx, ty)) {
+        ++tx;
+        continue;
+      }
+      const std::uint32_t first = tx;
+      while (contains(tx, ty)) ++tx;
+      out.push_back(rgb.crop(first * tile_, ty * tile_, (tx - first) * tile_, tile_));
+    }
+  }
+  return out.size() - before;
+}
+
+RoiDetector::RoiDetector(const LabConverter& converter, RoiOptions options)
+    : converter_(converter), options_(options) {
+  if (options_.tile == 0) throw std::invalid_argument("RoiDetector: zero tile size");
+}
+
+const RoiMap& RoiDetector::detect(const ImageView& rgb) {
+  if (rgb.format != PixelFormat::kRgb8) {
+    throw std::invalid_argument("RoiDetector: RGB8 input required");
+  }
+  map_ = RoiMap(rgb.width, rgb.height, options_.tile);
+  if (rgb.empty()) return map_;
+  pyramid_.build(rgb, options_.level);
+  const ImageView& coarse = pyramid_.coarsest();
+  const std::uint32_t shift = pyramid_.levels() - 1;
+  const std::uint32_t w = coarse.width, h = coarse.height;
+  if (lab_.planes().width < w || lab_.planes().height < h) lab_ = LabImage(w, h);
+  const LabPlanes lab = lab_.planes().crop(0, 0, w, h);
+  converter_.convert(coarse, lab);
+
+  // Each meat pixel, grown by the margin, marks the tiles its footprint at
+  // full resolution overlaps. The last coarse row and column also cover
+  // the odd pixels the pyramid dropped.
+  const std::uint32_t m = options_.margin, tile = options_.tile;
+  const auto span_of = [&](std::uint32_t c, std::uint32_t n, std::uint32_t full) {
+    const std::uint32_t lo = (c > m ? c - m : 0) << shift;
+    const std::uint32_t hi = c + 1 + m >= n ? full : std::min(full, (c + 1 + m) << shift);
+    return std::pair<std::uint32_t, std::uint32_t>{lo / tile, (hi - 1) / tile};
+  };
+  for (std::uint32_t cy = 0; cy < h; ++cy) {
+    const float* a = lab.a + std::size_t{cy} * lab.stride;
+    const auto [ty0, ty1] = span_of(cy, h, rgb.height);
+    for (std::uint32_t cx = 0; cx < w; ++cx) {
+      if (a[cx] < options_.meat_min_a) continue;
+      const auto [tx0, tx1] = span_of(cx, w, rgb.width);
+      for (std::uint32_t ty = ty0; ty <= ty1; ++ty) {
+        for (std::uint32_t tx = tx0; tx <= tx1; ++tx) map_.insert(tx, ty);
+      }
+    }
+  }
+  return map_;
+}
+
+}  // namespace meat_quality
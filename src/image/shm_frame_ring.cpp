@@ -0,0 +1,243 @@
+#include "meat_quality/image/shm_frame_ring.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <ctime>
+#include <stdexcept>
+#include <system_error>
+
+namespace meat_quality {
+namespace {
+
+constexpr std::size_t kPage = 4096;
+
+constexpr std::size_t page_round(std::size_t n) noexcept {
+  return (n + kPage - 1) & ~(kPage - 1);
+}
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Shared (not FUTEX_PRIVATE) futex ops: writer and reader are different
+// processes mapping the same page.
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                std::chrono::milliseconds timeout) noexcept {
+  timespec ts{static_cast<time_t>(timeout.count() / 1000),
+              static_cast<long>(timeout.count() % 1000) * 1'000'000};
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected,
+            &ts, nullptr, 0);
+}
+
+void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept {
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT32_MAX,
+            nullptr, nullptr, 0);
+}
+
+std::unique_ptr<ShmMapping> map_fd(int fd, std::size_t size) {
+  void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) throw_errno("shm frame ring: mmap");
+  return std::make_unique<ShmMapping>(p, size);
+}
+
+}  // namespace
+
+ShmMapping::~ShmMapping() { ::munmap(base_, size_); }
+
+shm::SlotHeader& ShmMapping::slot(std::uint32_t i) const noexcept {
+  auto* base = static_cast<std::uint8_t*>(base_) + header().slots_offset;
+  return reinterpret_cast<shm::SlotHeader*>(base)[i];
+}
+
+std::uint8_t* ShmMapping::pixels(std::uint32_t i) const noexcept {
+  return static_cast<std::uint8_t*>(base_) + header().data_offset +
+         std::size_t{i} * header().slot_bytes;
+}
+
+ShmFrameWriter::ShmFrameWriter(const std::string& name, std::uint32_t width,
+                               std::uint32_t height, std::uint32_t slot_count,
+                               PixelFormat format)
+    : name_(name) {
+  if (slot_count == 0 || width == 0 || height == 0) {
+    throw std::invalid_argument("ShmFrameWriter: empty ring");
+  }
+  const std::size_t stride = std::size_t{width} * bytes_per_pixel(format);
+  const std::size_t slot_bytes = page_round(stride * height);
+  const std::size_t slots_offset = page_round(sizeof(shm::RingHeader));
+  const std::size_t data_offset =
+      slots_offset + page_round(sizeof(shm::SlotHeader) * slot_count);
+  const std::size_t size = data_offset + slot_bytes * slot_count;
+
+  const int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0660);
+  if (fd < 0) throw_errno("ShmFrameWriter: shm_open");
+  if (::ftruncate(fd, static_cast<off_t>(size)) < 0) {
+    const int e = errno;
+    ::close(fd);
+    errno = e;
+    throw_errno("ShmFrameWriter: ftruncate");
+  }
+  try {
+    ring_ = map_fd(fd, size);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+
+  // The object is freshly truncated, so every field starts zeroed; the
+  // magic goes last so readers never see a half-initialised header.
+  shm::RingHeader& h = ring_->header();
+  h.version = shm::kVersion;
+  h.slot_count = slot_count;
+  h.width = width;
+  h.height = height;
+  h.format = static_cast<std::uint32_t>(format);
+  h.stride = stride;
+  h.slot_bytes = slot_bytes;
+  h.slots_offset = slots_offset;
+  h.data_offset = data_offset;
+  std::atomic_ref<std::uint32_t>(h.magic).store(shm::kMagic, std::memory_order_release);
+}
+
+ShmFrameWriter::~ShmFrameWriter() {
+  ring_.reset();
+  ::shm_unlink(name_.c_str());
+}
+
+std::uint8_t* ShmFrameWriter::begin_frame() noexcept {
+  const shm::RingHeader& h = ring_->header();
+  for (std::uint32_t i = 0; i < h.slot_count; ++i) {
+    std::uint32_t expected = shm::kFree;
+    if (ring_->slot(i).state.compare_exchange_strong(expected, shm::kWriting,
+                                                     std::memory_order_acquire)) {
+      claimed_ = i;
+      return ring_->pixels(i);
+    }
+  }
+  // Grader is lagging: overwrite the oldest frame it has not started on.
+  std::int64_t oldest = -1;
+  for (std::uint32_t i = 0; i < h.slot_count; ++i) {
+    const shm::SlotHeader& s = ring_->slot(i);
+    if (s.state.load(std::memory_order_relaxed) == shm::kReady &&
+        (oldest < 0 || s.sequence < ring_->slot(static_cast<std::uint32_t>(oldest)).sequence)) {
+      oldest = i;
+    }
+  }
+  if (oldest < 0) return nullptr;
+  std::uint32_t expected = shm::kReady;
+  if (!ring_->slot(static_cast<std::uint32_t>(oldest))
+           .state.compare_exchange_strong(expected, shm::kWriting,
+                                          std::memory_order_acquire)) {
+    return nullptr;  // a reader just took it
+  }
+  ring_->header().dropped.fetch_add(1, std::memory_order_relaxed);
+  claimed_ = oldest;
+  return ring_->pixels(static_cast<std::uint32_t>(oldest));
+}
+
+void ShmFrameWriter::publish(Timestamp timestamp) noexcept {
+  if (claimed_ < 0) return;
+  shm::RingHeader& h = ring_->header();
+  shm::SlotHeader& s = ring_->slot(static_cast<std::uint32_t>(claimed_));
+  s.sequence = h.next_sequence.fetch_add(1, std::memory_order_relaxed);
+  s.timestamp = timestamp;
+  s.state.store(shm::kReady, std::memory_order_release);
+  claimed_ = -1;
+  h.published.fetch_add(1, std::memory_order_release);
+  futex_wake_all(h.published);
+}
+
+ShmFrameSource::ShmFrameSource(const std::string& name) {
+  const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) throw_errno("ShmFrameSource: shm_open");
+  struct stat st{};
+  if (::fstat(fd, &st) < 0 || static_cast<std::size_t>(st.st_size) < sizeof(shm::RingHeader)) {
+    ::close(fd);
+    throw std::runtime_error("ShmFrameSource: segment too small");
+  }
+  try {
+    ring_ = map_fd(fd, static_cast<std::size_t>(st.st_size));
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+
+  // The header comes from another process: check every size against the
+  // mapping by division, so that no product or sum can wrap, before any
+  // slot or pixel pointer is formed from it.
+  const shm::RingHeader& h = ring_->header();
+  const auto size = static_cast<std::uint64_t>(st.st_size);
+  const auto format = static_cast<PixelFormat>(h.format);
+  const bool known_format = h.format == static_cast<std::uint32_t>(PixelFormat::kGray8) ||
+                            h.format == static_cast<std::uint32_t>(PixelFormat::kRgb8);
+  const bool valid =
+      std::atomic_ref<const std::uint32_t>(h.magic).load(std::memory_order_acquire) ==
+          shm::kMagic &&
+      h.version == shm::kVersion && known_format && h.slot_count != 0 && h.width != 0 &&
+      h.height != 0 && h.slots_offset >= sizeof(shm::RingHeader) &&
+      h.slots_offset % alignof(shm::SlotHeader) == 0 && h.slots_offset <= h.data_offset &&
+      (h.data_offset - h.slots_offset) / sizeof(shm::SlotHeader) >= h.slot_count &&
+      h.data_offset <= size && (size - h.data_offset) / h.slot_count >= h.slot_bytes &&
+      h.stride / bytes_per_pixel(format) >= h.width &&
+      h.slot_bytes / h.stride >= h.height;
+  if (!valid) throw std::runtime_error("ShmFrameSource: not a compatible frame ring");
+  frames_ = std::make_unique<Frame[]>(h.slot_count);
+  for (std::uint32_t i = 0; i < h.slot_count; ++i) {
+    frames_[i].image = {ring_->pixels(i), h.width, h.height, h.stride, format};
+  }
+}
+
+ShmFrameSource::~ShmFrameSource() = default;
+
+FrameRef ShmFrameSource::try_acquire() noexcept {
+  const shm::RingHeader& h = ring_->header();
+  for (;;) {
+    std::int64_t best = -1;
+    std::uint64_t best_seq = 0;
+    for (std::uint32_t i = 0; i < h.slot_count; ++i) {
+      const shm::SlotHeader& s = ring_->slot(i);
+      if (s.state.load(std::memory_order_acquire) != shm::kReady) continue;
+      if (best < 0 || s.sequence < best_seq) {
+        best = i;
+        best_seq = s.sequence;
+      }
+    }
+    if (best < 0) return {};
+    const auto index = static_cast<std::uint32_t>(best);
+    std::uint32_t expected = shm::kReady;
+    if (ring_->slot(index).state.compare_exchange_strong(expected, shm::kReading,
+                                                         std::memory_order_acquire)) {
+      Frame& f = frames_[index];
+      f.sequence = ring_->slot(index).sequence;
+      f.timestamp = ring_->slot(index).timestamp;
+      return hand_out(f, index);
+    }
+    // The writer stole the slot; rescan.
+  }
+}
+
+FrameRef ShmFrameSource::acquire(std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  shm::RingHeader& h = ring_->header();
+  for (;;) {
+    const std::uint32_t seen = h.published.load(std::memory_order_acquire);
+    if (FrameRef f = try_acquire()) return f;
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0) return {};
+    futex_wait(h.published, seen, left);
+  }
+}
+
+void ShmFrameSource::recycle(std::uint32_t index) noexcept {
+  ring_->slot(index).state.store(shm::kFree, std::memory_order_release);
+}
+
+}  // namespace meat_quality
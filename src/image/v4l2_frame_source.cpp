@@ -0,0 +1,132 @@
+#include "meat_quality/image/v4l2_frame_source.hpp"
+
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace meat_quality {
+namespace {
+
+int xioctl(int fd, unsigned long request, void* arg) noexcept {
+  int r;
+  do {
+    r = ::ioctl(fd, request, arg);
+  } while (r == -1 && errno == EINTR);
+  return r;
+}
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+}  // namespace
+
+V4l2FrameSource::V4l2FrameSource(const V4l2Options& options) {
+  fd_ = ::open(options.device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd_ < 0) throw_errno("V4l2FrameSource: open");
+
+  try {
+    v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = options.width;
+    fmt.fmt.pix.height = options.height;
+    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_RGB24;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(fd_, VIDIOC_S_FMT, &fmt) < 0) throw_errno("V4l2FrameSource: VIDIOC_S_FMT");
+    if (fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_RGB24) {
+      throw std::runtime_error("V4l2FrameSource: device does not deliver RGB24");
+    }
+    width_ = fmt.fmt.pix.width;
+    height_ = fmt.fmt.pix.height;
+    stride_ = fmt.fmt.pix.bytesperline != 0 ? fmt.fmt.pix.bytesperline
+                                            : std::size_t{width_} * 3;
+
+    v4l2_requestbuffers req{};
+    req.count = options.buffer_count;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd_, VIDIOC_REQBUFS, &req) < 0) throw_errno("V4l2FrameSource: VIDIOC_REQBUFS");
+    if (req.count == 0) throw std::runtime_error("V4l2FrameSource: no capture buffers");
+
+    mappings_.resize(req.count);
+    frames_ = std::make_unique<Frame[]>(req.count);
+    for (std::uint32_t i = 0; i < req.count; ++i) {
+      v4l2_buffer buf{};
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = V4L2_MEMORY_MMAP;
+      buf.index = i;
+      if (xioctl(fd_, VIDIOC_QUERYBUF, &buf) < 0) throw_errno("V4l2FrameSource: VIDIOC_QUERYBUF");
+      void* p = ::mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                       buf.m.offset);
+      if (p == MAP_FAILED) throw_errno("V4l2FrameSource: mmap");
+      mappings_[i] = {p, buf.length};
+      frames_[i].image = {static_cast<const std::uint8_t*>(p), width_, height_, stride_,
+                          PixelFormat::kRgb8};
+      queue_buffer(i);
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd_, VIDIOC_STREAMON, &type) < 0) throw_errno("V4l2FrameSource: VIDIOC_STREAMON");
+  } catch (...) {
+    for (const Mapping& m : mappings_) {
+      if (m.start != nullptr) ::munmap(m.start, m.length);
+    }
+    ::close(fd_);
+    throw;
+  }
+}
+
+V4l2FrameSource::~V4l2FrameSource() {
+  v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  xioctl(fd_, VIDIOC_STREAMOFF, &type);
+  for (const Mapping& m : mappings_) ::munmap(m.start, m.length);
+  ::close(fd_);
+}
+
+void V4l2FrameSource::queue_buffer(std::uint32_t index) {
+  v4l2_buffer buf{};
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+  buf.index = index;
+  if (xioctl(fd_, VIDIOC_QBUF, &buf) < 0) throw_errno("V4l2FrameSource: VIDIOC_QBUF");
+}
+
+FrameRef V4l2FrameSource::acquire(std::chrono::milliseconds timeout) {
+  pollfd pfd{fd_, POLLIN, 0};
+  const int r = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+  if (r < 0 && errno != EINTR) throw_errno("V4l2FrameSource: poll");
+  if (r <= 0) return {};
+
+  v4l2_buffer buf{};
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+  if (xioctl(fd_, VIDIOC_DQBUF, &buf) < 0) {
+    if (errno == EAGAIN) return {};
+    throw_errno("V4l2FrameSource: VIDIOC_DQBUF");
+  }
+  Frame& frame = frames_[buf.index];
+  frame.sequence = buf.sequence;
+  frame.timestamp = static_cast<Timestamp>(buf.timestamp.tv_sec) * 1'000'000 +
+                    buf.timestamp.tv_usec;
+  return hand_out(frame, buf.index);
+}
+
+void V4l2FrameSource::recycle(std::uint32_t index) noexcept {
+  std::lock_guard lock(queue_mutex_);
+  v4l2_buffer buf{};
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+  buf.index = index;
+  // A failed requeue (device unplugged) only shrinks the capture pool.
+  xioctl(fd_, VIDIOC_QBUF, &buf);
+}
+
+}  // namespace meat_quality
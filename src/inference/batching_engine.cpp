@@ -0,0 +1,155 @@
+#include "meat_quality/inference/batching_engine.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <stdexcept>
+
+#include "meat_quality/telemetry/telemetry.hpp"
+
+namespace meat_quality {
+namespace {
+
+std::uint64_t ns_between(std::chrono::steady_clock::time_point a,
+                         std::chrono::steady_clock::time_point b) noexcept {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+}
+
+}  // namespace
+
+BatchingEngine::BatchingEngine(const FreshnessClassifier& classifier,
+                               BatchingPolicy policy)
+    : classifier_(classifier), policy_(policy) {
+  if (policy_.max_batch == 0 || policy_.queue_capacity == 0) {
+    throw std::invalid_argument("BatchingEngine: empty batch or queue");
+  }
+  pending_.reserve(policy_.queue_capacity);
+  inputs_.resize(policy_.max_batch);
+  outputs_.resize(policy_.max_batch);
+  scratch_.resize(classifier_.scratch_size(policy_.max_batch));
+  worker_ = std::thread([this] { run(); });
+}
+
+BatchingEngine::~BatchingEngine() { stop(); }
+
+bool BatchingEngine::submit(const FeatureVector& features, Callback callback,
+                            void* context) {
+  {
+    std::lock_guard lock(mutex_);
+    if (stopping_ || pending_.size() >= policy_.queue_capacity) {
+      ++stats_.rejected;
+      return false;
+    }
+    pending_.push_back({features, callback, context, std::chrono::steady_clock::now()});
+    // Only the transitions that can close a batch need a wakeup.
+    if (pending_.size() != 1 && pending_.size() != policy_.max_batch) return true;
+  }
+  work_cv_.notify_one();
+  return true;
+}
+
+std::future<Prediction> BatchingEngine::submit(const FeatureVector& features) {
+  auto promise = std::make_unique<std::promise<Prediction>>();
+  std::future<Prediction> result = promise->get_future();
+  const auto complete = [](void* context, const Prediction& p) {
+    std::unique_ptr<std::promise<Prediction>> owned(
+        static_cast<std::promise<Prediction>*>(context));
+    owned->set_value(p);
+  };
+  if (submit(features, complete, promise.get())) {
+    promise.release();
+  } else {
+    promise->set_exception(std::make_exception_ptr(
+        std::runtime_error("BatchingEngine: request rejected")));
+  }
+  return result;
+}
+
+void BatchingEngine::drain() {
+  std::unique_lock lock(mutex_);
+  idle_cv_.wait(lock, [this] { return pending_.empty() && !busy_; });
+}
+
+void BatchingEngine::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  work_cv_.notify_one();
+  if (worker_.joinable()) worker_.join();
+}
+
+BatchingStats BatchingEngine::stats() const {
+  std::lock_guard lock(mutex_);
+  return stats_;
+}
+
+void BatchingEngine::run() {
+  std::vector<Request> batch;
+  batch.reserve(policy_.queue_capacity);
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    work_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+    if (pending_.empty()) break;  // stopping and nothing left
+
+    // Hold the batch open until it is full or its oldest request is due.
+    const auto deadline = pending_.front().enqueued + policy_.max_wait;
+    work_cv_.wait_until(lock, deadline, [this] {
+      return stopping_ || pending_.size() >= policy_.max_batch;
+    });
+
+    // Usually everything pending fits in one batch and the buffers are just
+    // swapped; only a backlog pays for shifting the queue.
+    batch.clear();
+    if (pending_.size() <= policy_.max_batch) {
+      batch.swap(pending_);
+    } else {
+      const auto split = pending_.begin() + static_cast<std::ptrdiff_t>(policy_.max_batch);
+      batch.assign(pending_.begin(), split);
+      pending_.erase(pending_.begin(), split);
+    }
+    busy_ = true;
+    lock.unlock();
+    process(batch);
+    lock.lock();
+    busy_ = false;
+    if (pending_.empty()) idle_cv_.notify_all();
+  }
+  idle_cv_.notify_all();
+}
+
+void BatchingEngine::process(std::vector<Request>& batch) {
+  const std::size_t n = batch.size();
+  for (std::size_t i = 0; i < n; ++i) inputs_[i] = batch[i].features;
+
+  const auto start = std::chrono::steady_clock::now();
+  classifier_.predict(inputs_.data(), n, outputs_.data(), scratch_);
+  const auto end = std::chrono::steady_clock::now();
+
+  // Counted before the results are delivered, so a caller holding one
+  // sees its batch in stats().
+  const std::uint64_t forward = ns_between(start, end);
+  telemetry::record(telemetry::Stage::kInference, forward);
+  telemetry::observe(telemetry::Distribution::kBatchSize, n);
+  telemetry::add(telemetry::Counter::kBatches);
+  {
+    std::lock_guard lock(mutex_);
+    stats_.requests += n;
+    ++stats_.batches;
+    stats_.forward_ns += forward;
+    stats_.queue_wait_ns += ns_between(batch.front().enqueued, start);
+    stats_.last_batch_size = n;
+    stats_.last_forward_ns = forward;
+    stats_.max_forward_ns = std::max(stats_.max_forward_ns, forward);
+    const std::size_t bucket = std::min<std::size_t>(
+        std::bit_width(n) - 1, BatchingStats::kSizeBuckets - 1);
+    ++stats_.batch_size_buckets[bucket];
+  }
+
+  for (std::size_t i = 0; i < n; ++i) {
+    batch[i].callback(batch[i].context, outputs_[i]);
+  }
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,189 @@
+#include "meat_quality/inference/freshness_classifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace meat_quality {
+namespace {
+
+// y[r][o] = b[o] + sum_i x[r][i] * w[i][o], four rows at a time so every
+// weight row loaded from memory is reused across the tile.
+void dense(const float* x, std::size_t rows, std::size_t in, const float* w,
+           const float* b, std::size_t out, float* y, bool relu) noexcept {
+  std::size_t r = 0;
+  for (; r + 4 <= rows; r += 4) {
+    float* y0 = y + (r + 0) * out;
+    float* y1 = y + (r + 1) * out;
+    float* y2 = y + (r + 2) * out;
+    float* y3 = y + (r + 3) * out;
+    std::copy(b, b + out, y0);
+    std::copy(b, b + out, y1);
+    std::copy(b, b + out, y2);
+    std::copy(b, b + out, y3);
+    const float* x0 = x + (r + 0) * in;
+    const float* x1 = x + (r + 1) * in;
+    const float* x2 = x + (r + 2) * in;
+    const float* x3 = x + (r + 3) * in;
+    for (std::size_t i = 0; i < in; ++i) {
+      const float* wi = w + i * out;
+      const float a0 = x0[i], a1 = x1[i], a2 = x2[i], a3 = x3[i];
+      for (std::size_t o = 0; o < out; ++o) {
+        y0[o] += a0 * wi[o];
+        y1[o] += a1 * wi[o];
+        y2[o] += a2 * wi[o];
+        y3[o] += a3 * wi[o];
+      }
+    }
+  }
+  for (; r < rows; ++r) {
+    float* yr = y + r * out;
+    std::copy(b, b + out, yr);
+    const float* xr = x + r * in;
+    for (std::size_t i = 0; i < in; ++i) {
+      const float* wi = w + i * out;
+      for (std::size_t o = 0; o < out; ++o) yr[o] += xr[i] * wi[o];
+    }
+  }
+  if (relu) {
+    for (std::size_t k = 0; k < rows * out; ++k) y[k] = std::max(y[k], 0.0f);
+  }
+}
+
+}  // namespace
+
+std::string_view freshness_class_name(FreshnessClass c) noexcept {
+  switch (c) {
+    case FreshnessClass::kFresh: return "fresh";
+    case FreshnessClass::kSemiFresh: return "semi_fresh";
+    case FreshnessClass::kSpoiled: return "spoiled";
+    case FreshnessClass::kUnknown: return "unknown";
+  }
+  return "unknown";
+}
+
+void softmax(const float* logits, Prediction& out) noexcept {
+  for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+    // With a NaN every comparison below fails and the argmax would fall
+    // back to class 0, kFresh: the worst possible default.
+    if (!std::isfinite(logits[k])) {
+      out.label = FreshnessClass::kUnknown;
+      out.probabilities.fill(0.0f);
+      return;
+    }
+  }
+  const float m = *std::max_element(logits, logits + kFreshnessClassCount);
+  float sum = 0.0f;
+  for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+    out.probabilities[k] = std::exp(logits[k] - m);
+    sum += out.probabilities[k];
+  }
+  std::size_t best = 0;
+  for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+    out.probabilities[k] /= sum;
+    if (out.probabilities[k] > out.probabilities[best]) best = k;
+  }
+  out.label = static_cast<FreshnessClass>(best);
+}
+
+std::string feature_name(std::size_t index) {
+  static constexpr const char* kStats[kFeaturesPerChannel] = {"mean", "variance", "slope",
+                                                              "min",  "max",      "ewma"};
+  std::string name(channel_name(static_cast<Channel>(index / kFeaturesPerChannel)));
+  name += '_';
+  name += kStats[index % kFeaturesPerChannel];
+  return name;
+}
+
+FeatureVector to_feature_vector(const WindowFeatures& features) noexcept {
+  FeatureVector v{};
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(features.channels, static_cast<Channel>(c))) continue;
+    const ChannelFeatures& f = features.values[c];
+    float* dst = v.data() + c * kFeaturesPerChannel;
+    dst[0] = f.mean;
+    dst[1] = f.variance;
+    dst[2] = f.slope;
+    dst[3] = f.min;
+    dst[4] = f.max;
+    dst[5] = f.ewma;
+  }
+  return v;
+}
+
+ClassifierWeights ClassifierWeights::random(std::size_t hidden,
+                                            std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  const auto fill = [&](std::vector<float>& v, std::size_t n, float scale) {
+    v.resize(n);
+    for (float& x : v) x = normal(rng) * scale;
+  };
+  ClassifierWeights w;
+  w.hidden = hidden;
+  w.input_mean.assign(kFeatureDim, 0.0f);
+  w.input_scale.assign(kFeatureDim, 1.0f);
+  fill(w.w1, kFeatureDim * hidden, 1.0f / std::sqrt(float(kFeatureDim)));
+  fill(w.b1, hidden, 0.1f);
+  fill(w.w2, hidden * kFreshnessClassCount, 1.0f / std::sqrt(float(hidden)));
+  fill(w.b2, kFreshnessClassCount, 0.1f);
+  return w;
+}
+
+namespace {
+
+void validate(const ClassifierView& w) {
+  const std::size_t h = w.hidden;
+  if (h == 0 || w.input_mean.size() != kFeatureDim || w.input_scale.size() != kFeatureDim ||
+      w.w1.size() != kFeatureDim * h || w.b1.size() != h ||
+      w.w2.size() != h * kFreshnessClassCount || w.b2.size() != kFreshnessClassCount) {
+    throw std::invalid_argument("FreshnessClassifier: inconsistent weight shapes");
+  }
+}
+
+}  // namespace
+
+FreshnessClassifier::FreshnessClassifier(ClassifierWeights weights)
+    : weights_(std::move(weights)) {
+  validate(weights_.view());
+}
+
+FreshnessClassifier::FreshnessClassifier(const ClassifierView& view)
+    : borrowed_view_(view), borrowed_(true) {
+  validate(view);
+}
+
+void FreshnessClassifier::predict(const FeatureVector* inputs, std::size_t batch,
+                                  Prediction* out,
+                                  std::span<float> scratch) const noexcept {
+  const ClassifierView w = view();
+  const std::size_t h = w.hidden;
+  float* x = scratch.data();
+  float* hid = x + batch * kFeatureDim;
+  float* logits = hid + batch * h;
+
+  const float* mean = w.input_mean.data();
+  const float* scale = w.input_scale.data();
+  for (std::size_t r = 0; r < batch; ++r) {
+    const float* src = inputs[r].data();
+    float* dst = x + r * kFeatureDim;
+    for (std::size_t i = 0; i < kFeatureDim; ++i) {
+      const float z = (src[i] - mean[i]) * scale[i];
+      dst[i] = std::isfinite(z) ? z : 0.0f;  // missing: the training mean
+    }
+  }
+  dense(x, batch, kFeatureDim, w.w1.data(), w.b1.data(), h, hid, true);
+  dense(hid, batch, h, w.w2.data(), w.b2.data(), kFreshnessClassCount, logits, false);
+
+  for (std::size_t r = 0; r < batch; ++r) softmax(logits + r * kFreshnessClassCount, out[r]);
+}
+
+Prediction FreshnessClassifier::predict(const FeatureVector& input) const {
+  std::vector<float> scratch(scratch_size(1));
+  Prediction p;
+  predict(&input, 1, &p, scratch);
+  return p;
+}
+
+}  // namespace meat_quality
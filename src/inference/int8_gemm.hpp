@@ -0,0 +1,51 @@
+#pragma once
+
+// Portable INT8 matrix product in the packed layout of int8_plugin.h. The
+// library uses it when no plugin is loaded; the plugin falls back to it on
+// CPUs without a dot-product instruction.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace meat_quality::detail {
+
+inline void int8_gemm_reference(const std::uint8_t* a, std::size_t rows, std::size_t k,
+                                const std::int8_t* w, std::size_t out,
+                                const std::int32_t* bias, const std::int32_t* /*w_sums*/,
+                                std::int32_t* y) noexcept {
+  const std::size_t groups = k / 4;
+  for (std::size_t r = 0; r < rows; ++r) {
+    const std::uint8_t* ar = a + r * k;
+    std::int32_t* yr = y + r * out;
+    for (std::size_t ob = 0; ob < out / 16; ++ob) {
+      std::int32_t acc[16];
+      for (std::size_t o = 0; o < 16; ++o) acc[o] = bias[ob * 16 + o];
+      for (std::size_t g = 0; g < groups; ++g) {
+        const std::int8_t* wg = w + (ob * groups + g) * 64;
+        const std::uint8_t* ag = ar + g * 4;
+        for (std::size_t o = 0; o < 16; ++o) {
+          acc[o] += ag[0] * wg[o * 4 + 0] + ag[1] * wg[o * 4 + 1] +
+                    ag[2] * wg[o * 4 + 2] + ag[3] * wg[o * 4 + 3];
+        }
+      }
+      for (std::size_t o = 0; o < 16; ++o) yr[ob * 16 + o] = acc[o];
+    }
+  }
+}
+
+}  // namespace meat_quality::detail
+
+namespace meat_quality::detail {
+
+// Per-ISA variants built into the plugin only; same contract as above.
+void int8_gemm_avx_vnni(const std::uint8_t* a, std::size_t rows, std::size_t k,
+                        const std::int8_t* w, std::size_t out, const std::int32_t* bias,
+                        const std::int32_t* w_sums, std::int32_t* y) noexcept;
+void int8_gemm_avx512_vnni(const std::uint8_t* a, std::size_t rows, std::size_t k,
+                           const std::int8_t* w, std::size_t out, const std::int32_t* bias,
+                           const std::int32_t* w_sums, std::int32_t* y) noexcept;
+void int8_gemm_dotprod(const std::uint8_t* a, std::size_t rows, std::size_t k,
+                       const std::int8_t* w, std::size_t out, const std::int32_t* bias,
+                       const std::int32_t* w_sums, std::int32_t* y) noexcept;
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,53 @@
+// Compiled with -mavx512f -mavx512bw -mavx512vnni; only reached when the CPU
+// reports AVX-512 VNNI.
+
+#include <immintrin.h>
+
+#include <cstring>
+
+#include "int8_gemm.hpp"
+
+namespace meat_quality::detail {
+
+// One packed block of 16 outputs by 4 inputs is exactly one zmm register,
+// so each group is a single VPDPBUSD per row; four rows share the load.
+void int8_gemm_avx512_vnni(const std::uint8_t* a, std::size_t rows, std::size_t k,
+                           const std::int8_t* w, std::size_t out, const std::int32_t* bias,
+                           const std::int32_t* w_sums, std::int32_t* y) noexcept {
+  const std::size_t groups = k / 4;
+  const auto load4 = [](const std::uint8_t* p) {
+    std::int32_t v;
+    std::memcpy(&v, p, 4);
+    return _mm512_set1_epi32(v);
+  };
+  std::size_t r = 0;
+  for (; r + 4 <= rows; r += 4) {
+    const std::uint8_t* ar = a + r * k;
+    for (std::size_t ob = 0; ob < out / 16; ++ob) {
+      const __m512i b = _mm512_loadu_si512(bias + ob * 16);
+      __m512i acc[4] = {b, b, b, b};
+      const std::int8_t* wb = w + ob * groups * 64;
+      for (std::size_t g = 0; g < groups; ++g) {
+        const __m512i wv = _mm512_loadu_si512(wb + g * 64);
+        for (int i = 0; i < 4; ++i) {
+          acc[i] = _mm512_dpbusd_epi32(acc[i], load4(ar + i * k + g * 4), wv);
+        }
+      }
+      for (int i = 0; i < 4; ++i) _mm512_storeu_si512(y + (r + i) * out + ob * 16, acc[i]);
+    }
+  }
+  for (; r < rows; ++r) {
+    const std::uint8_t* ar = a + r * k;
+    for (std::size_t ob = 0; ob < out / 16; ++ob) {
+      __m512i acc = _mm512_loadu_si512(bias + ob * 16);
+      const std::int8_t* wb = w + ob * groups * 64;
+      for (std::size_t g = 0; g < groups; ++g) {
+        acc = _mm512_dpbusd_epi32(acc, load4(ar + g * 4), _mm512_loadu_si512(wb + g * 64));
+      }
+      _mm512_storeu_si512(y + r * out + ob * 16, acc);
+    }
+  }
+  (void)w_sums;
+}
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,70 @@
+// Compiled with -mavx2 -mavxvnni; only reached when the CPU reports AVX-VNNI.
+
+#include <immintrin.h>
+
+#include <cstring>
+
+#include "int8_gemm.hpp"
+
+namespace meat_quality::detail {
+
+// Four rows share every packed weight load. Each group of 4 inputs is one
+// broadcast of the rows' activations and one VPDPBUSD per 8 outputs.
+void int8_gemm_avx_vnni(const std::uint8_t* a, std::size_t rows, std::size_t k,
+                        const std::int8_t* w, std::size_t out, const std::int32_t* bias,
+                        const std::int32_t* w_sums, std::int32_t* y) noexcept {
+  const std::size_t groups = k / 4;
+  const auto load4 = [](const std::uint8_t* p) {
+    std::int32_t v;
+    std::memcpy(&v, p, 4);
+    return _mm256_set1_epi32(v);
+  };
+  std::size_t r = 0;
+  for (; r + 4 <= rows; r += 4) {
+    const std::uint8_t* ar = a + r * k;
+    for (std::size_t ob = 0; ob < out / 16; ++ob) {
+      const __m256i b_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bias + ob * 16));
+      const __m256i b_hi =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bias + ob * 16 + 8));
+      __m256i lo[4] = {b_lo, b_lo, b_lo, b_lo};
+      __m256i hi[4] = {b_hi, b_hi, b_hi, b_hi};
+      const std::int8_t* wb = w + ob * groups * 64;
+      for (std::size_t g = 0; g < groups; ++g) {
+        const __m256i w_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wb + g * 64));
+        const __m256i w_hi =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wb + g * 64 + 32));
+        for (int i = 0; i < 4; ++i) {
+          const __m256i av = load4(ar + i * k + g * 4);
+          lo[i] = _mm256_dpbusd_avx_epi32(lo[i], av, w_lo);
+          hi[i] = _mm256_dpbusd_avx_epi32(hi[i], av, w_hi);
+        }
+      }
+      for (int i = 0; i < 4; ++i) {
+        std::int32_t* yr = y + (r + i) * out + ob * 16;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(yr), lo[i]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(yr + 8), hi[i]);
+      }
+    }
+  }
+  for (; r < rows; ++r) {
+    const std::uint8_t* ar = a + r * k;
+    for (std::size_t ob = 0; ob < out / 16; ++ob) {
+      __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bias + ob * 16));
+      __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bias + ob * 16 + 8));
+      const std::int8_t* wb = w + ob * groups * 64;
+      for (std::size_t g = 0; g < groups; ++g) {
+        const __m256i av = load4(ar + g * 4);
+        lo = _mm256_dpbusd_avx_epi32(
+            lo, av, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wb + g * 64)));
+        hi = _mm256_dpbusd_avx_epi32(
+            hi, av, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wb + g * 64 + 32)));
+      }
+      std::int32_t* yr = y + r * out + ob * 16;
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(yr), lo);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(yr + 8), hi);
+    }
+  }
+  (void)w_sums;
+}
+
+}  // namespace meat_quality::detail
@@ -0,0 +1,55 @@
+// Compiled with -march=armv8.2-a+dotprod; only reached when the CPU reports
+// the dot product extension (HWCAP_ASIMDDP).
+
+#include <arm_neon.h>
+
+#include <cstring>
+
+#include "int8_gemm.hpp"
+
+namespace meat_quality::detail {
+
+// SDOT multiplies signed by signed, so activations are shifted to a - 128
+// (a XOR 0x80) and 128 * sum(W[o]) is added back with the bias. A packed
+// block of 16 outputs by 4 inputs is four q registers of 4 outputs each.
+void int8_gemm_dotprod(const std::uint8_t* a, std::size_t rows, std::size_t k,
+                       const std::int8_t* w, std::size_t out, const std::int32_t* bias,
+                       const std::int32_t* w_sums, std::int32_t* y) noexcept {
+  const std::size_t groups = k / 4;
+  const uint8x16_t flip = vdupq_n_u8(0x80);
+  for (std::size_t r = 0; r < rows; ++r) {
+    const std::uint8_t* ar = a + r * k;
+    for (std::size_t ob = 0; ob < out / 16; ++ob) {
+      int32x4_t acc[4];
+      for (int q = 0; q < 4; ++q) {
+        const std::size_t o = ob * 16 + q * 4;
+        acc[q] = vmlaq_n_s32(vld1q_s32(bias + o), vld1q_s32(w_sums + o), 128);
+      }
+      const std::int8_t* wb = w + ob * groups * 64;
+      std::size_t g = 0;
+      // Four groups per iteration: one 16-byte activation load, SDOT by lane.
+      for (; g + 4 <= groups; g += 4) {
+        const int8x16_t av =
+            vreinterpretq_s8_u8(veorq_u8(vld1q_u8(ar + g * 4), flip));
+        for (int q = 0; q < 4; ++q) {
+          acc[q] = vdotq_laneq_s32(acc[q], vld1q_s8(wb + (g + 0) * 64 + q * 16), av, 0);
+          acc[q] = vdotq_laneq_s32(acc[q], vld1q_s8(wb + (g + 1) * 64 + q * 16), av, 1);
+          acc[q] = vdotq_laneq_s32(acc[q], vld1q_s8(wb + (g + 2) * 64 + q * 16), av, 2);
+          acc[q] = vdotq_laneq_s32(acc[q], vld1q_s8(wb + (g + 3) * 64 + q * 16), av, 3);
+        }
+      }
+      for (; g < groups; ++g) {
+        std::int32_t v;
+        std::memcpy(&v, ar + g * 4, 4);
+        const int8x16_t av = vreinterpretq_s8_u8(
+            veorq_u8(vreinterpretq_u8_s32(vdupq_n_s32(v)), flip));
+        for (int q = 0; q < 4; ++q) {
+          acc[q] = vdotq_s32(acc[q], vld1q_s8(wb + g * 64 + q * 16), av);
+        }
+      }
+      for (int q = 0; q < 4; ++q) vst1q_s32(y + r * out + ob * 16 + q * 4, acc[q]);
+    }
+  }
+}
+
+}  // namespace meat_quality::detail
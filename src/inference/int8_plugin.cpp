@@ -0,0 +1,57 @@
+// Entry point of libmeat_quality_int8.so. Picks the widest dot-product
+// kernel that both the host's SIMD level and the running CPU allow.
+
+#include "meat_quality/inference/int8_plugin.h"
+
+#include "int8_gemm.hpp"
+#include "meat_quality/core/simd.hpp"
+
+#if defined(MEAT_QUALITY_HAVE_DOTPROD)
+#include <sys/auxv.h>
+#endif
+
+namespace {
+
+using meat_quality::SimdLevel;
+
+constexpr mq_int8_kernels kReference{MQ_INT8_PLUGIN_ABI, "reference",
+                                     meat_quality::detail::int8_gemm_reference};
+#if defined(MEAT_QUALITY_HAVE_AVX_VNNI)
+constexpr mq_int8_kernels kAvxVnni{MQ_INT8_PLUGIN_ABI, "avx_vnni",
+                                   meat_quality::detail::int8_gemm_avx_vnni};
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX512_VNNI)
+constexpr mq_int8_kernels kAvx512Vnni{MQ_INT8_PLUGIN_ABI, "avx512_vnni",
+                                      meat_quality::detail::int8_gemm_avx512_vnni};
+#endif
+#if defined(MEAT_QUALITY_HAVE_DOTPROD)
+constexpr mq_int8_kernels kDotprod{MQ_INT8_PLUGIN_ABI, "dotprod",
+                                   meat_quality::detail::int8_gemm_dotprod};
+#endif
+
+}  // namespace
+
+extern "C" __attribute__((visibility("default"))) const mq_int8_kernels*
+mq_int8_plugin_kernels(uint32_t abi, int simd_level) {
+  if (abi != MQ_INT8_PLUGIN_ABI) return nullptr;
+  const auto level = static_cast<SimdLevel>(simd_level);
+#if defined(MEAT_QUALITY_HAVE_AVX512_VNNI)
+  if (level == SimdLevel::kAvx512 && __builtin_cpu_supports("avx512vnni") &&
+      __builtin_cpu_supports("avx512bw")) {
+    return &kAvx512Vnni;
+  }
+#endif
+#if defined(MEAT_QUALITY_HAVE_AVX_VNNI)
+  if ((level == SimdLevel::kAvx2 || level == SimdLevel::kAvx512) &&
+      __builtin_cpu_supports("avxvnni")) {
+    return &kAvxVnni;
+  }
+#endif
+#if defined(MEAT_QUALITY_HAVE_DOTPROD)
+  if (level == SimdLevel::kNeon && (getauxval(AT_HWCAP) & HWCAP_ASIMDDP) != 0) {
+    return &kDotprod;
+  }
+#endif
+  (void)level;
+  return &kReference;
+}
@@ -0,0 +1,242 @@
+#include "meat_quality/inference/quantized_classifier.hpp"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "int8_gemm.hpp"
+#include "meat_quality/core/simd.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr std::size_t round_up(std::size_t n, std::size_t m) noexcept {
+  return (n + m - 1) / m * m;
+}
+
+// |v| at quantile `q` of `values`; reorders them.
+float abs_quantile(std::vector<float>& values, double q) {
+  for (float& v : values) v = std::fabs(v);
+  const auto at = static_cast<std::size_t>(
+      std::clamp(q, 0.0, 1.0) * static_cast<double>(values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(at),
+                   values.end());
+  return values[at];
+}
+
+// `w` is input-major (`w[i * out + o]`), as in ClassifierWeights.
+QuantizedLayer quantize_layer(const float* w, const float* b, std::size_t in, std::size_t out,
+                              float in_scale, std::uint8_t in_zero_point) {
+  QuantizedLayer l;
+  l.in = in;
+  l.out = out;
+  l.k = round_up(in, 4);
+  l.out_padded = round_up(out, 16);
+  l.in_scale = in_scale;
+  l.in_zero_point = in_zero_point;
+  l.w.assign(l.out_padded * l.k, 0);
+  l.w_scale.assign(l.out_padded, 1.0f);
+  l.bias.assign(l.out_padded, 0);
+  l.w_sums.assign(l.out_padded, 0);
+  const std::size_t groups = l.k / 4;
+  for (std::size_t o = 0; o < out; ++o) {
+    float max_abs = 0.0f;
+    for (std::size_t i = 0; i < in; ++i) max_abs = std::max(max_abs, std::fabs(w[i * out + o]));
+    const float scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+    std::int32_t sum = 0;
+    for (std::size_t i = 0; i < in; ++i) {
+      const auto q = static_cast<std::int8_t>(
+          std::clamp(std::lround(w[i * out + o] / scale), -127l, 127l));
+      l.w[((o / 16) * groups + i / 4) * 64 + (o % 16) * 4 + i % 4] = q;
+      sum += q;
+    }
+    l.w_scale[o] = scale;
+    l.w_sums[o] = sum;
+    l.bias[o] = static_cast<std::int32_t>(std::lround(b[o] / (in_scale * scale))) -
+                std::int32_t{in_zero_point} * sum;
+  }
+  return l;
+}
+
+const mq_int8_kernels kReferenceKernels{MQ_INT8_PLUGIN_ABI, "reference",
+                                        detail::int8_gemm_reference};
+
+}  // namespace
+
+std::size_t QuantizedWeights::parameter_bytes() const noexcept {
+  const auto layer = [](const QuantizedLayer& l) {
+    return l.w.size() + (l.w_scale.size() + l.bias.size() + l.w_sums.size()) * 4;
+  };
+  return (input_mean.size() + input_scale.size()) * sizeof(float) + layer(l1) + layer(l2);
+}
+
+QuantizedWeights quantize(const ClassifierWeights& weights,
+                          std::span<const FeatureVector> calibration,
+                          CalibrationOptions options) {
+  const FreshnessClassifier validated(weights);  // throws on bad shapes
+  if (calibration.empty()) throw std::invalid_argument("quantize: no calibration data");
+  const std::size_t h = weights.hidden;
+  const std::size_t n = calibration.size();
+
+  // Standardized inputs and float hidden activations over the calibration set.
+  std::vector<float> x(n * kFeatureDim);
+  std::vector<float> hid(n * h);
+  for (std::size_t r = 0; r < n; ++r) {
+    float* xr = x.data() + r * kFeatureDim;
+    for (std::size_t i = 0; i < kFeatureDim; ++i) {
+      const float z = (calibration[r][i] - weights.input_mean[i]) * weights.input_scale[i];
+      xr[i] = std::isfinite(z) ? z : 0.0f;  // missing, as in predict()
+    }
+    float* hr = hid.data() + r * h;
+    std::copy(weights.b1.begin(), weights.b1.end(), hr);
+    for (std::size_t i = 0; i < kFeatureDim; ++i) {
+      for (std::size_t o = 0; o < h; ++o) hr[o] += xr[i] * weights.w1[i * h + o];
+    }
+    for (std::size_t o = 0; o < h; ++o) hr[o] = std::max(hr[o], 0.0f);
+  }
+
+  // Inputs are signed: symmetric around zero point 128. Hidden activations
+  // are post-ReLU: the full 0..255 range with zero point 0.
+  const float x_clip = std::max(abs_quantile(x, options.clip_quantile), 1e-6f);
+  const float h_clip = std::max(abs_quantile(hid, options.clip_quantile), 1e-6f);
+
+  QuantizedWeights q;
+  q.hidden = h;
+  q.input_mean = weights.input_mean;
+  q.input_scale = weights.input_scale;
+  q.l1 = quantize_layer(weights.w1.data(), weights.b1.data(), kFeatureDim, h, x_clip / 127.0f,
+                        128);
+  q.l2 = quantize_layer(weights.w2.data(), weights.b2.data(), h, kFreshnessClassCount,
+                        h_clip / 255.0f, 0);
+  return q;
+}
+
+const Int8Backend& Int8Backend::reference() noexcept {
+  static const Int8Backend backend(nullptr, &kReferenceKernels);
+  return backend;
+}
+
+Int8Backend Int8Backend::load(const std::string& path) {
+  void* handle = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    throw std::runtime_error("Int8Backend: cannot load " + path + ": " + ::dlerror());
+  }
+  auto entry = reinterpret_cast<mq_int8_plugin_entry_fn>(::dlsym(handle, MQ_INT8_PLUGIN_ENTRY));
+  const mq_int8_kernels* kernels =
+      entry != nullptr
+          ? entry(MQ_INT8_PLUGIN_ABI, static_cast<int>(active_simd_level()))
+          : nullptr;
+  if (kernels == nullptr || kernels->abi != MQ_INT8_PLUGIN_ABI || kernels->gemm == nullptr) {
+    ::dlclose(handle);
+    throw std::runtime_error("Int8Backend: " + path + " is not a compatible INT8 plugin");
+  }
+  return Int8Backend(handle, kernels);
+}
+
+Int8Backend::Int8Backend(Int8Backend&& other) noexcept
+    : handle_(std::exchange(other.handle_, nullptr)), kernels_(other.kernels_) {}
+
+Int8Backend& Int8Backend::operator=(Int8Backend&& other) noexcept {
+  if (this != &other) {
+    if (handle_ != nullptr) ::dlclose(handle_);
+    handle_ = std::exchange(other.handle_, nullptr);
+    kernels_ = other.kernels_;
+  }
+  return *this;
+}
+
+Int8Backend::~Int8Backend() {
+  if (handle_ != nullptr) ::dlclose(handle_);
+}
+
+QuantizedClassifier::QuantizedClassifier(QuantizedWeights weights, const Int8Backend& backend)
+    : weights_(std::move(weights)), backend_(backend) {
+  const QuantizedWeights& w = weights_;
+  const auto layer_ok = [](const QuantizedLayer& l) {
+    return l.k % 4 == 0 && l.k >= l.in && l.out_padded % 16 == 0 && l.out_padded >= l.out &&
+           l.w.size() == l.out_padded * l.k && l.w_scale.size() == l.out_padded &&
+           l.bias.size() == l.out_padded && l.w_sums.size() == l.out_padded;
+  };
+  if (w.hidden == 0 || w.input_mean.size() != kFeatureDim ||
+      w.input_scale.size() != kFeatureDim || !layer_ok(w.l1) || !layer_ok(w.l2) ||
+      w.l1.in != kFeatureDim || w.l1.out != w.hidden || w.l2.in != w.hidden ||
+      w.l2.out != kFreshnessClassCount) {
+    throw std::invalid_argument("QuantizedClassifier: inconsistent layer shapes");
+  }
+}
+
+std::size_t QuantizedClassifier::scratch_size(std::size_t batch) const noexcept {
+  const QuantizedWeights& w = weights_;
+  return batch * (w.l1.k / 4 + w.l1.out_padded + w.l2.k / 4 + w.l2.out_padded);
+}
+
+void QuantizedClassifier::predict(const FeatureVector* inputs, std::size_t batch,
+                                  Prediction* out,
+                                  std::span<std::int32_t> scratch) const noexcept {
+  const QuantizedLayer& l1 = weights_.l1;
+  const QuantizedLayer& l2 = weights_.l2;
+  auto* a1 = reinterpret_cast<std::uint8_t*>(scratch.data());
+  std::int32_t* y1 = scratch.data() + batch * l1.k / 4;
+  auto* a2 = reinterpret_cast<std::uint8_t*>(y1 + batch * l1.out_padded);
+  std::int32_t* y2 = reinterpret_cast<std::int32_t*>(a2) + batch * l2.k / 4;
+
+  // Standardize and quantize; +0.5 then truncation rounds the clamped,
+  // non-negative value to nearest.
+  const float* mean = weights_.input_mean.data();
+  const float* scale = weights_.input_scale.data();
+  const float inv1 = 1.0f / l1.in_scale;
+  const float zp1 = float(l1.in_zero_point) + 0.5f;
+  for (std::size_t r = 0; r < batch; ++r) {
+    const float* src = inputs[r].data();
+    std::uint8_t* dst = a1 + r * l1.k;
+    for (std::size_t i = 0; i < kFeatureDim; ++i) {
+      // A missing (non-finite) feature is the training mean, as in the FP32
+      // model: the zero point. std::clamp would pass a NaN through, and
+      // converting that to an integer is undefined.
+      const float z = (src[i] - mean[i]) * scale[i];
+      dst[i] = std::isfinite(z)
+                   ? static_cast<std::uint8_t>(std::clamp(z * inv1 + zp1, 0.0f, 255.0f))
+                   : l1.in_zero_point;
+    }
+    std::fill(dst + kFeatureDim, dst + l1.k, l1.in_zero_point);
+  }
+  backend_.gemm()(a1, batch, l1.k, l1.w.data(), l1.out_padded, l1.bias.data(),
+                  l1.w_sums.data(), y1);
+
+  // ReLU and requantize into layer 2's uint8 input.
+  const std::size_t h = weights_.hidden;
+  const float inv2 = 1.0f / l2.in_scale;
+  for (std::size_t r = 0; r < batch; ++r) {
+    const std::int32_t* yr = y1 + r * l1.out_padded;
+    std::uint8_t* dst = a2 + r * l2.k;
+    for (std::size_t o = 0; o < h; ++o) {
+      const float v = float(yr[o]) * (l1.in_scale * l1.w_scale[o]) * inv2 + 0.5f;
+      // NaN only from non-finite scales; ReLU it to zero rather than cast it.
+      dst[o] = v > 0.0f ? static_cast<std::uint8_t>(std::min(v, 255.0f)) : std::uint8_t{0};
+    }
+    std::fill(dst + h, dst + l2.k, std::uint8_t{0});
+  }
+  backend_.gemm()(a2, batch, l2.k, l2.w.data(), l2.out_padded, l2.bias.data(),
+                  l2.w_sums.data(), y2);
+
+  for (std::size_t r = 0; r < batch; ++r) {
+    const std::int32_t* yr = y2 + r * l2.out_padded;
+    float logits[kFreshnessClassCount];
+    for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+      logits[k] = float(yr[k]) * l2.in_scale * l2.w_scale[k];
+    }
+    softmax(logits, out[r]);
+  }
+}
+
+Prediction QuantizedClassifier::predict(const FeatureVector& input) const {
+  std::vector<std::int32_t> scratch(scratch_size(1));
+  Prediction p;
+  predict(&input, 1, &p, scratch);
+  return p;
+}
+
+}  // namespace meat_quality
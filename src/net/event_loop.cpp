@@ -0,0 +1,160 @@
+#include "meat_quality/net/event_loop.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <utility>
+
+namespace meat_quality {
+namespace {
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+constexpr int kMaxEvents = 256;
+
+}  // namespace
+
+EventLoop::EventLoop() {
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) throw_errno("EventLoop: epoll_create1");
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd_ < 0) {
+    const int err = errno;
+    ::close(epoll_fd_);
+    throw std::system_error(err, std::generic_category(), "EventLoop: eventfd");
+  }
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;  // the wakeup descriptor
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) != 0) {
+    const int err = errno;
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+    throw std::system_error(err, std::generic_category(), "EventLoop: epoll_ctl");
+  }
+}
+
+EventLoop::~EventLoop() {
+  for (IoHandle* io = handles_; io != nullptr;) {
+    IoHandle* next = io->next;
+    ::close(io->fd);
+    delete io;
+    io = next;
+  }
+  for (IoHandle* io : graveyard_) delete io;
+  ::close(wake_fd_);
+  ::close(epoll_fd_);
+}
+
+IoHandle* EventLoop::attach(int fd) {
+  auto* io = new IoHandle;
+  io->fd = fd;
+  epoll_event ev{};
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.ptr = io;
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    const int err = errno;
+    delete io;
+    throw std::system_error(err, std::generic_category(), "EventLoop: epoll_ctl");
+  }
+  io->next = handles_;
+  if (handles_ != nullptr) handles_->prev = io;
+  handles_ = io;
+  if (shut_down_) ::shutdown(fd, SHUT_RDWR);
+  return io;
+}
+
+void EventLoop::detach(IoHandle* io) noexcept {
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, io->fd, nullptr);
+  ::close(io->fd);
+  io->fd = -1;
+  io->reader = io->writer = {};
+  if (io->prev != nullptr) io->prev->next = io->next;
+  if (io->next != nullptr) io->next->prev = io->prev;
+  if (handles_ == io) handles_ = io->next;
+  graveyard_.push_back(io);
+}
+
+void EventLoop::post(std::coroutine_handle<> h) {
+  {
+    std::lock_guard lock(posted_mutex_);
+    posted_.push_back(h);
+  }
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const ssize_t n = ::write(wake_fd_, &one, sizeof one);
+}
+
+void EventLoop::stop() noexcept {
+  stop_.store(true, std::memory_order_relaxed);
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const ssize_t n = ::write(wake_fd_, &one, sizeof one);
+}
+
+void EventLoop::run_posted() {
+  {
+    std::lock_guard lock(posted_mutex_);
+    running_.swap(posted_);
+  }
+  for (std::coroutine_handle<> h : running_) h.resume();
+  running_.clear();
+}
+
+void EventLoop::shut_down_all() {
+  shut_down_ = true;
+  // Collect first: resumed tasks detach their handles from the list.
+  std::vector<std::coroutine_handle<>> waiting;
+  for (IoHandle* io = handles_; io != nullptr; io = io->next) {
+    ::shutdown(io->fd, SHUT_RDWR);
+    if (io->reader) waiting.push_back(std::exchange(io->reader, {}));
+    if (io->writer) waiting.push_back(std::exchange(io->writer, {}));
+  }
+  for (std::coroutine_handle<> h : waiting) h.resume();
+}
+
+void EventLoop::run() {
+  epoll_event events[kMaxEvents];
+  for (;;) {
+    if (stopping() && !shut_down_) shut_down_all();
+    if (shut_down_ && live_tasks_ == 0) break;
+    const int n = ::epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      throw_errno("EventLoop: epoll_wait");
+    }
+    bool woken = false;
+    for (int i = 0; i < n; ++i) {
+      auto* io = static_cast<IoHandle*>(events[i].data.ptr);
+      if (io == nullptr) {
+        woken = true;
+        continue;
+      }
+      const std::uint32_t e = events[i].events;
+      // Both directions are taken before either resumes: a resumed task
+      // may detach, and the handle is then only kept alive by the graveyard.
+      std::coroutine_handle<> r, w;
+      if (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) r = std::exchange(io->reader, {});
+      if (e & (EPOLLOUT | EPOLLHUP | EPOLLERR)) w = std::exchange(io->writer, {});
+      if (r) r.resume();
+      if (w) w.resume();
+    }
+    if (woken) {
+      std::uint64_t count;
+      [[maybe_unused]] const ssize_t r = ::read(wake_fd_, &count, sizeof count);
+      run_posted();
+    }
+    for (IoHandle* io : graveyard_) delete io;
+    graveyard_.clear();
+  }
+  run_posted();
+  for (IoHandle* io : graveyard_) delete io;
+  graveyard_.clear();
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,231 @@
+#include "meat_quality/net/front_end.hpp"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "meat_quality/net/protocol.hpp"
+#include "meat_quality/net/socket.hpp"
+#include "meat_quality/telemetry/telemetry.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Accept errors that say nothing about the listening socket itself; the
+// pending connection is retried on the next edge.
+bool transient_accept_error(int err) noexcept {
+  return err == ECONNABORTED || err == EMFILE || err == ENFILE || err == ENOBUFS ||
+         err == ENOMEM || err == EPROTO || err == EPERM;
+}
+
+}  // namespace
+
+FrontEnd::FrontEnd(IngestQueue& ingest, GradeBroker& grades, FrontEndOptions options)
+    : ingest_(&ingest), grades_(&grades), options_(std::move(options)) {
+  if (ingest_->policy() == Backpressure::kBlock) {
+    throw std::invalid_argument("FrontEnd: a blocking ingest queue would stall the event loops");
+  }
+  open_listeners();
+}
+
+FrontEnd::FrontEnd(PartitionedGrader& grader, FrontEndOptions options)
+    : grader_(&grader), options_(std::move(options)) {
+  open_listeners();
+}
+
+void FrontEnd::open_listeners() {
+  if (options_.threads == 0 || options_.read_buffer < wire::kFrameHeaderBytes) {
+    throw std::invalid_argument("FrontEnd: invalid thread count or read buffer");
+  }
+  port_ = options_.port;
+  for (std::size_t i = 0; i < options_.threads; ++i) {
+    auto w = std::make_unique<Worker>();
+    w->listen_fd = listen_tcp(options_.host, port_, options_.backlog);
+    port_ = local_port(w->listen_fd);  // later sockets share the picked port
+    workers_.push_back(std::move(w));
+  }
+}
+
+FrontEnd::~FrontEnd() {
+  stop();
+  for (auto& w : workers_) {
+    if (w->listen_fd >= 0) ::close(w->listen_fd);
+  }
+}
+
+void FrontEnd::start() {
+  for (auto& w : workers_) {
+    if (w->thread.joinable() || w->listen_fd < 0) continue;
+    Worker* worker = w.get();
+    w->thread = std::thread([this, worker] {
+      accept_loop(*worker);
+      worker->loop.run();
+    });
+  }
+}
+
+void FrontEnd::stop() {
+  for (auto& w : workers_) w->loop.stop();
+  for (auto& w : workers_) {
+    if (w->thread.joinable()) w->thread.join();
+  }
+}
+
+FrontEndStats FrontEnd::stats() const noexcept {
+  FrontEndStats s;
+  s.accepted = accepted_.load(std::memory_order_relaxed);
+  s.open = s.accepted - closed_.load(std::memory_order_relaxed);
+  s.samples = samples_.load(std::memory_order_relaxed);
+  s.samples_dropped = samples_dropped_.load(std::memory_order_relaxed);
+  s.grades = grades_served_.load(std::memory_order_relaxed);
+  s.protocol_errors = protocol_errors_.load(std::memory_order_relaxed);
+  s.rate_hints = rate_hints_.load(std::memory_order_relaxed);
+  return s;
+}
+
+Detached FrontEnd::accept_loop(Worker& worker) {
+  EventLoop::TaskToken token(worker.loop);
+  std::optional<AsyncSocket> listener;
+  try {
+    listener.emplace(worker.loop, std::exchange(worker.listen_fd, -1));
+  } catch (const std::system_error&) {
+    co_return;
+  }
+  for (;;) {
+    const int fd = listener->accept();
+    if (fd >= 0) {
+      accepted_.fetch_add(1, std::memory_order_relaxed);
+      const int one = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+      serve_connection(worker.loop, fd);
+      continue;
+    }
+    if (fd != -EAGAIN && !transient_accept_error(-fd)) break;  // shut down
+    if (worker.loop.stopping()) break;
+    co_await listener->readable();
+  }
+}
+
+Detached FrontEnd::serve_connection(EventLoop& loop, int fd) {
+  EventLoop::TaskToken token(loop);
+  std::optional<AsyncSocket> sock;
+  try {
+    sock.emplace(loop, fd);
+  } catch (const std::system_error&) {
+    closed_.fetch_add(1, std::memory_order_relaxed);
+    co_return;
+  }
+
+  std::vector<std::uint8_t> in(options_.read_buffer);
+  std::vector<std::uint8_t> out;
+  std::uint64_t received_ns = 0;
+  const auto ingest = [&](const IngestRecord& record) {
+    if (options_.alerts != nullptr) options_.alerts->push(record, received_ns);
+    const bool stored = push(record);
+    std::uint32_t interval;
+    if (options_.rates != nullptr && options_.rates->claim_hint(record.node, interval)) {
+      wire::append_rate_hint(out, {record.node, interval});
+      rate_hints_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return stored;
+  };
+  std::size_t have = 0;
+  bool open = true;
+  bool bad_frame = false;
+  while (open) {
+    const std::ptrdiff_t n = sock->read(in.data() + have, in.size() - have);
+    if (n == AsyncSocket::kWouldBlock) {
+      co_await sock->readable();
+      continue;
+    }
+    if (n <= 0) break;
+    have += static_cast<std::size_t>(n);
+    if (options_.alerts != nullptr) received_ns = telemetry::now_ns();
+
+    std::size_t at = 0;
+    while (open && have - at >= wire::kFrameHeaderBytes) {
+      std::uint32_t length;
+      wire::FrameType type;
+      wire::parse_frame_header(in.data() + at, length, type);
+      if (length == 0 || length > options_.max_frame) {
+        bad_frame = true;
+        break;
+      }
+      const std::size_t frame = 4 + std::size_t{length};
+      if (have - at < frame) {
+        if (frame > in.size()) in.resize(frame);
+        break;
+      }
+      const std::span<const std::uint8_t> body(in.data() + at + wire::kFrameHeaderBytes,
+                                               length - 1);
+      at += frame;
+      std::uint32_t count;
+      wire::GradeRequestFrame request;
+      if (type == wire::FrameType::kSensorPush && wire::parse_sensor_push(body, count)) {
+        std::uint64_t stored = 0;
+        for (std::uint32_t i = 0; i < count; ++i) {
+          stored += ingest(wire::sensor_record(body.data(), i)) ? 1 : 0;
+        }
+        samples_.fetch_add(stored, std::memory_order_relaxed);
+        if (stored != count) samples_dropped_.fetch_add(count - stored, std::memory_order_relaxed);
+      } else if (type == wire::FrameType::kPackedPush) {
+        // Decoded once: records ahead of a malformed one are ingested, then
+        // the connection is dropped as for any other bad frame.
+        std::uint64_t decoded = 0;
+        std::uint64_t stored = 0;
+        wire::PackedPushReader reader(body);
+        for (IngestRecord r; reader.next(r); ++decoded) stored += ingest(r) ? 1 : 0;
+        samples_.fetch_add(stored, std::memory_order_relaxed);
+        if (stored != decoded) {
+          samples_dropped_.fetch_add(decoded - stored, std::memory_order_relaxed);
+        }
+        if (reader.failed()) {
+          bad_frame = true;
+          break;
+        }
+      } else if (type == wire::FrameType::kGradeRequest &&
+                 wire::parse_grade_request(body, request)) {
+        wire::GradeResponseFrame response;
+        response.id = request.id;
+        response.status =
+            co_await grade(loop, GradingRequest{request.node, request.at, {}}, response.result);
+        grades_served_.fetch_add(1, std::memory_order_relaxed);
+        wire::append_grade_response(out, response);
+      } else {
+        bad_frame = true;
+        break;
+      }
+      for (std::size_t sent = 0; open && sent < out.size();) {
+        const std::ptrdiff_t w = sock->write(out.data() + sent, out.size() - sent);
+        if (w == AsyncSocket::kWouldBlock) {
+          co_await sock->writable();
+        } else if (w < 0) {
+          open = false;
+        } else {
+          sent += static_cast<std::size_t>(w);
+        }
+      }
+      out.clear();
+    }
+    if (bad_frame) {
+      protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    std::memmove(in.data(), in.data() + at, have - at);
+    have -= at;
+    if (have == 0 && in.size() > options_.read_buffer) {
+      in.resize(options_.read_buffer);
+      in.shrink_to_fit();
+    }
+  }
+  closed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,53 @@
+#include "meat_quality/net/grade_broker.hpp"
+
+namespace meat_quality {
+
+bool GradeBroker::Awaiter::await_suspend(std::coroutine_handle<> h) noexcept {
+  handle_ = h;
+  if (broker_.queue_.push(this)) return true;
+  status_ = broker_.queue_.closed() ? wire::GradeStatus::kShuttingDown
+                                    : wire::GradeStatus::kOverloaded;
+  return false;  // resume right away
+}
+
+GradeBroker::GradeBroker(std::size_t capacity, std::size_t max_batch, NodeId node_base)
+    : queue_(capacity, Backpressure::kReject), node_base_(node_base) {
+  batch_.resize(max_batch == 0 ? 1 : max_batch);
+  requests_.reserve(batch_.size());
+  results_.resize(batch_.size());
+}
+
+std::size_t GradeBroker::serve(const GradingPipeline& pipeline,
+                               std::chrono::microseconds timeout) {
+  const std::size_t n = timeout.count() > 0
+                            ? queue_.pop_batch(batch_.data(), batch_.size(), timeout)
+                            : queue_.pop_batch(batch_.data(), batch_.size());
+  if (n == 0) return 0;
+  const SampleStore& store = pipeline.store();
+  requests_.clear();
+  for (std::size_t i = 0; i < n; ++i) {
+    Awaiter* a = batch_[i];
+    if (a->request_.node < node_base_ || a->request_.node - node_base_ >= store.node_count()) {
+      a->status_ = wire::GradeStatus::kUnknownNode;
+    } else {
+      requests_.push_back(a->request_);
+      requests_.back().node -= node_base_;
+    }
+  }
+  if (!requests_.empty()) {
+    pipeline.grade_batch(requests_, std::span(results_).first(requests_.size()));
+  }
+  std::size_t graded = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    Awaiter* a = batch_[i];
+    if (a->status_ == wire::GradeStatus::kOk) {
+      a->result_ = results_[graded++];
+      a->result_.node += node_base_;
+    }
+    // The awaiter lives in the coroutine frame; touch nothing after this.
+    a->loop_.post(a->handle_);
+  }
+  return n;
+}
+
+}  // namespace meat_quality
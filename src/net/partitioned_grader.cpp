@@ -0,0 +1,112 @@
+#include "meat_quality/net/partitioned_grader.hpp"
+
+#include <stdexcept>
+
+namespace meat_quality {
+
+PartitionedGrader::PartitionedGrader(const NumaTopology& topology,
+                                     const FreshnessClassifier& classifier,
+                                     const LabConverter& converter,
+                                     PartitionedGraderOptions options)
+    : classifier_(classifier), converter_(converter), options_(options) {
+  if (options_.node_count == 0 || options_.drain_batch == 0) {
+    throw std::invalid_argument("PartitionedGrader: node count and drain batch must be positive");
+  }
+  const std::size_t n = std::min(topology.node_count(), options_.node_count);
+  for (std::size_t i = 0; i < n; ++i) {
+    auto p = std::make_unique<Partition>();
+    p->cpus = topology.node(i).cpus;
+    // Ceiling bounds, so that partition_of() (a floor) agrees with them.
+    const auto bound = [&](std::size_t k) { return (k * options_.node_count + n - 1) / n; };
+    p->first = static_cast<NodeId>(bound(i));
+    p->nodes = bound(i + 1) - bound(i);
+    partitions_.push_back(std::move(p));
+  }
+}
+
+PartitionedGrader::~PartitionedGrader() { stop(); }
+
+void PartitionedGrader::start() {
+  if (started_.load() != 0) return;
+  for (auto& p : partitions_) {
+    Partition* part = p.get();
+    p->thread = std::thread([this, part] { run(*part); });
+  }
+  for (std::size_t s = 0; (s = started_.load()) < partitions_.size();) started_.wait(s);
+  for (auto& p : partitions_) {
+    if (p->error) {
+      stop();
+      std::rethrow_exception(p->error);
+    }
+  }
+}
+
+void PartitionedGrader::stop() {
+  stop_.store(true);
+  for (auto& p : partitions_) {
+    if (p->thread.joinable()) p->thread.join();
+  }
+}
+
+bool PartitionedGrader::push(const IngestRecord& record) noexcept {
+  Partition& p = *partitions_[partition_of(record.node)];
+  if (!p.ready.load(std::memory_order_acquire) || stop_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  IngestRecord local = record;
+  if (options_.registry != nullptr) {
+    const NodeRegistry::ReadGuard snapshot = options_.registry->read();
+    if (const NodeRecord* node = snapshot->find(record.node)) node->calibration.apply(local.sample);
+  }
+  local.node -= p.first;
+  if (p.queue->push(local)) return true;
+  p.rejected.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+PartitionedGraderStats PartitionedGrader::stats() const noexcept {
+  PartitionedGraderStats s;
+  for (const auto& p : partitions_) {
+    s.samples += p->samples.load(std::memory_order_relaxed);
+    s.rejected += p->rejected.load(std::memory_order_relaxed);
+    s.grades += p->grades.load(std::memory_order_relaxed);
+  }
+  return s;
+}
+
+void PartitionedGrader::run(Partition& p) {
+  pin_current_thread(p.cpus);
+  std::unique_ptr<SampleStore> store;
+  std::unique_ptr<FreshnessClassifier> classifier;
+  std::unique_ptr<GradingPipeline> pipeline;
+  std::vector<IngestRecord> batch;
+  try {
+    // Allocated (and zeroed) here, so first-touch keeps it on this socket.
+    p.queue = std::make_unique<IngestQueue>(options_.queue_capacity, Backpressure::kReject);
+    p.broker = std::make_unique<GradeBroker>(options_.grade_capacity, options_.drain_batch, p.first);
+    store = std::make_unique<SampleStore>(p.nodes, options_.capacity_per_node);
+    classifier = std::make_unique<FreshnessClassifier>(classifier_);
+    pipeline = std::make_unique<GradingPipeline>(*store, *classifier, converter_, options_.grading);
+    batch.resize(options_.drain_batch);
+  } catch (...) {
+    p.error = std::current_exception();
+  }
+  if (!p.error) p.ready.store(true, std::memory_order_release);
+  started_.fetch_add(1);
+  started_.notify_all();
+  if (p.error) return;
+
+  while (!stop_.load(std::memory_order_relaxed)) {
+    const DrainResult r = drain_batch(*p.queue, *store, batch, options_.poll);
+    p.samples.fetch_add(r.stored, std::memory_order_relaxed);
+    p.rejected.fetch_add(r.out_of_order + r.unknown_node, std::memory_order_relaxed);
+    p.grades.fetch_add(p.broker->serve(*pipeline), std::memory_order_relaxed);
+  }
+  p.ready.store(false, std::memory_order_relaxed);
+  p.broker->close();
+  while (p.broker->pending() != 0) {
+    p.grades.fetch_add(p.broker->serve(*pipeline), std::memory_order_relaxed);
+  }
+}
+
+}  // namespace meat_quality
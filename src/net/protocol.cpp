@@ -0,0 +1,274 @@
+#include "meat_quality/net/protocol.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace meat_quality::wire {
+namespace {
+
+template <typename T>
+using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t,
+                                std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint16_t>>;
+
+template <typename U>
+U to_little(U u) noexcept {
+  if constexpr (std::endian::native == std::endian::big) {
+    if constexpr (sizeof(U) == 8) return __builtin_bswap64(u);
+    if constexpr (sizeof(U) == 4) return __builtin_bswap32(u);
+    if constexpr (sizeof(U) == 2) return __builtin_bswap16(u);
+  }
+  return u;
+}
+
+template <typename T>
+void put(std::vector<std::uint8_t>& out, T v) {
+  const Bits<T> u = to_little(std::bit_cast<Bits<T>>(v));
+  const std::size_t at = out.size();
+  out.resize(at + sizeof u);
+  std::memcpy(out.data() + at, &u, sizeof u);
+}
+
+template <typename T>
+T get(const std::uint8_t* p) noexcept {
+  Bits<T> u;
+  std::memcpy(&u, p, sizeof u);
+  return std::bit_cast<T>(to_little(u));
+}
+
+void put_header(std::vector<std::uint8_t>& out, std::size_t body, FrameType type) {
+  put(out, static_cast<std::uint32_t>(body + 1));
+  out.push_back(static_cast<std::uint8_t>(type));
+}
+
+// Quantized value of a non-finite reading in kPackedPush.
+constexpr std::int64_t kPackedMissing = std::numeric_limits<std::int32_t>::min();
+constexpr std::int64_t kPackedMax = std::numeric_limits<std::int32_t>::max();
+
+constexpr std::uint64_t zigzag(std::int64_t v) noexcept {
+  return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+constexpr std::int64_t unzigzag(std::uint64_t v) noexcept {
+  return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+void put_varint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<std::uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(v));
+}
+
+// Null on truncation or an over-long encoding.
+inline const std::uint8_t* get_varint(const std::uint8_t* p, const std::uint8_t* end,
+                                      std::uint64_t& v) noexcept {
+  if (p != end && *p < 0x80) {  // most deltas fit one byte
+    v = *p;
+    return p + 1;
+  }
+  v = 0;
+  for (unsigned shift = 0; p != end && shift < 64; shift += 7) {
+    const std::uint8_t b = *p++;
+    v |= std::uint64_t{b & 0x7fu} << shift;
+    if ((b & 0x80) == 0) return p;
+  }
+  return nullptr;
+}
+
+std::int64_t quantize(float v, float scale) noexcept {
+  if (!std::isfinite(v)) return kPackedMissing;
+  const double q = std::nearbyint(double(v) * double(scale));
+  return static_cast<std::int64_t>(std::clamp(q, double(kPackedMissing + 1), double(kPackedMax)));
+}
+
+// Reciprocal steps, so decoding multiplies instead of divides.
+constexpr auto kPackedStep = [] {
+  std::array<double, kChannelCount> step{};
+  for (std::size_t c = 0; c < kChannelCount; ++c) step[c] = 1.0 / double(kPackedScale[c]);
+  return step;
+}();
+
+float dequantize(std::int64_t q, std::size_t channel) noexcept {
+  return q == kPackedMissing ? std::numeric_limits<float>::quiet_NaN()
+                             : static_cast<float>(double(q) * kPackedStep[channel]);
+}
+
+}  // namespace
+
+void parse_frame_header(const std::uint8_t* p, std::uint32_t& length, FrameType& type) noexcept {
+  length = get<std::uint32_t>(p);
+  type = static_cast<FrameType>(p[4]);
+}
+
+void append_sensor_push(std::vector<std::uint8_t>& out, std::span<const IngestRecord> records) {
+  out.reserve(out.size() + kFrameHeaderBytes + 4 + records.size() * kSampleRecordBytes);
+  put_header(out, 4 + records.size() * kSampleRecordBytes, FrameType::kSensorPush);
+  put(out, static_cast<std::uint32_t>(records.size()));
+  for (const IngestRecord& r : records) {
+    put(out, r.node);
+    put(out, r.sample.timestamp);
+    for (float v : r.sample.values) put(out, v);
+  }
+}
+
+void append_grade_request(std::vector<std::uint8_t>& out, const GradeRequestFrame& request) {
+  put_header(out, kGradeRequestBytes, FrameType::kGradeRequest);
+  put(out, request.id);
+  put(out, request.node);
+  put(out, request.at);
+}
+
+void append_grade_response(std::vector<std::uint8_t>& out, const GradeResponseFrame& response) {
+  put_header(out, kGradeResponseBytes, FrameType::kGradeResponse);
+  put(out, response.id);
+  out.push_back(static_cast<std::uint8_t>(response.status));
+  out.push_back(static_cast<std::uint8_t>(response.result.sensor.label));
+  put(out, std::uint16_t{0});
+  put(out, response.result.samples);
+  put(out, response.result.at);
+  for (float p : response.result.sensor.probabilities) put(out, p);
+}
+
+void append_rate_hint(std::vector<std::uint8_t>& out, const RateHintFrame& hint) {
+  put_header(out, kRateHintBytes, FrameType::kRateHint);
+  put(out, hint.node);
+  put(out, hint.interval_ms);
+}
+
+void append_packed_push(std::vector<std::uint8_t>& out, std::span<const IngestRecord> records) {
+  const std::size_t at = out.size();
+  put_header(out, 0, FrameType::kPackedPush);  // length patched below
+  out.reserve(out.size() + 10 + records.size() * kMaxPackedRecordBytes);
+  put_varint(out, records.size());
+  for (std::size_t i = 0; i < records.size();) {
+    const NodeId node = records[i].node;
+    std::size_t n = 1;
+    while (i + n < records.size() && records[i + n].node == node) ++n;
+    put_varint(out, node);
+    put_varint(out, n);
+    Timestamp prev_t = 0;
+    std::int64_t prev[kChannelCount] = {};
+    for (const IngestRecord& r : records.subspan(i, n)) {
+      // Wrapping difference; the reader adds it back the same way.
+      const std::uint64_t dt =
+          static_cast<std::uint64_t>(r.sample.timestamp) - static_cast<std::uint64_t>(prev_t);
+      put_varint(out, zigzag(static_cast<std::int64_t>(dt)));
+      prev_t = r.sample.timestamp;
+      for (std::size_t c = 0; c < kChannelCount; ++c) {
+        const std::int64_t q = quantize(r.sample.values[c], kPackedScale[c]);
+        put_varint(out, zigzag(q - prev[c]));
+        prev[c] = q;
+      }
+    }
+    i += n;
+  }
+  const auto length = to_little(static_cast<std::uint32_t>(out.size() - at - 4));
+  std::memcpy(out.data() + at, &length, sizeof length);
+}
+
+IngestRecord sensor_record(const std::uint8_t* body, std::size_t i) noexcept {
+  const std::uint8_t* p = body + 4 + i * kSampleRecordBytes;
+  IngestRecord r;
+  r.node = get<std::uint32_t>(p);
+  r.sample.timestamp = get<std::int64_t>(p + 4);
+  for (std::size_t c = 0; c < kChannelCount; ++c) r.sample.values[c] = get<float>(p + 12 + 4 * c);
+  return r;
+}
+
+bool parse_sensor_push(std::span<const std::uint8_t> body, std::uint32_t& count) noexcept {
+  if (body.size() < 4) return false;
+  count = get<std::uint32_t>(body.data());
+  return body.size() - 4 == std::size_t{count} * kSampleRecordBytes;
+}
+
+bool parse_grade_request(std::span<const std::uint8_t> body, GradeRequestFrame& out) noexcept {
+  if (body.size() != kGradeRequestBytes) return false;
+  out.id = get<std::uint64_t>(body.data());
+  out.node = get<std::uint32_t>(body.data() + 8);
+  out.at = get<std::int64_t>(body.data() + 12);
+  return true;
+}
+
+bool parse_grade_response(std::span<const std::uint8_t> body, GradeResponseFrame& out) noexcept {
+  if (body.size() != kGradeResponseBytes) return false;
+  const std::uint8_t* p = body.data();
+  if (p[8] > static_cast<std::uint8_t>(GradeStatus::kShuttingDown) ||
+      p[9] > static_cast<std::uint8_t>(FreshnessClass::kUnknown)) {
+    return false;
+  }
+  out.id = get<std::uint64_t>(p);
+  out.status = static_cast<GradeStatus>(p[8]);
+  out.result.sensor.label = static_cast<FreshnessClass>(p[9]);
+  out.result.samples = get<std::uint32_t>(p + 12);
+  out.result.at = get<Timestamp>(p + 16);
+  for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+    out.result.sensor.probabilities[k] = get<float>(p + 24 + 4 * k);
+  }
+  return true;
+}
+
+bool parse_rate_hint(std::span<const std::uint8_t> body, RateHintFrame& out) noexcept {
+  if (body.size() != kRateHintBytes) return false;
+  out.node = get<std::uint32_t>(body.data());
+  out.interval_ms = get<std::uint32_t>(body.data() + 4);
+  return out.interval_ms != 0;
+}
+
+bool parse_packed_push(std::span<const std::uint8_t> body, std::uint32_t& count) noexcept {
+  PackedPushReader reader(body);
+  for (IngestRecord r; reader.next(r);) {
+  }
+  count = reader.count();
+  return !reader.failed();
+}
+
+PackedPushReader::PackedPushReader(std::span<const std::uint8_t> body) noexcept
+    : p_(body.data()), end_(body.data() + body.size()) {
+  std::uint64_t count = 0;
+  p_ = get_varint(p_, end_, count);
+  if (p_ == nullptr || count > std::numeric_limits<std::uint32_t>::max()) {
+    fail();
+    return;
+  }
+  count_ = static_cast<std::uint32_t>(count);
+}
+
+bool PackedPushReader::next(IngestRecord& out) noexcept {
+  std::uint64_t v = 0;
+  if (run_left_ == 0) {
+    // The runs must add up to the declared count, no more and no less.
+    if (p_ == end_) return read_ == count_ ? false : fail();
+    if ((p_ = get_varint(p_, end_, v)) == nullptr || v > std::numeric_limits<NodeId>::max()) {
+      return fail();
+    }
+    node_ = static_cast<NodeId>(v);
+    if ((p_ = get_varint(p_, end_, run_left_)) == nullptr || run_left_ == 0) return fail();
+    timestamp_ = 0;
+    std::fill(std::begin(values_), std::end(values_), 0);
+  }
+  if ((p_ = get_varint(p_, end_, v)) == nullptr) return fail();
+  timestamp_ = static_cast<std::int64_t>(static_cast<std::uint64_t>(timestamp_) +
+                                         static_cast<std::uint64_t>(unzigzag(v)));
+  out.node = node_;
+  out.sample.timestamp = timestamp_;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if ((p_ = get_varint(p_, end_, v)) == nullptr) return fail();
+    const std::int64_t d = unzigzag(v);
+    // Both ends stay in the 32-bit range, so a valid delta does too.
+    if (d < kPackedMissing - kPackedMax || d > kPackedMax - kPackedMissing) return fail();
+    const std::int64_t q = values_[c] + d;
+    if (q < kPackedMissing || q > kPackedMax) return fail();
+    values_[c] = q;
+    out.sample.values[c] = dequantize(q, c);
+  }
+  --run_left_;
+  return ++read_ <= count_ || fail();
+}
+
+}  // namespace meat_quality::wire
@@ -0,0 +1,93 @@
+#include "meat_quality/net/socket.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <system_error>
+
+namespace meat_quality {
+namespace {
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+}  // namespace
+
+AsyncSocket::AsyncSocket(EventLoop& loop, int fd) : loop_(loop) {
+  const int flags = ::fcntl(fd, F_GETFL);
+  if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+    const int err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::generic_category(), "AsyncSocket: fcntl");
+  }
+  try {
+    io_ = loop_.attach(fd);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+AsyncSocket::~AsyncSocket() { loop_.detach(io_); }
+
+std::ptrdiff_t AsyncSocket::read(void* data, std::size_t size) noexcept {
+  for (;;) {
+    const ssize_t n = ::recv(io_->fd, data, size, 0);
+    if (n >= 0) return n;
+    if (errno != EINTR) return errno == EWOULDBLOCK ? kWouldBlock : -errno;
+  }
+}
+
+std::ptrdiff_t AsyncSocket::write(const void* data, std::size_t size) noexcept {
+  for (;;) {
+    const ssize_t n = ::send(io_->fd, data, size, MSG_NOSIGNAL);
+    if (n >= 0) return n;
+    if (errno != EINTR) return errno == EWOULDBLOCK ? kWouldBlock : -errno;
+  }
+}
+
+int AsyncSocket::accept() noexcept {
+  for (;;) {
+    const int fd = ::accept4(io_->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd >= 0) return fd;
+    if (errno != EINTR) return errno == EWOULDBLOCK ? -EAGAIN : -errno;
+  }
+}
+
+int listen_tcp(const std::string& host, std::uint16_t port, int backlog) {
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+    throw std::invalid_argument("listen_tcp: not an IPv4 address: " + host);
+  }
+  const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) throw_errno("listen_tcp: socket");
+  const int one = 1;
+  if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one) != 0 ||
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof one) != 0 ||
+      ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 ||
+      ::listen(fd, backlog) != 0) {
+    const int err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::generic_category(), "listen_tcp");
+  }
+  return fd;
+}
+
+std::uint16_t local_port(int fd) {
+  sockaddr_in addr{};
+  socklen_t len = sizeof addr;
+  if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+    throw_errno("local_port: getsockname");
+  }
+  return ntohs(addr.sin_port);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,94 @@
+#include "meat_quality/storage/feature_matrix.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+namespace {
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+constexpr std::uint64_t align_up(std::uint64_t n) noexcept {
+  return (n + kCacheLineSize - 1) & ~std::uint64_t{kCacheLineSize - 1};
+}
+
+}  // namespace
+
+FeatureMatrixWriter::FeatureMatrixWriter(const std::string& path, std::uint64_t rows,
+                                         std::span<const ColumnSpec> columns)
+    : rows_(rows) {
+  std::uint64_t at = align_up(sizeof(feature_matrix::FileHeader) +
+                              columns.size() * sizeof(feature_matrix::ColumnEntry));
+  for (const ColumnSpec& c : columns) {
+    if (c.name.empty() || c.name.size() > feature_matrix::kMaxNameBytes) {
+      throw std::invalid_argument("FeatureMatrixWriter: bad column name '" + c.name + "'");
+    }
+    feature_matrix::ColumnEntry e{};
+    std::memcpy(e.name, c.name.data(), c.name.size());
+    e.type = c.type;
+    e.offset = at;
+    entries_.push_back(e);
+    at = align_up(at + rows_ * feature_matrix::column_type_size(c.type));
+  }
+  fd_ = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw_errno("FeatureMatrixWriter: open");
+  if (::ftruncate(fd_, static_cast<off_t>(at)) != 0) {
+    const int e = errno;
+    ::close(fd_);
+    throw std::system_error(e, std::generic_category(), "FeatureMatrixWriter: ftruncate");
+  }
+}
+
+FeatureMatrixWriter::~FeatureMatrixWriter() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+void FeatureMatrixWriter::write_raw(std::size_t column, feature_matrix::ColumnType type,
+                                    std::uint64_t first_row, const void* data,
+                                    std::size_t count) {
+  if (column >= entries_.size() || entries_[column].type != type || first_row > rows_ ||
+      count > rows_ - first_row) {
+    throw std::invalid_argument("FeatureMatrixWriter: write does not fit the column");
+  }
+  const std::size_t size = feature_matrix::column_type_size(type);
+  write_at(data, count * size, entries_[column].offset + first_row * size);
+}
+
+void FeatureMatrixWriter::write_at(const void* data, std::size_t n, std::uint64_t offset) {
+  const auto* p = static_cast<const std::uint8_t*>(data);
+  while (n != 0) {
+    const ssize_t k = ::pwrite(fd_, p, n, static_cast<off_t>(offset));
+    if (k < 0) {
+      if (errno == EINTR) continue;
+      throw_errno("FeatureMatrixWriter: pwrite");
+    }
+    p += k;
+    n -= static_cast<std::size_t>(k);
+    offset += static_cast<std::uint64_t>(k);
+  }
+}
+
+void FeatureMatrixWriter::finish() {
+  if (fd_ < 0) return;
+  write_at(entries_.data(), entries_.size() * sizeof(feature_matrix::ColumnEntry),
+           sizeof(feature_matrix::FileHeader));
+  if (::fsync(fd_) != 0) throw_errno("FeatureMatrixWriter: fsync");
+  // The header goes last, so a crashed export never looks complete.
+  const feature_matrix::FileHeader header{feature_matrix::kMagic, feature_matrix::kVersion,
+                                          static_cast<std::uint32_t>(entries_.size()), rows_, 0};
+  write_at(&header, sizeof header, 0);
+  if (::fsync(fd_) != 0) throw_errno("FeatureMatrixWriter: fsync");
+  ::close(fd_);
+  fd_ = -1;
+}
+
+}  // namespace meat_quality
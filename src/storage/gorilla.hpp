@@ -0,0 +1,208 @@
+#pragma once
+
+// Bit-stream codecs shared by the segment writer and reader: delta-of-delta
+// timestamps and Gorilla XOR floats (Pelkonen et al., VLDB 2015), adapted to
+// 32-bit floats and microsecond timestamps.
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "meat_quality/core/types.hpp"
+
+namespace meat_quality::gorilla::detail {
+
+/// MSB-first bit writer appending to a byte vector.
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<std::uint8_t>& out) noexcept : out_(out) {}
+
+  /// Appends the low `n` bits of `v`, 1 <= n <= 64.
+  void write(std::uint64_t v, unsigned n) {
+    if (n < 64) v &= (std::uint64_t{1} << n) - 1;
+    const unsigned room = 64 - fill_;
+    if (n < room) {
+      acc_ |= v << (room - n);
+      fill_ += n;
+      return;
+    }
+    const unsigned rest = n - room;
+    acc_ |= v >> rest;
+    put(acc_, 8);
+    acc_ = rest == 0 ? 0 : v << (64 - rest);
+    fill_ = rest;
+  }
+
+  /// Writes out the partial last word, zero-padded to a byte.
+  void finish() {
+    put(acc_, (fill_ + 7) / 8);
+    acc_ = 0;
+    fill_ = 0;
+  }
+
+ private:
+  void put(std::uint64_t word, unsigned bytes) {
+    for (unsigned i = 0; i < bytes; ++i)
+      out_.push_back(static_cast<std::uint8_t>(word >> (56 - 8 * i)));
+  }
+
+  std::vector<std::uint8_t>& out_;
+  std::uint64_t acc_ = 0;
+  unsigned fill_ = 0;
+};
+
+/// Reads what BitWriter wrote to [data, end). Loads whole 8-byte words
+/// while they fit; bits past `end` read as zero, so a corrupt stream decodes
+/// to garbage values but never reads outside its buffer.
+class BitReader {
+ public:
+  BitReader(const std::uint8_t* data, const std::uint8_t* end) noexcept
+      : data_(data), size_(static_cast<std::size_t>(end - data)) {}
+
+  /// Next `n` bits without consuming them, 1 <= n <= 57.
+  std::uint64_t peek(unsigned n) const noexcept {
+    const std::size_t at = pos_ >> 3;
+    std::uint64_t w = 0;
+    if (at + sizeof w <= size_) {
+      std::memcpy(&w, data_ + at, sizeof w);
+    } else if (at < size_) {
+      std::memcpy(&w, data_ + at, size_ - at);
+    }
+    if constexpr (std::endian::native == std::endian::little) w = __builtin_bswap64(w);
+    return (w << (pos_ & 7)) >> (64 - n);
+  }
+
+  void skip(unsigned n) noexcept { pos_ += n; }
+
+  std::uint64_t read(unsigned n) noexcept {
+    if (n > 57) {
+      const std::uint64_t hi = read(n - 32);
+      return (hi << 32) | read(32);
+    }
+    const std::uint64_t v = peek(n);
+    pos_ += n;
+    return v;
+  }
+
+ private:
+  const std::uint8_t* data_;
+  std::size_t size_;
+  std::size_t pos_ = 0;
+};
+
+constexpr std::uint64_t zigzag(std::int64_t v) noexcept {
+  return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+constexpr std::int64_t unzigzag(std::uint64_t v) noexcept {
+  return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+// Delta-of-delta buckets: a unary prefix of 0-4 ones (terminated by a zero)
+// selects the payload width; five ones mean a raw 64-bit value. With 10 Hz
+// samples and millisecond jitter most timestamps cost 1-16 bits.
+inline constexpr unsigned kDodBits[5] = {0, 7, 9, 12, 20};
+
+inline void encode_timestamps(const Timestamp* t, std::size_t n, BitWriter& w) {
+  w.write(static_cast<std::uint64_t>(t[0]), 64);
+  std::int64_t prev_delta = 0;
+  for (std::size_t i = 1; i < n; ++i) {
+    const std::int64_t delta = t[i] - t[i - 1];
+    const std::uint64_t z = zigzag(delta - prev_delta);
+    prev_delta = delta;
+    unsigned bucket = 0;
+    while (bucket < 5 && z >= (std::uint64_t{1} << kDodBits[bucket])) ++bucket;
+    if (bucket == 0) {
+      w.write(0, 1);
+    } else if (bucket < 5) {
+      // `bucket` ones, a zero, then the payload.
+      w.write(((std::uint64_t{1} << bucket) - 1) << 1, bucket + 1);
+      w.write(z, kDodBits[bucket]);
+    } else {
+      w.write(0x1f, 5);
+      w.write(z, 64);
+    }
+  }
+}
+
+inline void decode_timestamps(BitReader& r, std::size_t n, Timestamp* out) noexcept {
+  out[0] = static_cast<Timestamp>(r.read(64));
+  // Unsigned so that deltas decoded from a damaged stream wrap instead of
+  // overflowing.
+  std::uint64_t delta = 0;
+  for (std::size_t i = 1; i < n; ++i) {
+    const auto prefix = static_cast<std::uint8_t>(r.peek(5) << 3);
+    const unsigned ones = static_cast<unsigned>(std::countl_one(prefix));
+    std::uint64_t z = 0;
+    if (ones >= 5) {
+      r.skip(5);
+      z = r.read(64);
+    } else {
+      r.skip(ones + 1);
+      if (ones != 0) z = r.read(kDodBits[ones]);
+    }
+    delta += static_cast<std::uint64_t>(unzigzag(z));
+    out[i] = static_cast<Timestamp>(static_cast<std::uint64_t>(out[i - 1]) + delta);
+  }
+}
+
+// XOR with the previous value's bit pattern: "0" if equal; "10" plus the
+// meaningful bits if they fit the previous leading/trailing-zero window;
+// otherwise "11", 5 bits of leading zeros, 5 bits of length - 1, bits.
+inline void encode_floats(const float* x, std::size_t n, BitWriter& w) {
+  std::uint32_t prev = std::bit_cast<std::uint32_t>(x[0]);
+  w.write(prev, 32);
+  unsigned lead = 33, trail = 0;  // no window yet
+  for (std::size_t i = 1; i < n; ++i) {
+    const std::uint32_t cur = std::bit_cast<std::uint32_t>(x[i]);
+    const std::uint32_t v = cur ^ prev;
+    prev = cur;
+    if (v == 0) {
+      w.write(0, 1);
+      continue;
+    }
+    const auto l = static_cast<unsigned>(std::countl_zero(v));
+    const auto t = static_cast<unsigned>(std::countr_zero(v));
+    if (lead <= 32 && l >= lead && t >= trail) {
+      w.write(0b10, 2);
+      w.write(v >> trail, 32 - lead - trail);
+    } else {
+      const unsigned len = 32 - l - t;
+      w.write(0b11, 2);
+      w.write(l, 5);
+      w.write(len - 1, 5);
+      w.write(v >> t, len);
+      lead = l;
+      trail = t;
+    }
+  }
+}
+
+inline void decode_floats(BitReader& r, std::size_t n, float* out) noexcept {
+  std::uint32_t prev = static_cast<std::uint32_t>(r.read(32));
+  out[0] = std::bit_cast<float>(prev);
+  unsigned lead = 0, trail = 0;
+  for (std::size_t i = 1; i < n; ++i) {
+    const std::uint64_t ctl = r.peek(2);
+    if ((ctl & 0b10) == 0) {
+      r.skip(1);
+    } else if (ctl == 0b10) {
+      r.skip(2);
+      prev ^= static_cast<std::uint32_t>(r.read(32 - lead - trail) << trail);
+    } else {
+      r.skip(2);
+      lead = static_cast<unsigned>(r.read(5));
+      unsigned len = static_cast<unsigned>(r.read(5)) + 1;
+      // The writer never emits a window wider than 32 bits; clamp a damaged
+      // one so the shifts stay in range and lead + trail stays below 32.
+      if (lead + len > 32) len = 32 - lead;
+      trail = 32 - lead - len;
+      prev ^= static_cast<std::uint32_t>(r.read(len) << trail);
+    }
+    out[i] = std::bit_cast<float>(prev);
+  }
+}
+
+}  // namespace meat_quality::gorilla::detail
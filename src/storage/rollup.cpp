@@ -0,0 +1,236 @@
+#include "meat_quality/storage/rollup.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace meat_quality {
+namespace {
+
+// Buffered output flushed in writes of about this size.
+constexpr std::size_t kFlushBytes = std::size_t{1} << 16;
+
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+void write_all(int fd, const void* data, std::size_t n, const char* what) {
+  const auto* p = static_cast<const std::uint8_t*>(data);
+  while (n != 0) {
+    const ssize_t k = ::write(fd, p, n);
+    if (k < 0) {
+      if (errno == EINTR) continue;
+      throw_errno(what);
+    }
+    p += k;
+    n -= static_cast<std::size_t>(k);
+  }
+}
+
+}  // namespace
+
+void RollupAccumulator::reset(Timestamp t) noexcept {
+  t_ = t;
+  count_ = 0;
+  sum_.fill(0);
+  weight_.fill(0);
+  min_.fill(std::numeric_limits<float>::infinity());
+  max_.fill(-std::numeric_limits<float>::infinity());
+}
+
+void RollupAccumulator::add(const SensorSample& sample) noexcept {
+  ++count_;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    const float v = sample.values[c];
+    if (std::isnan(v)) continue;
+    sum_[c] += v;
+    ++weight_[c];
+    min_[c] = std::min(min_[c], v);
+    max_[c] = std::max(max_[c], v);
+  }
+}
+
+void RollupAccumulator::add(const rollup::Bucket& finer) noexcept {
+  count_ += finer.count;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (finer.readings[c] == 0) continue;
+    sum_[c] += double{finer.mean[c]} * finer.readings[c];
+    weight_[c] += finer.readings[c];
+    min_[c] = std::min(min_[c], finer.min[c]);
+    max_[c] = std::max(max_[c], finer.max[c]);
+  }
+}
+
+rollup::Bucket RollupAccumulator::bucket() const noexcept {
+  rollup::Bucket b{};
+  b.t = t_;
+  b.count = static_cast<std::uint32_t>(std::min<std::uint64_t>(count_, UINT32_MAX));
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    const bool any = weight_[c] != 0;
+    b.min[c] = any ? min_[c] : kNaN;
+    b.max[c] = any ? max_[c] : kNaN;
+    b.mean[c] = any ? static_cast<float>(sum_[c] / static_cast<double>(weight_[c])) : kNaN;
+    b.readings[c] = static_cast<std::uint32_t>(std::min<std::uint64_t>(weight_[c], UINT32_MAX));
+  }
+  return b;
+}
+
+RollupWriter::RollupWriter(const std::string& path, Timestamp resolution)
+    : resolution_(resolution) {
+  if (resolution_ <= 0) throw std::invalid_argument("RollupWriter: non-positive resolution");
+  fd_ = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw_errno("RollupWriter: open");
+  // Rewritten by finish() once the time range is known.
+  pending_.resize(sizeof(rollup::FileHeader));
+}
+
+RollupWriter::~RollupWriter() {
+  if (fd_ < 0) return;
+  try {
+    finish();
+  } catch (...) {
+    if (fd_ >= 0) ::close(fd_);
+  }
+}
+
+bool RollupWriter::append(NodeId node, const SensorSample& sample) {
+  const Timestamp t = sample.timestamp;
+  const bool same_node = !index_.empty() && index_.back().node == node;
+  if (!index_.empty() && node < index_.back().node) return false;
+  if (same_node && t < newest_) return false;
+  const Timestamp start = rollup::bucket_start(t, resolution_);
+  if (!same_node || start != open_.start()) {
+    close_bucket();
+    if (!same_node) index_.push_back({node, 0, buckets_, 0});
+    open_.reset(start);
+  }
+  newest_ = t;
+  open_.add(sample);
+  from_ = std::min(from_, t);
+  to_ = std::max(to_, t);
+  return true;
+}
+
+void RollupWriter::close_bucket() {
+  if (open_.empty()) return;
+  const rollup::Bucket b = open_.bucket();
+  const auto* p = reinterpret_cast<const std::uint8_t*>(&b);
+  pending_.insert(pending_.end(), p, p + sizeof b);
+  ++buckets_;
+  ++index_.back().count;
+  open_.reset(open_.start());
+  if (pending_.size() >= kFlushBytes) flush();
+}
+
+void RollupWriter::flush() {
+  write_all(fd_, pending_.data(), pending_.size(), "RollupWriter: write");
+  offset_ += pending_.size();
+  pending_.clear();
+}
+
+void RollupWriter::finish() {
+  if (fd_ < 0) return;
+  close_bucket();
+  const rollup::Trailer trailer{offset_ + pending_.size(), index_.size(), rollup::kMagic};
+  const auto* idx = reinterpret_cast<const std::uint8_t*>(index_.data());
+  pending_.insert(pending_.end(), idx, idx + index_.size() * sizeof(rollup::NodeEntry));
+  const auto* tr = reinterpret_cast<const std::uint8_t*>(&trailer);
+  pending_.insert(pending_.end(), tr, tr + sizeof trailer);
+  flush();
+
+  const rollup::FileHeader header{rollup::kMagic,
+                                  rollup::kVersion,
+                                  static_cast<std::uint32_t>(kChannelCount),
+                                  resolution_,
+                                  buckets_ == 0 ? 0 : from_,
+                                  buckets_ == 0 ? -1 : to_};
+  if (::pwrite(fd_, &header, sizeof header, 0) != static_cast<ssize_t>(sizeof header)) {
+    throw_errno("RollupWriter: pwrite");
+  }
+  const int fd = std::exchange(fd_, -1);
+  if (::close(fd) < 0) throw_errno("RollupWriter: close");
+}
+
+RollupReader::RollupReader(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) throw_errno("RollupReader: open");
+  struct stat st {};
+  if (::fstat(fd, &st) < 0) {
+    const int e = errno;
+    ::close(fd);
+    throw std::system_error(e, std::generic_category(), "RollupReader: fstat");
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ < sizeof(rollup::FileHeader) + sizeof(rollup::Trailer)) {
+    ::close(fd);
+    throw std::runtime_error("RollupReader: " + path + " is too short");
+  }
+  base_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  const int e = errno;
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    throw std::system_error(e, std::generic_category(), "RollupReader: mmap");
+  }
+
+  rollup::Trailer trailer;
+  std::memcpy(&trailer, bytes() + size_ - sizeof trailer, sizeof trailer);
+  const std::uint64_t index_end = size_ - sizeof trailer;
+  const std::uint64_t data_bytes = trailer.index_offset - sizeof(rollup::FileHeader);
+  bool valid = header().magic == rollup::kMagic && header().version == rollup::kVersion &&
+               header().channel_count == kChannelCount && header().resolution > 0 &&
+               trailer.magic == rollup::kMagic &&
+               trailer.index_offset >= sizeof(rollup::FileHeader) &&
+               trailer.index_offset <= index_end && data_bytes % sizeof(rollup::Bucket) == 0 &&
+               trailer.node_count == (index_end - trailer.index_offset) / sizeof(rollup::NodeEntry);
+  if (valid) {
+    index_ = {reinterpret_cast<const rollup::NodeEntry*>(bytes() + trailer.index_offset),
+              static_cast<std::size_t>(trailer.node_count)};
+    buckets_ = reinterpret_cast<const rollup::Bucket*>(bytes() + sizeof(rollup::FileHeader));
+    bucket_count_ = data_bytes / sizeof(rollup::Bucket);
+    for (const rollup::NodeEntry& n : index_) {
+      if (n.first > bucket_count_ || n.count > bucket_count_ - n.first) valid = false;
+    }
+  }
+  if (!valid) {
+    ::munmap(base_, size_);
+    base_ = nullptr;
+    throw std::runtime_error("RollupReader: " + path + " is not a valid rollup file");
+  }
+}
+
+RollupReader::~RollupReader() {
+  if (base_ != nullptr) ::munmap(base_, size_);
+}
+
+std::span<const rollup::Bucket> RollupReader::buckets(NodeId node, Timestamp from,
+                                                      Timestamp to) const noexcept {
+  const auto n = std::lower_bound(index_.begin(), index_.end(), node,
+                                  [](const rollup::NodeEntry& e, NodeId id) {
+                                    return e.node < id;
+                                  });
+  if (n == index_.end() || n->node != node) return {};
+  const rollup::Bucket* first = buckets_ + n->first;
+  const rollup::Bucket* last = first + n->count;
+  const Timestamp span = resolution() - 1;
+  first = std::lower_bound(first, last, from, [span](const rollup::Bucket& b, Timestamp t) {
+    return b.t + span < t;
+  });
+  last = std::upper_bound(first, last, to, [](Timestamp t, const rollup::Bucket& b) {
+    return t < b.t;
+  });
+  return {first, last};
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,263 @@
+#include "meat_quality/storage/segment.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "gorilla.hpp"
+
+namespace meat_quality {
+namespace {
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+void pad_to_word(std::vector<std::uint8_t>& bytes) {
+  bytes.resize((bytes.size() + 7) & ~std::size_t{7}, 0);
+}
+
+}  // namespace
+
+SegmentWriter::SegmentWriter(const std::string& path, std::uint32_t block_samples)
+    : block_samples_(block_samples) {
+  if (block_samples_ < 2) throw std::invalid_argument("SegmentWriter: block too small");
+  fd_ = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw_errno("SegmentWriter: open");
+  const segment::FileHeader header{segment::kMagic, segment::kVersion,
+                                   static_cast<std::uint32_t>(kChannelCount),
+                                   block_samples_, 0};
+  write_bytes(&header, sizeof header);
+}
+
+SegmentWriter::~SegmentWriter() {
+  if (fd_ < 0) return;
+  try {
+    finish();
+  } catch (...) {
+    if (fd_ >= 0) ::close(fd_);
+  }
+}
+
+bool SegmentWriter::append(NodeId node, const SensorSample& sample) {
+  NodeBuffer& buf = nodes_[node];
+  if (sample.timestamp < buf.newest) return false;
+  if (buf.timestamps.empty()) {
+    buf.timestamps.reserve(block_samples_);
+    for (std::vector<float>& c : buf.channels) c.reserve(block_samples_);
+  }
+  buf.newest = sample.timestamp;
+  buf.timestamps.push_back(sample.timestamp);
+  for (std::size_t c = 0; c < kChannelCount; ++c) buf.channels[c].push_back(sample.values[c]);
+  ++samples_;
+  if (buf.timestamps.size() == block_samples_) flush_block(node, buf);
+  return true;
+}
+
+std::size_t SegmentWriter::append(NodeId node, const WindowView& window) {
+  std::size_t accepted = 0;
+  for (std::size_t i = 0; i < window.timestamps.size(); ++i) {
+    accepted += append(node, window.sample(i)) ? 1 : 0;
+  }
+  return accepted;
+}
+
+void SegmentWriter::flush_block(NodeId node, NodeBuffer& buf) {
+  const std::size_t n = buf.timestamps.size();
+  if (n == 0) return;
+  segment::BlockEntry e{};
+  e.offset = offset_;
+  e.node = node;
+  e.count = static_cast<std::uint32_t>(n);
+  e.t_min = buf.timestamps.front();
+  e.t_max = buf.timestamps.back();
+
+  scratch_.clear();
+  gorilla::detail::BitWriter w(scratch_);
+  e.column_offset[0] = 0;
+  gorilla::detail::encode_timestamps(buf.timestamps.data(), n, w);
+  w.finish();
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    const std::vector<float>& x = buf.channels[c];
+    // Over the finite readings, like the window features; NaN if there
+    // are none, which no value range can exclude.
+    float lo = std::numeric_limits<float>::quiet_NaN(), hi = lo;
+    for (float v : x) {
+      if (!std::isfinite(v)) continue;
+      if (!(v >= lo)) lo = v;
+      if (!(v <= hi)) hi = v;
+    }
+    e.min[c] = lo;
+    e.max[c] = hi;
+    e.column_offset[c + 1] = static_cast<std::uint32_t>(scratch_.size());
+    gorilla::detail::encode_floats(x.data(), n, w);
+    w.finish();
+  }
+  pad_to_word(scratch_);
+  e.bytes = static_cast<std::uint32_t>(scratch_.size());
+  write_bytes(scratch_.data(), scratch_.size());
+  index_.push_back(e);
+
+  buf.timestamps.clear();
+  for (std::vector<float>& c : buf.channels) c.clear();
+}
+
+void SegmentWriter::write_bytes(const void* data, std::size_t n) {
+  const auto* p = static_cast<const std::uint8_t*>(data);
+  while (n != 0) {
+    const ssize_t k = ::write(fd_, p, n);
+    if (k < 0) {
+      if (errno == EINTR) continue;
+      throw_errno("SegmentWriter: write");
+    }
+    p += k;
+    n -= static_cast<std::size_t>(k);
+    offset_ += static_cast<std::uint64_t>(k);
+  }
+}
+
+void SegmentWriter::finish() {
+  if (fd_ < 0) return;
+  for (auto& [node, buf] : nodes_) flush_block(node, buf);
+  // Blocks of one node were emitted oldest first, so a stable sort by node
+  // leaves each node's run ordered by time.
+  std::stable_sort(index_.begin(), index_.end(),
+                   [](const segment::BlockEntry& a, const segment::BlockEntry& b) {
+                     return a.node < b.node;
+                   });
+  const segment::Trailer trailer{offset_, index_.size(), segment::kMagic};
+  write_bytes(index_.data(), index_.size() * sizeof(segment::BlockEntry));
+  write_bytes(&trailer, sizeof trailer);
+  const int fd = std::exchange(fd_, -1);
+  if (::close(fd) < 0) throw_errno("SegmentWriter: close");
+}
+
+SegmentReader::SegmentReader(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) throw_errno("SegmentReader: open");
+  struct stat st {};
+  if (::fstat(fd, &st) < 0) {
+    const int e = errno;
+    ::close(fd);
+    throw std::system_error(e, std::generic_category(), "SegmentReader: fstat");
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ < sizeof(segment::FileHeader) + sizeof(segment::Trailer)) {
+    ::close(fd);
+    throw std::runtime_error("SegmentReader: " + path + " is too short");
+  }
+  base_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  const int e = errno;
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    throw std::system_error(e, std::generic_category(), "SegmentReader: mmap");
+  }
+
+  segment::Trailer trailer;
+  std::memcpy(&trailer, bytes() + size_ - sizeof trailer, sizeof trailer);
+  const std::uint64_t index_end = size_ - sizeof trailer;
+  bool valid =
+      header().magic == segment::kMagic && header().version == segment::kVersion &&
+      header().channel_count == kChannelCount && header().block_samples >= 2 &&
+      trailer.magic == segment::kMagic &&
+      trailer.index_offset % alignof(segment::BlockEntry) == 0 &&
+      trailer.index_offset >= sizeof(segment::FileHeader) && trailer.index_offset <= index_end &&
+      trailer.block_count == (index_end - trailer.index_offset) / sizeof(segment::BlockEntry);
+  if (valid) {
+    index_ = {reinterpret_cast<const segment::BlockEntry*>(bytes() + trailer.index_offset),
+              static_cast<std::size_t>(trailer.block_count)};
+    // scan() sizes its buffers by block_samples and decode() trusts the
+    // column offsets, so every entry must stay inside the block area and
+    // keep the node and time order blocks() searches by.
+    const segment::BlockEntry* prev = nullptr;
+    for (const segment::BlockEntry& e : index_) {
+      valid = valid && e.count >= 1 && e.count <= header().block_samples &&
+              e.offset >= sizeof(segment::FileHeader) && e.offset <= trailer.index_offset &&
+              e.bytes <= trailer.index_offset - e.offset && e.column_offset[0] == 0 &&
+              e.t_min <= e.t_max;
+      for (std::size_t c = 1; c < segment::kColumnCount; ++c) {
+        valid = valid && e.column_offset[c] > e.column_offset[c - 1];
+      }
+      valid = valid && e.column_offset[segment::kColumnCount - 1] < e.bytes;
+      if (prev != nullptr) {
+        valid = valid && (prev->node < e.node || (prev->node == e.node && prev->t_max <= e.t_min));
+      }
+      prev = &e;
+    }
+  }
+  if (!valid) {
+    ::munmap(base_, size_);
+    base_ = nullptr;
+    index_ = {};
+    throw std::runtime_error("SegmentReader: " + path + " is not a valid segment");
+  }
+}
+
+SegmentReader::~SegmentReader() {
+  if (base_ != nullptr) ::munmap(base_, size_);
+}
+
+std::span<const segment::BlockEntry> SegmentReader::blocks(NodeId node, Timestamp from,
+                                                           Timestamp to) const noexcept {
+  // Within a node, blocks are disjoint and in time order, so both t_min and
+  // t_max are sorted.
+  auto first = std::lower_bound(index_.begin(), index_.end(), node,
+                                [](const segment::BlockEntry& e, NodeId n) {
+                                  return e.node < n;
+                                });
+  auto last = std::upper_bound(first, index_.end(), node,
+                               [](NodeId n, const segment::BlockEntry& e) {
+                                 return n < e.node;
+                               });
+  first = std::lower_bound(first, last, from,
+                           [](const segment::BlockEntry& e, Timestamp t) {
+                             return e.t_max < t;
+                           });
+  last = std::upper_bound(first, last, to,
+                          [](Timestamp t, const segment::BlockEntry& e) {
+                            return t < e.t_min;
+                          });
+  return {first, last};
+}
+
+void SegmentReader::decode(const segment::BlockEntry& entry, Timestamp* timestamps,
+                           const std::array<float*, kChannelCount>& columns,
+                           ChannelMask channels) const noexcept {
+  // Each column is read up to the next one, the last up to the block's end.
+  const std::uint8_t* payload = bytes() + entry.offset;
+  const auto column_end = [&](std::size_t k) {
+    return payload + (k + 1 < segment::kColumnCount ? entry.column_offset[k + 1] : entry.bytes);
+  };
+  gorilla::detail::BitReader ts(payload + entry.column_offset[0], column_end(0));
+  gorilla::detail::decode_timestamps(ts, entry.count, timestamps);
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    if (!contains(channels, static_cast<Channel>(c)) || columns[c] == nullptr) continue;
+    gorilla::detail::BitReader r(payload + entry.column_offset[c + 1], column_end(c + 1));
+    gorilla::detail::decode_floats(r, entry.count, columns[c]);
+  }
+}
+
+std::size_t SegmentReader::replay(const SegmentQuery& query, SampleStore& store) const {
+  if (query.node >= store.node_count()) return 0;
+  SegmentQuery all = query;
+  all.channels = kAllChannels;
+  std::size_t stored = 0;
+  scan(all, [&](const DecodedBlock& block) {
+    std::array<const float*, kChannelCount> cols;
+    for (std::size_t c = 0; c < kChannelCount; ++c) cols[c] = block.channels[c].data();
+    stored += store.push_columns(query.node, block.timestamps.data(), cols, block.size());
+  });
+  return stored;
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,252 @@
+#include "meat_quality/storage/snapshot.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+namespace {
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+constexpr std::size_t align_up(std::size_t n) noexcept {
+  return (n + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+}
+
+// Largest hidden width accepted from a file; keeps the layout arithmetic
+// far from overflow.
+constexpr std::uint32_t kMaxHidden = 1u << 20;
+
+// Offsets (in bytes, from the section start) and float counts of the six
+// classifier arrays, in file order.
+struct ClassifierLayout {
+  std::array<std::size_t, 6> offset{};
+  std::array<std::size_t, 6> count{};
+  std::size_t bytes = 0;
+};
+
+ClassifierLayout classifier_layout(std::size_t hidden) noexcept {
+  ClassifierLayout l;
+  l.count = {kFeatureDim, kFeatureDim, kFeatureDim * hidden, hidden,
+             hidden * kFreshnessClassCount, kFreshnessClassCount};
+  for (std::size_t i = 0; i < l.count.size(); ++i) {
+    l.offset[i] = l.bytes;
+    l.bytes = align_up(l.bytes + l.count[i] * sizeof(float));
+  }
+  return l;
+}
+
+std::size_t lut_floats(std::uint32_t grid) noexcept {
+  return std::size_t{grid} * grid * grid * 4;
+}
+
+void put(std::vector<std::uint8_t>& out, std::size_t at, const void* data, std::size_t n) {
+  if (n != 0) std::memcpy(out.data() + at, data, n);
+}
+
+void write_all(int fd, const std::uint8_t* p, std::size_t n) {
+  while (n != 0) {
+    const ssize_t k = ::write(fd, p, n);
+    if (k < 0) {
+      if (errno == EINTR) continue;
+      throw_errno("write_snapshot: write");
+    }
+    p += k;
+    n -= static_cast<std::size_t>(k);
+  }
+}
+
+}  // namespace
+
+void write_snapshot(const std::string& path, const SnapshotContents& contents) {
+  if (contents.lab != nullptr && contents.lab->mode() != LabMode::kLut) {
+    throw std::invalid_argument("write_snapshot: only a kLut converter has a table to store");
+  }
+  std::vector<snapshot::Section> sections;
+  std::optional<ClassifierView> weights;
+  if (contents.classifier != nullptr) {
+    weights = contents.classifier->view();
+    sections.push_back({snapshot::SectionKind::kClassifier,
+                        static_cast<std::uint32_t>(weights->hidden), 0,
+                        classifier_layout(weights->hidden).bytes, 1});
+  }
+  if (contents.lab != nullptr) {
+    sections.push_back({snapshot::SectionKind::kLabLut, contents.lab->lut_grid(), 0,
+                        contents.lab->lut().size_bytes(), contents.lab->lut().size()});
+  }
+  if (!contents.calibration.empty()) {
+    sections.push_back({snapshot::SectionKind::kCalibration, 0, 0,
+                        contents.calibration.size_bytes(), contents.calibration.size()});
+  }
+
+  std::size_t at = align_up(sizeof(snapshot::FileHeader) + sections.size() * sizeof(snapshot::Section));
+  for (snapshot::Section& s : sections) {
+    s.offset = at;
+    at = align_up(at + s.bytes);
+  }
+  std::vector<std::uint8_t> image(at, 0);
+  const snapshot::FileHeader header{snapshot::kMagic, snapshot::kVersion,
+                                    static_cast<std::uint32_t>(kChannelCount),
+                                    static_cast<std::uint32_t>(kFeatureDim),
+                                    static_cast<std::uint32_t>(sections.size()), image.size()};
+  put(image, 0, &header, sizeof header);
+  put(image, sizeof header, sections.data(), sections.size() * sizeof(snapshot::Section));
+  for (const snapshot::Section& s : sections) {
+    switch (s.kind) {
+      case snapshot::SectionKind::kClassifier: {
+        const ClassifierLayout l = classifier_layout(weights->hidden);
+        const std::array<std::span<const float>, 6> arrays = {
+            weights->input_mean, weights->input_scale, weights->w1,
+            weights->b1,         weights->w2,          weights->b2};
+        for (std::size_t i = 0; i < arrays.size(); ++i) {
+          put(image, s.offset + l.offset[i], arrays[i].data(), arrays[i].size_bytes());
+        }
+        break;
+      }
+      case snapshot::SectionKind::kLabLut:
+        put(image, s.offset, contents.lab->lut().data(), s.bytes);
+        break;
+      case snapshot::SectionKind::kCalibration:
+        put(image, s.offset, contents.calibration.data(), s.bytes);
+        break;
+    }
+  }
+
+  const std::string tmp = path + ".tmp";
+  const int fd = ::open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) throw_errno("write_snapshot: open");
+  try {
+    write_all(fd, image.data(), image.size());
+    if (::fsync(fd) != 0) throw_errno("write_snapshot: fsync");
+  } catch (...) {
+    ::close(fd);
+    ::unlink(tmp.c_str());
+    throw;
+  }
+  ::close(fd);
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    const int e = errno;
+    ::unlink(tmp.c_str());
+    throw std::system_error(e, std::generic_category(), "write_snapshot: rename");
+  }
+}
+
+Snapshot::Snapshot(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) throw_errno("Snapshot: open");
+  struct stat st {};
+  if (::fstat(fd, &st) < 0) {
+    const int e = errno;
+    ::close(fd);
+    throw std::system_error(e, std::generic_category(), "Snapshot: fstat");
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ < sizeof(snapshot::FileHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Snapshot: " + path + " is too short");
+  }
+  base_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  const int e = errno;
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    throw std::system_error(e, std::generic_category(), "Snapshot: mmap");
+  }
+
+  const auto* bytes = static_cast<const std::uint8_t*>(base_);
+  const auto& header = *static_cast<const snapshot::FileHeader*>(base_);
+  bool valid = header.magic == snapshot::kMagic && header.version == snapshot::kVersion &&
+               header.channel_count == kChannelCount && header.feature_dim == kFeatureDim &&
+               header.file_bytes == size_ &&
+               header.section_count <= (size_ - sizeof header) / sizeof(snapshot::Section);
+  if (valid) {
+    sections_ = {reinterpret_cast<const snapshot::Section*>(bytes + sizeof header),
+                 header.section_count};
+    const std::size_t table_end = sizeof header + sections_.size_bytes();
+    for (const snapshot::Section& s : sections_) {
+      std::size_t expected = 0;
+      switch (s.kind) {
+        case snapshot::SectionKind::kClassifier:
+          valid = valid && s.param != 0 && s.param <= kMaxHidden;
+          if (valid) expected = classifier_layout(s.param).bytes;
+          break;
+        case snapshot::SectionKind::kLabLut:
+          valid = valid && s.param >= 2 && s.param <= 256 && s.count == lut_floats(s.param);
+          expected = s.count * sizeof(float);
+          break;
+        case snapshot::SectionKind::kCalibration:
+          valid = valid && s.count <= size_ / sizeof(NodeCalibration);
+          expected = s.count * sizeof(NodeCalibration);
+          break;
+        default:
+          valid = false;
+          break;
+      }
+      valid = valid && s.bytes == expected && s.offset % kCacheLineSize == 0 &&
+              s.offset >= table_end && s.offset <= size_ && s.bytes <= size_ - s.offset;
+    }
+  }
+  if (!valid) {
+    ::munmap(base_, size_);
+    base_ = nullptr;
+    throw std::runtime_error("Snapshot: " + path + " is not a valid snapshot");
+  }
+  if (const snapshot::Section* s = find(snapshot::SectionKind::kCalibration)) {
+    calibration_ = {reinterpret_cast<const NodeCalibration*>(bytes + s->offset),
+                    static_cast<std::size_t>(s->count)};
+  }
+}
+
+Snapshot::~Snapshot() {
+  if (base_ != nullptr) ::munmap(base_, size_);
+}
+
+const snapshot::Section* Snapshot::find(snapshot::SectionKind kind) const noexcept {
+  for (const snapshot::Section& s : sections_) {
+    if (s.kind == kind) return &s;
+  }
+  return nullptr;
+}
+
+std::optional<ClassifierView> Snapshot::classifier_view() const noexcept {
+  const snapshot::Section* s = find(snapshot::SectionKind::kClassifier);
+  if (s == nullptr) return std::nullopt;
+  const ClassifierLayout l = classifier_layout(s->param);
+  const auto* base = static_cast<const std::uint8_t*>(base_) + s->offset;
+  const auto array = [&](std::size_t i) {
+    return std::span<const float>(reinterpret_cast<const float*>(base + l.offset[i]), l.count[i]);
+  };
+  return ClassifierView{s->param, array(0), array(1), array(2), array(3), array(4), array(5)};
+}
+
+FreshnessClassifier Snapshot::classifier() const {
+  const std::optional<ClassifierView> view = classifier_view();
+  if (!view) throw std::runtime_error("Snapshot: no classifier section");
+  return FreshnessClassifier(*view);
+}
+
+LabConverter Snapshot::lab_converter() const {
+  const snapshot::Section* s = find(snapshot::SectionKind::kLabLut);
+  if (s == nullptr) throw std::runtime_error("Snapshot: no LUT section");
+  const auto* lut = reinterpret_cast<const float*>(static_cast<const std::uint8_t*>(base_) + s->offset);
+  return LabConverter(std::span<const float>(lut, static_cast<std::size_t>(s->count)), s->param);
+}
+
+void Snapshot::prefetch() const noexcept {
+  ::madvise(base_, size_, MADV_WILLNEED);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,378 @@
+#include "meat_quality/storage/tiered_history.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "meat_quality/util/aligned_buffer.hpp"
+
+namespace meat_quality {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr const char* kRawExtension = ".mqseg";
+constexpr const char* kRollupExtension = ".mqroll";
+constexpr const char* kTempExtension = ".tmp";
+
+constexpr Timestamp kNever = std::numeric_limits<Timestamp>::max();
+
+// True if history ending at `end` is more than `retention` old at `now`.
+bool expired(Timestamp end, Timestamp now, Timestamp retention) noexcept {
+  return retention != kNever && end < now && now - end > retention;
+}
+
+void make_directory(const std::string& path) {
+  std::error_code ec;
+  fs::create_directories(path, ec);
+  if (ec) throw std::system_error(ec, "TieredHistory: create " + path);
+}
+
+// Files in `dir` with extension `ext`, by name.
+std::vector<std::string> list(const std::string& dir, const char* ext) {
+  std::vector<std::string> out;
+  for (const fs::directory_entry& e : fs::directory_iterator(dir)) {
+    if (e.is_regular_file() && e.path().extension() == ext) out.push_back(e.path().string());
+  }
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+void remove_file(const std::string& path) {
+  if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+    throw std::system_error(errno, std::generic_category(), "TieredHistory: unlink " + path);
+  }
+}
+
+Timestamp wall_clock_micros() noexcept {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+std::vector<RollupTier> TieredHistoryOptions::default_tiers(const std::string& root) {
+  return {
+      {kMinuteMicros, root + "/rollup-1m", 90 * kDayMicros},
+      {15 * kMinuteMicros, root + "/rollup-15m", 730 * kDayMicros},
+      {kHourMicros, root + "/rollup-1h", kNever},
+  };
+}
+
+TieredHistory::TieredHistory(TieredHistoryOptions options) : options_(std::move(options)) {
+  if (options_.raw_directory.empty()) {
+    throw std::invalid_argument("TieredHistory: no raw directory");
+  }
+  if (options_.tiers.empty()) {
+    options_.tiers = TieredHistoryOptions::default_tiers(options_.raw_directory);
+  }
+  for (std::size_t k = 0; k < options_.tiers.size(); ++k) {
+    const RollupTier& t = options_.tiers[k];
+    const bool nested = k == 0 || (t.resolution > options_.tiers[k - 1].resolution &&
+                                   t.resolution % options_.tiers[k - 1].resolution == 0);
+    if (t.resolution <= 0 || !nested || t.directory.empty()) {
+      throw std::invalid_argument("TieredHistory: tier resolutions must be positive multiples");
+    }
+  }
+
+  make_directory(options_.raw_directory);
+  for (const RollupTier& t : options_.tiers) {
+    make_directory(t.directory);
+    for (const std::string& tmp : list(t.directory, kTempExtension)) remove_file(tmp);
+  }
+  for (const std::string& path : list(options_.raw_directory, kRawExtension)) {
+    // A pass that stopped after writing some rollups: finish it if all of
+    // them are there, or start over from the raw segment.
+    std::size_t present = 0;
+    for (std::size_t k = 0; k < options_.tiers.size(); ++k) {
+      present += fs::exists(rollup_path(k, path)) ? 1 : 0;
+    }
+    if (present == options_.tiers.size()) {
+      remove_file(path);
+      continue;
+    }
+    for (std::size_t k = 0; k < options_.tiers.size() && present != 0; ++k) {
+      remove_file(rollup_path(k, path));
+    }
+    raw_.push_back(open_raw(path));
+  }
+  rollups_.resize(options_.tiers.size());
+  for (std::size_t k = 0; k < options_.tiers.size(); ++k) {
+    for (const std::string& path : list(options_.tiers[k].directory, kRollupExtension)) {
+      rollups_[k].push_back({path, std::make_shared<const RollupReader>(path)});
+    }
+    std::sort(rollups_[k].begin(), rollups_[k].end(),
+              [](const RollupFile& a, const RollupFile& b) {
+                return a.reader->from() < b.reader->from();
+              });
+  }
+  std::sort(raw_.begin(), raw_.end(),
+            [](const RawFile& a, const RawFile& b) { return a.from < b.from; });
+}
+
+TieredHistory::~TieredHistory() { stop(); }
+
+TieredHistory::RawFile TieredHistory::open_raw(const std::string& path) const {
+  RawFile f;
+  f.path = path;
+  f.reader = std::make_shared<const SegmentReader>(path);
+  f.from = kNever;
+  f.to = std::numeric_limits<Timestamp>::min();
+  for (const segment::BlockEntry& e : f.reader->blocks()) {
+    f.from = std::min(f.from, e.t_min);
+    f.to = std::max(f.to, e.t_max);
+  }
+  if (f.reader->blocks().empty()) f.from = f.to = 0;
+  return f;
+}
+
+std::string TieredHistory::rollup_path(std::size_t tier, const std::string& raw_path) const {
+  return (fs::path(options_.tiers[tier].directory) /
+          (fs::path(raw_path).stem().string() + kRollupExtension))
+      .string();
+}
+
+void TieredHistory::add_segment(const std::string& path) {
+  RawFile f = open_raw(path);
+  std::lock_guard lock(mutex_);
+  const auto at = std::upper_bound(raw_.begin(), raw_.end(), f.from,
+                                   [](Timestamp t, const RawFile& r) { return t < r.from; });
+  raw_.insert(at, std::move(f));
+}
+
+void TieredHistory::roll_up(const RawFile& raw, CompactionStats& stats) {
+  const std::size_t tiers = options_.tiers.size();
+  std::vector<std::string> finals(tiers);
+  std::vector<std::string> temps(tiers);
+  std::vector<RollupFile> written(tiers);
+  try {
+    std::vector<std::unique_ptr<RollupWriter>> writers;
+    for (std::size_t k = 0; k < tiers; ++k) {
+      finals[k] = rollup_path(k, raw.path);
+      temps[k] = finals[k] + kTempExtension;
+      writers.push_back(std::make_unique<RollupWriter>(temps[k], options_.tiers[k].resolution));
+    }
+    // One pass over the segment in index order (node-major, oldest
+    // first) feeds every tier.
+    const SegmentReader& reader = *raw.reader;
+    const std::size_t n = reader.block_samples();
+    AlignedBuffer<Timestamp> ts(n);
+    std::array<AlignedBuffer<float>, kChannelCount> cols;
+    std::array<float*, kChannelCount> out{};
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      cols[c] = AlignedBuffer<float>(n);
+      out[c] = cols[c].data();
+    }
+    SensorSample s;
+    for (const segment::BlockEntry& e : reader.blocks()) {
+      reader.decode(e, ts.data(), out);
+      for (std::size_t i = 0; i < e.count; ++i) {
+        s.timestamp = ts[i];
+        for (std::size_t c = 0; c < kChannelCount; ++c) s.values[c] = out[c][i];
+        for (const auto& w : writers) w->append(e.node, s);
+      }
+    }
+    for (std::size_t k = 0; k < tiers; ++k) {
+      writers[k]->finish();
+      if (std::rename(temps[k].c_str(), finals[k].c_str()) != 0) {
+        throw std::system_error(errno, std::generic_category(), "TieredHistory: rename");
+      }
+      written[k] = {finals[k], std::make_shared<const RollupReader>(finals[k])};
+      stats.rollup_bytes_written += written[k].reader->file_bytes();
+    }
+  } catch (...) {
+    for (std::size_t k = 0; k < tiers; ++k) {
+      ::unlink(temps[k].c_str());
+      ::unlink(finals[k].c_str());
+    }
+    throw;
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    for (std::size_t k = 0; k < tiers; ++k) {
+      auto& files = rollups_[k];
+      const Timestamp from = written[k].reader->from();
+      const auto at = std::upper_bound(files.begin(), files.end(), from,
+                                       [](Timestamp t, const RollupFile& f) {
+                                         return t < f.reader->from();
+                                       });
+      files.insert(at, std::move(written[k]));
+    }
+    std::erase_if(raw_, [&](const RawFile& f) { return f.path == raw.path; });
+  }
+  // Queries still reading the segment keep their mapping.
+  remove_file(raw.path);
+  stats.segments_compacted += 1;
+  stats.rollups_written += tiers;
+  stats.raw_bytes_removed += raw.reader->file_bytes();
+}
+
+CompactionStats TieredHistory::compact(Timestamp now) {
+  std::lock_guard pass(compact_mutex_);
+  CompactionStats s;
+  s.passes = 1;
+  std::vector<RawFile> due;
+  {
+    std::lock_guard lock(mutex_);
+    for (const RawFile& f : raw_) {
+      if (expired(f.to, now, options_.raw_retention)) due.push_back(f);
+    }
+  }
+  for (const RawFile& f : due) roll_up(f, s);
+
+  std::vector<std::string> stale;
+  {
+    std::lock_guard lock(mutex_);
+    for (std::size_t k = 0; k < rollups_.size(); ++k) {
+      const Timestamp retention = options_.tiers[k].retention;
+      std::erase_if(rollups_[k], [&](const RollupFile& f) {
+        if (!expired(f.reader->to(), now, retention)) return false;
+        stale.push_back(f.path);
+        return true;
+      });
+    }
+  }
+  for (const std::string& path : stale) remove_file(path);
+  s.rollups_expired = stale.size();
+
+  std::lock_guard lock(mutex_);
+  stats_.passes += s.passes;
+  stats_.segments_compacted += s.segments_compacted;
+  stats_.rollups_written += s.rollups_written;
+  stats_.rollups_expired += s.rollups_expired;
+  stats_.raw_bytes_removed += s.raw_bytes_removed;
+  stats_.rollup_bytes_written += s.rollup_bytes_written;
+  return s;
+}
+
+void TieredHistory::start() {
+  if (thread_.joinable()) return;
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = false;
+  }
+  thread_ = std::thread([this] { run(); });
+}
+
+void TieredHistory::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+void TieredHistory::run() {
+  std::unique_lock lock(mutex_);
+  while (!stop_) {
+    lock.unlock();
+    bool failed = false;
+    try {
+      compact(wall_clock_micros());
+    } catch (const std::exception&) {
+      failed = true;  // retried on the next pass
+    }
+    lock.lock();
+    if (failed) ++stats_.errors;
+    wake_.wait_for(lock, options_.compact_interval, [this] { return stop_; });
+  }
+}
+
+HistoryStats TieredHistory::query(const HistoryQuery& q, std::vector<rollup::Bucket>& out) const {
+  const Timestamp r = q.resolution;
+  if (r <= 0) throw std::invalid_argument("TieredHistory: non-positive query resolution");
+  HistoryStats stats;
+  for (std::size_t k = 0; k < options_.tiers.size(); ++k) {
+    const Timestamp tr = options_.tiers[k].resolution;
+    if (tr <= r && r % tr == 0) stats.tier = static_cast<int>(k);
+  }
+  // Whole result buckets, so raw samples and tier buckets cover the same
+  // span at the edges.
+  const Timestamp lo =
+      q.from == std::numeric_limits<Timestamp>::min() ? q.from : rollup::bucket_start(q.from, r);
+  const Timestamp hi = q.to == kNever ? q.to : rollup::bucket_start(q.to, r) + (r - 1);
+
+  // Sources in time order; raw segments and the tier never overlap.
+  struct Source {
+    Timestamp from;
+    std::shared_ptr<const RollupReader> rollup;
+    std::shared_ptr<const SegmentReader> raw;
+  };
+  std::vector<Source> sources;
+  {
+    std::lock_guard lock(mutex_);
+    if (stats.tier >= 0) {
+      for (const RollupFile& f : rollups_[static_cast<std::size_t>(stats.tier)]) {
+        if (f.reader->to() >= lo && f.reader->from() <= hi) {
+          sources.push_back({f.reader->from(), f.reader, nullptr});
+        }
+      }
+    }
+    for (const RawFile& f : raw_) {
+      if (f.to >= lo && f.from <= hi) sources.push_back({f.from, nullptr, f.reader});
+    }
+  }
+  std::stable_sort(sources.begin(), sources.end(),
+                   [](const Source& a, const Source& b) { return a.from < b.from; });
+
+  RollupAccumulator acc;
+  bool open = false;
+  const auto bucket_for = [&](Timestamp t) {
+    const Timestamp start = rollup::bucket_start(t, r);
+    if (open && start == acc.start()) return;
+    if (open && !acc.empty()) out.push_back(acc.bucket());
+    acc.reset(start);
+    open = true;
+  };
+  for (const Source& src : sources) {
+    if (src.rollup) {
+      for (const rollup::Bucket& b : src.rollup->buckets(q.node, lo, hi)) {
+        bucket_for(b.t);
+        acc.add(b);
+        ++stats.rollup_buckets;
+      }
+      continue;
+    }
+    SegmentQuery sq;
+    sq.node = q.node;
+    sq.from = lo;
+    sq.to = hi;
+    stats.raw_samples += src.raw->scan(sq, [&](const DecodedBlock& block) {
+      SensorSample s;
+      for (std::size_t i = 0; i < block.size(); ++i) {
+        s.timestamp = block.timestamps[i];
+        for (std::size_t c = 0; c < kChannelCount; ++c) s.values[c] = block.channels[c][i];
+        bucket_for(s.timestamp);
+        acc.add(s);
+      }
+    }).samples;
+  }
+  if (open && !acc.empty()) out.push_back(acc.bucket());
+  return stats;
+}
+
+std::size_t TieredHistory::raw_segments() const {
+  std::lock_guard lock(mutex_);
+  return raw_.size();
+}
+
+std::size_t TieredHistory::rollup_files(std::size_t k) const {
+  std::lock_guard lock(mutex_);
+  return k < rollups_.size() ? rollups_[k].size() : 0;
+}
+
+CompactionStats TieredHistory::stats() const {
+  std::lock_guard lock(mutex_);
+  return stats_;
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,40 @@
+#include "meat_quality/telemetry/c_api.h"
+
+#include <cstring>
+#include <string>
+
+#include "meat_quality/telemetry/telemetry.hpp"
+
+namespace telemetry = meat_quality::telemetry;
+
+extern "C" {
+
+size_t mq_telemetry_prometheus(char* buf, size_t size) {
+  const std::string text = telemetry::prometheus_text();
+  if (buf != nullptr && size > 0) {
+    const size_t n = text.size() < size - 1 ? text.size() : size - 1;
+    std::memcpy(buf, text.data(), n);
+    buf[n] = '\0';
+  }
+  return text.size();
+}
+
+double mq_telemetry_stage_quantile(int stage, double q) {
+  if (stage < 0 || static_cast<size_t>(stage) >= telemetry::kStageCount) return 0.0;
+  const telemetry::Snapshot s = telemetry::snapshot();
+  return static_cast<double>(s.stages[static_cast<size_t>(stage)].quantile(q)) * 1e-9;
+}
+
+uint64_t mq_telemetry_stage_count(int stage) {
+  if (stage < 0 || static_cast<size_t>(stage) >= telemetry::kStageCount) return 0;
+  return telemetry::snapshot().stages[static_cast<size_t>(stage)].count;
+}
+
+uint64_t mq_telemetry_counter(int counter) {
+  if (counter < 0 || static_cast<size_t>(counter) >= telemetry::kCounterCount) return 0;
+  return telemetry::snapshot().counters[static_cast<size_t>(counter)];
+}
+
+void mq_telemetry_set_enabled(int on) { telemetry::set_enabled(on != 0); }
+
+}  // extern "C"
@@ -0,0 +1,191 @@
+#include "meat_quality/telemetry/telemetry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+namespace meat_quality::telemetry {
+
+std::uint64_t HistogramSnapshot::quantile(double q) const noexcept {
+  if (count == 0) return 0;
+  q = std::clamp(q, 0.0, 1.0);
+  // Rank of the wanted value, 1-based: the smallest value with at least
+  // ceil(q * count) values at or below it.
+  const auto rank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(q * static_cast<double>(count) + 0.999999));
+  std::uint64_t seen = 0;
+  for (std::size_t b = 0; b < counts.size(); ++b) {
+    seen += counts[b];
+    if (seen >= rank) {
+      return std::min(bucket_lower(b) + bucket_width(b) / 2, max);
+    }
+  }
+  return max;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other) noexcept {
+  for (std::size_t b = 0; b < counts.size(); ++b) counts[b] += other.counts[b];
+  count += other.count;
+  sum += other.sum;
+  max = std::max(max, other.max);
+}
+
+void Histogram::add_to(HistogramSnapshot& out) const noexcept {
+  // The per-bucket counts are summed for `count` rather than reading
+  // count_, so quantiles stay consistent with a concurrently written block.
+  std::uint64_t n = 0;
+  for (std::size_t b = 0; b < kBucketCount; ++b) {
+    const std::uint64_t c = counts_[b].load(std::memory_order_relaxed);
+    out.counts[b] += c;
+    n += c;
+  }
+  out.count += n;
+  out.sum += sum_.load(std::memory_order_relaxed);
+  out.max = std::max(out.max, max_.load(std::memory_order_relaxed));
+}
+
+namespace {
+
+struct ThreadBlock {
+  std::array<Histogram, kStageCount> stages;
+  std::array<Histogram, kDistributionCount> distributions;
+  std::array<std::atomic<std::uint64_t>, kCounterCount> counters{};
+  std::atomic<bool> owned{true};
+  ThreadBlock* next = nullptr;
+};
+
+// Blocks are never freed: snapshot() may be walking them at any time. A
+// thread's block goes back to the pool when it exits and is claimed by the
+// next thread that records, so a churning thread pool does not grow the list.
+std::atomic<ThreadBlock*> g_blocks{nullptr};
+std::atomic<bool> g_enabled{true};
+
+ThreadBlock* acquire_block() {
+  for (ThreadBlock* b = g_blocks.load(std::memory_order_acquire); b != nullptr; b = b->next) {
+    bool expected = false;
+    if (!b->owned.load(std::memory_order_relaxed) &&
+        b->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+      return b;
+    }
+  }
+  auto* b = new ThreadBlock;
+  b->next = g_blocks.load(std::memory_order_relaxed);
+  while (!g_blocks.compare_exchange_weak(b->next, b, std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+  }
+  return b;
+}
+
+struct LocalBlock {
+  ThreadBlock* block = nullptr;
+  ~LocalBlock() {
+    if (block != nullptr) block->owned.store(false, std::memory_order_release);
+  }
+};
+
+thread_local LocalBlock tls_block;
+
+ThreadBlock& local() {
+  if (tls_block.block == nullptr) tls_block.block = acquire_block();
+  return *tls_block.block;
+}
+
+void bump(std::atomic<std::uint64_t>& a, std::uint64_t n) noexcept {
+  a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+void set_enabled(bool on) noexcept { g_enabled.store(on, std::memory_order_relaxed); }
+
+bool enabled() noexcept { return g_enabled.load(std::memory_order_relaxed); }
+
+void record(Stage stage, std::uint64_t nanoseconds) noexcept {
+  if (!enabled()) return;
+  local().stages[static_cast<std::size_t>(stage)].record(nanoseconds);
+}
+
+void observe(Distribution d, std::uint64_t value) noexcept {
+  if (!enabled()) return;
+  local().distributions[static_cast<std::size_t>(d)].record(value);
+}
+
+void add(Counter c, std::uint64_t n) noexcept {
+  if (!enabled()) return;
+  bump(local().counters[static_cast<std::size_t>(c)], n);
+}
+
+Snapshot snapshot() {
+  Snapshot s;
+  for (ThreadBlock* b = g_blocks.load(std::memory_order_acquire); b != nullptr; b = b->next) {
+    for (std::size_t i = 0; i < kStageCount; ++i) b->stages[i].add_to(s.stages[i]);
+    for (std::size_t i = 0; i < kDistributionCount; ++i) {
+      b->distributions[i].add_to(s.distributions[i]);
+    }
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+      s.counters[i] += b->counters[i].load(std::memory_order_relaxed);
+    }
+    ++s.threads;
+  }
+  return s;
+}
+
+namespace {
+
+constexpr double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+void append(std::string& out, const char* fmt, auto... args) {
+  char buf[256];
+  const int n = std::snprintf(buf, sizeof(buf), fmt, args...);
+  if (n > 0) out.append(buf, std::min<std::size_t>(static_cast<std::size_t>(n), sizeof(buf) - 1));
+}
+
+// `labels` is empty or `key="value"` without braces.
+void summary(std::string& out, const char* name, const std::string& labels,
+             const HistogramSnapshot& h, double scale) {
+  const char* sep = labels.empty() ? "" : ",";
+  for (double q : kQuantiles) {
+    // Client libraries report quantiles of an empty summary as NaN.
+    if (h.count == 0) {
+      append(out, "%s{%s%squantile=\"%g\"} NaN\n", name, labels.c_str(), sep, q);
+    } else {
+      append(out, "%s{%s%squantile=\"%g\"} %.9g\n", name, labels.c_str(), sep, q,
+             static_cast<double>(h.quantile(q)) * scale);
+    }
+  }
+  const std::string braced = labels.empty() ? std::string{} : "{" + labels + "}";
+  append(out, "%s_sum%s %.9g\n", name, braced.c_str(), static_cast<double>(h.sum) * scale);
+  append(out, "%s_count%s %" PRIu64 "\n", name, braced.c_str(), h.count);
+}
+
+}  // namespace
+
+std::string prometheus_text(const Snapshot& s) {
+  std::string out;
+  out.reserve(4096);
+  out += "# HELP meat_quality_stage_seconds Latency of one pipeline stage.\n"
+         "# TYPE meat_quality_stage_seconds summary\n";
+  for (std::size_t i = 0; i < kStageCount; ++i) {
+    const std::string labels =
+        std::string("stage=\"") + stage_name(static_cast<Stage>(i)) + "\"";
+    summary(out, "meat_quality_stage_seconds", labels, s.stages[i], 1e-9);
+  }
+  for (std::size_t i = 0; i < kDistributionCount; ++i) {
+    const char* name = distribution_name(static_cast<Distribution>(i));
+    append(out, "# TYPE meat_quality_%s summary\n", name);
+    char metric[64];
+    std::snprintf(metric, sizeof(metric), "meat_quality_%s", name);
+    summary(out, metric, {}, s.distributions[i], 1.0);
+  }
+  for (std::size_t i = 0; i < kCounterCount; ++i) {
+    const char* name = counter_name(static_cast<Counter>(i));
+    append(out, "# TYPE meat_quality_%s_total counter\n", name);
+    append(out, "meat_quality_%s_total %" PRIu64 "\n", name, s.counters[i]);
+  }
+  append(out, "# TYPE meat_quality_telemetry_threads gauge\n");
+  append(out, "meat_quality_telemetry_threads %zu\n", s.threads);
+  return out;
+}
+
+}  // namespace meat_quality::telemetry
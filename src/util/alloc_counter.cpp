@@ -0,0 +1,30 @@
+#include "meat_quality/util/alloc_counter.hpp"
+
+#include <atomic>
+
+namespace meat_quality {
+namespace {
+
+// Plain thread_local integers: no constructor, so counting is safe even for
+// allocations made before main() or during thread start-up.
+thread_local std::uint64_t tls_allocations = 0;
+std::atomic<bool> g_enabled{false};
+
+}  // namespace
+
+std::uint64_t thread_heap_allocations() noexcept { return tls_allocations; }
+
+bool heap_allocation_counting_enabled() noexcept {
+  return g_enabled.load(std::memory_order_relaxed);
+}
+
+namespace detail {
+
+void count_heap_allocation() noexcept { ++tls_allocations; }
+
+void enable_heap_allocation_counting() noexcept {
+  g_enabled.store(true, std::memory_order_relaxed);
+}
+
+}  // namespace detail
+}  // namespace meat_quality
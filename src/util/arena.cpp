@@ -0,0 +1,129 @@
+#include "meat_quality/util/arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace meat_quality {
+namespace {
+
+std::atomic<std::uint64_t> g_heap_blocks{0};
+
+// Arenas owned by one thread. `free` is a stack of idle arenas; its
+// capacity only grows with the deepest ScopedArena nesting seen.
+struct ThreadArenaPool {
+  std::vector<std::unique_ptr<Arena>> all;
+  std::vector<Arena*> free;
+};
+
+thread_local ThreadArenaPool tls_pool;
+
+}  // namespace
+
+Arena::~Arena() { release(); }
+
+Arena::Arena(Arena&& other) noexcept
+    : block_size_(other.block_size_),
+      head_(std::exchange(other.head_, nullptr)),
+      current_(std::exchange(other.current_, nullptr)),
+      cursor_(std::exchange(other.cursor_, nullptr)),
+      end_(std::exchange(other.end_, nullptr)),
+      used_before_current_(std::exchange(other.used_before_current_, 0)),
+      reserved_(std::exchange(other.reserved_, 0)),
+      blocks_(std::exchange(other.blocks_, 0)) {}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+  if (this != &other) {
+    release();
+    block_size_ = other.block_size_;
+    head_ = std::exchange(other.head_, nullptr);
+    current_ = std::exchange(other.current_, nullptr);
+    cursor_ = std::exchange(other.cursor_, nullptr);
+    end_ = std::exchange(other.end_, nullptr);
+    used_before_current_ = std::exchange(other.used_before_current_, 0);
+    reserved_ = std::exchange(other.reserved_, 0);
+    blocks_ = std::exchange(other.blocks_, 0);
+  }
+  return *this;
+}
+
+void Arena::release() noexcept {
+  for (Block* b = head_; b != nullptr;) {
+    Block* next = b->next;
+    ::operator delete(b, std::align_val_t{alignof(std::max_align_t)});
+    b = next;
+  }
+  head_ = current_ = nullptr;
+  cursor_ = end_ = nullptr;
+  used_before_current_ = reserved_ = blocks_ = 0;
+}
+
+void Arena::enter(Block* block) noexcept {
+  if (current_ != nullptr) used_before_current_ += static_cast<std::size_t>(cursor_ - current_->data());
+  current_ = block;
+  cursor_ = block->data();
+  end_ = block->data() + block->size;
+}
+
+void* Arena::allocate_slow(std::size_t bytes, std::size_t alignment) {
+  // Reuse blocks kept from before the last reset while they fit; skipping a
+  // too-small block just leaves it idle until the next reset.
+  while (current_ != nullptr && current_->next != nullptr) {
+    enter(current_->next);
+    std::byte* p = align_up(cursor_, alignment);
+    if (p + bytes <= end_) {
+      cursor_ = p + bytes;
+      return p;
+    }
+  }
+  const std::size_t size = std::max(block_size_, bytes + alignment);
+  auto* block = static_cast<Block*>(::operator new(sizeof(Block) + size,
+                                                   std::align_val_t{alignof(std::max_align_t)}));
+  g_heap_blocks.fetch_add(1, std::memory_order_relaxed);
+  block->next = nullptr;
+  block->size = size;
+  if (current_ == nullptr) head_ = block;
+  else current_->next = block;
+  reserved_ += size;
+  ++blocks_;
+  enter(block);
+  std::byte* p = align_up(cursor_, alignment);
+  cursor_ = p + bytes;
+  return p;
+}
+
+void Arena::reset() noexcept {
+  if (head_ == nullptr) return;
+  current_ = head_;
+  cursor_ = head_->data();
+  end_ = head_->data() + head_->size;
+  used_before_current_ = 0;
+}
+
+std::size_t Arena::used() const noexcept {
+  if (current_ == nullptr) return 0;
+  return used_before_current_ + static_cast<std::size_t>(cursor_ - current_->data());
+}
+
+std::uint64_t Arena::heap_blocks_allocated() noexcept {
+  return g_heap_blocks.load(std::memory_order_relaxed);
+}
+
+ScopedArena::ScopedArena() {
+  ThreadArenaPool& pool = tls_pool;
+  if (pool.free.empty()) {
+    pool.all.push_back(std::make_unique<Arena>());
+    pool.free.reserve(pool.all.size());
+    arena_ = pool.all.back().get();
+  } else {
+    arena_ = pool.free.back();
+    pool.free.pop_back();
+  }
+}
+
+ScopedArena::~ScopedArena() {
+  arena_->reset();
+  tls_pool.free.push_back(arena_);
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,116 @@
+#include "meat_quality/util/numa.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace meat_quality {
+namespace {
+
+// Kernel cpulist syntax: "0-3,8,10-11".
+std::vector<int> parse_cpu_list(std::string_view s) {
+  std::vector<int> cpus;
+  while (!s.empty()) {
+    const std::size_t comma = s.find(',');
+    const std::string_view range = s.substr(0, comma);
+    const std::size_t dash = range.find('-');
+    int lo = 0, hi = 0;
+    const auto lo_end = std::from_chars(range.data(), range.data() + range.size(), lo);
+    hi = lo;
+    if (dash != std::string_view::npos) {
+      std::from_chars(range.data() + dash + 1, range.data() + range.size(), hi);
+    }
+    if (lo_end.ec == std::errc{}) {
+      for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+    }
+    if (comma == std::string_view::npos) break;
+    s.remove_prefix(comma + 1);
+  }
+  return cpus;
+}
+
+// CPUs this process may run on.
+std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof set, &set) == 0) {
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+      if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned c = 0; c < n; ++c) cpus.push_back(static_cast<int>(c));
+  }
+  return cpus;
+}
+
+}  // namespace
+
+NumaTopology::NumaTopology(std::vector<NumaNode> nodes) {
+  for (NumaNode& n : nodes) {
+    if (!n.cpus.empty()) nodes_.push_back(std::move(n));
+  }
+  if (nodes_.empty()) nodes_.push_back({0, {0}});
+}
+
+NumaTopology NumaTopology::detect() {
+  const std::vector<int> allowed = allowed_cpus();
+  std::vector<NumaNode> nodes;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+    const std::string name = entry.path().filename().string();
+    int id = 0;
+    if (!name.starts_with("node") ||
+        std::from_chars(name.data() + 4, name.data() + name.size(), id).ec != std::errc{}) {
+      continue;
+    }
+    std::ifstream in(entry.path() / "cpulist");
+    std::string line;
+    if (!std::getline(in, line)) continue;
+    NumaNode node{id, {}};
+    for (int c : parse_cpu_list(line)) {
+      if (std::binary_search(allowed.begin(), allowed.end(), c)) node.cpus.push_back(c);
+    }
+    if (!node.cpus.empty()) nodes.push_back(std::move(node));
+  }
+  if (nodes.empty()) nodes.push_back({0, allowed});
+  std::sort(nodes.begin(), nodes.end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+  return NumaTopology(std::move(nodes));
+}
+
+bool pin_current_thread(std::span<const int> cpus) noexcept {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int c : cpus) {
+    if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+  }
+  return CPU_COUNT(&set) != 0 && ::sched_setaffinity(0, sizeof set, &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+int current_cpu() noexcept {
+#if defined(__linux__)
+  return ::sched_getcpu();
+#else
+  return -1;
+#endif
+}
+
+}  // namespace meat_quality
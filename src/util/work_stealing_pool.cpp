@@ -0,0 +1,140 @@
+#include "meat_quality/util/work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "meat_quality/util/numa.hpp"
+
+namespace meat_quality {
+namespace {
+
+struct WorkerIdentity {
+  const WorkStealingPool* pool = nullptr;
+  int index = -1;
+};
+
+thread_local WorkerIdentity tls_worker;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads, std::span<const int> cpus) {
+  if (threads == 0) {
+    threads = cpus.empty() ? std::max(1u, std::thread::hardware_concurrency()) : cpus.size();
+  }
+  queues_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+  threads_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    const int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+    threads_.emplace_back([this, i, cpu] {
+      if (cpu >= 0) pin_current_thread({&cpu, 1});
+      worker_loop(i);
+    });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard lock(sleep_mutex_);
+    stopping_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (std::thread& t : threads_) t.join();
+}
+
+int WorkStealingPool::current_worker() const noexcept {
+  return tls_worker.pool == this ? tls_worker.index : -1;
+}
+
+void WorkStealingPool::submit(Task task) {
+  const int self = current_worker();
+  const std::size_t target =
+      self >= 0 ? static_cast<std::size_t>(self)
+                : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+  {
+    std::lock_guard lock(queues_[target]->mutex);
+    queues_[target]->tasks.push_back(std::move(task));
+  }
+  queued_.fetch_add(1, std::memory_order_release);
+  // Taking the sleep mutex orders this wakeup after a worker's predicate
+  // check, so the notification cannot be lost.
+  { std::lock_guard lock(sleep_mutex_); }
+  sleep_cv_.notify_one();
+}
+
+bool WorkStealingPool::pop(std::size_t index, Task& out) {
+  Queue& q = *queues_[index];
+  std::lock_guard lock(q.mutex);
+  if (q.tasks.empty()) return false;
+  out = std::move(q.tasks.back());
+  q.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingPool::steal(std::size_t thief, Task& out) {
+  const std::size_t n = queues_.size();
+  for (std::size_t k = 1; k <= n; ++k) {
+    Queue& q = *queues_[(thief + k) % n];
+    std::lock_guard lock(q.mutex);
+    if (q.tasks.empty()) continue;
+    out = std::move(q.tasks.front());
+    q.tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+bool WorkStealingPool::run_one() {
+  if (queued_.load(std::memory_order_acquire) == 0) return false;
+  Task task;
+  const int self = current_worker();
+  const bool found = self >= 0 ? pop(static_cast<std::size_t>(self), task) ||
+                                     steal(static_cast<std::size_t>(self), task)
+                               : steal(0, task);
+  if (!found) return false;
+  queued_.fetch_sub(1, std::memory_order_relaxed);
+  task();
+  return true;
+}
+
+void WorkStealingPool::worker_loop(std::size_t index) {
+  tls_worker = {this, static_cast<int>(index)};
+  for (;;) {
+    if (run_one()) continue;
+    std::unique_lock lock(sleep_mutex_);
+    sleep_cv_.wait(lock, [this] {
+      return stopping_ || queued_.load(std::memory_order_acquire) != 0;
+    });
+    if (stopping_ && queued_.load(std::memory_order_acquire) == 0) return;
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  // A group must not be destroyed with tasks still referencing it.
+  while (outstanding_.load(std::memory_order_acquire) != 0) {
+    if (!pool_.run_one()) std::this_thread::yield();
+  }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+  outstanding_.fetch_add(1, std::memory_order_relaxed);
+  pool_.submit([this, task = std::move(task)] {
+    try {
+      task();
+    } catch (...) {
+      std::lock_guard lock(error_mutex_);
+      if (!error_) error_ = std::current_exception();
+    }
+    outstanding_.fetch_sub(1, std::memory_order_release);
+  });
+}
+
+void TaskGroup::wait() {
+  while (outstanding_.load(std::memory_order_acquire) != 0) {
+    if (!pool_.run_one()) std::this_thread::yield();
+  }
+  std::lock_guard lock(error_mutex_);
+  if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+}  // namespace meat_quality
@@ -0,0 +1,93 @@
+// Image accelerator plugin for tests. It does no pixel work; the device
+// index picks a failure instead:
+//
+//   0  works (every pixel background, zero sums)
+//   1  create() fails
+//   2  submit() fails
+//   3  wait() fails for ticket 0 only
+//
+// fake_image_accel_outstanding() counts host buffers, contexts and tickets
+// not yet freed, destroyed or waited for.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "meat_quality/image/image_accel.h"
+
+namespace {
+
+std::atomic<long> g_outstanding{0};
+
+struct Context {
+  int device;
+  int64_t tickets = 0;
+};
+
+void* fake_create(int device, char* error, size_t error_size) {
+  if (device == 1) {
+    std::snprintf(error, error_size, "no such device");
+    return nullptr;
+  }
+  ++g_outstanding;
+  return new Context{device};
+}
+
+void fake_destroy(void* ctx) {
+  --g_outstanding;
+  delete static_cast<Context*>(ctx);
+}
+
+void* fake_alloc_host(void*, size_t bytes) {
+  ++g_outstanding;
+  return std::malloc(bytes);
+}
+
+void fake_free_host(void*, void* p) {
+  if (p == nullptr) return;
+  --g_outstanding;
+  std::free(p);
+}
+
+int64_t fake_submit(void* ctx, mq_image_job* jobs, size_t n, const mq_image_params* params) {
+  auto& c = *static_cast<Context*>(ctx);
+  if (c.device == 2) return -1;
+  for (size_t i = 0; i < n; ++i) {
+    mq_image_job& job = jobs[i];
+    std::memset(job.classes, MQ_PIXEL_BACKGROUND, size_t{job.width} * job.height);
+    std::memset(job.histogram, 0, params->redness_bins * sizeof *job.histogram);
+    job.histogram[0] = job.width * job.height;
+    job.sum_l = job.sum_a = job.sum_b = 0;
+    job.fat_pixels = job.lean_pixels = 0;
+  }
+  ++g_outstanding;
+  return c.tickets++;
+}
+
+int fake_wait(void* ctx, int64_t ticket) {
+  --g_outstanding;
+  return static_cast<Context*>(ctx)->device == 3 && ticket == 0 ? -1 : 0;
+}
+
+constexpr mq_image_accel kTable{
+    .abi = MQ_IMAGE_ACCEL_ABI,
+    .name = "fake",
+    .create = fake_create,
+    .destroy = fake_destroy,
+    .alloc_host = fake_alloc_host,
+    .free_host = fake_free_host,
+    .submit = fake_submit,
+    .wait = fake_wait,
+};
+
+}  // namespace
+
+extern "C" __attribute__((visibility("default"))) const mq_image_accel*
+mq_image_accel_plugin(uint32_t abi) {
+  return abi == MQ_IMAGE_ACCEL_ABI ? &kTable : nullptr;
+}
+
+extern "C" __attribute__((visibility("default"))) long fake_image_accel_outstanding() {
+  return g_outstanding.load();
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "meat_quality/util/arena.hpp"
+
+namespace meat_quality {
+namespace {
+
+using RequestMix = std::vector<std::pair<std::size_t, std::size_t>>;  // bytes, alignment
+
+struct Allocation {
+  std::uintptr_t begin;
+  std::size_t bytes;
+};
+
+// A fixed mix of small, odd-sized and over-aligned requests, with a few
+// larger than the block.
+RequestMix request_mix(std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  RequestMix out;
+  for (int k = 0; k < 400; ++k) {
+    const std::size_t bytes = k % 97 == 0 ? 5000 + rng() % 3000 : rng() % 300;
+    out.emplace_back(bytes, std::size_t{1} << (rng() % 9));  // alignment 1..256
+  }
+  return out;
+}
+
+// Serves `mix` and checks every block is aligned, in no other block and
+// still holds what was written to it.
+std::vector<Allocation> serve(Arena& arena, const RequestMix& mix) {
+  std::vector<Allocation> out;
+  std::size_t requested = 0;
+  for (std::size_t i = 0; i < mix.size(); ++i) {
+    const auto [bytes, alignment] = mix[i];
+    auto* p = static_cast<std::uint8_t*>(arena.allocate(bytes, alignment));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % alignment, 0u) << i;
+    std::memset(p, static_cast<int>(i & 0xff), bytes);
+    out.push_back({reinterpret_cast<std::uintptr_t>(p), bytes});
+    requested += bytes;
+  }
+  EXPECT_GE(arena.used(), requested);
+  for (std::size_t i = 0; i < out.size(); ++i) {
+    const auto* p = reinterpret_cast<const std::uint8_t*>(out[i].begin);
+    const auto intact = [&](std::uint8_t b) { return b == (i & 0xff); };
+    EXPECT_TRUE(std::all_of(p, p + out[i].bytes, intact)) << "allocation " << i << " overwritten";
+  }
+  // An empty allocation may share its address with the next one.
+  std::vector<Allocation> sorted = out;
+  std::sort(sorted.begin(), sorted.end(), [](const Allocation& a, const Allocation& b) {
+    return a.begin != b.begin ? a.begin < b.begin : a.bytes < b.bytes;
+  });
+  for (std::size_t i = 1; i < sorted.size(); ++i) {
+    EXPECT_LE(sorted[i - 1].begin + sorted[i - 1].bytes, sorted[i].begin);
+  }
+  return out;
+}
+
+TEST(Arena, AllocationsAreAlignedAndDisjoint) {
+  Arena arena(4096);
+  EXPECT_EQ(arena.used(), 0u);
+  EXPECT_EQ(arena.block_count(), 0u);
+  serve(arena, request_mix(1));
+  EXPECT_GT(arena.block_count(), 1u);
+  EXPECT_LE(arena.used(), arena.reserved());
+}
+
+TEST(Arena, ResetReusesBlocksWithoutTheHeap) {
+  Arena arena(4096);
+  const auto mix = request_mix(2);
+  const std::vector<Allocation> first = serve(arena, mix);
+  const std::size_t blocks = arena.block_count(), reserved = arena.reserved();
+  const std::uint64_t heap = Arena::heap_blocks_allocated();
+
+  for (int round = 0; round < 3; ++round) {
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    const std::vector<Allocation> again = serve(arena, mix);
+    EXPECT_EQ(again.front().begin, first.front().begin);
+  }
+  EXPECT_EQ(arena.block_count(), blocks);
+  EXPECT_EQ(arena.reserved(), reserved);
+  EXPECT_EQ(Arena::heap_blocks_allocated(), heap);
+}
+
+TEST(Arena, OversizedRequestsGetTheirOwnBlock) {
+  Arena arena(256);
+  void* small = arena.allocate(16);
+  void* big = arena.allocate(10'000, 64);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(big) % 64, 0u);
+  EXPECT_EQ(arena.block_count(), 2u);
+  EXPECT_GE(arena.reserved(), 256u + 10'000u);
+  std::memset(big, 0xab, 10'000);
+  EXPECT_NE(small, big);
+
+  // After a reset the small first block is skipped, not overrun.
+  arena.reset();
+  void* again = arena.allocate(10'000, 64);
+  std::memset(again, 0xcd, 10'000);
+  EXPECT_EQ(arena.block_count(), 2u);
+}
+
+TEST(Arena, ZeroedSpansAreZeroOnReusedMemory) {
+  Arena arena(1024);
+  std::span<std::uint32_t> dirty = arena.allocate_span<std::uint32_t>(200);
+  std::fill(dirty.begin(), dirty.end(), 0xdeadbeef);
+  arena.reset();
+  const std::span<std::uint32_t> clean = arena.allocate_zeroed<std::uint32_t>(200);
+  EXPECT_EQ(clean.data(), dirty.data());
+  EXPECT_TRUE(std::all_of(clean.begin(), clean.end(), [](std::uint32_t v) { return v == 0; }));
+  const std::span<double> empty = arena.allocate_zeroed<double>(0);
+  EXPECT_TRUE(empty.empty());
+}
+
+TEST(Arena, MoveTransfersTheBlocks) {
+  Arena a(512);
+  auto* p = static_cast<int*>(a.allocate(sizeof(int)));
+  *p = 42;
+  const std::size_t used = a.used();
+  Arena b(std::move(a));
+  EXPECT_EQ(b.used(), used);
+  EXPECT_EQ(b.block_count(), 1u);
+  EXPECT_EQ(a.block_count(), 0u);
+  EXPECT_EQ(a.used(), 0u);
+  EXPECT_EQ(*p, 42);
+
+  Arena c(64);
+  c.allocate(8);
+  c = std::move(b);
+  EXPECT_EQ(c.used(), used);
+  EXPECT_EQ(*p, 42);
+  a.allocate(8);  // a moved-from arena is empty but usable
+  EXPECT_EQ(a.block_count(), 1u);
+}
+
+TEST(Arena, AllocatorBacksStandardContainers) {
+  Arena arena(1024);
+  std::vector<int, ArenaAllocator<int>> v{ArenaAllocator<int>(arena)};
+  for (int i = 0; i < 1000; ++i) v.push_back(i);
+  EXPECT_EQ(v[999], 999);
+  EXPECT_GE(arena.used(), 1000 * sizeof(int));
+  EXPECT_TRUE(ArenaAllocator<int>(arena) == ArenaAllocator<double>(arena));
+  Arena other;
+  EXPECT_FALSE(ArenaAllocator<int>(arena) == ArenaAllocator<int>(other));
+}
+
+TEST(ScopedArena, NestedScopesGetDistinctArenasAndReuseThem) {
+  Arena* outer_arena = nullptr;
+  {
+    ScopedArena outer;
+    outer_arena = &outer.get();
+    outer->allocate(100);
+    {
+      ScopedArena inner;
+      EXPECT_NE(&inner.get(), outer_arena);
+      inner->allocate(100);
+    }
+    EXPECT_GE(outer->used(), 100u);
+  }
+  ScopedArena again;
+  EXPECT_EQ(again->used(), 0u);  // reset when it was returned
+  ScopedArena nested;
+  EXPECT_NE(&nested.get(), &again.get());
+  EXPECT_TRUE(&again.get() == outer_arena || &nested.get() == outer_arena);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <dlfcn.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "meat_quality/grading/batch_image_grader.hpp"
+#include "synthetic_image.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+class BatchImageGraderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Odd sizes, a one-pixel image, an empty one and strided crops.
+    const std::pair<std::uint32_t, std::uint32_t> sizes[] = {
+        {64, 48}, {97, 61}, {1, 1}, {33, 7}, {120, 90}, {0, 0}, {5, 130}};
+    for (std::uint32_t i = 0; i < 37; ++i) {
+      const auto [w, h] = sizes[i % std::size(sizes)];
+      images_.push_back(bench::make_carcass_image(w + 4, h + 3, i + 1, 0.3 + 0.01 * i));
+    }
+    for (std::uint32_t i = 0; i < images_.size(); ++i) {
+      const ImageView v = images_[i].view();
+      views_.push_back(i % 2 == 0 ? v : v.crop(3, 2, v.width - 4, v.height - 3));
+    }
+  }
+
+  // What the CPU path reports for `img`.
+  ImageGrade reference(const ImageView& img, const BatchImageOptions& o) const {
+    ImageGrade g;
+    g.color = summarize_color({&img, 1}, converter_, o.grading);
+    WorkStealingPool pool(1);
+    g.marbling = MarblingSegmenter(pool, converter_, o.marbling).segment(img);
+    return g;
+  }
+
+  static void expect_same_grade(const ImageGrade& got, const ImageGrade& want) {
+    EXPECT_EQ(got.color.pixels, want.color.pixels);
+    EXPECT_EQ(got.color.mean_l, want.color.mean_l);
+    EXPECT_EQ(got.color.mean_a, want.color.mean_a);
+    EXPECT_EQ(got.color.mean_b, want.color.mean_b);
+    EXPECT_EQ(got.color.a_p10, want.color.a_p10);
+    EXPECT_EQ(got.color.a_p50, want.color.a_p50);
+    EXPECT_EQ(got.color.a_p90, want.color.a_p90);
+    EXPECT_EQ(got.marbling.fat_pixels, want.marbling.fat_pixels);
+    EXPECT_EQ(got.marbling.lean_pixels, want.marbling.lean_pixels);
+    EXPECT_EQ(got.marbling.fleck_count, want.marbling.fleck_count);
+    EXPECT_EQ(got.marbling.largest_fleck, want.marbling.largest_fleck);
+  }
+
+  std::vector<bench::SyntheticImage> images_;
+  std::vector<ImageView> views_;
+  const LabConverter converter_{LabMode::kSimd};
+};
+
+TEST_F(BatchImageGraderTest, ReferenceBackendMatchesTheCpuPath) {
+  BatchImageOptions o;
+  o.batch = 5;  // 37 images: the last batch holds two
+  o.grading.redness_bins = 48;
+  o.marbling.min_fleck_pixels = 3;
+  BatchImageGrader grader(ImageAccelBackend::reference(), o);
+  EXPECT_EQ(grader.backend_name(), ImageAccelBackend::reference().name());
+
+  std::vector<ImageGrade> got(views_.size());
+  for (int pass = 0; pass < 2; ++pass) {  // staging buffers are reused
+    grader.grade(views_, got);
+    for (std::size_t i = 0; i < views_.size(); ++i) {
+      SCOPED_TRACE(testing::Message() << "pass " << pass << ", image " << i << " ("
+                                      << views_[i].width << "x" << views_[i].height << ")");
+      expect_same_grade(got[i], reference(views_[i], o));
+    }
+  }
+
+  // Fewer images than a batch, and none at all.
+  std::vector<ImageGrade> few(3);
+  grader.grade(std::span(views_).subspan(10, 3), few);
+  for (std::size_t i = 0; i < few.size(); ++i) expect_same_grade(few[i], got[10 + i]);
+  grader.grade({}, {});
+}
+
+TEST_F(BatchImageGraderTest, RejectsBadInputs) {
+  BatchImageOptions o;
+  o.batch = 0;
+  EXPECT_THROW(BatchImageGrader(ImageAccelBackend::reference(), o), std::invalid_argument);
+
+  o.batch = 4;
+  BatchImageGrader grader(ImageAccelBackend::reference(), o);
+  std::vector<ImageGrade> out(views_.size() - 1);
+  EXPECT_THROW(grader.grade(views_, out), std::invalid_argument);
+  out.resize(views_.size());
+  std::vector<ImageView> views = views_;
+  views[6].format = PixelFormat::kGray8;
+  EXPECT_THROW(grader.grade(views, out), std::invalid_argument);
+  grader.grade(views_, out);  // usable afterwards
+  expect_same_grade(out[6], reference(views_[6], grader.options()));
+}
+
+TEST_F(BatchImageGraderTest, LoadRejectsMissingAndForeignPlugins) {
+  test::TempDir dir;
+  EXPECT_THROW(ImageAccelBackend::load(dir.file("missing.so")), std::runtime_error);
+  test::write_file(dir.file("garbage.so"), std::vector<std::uint8_t>(64, 0x5a));
+  EXPECT_THROW(ImageAccelBackend::load(dir.file("garbage.so")), std::runtime_error);
+#if defined(MEAT_QUALITY_INT8_PLUGIN_PATH)
+  // A real plugin, but for another interface.
+  EXPECT_THROW(ImageAccelBackend::load(MEAT_QUALITY_INT8_PLUGIN_PATH), std::runtime_error);
+#endif
+}
+
+#if defined(MEAT_QUALITY_FAKE_IMAGE_ACCEL_PATH)
+// The fake plugin's device index picks the call that fails; see
+// fake_image_accel.cpp.
+class FakeAccelTest : public BatchImageGraderTest {
+ protected:
+  void SetUp() override {
+    BatchImageGraderTest::SetUp();
+    handle_ = dlopen(MEAT_QUALITY_FAKE_IMAGE_ACCEL_PATH, RTLD_NOW | RTLD_LOCAL);
+    ASSERT_NE(handle_, nullptr) << dlerror();
+    outstanding_ = reinterpret_cast<long (*)()>(dlsym(handle_, "fake_image_accel_outstanding"));
+    ASSERT_NE(outstanding_, nullptr);
+  }
+
+  void TearDown() override {
+    if (handle_ != nullptr) dlclose(handle_);
+  }
+
+  static BatchImageOptions on_device(int device) {
+    BatchImageOptions o;
+    o.batch = 4;
+    o.device = device;
+    return o;
+  }
+
+  const ImageAccelBackend backend_ = ImageAccelBackend::load(MEAT_QUALITY_FAKE_IMAGE_ACCEL_PATH);
+  void* handle_ = nullptr;
+  long (*outstanding_)() = nullptr;
+};
+
+TEST_F(FakeAccelTest, GradesThroughThePlugin) {
+  {
+    BatchImageGrader grader(backend_, on_device(0));
+    EXPECT_EQ(grader.backend_name(), "fake");
+    std::vector<ImageGrade> out(views_.size());
+    grader.grade(views_, out);
+    for (std::size_t i = 0; i < views_.size(); ++i) {
+      // Every pixel is background to the fake device.
+      EXPECT_EQ(out[i].color.pixels, std::uint64_t{views_[i].width} * views_[i].height);
+      EXPECT_EQ(out[i].marbling.fat_pixels + out[i].marbling.lean_pixels, 0u);
+    }
+  }
+  EXPECT_EQ(outstanding_(), 0);
+}
+
+TEST_F(FakeAccelTest, ReportsDeviceFailures) {
+  try {
+    BatchImageGrader grader(backend_, on_device(1));
+    ADD_FAILURE() << "opened a missing device";
+  } catch (const std::runtime_error& e) {
+    EXPECT_NE(std::string(e.what()).find("no such device"), std::string::npos) << e.what();
+  }
+
+  std::vector<ImageGrade> out(views_.size());
+  {
+    BatchImageGrader grader(backend_, on_device(2));
+    EXPECT_THROW(grader.grade(views_, out), std::runtime_error);
+  }
+  EXPECT_EQ(outstanding_(), 0);
+
+  {
+    // The first submission fails after the second is in flight; the next
+    // call waits for that one and succeeds.
+    BatchImageGrader grader(backend_, on_device(3));
+    EXPECT_THROW(grader.grade(views_, out), std::runtime_error);
+    grader.grade(views_, out);
+    EXPECT_EQ(out.back().color.pixels,
+              std::uint64_t{views_.back().width} * views_.back().height);
+  }
+  EXPECT_EQ(outstanding_(), 0);
+}
+#endif
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/inference/batching_engine.hpp"
+
+namespace meat_quality {
+namespace {
+
+using std::chrono::microseconds;
+using std::chrono::seconds;
+
+std::vector<FeatureVector> random_inputs(std::size_t n, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<float> normal(0.0f, 2.0f);
+  std::vector<FeatureVector> out(n);
+  for (FeatureVector& v : out) {
+    for (float& x : v) x = normal(rng);
+  }
+  return out;
+}
+
+class BatchingEngineTest : public ::testing::Test {
+ protected:
+  const FreshnessClassifier classifier_{ClassifierWeights::random(16, 5)};
+};
+
+// Batches of every size up to and past max_batch give what the single-sample
+// path gives, each to its own request.
+TEST_F(BatchingEngineTest, MatchesTheSingleSamplePath) {
+  BatchingEngine engine(classifier_, {.max_batch = 7, .max_wait = microseconds{200}});
+  const std::vector<FeatureVector> inputs = random_inputs(300, 1);
+  std::vector<std::future<Prediction>> results;
+  for (const FeatureVector& v : inputs) results.push_back(engine.submit(v));
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    const Prediction got = results[i].get();
+    const Prediction want = classifier_.predict(inputs[i]);
+    EXPECT_EQ(got.label, want.label) << i;
+    for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+      EXPECT_NEAR(got.probabilities[k], want.probabilities[k], 1e-6f) << i;
+    }
+  }
+  const BatchingStats s = engine.stats();
+  EXPECT_EQ(s.requests, inputs.size());
+  EXPECT_LE(s.last_batch_size, 7u);
+  EXPECT_GE(s.batches, (inputs.size() + 6) / 7);
+  EXPECT_EQ(std::accumulate(s.batch_size_buckets.begin(), s.batch_size_buckets.end(),
+                            std::uint64_t{0}),
+            s.batches);
+}
+
+TEST_F(BatchingEngineTest, ClosesFullBatchesWithoutWaiting) {
+  // The wait is far longer than the test, so only size closes a batch.
+  BatchingEngine engine(classifier_, {.max_batch = 8, .max_wait = seconds{30}});
+  std::atomic<int> done{0};
+  const auto on_done = [](void* ctx, const Prediction&) {
+    static_cast<std::atomic<int>*>(ctx)->fetch_add(1);
+  };
+  for (const FeatureVector& v : random_inputs(40, 2)) ASSERT_TRUE(engine.submit(v, on_done, &done));
+  engine.drain();
+  EXPECT_EQ(done.load(), 40);
+  const BatchingStats s = engine.stats();
+  EXPECT_EQ(s.batches, 5u);
+  EXPECT_EQ(s.batch_size_buckets[3], 5u);  // [8, 16)
+}
+
+TEST_F(BatchingEngineTest, ClosesAPartialBatchAfterMaxWait) {
+  BatchingEngine engine(classifier_, {.max_batch = 64, .max_wait = microseconds{1000}});
+  std::vector<std::future<Prediction>> results;
+  for (const FeatureVector& v : random_inputs(3, 3)) results.push_back(engine.submit(v));
+  for (auto& r : results) ASSERT_EQ(r.wait_for(seconds{10}), std::future_status::ready);
+  const BatchingStats s = engine.stats();
+  EXPECT_EQ(s.batches, 1u);
+  EXPECT_EQ(s.last_batch_size, 3u);
+  EXPECT_GE(s.queue_wait_ns, 1'000'000u);
+}
+
+TEST_F(BatchingEngineTest, RejectsWhenFullOrStopped) {
+  BatchingEngine engine(classifier_,
+                        {.max_batch = 64, .max_wait = seconds{30}, .queue_capacity = 4});
+  const std::vector<FeatureVector> inputs = random_inputs(6, 4);
+  std::vector<std::future<Prediction>> queued;
+  for (std::size_t i = 0; i < 4; ++i) queued.push_back(engine.submit(inputs[i]));
+  std::future<Prediction> over = engine.submit(inputs[4]);
+  EXPECT_THROW(over.get(), std::runtime_error);
+
+  // Stopping completes what was queued without waiting out max_wait.
+  engine.stop();
+  for (auto& r : queued) {
+    ASSERT_EQ(r.wait_for(seconds{0}), std::future_status::ready);
+    EXPECT_NE(r.get().label, FreshnessClass::kUnknown);
+  }
+  EXPECT_FALSE(engine.submit(inputs[5], [](void*, const Prediction&) { FAIL(); }, nullptr));
+  EXPECT_EQ(engine.stats().rejected, 2u);
+  EXPECT_EQ(engine.stats().requests, 4u);
+}
+
+TEST_F(BatchingEngineTest, RejectsAnEmptyBatchOrQueue) {
+  EXPECT_THROW(BatchingEngine(classifier_, {.max_batch = 0}), std::invalid_argument);
+  EXPECT_THROW(BatchingEngine(classifier_, {.max_batch = 8, .queue_capacity = 0}),
+               std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "test_support.hpp"
+
+#if defined(MEAT_QUALITY_BENCH_COMPARE_PATH)
+
+namespace meat_quality {
+namespace {
+
+struct BenchRun {
+  std::string name;
+  double cpu_time;
+  double real_time = 0;
+  std::string time_unit = "ns";
+  std::string run_type = "iteration";
+  std::string aggregate_name = "";
+  bool error = false;
+};
+
+// The line-per-field layout of Google Benchmark's JSON reporter.
+std::string result_json(const std::vector<BenchRun>& runs, const std::string& host = "gate") {
+  std::string out = "{\n  \"context\": {\n    \"host_name\": \"" + host +
+                    "\",\n    \"num_cpus\": 4,\n    \"caches\": [\n      {\n"
+                    "        \"level\": 1\n      }\n    ]\n  },\n  \"benchmarks\": [\n";
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    const BenchRun& r = runs[i];
+    out += "    {\n      \"name\": \"" + r.name + "\",\n";
+    out += "      \"run_name\": \"" + r.name + "\",\n";
+    out += "      \"run_type\": \"" + r.run_type + "\",\n";
+    if (!r.aggregate_name.empty()) {
+      out += "      \"aggregate_name\": \"" + r.aggregate_name + "\",\n";
+    }
+    if (r.error) out += "      \"error_occurred\": true,\n";
+    out += "      \"real_time\": " + std::to_string(r.real_time) + ",\n";
+    out += "      \"cpu_time\": " + std::to_string(r.cpu_time) + ",\n";
+    out += "      \"time_unit\": \"" + r.time_unit + "\"\n";
+    out += i + 1 < runs.size() ? "    },\n" : "    }\n";
+  }
+  return out + "  ]\n}\n";
+}
+
+class BenchCompareTest : public ::testing::Test {
+ protected:
+  // Exit status of the comparison; its output is left in `output_`.
+  int compare(const std::vector<BenchRun>& baseline, const std::vector<BenchRun>& results,
+              const std::string& args = "") {
+    write(dir_.file("baseline.json"), result_json(baseline));
+    write(dir_.file("results.json"), result_json(results));
+    return run(dir_.file("baseline.json") + " " + dir_.file("results.json") + " " + args);
+  }
+
+  int run(const std::string& args) {
+    const std::string out = dir_.file("out.txt");
+    const std::string command =
+        std::string(MEAT_QUALITY_BENCH_COMPARE_PATH) + " " + args + " >" + out + " 2>&1";
+    const int status = std::system(command.c_str());
+    const std::vector<std::uint8_t> bytes = test::read_file(out);
+    output_.assign(bytes.begin(), bytes.end());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  static void write(const std::string& path, const std::string& text) {
+    test::write_file(path, {text.begin(), text.end()});
+  }
+
+  bool output_has(const std::string& text) const {
+    return output_.find(text) != std::string::npos;
+  }
+
+  test::TempDir dir_;
+  std::string output_;
+};
+
+TEST_F(BenchCompareTest, PassesWithinToleranceAndFailsBeyondIt) {
+  const std::vector<BenchRun> base = {{"BM_A", 100}, {"BM_B", 1000}};
+  EXPECT_EQ(compare(base, {{"BM_A", 120}, {"BM_B", 900}}), 0) << output_;
+  EXPECT_TRUE(output_has("no regressions beyond 25%"));
+
+  EXPECT_EQ(compare(base, {{"BM_A", 130}, {"BM_B", 900}}), 1) << output_;
+  EXPECT_TRUE(output_has("REGRESSION"));
+  EXPECT_TRUE(output_has("1 benchmark(s) slower"));
+  EXPECT_EQ(compare(base, {{"BM_A", 130}, {"BM_B", 900}}, "--tolerance=0.5"), 0) << output_;
+}
+
+TEST_F(BenchCompareTest, ComparesTheFastestRepetition) {
+  // The medians, 200 and 140, would pass; the fastest runs are 100 and 130.
+  const std::vector<BenchRun> base = {{"BM_A", 100}, {"BM_A", 300},
+                                      {"BM_A", 200, 0, "ns", "aggregate", "median"}};
+  EXPECT_EQ(compare(base, {{"BM_A", 140}, {"BM_A", 130}, {"BM_A", 150},
+                           {"BM_A", 140, 0, "ns", "aggregate", "median"}}),
+            1)
+      << output_;
+
+  // Aggregates alone fall back to the median.
+  const std::vector<BenchRun> aggregates = {{"BM_A", 50, 0, "ns", "aggregate", "mean"},
+                                            {"BM_A", 100, 0, "ns", "aggregate", "median"}};
+  EXPECT_EQ(compare(aggregates, {{"BM_A", 0.11, 0, "us", "aggregate", "median"}}), 0)
+      << output_;
+}
+
+TEST_F(BenchCompareTest, UsesRealTimeOnlyWhenMeasured) {
+  EXPECT_EQ(compare({{"BM_Net/real_time", 1, 100}}, {{"BM_Net/real_time", 1, 200}}), 1)
+      << output_;
+  EXPECT_EQ(compare({{"BM_Cpu", 100, 1}}, {{"BM_Cpu", 100, 900}}), 0) << output_;
+  EXPECT_EQ(compare({{"BM_Ms", 1, 0, "ms"}}, {{"BM_Ms", 1100, 0, "us"}}), 0) << output_;
+}
+
+TEST_F(BenchCompareTest, ReportsMissingNewAndFailedBenchmarks) {
+  const std::vector<BenchRun> base = {{"BM_Gone", 10}, {"BM_Kept", 10}};
+  EXPECT_EQ(compare(base, {{"BM_Kept", 10}, {"BM_New", 10}}), 0) << output_;
+  EXPECT_TRUE(output_has("  missing"));
+  EXPECT_TRUE(output_has("  new"));
+
+  // A run that reported an error is not a measurement.
+  BenchRun failed{"BM_Kept", 1000};
+  failed.error = true;
+  EXPECT_EQ(compare(base, {failed, {"BM_Kept", 10}}), 0) << output_;
+}
+
+TEST_F(BenchCompareTest, RejectsBadArgumentsAndFiles) {
+  EXPECT_EQ(run(""), 2);
+  EXPECT_TRUE(output_has("usage"));
+  EXPECT_EQ(run(dir_.file("a.json")), 2);
+  EXPECT_EQ(compare({{"BM_A", 1}}, {{"BM_A", 1}}, "--tolerance=0"), 2);
+  EXPECT_EQ(compare({{"BM_A", 1}}, {{"BM_A", 1}}, "--tolerance=-1"), 2);
+
+  write(dir_.file("results.json"), result_json({{"BM_A", 1}}));
+  EXPECT_EQ(run(dir_.file("missing.json") + " " + dir_.file("results.json")), 2);
+  EXPECT_TRUE(output_has("cannot open"));
+
+  // Results with no benchmark runs, e.g. an interrupted run.
+  write(dir_.file("empty.json"), result_json({}));
+  EXPECT_EQ(run(dir_.file("results.json") + " " + dir_.file("empty.json")), 2);
+  EXPECT_TRUE(output_has("no benchmark runs"));
+  BenchRun errored{"BM_A", 1};
+  errored.error = true;
+  write(dir_.file("errored.json"), result_json({errored}));
+  EXPECT_EQ(run(dir_.file("results.json") + " " + dir_.file("errored.json")), 2);
+}
+
+TEST_F(BenchCompareTest, WarnsAboutADifferentMachine) {
+  write(dir_.file("baseline.json"), result_json({{"BM_A", 10}}, "gate"));
+  write(dir_.file("results.json"), result_json({{"BM_A", 10}}, "laptop"));
+  EXPECT_EQ(run(dir_.file("baseline.json") + " " + dir_.file("results.json")), 0);
+  EXPECT_TRUE(output_has("warning: baseline from gate"));
+}
+
+}  // namespace
+}  // namespace meat_quality
+
+#endif  // MEAT_QUALITY_BENCH_COMPARE_PATH
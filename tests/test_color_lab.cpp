@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/image/color_lab.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+using test::EachSimdLevel;
+
+constexpr float kSentinel = -1000.0f;
+
+// `width` x `height` random pixels in rows padded by a few bytes, so the
+// kernels never see a contiguous image by accident.
+struct RandomImage {
+  RandomImage(std::uint32_t width, std::uint32_t height, std::uint64_t seed)
+      : width(width), height(height), stride(std::size_t{width} * 3 + 5),
+        pixels(stride * height) {
+    std::mt19937_64 rng(seed);
+    for (std::uint8_t& p : pixels) p = static_cast<std::uint8_t>(rng());
+  }
+
+  ImageView view() const noexcept {
+    return {pixels.data(), width, height, stride, PixelFormat::kRgb8};
+  }
+  const std::uint8_t* at(std::uint32_t x, std::uint32_t y) const {
+    return pixels.data() + y * stride + x * 3;
+  }
+
+  std::uint32_t width, height;
+  std::size_t stride;
+  std::vector<std::uint8_t> pixels;
+};
+
+// Converts into the middle of a larger image, checks every pixel against
+// the exact formula and that nothing outside the crop was written.
+float max_delta_e(const LabConverter& conv, const RandomImage& img) {
+  LabImage out(img.width + 3, img.height + 2);
+  const LabPlanes& all = out.planes();
+  for (float* plane : {all.l, all.a, all.b}) {
+    std::fill(plane, plane + all.stride * all.height, kSentinel);
+  }
+  conv.convert(img.view(), all.crop(2, 1, img.width, img.height));
+  float worst = 0.0f;
+  for (std::uint32_t y = 0; y < all.height; ++y) {
+    for (std::uint32_t x = 0; x < all.width; ++x) {
+      const std::size_t i = y * all.stride + x;
+      const bool inside = x >= 2 && x < img.width + 2 && y >= 1 && y < img.height + 1;
+      if (!inside) {
+        EXPECT_EQ(all.l[i], kSentinel) << x << "," << y;
+        continue;
+      }
+      const std::uint8_t* p = img.at(x - 2, y - 1);
+      const Lab got{all.l[i], all.a[i], all.b[i]};
+      worst = std::max(worst, delta_e76(got, srgb_to_lab_exact(p[0], p[1], p[2])));
+    }
+  }
+  return worst;
+}
+
+TEST(ColorLab, ExactMatchesPublishedValues) {
+  const Lab white = srgb_to_lab_exact(255, 255, 255);
+  EXPECT_NEAR(white.l, 100.0f, 1e-3f);
+  EXPECT_NEAR(white.a, 0.0f, 1e-2f);
+  EXPECT_NEAR(white.b, 0.0f, 1e-2f);
+  const Lab black = srgb_to_lab_exact(0, 0, 0);
+  EXPECT_NEAR(black.l, 0.0f, 1e-4f);
+  const Lab red = srgb_to_lab_exact(255, 0, 0);
+  EXPECT_NEAR(red.l, 53.24f, 0.01f);
+  EXPECT_NEAR(red.a, 80.09f, 0.01f);
+  EXPECT_NEAR(red.b, 67.20f, 0.01f);
+}
+
+// Widths 1 to 40 cover every tail length of the 8- and 16-lane kernels.
+TEST_F(EachSimdLevel, SimdModeStaysCloseToExactAtEveryWidth) {
+  const LabConverter conv(LabMode::kSimd);
+  for_each_level([&] {
+    for (std::uint32_t w = 1; w <= 40; ++w) {
+      EXPECT_LT(max_delta_e(conv, RandomImage(w, 3, w)), 0.01f) << "width " << w;
+    }
+  });
+}
+
+TEST(ColorLab, LutModeStaysCloseToExact) {
+  const LabConverter conv(LabMode::kLut);
+  EXPECT_LT(max_delta_e(conv, RandomImage(97, 61, 1)), 1.0f);
+  EXPECT_LT(max_delta_e(conv, RandomImage(1, 1, 2)), 1.0f);
+}
+
+TEST(ColorLab, ExactModeIsTheReference) {
+  const LabConverter conv(LabMode::kExact);
+  EXPECT_EQ(max_delta_e(conv, RandomImage(17, 5, 3)), 0.0f);
+}
+
+TEST_F(EachSimdLevel, SinglePixelMatchesTheImagePath) {
+  const RandomImage img(33, 1, 4);
+  for (const LabMode mode : {LabMode::kExact, LabMode::kSimd, LabMode::kLut}) {
+    const LabConverter conv(mode);
+    for_each_level([&] {
+      LabImage out(img.width, 1);
+      conv.convert(img.view(), out.planes());
+      for (std::uint32_t x = 0; x < img.width; ++x) {
+        const std::uint8_t* p = img.at(x, 0);
+        const Lab one = conv.convert(p[0], p[1], p[2]);
+        const Lab image{out.planes().l[x], out.planes().a[x], out.planes().b[x]};
+        EXPECT_LT(delta_e76(one, image), 1e-3f) << "mode " << int(mode) << " x " << x;
+      }
+    });
+  }
+}
+
+TEST(ColorLab, BorrowedLutConvertsIdentically) {
+  const LabConverter owner(LabMode::kLut, 17);
+  const LabConverter borrower(owner.lut(), owner.lut_grid());
+  EXPECT_EQ(borrower.mode(), LabMode::kLut);
+  EXPECT_EQ(borrower.lut().data(), owner.lut().data());
+  const RandomImage img(23, 7, 5);
+  LabImage a(img.width, img.height), b(img.width, img.height);
+  owner.convert(img.view(), a.planes());
+  borrower.convert(img.view(), b.planes());
+  const std::size_t n = a.planes().stride * img.height;
+  EXPECT_TRUE(std::equal(a.planes().l, a.planes().l + n, b.planes().l));
+  EXPECT_TRUE(std::equal(a.planes().a, a.planes().a + n, b.planes().a));
+
+  EXPECT_THROW(LabConverter(owner.lut().first(owner.lut().size() - 4), 17),
+               std::invalid_argument);
+}
+
+TEST(ColorLab, RejectsMismatchedInputs) {
+  const LabConverter conv(LabMode::kSimd);
+  const RandomImage img(8, 4, 6);
+  LabImage small(7, 4);
+  EXPECT_THROW(conv.convert(img.view(), small.planes()), std::invalid_argument);
+  ImageView gray = img.view();
+  gray.format = PixelFormat::kGray8;
+  LabImage out(8, 4);
+  EXPECT_THROW(conv.convert(gray, out.planes()), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/storage/feature_matrix.hpp"
+#include "meat_quality/storage/segment.hpp"
+#include "synthetic_image.hpp"
+#include "synthetic_trace.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+using feature_matrix::ColumnEntry;
+using feature_matrix::ColumnType;
+using feature_matrix::FileHeader;
+
+// A finished matrix read back the way numpy would map it.
+struct MatrixFile {
+  explicit MatrixFile(const std::string& path) : bytes(test::read_file(path)) {
+    EXPECT_GE(bytes.size(), sizeof header);
+    std::memcpy(&header, bytes.data(), sizeof header);
+    entries.resize(header.column_count);
+    std::memcpy(entries.data(), bytes.data() + sizeof header,
+                entries.size() * sizeof(ColumnEntry));
+  }
+
+  std::size_t column(const std::string& name) const {
+    for (std::size_t c = 0; c < entries.size(); ++c) {
+      if (name == entries[c].name) return c;
+    }
+    ADD_FAILURE() << "no column " << name;
+    return 0;
+  }
+
+  template <typename T>
+  T at(std::size_t column, std::size_t row) const {
+    EXPECT_EQ(entries[column].type, feature_matrix::column_type_of<T>());
+    T v;
+    std::memcpy(&v, bytes.data() + entries[column].offset + row * sizeof(T), sizeof v);
+    return v;
+  }
+
+  template <typename T>
+  T at(const std::string& name, std::size_t row) const {
+    return at<T>(column(name), row);
+  }
+
+  std::vector<std::uint8_t> bytes;
+  FileHeader header{};
+  std::vector<ColumnEntry> entries;
+};
+
+TEST(FeatureMatrixWriter, ThreadsFillDisjointSlicesOfAlignedColumns) {
+  test::TempDir dir;
+  const std::vector<ColumnSpec> columns = {{"node", ColumnType::kU32},
+                                           {"at", ColumnType::kI64},
+                                           {"x", ColumnType::kF32}};
+  constexpr std::uint64_t kRows = 1001;  // odd, so the columns need padding
+  FeatureMatrixWriter writer(dir.file("m.mqfm"), kRows, columns);
+  EXPECT_EQ(writer.rows(), kRows);
+  EXPECT_EQ(writer.column_count(), 3u);
+  {
+    std::vector<std::thread> threads;
+    for (std::uint64_t first = 0; first < kRows; first += 100) {
+      threads.emplace_back([&, first] {
+        const std::size_t n = std::min<std::uint64_t>(100, kRows - first);
+        std::vector<std::uint32_t> node(n);
+        std::vector<std::int64_t> at(n);
+        std::vector<float> x(n);
+        for (std::size_t i = 0; i < n; ++i) {
+          node[i] = static_cast<std::uint32_t>(first + i);
+          at[i] = -(static_cast<std::int64_t>(first + i) << 33);
+          x[i] = static_cast<float>(first + i) * 0.5f;
+        }
+        writer.write<float>(2, first, x);  // columns in any order
+        writer.write<std::uint32_t>(0, first, node);
+        writer.write<std::int64_t>(1, first, at);
+      });
+    }
+    for (std::thread& t : threads) t.join();
+  }
+  writer.finish();
+  writer.finish();  // a second call does nothing
+
+  const MatrixFile m(dir.file("m.mqfm"));
+  EXPECT_EQ(m.header.magic, feature_matrix::kMagic);
+  EXPECT_EQ(m.header.version, feature_matrix::kVersion);
+  EXPECT_EQ(m.header.rows, kRows);
+  ASSERT_EQ(m.header.column_count, 3u);
+  std::uint64_t end = sizeof(FileHeader) + 3 * sizeof(ColumnEntry);
+  for (std::size_t c = 0; c < 3; ++c) {
+    EXPECT_EQ(m.entries[c].name, columns[c].name);
+    EXPECT_EQ(m.entries[c].offset % kCacheLineSize, 0u) << c;
+    EXPECT_GE(m.entries[c].offset, end) << c;
+    end = m.entries[c].offset + kRows * feature_matrix::column_type_size(columns[c].type);
+  }
+  EXPECT_GE(m.bytes.size(), end);
+  for (std::size_t r = 0; r < kRows; ++r) {
+    ASSERT_EQ(m.at<std::uint32_t>(0, r), r);
+    ASSERT_EQ(m.at<std::int64_t>(1, r), -(static_cast<std::int64_t>(r) << 33));
+    ASSERT_EQ(m.at<float>(2, r), static_cast<float>(r) * 0.5f);
+  }
+}
+
+TEST(FeatureMatrixWriter, AnUnfinishedFileHasNoMagic) {
+  test::TempDir dir;
+  const std::vector<ColumnSpec> columns = {{"x", ColumnType::kF32}};
+  {
+    FeatureMatrixWriter writer(dir.file("m.mqfm"), 10, columns);
+    const std::vector<float> x(10, 1.0f);
+    writer.write<float>(0, 0, x);
+  }
+  const std::vector<std::uint8_t> bytes = test::read_file(dir.file("m.mqfm"));
+  ASSERT_GE(bytes.size(), sizeof(FileHeader));
+  FileHeader header;
+  std::memcpy(&header, bytes.data(), sizeof header);
+  EXPECT_NE(header.magic, feature_matrix::kMagic);
+}
+
+TEST(FeatureMatrixWriter, RejectsBadColumnsAndWrites) {
+  test::TempDir dir;
+  const std::string path = dir.file("m.mqfm");
+  const auto make = [&](std::string name) {
+    const std::vector<ColumnSpec> columns = {{std::move(name), ColumnType::kF32}};
+    FeatureMatrixWriter writer(path, 4, columns);
+  };
+  EXPECT_THROW(make(""), std::invalid_argument);
+  EXPECT_THROW(make(std::string(feature_matrix::kMaxNameBytes + 1, 'x')), std::invalid_argument);
+  EXPECT_NO_THROW(make(std::string(feature_matrix::kMaxNameBytes, 'x')));
+  const std::vector<ColumnSpec> columns = {{"x", ColumnType::kF32}};
+  EXPECT_THROW(FeatureMatrixWriter(dir.file("missing/m.mqfm"), 4, columns), std::system_error);
+
+  FeatureMatrixWriter writer(path, 4, columns);
+  const std::vector<float> two(2);
+  const std::vector<std::int32_t> ints(2);
+  EXPECT_THROW(writer.write<float>(1, 0, two), std::invalid_argument);
+  EXPECT_THROW(writer.write<std::int32_t>(0, 0, ints), std::invalid_argument);
+  EXPECT_THROW(writer.write<float>(0, 3, two), std::invalid_argument);
+  EXPECT_THROW(writer.write<float>(0, 5, {}), std::invalid_argument);
+  EXPECT_NO_THROW(writer.write<float>(0, 2, two));
+  EXPECT_NO_THROW(writer.write<float>(0, 4, {}));
+}
+
+#if defined(MEAT_QUALITY_EXTRACT_FEATURES_PATH)
+
+constexpr Timestamp kMinute = 60 * kMicrosPerSecond;
+constexpr Timestamp kDay = 24 * kMicrosPerHour;
+const std::vector<NodeId> kNodes = {2, 7, 40};
+
+// Three days of one sample a minute per node, split across two segments
+// inside a labelled window, and labels on every day with one tray image.
+class ExtractFeaturesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bench::TraceGenerator gen(9);
+    SegmentWriter first(dir_.file("a.seg"), 256), second(dir_.file("b.seg"), 256);
+    for (Timestamp t = kMinute; t < 3 * kDay; t += kMinute) {
+      for (const NodeId n : kNodes) {
+        SensorSample s = gen.sample(n, static_cast<std::uint64_t>(t / kMinute));
+        s.timestamp = t;
+        store_.push(n, s);
+        (t < kDay + 9 * kMicrosPerHour ? first : second).append(n, s);
+      }
+    }
+    first.finish();
+    second.finish();
+
+    const bench::SyntheticImage img = bench::make_carcass_image(40, 24, 4);
+    std::string ppm = "P6\n# tray\n40 24\n255\n";
+    ppm.append(img.pixels.begin(), img.pixels.end());
+    test::write_file(dir_.file("tray.ppm"), {ppm.begin(), ppm.end()});
+    const ImageView view = img.view();
+    color_ = summarize_color({&view, 1}, LabConverter{});
+
+    // Unsorted on purpose, with a header and a comment.
+    std::string csv = "node,timestamp_us,label,image\n# spot checks\n";
+    for (const Timestamp day : {2, 0, 1}) {
+      for (const NodeId n : kNodes) {
+        for (const Timestamp hour : {9, 3, 17}) {
+          const Timestamp at = day * kDay + hour * kMicrosPerHour + 30 * kMicrosPerSecond;
+          csv += std::to_string(n) + "," + std::to_string(at) + "," +
+                 std::to_string((n + hour) % 3) + (n == 7 && hour == 9 ? ",tray.ppm" : "") +
+                 "\n";
+          labels_.push_back({n, at});
+        }
+      }
+    }
+    write(dir_.file("labels.csv"), csv);
+    std::sort(labels_.begin(), labels_.end());
+  }
+
+  int extract(const std::string& args) {
+    const std::string command = std::string(MEAT_QUALITY_EXTRACT_FEATURES_PATH) + " " + args +
+                                " >" + dir_.file("out.txt") + " 2>&1";
+    const int status = std::system(command.c_str());
+    const std::vector<std::uint8_t> bytes = test::read_file(dir_.file("out.txt"));
+    output_.assign(bytes.begin(), bytes.end());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  std::string standard_args(const std::string& out) const {
+    return "--labels " + dir_.file("labels.csv") + " --out " + dir_.file(out) + " --images " +
+           dir_.file(".") + " --window-hours 1 " + dir_.file("a.seg") + " " + dir_.file("b.seg");
+  }
+
+  static void write(const std::string& path, const std::string& text) {
+    test::write_file(path, {text.begin(), text.end()});
+  }
+
+  test::TempDir dir_;
+  SampleStore store_{41, 8192};  // holds all three days: no wrap
+  std::vector<std::pair<NodeId, Timestamp>> labels_;
+  ColorSummary color_;
+  std::string output_;
+};
+
+TEST_F(ExtractFeaturesTest, RowsMatchTheServingFeaturesForAnyThreadCount) {
+  ASSERT_EQ(extract(standard_args("one.mqfm") + " --threads 1"), 0) << output_;
+  ASSERT_EQ(extract(standard_args("three.mqfm") + " --threads 3"), 0) << output_;
+  EXPECT_EQ(test::read_file(dir_.file("one.mqfm")), test::read_file(dir_.file("three.mqfm")));
+
+  const MatrixFile m(dir_.file("one.mqfm"));
+  EXPECT_EQ(m.header.magic, feature_matrix::kMagic);
+  ASSERT_EQ(m.header.rows, labels_.size());
+  ASSERT_EQ(m.header.column_count, 4 + kFeatureDim + 7);
+  for (std::size_t f = 0; f < kFeatureDim; ++f) EXPECT_EQ(m.entries[4 + f].name, feature_name(f));
+
+  std::size_t with_color = 0;
+  for (std::size_t r = 0; r < labels_.size(); ++r) {
+    const auto [node, at] = labels_[r];
+    SCOPED_TRACE(testing::Message() << "row " << r);
+    ASSERT_EQ(m.at<std::uint32_t>("node", r), node);
+    ASSERT_EQ(m.at<std::int64_t>("at", r), at);
+    WindowView window = store_.window(node, at - kMicrosPerHour);
+    std::size_t keep = window.size();
+    while (keep > 0 && window.timestamps[keep - 1] > at) --keep;
+    window = window.head(keep);
+    EXPECT_EQ(m.at<std::uint32_t>("samples", r), window.size());
+    const FeatureVector want = to_feature_vector(extract_features(window, FeatureOptions{}));
+    for (std::size_t f = 0; f < kFeatureDim; ++f) {
+      EXPECT_EQ(m.at<float>(4 + f, r), want[f]) << feature_name(f);
+    }
+    if (m.at<std::uint32_t>("has_color", r) != 0) {
+      ++with_color;
+      EXPECT_EQ(m.at<float>("mean_a", r), color_.mean_a);
+      EXPECT_EQ(m.at<float>("a_p90", r), color_.a_p90);
+    } else {
+      EXPECT_EQ(m.at<float>("mean_l", r), 0.0f);
+    }
+  }
+  EXPECT_EQ(with_color, 3u);
+}
+
+TEST_F(ExtractFeaturesTest, ShardsSplitWholeNodeDays) {
+  std::set<std::pair<NodeId, Timestamp>> seen;
+  std::set<std::pair<NodeId, Timestamp>> days[3];
+  for (int shard = 0; shard < 3; ++shard) {
+    const std::string out = "shard" + std::to_string(shard) + ".mqfm";
+    ASSERT_EQ(extract(standard_args(out) + " --shard " + std::to_string(shard) + "/3"), 0)
+        << output_;
+    const MatrixFile m(dir_.file(out));
+    for (std::size_t r = 0; r < m.header.rows; ++r) {
+      const NodeId node = m.at<std::uint32_t>("node", r);
+      const Timestamp at = m.at<std::int64_t>("at", r);
+      EXPECT_TRUE(seen.emplace(node, at).second);
+      days[shard].emplace(node, at / kDay);
+    }
+  }
+  const std::set<std::pair<NodeId, Timestamp>> all(labels_.begin(), labels_.end());
+  EXPECT_EQ(seen, all);
+  for (int a = 0; a < 3; ++a) {
+    for (int b = a + 1; b < 3; ++b) {
+      for (const auto& day : days[a]) EXPECT_EQ(days[b].count(day), 0u);
+    }
+  }
+}
+
+TEST_F(ExtractFeaturesTest, RejectsBadArgumentsAndInputs) {
+  EXPECT_EQ(extract(""), 2);
+  EXPECT_NE(output_.find("usage"), std::string::npos);
+  for (const char* bad : {" --shard 3/3", " --shard 1", " --threads x", " --window-hours 0",
+                          " --frobnicate", " --images"}) {
+    EXPECT_EQ(extract(standard_args("m.mqfm") + bad), 2) << bad;
+  }
+
+  EXPECT_EQ(extract(standard_args("m.mqfm") + " " + dir_.file("missing.seg")), 1);
+  write(dir_.file("labels.csv"), "2,100,1\n7,oops,1\n");
+  EXPECT_EQ(extract(standard_args("m.mqfm")), 1);
+  EXPECT_NE(output_.find("labels.csv:2: bad label line"), std::string::npos) << output_;
+  write(dir_.file("labels.csv"), "2,100,1,missing.ppm\n");
+  EXPECT_EQ(extract(standard_args("m.mqfm")), 1);
+  EXPECT_NE(output_.find("cannot read image"), std::string::npos) << output_;
+}
+
+#endif  // MEAT_QUALITY_EXTRACT_FEATURES_PATH
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "meat_quality/image/shm_frame_ring.hpp"
+#include "meat_quality/image/v4l2_frame_source.hpp"
+
+namespace meat_quality {
+namespace {
+
+using std::chrono::milliseconds;
+
+constexpr std::uint32_t kWidth = 8;
+constexpr std::uint32_t kHeight = 4;
+
+std::string ring_name() {
+  static int counter = 0;
+  return "/mq_test_" + std::to_string(::getpid()) + "_" + std::to_string(counter++);
+}
+
+// Writes a frame whose first pixel byte is `marker`.
+void capture(ShmFrameWriter& writer, std::uint8_t marker, Timestamp at) {
+  std::uint8_t* px = writer.begin_frame();
+  ASSERT_NE(px, nullptr);
+  px[0] = marker;
+  writer.publish(at);
+}
+
+TEST(ShmFrameRing, HandsOutFramesOldestFirstInPlace) {
+  const std::string name = ring_name();
+  ShmFrameWriter writer(name, kWidth, kHeight, 3);
+  ShmFrameSource source(name);
+  EXPECT_FALSE(source.acquire(milliseconds{0}));
+
+  capture(writer, 11, 100);
+  capture(writer, 22, 200);
+  FrameRef first = source.acquire(milliseconds{0});
+  ASSERT_TRUE(first);
+  EXPECT_EQ(first->sequence, 0u);
+  EXPECT_EQ(first->timestamp, 100);
+  EXPECT_EQ(first.image().data[0], 11);
+  EXPECT_EQ(first.image().width, kWidth);
+  EXPECT_EQ(first.image().height, kHeight);
+  EXPECT_EQ(first.image().stride, writer.stride());
+
+  FrameRef copy = first;
+  EXPECT_EQ(first.use_count(), 2u);
+  const FrameRef second = source.acquire(milliseconds{0});
+  ASSERT_TRUE(second);
+  EXPECT_EQ(second.image().data[0], 22);
+  EXPECT_EQ(source.in_flight(), 2u);
+
+  // The slot goes back to the writer only with the last reference.
+  first.reset();
+  EXPECT_EQ(source.in_flight(), 2u);
+  copy.reset();
+  EXPECT_EQ(source.in_flight(), 1u);
+  EXPECT_EQ(writer.dropped(), 0u);
+}
+
+TEST(ShmFrameRing, WriterOverwritesTheOldestUnreadFrame) {
+  const std::string name = ring_name();
+  ShmFrameWriter writer(name, kWidth, kHeight, 2);
+  ShmFrameSource source(name);
+  capture(writer, 1, 1);
+  capture(writer, 2, 2);
+  capture(writer, 3, 3);  // the grader lags: frame 1 is lost
+  EXPECT_EQ(writer.dropped(), 1u);
+  const FrameRef a = source.acquire(milliseconds{0});
+  const FrameRef b = source.acquire(milliseconds{0});
+  ASSERT_TRUE(a && b);
+  EXPECT_EQ(a.image().data[0], 2);
+  EXPECT_EQ(b.image().data[0], 3);
+
+  // Every slot is being read: nothing to capture into, nothing stolen.
+  EXPECT_EQ(writer.begin_frame(), nullptr);
+  EXPECT_EQ(writer.dropped(), 1u);
+}
+
+TEST(ShmFrameRing, AcquireTimesOutWithoutAFrame) {
+  const std::string name = ring_name();
+  ShmFrameWriter writer(name, kWidth, kHeight, 2);
+  ShmFrameSource source(name);
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(source.acquire(milliseconds{20}));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds{15});
+}
+
+TEST(ShmFrameRing, RejectsMissingAndTruncatedSegments) {
+  EXPECT_THROW(ShmFrameSource{ring_name()}, std::system_error);
+  EXPECT_THROW((ShmFrameWriter{ring_name(), 0, kHeight, 2}), std::invalid_argument);
+
+  const std::string name = ring_name();
+  const int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(::ftruncate(fd, sizeof(shm::RingHeader) - 1), 0);
+  ::close(fd);
+  EXPECT_THROW(ShmFrameSource{name}, std::runtime_error);
+  ::shm_unlink(name.c_str());
+}
+
+// A writer's segment with one header field rewritten, as a stale or
+// hostile producer might leave it.
+TEST(ShmFrameRing, RejectsEveryInconsistentHeader) {
+  const std::vector<std::function<void(shm::RingHeader&)>> edits = {
+      [](shm::RingHeader& h) { h.version = shm::kVersion + 1; },
+      [](shm::RingHeader& h) { h.format = 7; },
+      [](shm::RingHeader& h) { h.slot_count = 0; },
+      [](shm::RingHeader& h) { h.slot_count = 1u << 31; },  // slot table overruns
+      [](shm::RingHeader& h) { h.width = 0; },
+      [](shm::RingHeader& h) { h.height = 0; },
+      [](shm::RingHeader& h) { h.stride = h.width * 3 - 1; },
+      [](shm::RingHeader& h) { h.stride = 0; },
+      [](shm::RingHeader& h) {
+        h.height = static_cast<std::uint32_t>(h.slot_bytes / h.stride) + 1;
+      },
+      [](shm::RingHeader& h) { h.slot_bytes = ~std::uint64_t{0} / 2 + 1; },  // wraps when multiplied
+      [](shm::RingHeader& h) { h.slots_offset = 8; },
+      [](shm::RingHeader& h) { h.slots_offset += 1; },
+      [](shm::RingHeader& h) { h.slots_offset = h.data_offset + 64; },
+      [](shm::RingHeader& h) { h.data_offset = ~std::uint64_t{0}; },
+  };
+  for (std::size_t k = 0; k < edits.size(); ++k) {
+    const std::string name = ring_name();
+    ShmFrameWriter writer(name, kWidth, kHeight, 2);
+    EXPECT_NO_THROW(ShmFrameSource{name});
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    void* p =
+        ::mmap(nullptr, sizeof(shm::RingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(p, MAP_FAILED);
+    edits[k](*static_cast<shm::RingHeader*>(p));
+    ::munmap(p, sizeof(shm::RingHeader));
+    EXPECT_THROW(ShmFrameSource{name}, std::runtime_error) << "edit " << k;
+  }
+}
+
+TEST(V4l2FrameSource, ReportsDeviceErrorsAsSystemErrors) {
+  try {
+    V4l2FrameSource source({.device = "/dev/mq-no-such-camera"});
+    FAIL() << "opened a missing device";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code().value(), ENOENT);
+  }
+  // A node that is not a capture device fails its first ioctl.
+  EXPECT_THROW(V4l2FrameSource({.device = "/dev/null"}), std::system_error);
+}
+
+}  // namespace
+}  // namespace meat_quality
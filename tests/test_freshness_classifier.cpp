@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "meat_quality/inference/freshness_classifier.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+// Random weights with a non-trivial standardization, so "missing" and
+// "zero" are different inputs.
+ClassifierWeights standardized_weights() {
+  ClassifierWeights w = ClassifierWeights::random(16, 3);
+  for (std::size_t i = 0; i < kFeatureDim; ++i) {
+    w.input_mean[i] = 0.5f * static_cast<float>(i % 7) - 1.0f;
+    w.input_scale[i] = 0.5f + 0.1f * static_cast<float>(i % 5);
+  }
+  return w;
+}
+
+FeatureVector random_features(std::mt19937_64& rng) {
+  std::normal_distribution<float> normal(0.0f, 2.0f);
+  FeatureVector v;
+  for (float& x : v) x = normal(rng);
+  return v;
+}
+
+TEST(Softmax, PicksTheLargestLogit) {
+  const float logits[kFreshnessClassCount] = {0.5f, 2.0f, -1.0f};
+  Prediction p;
+  softmax(logits, p);
+  EXPECT_EQ(p.label, FreshnessClass::kSemiFresh);
+  EXPECT_NEAR(p.probabilities[0] + p.probabilities[1] + p.probabilities[2], 1.0f, 1e-6f);
+  EXPECT_EQ(p.confidence(), p.probabilities[1]);
+}
+
+TEST(Softmax, NonFiniteLogitsAreUnknownNotFresh) {
+  for (const float bad : {kNaN, kInf, -kInf}) {
+    for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+      float logits[kFreshnessClassCount] = {0.1f, 0.2f, 0.3f};
+      logits[k] = bad;
+      Prediction p;
+      softmax(logits, p);
+      EXPECT_EQ(p.label, FreshnessClass::kUnknown);
+      EXPECT_EQ(p.confidence(), 0.0f);
+      for (const float q : p.probabilities) EXPECT_EQ(q, 0.0f);
+    }
+  }
+  EXPECT_EQ(freshness_class_name(FreshnessClass::kUnknown), "unknown");
+}
+
+TEST(FreshnessClassifier, BatchMatchesSingleSamplePath) {
+  const FreshnessClassifier classifier(standardized_weights());
+  std::mt19937_64 rng(1);
+  // Seven rows: one four-row tile plus a three-row tail.
+  std::vector<FeatureVector> inputs(7);
+  for (FeatureVector& v : inputs) v = random_features(rng);
+  std::vector<Prediction> batch(inputs.size());
+  std::vector<float> scratch(classifier.scratch_size(inputs.size()));
+  classifier.predict(inputs.data(), inputs.size(), batch.data(), scratch);
+  for (std::size_t r = 0; r < inputs.size(); ++r) {
+    const Prediction single = classifier.predict(inputs[r]);
+    EXPECT_EQ(batch[r].label, single.label);
+    for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+      EXPECT_NEAR(batch[r].probabilities[k], single.probabilities[k], 1e-6f);
+    }
+  }
+}
+
+TEST(FreshnessClassifier, MissingChannelIsTakenAtItsTrainingMean) {
+  const ClassifierWeights weights = standardized_weights();
+  const FreshnessClassifier classifier(weights);
+  std::mt19937_64 rng(2);
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    FeatureVector dropped = random_features(rng);
+    FeatureVector at_mean = dropped;
+    for (std::size_t i = c * kFeaturesPerChannel; i < (c + 1) * kFeaturesPerChannel; ++i) {
+      dropped[i] = i % 2 == 0 ? kNaN : kInf;
+      at_mean[i] = weights.input_mean[i];
+    }
+    const Prediction got = classifier.predict(dropped);
+    const Prediction want = classifier.predict(at_mean);
+    ASSERT_NE(got.label, FreshnessClass::kUnknown);
+    EXPECT_EQ(got.label, want.label);
+    EXPECT_EQ(std::memcmp(got.probabilities.data(), want.probabilities.data(),
+                          sizeof got.probabilities),
+              0);
+  }
+}
+
+TEST(FreshnessClassifier, NonFiniteWeightsGiveUnknown) {
+  ClassifierWeights weights = standardized_weights();
+  weights.b2[0] = kInf;
+  const FreshnessClassifier classifier(std::move(weights));
+  std::mt19937_64 rng(3);
+  EXPECT_EQ(classifier.predict(random_features(rng)).label, FreshnessClass::kUnknown);
+}
+
+}  // namespace
+}  // namespace meat_quality
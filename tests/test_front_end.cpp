@@ -0,0 +1,335 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/features/sampling_rate.hpp"
+#include "meat_quality/net/front_end.hpp"
+#include "meat_quality/net/protocol.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality {
+namespace {
+
+int connect_to(std::uint16_t port) {
+  const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool write_all(int fd, const std::vector<std::uint8_t>& bytes) {
+  return ::write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size());
+}
+
+// Everything the server sends until it closes the connection.
+std::vector<std::uint8_t> read_to_end(int fd) {
+  std::vector<std::uint8_t> in;
+  std::uint8_t buf[4096];
+  for (ssize_t n; (n = ::read(fd, buf, sizeof buf)) > 0;) in.insert(in.end(), buf, buf + n);
+  return in;
+}
+
+// Polls `done` for up to five seconds.
+template <typename Fn>
+bool eventually(Fn&& done) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Exactly `count` frames; returns the bytes read so far on EOF.
+std::vector<std::uint8_t> read_frames(int fd, std::size_t count) {
+  std::vector<std::uint8_t> in;
+  std::size_t at = 0;
+  while (count > 0) {
+    if (in.size() - at >= wire::kFrameHeaderBytes) {
+      std::uint32_t length;
+      wire::FrameType type;
+      wire::parse_frame_header(in.data() + at, length, type);
+      if (in.size() - at >= 4 + std::size_t{length}) {
+        at += 4 + std::size_t{length};
+        --count;
+        continue;
+      }
+    }
+    std::uint8_t buf[4096];
+    const ssize_t n = ::read(fd, buf, sizeof buf);
+    if (n <= 0) break;
+    in.insert(in.end(), buf, buf + n);
+  }
+  return in;
+}
+
+// Rewrites the little-endian length field of the frame starting at `at`.
+void set_length(std::vector<std::uint8_t>& frame, std::uint32_t length, std::size_t at = 0) {
+  for (int k = 0; k < 4; ++k) frame[at + k] = static_cast<std::uint8_t>(length >> (8 * k));
+}
+
+std::vector<IngestRecord> records(NodeId node, std::uint64_t from, std::size_t n) {
+  bench::TraceGenerator gen(5);
+  std::vector<IngestRecord> out;
+  for (std::size_t i = 0; i < n; ++i) out.push_back({node, gen.sample(node, from + i)});
+  return out;
+}
+
+// A front end on a free loopback port whose pushes land in `queue`.
+class FrontEndTest : public ::testing::Test {
+ protected:
+  void start(FrontEndOptions options = {}) {
+    options.host = "127.0.0.1";
+    options.threads = 1;
+    net_.emplace(queue_, broker_, std::move(options));
+    net_->start();
+  }
+
+  FrontEnd& net() { return *net_; }
+
+  // The grading thread's side: moves pushed samples into `store`.
+  void drain_into(SampleStore& store) {
+    std::vector<IngestRecord> batch(1024);
+    for (std::size_t n; (n = queue_.pop_batch(batch.data(), batch.size())) > 0;) {
+      for (std::size_t i = 0; i < n; ++i) store.push(batch[i].node, batch[i].sample);
+    }
+  }
+
+  // Serves the broker until `count` grade requests have been answered.
+  bool serve_grades(const GradingPipeline& pipeline, std::size_t count) {
+    std::size_t served = 0;
+    return eventually([&] {
+      served += broker_.serve(pipeline, std::chrono::milliseconds(1));
+      return served >= count;
+    });
+  }
+
+  IngestQueue queue_{1024, Backpressure::kReject};
+  GradeBroker broker_;
+  std::optional<FrontEnd> net_;
+};
+
+std::vector<wire::GradeResponseFrame> parse_responses(const std::vector<std::uint8_t>& in) {
+  std::vector<wire::GradeResponseFrame> out;
+  for (std::size_t at = 0; at + wire::kFrameHeaderBytes <= in.size();) {
+    std::uint32_t length;
+    wire::FrameType type;
+    wire::parse_frame_header(in.data() + at, length, type);
+    if (type != wire::FrameType::kGradeResponse || at + 4 + length > in.size()) break;
+    wire::GradeResponseFrame response;
+    if (!wire::parse_grade_response({in.data() + at + wire::kFrameHeaderBytes, length - 1},
+                                    response)) {
+      break;
+    }
+    out.push_back(response);
+    at += 4 + length;
+  }
+  return out;
+}
+
+TEST_F(FrontEndTest, PushedSamplesAreGradedOverTheSameConnection) {
+  start();
+  SampleStore store(4, 1024);
+  const FreshnessClassifier classifier(ClassifierWeights::random(16, 8));
+  const LabConverter converter(LabMode::kExact);
+  const GradingPipeline pipeline(store, classifier, converter);
+  const int fd = connect_to(net().port());
+  ASSERT_GE(fd, 0);
+
+  // More than the initial read buffer in one frame.
+  std::vector<std::uint8_t> frame;
+  wire::append_sensor_push(frame, records(1, 0, 300));
+  ASSERT_GT(frame.size(), FrontEndOptions{}.read_buffer);
+  ASSERT_TRUE(write_all(fd, frame));
+  ASSERT_TRUE(eventually([&] { return net().stats().samples == 300; }));
+  drain_into(store);
+
+  frame.clear();
+  wire::append_grade_request(frame, {.id = 7, .node = 1, .at = 0});
+  wire::append_grade_request(frame, {.id = 8, .node = 9, .at = 0});  // not in the store
+  wire::append_grade_request(frame, {.id = 9, .node = 1, .at = store.newest(1) - 100 * 100'000});
+  ASSERT_TRUE(write_all(fd, frame));
+  ASSERT_TRUE(serve_grades(pipeline, 3));
+  const std::vector<wire::GradeResponseFrame> responses = parse_responses(read_frames(fd, 3));
+  ::close(fd);
+
+  ASSERT_EQ(responses.size(), 3u);
+  EXPECT_EQ(responses[0].id, 7u);
+  EXPECT_EQ(responses[1].id, 8u);
+  EXPECT_EQ(responses[2].id, 9u);
+  EXPECT_EQ(responses[1].status, wire::GradeStatus::kUnknownNode);
+  for (const std::size_t k : {0u, 2u}) {
+    const wire::GradeResponseFrame& r = responses[k];
+    ASSERT_EQ(r.status, wire::GradeStatus::kOk);
+    const GradeResult want = pipeline.grade({.node = 1, .at = r.result.at, .crops = {}});
+    EXPECT_EQ(r.result.samples, want.samples);
+    EXPECT_EQ(r.result.sensor.label, want.sensor.label);
+    for (std::size_t c = 0; c < kFreshnessClassCount; ++c) {
+      EXPECT_FLOAT_EQ(r.result.sensor.probabilities[c], want.sensor.probabilities[c]);
+    }
+  }
+  EXPECT_EQ(responses[0].result.at, store.newest(1));
+  EXPECT_EQ(responses[0].result.samples, 300u);
+  EXPECT_EQ(responses[2].result.samples, 200u);
+  EXPECT_EQ(net().stats().grades, 3u);
+}
+
+TEST_F(FrontEndTest, GradesAfterTheBrokerClosesAreRefused) {
+  start();
+  broker_.close();
+  const int fd = connect_to(net().port());
+  ASSERT_GE(fd, 0);
+  std::vector<std::uint8_t> frame;
+  wire::append_grade_request(frame, {.id = 3, .node = 0, .at = 0});
+  ASSERT_TRUE(write_all(fd, frame));
+  const std::vector<wire::GradeResponseFrame> responses = parse_responses(read_frames(fd, 1));
+  ::close(fd);
+  ASSERT_EQ(responses.size(), 1u);
+  EXPECT_EQ(responses[0].id, 3u);
+  EXPECT_EQ(responses[0].status, wire::GradeStatus::kShuttingDown);
+}
+
+// Each frame closes its connection without a reply and counts once.
+TEST_F(FrontEndTest, MalformedFramesCloseTheConnection) {
+  start({.max_frame = 4096});
+  std::vector<std::vector<std::uint8_t>> bad;
+  bad.push_back({0, 0, 0, 0, 1});  // zero length
+  {
+    std::vector<std::uint8_t> f;
+    wire::append_sensor_push(f, records(0, 0, 200));  // over max_frame
+    bad.push_back(f);
+  }
+  bad.push_back({1, 0, 0, 0, 99});  // unknown type
+  {
+    std::vector<std::uint8_t> f;
+    wire::append_sensor_push(f, records(0, 0, 2));
+    f.pop_back();  // a record short of its declared count
+    set_length(f, static_cast<std::uint32_t>(f.size() - 4));
+    bad.push_back(f);
+  }
+  {
+    std::vector<std::uint8_t> f;
+    wire::append_grade_request(f, {.id = 1, .node = 0, .at = 0});
+    f.push_back(0);
+    set_length(f, static_cast<std::uint32_t>(f.size() - 4));
+    bad.push_back(f);
+  }
+  {
+    std::vector<std::uint8_t> f;  // server-to-client frames are not requests
+    wire::append_rate_hint(f, {.node = 0, .interval_ms = 100});
+    bad.push_back(f);
+  }
+  for (std::size_t k = 0; k < bad.size(); ++k) {
+    const int fd = connect_to(net().port());
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(write_all(fd, bad[k]));
+    EXPECT_TRUE(read_to_end(fd).empty()) << "frame " << k;
+    ::close(fd);
+    ASSERT_TRUE(eventually([&] { return net().stats().protocol_errors == k + 1; }))
+        << "frame " << k;
+  }
+  ASSERT_TRUE(eventually([&] { return net().stats().open == 0; }));
+  EXPECT_EQ(net().stats().samples, 0u);
+  EXPECT_EQ(net().stats().accepted, bad.size());
+}
+
+TEST_F(FrontEndTest, RejectsUnusableOptions) {
+  IngestQueue blocking(16, Backpressure::kBlock);
+  EXPECT_THROW(FrontEnd(blocking, broker_, {.host = "127.0.0.1"}), std::invalid_argument);
+  EXPECT_THROW(FrontEnd(queue_, broker_, {.host = "127.0.0.1", .threads = 0}),
+               std::invalid_argument);
+  EXPECT_THROW(FrontEnd(queue_, broker_, {.host = "127.0.0.1", .read_buffer = 4}),
+               std::invalid_argument);
+  EXPECT_THROW(FrontEnd(queue_, broker_, {.host = "localhost"}), std::invalid_argument);
+  EXPECT_THROW(FrontEnd(queue_, broker_, {.host = "192.0.2.1"}), std::system_error);
+}
+
+TEST_F(FrontEndTest, PackedPushIsDecodedOnceAndClosedOnMalformedTail) {
+  start();
+  const int fd = connect_to(net().port());
+  ASSERT_GE(fd, 0);
+  std::vector<std::uint8_t> frame;
+  wire::append_packed_push(frame, records(1, 0, 5));
+  // Declares four records but carries three: they are ingested as they
+  // are decoded, then the missing one closes the connection.
+  const std::size_t good = frame.size();
+  wire::append_packed_push(frame, records(2, 0, 3));
+  ASSERT_EQ(frame[good + wire::kFrameHeaderBytes], 3);
+  frame[good + wire::kFrameHeaderBytes] = 4;
+  ASSERT_TRUE(write_all(fd, frame));
+  EXPECT_TRUE(read_to_end(fd).empty());
+  ::close(fd);
+
+  ASSERT_TRUE(eventually([&] { return net().stats().open == 0; }));
+  const FrontEndStats s = net().stats();
+  EXPECT_EQ(s.protocol_errors, 1u);
+  EXPECT_EQ(s.samples, 8u);
+  std::vector<IngestRecord> queued(16);
+  queued.resize(queue_.pop_batch(queued.data(), queued.size()));
+  ASSERT_EQ(queued.size(), 8u);
+  EXPECT_EQ(queued[4].node, 1u);
+  EXPECT_EQ(queued[5].node, 2u);
+}
+
+TEST_F(FrontEndTest, RateChangeIsHintedExactlyOnce) {
+  SamplingRateController rates(4, {.patience = 1, .min_samples = 1});
+  start({.rates = &rates});
+  const int fd = connect_to(net().port());
+  ASSERT_GE(fd, 0);
+  std::vector<std::uint8_t> frame;
+  const auto push = [&](std::uint64_t from, std::uint64_t expect_samples) {
+    frame.clear();
+    wire::append_packed_push(frame, records(1, from, 10));
+    ASSERT_TRUE(write_all(fd, frame));
+    ASSERT_TRUE(eventually([&] { return net().stats().samples == expect_samples; }));
+  };
+  push(0, 10);  // still at the full rate: nothing to hint
+
+  // A quiet window doubles node 1's interval.
+  WindowFeatures quiet;
+  quiet.samples = 100;
+  quiet.channels = kAllChannels;
+  ASSERT_EQ(rates.update(1, quiet), 200u);
+  push(10, 20);
+  push(20, 30);
+  ::shutdown(fd, SHUT_WR);
+  const std::vector<std::uint8_t> in = read_to_end(fd);
+  ::close(fd);
+
+  std::vector<wire::RateHintFrame> hints;
+  for (std::size_t at = 0; at + wire::kFrameHeaderBytes <= in.size();) {
+    std::uint32_t length;
+    wire::FrameType type;
+    wire::parse_frame_header(in.data() + at, length, type);
+    ASSERT_EQ(type, wire::FrameType::kRateHint);
+    ASSERT_LE(at + 4 + length, in.size());
+    wire::RateHintFrame hint;
+    ASSERT_TRUE(wire::parse_rate_hint({in.data() + at + wire::kFrameHeaderBytes, length - 1},
+                                      hint));
+    hints.push_back(hint);
+    at += 4 + length;
+  }
+  ASSERT_EQ(hints.size(), 1u);
+  EXPECT_EQ(hints[0].node, 1u);
+  EXPECT_EQ(hints[0].interval_ms, 200u);
+  EXPECT_EQ(net().stats().rate_hints, 1u);
+}
+
+}  // namespace
+}  // namespace meat_quality
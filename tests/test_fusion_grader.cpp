@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/grading/fusion_grader.hpp"
+#include "synthetic_image.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality {
+namespace {
+
+bool same_prediction(const Prediction& a, const Prediction& b) {
+  return a.label == b.label && std::memcmp(a.probabilities.data(), b.probabilities.data(),
+                                           sizeof a.probabilities) == 0;
+}
+
+// Random weights scaled down to the trace's raw feature values, so the
+// models are unsure often enough for the cascade to matter.
+ClassifierWeights hesitant_weights(std::size_t hidden, std::uint64_t seed) {
+  ClassifierWeights w = ClassifierWeights::random(hidden, seed);
+  std::fill(w.input_scale.begin(), w.input_scale.end(), 0.02f);
+  return w;
+}
+
+// Top-two difference, by sorting.
+float margin_of(const Prediction& p) {
+  std::array<float, kFreshnessClassCount> q = p.probabilities;
+  std::sort(q.begin(), q.end());
+  return q[kFreshnessClassCount - 1] - q[kFreshnessClassCount - 2];
+}
+
+TEST(ImageFreshnessModel, StandardizesAndScoresTheColorStatistics) {
+  const ImageModelWeights w = ImageModelWeights::random(3);
+  const ImageFreshnessModel model(w);
+  ColorSummary color;
+  color.mean_l = 41.0f, color.mean_a = 24.5f, color.mean_b = 9.0f;
+  color.a_p10 = 12.0f, color.a_p50 = 25.0f, color.a_p90 = 33.5f;
+  const ImageFeatureVector x = to_image_features(color);
+  EXPECT_EQ(x, (ImageFeatureVector{41.0f, 24.5f, 9.0f, 12.0f, 25.0f, 33.5f}));
+
+  std::array<double, kFreshnessClassCount> logits;
+  for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+    logits[k] = w.b[k];
+    for (std::size_t i = 0; i < kImageFeatureDim; ++i) {
+      logits[k] += double(x[i] - w.input_mean[i]) * w.input_scale[i] *
+                   w.w[i * kFreshnessClassCount + k];
+    }
+  }
+  double total = 0;
+  for (const double l : logits) total += std::exp(l);
+  const Prediction p = model.predict(color);
+  for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+    EXPECT_NEAR(p.probabilities[k], std::exp(logits[k]) / total, 1e-6) << k;
+  }
+  EXPECT_EQ(p.label, static_cast<FreshnessClass>(std::max_element(logits.begin(), logits.end()) -
+                                                 logits.begin()));
+
+  EXPECT_EQ(fusion_stage_name(FusionStage::kGas), "gas");
+  EXPECT_EQ(fusion_stage_name(FusionStage::kPh), "ph");
+  EXPECT_EQ(fusion_stage_name(FusionStage::kImage), "image");
+}
+
+class FusionGraderTest : public ::testing::Test {
+ protected:
+  static constexpr NodeId kNodes = 40;
+  static constexpr std::uint64_t kTicks = 600;
+
+  void SetUp() override {
+    bench::TraceGenerator(7).fill(store_, kTicks);
+    // 37 trays: some nodes twice, at the newest sample or earlier, two
+    // crops, one or none.
+    for (std::uint32_t i = 0; i < 37; ++i) {
+      const NodeId node = (i * 7) % kNodes;
+      const Timestamp at = i % 4 == 0 ? Timestamp(480 + i) * bench::kTickMicros : 0;
+      const std::span<const ImageView> crops(crops_, i % 3);
+      requests_.push_back({node, at, crops});
+    }
+    options_.grading.window = 30 * kMicrosPerSecond;
+  }
+
+  // Stage by stage, one tray at a time: each sensor model through its own
+  // single-request pipeline, fused in log space.
+  FusedGrade reference(const GradingRequest& req, FusionModels models,
+                       const FusionOptions& o) const {
+    FusedGrade g;
+    std::array<float, kFreshnessClassCount> pooled{};
+    const auto fuse = [&](FusionStage s, const Prediction& p) {
+      const auto k = static_cast<std::size_t>(s);
+      g.stages[k] = p;
+      g.stage_mask |= static_cast<std::uint8_t>(1u << k);
+      for (std::size_t c = 0; c < kFreshnessClassCount; ++c) {
+        pooled[c] += o.weight[k] * std::log(std::max(p.probabilities[c], 1e-6f));
+      }
+      softmax(pooled.data(), g.fused);
+      return margin_of(g.fused) >= o.exit_margin[k];
+    };
+    const auto sensor = [&](const FreshnessClassifier& model, ChannelMask channels) {
+      GradingOptions go = o.grading;
+      go.features.channels = channels;
+      return GradingPipeline(store_, model, converter_, go).grade({req.node, g.at, {}});
+    };
+
+    g.at = req.at;
+    const GradeResult gas = sensor(*models.gas, o.gas_channels);
+    g.node = gas.node;
+    g.at = gas.at;
+    g.samples = gas.samples;
+    if (fuse(FusionStage::kGas, gas.sensor)) return g;
+    if (models.ph != nullptr && fuse(FusionStage::kPh, sensor(*models.ph, o.ph_channels).sensor)) {
+      return g;
+    }
+    if (models.image != nullptr && !req.crops.empty()) {
+      g.color = summarize_color(req.crops, converter_, o.grading);
+      g.has_color = true;
+      fuse(FusionStage::kImage, models.image->predict(g.color));
+    }
+    return g;
+  }
+
+  // Checks `got` against the reference and the stats against the stages
+  // the reference ran.
+  void expect_matches(const std::vector<FusedGrade>& got, FusionModels models,
+                      const FusionOptions& o, const FusionStats& stats) const {
+    ASSERT_EQ(got.size(), requests_.size());
+    FusionStats want;
+    want.requests = requests_.size();
+    for (std::size_t i = 0; i < got.size(); ++i) {
+      SCOPED_TRACE(testing::Message() << "tray " << i);
+      const FusedGrade r = reference(requests_[i], models, o);
+      EXPECT_EQ(got[i].node, r.node);
+      EXPECT_EQ(got[i].at, r.at);
+      EXPECT_EQ(got[i].samples, r.samples);
+      EXPECT_EQ(got[i].stage_mask, r.stage_mask);
+      EXPECT_TRUE(same_prediction(got[i].fused, r.fused));
+      std::size_t last = 0;
+      for (std::size_t k = 0; k < kFusionStageCount; ++k) {
+        if (!r.ran(static_cast<FusionStage>(k))) continue;
+        EXPECT_TRUE(same_prediction(got[i].stages[k], r.stages[k])) << "stage " << k;
+        ++want.runs[k];
+        last = k;
+      }
+      ++want.exits[last];
+      EXPECT_EQ(got[i].has_color, r.has_color);
+      EXPECT_EQ(got[i].color.pixels, r.color.pixels);
+      EXPECT_EQ(got[i].color.mean_a, r.color.mean_a);
+      EXPECT_EQ(got[i].color.a_p90, r.color.a_p90);
+    }
+    EXPECT_EQ(stats.requests, want.requests);
+    EXPECT_EQ(stats.runs, want.runs);
+    EXPECT_EQ(stats.exits, want.exits);
+  }
+
+  std::vector<FusedGrade> grade_batch(FusionGrader& grader) const {
+    std::vector<FusedGrade> out(requests_.size());
+    grader.grade_batch(requests_, out);
+    return out;
+  }
+
+  SampleStore store_{kNodes, 256};
+  const bench::SyntheticImage img_ = bench::make_carcass_image(96, 64, 4, 0.6);
+  const ImageView crops_[2] = {img_.view().crop(0, 0, 48, 40), img_.view().crop(40, 20, 56, 44)};
+  std::vector<GradingRequest> requests_;
+  const FreshnessClassifier gas_{hesitant_weights(16, 3)};
+  const FreshnessClassifier ph_{hesitant_weights(8, 4)};
+  const ImageFreshnessModel image_{ImageModelWeights::random(5)};
+  const LabConverter converter_{LabMode::kExact};
+  FusionOptions options_;
+};
+
+TEST_F(FusionGraderTest, CascadeMatchesTheStagesRunOneByOne) {
+  const FusionModels models{&gas_, &ph_, &image_};
+  // Margins that let each stage decide some trays: a fifth of them exit
+  // after the gas model, half of the rest after pH.
+  FusionOptions o = options_;
+  o.exit_margin = {2.0f, 2.0f, 0.0f};
+  o.weight = {1.0f, 0.7f, 1.5f};
+  std::vector<float> margins;
+  for (const GradingRequest& r : requests_) {
+    margins.push_back(margin_of(reference(r, {&gas_, nullptr, nullptr}, o).fused));
+  }
+  std::sort(margins.begin(), margins.end());
+  o.exit_margin[0] = margins[margins.size() * 4 / 5];
+  margins.clear();
+  for (const GradingRequest& r : requests_) {
+    const FusedGrade g = reference(r, {&gas_, &ph_, nullptr}, o);
+    if (g.ran(FusionStage::kPh)) margins.push_back(margin_of(g.fused));
+  }
+  std::sort(margins.begin(), margins.end());
+  o.exit_margin[1] = margins[margins.size() / 2];
+
+  FusionGrader grader(store_, models, converter_, o);
+  const std::vector<FusedGrade> got = grade_batch(grader);
+  expect_matches(got, models, o, grader.stats());
+  for (std::size_t k = 0; k < kFusionStageCount; ++k) {
+    EXPECT_GT(grader.stats().exits[k], 0u) << "stage " << k;
+  }
+
+  // One tray at a time gives the same grades.
+  grader.reset_stats();
+  std::vector<FusedGrade> single;
+  for (const GradingRequest& r : requests_) single.push_back(grader.grade(r));
+  expect_matches(single, models, o, grader.stats());
+}
+
+TEST_F(FusionGraderTest, MarginsAndMissingStagesBoundTheCascade) {
+  FusionOptions o = options_;
+  o.exit_margin = {0.0f, 0.0f, 0.0f};  // the gas model decides everything
+  {
+    FusionGrader grader(store_, {&gas_, &ph_, &image_}, converter_, o);
+    const std::vector<FusedGrade> got = grade_batch(grader);
+    expect_matches(got, {&gas_, &ph_, &image_}, o, grader.stats());
+    EXPECT_EQ(grader.stats().exits[0], requests_.size());
+  }
+
+  o.exit_margin = {2.0f, 2.0f, 0.0f};  // every stage runs where it can
+  std::vector<FusedGrade> all;
+  {
+    FusionGrader grader(store_, {&gas_, &ph_, &image_}, converter_, o);
+    all = grade_batch(grader);
+    expect_matches(all, {&gas_, &ph_, &image_}, o, grader.stats());
+    EXPECT_EQ(grader.stats().runs[1], requests_.size());
+    EXPECT_EQ(grader.stats().exits[1], requests_.size() / 3 + 1);  // trays without crops
+  }
+  {
+    // No pH model: undecided trays go straight to the image model.
+    FusionGrader grader(store_, {&gas_, nullptr, &image_}, converter_, o);
+    expect_matches(grade_batch(grader), {&gas_, nullptr, &image_}, o, grader.stats());
+    EXPECT_EQ(grader.stats().runs[1], 0u);
+  }
+  {
+    // A zero weight runs the image model without moving the fused grade.
+    o.weight[2] = 0.0f;
+    FusionGrader grader(store_, {&gas_, &ph_, &image_}, converter_, o);
+    FusionGrader sensors(store_, {&gas_, &ph_, nullptr}, converter_, o);
+    const std::vector<FusedGrade> got = grade_batch(grader), want = grade_batch(sensors);
+    for (std::size_t i = 0; i < got.size(); ++i) {
+      EXPECT_EQ(got[i].has_color, !requests_[i].crops.empty());
+      EXPECT_TRUE(same_prediction(got[i].fused, want[i].fused)) << i;
+      EXPECT_TRUE(same_prediction(got[i].stages[2], all[i].stages[2])) << i;
+    }
+  }
+}
+
+TEST_F(FusionGraderTest, RejectsAMissingGasModelAndMismatchedSpans) {
+  EXPECT_THROW(FusionGrader(store_, {nullptr, &ph_, &image_}, converter_), std::invalid_argument);
+  FusionGrader grader(store_, {&gas_, &ph_, &image_}, converter_, options_);
+  std::vector<FusedGrade> out(requests_.size() - 1);
+  EXPECT_THROW(grader.grade_batch(requests_, out), std::invalid_argument);
+  grader.grade_batch({}, {});
+  EXPECT_EQ(grader.stats().requests, 0u);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "meat_quality/grading/grade_cache.hpp"
+
+namespace meat_quality {
+namespace {
+
+Prediction prediction_of(FreshnessClass label) {
+  Prediction p;
+  p.label = label;
+  p.probabilities[static_cast<std::size_t>(label)] = 1.0f;
+  return p;
+}
+
+GradeCacheKey key_of(NodeId node, std::uint64_t features, std::int64_t bucket = 5) {
+  return {node, bucket, features};
+}
+
+TEST(GradeCache, RejectsInvalidOptions) {
+  EXPECT_THROW(GradeCache({.max_bytes = 64}), std::invalid_argument);
+  EXPECT_THROW(GradeCache({.bucket = 0}), std::invalid_argument);
+  EXPECT_THROW(GradeCache({.mantissa_bits = 0}), std::invalid_argument);
+  EXPECT_THROW(GradeCache({.mantissa_bits = 24}), std::invalid_argument);
+}
+
+TEST(GradeCache, MemoServesOnlyTheSameGenerationAndBucket) {
+  GradeCache cache;
+  cache.insert(key_of(3, 42), 100, prediction_of(FreshnessClass::kSemiFresh), 77);
+
+  Prediction p;
+  std::uint32_t samples = 0;
+  ASSERT_TRUE(cache.find_current(3, 5, 100, p, samples));
+  EXPECT_EQ(p.label, FreshnessClass::kSemiFresh);
+  EXPECT_EQ(samples, 77u);
+  EXPECT_FALSE(cache.find_current(3, 5, 101, p, samples));  // a sample landed
+  EXPECT_FALSE(cache.find_current(3, 6, 100, p, samples));  // window moved on
+  EXPECT_FALSE(cache.find_current(4, 5, 100, p, samples));
+
+  // Same quantized features at the new generation: the entry is reused and
+  // the memo follows the new generation.
+  ASSERT_TRUE(cache.find(key_of(3, 42), 101, p));
+  EXPECT_EQ(p.label, FreshnessClass::kSemiFresh);
+  EXPECT_TRUE(cache.find_current(3, 5, 101, p, samples));
+  EXPECT_FALSE(cache.find_current(3, 5, 100, p, samples));
+  EXPECT_FALSE(cache.find(key_of(3, 43), 101, p));
+
+  const GradeCacheStats s = cache.stats();
+  EXPECT_EQ(s.memo_hits, 2u);
+  EXPECT_EQ(s.feature_hits, 1u);
+  EXPECT_EQ(s.misses, 1u);
+  EXPECT_EQ(s.entries, 1u);
+}
+
+TEST(GradeCache, InvalidateAndClearDropCachedResults) {
+  GradeCache cache;
+  cache.insert(key_of(1, 7), 10, prediction_of(FreshnessClass::kSpoiled), 5);
+  cache.insert(key_of(2, 7), 10, prediction_of(FreshnessClass::kFresh), 5);
+  Prediction p;
+  std::uint32_t samples = 0;
+  cache.invalidate(1);
+  EXPECT_FALSE(cache.find_current(1, 5, 10, p, samples));
+  EXPECT_TRUE(cache.find_current(2, 5, 10, p, samples));
+  EXPECT_TRUE(cache.find(key_of(1, 7), 10, p));  // the entry itself survives
+
+  cache.clear();
+  EXPECT_FALSE(cache.find_current(2, 5, 10, p, samples));
+  EXPECT_FALSE(cache.find(key_of(2, 7), 10, p));
+  EXPECT_EQ(cache.stats().entries, 0u);
+}
+
+TEST(GradeCache, NodesBeyondTheMemoAreStillCached) {
+  GradeCache cache({.max_bytes = 16 << 10});
+  const NodeId far = 1'000'000;
+  cache.insert(key_of(far, 9), 1, prediction_of(FreshnessClass::kSpoiled), 3);
+  Prediction p;
+  std::uint32_t samples = 0;
+  EXPECT_FALSE(cache.find_current(far, 5, 1, p, samples));
+  ASSERT_TRUE(cache.find(key_of(far, 9), 1, p));
+  EXPECT_EQ(p.label, FreshnessClass::kSpoiled);
+}
+
+TEST(GradeCache, ClockEvictsUnreferencedEntriesFirst) {
+  GradeCache cache({.max_bytes = 16 << 10});
+  constexpr std::uint64_t kInserted = 1000;
+  for (std::uint64_t i = 0; i < kInserted; ++i) {
+    cache.insert(key_of(0, i), i, prediction_of(FreshnessClass::kFresh), 1);
+  }
+  const GradeCacheStats s = cache.stats();
+  ASSERT_GE(s.entries, 16u);
+  EXPECT_EQ(s.entries + s.evictions, kInserted);
+  EXPECT_LE(s.bytes, std::size_t{16} << 10);
+
+  // Without references CLOCK is FIFO: exactly the newest entries are held.
+  Prediction p;
+  const std::uint64_t oldest = kInserted - s.entries;
+  EXPECT_FALSE(cache.find(key_of(0, oldest - 1), 0, p));
+  for (std::uint64_t i = oldest; i < kInserted; ++i) {
+    ASSERT_TRUE(cache.find(key_of(0, i), 0, p)) << i;
+  }
+  // Every entry is now referenced; one more insert clears the bits in a
+  // full sweep and evicts the oldest. Re-referencing the next oldest makes
+  // the following insert pass over it.
+  cache.insert(key_of(0, kInserted), 0, prediction_of(FreshnessClass::kFresh), 1);
+  EXPECT_FALSE(cache.find(key_of(0, oldest), 0, p));
+  ASSERT_TRUE(cache.find(key_of(0, oldest + 1), 0, p));
+  cache.insert(key_of(0, kInserted + 1), 0, prediction_of(FreshnessClass::kFresh), 1);
+  EXPECT_TRUE(cache.find(key_of(0, oldest + 1), 0, p));
+  EXPECT_FALSE(cache.find(key_of(0, oldest + 2), 0, p));
+}
+
+TEST(GradeCache, QuantizedFeatureHash) {
+  const GradeCache cache({.mantissa_bits = 12});
+  FeatureVector a{};
+  for (std::size_t i = 0; i < a.size(); ++i) a[i] = 1.0f + 0.37f * static_cast<float>(i);
+  FeatureVector b = a;
+  b[3] *= 1.0f + 1e-6f;  // far below 2^-12
+  FeatureVector c = a;
+  c[3] *= 1.01f;
+  EXPECT_EQ(cache.hash_features(a), cache.hash_features(b));
+  EXPECT_NE(cache.hash_features(a), cache.hash_features(c));
+
+  FeatureVector zero{}, negative_zero{};
+  negative_zero[0] = -0.0f;
+  EXPECT_EQ(cache.hash_features(zero), cache.hash_features(negative_zero));
+}
+
+}  // namespace
+}  // namespace meat_quality
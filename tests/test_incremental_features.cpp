@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include "meat_quality/features/incremental_features.hpp"
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr Timestamp kWindow = 60 * 1'000'000;  // 600 samples at 10 Hz
+constexpr std::size_t kCapacity = 1024;
+constexpr FeatureOptions kOptions{.ewma_alpha = 0.05f, .channels = kAllChannels};
+
+// Everything but the EWMA is recomputed from the same window, so it agrees
+// to float rounding; the EWMA also carries (1 - alpha)^600 of older history.
+void expect_drift_below(const FeatureDrift& d, double tolerance) {
+  ASSERT_GT(d.checks, 0u);
+  for (std::size_t k = 0; k < FeatureDrift::kFields; ++k) {
+    EXPECT_LT(d.max_rel_error[k], tolerance) << "field " << k;
+  }
+}
+
+TEST(IncrementalFeatures, MatchesFullRescan) {
+  SampleStore store(2, kCapacity);
+  IncrementalFeatureTracker tracker(store, kWindow, kOptions, FeatureMode::kValidate);
+  bench::TraceGenerator gen(11);
+  for (std::uint64_t t = 0; t < 3000; ++t) {
+    for (NodeId n = 0; n < 2; ++n) store.push(n, gen.sample(n, t));
+    // Node 1 is updated in bursts, so several samples enter and leave at once.
+    tracker.update(0);
+    if (t % 37 == 0) tracker.update(1);
+  }
+  expect_drift_below(tracker.drift(), 1e-3);
+  EXPECT_EQ(tracker.rebuilds(), 2u);
+}
+
+TEST(IncrementalFeatures, NaNReadingLeavesNoTraceOnceOutOfTheWindow) {
+  SampleStore store(1, kCapacity);
+  IncrementalFeatureTracker tracker(store, kWindow, kOptions, FeatureMode::kValidate);
+  bench::TraceGenerator gen(12);
+  for (std::uint64_t t = 0; t < 3000; ++t) {
+    SensorSample s = gen.sample(0, t);
+    if (t == 100) s[Channel::kNh3] = std::nanf("");
+    if (t == 110) s[Channel::kPh] = INFINITY;
+    store.push(0, s);
+    const WindowFeatures f = tracker.update(0);
+    // Inside the window the reading is skipped rather than poisoning the sums.
+    EXPECT_TRUE(std::isfinite(f[Channel::kNh3].mean)) << "tick " << t;
+    EXPECT_TRUE(std::isfinite(f[Channel::kNh3].ewma)) << "tick " << t;
+    EXPECT_TRUE(std::isfinite(f[Channel::kPh].variance)) << "tick " << t;
+    if (t == 711) tracker.clear_drift();  // both readings have left the window
+  }
+  expect_drift_below(tracker.drift(), 1e-3);
+  EXPECT_EQ(tracker.rebuilds(), 1u);
+}
+
+// Dropouts that stay in the window: the rescan skips them as the tracker
+// does, down to a channel that never reports.
+SensorSample with_dropouts(bench::TraceGenerator& gen, std::uint64_t t) {
+  SensorSample s = gen.sample(0, t);
+  if (t % 50 == 7) s[Channel::kNh3] = std::nanf("");
+  if (t % 333 == 0) s[Channel::kPh] = -INFINITY;
+  if (t % 1000 < 40) s[Channel::kTemperature] = std::nanf("");
+  s[Channel::kH2s] = std::nanf("");
+  return s;
+}
+
+TEST(IncrementalFeatures, AgreesWithRescanOnWindowsHoldingNaN) {
+  SampleStore store(1, kCapacity);
+  IncrementalFeatureTracker tracker(store, kWindow, kOptions, FeatureMode::kValidate);
+  bench::TraceGenerator gen(14);
+  for (std::uint64_t t = 0; t < 3000; ++t) {
+    store.push(0, with_dropouts(gen, t));
+    tracker.update(0);
+  }
+  // No clear_drift(): every window held non-finite readings.
+  expect_drift_below(tracker.drift(), 1e-3);
+}
+
+TEST(IncrementalFeatures, GradingThroughTheTrackerMatchesARescan) {
+  SampleStore store(1, kCapacity);
+  IncrementalFeatureTracker tracker(store, kWindow, kOptions);
+  const FreshnessClassifier classifier(ClassifierWeights::random(16, 4));
+  const LabConverter converter(LabMode::kExact);
+  GradingPipeline pipeline(store, classifier, converter,
+                           {.window = kWindow, .features = kOptions});
+  pipeline.set_feature_tracker(&tracker);
+  bench::TraceGenerator gen(15);
+  for (std::uint64_t t = 0; t < 2000; ++t) {
+    store.push(0, with_dropouts(gen, t));
+    if (t % 97 != 0) continue;
+    // `at == 0` reads the tracker; the same instant given explicitly rescans.
+    const GradeResult live = pipeline.grade({.node = 0, .at = 0, .crops = {}});
+    const GradeResult past = pipeline.grade({.node = 0, .at = store.newest(0), .crops = {}});
+    EXPECT_EQ(live.samples, past.samples) << "tick " << t;
+    ASSERT_NE(live.sensor.label, FreshnessClass::kUnknown) << "tick " << t;
+    EXPECT_EQ(live.sensor.label, past.sensor.label) << "tick " << t;
+    for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+      EXPECT_NEAR(live.sensor.probabilities[k], past.sensor.probabilities[k], 1e-3f)
+          << "tick " << t;
+    }
+  }
+}
+
+TEST(IncrementalFeatures, ChannelWithoutFiniteReadingsHasNaNMean) {
+  SampleStore store(1, kCapacity);
+  IncrementalFeatureTracker tracker(store, kWindow, kOptions);
+  bench::TraceGenerator gen(13);
+  for (std::uint64_t t = 0; t < 50; ++t) {
+    SensorSample s = gen.sample(0, t);
+    s[Channel::kH2s] = std::nanf("");
+    store.push(0, s);
+  }
+  const WindowFeatures f = tracker.update(0);
+  EXPECT_EQ(f.samples, 50u);
+  EXPECT_TRUE(std::isnan(f[Channel::kH2s].mean));
+  EXPECT_TRUE(std::isnan(f[Channel::kH2s].min));
+  EXPECT_EQ(f[Channel::kH2s].variance, 0.0f);
+  EXPECT_TRUE(std::isfinite(f[Channel::kNh3].mean));
+
+  // A rescan reports the channel the same way.
+  const WindowFeatures full = extract_features(store.window(0, 0), kOptions);
+  EXPECT_TRUE(std::isnan(full[Channel::kH2s].mean));
+  EXPECT_TRUE(std::isnan(full[Channel::kH2s].min));
+  EXPECT_EQ(full[Channel::kH2s].variance, 0.0f);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#if defined(MEAT_QUALITY_LOAD_GENERATOR_PATH)
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "synthetic_image.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Runs mq_load_generator as a child process, like an operator would.
+class LoadGeneratorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    write_ppm("tray.ppm", 40, 24);
+    write_ppm("small.ppm", 20, 24);
+  }
+
+  void write_ppm(const std::string& name, std::uint32_t width, std::uint32_t height) const {
+    const bench::SyntheticImage img = bench::make_carcass_image(width, height, 4);
+    std::string ppm = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    ppm.append(img.pixels.begin(), img.pixels.end());
+    test::write_file(dir_.file(name), {ppm.begin(), ppm.end()});
+  }
+
+  // Exit status; stdout and stderr end up in `output_`.
+  int run(const std::string& args) {
+    const std::string command = std::string(MEAT_QUALITY_LOAD_GENERATOR_PATH) + " " + args +
+                                " >" + dir_.file("out.txt") + " 2>&1";
+    const int status = std::system(command.c_str());
+    const std::vector<std::uint8_t> bytes = test::read_file(dir_.file("out.txt"));
+    output_.assign(bytes.begin(), bytes.end());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  // Rows of the CSV report at `name`, header first, split at commas.
+  std::vector<std::vector<std::string>> read_csv(const std::string& name) const {
+    const std::vector<std::uint8_t> bytes = test::read_file(dir_.file(name));
+    std::istringstream in(std::string(bytes.begin(), bytes.end()));
+    std::vector<std::vector<std::string>> rows;
+    for (std::string line; std::getline(in, line);) {
+      std::istringstream fields(line);
+      rows.emplace_back();
+      for (std::string f; std::getline(fields, f, ',');) rows.back().push_back(f);
+    }
+    return rows;
+  }
+
+  // Shared-memory ring names unique to this process.
+  std::string ring_prefix() const { return "/mq_test_cam_" + std::to_string(::getpid()) + "_"; }
+
+  test::TempDir dir_;
+  std::string output_;
+};
+
+TEST_F(LoadGeneratorTest, EmbeddedRunReportsEveryInterval) {
+  ASSERT_EQ(run("--embedded --nodes 64 --nodes-per-room 8 --connections 2 --rate-hz 5 "
+                "--grade-qps 40 --duration-s 1.5 --report-s 0.5 --jitter-ms 5 --seed 3 "
+                "--door-opens-per-hour 3600 --door-open-s 0.2 --cameras 1 --camera-fps 10 "
+                "--ring-prefix " + ring_prefix() + " --out " + dir_.file("report.csv") + " " +
+                dir_.file("tray.ppm")),
+            0)
+      << output_;
+  const auto rows = read_csv("report.csv");
+  ASSERT_EQ(rows.size(), 4u) << output_;  // header and three intervals
+  const std::vector<std::string>& header = rows[0];
+  ASSERT_EQ(header.size(), 19u);
+  const auto column = [&](const std::string& name) {
+    for (std::size_t c = 0; c < header.size(); ++c) {
+      if (header[c] == name) return c;
+    }
+    ADD_FAILURE() << "no column " << name;
+    return std::size_t{0};
+  };
+  double samples = 0, grades = 0, frames = 0;
+  for (std::size_t r = 1; r < rows.size(); ++r) {
+    ASSERT_EQ(rows[r].size(), header.size()) << "row " << r;
+    EXPECT_NEAR(std::stod(rows[r][column("elapsed_s")]), 0.5 * double(r), 0.15);
+    EXPECT_EQ(rows[r][column("errors")], "0") << "row " << r;
+    EXPECT_GT(std::stod(rows[r][column("rss_mb")]), 0.0);
+    samples += std::stod(rows[r][column("samples_per_s")]);
+    grades += std::stod(rows[r][column("grades_per_s")]);
+    frames += std::stod(rows[r][column("frames_per_s")]);
+  }
+  EXPECT_GT(samples, 0.0);
+  EXPECT_GT(grades, 0.0);
+  EXPECT_GT(frames, 0.0);
+  EXPECT_NE(output_.find("64 nodes at 5.00 Hz over 2 connections"), std::string::npos) << output_;
+  EXPECT_NE(output_.find("(including the generator)"), std::string::npos) << output_;
+
+  // Packed batches, report to stdout.
+  ASSERT_EQ(run("--embedded --packed --nodes 16 --duration-s 0.5 --report-s 0.5"), 0) << output_;
+  EXPECT_EQ(output_.rfind("elapsed_s,samples_per_s,", 0), 0u) << output_;
+}
+
+TEST_F(LoadGeneratorTest, UsageErrorsExitWithTwo) {
+  const std::string frame = dir_.file("tray.ppm");
+  const std::vector<std::string> bad = {
+      "",
+      "--embedded --connect localhost:7000",
+      "--connect localhost",
+      "--connect :x",
+      "--embedded --nodes 0",
+      "--embedded --nodes",
+      "--embedded --nodes many",
+      "--embedded --connections 0",
+      "--embedded --nodes-per-room 0",
+      "--embedded --rate-hz 0",
+      "--embedded --duration-s -1",
+      "--embedded --report-s 0",
+      "--embedded --burst-factor 0.5",
+      "--embedded --jitter-ms -1",
+      "--embedded --grade-qps -2",
+      "--embedded --door-opens-per-hour -1",
+      "--embedded --cameras 1",
+      "--embedded --cameras 1 --camera-fps 0 " + frame,
+      "--embedded --frobnicate",
+  };
+  for (const std::string& args : bad) {
+    SCOPED_TRACE(args);
+    EXPECT_EQ(run(args), 2) << output_;
+    EXPECT_NE(output_.find("usage:"), std::string::npos) << output_;
+  }
+}
+
+TEST_F(LoadGeneratorTest, RuntimeErrorsExitWithOne) {
+  // A port nobody listens on: bound, then released.
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof addr;
+  ASSERT_EQ(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr), 0);
+  ASSERT_EQ(::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  const int port = ntohs(addr.sin_port);
+  ::close(fd);
+
+  const std::string cameras =
+      "--embedded --duration-s 0.5 --cameras 1 --camera-fps 5 --ring-prefix " + ring_prefix();
+  const std::vector<std::string> failing = {
+      "--connect 127.0.0.1:" + std::to_string(port) + " --duration-s 0.5",
+      "--connect no-such-host.invalid:7000 --duration-s 0.5",
+      cameras + " " + dir_.file("missing.ppm"),
+      cameras + " " + dir_.file("tray.ppm") + " " + dir_.file("small.ppm"),  // sizes differ
+      "--embedded --duration-s 0.5 --out " + dir_.file("missing/report.csv"),
+  };
+  for (const std::string& args : failing) {
+    SCOPED_TRACE(args);
+    EXPECT_EQ(run(args), 1) << output_;
+    EXPECT_NE(output_.find("error: "), std::string::npos) << output_;
+  }
+}
+
+}  // namespace
+}  // namespace meat_quality
+
+#endif  // MEAT_QUALITY_LOAD_GENERATOR_PATH
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/image/image_accel.h"
+#include "meat_quality/image/marbling.hpp"
+#include "synthetic_image.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Pixel classes of a whole image, thresholded the way the segmenter does,
+// with the tiles outside `roi` (if given) cleared to background.
+std::vector<std::uint8_t> classify(const LabConverter& conv, const ImageView& rgb,
+                                   const MarblingOptions& opt, const RoiMap* roi = nullptr) {
+  LabImage lab(rgb.width, rgb.height);
+  conv.convert(rgb, lab.planes());
+  const LabPlanes& p = lab.planes();
+  std::vector<std::uint8_t> classes(std::size_t{rgb.width} * rgb.height, MQ_PIXEL_BACKGROUND);
+  for (std::uint32_t y = 0; y < rgb.height; ++y) {
+    for (std::uint32_t x = 0; x < rgb.width; ++x) {
+      if (roi != nullptr && !roi->contains(x / opt.tile, y / opt.tile)) continue;
+      const float l = p.l[y * p.stride + x], a = p.a[y * p.stride + x];
+      std::uint8_t& c = classes[std::size_t{y} * rgb.width + x];
+      if (l >= opt.fat_min_l && a <= opt.fat_max_a) c = MQ_PIXEL_FAT;
+      else if (a >= opt.lean_min_a) c = MQ_PIXEL_LEAN;
+    }
+  }
+  return classes;
+}
+
+void expect_same_scores(const MarblingResult& got, const MarblingResult& want) {
+  EXPECT_EQ(got.fat_pixels, want.fat_pixels);
+  EXPECT_EQ(got.lean_pixels, want.lean_pixels);
+  EXPECT_EQ(got.fleck_count, want.fleck_count);
+  EXPECT_EQ(got.largest_fleck, want.largest_fleck);
+}
+
+class MarblingTest : public ::testing::Test {
+ protected:
+  const LabConverter conv_{LabMode::kExact};
+};
+
+// Tile sizes that do not divide the image leave partial tiles on the right
+// and bottom; flecks cut by every kind of tile edge must still be joined.
+TEST_F(MarblingTest, TiledSegmentationMatchesOnePassLabelling) {
+  const bench::SyntheticImage img = bench::make_carcass_image(203, 131, 7, 0.8);
+  for (const std::size_t threads : {1u, 3u}) {
+    WorkStealingPool pool(threads);
+    for (const std::uint32_t tile : {1u, 5u, 16u, 64u, 256u}) {
+      SCOPED_TRACE(testing::Message() << threads << " threads, tile " << tile);
+      const MarblingSegmenter seg(pool, conv_, {.tile = tile});
+      const std::vector<std::uint8_t> classes = classify(conv_, img.view(), seg.options());
+      const MarblingResult want =
+          label_marbling(classes.data(), img.width, img.height, seg.options());
+      ASSERT_GT(want.fleck_count, 3u);
+      const MarblingResult got = seg.segment(img.view());
+      expect_same_scores(got, want);
+      EXPECT_EQ(got.tiles, ((203 + tile - 1) / tile) * ((131 + tile - 1) / tile));
+      EXPECT_EQ(got.skipped_tiles, 0u);
+    }
+  }
+}
+
+TEST_F(MarblingTest, JoinsFlecksAcrossTileEdgesButNotDiagonally) {
+  // 8x8 lean with tile 4: a plus around (3, 3) crosses both tile edges,
+  // and a diagonal pair in one corner stays two components.
+  std::vector<std::uint8_t> px(8 * 8 * 3);
+  for (std::size_t i = 0; i < px.size(); i += 3) px[i] = 165, px[i + 1] = 38, px[i + 2] = 42;
+  const auto fat = [&](std::uint32_t x, std::uint32_t y) {
+    std::uint8_t* p = px.data() + (y * 8 + x) * 3;
+    p[0] = 236, p[1] = 224, p[2] = 212;
+  };
+  for (std::uint32_t k = 2; k < 6; ++k) fat(k, 3), fat(3, k);
+  fat(0, 7), fat(1, 6);
+  WorkStealingPool pool(2);
+  const MarblingSegmenter seg(pool, conv_, {.tile = 4, .min_fleck_pixels = 1});
+  const MarblingResult r = seg.segment({px.data(), 8, 8, 8 * 3, PixelFormat::kRgb8});
+  EXPECT_EQ(r.fat_pixels, 9u);
+  EXPECT_EQ(r.lean_pixels, 55u);
+  EXPECT_EQ(r.fleck_count, 3u);
+  EXPECT_EQ(r.largest_fleck, 7u);
+  EXPECT_EQ(r.tiles, 4u);
+}
+
+TEST_F(MarblingTest, RegionOfInterestSegmentsOnlyItsTiles) {
+  const bench::SyntheticImage img = bench::make_carcass_image(150, 90, 8, 0.9);
+  WorkStealingPool pool(2);
+  const MarblingSegmenter seg(pool, conv_, {.tile = 32});
+  RoiMap roi(img.width, img.height, 32);
+  roi.insert(1, 0), roi.insert(2, 0), roi.insert(1, 1), roi.insert(3, 2), roi.insert(4, 2);
+  const std::vector<std::uint8_t> classes = classify(conv_, img.view(), seg.options(), &roi);
+  const MarblingResult got = seg.segment(img.view(), roi);
+  expect_same_scores(got, label_marbling(classes.data(), img.width, img.height, seg.options()));
+  EXPECT_EQ(got.tiles, 5u);
+  EXPECT_EQ(got.skipped_tiles, 5u * 3u - 5u);
+
+  const MarblingResult none = seg.segment(img.view(), RoiMap(img.width, img.height, 32));
+  EXPECT_EQ(none.tiles, 0u);
+  EXPECT_EQ(none.fat_pixels + none.lean_pixels, 0u);
+}
+
+TEST_F(MarblingTest, IncrementalJobMatchesWholeImage) {
+  const bench::SyntheticImage img = bench::make_carcass_image(120, 100, 9, 0.8);
+  WorkStealingPool pool(2);
+  const MarblingSegmenter seg(pool, conv_, {.tile = 24});
+  const MarblingResult want = seg.segment(img.view());
+  const auto job = seg.begin(img.view());
+  for (std::uint32_t rows = 0; rows <= img.height; rows += 17) job->add_rows(rows);
+  job->add_tile(0, job->tiles_y() - 1);
+  job->add_tile(job->tiles_x(), 0);  // outside the image: ignored
+  const MarblingResult got = job->finish();
+  expect_same_scores(got, want);
+  EXPECT_EQ(got.tiles, want.tiles);
+}
+
+TEST_F(MarblingTest, RejectsBadOptionsAndInputs) {
+  WorkStealingPool pool(1);
+  EXPECT_THROW(MarblingSegmenter(pool, conv_, {.tile = 0}), std::invalid_argument);
+  const MarblingSegmenter seg(pool, conv_, {.tile = 16});
+  const bench::SyntheticImage img = bench::make_carcass_image(40, 30, 1);
+  ImageView gray = img.view();
+  gray.format = PixelFormat::kGray8;
+  EXPECT_THROW(seg.segment(gray), std::invalid_argument);
+  EXPECT_THROW(seg.segment(img.view(), RoiMap(40, 30, 8)), std::invalid_argument);
+  EXPECT_THROW(seg.segment(img.view(), RoiMap(41, 30, 16)), std::invalid_argument);
+
+  const MarblingResult empty = label_marbling(nullptr, 0, 5);
+  EXPECT_EQ(empty.tiles, 0u);
+  EXPECT_EQ(empty.fat_ratio(), 0.0);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/util/mpsc_queue.hpp"
+
+namespace meat_quality {
+namespace {
+
+using namespace std::chrono_literals;
+
+std::vector<std::uint64_t> drain(MpscQueue<std::uint64_t>& q) {
+  std::vector<std::uint64_t> out;
+  std::uint64_t v;
+  while (q.try_pop(v)) out.push_back(v);
+  return out;
+}
+
+TEST(MpscQueue, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(MpscQueue<int>(5).capacity(), 8u);
+  EXPECT_EQ(MpscQueue<int>(1).capacity(), 2u);
+  EXPECT_THROW(MpscQueue<int>(0), std::invalid_argument);
+}
+
+TEST(MpscQueue, RejectRefusesPushesWhenFull) {
+  MpscQueue<std::uint64_t> q(4, Backpressure::kReject);
+  for (std::uint64_t i = 0; i < 4; ++i) ASSERT_TRUE(q.push(i));
+  EXPECT_FALSE(q.push(4));
+  EXPECT_FALSE(q.push(5));
+  EXPECT_EQ(q.size_approx(), 4u);
+  EXPECT_EQ(drain(q), (std::vector<std::uint64_t>{0, 1, 2, 3}));
+  EXPECT_TRUE(q.push(6));
+
+  const MpscQueueStats s = q.stats();
+  EXPECT_EQ(s.pushed, 5u);
+  EXPECT_EQ(s.popped, 4u);
+  EXPECT_EQ(s.rejected, 2u);
+  EXPECT_EQ(s.dropped, 0u);
+}
+
+TEST(MpscQueue, DropOldestKeepsTheNewestElements) {
+  MpscQueue<std::uint64_t> q(4, Backpressure::kDropOldest);
+  for (std::uint64_t i = 0; i < 10; ++i) ASSERT_TRUE(q.push(i));
+  EXPECT_EQ(drain(q), (std::vector<std::uint64_t>{6, 7, 8, 9}));
+  const MpscQueueStats s = q.stats();
+  EXPECT_EQ(s.pushed, 10u);
+  EXPECT_EQ(s.dropped, 6u);
+  EXPECT_EQ(s.producer_waits, 6u);
+  EXPECT_EQ(s.rejected, 0u);
+}
+
+TEST(MpscQueue, BlockWaitsForTheConsumer) {
+  MpscQueue<std::uint64_t> q(2, Backpressure::kBlock);
+  ASSERT_TRUE(q.push(0));
+  ASSERT_TRUE(q.push(1));
+  std::atomic<bool> done{false};
+  std::thread producer([&] {
+    EXPECT_TRUE(q.push(2));
+    done = true;
+  });
+  std::this_thread::sleep_for(20ms);
+  EXPECT_FALSE(done);
+  std::uint64_t v;
+  ASSERT_TRUE(q.try_pop(v));
+  EXPECT_EQ(v, 0u);
+  producer.join();
+  EXPECT_EQ(drain(q), (std::vector<std::uint64_t>{1, 2}));
+  EXPECT_EQ(q.stats().producer_waits, 1u);
+}
+
+TEST(MpscQueue, CloseReleasesBlockedProducersAndDrains) {
+  MpscQueue<std::uint64_t> q(2, Backpressure::kBlock);
+  ASSERT_TRUE(q.push(0));
+  ASSERT_TRUE(q.push(1));
+  std::thread producer([&] { EXPECT_FALSE(q.push(2)); });
+  std::this_thread::sleep_for(10ms);
+  q.close();
+  producer.join();
+  EXPECT_FALSE(q.push(3));
+  std::uint64_t out[4];
+  EXPECT_EQ(q.pop_batch(out, 4, 1ms), 2u);
+  EXPECT_EQ(q.pop_batch(out, 4, 1ms), 0u);
+  EXPECT_EQ(q.stats().rejected, 2u);
+}
+
+TEST(MpscQueue, ConcurrentProducersDeliverEveryElementInProducerOrder) {
+  constexpr std::uint64_t kProducers = 4;
+  constexpr std::uint64_t kPerProducer = 20000;
+  MpscQueue<std::uint64_t> q(64, Backpressure::kBlock);
+  std::vector<std::thread> producers;
+  for (std::uint64_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&q, p] {
+      for (std::uint64_t i = 0; i < kPerProducer; ++i) q.push(p << 32 | i);
+    });
+  }
+  std::vector<std::uint64_t> next(kProducers, 0);
+  std::uint64_t batch[16];
+  std::uint64_t total = 0;
+  while (total < kProducers * kPerProducer) {
+    const std::size_t n = q.pop_batch(batch, 16, 10ms);
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t p = batch[i] >> 32;
+      ASSERT_LT(p, kProducers);
+      EXPECT_EQ(batch[i] & 0xffffffffu, next[p]++);
+    }
+    total += n;
+  }
+  for (std::thread& t : producers) t.join();
+  EXPECT_EQ(q.size_approx(), 0u);
+  EXPECT_EQ(q.stats().popped, kProducers * kPerProducer);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/core/node_registry.hpp"
+
+namespace meat_quality {
+namespace {
+
+NodeRecord record_of(NodeId node, std::uint32_t shard) {
+  NodeRecord r;
+  r.node = node;
+  r.shard = shard;
+  r.location = {shard, node};
+  return r;
+}
+
+// Nodes [0, count), all on `shard`.
+std::vector<NodeRecord> records_on(std::uint32_t shard, NodeId count) {
+  std::vector<NodeRecord> out;
+  for (NodeId n = 0; n < count; ++n) out.push_back(record_of(n, shard));
+  return out;
+}
+
+TEST(NodeRegistry, LooksUpRegisteredNodes) {
+  const NodeRegistry registry({record_of(7, 1), record_of(1'000'003, 2)});
+  NodeRecord r;
+  ASSERT_TRUE(registry.lookup(7, r));
+  EXPECT_EQ(r.shard, 1u);
+  ASSERT_TRUE(registry.lookup(1'000'003, r));
+  EXPECT_EQ(r.location.room, 1'000'003u);
+  EXPECT_FALSE(registry.lookup(8, r));
+
+  const NodeRegistry::ReadGuard snapshot = registry.read();
+  EXPECT_EQ(snapshot->size(), 2u);
+  EXPECT_EQ(snapshot->find(9), nullptr);
+  EXPECT_EQ(registry.stats().version, 1u);
+  EXPECT_EQ(registry.stats().nodes, 2u);
+}
+
+TEST(NodeRegistry, RejectsDuplicateNodes) {
+  EXPECT_THROW(NodeRegistry({record_of(1, 0), record_of(1, 1)}), std::invalid_argument);
+  NodeRegistry registry(records_on(0, 4));
+  EXPECT_THROW(registry.replace({record_of(2, 0), record_of(2, 0)}), std::invalid_argument);
+  // A failed replace publishes nothing.
+  EXPECT_EQ(registry.stats().version, 1u);
+  EXPECT_EQ(registry.stats().nodes, 4u);
+}
+
+TEST(NodeRegistry, UpdateModifyAndReplacePublishNewVersions) {
+  NodeRegistry registry(records_on(0, 4));
+  const NodeRecord changed[] = {record_of(1, 5), record_of(9, 5), record_of(9, 6)};
+  const NodeId removed[] = {3};
+  registry.update(changed, removed);
+
+  NodeRecord r;
+  ASSERT_TRUE(registry.lookup(1, r));
+  EXPECT_EQ(r.shard, 5u);
+  ASSERT_TRUE(registry.lookup(9, r));
+  EXPECT_EQ(r.shard, 6u);  // the last one wins
+  EXPECT_FALSE(registry.lookup(3, r));
+  EXPECT_EQ(registry.stats().nodes, 4u);
+
+  registry.modify([](std::vector<NodeRecord>& records) {
+    for (NodeRecord& rec : records) rec.shard += 10;
+  });
+  ASSERT_TRUE(registry.lookup(0, r));
+  EXPECT_EQ(r.shard, 10u);
+
+  registry.replace({record_of(42, 1)});
+  EXPECT_FALSE(registry.lookup(0, r));
+  EXPECT_TRUE(registry.lookup(42, r));
+  EXPECT_EQ(registry.stats().version, 4u);
+  EXPECT_EQ(registry.read()->version(), 4u);
+}
+
+TEST(NodeRegistry, UpdateWaitsForReadersOfTheOldSnapshot) {
+  NodeRegistry registry(records_on(1, 16));
+  std::optional<NodeRegistry::ReadGuard> old(registry.read());
+  std::atomic<bool> published{false};
+  std::thread updater([&] {
+    registry.replace(records_on(2, 16));
+    published = true;
+  });
+
+  // New readers see the new snapshot as soon as it is published...
+  NodeRecord r;
+  for (int i = 0; i < 1000 && !(registry.lookup(5, r) && r.shard == 2); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(r.shard, 2u);
+  // ...while the update waits on the pinned one, which stays intact.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(published.load());
+  // No ASSERT before the join: returning would leave the updater joinable.
+  const NodeRecord* pinned = (*old)->find(5);
+  EXPECT_TRUE(pinned != nullptr && pinned->shard == 1);
+  EXPECT_EQ((*old)->version(), 1u);
+
+  old.reset();
+  updater.join();
+  EXPECT_TRUE(published.load());
+  EXPECT_GT(registry.stats().grace_ns, 0u);
+}
+
+TEST(NodeRegistry, ReadersSeeWholeSnapshotsDuringUpdates) {
+  constexpr NodeId kNodes = 64;
+  constexpr std::uint32_t kVersions = 200;
+  NodeRegistry registry(records_on(0, kNodes));
+  std::atomic<bool> done{false};
+  std::atomic<std::uint64_t> torn{0};
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back([&] {
+      while (!done.load(std::memory_order_relaxed)) {
+        // Every record of one snapshot was written by the same update.
+        const NodeRegistry::ReadGuard snapshot = registry.read();
+        const NodeRecord* first = snapshot->find(0);
+        if (first == nullptr || snapshot->size() != kNodes) {
+          ++torn;
+          continue;
+        }
+        for (NodeId n = 1; n < kNodes; ++n) {
+          const NodeRecord* r = snapshot->find(n);
+          if (r == nullptr || r->shard != first->shard) ++torn;
+        }
+      }
+    });
+  }
+  for (std::uint32_t v = 1; v <= kVersions; ++v) registry.replace(records_on(v, kNodes));
+  done = true;
+  for (std::thread& t : readers) t.join();
+
+  EXPECT_EQ(torn.load(), 0u);
+  EXPECT_EQ(registry.stats().version, kVersions + 1);
+  NodeRecord r;
+  ASSERT_TRUE(registry.lookup(kNodes - 1, r));
+  EXPECT_EQ(r.shard, kVersions);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/net/partitioned_grader.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Polls `done` for up to five seconds.
+template <typename Fn>
+bool eventually(Fn&& done) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+struct Graded {
+  wire::GradeStatus status = wire::GradeStatus::kOverloaded;
+  GradeResult result;
+};
+
+Detached await_grade(EventLoop& loop, PartitionedGrader& grader, GradingRequest request,
+                     Graded& out) {
+  const EventLoop::TaskToken token(loop);
+  out.status = co_await grader.grade(loop, request, out.result);
+}
+
+// Grades every request from coroutines on one loop, run on this thread.
+std::vector<Graded> grade_all(PartitionedGrader& grader, const std::vector<GradingRequest>& reqs) {
+  EventLoop loop;
+  std::vector<Graded> out(reqs.size());
+  for (std::size_t i = 0; i < reqs.size(); ++i) await_grade(loop, grader, reqs[i], out[i]);
+  loop.stop();
+  loop.run();
+  return out;
+}
+
+TEST(NumaTopology, ExplicitLayoutsDropNodesWithoutCpus) {
+  const NumaTopology t({{0, {0, 1}}, {1, {}}, {3, {2}}});
+  ASSERT_EQ(t.node_count(), 2u);
+  EXPECT_EQ(t.node(0).id, 0);
+  EXPECT_EQ(t.node(1).id, 3);
+  EXPECT_EQ(t.node(1).cpus, std::vector<int>{2});
+
+  const NumaTopology none({});
+  ASSERT_EQ(none.node_count(), 1u);
+  EXPECT_EQ(none.node(0).cpus, std::vector<int>{0});
+}
+
+TEST(NumaTopology, DetectsEachAllowedCpuOnce) {
+  const NumaTopology t = NumaTopology::detect();
+  ASSERT_GE(t.node_count(), 1u);
+  std::set<int> cpus;
+  for (std::size_t i = 0; i < t.node_count(); ++i) {
+    if (i > 0) {
+      EXPECT_LT(t.node(i - 1).id, t.node(i).id);
+    }
+    EXPECT_FALSE(t.node(i).cpus.empty());
+    for (const int c : t.node(i).cpus) EXPECT_TRUE(cpus.insert(c).second) << c;
+  }
+
+  // Pinning to a detected CPU sticks; nothing valid to pin to is refused.
+  const int cpu = t.node(t.node_count() - 1).cpus.back();
+  std::thread([cpu] {
+    EXPECT_TRUE(pin_current_thread(std::vector<int>{cpu}));
+    EXPECT_EQ(current_cpu(), cpu);
+    EXPECT_FALSE(pin_current_thread({}));
+    EXPECT_FALSE(pin_current_thread(std::vector<int>{-1}));
+  }).join();
+}
+
+// Three partitions on whatever CPU the test may use, so the layout does
+// not depend on the machine.
+class PartitionedGraderTest : public ::testing::Test {
+ protected:
+  static constexpr std::size_t kNodes = 10;
+
+  NumaTopology three_sockets() const {
+    const int cpu = NumaTopology::detect().node(0).cpus.front();
+    return NumaTopology({{0, {cpu}}, {1, {cpu}}, {2, {cpu}}});
+  }
+
+  PartitionedGraderOptions options() const {
+    PartitionedGraderOptions o;
+    o.node_count = kNodes;
+    o.capacity_per_node = 512;
+    o.queue_capacity = 4096;
+    o.drain_batch = 64;
+    o.grade_capacity = 64;
+    return o;
+  }
+
+  const FreshnessClassifier classifier_{ClassifierWeights::random(16, 33)};
+  const LabConverter converter_{LabMode::kExact};
+};
+
+TEST_F(PartitionedGraderTest, RoutesContiguousRangesToPartitions) {
+  const PartitionedGrader grader(three_sockets(), classifier_, converter_, options());
+  ASSERT_EQ(grader.partition_count(), 3u);
+  std::vector<std::size_t> sizes(3);
+  for (NodeId n = 0; n < kNodes; ++n) {
+    const std::size_t p = grader.partition_of(n);
+    ASSERT_LT(p, 3u);
+    if (n > 0) {
+      EXPECT_GE(p, grader.partition_of(n - 1));
+    }
+    ++sizes[p];
+  }
+  EXPECT_EQ(sizes, (std::vector<std::size_t>{4, 3, 3}));
+  EXPECT_EQ(grader.partition_of(kNodes), 2u);
+  EXPECT_EQ(grader.partition_of(~NodeId{0}), 2u);
+
+  // More sockets than nodes: one partition per node.
+  PartitionedGraderOptions two = options();
+  two.node_count = 2;
+  EXPECT_EQ(PartitionedGrader(three_sockets(), classifier_, converter_, two).partition_count(),
+            2u);
+}
+
+TEST_F(PartitionedGraderTest, GradesMatchOneUnpartitionedStore) {
+  NodeRecord calibrated;
+  calibrated.node = 5;  // first node of the second partition
+  calibrated.calibration.gain[index_of(Channel::kNh3)] = 2.0f;
+  calibrated.calibration.offset[index_of(Channel::kVoc)] = -10.0f;
+  const NodeRegistry registry({calibrated});
+  PartitionedGraderOptions o = options();
+  o.registry = &registry;
+  PartitionedGrader grader(three_sockets(), classifier_, converter_, o);
+
+  const IngestRecord early{0, {}};
+  EXPECT_FALSE(grader.push(early));  // not started
+  grader.start();
+  grader.start();  // a second call does nothing
+
+  SampleStore store(kNodes, o.capacity_per_node);
+  const GradingPipeline pipeline(store, classifier_, converter_, o.grading);
+  bench::TraceGenerator gen(4);
+  std::uint64_t pushed = 0;
+  for (std::uint64_t t = 1; t <= 700; ++t) {  // past the ring capacity
+    for (NodeId n = 0; n < kNodes; ++n) {
+      SensorSample s = gen.sample(n, t);
+      ASSERT_TRUE(grader.push({n, s}));
+      ++pushed;
+      if (n == 5) calibrated.calibration.apply(s);
+      store.push(n, s);
+    }
+  }
+  ASSERT_TRUE(eventually([&] { return grader.stats().samples == pushed; }));
+
+  std::vector<GradingRequest> requests;
+  for (NodeId n = 0; n < kNodes; ++n) {
+    requests.push_back({n, 0, {}});
+    requests.push_back({n, 50 * bench::kTickMicros, {}});
+  }
+  requests.push_back({kNodes, 0, {}});
+  const std::vector<Graded> got = grade_all(grader, requests);
+  for (std::size_t i = 0; i + 1 < requests.size(); ++i) {
+    SCOPED_TRACE(testing::Message() << "node " << requests[i].node << " at " << requests[i].at);
+    ASSERT_EQ(got[i].status, wire::GradeStatus::kOk);
+    const GradeResult want = pipeline.grade(requests[i]);
+    EXPECT_EQ(got[i].result.node, requests[i].node);
+    EXPECT_EQ(got[i].result.samples, want.samples);
+    EXPECT_EQ(got[i].result.sensor.label, want.sensor.label);
+    EXPECT_EQ(std::memcmp(got[i].result.sensor.probabilities.data(),
+                          want.sensor.probabilities.data(), sizeof want.sensor.probabilities),
+              0);
+  }
+  EXPECT_EQ(got.back().status, wire::GradeStatus::kUnknownNode);
+
+  // A partition counts its grades after resuming their coroutines.
+  EXPECT_TRUE(eventually([&] { return grader.stats().grades == requests.size(); }))
+      << grader.stats().grades;  // answered, the unknown node included
+  EXPECT_EQ(grader.stats().samples, pushed);
+  EXPECT_EQ(grader.stats().rejected, 0u);
+}
+
+TEST_F(PartitionedGraderTest, CountsRejectedSamplesAndRefusesAfterStop) {
+  PartitionedGrader grader(three_sockets(), classifier_, converter_, options());
+  grader.start();
+  bench::TraceGenerator gen(6);
+  ASSERT_TRUE(grader.push({8, gen.sample(8, 100)}));
+  ASSERT_TRUE(grader.push({8, gen.sample(8, 99)}));  // out of order
+  ASSERT_TRUE(grader.push({kNodes + 3, gen.sample(1, 100)}));  // beyond the node count
+  ASSERT_TRUE(eventually([&] {
+    const PartitionedGraderStats s = grader.stats();
+    return s.samples + s.rejected == 3;
+  }));
+  EXPECT_EQ(grader.stats().samples, 1u);
+  EXPECT_EQ(grader.stats().rejected, 2u);
+
+  grader.stop();
+  EXPECT_FALSE(grader.push({8, gen.sample(8, 200)}));
+  const std::vector<Graded> got = grade_all(grader, {{8, 0, {}}, {1, 0, {}}});
+  EXPECT_EQ(got[0].status, wire::GradeStatus::kShuttingDown);
+  EXPECT_EQ(got[1].status, wire::GradeStatus::kShuttingDown);
+  grader.stop();  // a second call does nothing
+}
+
+TEST_F(PartitionedGraderTest, RejectsBadOptionsAndRethrowsStartFailures) {
+  PartitionedGraderOptions o = options();
+  o.node_count = 0;
+  EXPECT_THROW(PartitionedGrader(three_sockets(), classifier_, converter_, o),
+               std::invalid_argument);
+  o = options();
+  o.drain_batch = 0;
+  EXPECT_THROW(PartitionedGrader(three_sockets(), classifier_, converter_, o),
+               std::invalid_argument);
+
+  // Partition state is built on the partition threads.
+  o = options();
+  o.queue_capacity = 0;
+  PartitionedGrader grader(three_sockets(), classifier_, converter_, o);
+  EXPECT_THROW(grader.start(), std::invalid_argument);
+  EXPECT_FALSE(grader.push({0, {}}));
+}
+
+}  // namespace
+}  // namespace meat_quality
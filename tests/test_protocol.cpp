@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "meat_quality/net/protocol.hpp"
+#include "synthetic_trace.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality::wire {
+namespace {
+
+// Splits one encoded frame into its type and body.
+std::span<const std::uint8_t> body_of(const std::vector<std::uint8_t>& frame, FrameType want) {
+  std::uint32_t length = 0;
+  FrameType type{};
+  EXPECT_GE(frame.size(), kFrameHeaderBytes);
+  parse_frame_header(frame.data(), length, type);
+  EXPECT_EQ(type, want);
+  EXPECT_EQ(length + 4u, frame.size());
+  return std::span(frame).subspan(kFrameHeaderBytes);
+}
+
+// Three runs over two nodes, with timestamps that jump and go negative.
+std::vector<IngestRecord> packed_records() {
+  bench::TraceGenerator gen(8);
+  std::vector<IngestRecord> out;
+  for (std::uint64_t t = 0; t < 40; ++t) out.push_back({7, gen.sample(7, t)});
+  for (std::uint64_t t = 0; t < 5; ++t) out.push_back({1'000'000, gen.sample(3, t)});
+  for (std::uint64_t t = 40; t < 45; ++t) out.push_back({7, gen.sample(7, t)});
+  out[3].sample.timestamp = out[2].sample.timestamp;  // zero delta
+  out[41].sample.timestamp = -123'456'789;
+  out[42].sample.timestamp = std::numeric_limits<Timestamp>::max();
+  out[43].sample.timestamp = std::numeric_limits<Timestamp>::min();
+  out[10].sample[Channel::kNh3] = std::nanf("");
+  out[11].sample[Channel::kPh] = -INFINITY;
+  out[12].sample[Channel::kVoc] = 1e12f;  // clamps to the 32-bit fixed-point range
+  return out;
+}
+
+std::vector<IngestRecord> read_all(std::span<const std::uint8_t> body, bool& failed) {
+  std::vector<IngestRecord> out;
+  PackedPushReader reader(body);
+  for (IngestRecord r; reader.next(r);) out.push_back(r);
+  failed = reader.failed();
+  return out;
+}
+
+TEST(Protocol, PackedPushRoundTripsToTheFixedPointStep) {
+  const std::vector<IngestRecord> in = packed_records();
+  std::vector<std::uint8_t> frame;
+  append_packed_push(frame, in);
+  const auto body = body_of(frame, FrameType::kPackedPush);
+  EXPECT_LT(body.size(), in.size() * kSampleRecordBytes / 3);
+
+  std::uint32_t count = 0;
+  ASSERT_TRUE(parse_packed_push(body, count));
+  EXPECT_EQ(count, in.size());
+  bool failed = true;
+  const std::vector<IngestRecord> out = read_all(body, failed);
+  EXPECT_FALSE(failed);
+  ASSERT_EQ(out.size(), in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(out[i].node, in[i].node) << i;
+    EXPECT_EQ(out[i].sample.timestamp, in[i].sample.timestamp) << i;
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      const float want = in[i].sample.values[c];
+      const float got = out[i].sample.values[c];
+      if (!std::isfinite(want)) {
+        EXPECT_TRUE(std::isnan(got)) << i << " " << c;
+      } else if (i == 12 && c == index_of(Channel::kVoc)) {
+        EXPECT_NEAR(got, std::numeric_limits<std::int32_t>::max() / kPackedScale[c], 1.0f);
+      } else {
+        EXPECT_NEAR(got, want, 0.5f / kPackedScale[c] * 1.001f) << i << " " << c;
+      }
+    }
+  }
+}
+
+TEST(Protocol, PackedPushRejectsMalformedBodies) {
+  // The reader alone catches everything parse_packed_push() does.
+  const auto reject = [](std::vector<std::uint8_t> body) {
+    std::uint32_t count = 0;
+    bool failed = false;
+    read_all(body, failed);
+    EXPECT_EQ(failed, !parse_packed_push(body, count));
+    return failed;
+  };
+  EXPECT_TRUE(reject({}));
+  EXPECT_FALSE(reject({0}));                      // an empty push
+  EXPECT_TRUE(reject({1}));                       // a record short
+  EXPECT_TRUE(reject({2, 5, 1, 0, 0, 0, 0, 0, 0, 0}));  // fewer records than declared
+  EXPECT_TRUE(reject({1, 5, 0}));                 // zero-length run
+  EXPECT_TRUE(reject({0, 5, 1, 0, 0, 0, 0, 0}));  // more records than declared
+  // Over-long varint: eleven continuation bytes.
+  EXPECT_TRUE(reject({0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01}));
+  // Node id above 32 bits.
+  EXPECT_TRUE(reject({1, 0x80, 0x80, 0x80, 0x80, 0x10, 1, 0, 0, 0, 0, 0, 0, 0}));
+  // A value delta that leaves the 32-bit fixed-point range.
+  EXPECT_TRUE(reject({1, 5, 1, 0, 0xfe, 0xff, 0xff, 0xff, 0x1f, 0, 0, 0, 0, 0}));
+
+  std::vector<std::uint8_t> frame;
+  append_packed_push(frame, packed_records());
+  const auto body = body_of(frame, FrameType::kPackedPush);
+  for (std::size_t n = 0; n < body.size(); ++n) {
+    EXPECT_TRUE(reject({body.begin(), body.begin() + static_cast<std::ptrdiff_t>(n)})) << n;
+  }
+}
+
+// The reader fails exactly where parse_packed_push() does, and decodes
+// everything it accepts.
+TEST(Protocol, PackedPushSurvivesBitFlips) {
+  std::vector<std::uint8_t> frame;
+  append_packed_push(frame, packed_records());
+  const auto body = body_of(frame, FrameType::kPackedPush);
+  test::for_each_corruption({body.begin(), body.end()}, [](const std::vector<std::uint8_t>& b) {
+    std::uint32_t count = 0;
+    const bool ok = parse_packed_push(b, count);
+    bool failed = false;
+    const std::vector<IngestRecord> out = read_all(b, failed);
+    EXPECT_EQ(failed, !ok);
+    if (ok) {
+      EXPECT_EQ(out.size(), count);
+    }
+  }, 2000);
+}
+
+TEST(Protocol, SensorPushRoundTrips) {
+  const std::vector<IngestRecord> in = packed_records();
+  std::vector<std::uint8_t> frame;
+  append_sensor_push(frame, in);
+  const auto body = body_of(frame, FrameType::kSensorPush);
+  std::uint32_t count = 0;
+  ASSERT_TRUE(parse_sensor_push(body, count));
+  ASSERT_EQ(count, in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    const IngestRecord r = sensor_record(body.data(), i);
+    EXPECT_EQ(r.node, in[i].node);
+    EXPECT_EQ(r.sample.timestamp, in[i].sample.timestamp);
+    EXPECT_EQ(std::memcmp(r.sample.values.data(), in[i].sample.values.data(),
+                          sizeof r.sample.values),
+              0);
+  }
+  EXPECT_FALSE(parse_sensor_push(body.first(body.size() - 1), count));
+  EXPECT_FALSE(parse_sensor_push(body.first(3), count));
+}
+
+TEST(Protocol, FixedSizeFramesRoundTrip) {
+  std::vector<std::uint8_t> frame;
+  append_grade_request(frame, {.id = 99, .node = 12, .at = -5});
+  GradeRequestFrame request;
+  ASSERT_TRUE(parse_grade_request(body_of(frame, FrameType::kGradeRequest), request));
+  EXPECT_EQ(request.id, 99u);
+  EXPECT_EQ(request.node, 12u);
+  EXPECT_EQ(request.at, -5);
+
+  GradeResponseFrame response;
+  response.id = 7;
+  response.status = GradeStatus::kOverloaded;
+  response.result.samples = 600;
+  response.result.at = 1234;
+  response.result.sensor.label = FreshnessClass::kSpoiled;
+  response.result.sensor.probabilities = {0.1f, 0.2f, 0.7f};
+  frame.clear();
+  append_grade_response(frame, response);
+  GradeResponseFrame got;
+  ASSERT_TRUE(parse_grade_response(body_of(frame, FrameType::kGradeResponse), got));
+  EXPECT_EQ(got.id, 7u);
+  EXPECT_EQ(got.status, GradeStatus::kOverloaded);
+  EXPECT_EQ(got.result.samples, 600u);
+  EXPECT_EQ(got.result.at, 1234);
+  EXPECT_EQ(got.result.sensor.label, FreshnessClass::kSpoiled);
+  EXPECT_EQ(got.result.sensor.probabilities, response.result.sensor.probabilities);
+
+  std::vector<std::uint8_t> bad(frame.begin() + kFrameHeaderBytes, frame.end());
+  bad[8] = 4;  // no such status
+  EXPECT_FALSE(parse_grade_response(bad, got));
+  bad[8] = 0;
+  bad[9] = static_cast<std::uint8_t>(FreshnessClass::kUnknown) + 1;
+  EXPECT_FALSE(parse_grade_response(bad, got));
+
+  frame.clear();
+  append_rate_hint(frame, {.node = 3, .interval_ms = 5000});
+  RateHintFrame hint;
+  ASSERT_TRUE(parse_rate_hint(body_of(frame, FrameType::kRateHint), hint));
+  EXPECT_EQ(hint.node, 3u);
+  EXPECT_EQ(hint.interval_ms, 5000u);
+  frame.clear();
+  append_rate_hint(frame, {.node = 3, .interval_ms = 0});
+  EXPECT_FALSE(parse_rate_hint(body_of(frame, FrameType::kRateHint), hint));
+}
+
+}  // namespace
+}  // namespace meat_quality::wire
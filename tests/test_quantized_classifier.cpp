@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "meat_quality/inference/quantized_classifier.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr std::size_t kHidden = 32;
+
+std::vector<FeatureVector> random_features(std::size_t n, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<float> normal(0.0f, 1.5f);
+  std::vector<FeatureVector> out(n);
+  for (FeatureVector& v : out) {
+    for (float& x : v) x = normal(rng);
+  }
+  return out;
+}
+
+class QuantizedClassifierTest : public ::testing::Test {
+ protected:
+  QuantizedClassifierTest()
+      : weights_(ClassifierWeights::random(kHidden, 7)),
+        fp32_(weights_),
+        int8_(quantize(weights_, random_features(256, 1))) {}
+
+  ClassifierWeights weights_;
+  FreshnessClassifier fp32_;
+  QuantizedClassifier int8_;
+};
+
+TEST_F(QuantizedClassifierTest, AgreesWithFp32OnASampleSet) {
+  const std::vector<FeatureVector> inputs = random_features(2000, 2);
+  std::vector<Prediction> got(inputs.size());
+  std::vector<std::int32_t> scratch(int8_.scratch_size(inputs.size()));
+  int8_.predict(inputs.data(), inputs.size(), got.data(), scratch);
+
+  std::size_t agree = 0;
+  double max_error = 0;
+  for (std::size_t r = 0; r < inputs.size(); ++r) {
+    const Prediction want = fp32_.predict(inputs[r]);
+    agree += got[r].label == want.label;
+    for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+      max_error = std::max(max_error, double(std::fabs(got[r].probabilities[k] -
+                                                       want.probabilities[k])));
+    }
+  }
+  // The README promises about 98-99% agreement on the benchmark inputs.
+  EXPECT_GE(double(agree) / double(inputs.size()), 0.97);
+  EXPECT_LT(max_error, 0.1);
+}
+
+TEST_F(QuantizedClassifierTest, MissingChannelMatchesFp32) {
+  const std::vector<FeatureVector> inputs = random_features(50, 3);
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    for (const FeatureVector& base : inputs) {
+      FeatureVector dropped = base;
+      FeatureVector at_mean = base;
+      for (std::size_t i = c * kFeaturesPerChannel; i < (c + 1) * kFeaturesPerChannel; ++i) {
+        dropped[i] = std::numeric_limits<float>::quiet_NaN();
+        at_mean[i] = weights_.input_mean[i];
+      }
+      const Prediction q = int8_.predict(dropped);
+      const Prediction f = fp32_.predict(dropped);
+      ASSERT_NE(q.label, FreshnessClass::kUnknown);
+      ASSERT_NE(f.label, FreshnessClass::kUnknown);
+      // Both paths take the channel at its training mean...
+      const Prediction q_mean = int8_.predict(at_mean);
+      EXPECT_EQ(q.label, q_mean.label);
+      EXPECT_EQ(std::memcmp(q.probabilities.data(), q_mean.probabilities.data(),
+                            sizeof q.probabilities),
+                0);
+      EXPECT_EQ(f.label, fp32_.predict(at_mean).label);
+      // ...and stay within quantization error of each other.
+      for (std::size_t k = 0; k < kFreshnessClassCount; ++k) {
+        EXPECT_NEAR(q.probabilities[k], f.probabilities[k], 0.1f);
+      }
+    }
+  }
+}
+
+TEST_F(QuantizedClassifierTest, InfiniteAndHugeFeaturesStayDefined) {
+  FeatureVector v = random_features(1, 4)[0];
+  v[0] = std::numeric_limits<float>::infinity();
+  v[1] = -std::numeric_limits<float>::infinity();
+  v[2] = 1e30f;  // finite: clamps to the end of the range
+  v[3] = -1e30f;
+  const Prediction p = int8_.predict(v);
+  EXPECT_NE(p.label, FreshnessClass::kUnknown);
+  EXPECT_NEAR(p.probabilities[0] + p.probabilities[1] + p.probabilities[2], 1.0f, 1e-5f);
+}
+
+TEST_F(QuantizedClassifierTest, NaNCalibrationDataIsTreatedAsMissing) {
+  std::vector<FeatureVector> calibration = random_features(256, 1);
+  for (std::size_t r = 0; r < calibration.size(); r += 3) {
+    calibration[r][r % kFeatureDim] = std::numeric_limits<float>::quiet_NaN();
+  }
+  const QuantizedWeights q = quantize(weights_, calibration);
+  EXPECT_TRUE(std::isfinite(q.l1.in_scale));
+  EXPECT_TRUE(std::isfinite(q.l2.in_scale));
+  EXPECT_GT(q.l1.in_scale, 0.0f);
+}
+
+#if defined(MEAT_QUALITY_INT8_PLUGIN_PATH)
+TEST_F(QuantizedClassifierTest, PluginKernelsMatchTheReference) {
+  const Int8Backend plugin = Int8Backend::load(MEAT_QUALITY_INT8_PLUGIN_PATH);
+  const QuantizedClassifier accelerated(int8_.weights(), plugin);
+  // Batch sizes around the kernels' row blocking, including odd tails.
+  for (const std::size_t batch : {1u, 3u, 4u, 7u, 16u, 33u}) {
+    const std::vector<FeatureVector> inputs = random_features(batch, 10 + batch);
+    std::vector<Prediction> want(batch), got(batch);
+    std::vector<std::int32_t> scratch(int8_.scratch_size(batch));
+    int8_.predict(inputs.data(), batch, want.data(), scratch);
+    accelerated.predict(inputs.data(), batch, got.data(), scratch);
+    for (std::size_t r = 0; r < batch; ++r) {
+      // Integer products: bit-exact whatever the kernel.
+      EXPECT_EQ(got[r].label, want[r].label);
+      EXPECT_EQ(std::memcmp(got[r].probabilities.data(), want[r].probabilities.data(),
+                            sizeof want[r].probabilities),
+                0)
+          << plugin.name() << " batch " << batch << " row " << r;
+    }
+  }
+}
+#endif
+
+}  // namespace
+}  // namespace meat_quality
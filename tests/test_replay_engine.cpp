@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "meat_quality/grading/replay_engine.hpp"
+#include "synthetic_image.hpp"
+#include "synthetic_trace.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr Timestamp kStep = 7 * kMicrosPerSecond;
+constexpr std::size_t kCapacity = 256;
+
+// Sparse node ids, written to two segments that overlap by 50 ticks; the
+// overlap carries different values, which replay must drop as production
+// would.
+const std::vector<NodeId> kNodes = {0, 3, 4, 9, 11};
+constexpr std::uint64_t kFirstEnd = 1200, kSecondBegin = 1150, kSecondEnd = 2400;
+
+// Bit-identical when `exact`, else within float rounding of the features.
+void expect_same_result(const GradeResult& got, const GradeResult& want, bool exact) {
+  EXPECT_EQ(got.at, want.at);
+  EXPECT_EQ(got.samples, want.samples);
+  EXPECT_EQ(got.sensor.label, want.sensor.label);
+  if (exact) {
+    EXPECT_EQ(std::memcmp(got.sensor.probabilities.data(), want.sensor.probabilities.data(),
+                          sizeof want.sensor.probabilities),
+              0);
+  } else {
+    for (std::size_t c = 0; c < kFreshnessClassCount; ++c) {
+      EXPECT_NEAR(got.sensor.probabilities[c], want.sensor.probabilities[c],
+                  1e-4 * want.sensor.probabilities[c])
+          << c;
+    }
+  }
+  EXPECT_EQ(got.has_color, want.has_color);
+  EXPECT_EQ(got.color.pixels, want.color.pixels);
+  EXPECT_EQ(got.color.mean_a, want.color.mean_a);
+  EXPECT_EQ(got.color.a_p50, want.color.a_p50);
+}
+
+class ReplayEngineTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bench::TraceGenerator gen(5);
+    SegmentWriter first(dir_.file("a.seg"), 64), second(dir_.file("b.seg"), 64);
+    // Ticks start at 1: a request at 0 would mean "the newest sample".
+    for (std::uint64_t t = 1; t < kSecondEnd; ++t) {
+      for (const NodeId n : kNodes) {
+        if (t < kFirstEnd) first.append(n, history_[n].emplace_back(gen.sample(n, t)));
+        if (t >= kSecondBegin) overlap_[n].push_back(gen.sample(n, t));
+      }
+    }
+    for (const NodeId n : kNodes) {
+      for (const SensorSample& s : overlap_[n]) second.append(n, s);
+      history_[n].insert(history_[n].end(), overlap_[n].begin(), overlap_[n].end());
+    }
+    first.finish();
+    second.finish();
+    for (const char* name : {"a.seg", "b.seg"}) {
+      readers_.push_back(std::make_unique<SegmentReader>(dir_.file(name)));
+      segments_.push_back(readers_.back().get());
+    }
+  }
+
+  // What `grade({node, t})` returns in production at each instant: a store
+  // of the same capacity fed the segments' samples, in order, up to `t`.
+  std::map<std::pair<NodeId, Timestamp>, GradeResult> reference(
+      const std::vector<NodeId>& nodes, Timestamp from, Timestamp to,
+      const ReplayEngine::CropSource& crops = {}) const {
+    SampleStore store(kNodes.back() + 1, kCapacity);
+    const GradingPipeline pipeline(store, classifier_, converter_, options_.grading);
+    std::map<NodeId, std::size_t> next;
+    std::map<std::pair<NodeId, Timestamp>, GradeResult> out;
+    for (Timestamp t = from; t <= to; t += kStep) {
+      for (const NodeId n : nodes) {
+        const std::vector<SensorSample>& h = history_.at(n);
+        std::size_t& i = next[n];
+        for (; i < h.size() && h[i].timestamp <= t; ++i) store.push(n, h[i]);
+        const std::span<const ImageView> c = crops ? crops(n, t) : std::span<const ImageView>{};
+        out[{n, t}] = pipeline.grade({n, t, c});
+      }
+    }
+    return out;
+  }
+
+  // Runs the replay and checks every result against `want`, node by node
+  // in time order.
+  ReplayStats replay_and_compare(
+      const ReplayEngine& engine,
+      const std::map<std::pair<NodeId, Timestamp>, GradeResult>& want,
+      const ReplayEngine::CropSource& crops = {}, bool exact = true) {
+    std::vector<GradeResult> got;
+    const ReplayStats stats = engine.run(
+        segments_,
+        [&](std::span<const GradeResult> batch) {
+          EXPECT_GT(batch.size(), 0u);
+          EXPECT_LE(batch.size(), engine.options().output_batch);
+          got.insert(got.end(), batch.begin(), batch.end());
+        },
+        crops);
+    EXPECT_EQ(got.size(), want.size());
+    std::map<NodeId, Timestamp> last;
+    for (const GradeResult& r : got) {
+      const auto it = want.find({r.node, r.at});
+      if (it == want.end()) {
+        ADD_FAILURE() << "unexpected result for node " << r.node << " at " << r.at;
+        continue;
+      }
+      SCOPED_TRACE(testing::Message() << "node " << r.node << " at " << r.at);
+      expect_same_result(r, it->second, exact);
+      if (last.count(r.node) != 0) {
+        EXPECT_LT(last[r.node], r.at);
+      }
+      last[r.node] = r.at;
+    }
+    EXPECT_EQ(stats.grades, got.size());
+    return stats;
+  }
+
+  ReplayOptions options(std::span<const NodeId> nodes = {}) const {
+    ReplayOptions o = options_;
+    o.nodes = nodes;
+    return o;
+  }
+
+  test::TempDir dir_;
+  std::map<NodeId, std::vector<SensorSample>> history_, overlap_;
+  std::vector<std::unique_ptr<SegmentReader>> readers_;
+  std::vector<const SegmentReader*> segments_;
+  const FreshnessClassifier classifier_{ClassifierWeights::random(16, 21)};
+  const LabConverter converter_{LabMode::kExact};
+  // The window is longer than the ring, so the capacity bounds what a grade
+  // sees; two nodes a task leaves a partial last task.
+  const ReplayOptions options_ = [] {
+    ReplayOptions o;
+    o.step = kStep;
+    o.capacity_per_node = kCapacity;
+    o.nodes_per_task = 2;
+    o.output_batch = 7;
+    o.grading.window = 60 * kMicrosPerSecond;
+    return o;
+  }();
+};
+
+TEST_F(ReplayEngineTest, MatchesProductionGradesAtEveryInstant) {
+  for (const std::size_t threads : {1u, 3u}) {
+    SCOPED_TRACE(testing::Message() << threads << " threads");
+    WorkStealingPool pool(threads);
+    const ReplayEngine engine(pool, classifier_, converter_, options());
+    const Timestamp first = bench::kTickMicros, last = (kSecondEnd - 1) * bench::kTickMicros;
+    const auto want = reference(kNodes, first, last);
+    const ReplayStats stats = replay_and_compare(engine, want);
+    const std::uint64_t instants = (last - first) / kStep + 1;
+    EXPECT_EQ(stats.nodes, kNodes.size());
+    EXPECT_EQ(stats.grades, kNodes.size() * instants);
+    EXPECT_EQ(stats.batches, 3 * instants);  // tasks of 2, 2 and 1 nodes
+    // Every sample up to the last instant is replayed, overlap included.
+    const Timestamp end = first + (instants - 1) * kStep;
+    std::uint64_t samples = 0;
+    for (const auto& [n, h] : history_) {
+      for (const SensorSample& s : h) samples += s.timestamp <= end;
+    }
+    EXPECT_EQ(stats.samples, samples);
+  }
+}
+
+TEST_F(ReplayEngineTest, ReplaysASubsetOfNodesOverARange) {
+  WorkStealingPool pool(2);
+  const std::vector<NodeId> nodes = {3, 11};
+  ReplayOptions o = options(nodes);
+  o.from = 100 * kMicrosPerSecond;
+  o.to = 180 * kMicrosPerSecond;  // not on an instant: the last one is 177 s
+  const ReplayEngine engine(pool, classifier_, converter_, o);
+
+  // Production's ring at `from` already holds the history before it. The
+  // replay only reads back one window, so its ring wraps elsewhere.
+  const auto want = reference(nodes, o.from, o.to);
+  EXPECT_EQ(want.size(), 2u * 12u);
+  const ReplayStats stats = replay_and_compare(engine, want, {}, false);
+  EXPECT_EQ(stats.nodes, 2u);
+  EXPECT_EQ(stats.batches, 12u);
+}
+
+TEST_F(ReplayEngineTest, GradesArchivedCrops) {
+  WorkStealingPool pool(2);
+  const bench::SyntheticImage img = bench::make_carcass_image(48, 32, 3);
+  const ImageView view = img.view();
+  // Crops for some nodes at some instants only.
+  const ReplayEngine::CropSource crops = [&](NodeId n, Timestamp t) {
+    return n % 3 == 0 && (t / kStep) % 2 == 0 ? std::span<const ImageView>(&view, 1)
+                                              : std::span<const ImageView>{};
+  };
+  ReplayOptions o = options();
+  o.to = 60 * kMicrosPerSecond;
+  const ReplayEngine engine(pool, classifier_, converter_, o);
+  const auto want = reference(kNodes, bench::kTickMicros, o.to, crops);
+  replay_and_compare(engine, want, crops);
+  std::size_t with_color = 0;
+  for (const auto& [key, r] : want) with_color += r.has_color;
+  EXPECT_GT(with_color, 0u);
+  EXPECT_LT(with_color, want.size());
+}
+
+TEST_F(ReplayEngineTest, EmptyRangesGradeNothing) {
+  WorkStealingPool pool(1);
+  int calls = 0;
+  const auto count = [&](std::span<const GradeResult>) { ++calls; };
+
+  ReplayOptions o = options();
+  o.from = 500 * kMicrosPerSecond;  // after the last sample
+  EXPECT_EQ(ReplayEngine(pool, classifier_, converter_, o).run(segments_, count).grades, 0u);
+  o.from = 100 * kMicrosPerSecond;
+  o.to = 50 * kMicrosPerSecond;
+  EXPECT_EQ(ReplayEngine(pool, classifier_, converter_, o).run(segments_, count).grades, 0u);
+
+  const ReplayStats none = ReplayEngine(pool, classifier_, converter_, options()).run({}, count);
+  EXPECT_EQ(none.nodes, 0u);
+  EXPECT_EQ(none.grades, 0u);
+  EXPECT_EQ(calls, 0);
+}
+
+TEST_F(ReplayEngineTest, RejectsZeroSizesAndRethrowsSinkErrors) {
+  WorkStealingPool pool(2);
+  for (const auto zero : {&ReplayOptions::capacity_per_node, &ReplayOptions::nodes_per_task,
+                          &ReplayOptions::output_batch}) {
+    ReplayOptions o = options();
+    o.*zero = 0;
+    EXPECT_THROW(ReplayEngine(pool, classifier_, converter_, o), std::invalid_argument);
+  }
+  ReplayOptions o = options();
+  o.step = 0;
+  EXPECT_THROW(ReplayEngine(pool, classifier_, converter_, o), std::invalid_argument);
+  o.step = -kStep;
+  EXPECT_THROW(ReplayEngine(pool, classifier_, converter_, o), std::invalid_argument);
+
+  const ReplayEngine engine(pool, classifier_, converter_, options());
+  int calls = 0;
+  const auto fail = [&](std::span<const GradeResult>) {
+    if (++calls == 3) throw std::runtime_error("sink full");
+  };
+  EXPECT_THROW(engine.run(segments_, fail), std::runtime_error);
+  // The pool is still usable afterwards.
+  EXPECT_GT(engine.run(segments_, [](std::span<const GradeResult>) {}).grades, 0u);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/image/marbling.hpp"
+#include "meat_quality/image/roi.hpp"
+#include "synthetic_image.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Rounded 2x2 box average, one pixel at a time.
+std::vector<std::uint8_t> halve_reference(const ImageView& src) {
+  const std::size_t bpp = bytes_per_pixel(src.format);
+  const std::uint32_t w = src.width / 2, h = src.height / 2;
+  std::vector<std::uint8_t> out(std::size_t{w} * h * bpp);
+  for (std::uint32_t y = 0; y < h; ++y) {
+    for (std::uint32_t x = 0; x < w; ++x) {
+      for (std::size_t c = 0; c < bpp; ++c) {
+        const int sum = src.pixel(2 * x, 2 * y)[c] + src.pixel(2 * x + 1, 2 * y)[c] +
+                        src.pixel(2 * x, 2 * y + 1)[c] + src.pixel(2 * x + 1, 2 * y + 1)[c];
+        out[(std::size_t{y} * w + x) * bpp + c] = static_cast<std::uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+  return out;
+}
+
+void expect_same_pixels(const ImageView& got, const std::vector<std::uint8_t>& want) {
+  const std::size_t row = got.row_bytes();
+  ASSERT_EQ(row * got.height, want.size());
+  for (std::uint32_t y = 0; y < got.height; ++y) {
+    ASSERT_TRUE(std::equal(got.row(y), got.row(y) + row, want.data() + y * row)) << "row " << y;
+  }
+}
+
+TEST(ImagePyramid, LevelsAverageTwoByTwoBlocks) {
+  // Odd sizes drop a row or column at some level; the base is a strided
+  // crop, so rows are not back to back.
+  const bench::SyntheticImage img = bench::make_carcass_image(211, 133, 3);
+  const ImageView base = img.view().crop(2, 1, 203, 131);
+  std::vector<std::uint8_t> gray_pixels(std::size_t{203} * 131);
+  for (std::size_t i = 0; i < gray_pixels.size(); ++i) {
+    gray_pixels[i] = static_cast<std::uint8_t>(i * 7919 % 251);
+  }
+  const ImageView gray{gray_pixels.data(), 203, 131, 203, PixelFormat::kGray8};
+
+  for (const ImageView& view : {base, gray}) {
+    ImagePyramid pyramid;
+    pyramid.build(view, 4);
+    ASSERT_EQ(pyramid.levels(), 5u);
+    EXPECT_EQ(pyramid.level(0).data, view.data);
+    const std::uint32_t widths[] = {203, 101, 50, 25, 12}, heights[] = {131, 65, 32, 16, 8};
+    for (std::uint32_t k = 1; k < pyramid.levels(); ++k) {
+      SCOPED_TRACE(testing::Message() << "level " << k);
+      const ImageView& level = pyramid.level(k);
+      EXPECT_EQ(level.width, widths[k]);
+      EXPECT_EQ(level.height, heights[k]);
+      EXPECT_EQ(level.format, view.format);
+      expect_same_pixels(level, halve_reference(pyramid.level(k - 1)));
+    }
+    EXPECT_EQ(&pyramid.coarsest(), &pyramid.level(4));
+  }
+}
+
+TEST(ImagePyramid, StopsAtOnePixelAndReusesStorage) {
+  const bench::SyntheticImage img = bench::make_carcass_image(40, 5, 1);
+  ImagePyramid pyramid;
+  pyramid.build(img.view(), 10);
+  ASSERT_EQ(pyramid.levels(), 3u);  // 40x5, 20x2, 10x1
+  EXPECT_EQ(pyramid.coarsest().width, 10u);
+  EXPECT_EQ(pyramid.coarsest().height, 1u);
+
+  const std::uint8_t* level1 = pyramid.level(1).data;
+  const bench::SyntheticImage other = bench::make_carcass_image(40, 5, 2);
+  pyramid.build(other.view(), 1);
+  ASSERT_EQ(pyramid.levels(), 2u);
+  EXPECT_EQ(pyramid.level(1).data, level1);
+  expect_same_pixels(pyramid.level(1), halve_reference(other.view()));
+
+  pyramid.build(other.view(), 0);
+  EXPECT_EQ(pyramid.levels(), 1u);
+}
+
+TEST(RoiMap, CountsPartialTilesAndCropsRuns) {
+  RoiMap map(100, 70, 32);  // 4x3 tiles; the last column and row are partial
+  EXPECT_EQ(map.tiles_x(), 4u);
+  EXPECT_EQ(map.tiles_y(), 3u);
+  EXPECT_EQ(map.selected(), 0u);
+  EXPECT_EQ(map.coverage(), 0.0);
+  map.insert(1, 0), map.insert(2, 0), map.insert(3, 0), map.insert(3, 2), map.insert(1, 2);
+  map.insert(1, 0);  // again
+  map.insert(4, 0);  // outside
+  EXPECT_EQ(map.selected(), 5u);
+  EXPECT_TRUE(map.contains(3, 2));
+  EXPECT_FALSE(map.contains(0, 0));
+  EXPECT_FALSE(map.contains(4, 0));
+  EXPECT_EQ(map.pixels(), 32u * 32 * 2 + 4u * 32 + 4u * 6 + 32u * 6);
+  EXPECT_DOUBLE_EQ(map.coverage(), double(map.pixels()) / (100.0 * 70.0));
+
+  const bench::SyntheticImage img = bench::make_carcass_image(100, 70, 1);
+  std::vector<ImageView> crops(1);  // appended to
+  EXPECT_EQ(map.crops(img.view(), crops), 3u);
+  ASSERT_EQ(crops.size(), 4u);
+  EXPECT_EQ(crops[1].data, img.view().pixel(32, 0));
+  EXPECT_EQ(crops[1].width, 68u);  // tiles 1-3, clipped to the frame
+  EXPECT_EQ(crops[1].height, 32u);
+  EXPECT_EQ(crops[2].data, img.view().pixel(32, 64));
+  EXPECT_EQ(crops[2].width, 32u);
+  EXPECT_EQ(crops[2].height, 6u);
+  EXPECT_EQ(crops[3].data, img.view().pixel(96, 64));
+  EXPECT_EQ(crops[3].width, 4u);
+
+  EXPECT_THROW(RoiMap(10, 10, 0), std::invalid_argument);
+}
+
+class RoiDetectorTest : public ::testing::Test {
+ protected:
+  // Tiles overlapped by the full-resolution footprint of every coarse meat
+  // pixel grown by the margin, found pixel by pixel.
+  RoiMap reference(const ImageView& rgb, const RoiOptions& opt) const {
+    RoiMap map(rgb.width, rgb.height, opt.tile);
+    ImagePyramid pyramid;
+    pyramid.build(rgb, opt.level);
+    const ImageView& coarse = pyramid.coarsest();
+    const std::uint32_t scale = 1u << (pyramid.levels() - 1);
+    LabImage lab(coarse.width, coarse.height);
+    conv_.convert(coarse, lab.planes());
+    const auto footprint = [&](std::uint32_t c, std::uint32_t n, std::uint32_t full) {
+      const std::uint32_t lo = c > opt.margin ? c - opt.margin : 0;
+      // The last coarse pixel also covers the odd pixels the pyramid dropped.
+      const std::uint32_t hi = c + 1 + opt.margin >= n ? full
+                                                       : (c + 1 + opt.margin) * scale;
+      return std::pair<std::uint32_t, std::uint32_t>{lo * scale, std::min(hi, full)};
+    };
+    for (std::uint32_t cy = 0; cy < coarse.height; ++cy) {
+      for (std::uint32_t cx = 0; cx < coarse.width; ++cx) {
+        if (lab.planes().a[cy * lab.planes().stride + cx] < opt.meat_min_a) continue;
+        const auto [x0, x1] = footprint(cx, coarse.width, rgb.width);
+        const auto [y0, y1] = footprint(cy, coarse.height, rgb.height);
+        for (std::uint32_t y = y0; y < y1; ++y) {
+          for (std::uint32_t x = x0; x < x1; ++x) map.insert(x / opt.tile, y / opt.tile);
+        }
+      }
+    }
+    return map;
+  }
+
+  static void expect_same_tiles(const RoiMap& got, const RoiMap& want) {
+    ASSERT_EQ(got.tiles_x(), want.tiles_x());
+    ASSERT_EQ(got.tiles_y(), want.tiles_y());
+    EXPECT_EQ(got.selected(), want.selected());
+    for (std::uint32_t ty = 0; ty < want.tiles_y(); ++ty) {
+      for (std::uint32_t tx = 0; tx < want.tiles_x(); ++tx) {
+        EXPECT_EQ(got.contains(tx, ty), want.contains(tx, ty)) << tx << ", " << ty;
+      }
+    }
+  }
+
+  const LabConverter conv_{LabMode::kExact};
+};
+
+TEST_F(RoiDetectorTest, MarksTheTilesAroundCoarseMeatPixels) {
+  for (const auto& [width, height] :
+       {std::pair{517u, 301u}, std::pair{640u, 360u}, std::pair{97u, 61u}}) {
+    const bench::SyntheticImage img = bench::make_carcass_image(width, height, 5, 0.4);
+    // Level 9 stops at the coarsest level the frame has.
+    for (const RoiOptions opt : {RoiOptions{.tile = 32}, RoiOptions{.tile = 24, .level = 2},
+                                 RoiOptions{.tile = 16, .level = 0, .margin = 0},
+                                 RoiOptions{.tile = 64, .level = 9, .margin = 5}}) {
+      SCOPED_TRACE(testing::Message() << width << "x" << height << ", tile " << opt.tile
+                                      << ", level " << opt.level);
+      RoiDetector detector(conv_, opt);
+      const RoiMap& got = detector.detect(img.view());
+      expect_same_tiles(got, reference(img.view(), opt));
+      EXPECT_GT(got.selected(), 0u);
+      if (opt.margin <= 2) {
+        EXPECT_LT(got.coverage(), 1.0);  // the belt either side is skipped
+      }
+    }
+  }
+}
+
+// The region holds all the meat, so segmenting only its tiles scores the
+// frame the same as segmenting all of it.
+TEST_F(RoiDetectorTest, SegmentingTheRegionMatchesTheFullFrame) {
+  const bench::SyntheticImage img = bench::make_carcass_image(517, 301, 8, 0.5);
+  WorkStealingPool pool(2);
+  const MarblingSegmenter seg(pool, conv_, {.tile = 32});
+  RoiDetector detector(conv_, {.tile = 32});
+  const RoiMap& roi = detector.detect(img.view());
+  const MarblingResult full = seg.segment(img.view());
+  const MarblingResult part = seg.segment(img.view(), roi);
+  EXPECT_EQ(part.fat_pixels, full.fat_pixels);
+  EXPECT_EQ(part.lean_pixels, full.lean_pixels);
+  EXPECT_EQ(part.fleck_count, full.fleck_count);
+  EXPECT_EQ(part.largest_fleck, full.largest_fleck);
+  EXPECT_EQ(part.tiles, roi.selected());
+  EXPECT_GT(part.skipped_tiles, 0u);
+}
+
+TEST_F(RoiDetectorTest, RejectsBadOptionsAndInputs) {
+  EXPECT_THROW(RoiDetector(conv_, {.tile = 0}), std::invalid_argument);
+  RoiDetector detector(conv_, {.tile = 16});
+  const bench::SyntheticImage img = bench::make_carcass_image(40, 30, 1);
+  ImageView gray = img.view();
+  gray.format = PixelFormat::kGray8;
+  EXPECT_THROW(detector.detect(gray), std::invalid_argument);
+
+  const RoiMap& empty = detector.detect(img.view().crop(0, 0, 0, 0));
+  EXPECT_EQ(empty.selected(), 0u);
+  EXPECT_EQ(empty.tiles_x(), 0u);
+  EXPECT_EQ(detector.detect(img.view()).width(), 40u);  // usable afterwards
+}
+
+}  // namespace
+}  // namespace meat_quality
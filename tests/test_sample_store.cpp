@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/core/sample_store.hpp"
+
+namespace meat_quality {
+namespace {
+
+SensorSample sample_at(Timestamp t) {
+  SensorSample s;
+  s.timestamp = t;
+  for (std::size_t c = 0; c < kChannelCount; ++c) {
+    s.values[c] = static_cast<float>(t) + 0.25f * static_cast<float>(c);
+  }
+  return s;
+}
+
+std::vector<Timestamp> timestamps_of(const WindowView& w) {
+  std::vector<Timestamp> out;
+  w.timestamps.for_each_segment([&](auto seg) { out.insert(out.end(), seg.begin(), seg.end()); });
+  return out;
+}
+
+TEST(SampleStore, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(SampleStore(1, 100).capacity(), 128u);
+  EXPECT_EQ(SampleStore(1, 0).capacity(), 1u);
+  EXPECT_THROW(SampleStore(0, 16), std::invalid_argument);
+}
+
+TEST(SampleStore, WrapsAndKeepsNewestSamples) {
+  SampleStore store(2, 8);
+  for (Timestamp t = 0; t < 13; ++t) ASSERT_TRUE(store.push(1, sample_at(t)));
+  EXPECT_EQ(store.size(0), 0u);
+  EXPECT_EQ(store.size(1), 8u);
+  EXPECT_EQ(store.total_pushed(1), 13u);
+  EXPECT_EQ(store.oldest_sequence(1), 5u);
+  EXPECT_EQ(store.newest(1), 12);
+
+  const WindowView all = store.window(1, 0);
+  EXPECT_FALSE(all.timestamps.second.empty());  // the run wraps the ring
+  EXPECT_EQ(timestamps_of(all), (std::vector<Timestamp>{5, 6, 7, 8, 9, 10, 11, 12}));
+  for (std::size_t i = 0; i < all.size(); ++i) {
+    EXPECT_EQ(all.sample(i).values[3], static_cast<float>(all.timestamps[i]) + 0.75f);
+  }
+}
+
+TEST(SampleStore, WindowLatestAndSequenceViews) {
+  SampleStore store(1, 8);
+  for (Timestamp t = 0; t < 11; ++t) store.push(0, sample_at(t * 10));
+  EXPECT_EQ(timestamps_of(store.window(0, 75)), (std::vector<Timestamp>{80, 90, 100}));
+  EXPECT_EQ(timestamps_of(store.window(0, 80)), (std::vector<Timestamp>{80, 90, 100}));
+  EXPECT_TRUE(store.window(0, 101).empty());
+  EXPECT_EQ(timestamps_of(store.latest(0, 2)), (std::vector<Timestamp>{90, 100}));
+  EXPECT_EQ(store.latest(0, 50).size(), 8u);
+  EXPECT_EQ(timestamps_of(store.since_sequence(0, 9)), (std::vector<Timestamp>{90, 100}));
+  EXPECT_EQ(store.since_sequence(0, 0).size(), 8u);  // overwritten: starts at the oldest held
+  EXPECT_TRUE(store.since_sequence(0, 11).empty());
+}
+
+TEST(SampleStore, RejectsOutOfOrderSamples) {
+  SampleStore store(1, 8);
+  ASSERT_TRUE(store.push(0, sample_at(10)));
+  EXPECT_FALSE(store.push(0, sample_at(9)));
+  EXPECT_TRUE(store.push(0, sample_at(10)));
+
+  const Timestamp ts[] = {11, 5, 12};
+  std::vector<float> column = {1, 2, 3};
+  std::array<const float*, kChannelCount> columns;
+  columns.fill(column.data());
+  EXPECT_EQ(store.push_columns(0, ts, columns, 3), 2u);
+  EXPECT_EQ(timestamps_of(store.window(0, 0)), (std::vector<Timestamp>{10, 10, 11, 12}));
+  EXPECT_EQ(store.window(0, 12).channels[0][0], 3.0f);
+}
+
+}  // namespace
+}  // namespace meat_quality
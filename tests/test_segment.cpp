@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/storage/segment.hpp"
+#include "synthetic_trace.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr NodeId kNodes = 3;
+constexpr std::uint32_t kBlockSamples = 64;
+
+// Writes a few blocks per node, with a NaN and a repeated value pattern so
+// every float encoding branch is exercised, and returns what was accepted.
+std::vector<std::vector<SensorSample>> write_segment(const std::string& path) {
+  bench::TraceGenerator gen(3);
+  std::vector<std::vector<SensorSample>> written(kNodes);
+  SegmentWriter w(path, kBlockSamples);
+  for (std::uint64_t t = 0; t < 300; ++t) {
+    for (NodeId n = 0; n < kNodes; ++n) {
+      SensorSample s = gen.sample(n, t);
+      if (t % 50 == 7) s[Channel::kPh] = std::nanf("");
+      if (t % 10 < 3) s[Channel::kHumidity] = 90.0f;
+      if (w.append(n, s)) written[n].push_back(s);
+    }
+  }
+  w.finish();
+  return written;
+}
+
+bool same_bits(float a, float b) {
+  return std::memcmp(&a, &b, sizeof a) == 0;
+}
+
+// Opens and fully scans a possibly damaged segment. It must either be
+// rejected or decode without touching memory outside the file.
+void open_and_scan(const std::string& path) {
+  try {
+    const SegmentReader r(path);
+    for (NodeId n = 0; n <= kNodes; ++n) {
+      r.scan({.node = n, .range = std::nullopt}, [](const DecodedBlock& b) {
+        float sum = 0;
+        for (std::size_t i = 0; i < b.size(); ++i) sum += b.channels[0][i];
+        (void)sum;
+      });
+    }
+  } catch (const std::system_error&) {
+  } catch (const std::runtime_error&) {
+  }
+}
+
+TEST(Segment, RoundTripsEverySampleBitExact) {
+  const test::TempDir dir;
+  const std::string path = dir.file("a.seg");
+  const auto written = write_segment(path);
+  const SegmentReader r(path);
+  for (NodeId n = 0; n < kNodes; ++n) {
+    std::size_t i = 0;
+    r.scan({.node = n, .range = std::nullopt}, [&](const DecodedBlock& b) {
+      for (std::size_t j = 0; j < b.size(); ++j, ++i) {
+        ASSERT_LT(i, written[n].size());
+        EXPECT_EQ(b.timestamps[j], written[n][i].timestamp);
+        for (std::size_t c = 0; c < kChannelCount; ++c) {
+          EXPECT_TRUE(same_bits(b.channels[c][j], written[n][i].values[c]))
+              << "node " << n << " sample " << i << " channel " << c;
+        }
+      }
+    });
+    EXPECT_EQ(i, written[n].size());
+  }
+}
+
+TEST(Segment, ScanTrimsToTimeRange) {
+  const test::TempDir dir;
+  const std::string path = dir.file("a.seg");
+  const auto written = write_segment(path);
+  const SegmentReader r(path);
+  const Timestamp from = written[1][100].timestamp, to = written[1][199].timestamp;
+  std::vector<Timestamp> seen;
+  const SegmentQuery q = {.node = 1, .from = from, .to = to, .range = std::nullopt};
+  const ScanStats stats = r.scan(q, [&](const DecodedBlock& b) {
+    seen.insert(seen.end(), b.timestamps.begin(), b.timestamps.end());
+  });
+  ASSERT_EQ(seen.size(), 100u);
+  EXPECT_EQ(seen.front(), from);
+  EXPECT_EQ(seen.back(), to);
+  EXPECT_EQ(stats.samples, 100u);
+}
+
+TEST(Segment, RejectsOrSurvivesTruncationAndBitFlips) {
+  const test::TempDir dir;
+  const std::string path = dir.file("a.seg");
+  write_segment(path);
+  const std::vector<std::uint8_t> bytes = test::read_file(path);
+  const std::string damaged_path = dir.file("damaged.seg");
+  test::for_each_corruption(bytes, [&](const std::vector<std::uint8_t>& damaged) {
+    test::write_file(damaged_path, damaged);
+    open_and_scan(damaged_path);
+  });
+}
+
+TEST(Segment, AcceptsSparseClusterWideNodeIds) {
+  const test::TempDir dir;
+  const std::string path = dir.file("a.seg");
+  constexpr NodeId kFar = 0xFFFFFFF0;
+  bench::TraceGenerator gen(4);
+  {
+    SegmentWriter w(path, kBlockSamples);
+    for (std::uint64_t t = 0; t < 100; ++t) {
+      ASSERT_TRUE(w.append(kFar, gen.sample(kFar, t)));
+      ASSERT_TRUE(w.append(7, gen.sample(7, t)));
+    }
+    w.finish();
+  }
+  const SegmentReader r(path);
+  ASSERT_EQ(r.blocks().size(), 4u);
+  EXPECT_EQ(r.blocks().front().node, 7u);
+  EXPECT_EQ(r.blocks().back().node, kFar);
+  EXPECT_EQ(r.scan({.node = kFar, .range = std::nullopt}, [](const DecodedBlock&) {}).samples,
+            100u);
+}
+
+TEST(Segment, BlockRangesCoverFiniteReadingsOnly) {
+  const test::TempDir dir;
+  const std::string path = dir.file("a.seg");
+  {
+    SegmentWriter w(path, kBlockSamples);
+    for (std::uint32_t i = 0; i < kBlockSamples; ++i) {
+      SensorSample s;
+      s.timestamp = Timestamp{i} * bench::kTickMicros;
+      s.values.fill(5.0f + static_cast<float>(i % 4));
+      // The block's first pH reading is a dropout, and H2S never reports.
+      if (i == 0) s[Channel::kPh] = std::nanf("");
+      if (i == 9) s[Channel::kPh] = INFINITY;
+      s[Channel::kH2s] = std::nanf("");
+      ASSERT_TRUE(w.append(0, s));
+    }
+    w.finish();
+  }
+  const SegmentReader r(path);
+  ASSERT_EQ(r.blocks().size(), 1u);
+  const segment::BlockEntry& e = r.blocks()[0];
+  EXPECT_EQ(e.min[index_of(Channel::kPh)], 5.0f);
+  EXPECT_EQ(e.max[index_of(Channel::kPh)], 8.0f);
+  EXPECT_TRUE(std::isnan(e.min[index_of(Channel::kH2s)]));
+  EXPECT_TRUE(std::isnan(e.max[index_of(Channel::kH2s)]));
+
+  const auto blocks_kept = [&](Channel c, float lo, float hi) {
+    const SegmentQuery q = {.node = 0, .range = ValueRange{c, lo, hi}};
+    return r.scan(q, [](const DecodedBlock&) {}).blocks_considered -
+           r.scan(q, [](const DecodedBlock&) {}).blocks_skipped;
+  };
+  EXPECT_EQ(blocks_kept(Channel::kPh, 6.0f, 7.0f), 1u);
+  EXPECT_EQ(blocks_kept(Channel::kPh, 9.0f, 10.0f), 0u);  // was kept when seeded from NaN
+  EXPECT_EQ(blocks_kept(Channel::kH2s, 0.0f, 1.0f), 1u);  // unknown, so never skipped
+}
+
+// Rewrites index entry `i` of the segment at `path` with `edit`.
+void edit_entry(const std::string& path, std::size_t i,
+                const std::function<void(segment::BlockEntry&)>& edit) {
+  std::vector<std::uint8_t> bytes = test::read_file(path);
+  segment::Trailer trailer;
+  std::memcpy(&trailer, bytes.data() + bytes.size() - sizeof trailer, sizeof trailer);
+  std::uint8_t* at = bytes.data() + trailer.index_offset + i * sizeof(segment::BlockEntry);
+  segment::BlockEntry e;
+  std::memcpy(&e, at, sizeof e);
+  edit(e);
+  std::memcpy(at, &e, sizeof e);
+  test::write_file(path, bytes);
+}
+
+TEST(Segment, RejectsInconsistentIndexEntries) {
+  struct Edit {
+    std::size_t entry;
+    std::function<void(segment::BlockEntry&)> fn;
+  };
+  const std::vector<Edit> edits = {
+      {0, [](segment::BlockEntry& e) { e.count = 0; }},
+      {0, [](segment::BlockEntry& e) { e.count = kBlockSamples + 1; }},
+      {0, [](segment::BlockEntry& e) { e.offset = ~std::uint64_t{0} - 8; }},
+      {0, [](segment::BlockEntry& e) { e.bytes = ~std::uint32_t{0}; }},
+      {0, [](segment::BlockEntry& e) { e.column_offset[3] = e.bytes; }},
+      {0, [](segment::BlockEntry& e) { e.column_offset[2] = e.column_offset[1]; }},
+      {0, [](segment::BlockEntry& e) { e.t_max = e.t_min - 1; }},
+      {0, [](segment::BlockEntry& e) { e.node = kNodes + 5; }},  // breaks the node order
+      {1, [](segment::BlockEntry& e) { e.t_min -= kMicrosPerHour; }},  // overlaps block 0
+  };
+  const test::TempDir dir;
+  for (std::size_t k = 0; k < edits.size(); ++k) {
+    const std::string path = dir.file(std::to_string(k) + ".seg");
+    write_segment(path);
+    edit_entry(path, edits[k].entry, edits[k].fn);
+    EXPECT_THROW(SegmentReader{path}, std::runtime_error) << "edit " << k;
+  }
+}
+
+}  // namespace
+}  // namespace meat_quality
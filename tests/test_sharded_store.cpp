@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "meat_quality/cluster/shard_map.hpp"
+#include "meat_quality/cluster/sharded_store.hpp"
+#include "synthetic_trace.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr std::uint32_t kShards = 16;
+constexpr NodeId kNodes = 64;
+constexpr std::uint64_t kTicks = 200;
+
+ShardMap map_of(std::initializer_list<MemberId> members, std::uint64_t epoch) {
+  std::vector<RingMember> ring;
+  for (const MemberId m : members) ring.push_back({m, 1});
+  return ShardMap::build(ring, epoch, kShards);
+}
+
+// Same FNV-1a as the blob trailer, to re-seal a payload edited on purpose.
+void reseal(std::vector<std::uint8_t>& blob) {
+  const std::size_t body = blob.size() - sizeof(std::uint64_t) - 8;
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  for (std::size_t i = 0; i < body; ++i) h = (h ^ blob[i]) * 0x100000001b3ull;
+  std::memcpy(blob.data() + body, &h, sizeof h);
+}
+
+// Header fields of a blob: shard at byte 8, epoch at 16, node count at 24.
+ShardId shard_in(const std::vector<std::uint8_t>& blob) {
+  ShardId shard;
+  std::memcpy(&shard, blob.data() + 8, sizeof shard);
+  return shard;
+}
+
+std::vector<std::uint8_t> with_epoch(std::vector<std::uint8_t> blob, std::uint64_t epoch) {
+  std::memcpy(blob.data() + 16, &epoch, sizeof epoch);
+  reseal(blob);
+  return blob;
+}
+
+// Member 0 owns every shard and has samples for every node; member 1 then
+// joins and member 0 exports the shards that moved.
+class ShardedStoreTest : public ::testing::Test {
+ protected:
+  ShardedStoreTest() : old_owner_(0, kNodes, 256, kShards) {
+    old_owner_.apply(map_of({0}, 1));
+    bench::TraceGenerator gen(4);
+    for (std::uint64_t t = 0; t < kTicks; ++t) {
+      for (NodeId n = 0; n < kNodes; ++n) {
+        const SensorSample s = gen.sample(n, t);
+        EXPECT_EQ(old_owner_.push(n, s), ShardPush::kStored);
+        pushed_.push_back({n, s});
+      }
+    }
+    const Rebalance plan = old_owner_.apply(joined_);
+    for (const ShardId s : plan.outgoing) {
+      std::vector<std::uint8_t> blob = old_owner_.export_shard(s);
+      if (blob.size() > largest_.size()) largest_ = blob;
+      blobs_.push_back(std::move(blob));
+    }
+  }
+
+  ShardedSampleStore new_owner() const {
+    ShardedSampleStore store(1, kNodes, 256, kShards);
+    store.apply(map_of({0}, 1));
+    store.apply(joined_);
+    return store;
+  }
+
+  struct Pushed {
+    NodeId node;
+    SensorSample sample;
+  };
+
+  ShardMap joined_ = map_of({0, 1}, 2);
+  ShardedSampleStore old_owner_;
+  std::vector<Pushed> pushed_;
+  std::vector<std::vector<std::uint8_t>> blobs_;
+  std::vector<std::uint8_t> largest_;
+};
+
+TEST_F(ShardedStoreTest, MigratesMovedShardsBitExact) {
+  ASSERT_FALSE(blobs_.empty());
+  ShardedSampleStore store = new_owner();
+  // A sample that reached the new owner before the export is kept after it.
+  NodeId early = 0;
+  while (joined_.owner_of(early) != 1) ++early;
+  SensorSample late;
+  late.timestamp = static_cast<Timestamp>(kTicks) * bench::kTickMicros;
+  late.values.fill(7.0f);
+  ASSERT_EQ(store.push(early, late), ShardPush::kStored);
+
+  std::size_t samples = 0;
+  for (const auto& blob : blobs_) samples += store.import_shard(blob).samples;
+
+  std::size_t moved = 0;
+  for (const Pushed& p : pushed_) moved += joined_.owner_of(p.node) == 1;
+  EXPECT_EQ(samples, moved + 1);
+  for (NodeId n = 0; n < kNodes; ++n) {
+    if (joined_.owner_of(n) != 1) continue;
+    EXPECT_EQ(old_owner_.slot_of(n), ShardedSampleStore::kNoSlot) << n;
+    const NodeId slot = store.slot_of(n);
+    ASSERT_NE(slot, ShardedSampleStore::kNoSlot) << n;
+    const WindowView w = store.store().window(slot, 0);
+    ASSERT_EQ(w.size(), kTicks + (n == early ? 1 : 0)) << n;
+    std::size_t i = 0;
+    for (const Pushed& p : pushed_) {
+      if (p.node != n) continue;
+      const SensorSample got = w.sample(i++);
+      EXPECT_EQ(got.timestamp, p.sample.timestamp);
+      EXPECT_EQ(std::memcmp(got.values.data(), p.sample.values.data(), sizeof got.values), 0);
+    }
+    if (n == early) {
+      EXPECT_EQ(w.sample(i).values[0], 7.0f);
+    }
+  }
+}
+
+TEST_F(ShardedStoreTest, RejectsBlobsForShardsNotOwned) {
+  ShardedSampleStore store(0, kNodes, 256, kShards);
+  store.apply(joined_);
+  EXPECT_THROW(store.import_shard(largest_), std::invalid_argument);
+}
+
+TEST_F(ShardedStoreTest, RejectsBlobsFromAMapNotYetApplied) {
+  ASSERT_FALSE(largest_.empty());
+  const std::vector<std::uint8_t> ahead = with_epoch(largest_, joined_.epoch() + 1);
+  ShardedSampleStore store = new_owner();
+  EXPECT_THROW(store.import_shard(ahead), std::invalid_argument);
+  EXPECT_EQ(store.node_count(), 0u);
+  // Once the importer catches up the same blob is accepted.
+  store.apply(map_of({0, 1}, joined_.epoch() + 1));
+  EXPECT_GT(store.import_shard(ahead).nodes, 0u);
+}
+
+TEST_F(ShardedStoreTest, RejectsBlobsOlderThanTheLastTransfer) {
+  ASSERT_FALSE(largest_.empty());
+  ShardedSampleStore store = new_owner();
+  // Exported before this member took the shard over: not meant for it.
+  EXPECT_THROW(store.import_shard(with_epoch(largest_, joined_.epoch() - 1)),
+               std::invalid_argument);
+  EXPECT_EQ(store.node_count(), 0u);
+
+  // An unrelated map change does not make the real transfer stale.
+  store.apply(map_of({0, 1}, joined_.epoch() + 1));
+  ASSERT_GT(store.import_shard(largest_).nodes, 0u);
+  // A later transfer of the same shard makes the earlier one stale.
+  EXPECT_THROW(store.import_shard(with_epoch(largest_, joined_.epoch() - 1)),
+               std::invalid_argument);
+  EXPECT_NO_THROW(store.import_shard(with_epoch(largest_, joined_.epoch() + 1)));
+  EXPECT_THROW(store.import_shard(largest_), std::invalid_argument);
+}
+
+TEST_F(ShardedStoreTest, RunningOutOfSlotsLeavesTheStoreUnchanged) {
+  ASSERT_FALSE(largest_.empty());
+  const ShardId shard = shard_in(largest_);
+  NodeId mine = 0;
+  while (shard_of(mine, kShards) != shard) ++mine;
+  ShardedSampleStore store(1, 2, 256, kShards);
+  store.apply(map_of({0}, 1));
+  store.apply(joined_);
+  SensorSample early;
+  early.timestamp = static_cast<Timestamp>(kTicks) * bench::kTickMicros;
+  early.values.fill(7.0f);
+  ASSERT_EQ(store.push(mine, early), ShardPush::kStored);
+
+  // The blob's other nodes need more than the one slot left.
+  std::uint32_t nodes;
+  std::memcpy(&nodes, largest_.data() + 24, sizeof nodes);
+  ASSERT_GE(nodes, 3u);
+  EXPECT_THROW(store.import_shard(largest_), std::runtime_error);
+  EXPECT_EQ(store.node_count(), 1u);
+  const WindowView w = store.store().window(store.slot_of(mine), 0);
+  ASSERT_EQ(w.size(), 1u);
+  EXPECT_EQ(w.sample(0).values[0], 7.0f);
+  // Nothing was claimed, so the freed slot is still there for a push.
+  NodeId other = mine + 1;
+  while (joined_.owner_of(other) != 1 || shard_of(other, kShards) == shard) ++other;
+  EXPECT_EQ(store.push(other, early), ShardPush::kStored);
+}
+
+TEST_F(ShardedStoreTest, RejectsTruncatedAndDamagedBlobs) {
+  ASSERT_FALSE(largest_.empty());
+  const std::size_t sealed = largest_.size() - 8;  // the zero padding is not checked
+  test::for_each_corruption(largest_, [&](const std::vector<std::uint8_t>& damaged) {
+    const bool intact = damaged.size() == largest_.size() &&
+                        std::memcmp(damaged.data(), largest_.data(), sealed) == 0;
+    ShardedSampleStore store = new_owner();
+    if (intact) {
+      EXPECT_NO_THROW(store.import_shard(damaged));
+    } else {
+      EXPECT_THROW(store.import_shard(damaged), std::invalid_argument);
+    }
+  });
+}
+
+// A blob whose checksum matches a damaged payload, as a buggy exporter
+// would produce: import must reject it or decode garbage, nothing worse.
+TEST_F(ShardedStoreTest, SurvivesResealedDamagedPayloads) {
+  ASSERT_FALSE(largest_.empty());
+  test::for_each_corruption(largest_, [&](std::vector<std::uint8_t> damaged) {
+    if (damaged.size() != largest_.size()) return;
+    reseal(damaged);
+    ShardedSampleStore store = new_owner();
+    try {
+      const ShardImport r = store.import_shard(damaged);
+      EXPECT_LE(r.nodes, static_cast<std::size_t>(kNodes));
+    } catch (const std::invalid_argument&) {
+    }
+  }, 2000);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "meat_quality/storage/snapshot.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr std::uint32_t kLutGrid = 9;
+
+std::vector<FeatureVector> feature_vectors(std::size_t n) {
+  std::mt19937_64 rng(5);
+  std::normal_distribution<float> normal(0.0f, 2.0f);
+  std::vector<FeatureVector> out(n);
+  for (FeatureVector& v : out) {
+    for (float& x : v) x = normal(rng);
+  }
+  return out;
+}
+
+std::vector<NodeCalibration> calibration_table() {
+  std::vector<NodeCalibration> table(5, NodeCalibration::identity());
+  for (std::size_t n = 0; n < table.size(); ++n) {
+    table[n].gain[1] = 1.0f + 0.01f * static_cast<float>(n);
+    table[n].offset[3] = -0.5f * static_cast<float>(n);
+  }
+  return table;
+}
+
+bool same_prediction(const Prediction& a, const Prediction& b) {
+  return a.label == b.label &&
+         std::memcmp(a.probabilities.data(), b.probabilities.data(), sizeof a.probabilities) == 0;
+}
+
+class SnapshotTest : public ::testing::Test {
+ protected:
+  SnapshotTest()
+      : classifier_(ClassifierWeights::random(16, 2)),
+        lab_(LabMode::kLut, kLutGrid),
+        calibration_(calibration_table()),
+        path_(dir_.file("startup.snap")) {
+    write_snapshot(path_, {&classifier_, &lab_, calibration_});
+  }
+
+  test::TempDir dir_;
+  FreshnessClassifier classifier_;
+  LabConverter lab_;
+  std::vector<NodeCalibration> calibration_;
+  std::string path_;
+};
+
+TEST_F(SnapshotTest, RoundTripsEverySection) {
+  const Snapshot snap(path_);
+  const FreshnessClassifier mapped = snap.classifier();
+  for (const FeatureVector& v : feature_vectors(32)) {
+    EXPECT_TRUE(same_prediction(mapped.predict(v), classifier_.predict(v)));
+  }
+  const LabConverter mapped_lab = snap.lab_converter();
+  for (int r = 0; r < 256; r += 15) {
+    for (int g = 0; g < 256; g += 15) {
+      const Lab want = lab_.convert(static_cast<std::uint8_t>(r), static_cast<std::uint8_t>(g), 40);
+      const Lab got =
+          mapped_lab.convert(static_cast<std::uint8_t>(r), static_cast<std::uint8_t>(g), 40);
+      EXPECT_EQ(std::memcmp(&want, &got, sizeof want), 0);
+    }
+  }
+  ASSERT_EQ(snap.calibration().size(), calibration_.size());
+  EXPECT_EQ(std::memcmp(snap.calibration().data(), calibration_.data(),
+                        calibration_.size() * sizeof(NodeCalibration)),
+            0);
+}
+
+TEST_F(SnapshotTest, RejectsOrSurvivesTruncationAndBitFlips) {
+  const std::vector<std::uint8_t> bytes = test::read_file(path_);
+  const std::string damaged_path = dir_.file("damaged.snap");
+  const std::vector<FeatureVector> inputs = feature_vectors(4);
+  test::for_each_corruption(bytes, [&](const std::vector<std::uint8_t>& damaged) {
+    test::write_file(damaged_path, damaged);
+    try {
+      const Snapshot snap(damaged_path);
+      const FreshnessClassifier c = snap.classifier();
+      for (const FeatureVector& v : inputs) (void)c.predict(v);
+      const LabConverter lab = snap.lab_converter();
+      (void)lab.convert(255, 255, 255);
+      float sum = 0;
+      for (const NodeCalibration& cal : snap.calibration()) sum += cal.gain[0];
+      (void)sum;
+    } catch (const std::system_error&) {
+    } catch (const std::runtime_error&) {
+    } catch (const std::invalid_argument&) {
+    }
+  });
+}
+
+TEST_F(SnapshotTest, ReportsIoFailuresAsSystemErrors) {
+  try {
+    const Snapshot snap(dir_.file("missing.snap"));
+    ADD_FAILURE() << "opened a missing file";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), std::errc::no_such_file_or_directory);
+  }
+  EXPECT_THROW(write_snapshot(dir_.file("missing/startup.snap"), {&classifier_, nullptr, {}}),
+               std::system_error);
+
+  // A readable file that is not a snapshot is a format error, not an I/O one.
+  const std::string garbage = dir_.file("garbage.snap");
+  test::write_file(garbage, std::vector<std::uint8_t>(4096, 0x5a));
+  try {
+    const Snapshot snap(garbage);
+    ADD_FAILURE() << "accepted a file of garbage";
+  } catch (const std::system_error&) {
+    ADD_FAILURE() << "reported a format error as an I/O error";
+  } catch (const std::runtime_error&) {
+  }
+}
+
+TEST_F(SnapshotTest, RejectsSectionsOutsideTheFile) {
+  std::vector<std::uint8_t> bytes = test::read_file(path_);
+  snapshot::Section s;
+  std::uint8_t* first = bytes.data() + sizeof(snapshot::FileHeader);
+  std::memcpy(&s, first, sizeof s);
+  s.offset = ~std::uint64_t{0} - 63;  // cache-line aligned, wraps with bytes added
+  std::memcpy(first, &s, sizeof s);
+  const std::string damaged_path = dir_.file("damaged.snap");
+  test::write_file(damaged_path, bytes);
+  EXPECT_THROW(Snapshot{damaged_path}, std::runtime_error);
+}
+
+}  // namespace
+}  // namespace meat_quality
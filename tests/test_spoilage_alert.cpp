@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+#include "meat_quality/features/spoilage_alert.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr Timestamp kTick = 100'000;  // 10 Hz
+
+// Steady readings below every limit.
+SensorSample steady(Timestamp t) {
+  SensorSample s;
+  s.timestamp = t;
+  s.values = {1.0f, 0.1f, 100.0f, 3.0f, 80.0f, 6.0f};
+  return s;
+}
+
+class AlertEvaluatorTest : public ::testing::Test {
+ protected:
+  explicit AlertEvaluatorTest(const AlertOptions& options = {}) : evaluator_(4, options) {}
+
+  std::size_t feed(NodeId node, const SensorSample& s) {
+    const std::size_t n = evaluator_.update(node, s, raised_);
+    alerts_.insert(alerts_.end(), raised_.begin(), raised_.begin() + static_cast<std::ptrdiff_t>(n));
+    return n;
+  }
+
+  AlertEvaluator evaluator_;
+  std::array<SpoilageAlert, AlertEvaluator::kMaxAlertsPerSample> raised_;
+  std::vector<SpoilageAlert> alerts_;
+};
+
+// A step this steep would also raise rise alerts; leave only the limits.
+AlertOptions limits_only() {
+  AlertOptions o;
+  o.max_rise.fill(AlertOptions::kNoLimit);
+  return o;
+}
+
+class LimitAlertTest : public AlertEvaluatorTest {
+ protected:
+  LimitAlertTest() : AlertEvaluatorTest(limits_only()) {}
+};
+
+TEST_F(LimitAlertTest, NeedsConfirmationAndRearmsOnTheSmoothedLevel) {
+  Timestamp t = 0;
+  for (int i = 0; i < 20; ++i) feed(1, steady(t += kTick));
+  SensorSample breach = steady(0);
+  breach[Channel::kTemperature] = 12.0f;
+  breach.timestamp = t += kTick;
+  EXPECT_EQ(feed(1, breach), 0u);  // one reading could be a glitch
+  breach.timestamp = t += kTick;
+  ASSERT_EQ(feed(1, breach), 1u);
+  EXPECT_EQ(alerts_[0].node, 1u);
+  EXPECT_EQ(alerts_[0].channel, Channel::kTemperature);
+  EXPECT_EQ(alerts_[0].kind, AlertKind::kLimit);
+  EXPECT_EQ(alerts_[0].value, 12.0f);
+  EXPECT_EQ(alerts_[0].at, t);
+  // EWMA (alpha 0.3) of 3, 12, 12 and the slope of the window's fit.
+  EXPECT_NEAR(alerts_[0].level, 5.7f + 0.3f * (12.0f - 5.7f), 1e-4f);
+  EXPECT_GT(alerts_[0].rise_per_min, 0.0f);
+
+  // Still over the limit: no repeat. One low reading leaves the smoothed
+  // level above the rearm threshold, so the next breach stays quiet.
+  breach.timestamp = t += kTick;
+  EXPECT_EQ(feed(1, breach), 0u);
+  EXPECT_EQ(feed(1, steady(t += kTick)), 0u);
+  breach.timestamp = t += kTick;
+  EXPECT_EQ(feed(1, breach), 0u);
+  breach.timestamp = t += kTick;
+  EXPECT_EQ(feed(1, breach), 0u);
+
+  // Once the level has settled, a new breach alerts again.
+  for (int i = 0; i < 10; ++i) feed(1, steady(t += kTick));
+  for (int i = 0; i < 2; ++i) {
+    breach.timestamp = t += kTick;
+    feed(1, breach);
+  }
+  EXPECT_EQ(alerts_.size(), 2u);
+}
+
+TEST_F(AlertEvaluatorTest, RiseFiresOnTheWindowSlope) {
+  Timestamp t = 0;
+  for (int i = 0; i < 50; ++i) feed(0, steady(t += kTick));
+  ASSERT_TRUE(alerts_.empty());
+  // NH3 climbing 3 ppm per minute, well below its 10 ppm limit.
+  SensorSample s = steady(0);
+  for (int i = 0; i < 100 && alerts_.empty(); ++i) {
+    s.timestamp = t += kTick;
+    s[Channel::kNh3] += 3.0f / 600.0f;
+    feed(0, s);
+  }
+  ASSERT_EQ(alerts_.size(), 1u);
+  EXPECT_EQ(alerts_[0].channel, Channel::kNh3);
+  EXPECT_EQ(alerts_[0].kind, AlertKind::kRise);
+  EXPECT_GE(alerts_[0].rise_per_min, 2.0f);
+  EXPECT_LT(alerts_[0].value, 10.0f);
+}
+
+TEST_F(AlertEvaluatorTest, IgnoresStaleSamplesUnknownNodesAndNaN) {
+  SensorSample s = steady(10 * kTick);
+  s[Channel::kH2s] = 5.0f;
+  EXPECT_EQ(feed(4, s), 0u);
+  EXPECT_EQ(feed(2, s), 0u);
+  EXPECT_EQ(feed(2, s), 0u);  // same timestamp: not newer
+  s.timestamp -= kTick;
+  EXPECT_EQ(feed(2, s), 0u);
+  s.timestamp = 11 * kTick;
+  s[Channel::kH2s] = std::nanf("");
+  EXPECT_EQ(feed(2, s), 0u);  // a gap does not break the run...
+  s.timestamp = 12 * kTick;
+  s[Channel::kH2s] = 5.0f;
+  EXPECT_EQ(feed(2, s), 1u);  // ...the second finite reading over the limit confirms it
+
+  evaluator_.reset(2);
+  s.timestamp = kTick;  // accepted again after a reset, with a fresh run
+  EXPECT_EQ(feed(2, s), 0u);
+  s.timestamp = 2 * kTick;
+  EXPECT_EQ(feed(2, s), 1u);
+}
+
+TEST(AlertLane, CalibratesFromTheRegistry) {
+  NodeRecord record;
+  record.node = 2;
+  record.calibration.gain[index_of(Channel::kTemperature)] = 3.0f;  // 3 °C reads as 9 °C
+  const NodeRegistry registry({record});
+
+  std::mutex mutex;
+  std::vector<SpoilageAlert> alerts;
+  AlertLaneOptions options;
+  options.node_count = 8;
+  options.registry = &registry;
+  AlertLane lane(
+      [&](const SpoilageAlert& a) {
+        const std::lock_guard lock(mutex);
+        alerts.push_back(a);
+      },
+      options);
+  lane.start();
+  for (Timestamp t = 1; t <= 5; ++t) {
+    for (NodeId node : {1u, 2u}) ASSERT_TRUE(lane.push({node, steady(t * kTick)}));
+  }
+  lane.stop();
+
+  ASSERT_EQ(alerts.size(), 1u);
+  EXPECT_EQ(alerts[0].node, 2u);
+  EXPECT_EQ(alerts[0].channel, Channel::kTemperature);
+  EXPECT_FLOAT_EQ(alerts[0].value, 9.0f);
+  const AlertLaneStats stats = lane.stats();
+  EXPECT_EQ(stats.samples, 10u);
+  EXPECT_EQ(stats.alerts, 1u);
+  EXPECT_EQ(stats.dropped, 0u);
+}
+
+}  // namespace
+}  // namespace meat_quality
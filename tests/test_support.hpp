@@ -0,0 +1,97 @@
+#pragma once
+
+// Helpers shared by the unit tests: scratch files, deterministic
+// corruptions of encoded data for the decoder robustness tests, and a
+// fixture that runs a check at every SIMD level.
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "meat_quality/core/simd.hpp"
+
+namespace meat_quality::test {
+
+/// Directory removed with everything in it when the object goes away.
+class TempDir {
+ public:
+  TempDir() {
+    static int counter = 0;
+    path_ = std::filesystem::temp_directory_path() /
+            ("meat_quality_test_" + std::to_string(::getpid()) + "_" + std::to_string(counter++));
+    std::filesystem::create_directories(path_);
+  }
+  ~TempDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+  }
+  TempDir(const TempDir&) = delete;
+  TempDir& operator=(const TempDir&) = delete;
+
+  std::string file(const std::string& name) const { return (path_ / name).string(); }
+
+ private:
+  std::filesystem::path path_;
+};
+
+inline std::vector<std::uint8_t> read_file(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+inline void write_file(const std::string& path, const std::vector<std::uint8_t>& bytes) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+}
+
+/// Calls `fn(damaged)` with truncations of `bytes` (every length for small
+/// inputs, an even spread of them for large ones) and then `flips` copies
+/// with a few random bits flipped, always the same ones for a given seed.
+template <typename Fn>
+void for_each_corruption(const std::vector<std::uint8_t>& bytes, Fn&& fn,
+                         std::size_t flips = 500, std::uint64_t seed = 1) {
+  const std::size_t step = bytes.size() / 512 + 1;
+  for (std::size_t n = 0; n < bytes.size(); n += step) {
+    fn(std::vector<std::uint8_t>(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(n)));
+  }
+  if (bytes.empty()) return;
+  std::mt19937_64 rng(seed);
+  for (std::size_t k = 0; k < flips; ++k) {
+    std::vector<std::uint8_t> damaged = bytes;
+    for (std::size_t f = 0; f <= k % 4; ++f) {
+      damaged[rng() % damaged.size()] ^= static_cast<std::uint8_t>(1u << (rng() % 8));
+    }
+    fn(damaged);
+  }
+}
+
+/// Runs checks at every SIMD level this build and CPU support, restoring
+/// the active level afterwards.
+class EachSimdLevel : public ::testing::Test {
+ protected:
+  ~EachSimdLevel() override { set_simd_level(saved_); }
+
+  template <typename Fn>
+  void for_each_level(Fn&& fn) {
+    for (const SimdLevel level :
+         {SimdLevel::kScalar, SimdLevel::kAvx2, SimdLevel::kAvx512, SimdLevel::kNeon}) {
+      if (!set_simd_level(level)) continue;
+      SCOPED_TRACE(simd_level_name(level));
+      fn();
+    }
+  }
+
+ private:
+  SimdLevel saved_ = active_simd_level();
+};
+
+}  // namespace meat_quality::test
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <latch>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/telemetry/c_api.h"
+#include "meat_quality/telemetry/telemetry.hpp"
+#include "synthetic_trace.hpp"
+
+namespace meat_quality {
+namespace {
+
+using namespace telemetry;
+
+// The telemetry is process-wide and other tests grade too, so every check
+// compares against a snapshot taken just before.
+std::uint64_t stage_count(Stage s) { return snapshot()[s].count; }
+
+TEST(Histogram, BucketsTileTheRangeWithinOneThirtySecond) {
+  for (std::size_t b = 0; b < kBucketCount; ++b) {
+    const std::uint64_t lo = bucket_lower(b), width = bucket_width(b);
+    ASSERT_EQ(bucket_of(lo), b);
+    ASSERT_EQ(bucket_of(lo + width - 1), b);
+    if (b + 1 < kBucketCount) {
+      ASSERT_EQ(bucket_lower(b + 1), lo + width) << b;
+    }
+    if (b >= kSubBuckets) {
+      ASSERT_LE(width * kSubBuckets, lo) << b;
+    }
+  }
+  EXPECT_EQ(bucket_of(0), 0u);
+  EXPECT_EQ(bucket_of(std::uint64_t{1} << (kMaxExponent + 1)), kBucketCount - 1);
+  EXPECT_EQ(bucket_of(std::numeric_limits<std::uint64_t>::max()), kBucketCount - 1);
+}
+
+TEST(Histogram, QuantilesAreWithinTheBucketResolution) {
+  Histogram h;
+  HistogramSnapshot empty;
+  h.add_to(empty);
+  EXPECT_EQ(empty.quantile(0.5), 0u);
+  EXPECT_EQ(empty.mean(), 0.0);
+
+  for (std::uint64_t v = 1; v <= 100'000; ++v) h.record(v);
+  HistogramSnapshot s;
+  h.add_to(s);
+  EXPECT_EQ(s.count, 100'000u);
+  EXPECT_EQ(s.max, 100'000u);
+  EXPECT_DOUBLE_EQ(s.mean(), 50'000.5);
+  for (const double q : {0.01, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+    EXPECT_NEAR(static_cast<double>(s.quantile(q)), q * 1e5, q * 1e5 / 32) << q;
+  }
+  EXPECT_EQ(s.quantile(0.0), 1u);
+  EXPECT_EQ(s.quantile(7.0), s.quantile(1.0));
+
+  // A bucket's midpoint is clamped to the largest value recorded.
+  Histogram one;
+  one.record(992);  // the bucket is [992, 1008)
+  HistogramSnapshot single;
+  one.add_to(single);
+  EXPECT_EQ(single.quantile(0.5), 992u);
+
+  // Merging adds counts and keeps the larger maximum.
+  Histogram big;
+  big.record(1'000'000);
+  HistogramSnapshot merged = s;
+  HistogramSnapshot other;
+  big.add_to(other);
+  merged.merge(other);
+  EXPECT_EQ(merged.count, 100'001u);
+  EXPECT_EQ(merged.max, 1'000'000u);
+  EXPECT_EQ(merged.sum, s.sum + 1'000'000u);
+}
+
+TEST(Telemetry, MergesThreadsAndKeepsExitedThreadTotals) {
+  const Snapshot before = snapshot();
+  // Four threads alive at once in each round, so each round needs four
+  // blocks however the threads are scheduled.
+  const auto run_round = [] {
+    std::latch alive(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&alive] {
+        for (int i = 0; i < 1000; ++i) record(Stage::kIngest, 1000 + i);
+        add(Counter::kSamplesIngested, 5);
+        observe(Distribution::kQueueDepth, 17);
+        alive.arrive_and_wait();
+      });
+    }
+    for (std::thread& t : threads) t.join();
+  };
+  run_round();
+  const Snapshot after = snapshot();
+  EXPECT_EQ(after[Stage::kIngest].count - before[Stage::kIngest].count, 4000u);
+  EXPECT_EQ(after[Counter::kSamplesIngested] - before[Counter::kSamplesIngested], 20u);
+  EXPECT_EQ(after[Distribution::kQueueDepth].count - before[Distribution::kQueueDepth].count,
+            4u);
+  EXPECT_GE(after[Stage::kIngest].max, 1999u);
+
+  // Blocks of exited threads are handed to new ones, not added to.
+  run_round();
+  EXPECT_EQ(snapshot().threads, after.threads);
+  EXPECT_EQ(stage_count(Stage::kIngest) - after[Stage::kIngest].count, 4000u);
+}
+
+TEST(Telemetry, DisabledRecordingIsDropped) {
+  const Snapshot before = snapshot();
+  set_enabled(false);
+  record(Stage::kColor, 10);
+  add(Counter::kAlerts);
+  { StageTimer timer(Stage::kColor); }
+  EXPECT_FALSE(enabled());
+  set_enabled(true);
+  const Snapshot after = snapshot();
+  EXPECT_EQ(after[Stage::kColor].count, before[Stage::kColor].count);
+  EXPECT_EQ(after[Counter::kAlerts], before[Counter::kAlerts]);
+  { StageTimer timer(Stage::kColor); }
+  EXPECT_EQ(stage_count(Stage::kColor), before[Stage::kColor].count + 1);
+}
+
+TEST(Telemetry, PrometheusTextNamesEverySeries) {
+  Snapshot s;
+  s.stages[static_cast<std::size_t>(Stage::kInference)].counts[bucket_of(2000)] = 1;
+  s.stages[static_cast<std::size_t>(Stage::kInference)].count = 1;
+  s.stages[static_cast<std::size_t>(Stage::kInference)].sum = 2000;
+  s.stages[static_cast<std::size_t>(Stage::kInference)].max = 2000;
+  s.counters[static_cast<std::size_t>(Counter::kGrades)] = 42;
+  const std::string text = prometheus_text(s);
+  for (std::size_t i = 0; i < kStageCount; ++i) {
+    EXPECT_NE(text.find(std::string("stage=\"") + stage_name(static_cast<Stage>(i)) + "\""),
+              std::string::npos);
+  }
+  EXPECT_NE(text.find("meat_quality_stage_seconds{stage=\"inference\",quantile=\"0.5\"} 2e-06"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("meat_quality_stage_seconds{stage=\"ingest\",quantile=\"0.5\"} NaN"),
+            std::string::npos);
+  EXPECT_NE(text.find("meat_quality_stage_seconds_count{stage=\"inference\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("meat_quality_batch_size_count 0\n"), std::string::npos);
+  EXPECT_NE(text.find("meat_quality_grades_total 42\n"), std::string::npos);
+}
+
+TEST(Telemetry, CApiSizesTruncatesAndRejectsUnknownIds) {
+  record(Stage::kAlert, 3'000'000);
+  const std::size_t full = mq_telemetry_prometheus(nullptr, 0);
+  ASSERT_GT(full, 100u);
+  std::vector<char> buf(full + 1, 'x');
+  EXPECT_EQ(mq_telemetry_prometheus(buf.data(), buf.size()), full);
+  EXPECT_EQ(std::strlen(buf.data()), full);
+  char small[16];
+  EXPECT_EQ(mq_telemetry_prometheus(small, sizeof small), full);
+  EXPECT_EQ(std::strlen(small), sizeof small - 1);
+  EXPECT_EQ(std::strncmp(small, buf.data(), sizeof small - 1), 0);
+
+  EXPECT_EQ(mq_telemetry_stage_count(MQ_STAGE_ALERT), stage_count(Stage::kAlert));
+  EXPECT_GT(mq_telemetry_stage_quantile(MQ_STAGE_ALERT, 1.0), 0.0);
+  EXPECT_EQ(mq_telemetry_stage_count(-1), 0u);
+  EXPECT_EQ(mq_telemetry_stage_count(int(kStageCount)), 0u);
+  EXPECT_EQ(mq_telemetry_stage_quantile(int(kStageCount), 0.5), 0.0);
+  EXPECT_EQ(mq_telemetry_counter(int(kCounterCount)), 0u);
+  EXPECT_EQ(mq_telemetry_counter(MQ_COUNTER_GRADES), snapshot()[Counter::kGrades]);
+
+  mq_telemetry_set_enabled(0);
+  EXPECT_FALSE(enabled());
+  mq_telemetry_set_enabled(1);
+  EXPECT_TRUE(enabled());
+}
+
+// Batches and batch sizes count classifier passes; grades count results.
+TEST(Telemetry, CacheHitsAreGradesButNotBatches) {
+  SampleStore store(3, 1024);
+  bench::TraceGenerator gen(3);
+  for (std::uint64_t t = 0; t < 200; ++t) {
+    for (NodeId n = 0; n < 3; ++n) store.push(n, gen.sample(n, t));
+  }
+  const FreshnessClassifier classifier(ClassifierWeights::random(16, 6));
+  const LabConverter converter(LabMode::kExact);
+  GradingPipeline pipeline(store, classifier, converter);
+  GradeCache cache;
+  pipeline.set_result_cache(&cache);
+  const std::vector<GradingRequest> requests = {{0, 0, {}}, {1, 0, {}}, {2, 0, {}}};
+  std::vector<GradeResult> out(requests.size());
+
+  const Snapshot before = snapshot();
+  pipeline.grade_batch(requests, out);
+  const Snapshot first = snapshot();
+  EXPECT_EQ(first[Counter::kGrades] - before[Counter::kGrades], 3u);
+  EXPECT_EQ(first[Counter::kBatches] - before[Counter::kBatches], 1u);
+  EXPECT_EQ(first[Distribution::kBatchSize].sum - before[Distribution::kBatchSize].sum, 3u);
+  EXPECT_EQ(first[Stage::kInference].count - before[Stage::kInference].count, 1u);
+
+  pipeline.grade_batch(requests, out);  // every request is a cache hit
+  const Snapshot second = snapshot();
+  EXPECT_EQ(second[Counter::kGrades] - first[Counter::kGrades], 3u);
+  EXPECT_EQ(second[Counter::kBatches], first[Counter::kBatches]);
+  EXPECT_EQ(second[Distribution::kBatchSize].count, first[Distribution::kBatchSize].count);
+  EXPECT_EQ(second[Stage::kInference].count, first[Stage::kInference].count);
+
+  // One new sample makes one miss: a batch of one.
+  store.push(1, gen.sample(1, 200));
+  pipeline.grade_batch(requests, out);
+  const Snapshot third = snapshot();
+  EXPECT_EQ(third[Counter::kBatches] - second[Counter::kBatches], 1u);
+  EXPECT_EQ(third[Distribution::kBatchSize].sum - second[Distribution::kBatchSize].sum, 1u);
+}
+
+}  // namespace
+}  // namespace meat_quality
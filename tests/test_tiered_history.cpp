@@ -0,0 +1,516 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/storage/tiered_history.hpp"
+#include "synthetic_trace.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr Timestamp kSecond = 1'000'000;
+constexpr Timestamp kStep = 10 * kSecond;
+constexpr Timestamp kNever = std::numeric_limits<Timestamp>::max();
+// Off every bucket boundary, so first buckets are partial.
+constexpr Timestamp kOrigin = 20'000 * kDayMicros + 3 * kMinuteMicros + 20 * kSecond;
+const std::vector<NodeId> kNodes = {1, 4, 9};
+
+// A node's samples every 10 s from `first` to `last` ticks, with dropouts:
+// a NaN pH every 37 ticks and node 9's pH missing for two hours.
+std::vector<SensorSample> make_samples(NodeId node, std::uint64_t first, std::uint64_t last) {
+  bench::TraceGenerator gen(node);
+  std::vector<SensorSample> out;
+  for (std::uint64_t t = first; t < last; ++t) {
+    SensorSample s = gen.sample(node, t * 100);
+    s.timestamp = kOrigin + static_cast<Timestamp>(t) * kStep;
+    if (t % 37 == 5 || (node == 9 && t >= 400 && t < 1100)) s[Channel::kPh] = std::nanf("");
+    out.push_back(s);
+  }
+  return out;
+}
+
+// Buckets of `resolution` over the samples in whole buckets around
+// [from, to], one sample at a time.
+std::vector<rollup::Bucket> reference(const std::vector<SensorSample>& samples,
+                                      Timestamp resolution,
+                                      Timestamp from = std::numeric_limits<Timestamp>::min(),
+                                      Timestamp to = std::numeric_limits<Timestamp>::max()) {
+  struct Sums {
+    std::uint32_t count = 0;
+    std::array<double, kChannelCount> sum{};
+    std::array<std::uint64_t, kChannelCount> n{};
+    std::array<float, kChannelCount> min, max;
+  };
+  std::map<Timestamp, Sums> buckets;
+  for (const SensorSample& s : samples) {
+    const Timestamp start = rollup::bucket_start(s.timestamp, resolution);
+    if (start + resolution - 1 < from || start > to) continue;
+    Sums& b = buckets[start];
+    ++b.count;
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      const float v = s.values[c];
+      if (std::isnan(v)) continue;
+      b.min[c] = b.n[c] == 0 ? v : std::min(b.min[c], v);
+      b.max[c] = b.n[c] == 0 ? v : std::max(b.max[c], v);
+      b.sum[c] += v;
+      ++b.n[c];
+    }
+  }
+  std::vector<rollup::Bucket> out;
+  for (const auto& [t, b] : buckets) {
+    rollup::Bucket r{};
+    r.t = t;
+    r.count = b.count;
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      r.min[c] = b.n[c] == 0 ? std::nanf("") : b.min[c];
+      r.max[c] = b.n[c] == 0 ? std::nanf("") : b.max[c];
+      r.mean[c] = b.n[c] == 0 ? std::nanf("") : static_cast<float>(b.sum[c] / double(b.n[c]));
+      r.readings[c] = static_cast<std::uint32_t>(b.n[c]);
+    }
+    out.push_back(r);
+  }
+  return out;
+}
+
+// Counts, min and max are exact whatever the tier; a mean folded from
+// finer buckets is within float rounding of the one from the samples.
+void expect_same_buckets(std::span<const rollup::Bucket> got,
+                         const std::vector<rollup::Bucket>& want, bool exact_mean) {
+  ASSERT_EQ(got.size(), want.size());
+  for (std::size_t i = 0; i < want.size(); ++i) {
+    SCOPED_TRACE(testing::Message() << "bucket " << i << " at " << want[i].t);
+    EXPECT_EQ(got[i].t, want[i].t);
+    EXPECT_EQ(got[i].count, want[i].count);
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      EXPECT_EQ(got[i].readings[c], want[i].readings[c]) << "channel " << c;
+      if (std::isnan(want[i].mean[c])) {
+        EXPECT_TRUE(std::isnan(got[i].min[c]) && std::isnan(got[i].max[c]) &&
+                    std::isnan(got[i].mean[c]))
+            << "channel " << c;
+        continue;
+      }
+      EXPECT_EQ(got[i].min[c], want[i].min[c]) << "channel " << c;
+      EXPECT_EQ(got[i].max[c], want[i].max[c]) << "channel " << c;
+      if (exact_mean) {
+        EXPECT_EQ(got[i].mean[c], want[i].mean[c]) << "channel " << c;
+      } else {
+        EXPECT_NEAR(got[i].mean[c], want[i].mean[c], 1e-6 * std::fabs(want[i].mean[c]))
+            << "channel " << c;
+      }
+    }
+  }
+}
+
+TEST(Rollup, BucketStartRoundsDown) {
+  EXPECT_EQ(rollup::bucket_start(0, kHourMicros), 0);
+  EXPECT_EQ(rollup::bucket_start(kHourMicros - 1, kHourMicros), 0);
+  EXPECT_EQ(rollup::bucket_start(kHourMicros, kHourMicros), kHourMicros);
+  EXPECT_EQ(rollup::bucket_start(-1, kHourMicros), -kHourMicros);
+  EXPECT_EQ(rollup::bucket_start(-kHourMicros, kHourMicros), -kHourMicros);
+}
+
+TEST(Rollup, AccumulatorMatchesTheSamplesAndMergesFinerBuckets) {
+  // An hour in which node 9 never reports pH.
+  const Timestamp start = rollup::bucket_start(kOrigin, kHourMicros) + 2 * kHourMicros;
+  std::vector<SensorSample> samples;
+  for (const SensorSample& s : make_samples(9, 0, 1500)) {
+    if (s.timestamp >= start && s.timestamp < start + kHourMicros) samples.push_back(s);
+  }
+  RollupAccumulator hour, minute;
+  hour.reset(start);
+  EXPECT_TRUE(hour.empty());
+  std::vector<rollup::Bucket> minutes;
+  for (const SensorSample& s : samples) {
+    const Timestamp m = rollup::bucket_start(s.timestamp, kMinuteMicros);
+    if (!minute.empty() && minute.start() != m) minutes.push_back(minute.bucket());
+    if (minute.empty() || minute.start() != m) minute.reset(m);
+    minute.add(s);
+    hour.add(s);
+  }
+  minutes.push_back(minute.bucket());
+  expect_same_buckets(minutes, reference(samples, kMinuteMicros), true);
+
+  RollupAccumulator merged;
+  merged.reset(start);
+  for (const rollup::Bucket& b : minutes) merged.add(b);
+  const rollup::Bucket direct = hour.bucket();
+  expect_same_buckets({&direct, 1}, reference(samples, kHourMicros), true);
+  expect_same_buckets({&direct, 1}, {merged.bucket()}, false);
+  EXPECT_EQ(direct.count, 360u);
+  EXPECT_TRUE(std::isnan(direct.mean[index_of(Channel::kPh)]));
+}
+
+// Writes `samples[node]` for every node to a rollup file of `resolution`.
+void write_rollup(const std::string& path, Timestamp resolution,
+                  const std::map<NodeId, std::vector<SensorSample>>& samples) {
+  RollupWriter w(path, resolution);
+  for (const auto& [node, history] : samples) {
+    for (const SensorSample& s : history) ASSERT_TRUE(w.append(node, s));
+  }
+  w.finish();
+}
+
+TEST(RollupFile, RoundTripsAndTrimsToTheQueryRange) {
+  const test::TempDir dir;
+  std::map<NodeId, std::vector<SensorSample>> samples;
+  // Over 64 KiB of buckets, so the writer flushes more than once.
+  for (const NodeId n : kNodes) samples[n] = make_samples(n, 0, 2000 + n);
+  write_rollup(dir.file("a.mqroll"), kMinuteMicros, samples);
+
+  const RollupReader r(dir.file("a.mqroll"));
+  EXPECT_EQ(r.resolution(), kMinuteMicros);
+  EXPECT_EQ(r.from(), kOrigin);
+  EXPECT_EQ(r.to(), samples[9].back().timestamp);
+  ASSERT_EQ(r.nodes().size(), kNodes.size());
+  for (const NodeId n : kNodes) {
+    SCOPED_TRACE(testing::Message() << "node " << n);
+    expect_same_buckets(r.buckets(n), reference(samples[n], kMinuteMicros), true);
+    // A range starting or ending inside a bucket includes the bucket.
+    const Timestamp from = samples[n][500].timestamp + 5 * kSecond;
+    const Timestamp to = samples[n][1234].timestamp;
+    expect_same_buckets(r.buckets(n, from, to),
+                        reference(samples[n], kMinuteMicros, from, to), true);
+    EXPECT_TRUE(r.buckets(n, to, from).empty());
+  }
+  EXPECT_TRUE(r.buckets(2).empty());
+  EXPECT_TRUE(r.buckets(10).empty());
+}
+
+TEST(RollupFile, WriterRefusesOutOfOrderInput) {
+  const test::TempDir dir;
+  const std::vector<SensorSample> samples = make_samples(4, 0, 20);
+  {
+    RollupWriter w(dir.file("a.mqroll"), kMinuteMicros);
+    ASSERT_TRUE(w.append(4, samples[10]));
+    EXPECT_FALSE(w.append(4, samples[9]));  // older
+    EXPECT_FALSE(w.append(3, samples[11]));  // lower node
+    ASSERT_TRUE(w.append(4, samples[11]));
+    ASSERT_TRUE(w.append(5, samples[0]));
+    w.finish();
+    EXPECT_EQ(w.buckets_written(), 2u);
+    w.finish();  // a second call does nothing
+  }
+  const RollupReader r(dir.file("a.mqroll"));
+  EXPECT_EQ(r.buckets(4)[0].count, 2u);
+  EXPECT_EQ(r.from(), samples[0].timestamp);
+  EXPECT_EQ(r.to(), samples[11].timestamp);
+
+  // Nothing written: an empty range and no nodes.
+  { RollupWriter empty(dir.file("empty.mqroll"), kHourMicros); }
+  const RollupReader e(dir.file("empty.mqroll"));
+  EXPECT_TRUE(e.nodes().empty());
+  EXPECT_LT(e.to(), e.from());
+
+  EXPECT_THROW(RollupWriter(dir.file("b.mqroll"), 0), std::invalid_argument);
+  EXPECT_THROW(RollupWriter(dir.file("missing/b.mqroll"), kHourMicros), std::system_error);
+}
+
+TEST(RollupFile, RejectsOrSurvivesTruncationAndBitFlips) {
+  const test::TempDir dir;
+  std::map<NodeId, std::vector<SensorSample>> samples;
+  for (const NodeId n : kNodes) samples[n] = make_samples(n, 0, 400);
+  write_rollup(dir.file("a.mqroll"), kMinuteMicros, samples);
+  const std::string damaged_path = dir.file("damaged.mqroll");
+  test::for_each_corruption(
+      test::read_file(dir.file("a.mqroll")), [&](const std::vector<std::uint8_t>& damaged) {
+        test::write_file(damaged_path, damaged);
+        try {
+          const RollupReader r(damaged_path);
+          for (const rollup::NodeEntry& e : r.nodes()) {
+            for (const rollup::Bucket& b : r.buckets(e.node)) (void)b.count;
+          }
+        } catch (const std::runtime_error&) {
+        }
+      });
+  EXPECT_THROW(RollupReader(dir.file("missing.mqroll")), std::system_error);
+}
+
+// Three raw segments of about five hours each, ending in the middle of an
+// hour, written before every test.
+class TieredHistoryTest : public ::testing::Test {
+ protected:
+  static constexpr std::uint64_t kSegmentTicks = 1845;  // 5 h 7 min 30 s
+
+  void SetUp() override {
+    fs::create_directories(dir_.file("raw"));
+    for (int k = 0; k < 3; ++k) {
+      write_segment(k);
+      for (const NodeId n : kNodes) {
+        const std::vector<SensorSample> s = make_samples(n, k * kSegmentTicks,
+                                                         (k + 1) * kSegmentTicks);
+        samples_[n].insert(samples_[n].end(), s.begin(), s.end());
+      }
+      ends_.push_back(samples_[kNodes.back()].back().timestamp);
+    }
+  }
+
+  void write_segment(int k) const {
+    SegmentWriter w(raw_path(k), 64);
+    for (const NodeId n : kNodes) {
+      for (const SensorSample& s : make_samples(n, k * kSegmentTicks, (k + 1) * kSegmentTicks)) {
+        ASSERT_TRUE(w.append(n, s));
+      }
+    }
+    w.finish();
+  }
+
+  std::string raw_path(int k) const {
+    return dir_.file("raw/seg" + std::to_string(k) + ".mqseg");
+  }
+
+  TieredHistoryOptions options() const {
+    TieredHistoryOptions o;
+    o.raw_directory = dir_.file("raw");
+    o.raw_retention = kDayMicros;
+    o.tiers = {{kMinuteMicros, dir_.file("1m")},
+               {15 * kMinuteMicros, dir_.file("15m")},
+               {kHourMicros, dir_.file("1h")}};
+    return o;
+  }
+
+  // Queries every node at `resolution` over [from, to] and checks the
+  // result against the samples.
+  void expect_matches(const TieredHistory& h, Timestamp resolution, int tier, bool exact_mean,
+                      Timestamp from = std::numeric_limits<Timestamp>::min(),
+                      Timestamp to = std::numeric_limits<Timestamp>::max()) const {
+    for (const NodeId n : kNodes) {
+      SCOPED_TRACE(testing::Message() << "node " << n << " every " << resolution / kSecond
+                                      << " s");
+      std::vector<rollup::Bucket> got;
+      const HistoryStats stats = h.query({n, from, to, resolution}, got);
+      EXPECT_EQ(stats.tier, tier);
+      expect_same_buckets(got, reference(samples_.at(n), resolution, from, to), exact_mean);
+    }
+  }
+
+  test::TempDir dir_;
+  std::map<NodeId, std::vector<SensorSample>> samples_;
+  std::vector<Timestamp> ends_;  // last timestamp of each segment
+};
+
+TEST_F(TieredHistoryTest, QueriesRawSegmentsBeforeCompaction) {
+  const TieredHistory h(options());
+  EXPECT_EQ(h.raw_segments(), 3u);
+  // Raw samples are summed exactly as the reference sums them.
+  expect_matches(h, kHourMicros, 2, true);
+  expect_matches(h, 30 * kMinuteMicros, 1, true);
+  expect_matches(h, 90 * kSecond, -1, true);
+  const Timestamp from = kOrigin + 2 * kHourMicros + 7 * kSecond;
+  expect_matches(h, 15 * kMinuteMicros, 1, true, from, from + 6 * kHourMicros);
+
+  std::vector<rollup::Bucket> none;
+  const HistoryStats stats = h.query({2, kOrigin, ends_.back(), kHourMicros}, none);
+  EXPECT_TRUE(none.empty());
+  EXPECT_EQ(stats.raw_samples, 0u);
+}
+
+TEST_F(TieredHistoryTest, CompactionSwapsOldSegmentsForRollups) {
+  TieredHistory h(options());
+  // The first two segments are past the raw retention, the last is not.
+  const CompactionStats s = h.compact(ends_[1] + kDayMicros + 1);
+  EXPECT_EQ(s.passes, 1u);
+  EXPECT_EQ(s.segments_compacted, 2u);
+  EXPECT_EQ(s.rollups_written, 6u);
+  EXPECT_EQ(s.rollups_expired, 0u);
+  EXPECT_GT(s.raw_bytes_removed, s.rollup_bytes_written);
+  EXPECT_EQ(h.raw_segments(), 1u);
+  EXPECT_FALSE(fs::exists(raw_path(0)));
+  EXPECT_TRUE(fs::exists(raw_path(2)));
+  for (std::size_t k = 0; k < 3; ++k) EXPECT_EQ(h.rollup_files(k), 2u);
+  EXPECT_EQ(h.stats().segments_compacted, 2u);
+
+  // Buckets straddling a segment boundary merge a tier bucket and raw
+  // samples, or two tier buckets.
+  expect_matches(h, kHourMicros, 2, false);
+  expect_matches(h, 2 * kHourMicros, 2, false);
+  expect_matches(h, 45 * kMinuteMicros, 1, false);
+  expect_matches(h, kMinuteMicros, 0, false);
+  const Timestamp from = ends_[0] - 40 * kMinuteMicros;
+  expect_matches(h, 15 * kMinuteMicros, 1, false, from, ends_[1] + 3 * kHourMicros);
+
+  std::vector<rollup::Bucket> hourly;
+  const HistoryStats stats = h.query({4, kOrigin, ends_.back(), kHourMicros}, hourly);
+  EXPECT_GT(stats.rollup_buckets, 0u);
+  EXPECT_EQ(stats.raw_samples, kSegmentTicks);  // the last segment only
+
+  // No tier divides 90 s, so only the raw segment left answers.
+  std::vector<rollup::Bucket> raw_only;
+  EXPECT_EQ(h.query({4, kOrigin, ends_.back(), 90 * kSecond}, raw_only).tier, -1);
+  ASSERT_FALSE(raw_only.empty());
+  EXPECT_GT(raw_only.front().t, ends_[1] - 90 * kSecond);
+
+  // Nothing left to do.
+  EXPECT_EQ(h.compact(ends_[1] + kDayMicros + 1).segments_compacted, 0u);
+  EXPECT_EQ(h.stats().passes, 2u);
+}
+
+TEST_F(TieredHistoryTest, TiersExpireOnTheirOwnRetention) {
+  TieredHistoryOptions o = options();
+  o.tiers[0].retention = 2 * kDayMicros;
+  o.tiers[1].retention = 10 * kDayMicros;
+  TieredHistory h(o);
+  const CompactionStats s = h.compact(ends_[2] + 3 * kDayMicros);
+  EXPECT_EQ(s.segments_compacted, 3u);
+  EXPECT_EQ(s.rollups_expired, 3u);
+  EXPECT_EQ(h.rollup_files(0), 0u);
+  EXPECT_EQ(h.rollup_files(1), 3u);
+  EXPECT_EQ(h.rollup_files(2), 3u);
+  EXPECT_TRUE(fs::is_empty(dir_.file("1m")));
+
+  std::vector<rollup::Bucket> minutes;
+  EXPECT_EQ(h.query({4, kOrigin, ends_.back(), kMinuteMicros}, minutes).tier, 0);
+  EXPECT_TRUE(minutes.empty());
+  expect_matches(h, 15 * kMinuteMicros, 1, false);
+
+  EXPECT_EQ(h.compact(ends_[2] + 11 * kDayMicros).rollups_expired, 3u);
+  expect_matches(h, kHourMicros, 2, false);
+}
+
+TEST_F(TieredHistoryTest, ReopensAndFinishesInterruptedCompactions) {
+  {
+    TieredHistory h(options());
+    h.compact(ends_[1] + kDayMicros + 1);
+  }
+  // Segment 0 is back with all its rollups written: the pass stopped
+  // before deleting it. Segment 1's hourly rollup is missing, so its pass
+  // starts over. A temporary file is left from a pass that died.
+  write_segment(0);
+  write_segment(1);
+  fs::remove(dir_.file("1h/seg1.mqroll"));
+  test::write_file(dir_.file("15m/seg1.mqroll.tmp"), {1, 2, 3});
+
+  const TieredHistory h(options());
+  EXPECT_FALSE(fs::exists(raw_path(0)));
+  EXPECT_TRUE(fs::exists(raw_path(1)));
+  EXPECT_FALSE(fs::exists(dir_.file("1m/seg1.mqroll")));
+  EXPECT_FALSE(fs::exists(dir_.file("15m/seg1.mqroll.tmp")));
+  EXPECT_EQ(h.raw_segments(), 2u);
+  for (std::size_t k = 0; k < 3; ++k) EXPECT_EQ(h.rollup_files(k), 1u);
+  expect_matches(h, kHourMicros, 2, false);
+  expect_matches(h, kMinuteMicros, 0, false);
+}
+
+TEST_F(TieredHistoryTest, QueriesSeeEveryIntervalOnceDuringCompaction) {
+  TieredHistory h(options());
+  const std::vector<rollup::Bucket> want = reference(samples_.at(1), kHourMicros);
+  std::atomic<bool> done{false};
+  std::atomic<int> queries{0};
+  std::thread reader([&] {
+    while (!done.load() || queries.load() == 0) {
+      std::vector<rollup::Bucket> got;
+      h.query({1, std::numeric_limits<Timestamp>::min(), kNever, kHourMicros}, got);
+      expect_same_buckets(got, want, false);
+      ++queries;
+    }
+  });
+  for (int k = 0; k < 3; ++k) h.compact(ends_[k] + kDayMicros + 1);
+  done = true;
+  reader.join();
+  EXPECT_EQ(h.raw_segments(), 0u);
+  EXPECT_GT(queries.load(), 0);
+}
+
+TEST_F(TieredHistoryTest, CompactsInTheBackgroundAndRetriesFailedPasses) {
+  TieredHistoryOptions o = options();
+  o.compact_interval = std::chrono::milliseconds(5);
+  TieredHistory h(o);
+  // A file where a tier's directory should be fails every pass.
+  fs::remove(dir_.file("15m"));
+  test::write_file(dir_.file("15m"), {0});
+  h.start();
+  h.start();  // a second call does nothing
+  const auto wait_for = [](auto&& done) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done() && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+  };
+  // The wall clock is years past the trace.
+  ASSERT_TRUE(wait_for([&] { return h.stats().errors >= 2; }));
+  EXPECT_EQ(h.raw_segments(), 3u);
+  for (const fs::directory_entry& e : fs::directory_iterator(dir_.file("1m"))) {
+    EXPECT_NE(e.path().extension(), ".mqroll") << e.path();  // failed passes leave none
+  }
+
+  fs::remove(dir_.file("15m"));
+  fs::create_directories(dir_.file("15m"));
+  ASSERT_TRUE(wait_for([&] { return h.raw_segments() == 0; }));
+  h.stop();
+  h.stop();
+  EXPECT_EQ(h.stats().segments_compacted, 3u);
+  expect_matches(h, kHourMicros, 2, false);
+}
+
+TEST_F(TieredHistoryTest, AddsSegmentsAndUsesDefaultTiers) {
+  TieredHistoryOptions o = options();
+  o.tiers.clear();
+  TieredHistory h(o);
+  ASSERT_EQ(h.tiers().size(), 3u);
+  EXPECT_EQ(h.tiers()[0].resolution, kMinuteMicros);
+  EXPECT_EQ(h.tiers()[1].resolution, 15 * kMinuteMicros);
+  EXPECT_EQ(h.tiers()[2].resolution, kHourMicros);
+  EXPECT_EQ(h.tiers()[2].retention, kNever);
+  for (const RollupTier& t : h.tiers()) {
+    EXPECT_EQ(fs::path(t.directory).parent_path(), fs::path(o.raw_directory));
+    EXPECT_TRUE(fs::is_directory(t.directory));
+  }
+
+  // A segment written after opening is seen once registered.
+  const std::vector<SensorSample> more = make_samples(4, 3 * kSegmentTicks, 4 * kSegmentTicks);
+  {
+    SegmentWriter w(raw_path(3), 64);
+    for (const SensorSample& s : more) ASSERT_TRUE(w.append(4, s));
+    w.finish();
+  }
+  h.add_segment(raw_path(3));
+  EXPECT_EQ(h.raw_segments(), 4u);
+  samples_[4].insert(samples_[4].end(), more.begin(), more.end());
+  h.compact(ends_[1] + kDayMicros + 1);
+  expect_matches(h, kHourMicros, 2, false);
+  EXPECT_THROW(h.add_segment(dir_.file("raw/missing.mqseg")), std::system_error);
+}
+
+TEST_F(TieredHistoryTest, RejectsBadTiersQueriesAndFiles) {
+  TieredHistoryOptions o = options();
+  o.raw_directory.clear();
+  EXPECT_THROW(TieredHistory{o}, std::invalid_argument);
+  for (const std::vector<Timestamp>& resolutions :
+       {std::vector<Timestamp>{kMinuteMicros, 90 * kSecond}, {kHourMicros, kMinuteMicros},
+        {kMinuteMicros, kMinuteMicros}, {0}, {-kMinuteMicros}}) {
+    o = options();
+    o.tiers.resize(resolutions.size());
+    for (std::size_t k = 0; k < resolutions.size(); ++k) o.tiers[k].resolution = resolutions[k];
+    EXPECT_THROW(TieredHistory{o}, std::invalid_argument) << resolutions.back();
+  }
+  o = options();
+  o.tiers[1].directory.clear();
+  EXPECT_THROW(TieredHistory{o}, std::invalid_argument);
+
+  const TieredHistory h(options());
+  std::vector<rollup::Bucket> out;
+  EXPECT_THROW(h.query({1, kOrigin, kNever, 0}, out), std::invalid_argument);
+  EXPECT_THROW(h.query({1, kOrigin, kNever, -kHourMicros}, out), std::invalid_argument);
+  EXPECT_EQ(h.rollup_files(3), 0u);
+
+  test::write_file(dir_.file("1h/bad.mqroll"), std::vector<std::uint8_t>(100, 7));
+  EXPECT_THROW(TieredHistory{options()}, std::runtime_error);
+  o = options();
+  o.raw_directory = dir_.file("1h/bad.mqroll");
+  EXPECT_THROW(TieredHistory{o}, std::system_error);
+}
+
+}  // namespace
+}  // namespace meat_quality
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "meat_quality/core/simd.hpp"
+#include "meat_quality/features/feature_pipeline.hpp"
+#include "meat_quality/features/window_features.hpp"
+#include "test_support.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+constexpr float kInf = std::numeric_limits<float>::infinity();
+constexpr Timestamp kTick = 100'000;
+
+// Straightforward double-precision features over the finite readings.
+ChannelFeatures reference_features(const std::vector<Timestamp>& t, const std::vector<float>& x,
+                                   float alpha) {
+  std::vector<double> ts, xs;
+  double ewma = 0;
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    if (!std::isfinite(x[i])) continue;
+    ewma = xs.empty() ? x[i] : ewma + alpha * (x[i] - ewma);
+    ts.push_back(static_cast<double>(t[i] - t.front()) * 1e-6);
+    xs.push_back(x[i]);
+  }
+  ChannelFeatures f;
+  if (xs.empty()) {
+    f.mean = f.min = f.max = f.ewma = kNaN;
+    return f;
+  }
+  const double n = static_cast<double>(xs.size());
+  double mx = 0, mt = 0;
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    mx += xs[i] / n;
+    mt += ts[i] / n;
+  }
+  double vx = 0, vt = 0, ctx = 0;
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    vx += (xs[i] - mx) * (xs[i] - mx);
+    vt += (ts[i] - mt) * (ts[i] - mt);
+    ctx += (ts[i] - mt) * (xs[i] - mx);
+  }
+  f.mean = static_cast<float>(mx);
+  f.variance = static_cast<float>(vx / n);
+  f.slope = vt > 0 ? static_cast<float>(ctx / vt) : 0.0f;
+  f.min = static_cast<float>(*std::min_element(xs.begin(), xs.end()));
+  f.max = static_cast<float>(*std::max_element(xs.begin(), xs.end()));
+  f.ewma = static_cast<float>(ewma);
+  return f;
+}
+
+void expect_near(float got, float want, const char* field, std::size_t c) {
+  if (std::isnan(want)) {
+    EXPECT_TRUE(std::isnan(got)) << field << " of channel " << c;
+    return;
+  }
+  EXPECT_NEAR(got, want, 1e-4f * std::max(1.0f, std::fabs(want))) << field << " of channel " << c;
+}
+
+void expect_matches(const ChannelFeatures& got, const ChannelFeatures& want, std::size_t c) {
+  expect_near(got.mean, want.mean, "mean", c);
+  expect_near(got.variance, want.variance, "variance", c);
+  expect_near(got.slope, want.slope, "slope", c);
+  expect_near(got.min, want.min, "min", c);
+  expect_near(got.max, want.max, "max", c);
+  expect_near(got.ewma, want.ewma, "ewma", c);
+}
+
+using test::EachSimdLevel;
+
+// A store whose ring wraps, so windows come in two segments, with
+// `ticks` random-walk samples in every channel.
+struct Trace {
+  Trace(std::size_t ticks, std::uint64_t seed, std::size_t capacity = 256)
+      : store(1, capacity) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    SensorSample s;
+    s.values = {2.0f, 0.05f, 150.0f, 2.5f, 88.0f, 5.6f};
+    for (std::size_t i = 0; i < ticks; ++i) {
+      s.timestamp = static_cast<Timestamp>(i + 1) * kTick;
+      for (float& v : s.values) v += noise(rng) * 0.1f;
+      samples.push_back(s);
+    }
+  }
+
+  void push() {
+    for (const SensorSample& s : samples) store.push(0, s);
+  }
+
+  // Reference features of the last `n` samples.
+  ChannelFeatures reference(std::size_t c, std::size_t n, float alpha) const {
+    std::vector<Timestamp> t;
+    std::vector<float> x;
+    for (std::size_t i = samples.size() - n; i < samples.size(); ++i) {
+      t.push_back(samples[i].timestamp);
+      x.push_back(samples[i].values[c]);
+    }
+    return reference_features(t, x, alpha);
+  }
+
+  SampleStore store;
+  std::vector<SensorSample> samples;
+};
+
+// Every length up to a few AVX-512 vectors, so each kernel runs with every
+// tail length, and the same data split into two segments at several points.
+TEST_F(EachSimdLevel, KernelsMatchTheReferenceAtEveryTailLength) {
+  std::mt19937_64 rng(2);
+  std::normal_distribution<float> noise(0.0f, 0.3f);
+  std::vector<Timestamp> t(70);
+  std::vector<float> x(70);
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    // A level far from zero and an uneven clock, as real nodes report.
+    t[i] = 5'000'000 + static_cast<Timestamp>(i) * kTick + static_cast<Timestamp>(i % 3) * 1000;
+    x[i] = 88.0f + 0.01f * static_cast<float>(i) + noise(rng);
+  }
+  const float alpha = 0.1f;
+  for_each_level([&] {
+    for (std::size_t n = 1; n <= x.size(); ++n) {
+      const std::vector<Timestamp> tn(t.begin(), t.begin() + static_cast<std::ptrdiff_t>(n));
+      const std::vector<float> xn(x.begin(), x.begin() + static_cast<std::ptrdiff_t>(n));
+      const ChannelFeatures want = reference_features(tn, xn, alpha);
+      // A window's first segment is never empty.
+      for (const std::size_t split : {n, std::max<std::size_t>(n / 2, 1), std::size_t{1}}) {
+        SCOPED_TRACE(::testing::Message() << "n " << n << " split " << split);
+        const SplitSpan<Timestamp> ts{{tn.data(), split}, {tn.data() + split, n - split}};
+        const SplitSpan<float> xs{{xn.data(), split}, {xn.data() + split, n - split}};
+        expect_matches(compute_channel_features(ts, xs, alpha), want, 0);
+      }
+    }
+  });
+}
+
+TEST_F(EachSimdLevel, EmptyWindowIsAllZeros) {
+  for_each_level([&] {
+    const ChannelFeatures f = compute_channel_features({}, {}, 0.1f);
+    EXPECT_EQ(f.mean, 0.0f);
+    EXPECT_EQ(f.variance, 0.0f);
+    EXPECT_EQ(f.slope, 0.0f);
+    EXPECT_EQ(f.ewma, 0.0f);
+    const WindowFeatures w = extract_features(WindowView{});
+    EXPECT_EQ(w.samples, 0u);
+  });
+}
+
+// The fused kernels fold timestamps in blocks of 256 and vectors of up to
+// eight lanes; lengths around both, in one segment or split by the ring,
+// must give what the per-channel path gives for every SKU and a set
+// without its own kernel.
+TEST_F(EachSimdLevel, FixedChannelSetsMatchTheGenericPathAtEveryLength) {
+  Trace trace(600, 3, 512);  // windows longer than 88 samples wrap
+  trace.push();
+  const float alpha = 0.2f;
+  std::vector<std::size_t> lengths;
+  for (std::size_t n = 1; n <= 40; ++n) lengths.push_back(n);
+  for (const std::size_t n : {87u, 88u, 89u, 95u, 255u, 256u, 257u, 263u, 511u, 512u}) {
+    lengths.push_back(n);
+  }
+  const auto check = [&](auto mask, std::size_t n) {
+    const WindowView window = trace.store.latest(0, n);
+    ASSERT_EQ(window.size(), n);
+    const WindowFeatures fixed = extract_features_fixed<decltype(mask)::value>(window, alpha);
+    const WindowFeatures generic = extract_features(window, {alpha, decltype(mask)::value});
+    EXPECT_EQ(fixed.samples, generic.samples);
+    EXPECT_EQ(fixed.start, generic.start);
+    EXPECT_EQ(fixed.end, generic.end);
+    EXPECT_EQ(fixed.channels, generic.channels);
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      if (!contains(generic.channels, static_cast<Channel>(c))) continue;
+      const ChannelFeatures want = trace.reference(c, n, alpha);
+      expect_matches(fixed.values[c], want, c);
+      expect_matches(generic.values[c], want, c);
+    }
+  };
+  for_each_level([&] {
+    for (const std::size_t n : lengths) {
+      SCOPED_TRACE(::testing::Message() << "n " << n);
+      check(std::integral_constant<ChannelMask, kGasOnlySku>{}, n);
+      check(std::integral_constant<ChannelMask, kGasPhSku>{}, n);
+      check(std::integral_constant<ChannelMask, kFullSku>{}, n);
+      check(std::integral_constant<ChannelMask, mask_of(Channel::kTemperature) |
+                                                    mask_of(Channel::kNh3)>{},
+            n);
+    }
+  });
+  static_assert(!is_fused_feature_set(mask_of(Channel::kTemperature)));
+}
+
+TEST_F(EachSimdLevel, NonFiniteReadingsAreLeftOut) {
+  Trace trace(300, 1);  // 256 kept, wrapped
+  const std::size_t base = trace.samples.size() - 256;
+  // The first sample of the window, one inside the vector body, one in the
+  // tail, a run across the ring's split point, and a channel with no
+  // finite reading at all.
+  trace.samples[base][Channel::kNh3] = kNaN;
+  trace.samples[base + 100][Channel::kVoc] = kInf;
+  trace.samples[base + 253][Channel::kTemperature] = -kInf;
+  for (std::size_t i = 0; i < 20; ++i) trace.samples[base + 40 + i][Channel::kPh] = kNaN;
+  for (SensorSample& s : trace.samples) s[Channel::kH2s] = kNaN;
+  trace.push();
+  const WindowView window = trace.store.window(0, 0);
+  ASSERT_EQ(window.size(), 256u);
+  ASSERT_FALSE(window.timestamps.second.empty());
+
+  const float alpha = 0.05f;
+  for_each_level([&] {
+    const WindowFeatures generic = extract_features(window, {alpha, kAllChannels});
+    const WindowFeatures fixed = extract_features_fixed<kFullSku>(window, alpha);
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      const ChannelFeatures want = trace.reference(c, 256, alpha);
+      expect_matches(generic.values[c], want, c);
+      expect_matches(fixed.values[c], want, c);
+    }
+    const WindowFeatures gas = extract_features_fixed<kGasPhSku>(window, alpha);
+    for (const Channel c : {Channel::kNh3, Channel::kH2s, Channel::kVoc, Channel::kPh}) {
+      expect_matches(gas[c], trace.reference(index_of(c), 256, alpha), index_of(c));
+    }
+  });
+}
+
+}  // namespace
+}  // namespace meat_quality
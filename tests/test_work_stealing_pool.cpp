@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/util/work_stealing_pool.hpp"
+
+namespace meat_quality {
+namespace {
+
+// Spins for up to five seconds without helping the pool.
+template <typename Fn>
+bool eventually(Fn&& done) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+TEST(WorkStealingPool, RunsEveryTaskOnce) {
+  for (const std::size_t threads : {1u, 4u}) {
+    WorkStealingPool pool(threads);
+    EXPECT_EQ(pool.thread_count(), threads);
+    std::vector<std::atomic<int>> runs(1000);
+    TaskGroup group(pool);
+    for (auto& r : runs) group.run([&r] { r.fetch_add(1); });
+    group.wait();
+    for (std::size_t i = 0; i < runs.size(); ++i) ASSERT_EQ(runs[i].load(), 1) << i;
+  }
+}
+
+TEST(WorkStealingPool, TasksSpawnedByTasksJoinTheGroup) {
+  std::atomic<int> leaves{0};
+  WorkStealingPool pool(3);
+  TaskGroup group(pool);
+  std::function<void(int)> split = [&](int depth) {
+    if (depth == 0) {
+      leaves.fetch_add(1);
+      return;
+    }
+    group.run([&, depth] { split(depth - 1); });
+    group.run([&, depth] { split(depth - 1); });
+  };
+  group.run([&] { split(10); });
+  group.wait();
+  EXPECT_EQ(leaves.load(), 1 << 10);
+}
+
+// A worker that blocks without helping leaves its own deque to the others.
+TEST(WorkStealingPool, IdleWorkersStealFromABusyOne) {
+  std::atomic<int> done{0}, by_owner{0};
+  WorkStealingPool pool(2);
+  pool.submit([&] {
+    const int self = pool.current_worker();
+    for (int k = 0; k < 8; ++k) {
+      pool.submit([&, self] {
+        if (pool.current_worker() == self) by_owner.fetch_add(1);
+        done.fetch_add(1);
+      });
+    }
+    eventually([&] { return done.load() == 8; });
+  });
+  ASSERT_TRUE(eventually([&] { return done.load() == 8; }));
+  EXPECT_EQ(by_owner.load(), 0);
+}
+
+TEST(WorkStealingPool, IdentifiesItsWorkers) {
+  WorkStealingPool pool(3), other(1);
+  EXPECT_EQ(pool.current_worker(), -1);
+  std::vector<int> seen(64, -2);
+  std::atomic<int> other_seen{-2};
+  TaskGroup group(pool);
+  for (int& s : seen) group.run([&] { s = pool.current_worker(); });
+  group.run([&] { other_seen = other.current_worker(); });
+  group.wait();
+  for (const int s : seen) {
+    // The waiting thread helps, so some tasks run outside the workers.
+    EXPECT_GE(s, -1);
+    EXPECT_LT(s, 3);
+  }
+  EXPECT_EQ(other_seen.load(), -1);
+}
+
+TEST(WorkStealingPool, WaitRethrowsTheFirstErrorOnce) {
+  WorkStealingPool pool(2);
+  TaskGroup group(pool);
+  std::atomic<int> ran{0};
+  for (int k = 0; k < 20; ++k) {
+    group.run([&, k] {
+      ran.fetch_add(1);
+      if (k % 5 == 0) throw std::runtime_error("task failed");
+    });
+  }
+  EXPECT_THROW(group.wait(), std::runtime_error);
+  EXPECT_EQ(ran.load(), 20);  // the other tasks still ran
+  group.run([&] { ran.fetch_add(1); });
+  EXPECT_NO_THROW(group.wait());
+  EXPECT_EQ(ran.load(), 21);
+}
+
+TEST(WorkStealingPool, DestructorRunsQueuedTasks) {
+  std::atomic<int> ran{0};
+  {
+    std::atomic<bool> release{false};
+    WorkStealingPool pool(1);
+    pool.submit([&] { eventually([&] { return release.load(); }); });
+    for (int k = 0; k < 50; ++k) pool.submit([&] { ran.fetch_add(1); });
+    release = true;
+  }
+  EXPECT_EQ(ran.load(), 50);
+}
+
+TEST(WorkStealingPool, RunOneFromOutsideTakesQueuedWork) {
+  std::atomic<bool> started{false}, release{false};
+  std::atomic<int> ran{0};
+  WorkStealingPool pool(1);
+  EXPECT_FALSE(pool.run_one());
+  pool.submit([&] {
+    started = true;
+    eventually([&] { return release.load(); });
+  });
+  ASSERT_TRUE(eventually([&] { return started.load(); }));
+  pool.submit([&] { ran.fetch_add(1); });
+  EXPECT_TRUE(pool.run_one());
+  EXPECT_EQ(ran.load(), 1);
+  release = true;
+}
+
+}  // namespace
+}  // namespace meat_quality
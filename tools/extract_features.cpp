@@ -0,0 +1,329 @@
+// Builds training feature matrices from sensor history segments and a
+// label file, with the same feature kernels the gateway serves with.
+//
+//   mq_extract_features --labels labels.csv --out features.mqfm
+//                       [--images DIR] [--threads N] [--shard I/M]
+//                       [--window-hours H] SEGMENT...
+//
+// Each label line is `node,timestamp_us,label[,image.ppm]`; lines starting
+// with '#' and a header line are skipped. Every labeled instant becomes one
+// row: key columns, the classifier inputs over the window ending at the
+// instant, and color statistics if the line names an image (binary PPM,
+// relative to --images).
+//
+// Rows are sorted by node and time, and (node, day) units are the unit of
+// work. `--shard I/M` keeps the units that hash to shard I of M, so M
+// machines can split one label file without coordinating. Units run on a
+// thread pool and write their rows straight into their slice of each
+// output column, so the output is byte-identical for any thread count.
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "meat_quality/cluster/shard_map.hpp"
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/storage/feature_matrix.hpp"
+#include "meat_quality/storage/segment.hpp"
+#include "meat_quality/util/work_stealing_pool.hpp"
+
+namespace meat_quality {
+namespace {
+
+constexpr Timestamp kMicrosPerDay = 24 * kMicrosPerHour;
+
+struct Options {
+  std::string labels;
+  std::string out;
+  std::string images;
+  std::vector<std::string> segments;
+  std::size_t threads = 0;
+  std::uint64_t shard = 0;
+  std::uint64_t shard_count = 1;
+  Timestamp window = GradingOptions{}.window;
+};
+
+struct Label {
+  NodeId node;
+  Timestamp at;
+  std::int32_t label;
+  std::string image;
+};
+
+// Rows [first, last) of the sorted labels: one node on one day.
+struct Unit {
+  std::size_t first;
+  std::size_t last;
+};
+
+[[noreturn]] void usage(const char* error) {
+  std::fprintf(stderr,
+               "error: %s\n"
+               "usage: mq_extract_features --labels FILE --out FILE [--images DIR]\n"
+               "       [--threads N] [--shard I/M] [--window-hours H] SEGMENT...\n",
+               error);
+  std::exit(2);
+}
+
+template <typename T>
+bool parse_number(std::string_view s, T& out) {
+  const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+  return ec == std::errc{} && end == s.data() + s.size();
+}
+
+Options parse_args(int argc, char** argv) {
+  Options o;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const auto value = [&]() -> std::string_view {
+      if (i + 1 == argc) usage("missing option value");
+      return argv[++i];
+    };
+    if (arg == "--labels") {
+      o.labels = value();
+    } else if (arg == "--out") {
+      o.out = value();
+    } else if (arg == "--images") {
+      o.images = value();
+    } else if (arg == "--threads") {
+      if (!parse_number(value(), o.threads)) usage("bad --threads");
+    } else if (arg == "--window-hours") {
+      double hours = 0;
+      if (!parse_number(value(), hours) || hours <= 0) usage("bad --window-hours");
+      o.window = static_cast<Timestamp>(hours * double(kMicrosPerHour));
+    } else if (arg == "--shard") {
+      const std::string_view v = value();
+      const std::size_t slash = v.find('/');
+      if (slash == std::string_view::npos || !parse_number(v.substr(0, slash), o.shard) ||
+          !parse_number(v.substr(slash + 1), o.shard_count) || o.shard >= o.shard_count) {
+        usage("bad --shard, expected I/M with I < M");
+      }
+    } else if (arg.starts_with("--")) {
+      usage("unknown option");
+    } else {
+      o.segments.emplace_back(arg);
+    }
+  }
+  if (o.labels.empty() || o.out.empty() || o.segments.empty()) {
+    usage("--labels, --out and at least one segment are required");
+  }
+  return o;
+}
+
+std::vector<Label> read_labels(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open " + path);
+  std::vector<Label> labels;
+  std::string line;
+  for (std::size_t number = 1; std::getline(in, line); ++number) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line[0] == '#') continue;
+    std::string_view fields[4];
+    std::size_t n = 0;
+    for (std::string_view rest = line; n < 4;) {
+      const std::size_t comma = rest.find(',');
+      fields[n++] = rest.substr(0, comma);
+      if (comma == std::string_view::npos) break;
+      rest.remove_prefix(comma + 1);
+    }
+    Label l{};
+    if (n < 3 || !parse_number(fields[0], l.node) || !parse_number(fields[1], l.at) ||
+        !parse_number(fields[2], l.label)) {
+      if (labels.empty() && number == 1) continue;  // header
+      throw std::runtime_error(path + ":" + std::to_string(number) + ": bad label line");
+    }
+    if (n == 4) l.image = fields[3];
+    labels.push_back(std::move(l));
+  }
+  return labels;
+}
+
+Timestamp day_of(Timestamp t) noexcept {
+  return t >= 0 ? t / kMicrosPerDay : (t + 1) / kMicrosPerDay - 1;
+}
+
+bool in_shard(const Label& l, const Options& o) noexcept {
+  const auto key = (std::uint64_t{l.node} << 32) ^ static_cast<std::uint64_t>(day_of(l.at));
+  return mix64(key) % o.shard_count == o.shard;
+}
+
+// Binary PPM (P6, maxval 255) into an RGB8 buffer.
+bool read_ppm(const std::string& path, std::vector<std::uint8_t>& pixels, ImageView& view) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  std::uint32_t width = 0, height = 0, maxval = 0;
+  const auto skip_comments = [&] {
+    while (in >> std::ws && in.peek() == '#') in.ignore(1 << 20, '\n');
+  };
+  in >> magic;
+  skip_comments();
+  in >> width;
+  skip_comments();
+  in >> height;
+  skip_comments();
+  in >> maxval;
+  if (!in || magic != "P6" || maxval != 255 || width == 0 || height == 0) return false;
+  in.get();
+  pixels.resize(std::size_t{width} * height * 3);
+  in.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+  if (!in) return false;
+  view = {pixels.data(), width, height, std::size_t{width} * 3, PixelFormat::kRgb8};
+  return true;
+}
+
+// One node's samples over a time range, gathered from every segment.
+struct History {
+  std::vector<Timestamp> timestamps;
+  std::array<std::vector<float>, kChannelCount> channels;
+
+  WindowView window(Timestamp from, Timestamp to) const noexcept {
+    const auto begin = std::lower_bound(timestamps.begin(), timestamps.end(), from);
+    const auto end = std::upper_bound(begin, timestamps.end(), to);
+    const auto off = static_cast<std::size_t>(begin - timestamps.begin());
+    const auto len = static_cast<std::size_t>(end - begin);
+    WindowView w;
+    w.timestamps.first = {timestamps.data() + off, len};
+    for (std::size_t c = 0; c < kChannelCount; ++c) {
+      w.channels[c].first = {channels[c].data() + off, len};
+    }
+    return w;
+  }
+};
+
+History load_history(const std::vector<std::unique_ptr<SegmentReader>>& segments, NodeId node,
+                     Timestamp from, Timestamp to) {
+  History h;
+  SegmentQuery query;
+  query.node = node;
+  query.from = from;
+  query.to = to;
+  for (const auto& r : segments) {
+    r->scan(query, [&](const DecodedBlock& b) {
+      for (std::size_t i = 0; i < b.size(); ++i) {
+        // Overlapping segments: keep time order, as a sample store would.
+        if (!h.timestamps.empty() && b.timestamps[i] < h.timestamps.back()) continue;
+        h.timestamps.push_back(b.timestamps[i]);
+        for (std::size_t c = 0; c < kChannelCount; ++c) h.channels[c].push_back(b.channels[c][i]);
+      }
+    });
+  }
+  return h;
+}
+
+int run(const Options& o) {
+  const auto started = std::chrono::steady_clock::now();
+  std::vector<Label> labels = read_labels(o.labels);
+  std::erase_if(labels, [&](const Label& l) { return !in_shard(l, o); });
+  std::stable_sort(labels.begin(), labels.end(), [](const Label& a, const Label& b) {
+    return a.node != b.node ? a.node < b.node : a.at < b.at;
+  });
+  std::vector<Unit> units;
+  for (std::size_t i = 0; i < labels.size();) {
+    std::size_t j = i + 1;
+    while (j < labels.size() && labels[j].node == labels[i].node &&
+           day_of(labels[j].at) == day_of(labels[i].at)) {
+      ++j;
+    }
+    units.push_back({i, j});
+    i = j;
+  }
+  const bool with_color = std::any_of(labels.begin(), labels.end(),
+                                      [](const Label& l) { return !l.image.empty(); });
+
+  std::vector<std::unique_ptr<SegmentReader>> segments;
+  for (const std::string& path : o.segments) segments.push_back(std::make_unique<SegmentReader>(path));
+
+  using feature_matrix::ColumnType;
+  std::vector<ColumnSpec> columns = {{"node", ColumnType::kU32},
+                                     {"at", ColumnType::kI64},
+                                     {"label", ColumnType::kI32},
+                                     {"samples", ColumnType::kU32}};
+  for (std::size_t f = 0; f < kFeatureDim; ++f) columns.push_back({feature_name(f), ColumnType::kF32});
+  constexpr std::size_t kFirstFeature = 4;
+  const std::size_t first_color = columns.size();
+  if (with_color) {
+    columns.push_back({"has_color", ColumnType::kU32});
+    for (const char* name : {"mean_l", "mean_a", "mean_b", "a_p10", "a_p50", "a_p90"}) {
+      columns.push_back({name, ColumnType::kF32});
+    }
+  }
+  FeatureMatrixWriter writer(o.out, labels.size(), columns);
+
+  GradingOptions grading;
+  grading.window = o.window;
+  const LabConverter converter;
+  WorkStealingPool pool(o.threads);
+  TaskGroup group(pool);
+  for (const Unit& unit : units) {
+    group.run([&, unit] {
+      const std::size_t n = unit.last - unit.first;
+      const Label& head = labels[unit.first];
+      const History history = load_history(segments, head.node, head.at - o.window,
+                                           labels[unit.last - 1].at);
+      std::vector<std::uint32_t> node(n, head.node), samples(n), has_color(n);
+      std::vector<std::int64_t> at(n);
+      std::vector<std::int32_t> label(n);
+      std::vector<std::vector<float>> features(kFeatureDim, std::vector<float>(n));
+      std::vector<std::vector<float>> color(6, std::vector<float>(n));
+      std::vector<std::uint8_t> pixels;
+      for (std::size_t r = 0; r < n; ++r) {
+        const Label& l = labels[unit.first + r];
+        at[r] = l.at;
+        label[r] = l.label;
+        const WindowView window = history.window(l.at - o.window, l.at);
+        samples[r] = static_cast<std::uint32_t>(window.size());
+        const FeatureVector fv = to_feature_vector(extract_features(window, grading.features));
+        for (std::size_t f = 0; f < kFeatureDim; ++f) features[f][r] = fv[f];
+        if (l.image.empty()) continue;
+        ImageView image;
+        const std::string path = o.images.empty() ? l.image : o.images + "/" + l.image;
+        if (!read_ppm(path, pixels, image)) throw std::runtime_error("cannot read image " + path);
+        const ColorSummary s = summarize_color({&image, 1}, converter, grading);
+        has_color[r] = 1;
+        const float values[6] = {s.mean_l, s.mean_a, s.mean_b, s.a_p10, s.a_p50, s.a_p90};
+        for (std::size_t k = 0; k < 6; ++k) color[k][r] = values[k];
+      }
+      writer.write<std::uint32_t>(0, unit.first, node);
+      writer.write<std::int64_t>(1, unit.first, at);
+      writer.write<std::int32_t>(2, unit.first, label);
+      writer.write<std::uint32_t>(3, unit.first, samples);
+      for (std::size_t f = 0; f < kFeatureDim; ++f) {
+        writer.write<float>(kFirstFeature + f, unit.first, features[f]);
+      }
+      if (!with_color) return;
+      writer.write<std::uint32_t>(first_color, unit.first, has_color);
+      for (std::size_t k = 0; k < 6; ++k) writer.write<float>(first_color + 1 + k, unit.first, color[k]);
+    });
+  }
+  group.wait();
+  writer.finish();
+
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  std::fprintf(stderr, "%zu rows (%zu node-days, shard %llu/%llu) on %zu threads in %.2f s -> %s\n",
+               labels.size(), units.size(), static_cast<unsigned long long>(o.shard),
+               static_cast<unsigned long long>(o.shard_count), pool.thread_count(), seconds,
+               o.out.c_str());
+  return 0;
+}
+
+}  // namespace
+}  // namespace meat_quality
+
+int main(int argc, char** argv) {
+  const meat_quality::Options options = meat_quality::parse_args(argc, argv);
+  try {
+    return meat_quality::run(options);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "error: %s\n", e.what());
+    return 1;
+  }
+}
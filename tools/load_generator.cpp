@@ -0,0 +1,874 @@
+// Load generator and soak harness for a grader's network front end.
+//
+//   mq_load_generator (--connect HOST:PORT | --embedded) [--nodes N]
+//                     [--connections C] [--rate-hz R] [--grade-qps Q]
+//                     [--duration-s S] [--report-s S] [--jitter-ms J]
+//                     [--nodes-per-room K] [--door-opens-per-hour D]
+//                     [--door-open-s S] [--burst-factor B] [--time-scale X]
+//                     [--packed] [--cameras M --camera-fps F FRAME.ppm...]
+//                     [--ring-prefix NAME] [--server-pid PID] [--seed S]
+//                     [--out FILE]
+//
+// Simulates N sensor nodes in cold rooms of K nodes each. Every node's gas
+// and pH channels follow an exponential spoilage curve from its own onset,
+// and a tray past its shelf life is swapped for a fresh one. Each room's
+// door opens about D times an hour for S seconds; while it is open the
+// room warms, dries out and its nodes report B times as often. Nodes are
+// spread over C push connections, and every sample leaves after an
+// exponentially distributed network delay of mean J ms, so samples arrive
+// late and sometimes out of order. One more connection sends Q grade
+// queries a second, open loop, and times each answer. Rate hints from the
+// server are applied to the node they name.
+//
+// With --cameras, M shared-memory rings (NAME0, NAME1, ...) are fed at F
+// frames a second from the recorded frames, in a loop; the grader is
+// expected to map them. --embedded starts an in-process grader on a free
+// port instead of connecting to one, which also consumes the camera rings.
+//
+// Every --report-s seconds one CSV row goes to --out (default stdout):
+// throughput, grade latency percentiles over the interval, drop counts,
+// and the resident memory and CPU use of --server-pid (this process with
+// --embedded). The summary on stderr gives memory growth per hour and
+// nodes per busy core, the numbers to plan capacity with. Write soak logs
+// to `soak_output.txt`, which is ignored like the test and bench outputs.
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "meat_quality/cluster/shard_map.hpp"
+#include "meat_quality/grading/grading_pipeline.hpp"
+#include "meat_quality/image/shm_frame_ring.hpp"
+#include "meat_quality/net/front_end.hpp"
+#include "meat_quality/net/protocol.hpp"
+#include "meat_quality/telemetry/histogram.hpp"
+
+namespace meat_quality {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// A tray past this age (simulated) is replaced by a fresh one.
+constexpr double kShelfLifeHours = 96.0;
+
+// Samples per push frame at most; a gateway batches like this.
+constexpr std::size_t kMaxPushBatch = 512;
+
+// Longest a sender sleeps, so it notices hints and the end of the run.
+constexpr auto kMaxSleep = std::chrono::milliseconds{5};
+
+struct Options {
+  std::string host;
+  std::uint16_t port = 0;
+  bool embedded = false;
+  std::size_t nodes = 1024;
+  std::size_t connections = 4;
+  double rate_hz = 1.0;
+  double grade_qps = 50.0;
+  double duration_s = 60.0;
+  double report_s = 10.0;
+  double jitter_ms = 20.0;
+  std::size_t nodes_per_room = 16;
+  double door_opens_per_hour = 2.0;
+  double door_open_s = 120.0;
+  double burst_factor = 4.0;
+  double time_scale = 1.0;
+  bool packed = false;
+  std::size_t cameras = 0;
+  double camera_fps = 2.0;
+  std::vector<std::string> footage;
+  std::string ring_prefix = "/mq_soak_cam";
+  long server_pid = 0;
+  std::uint64_t seed = 1;
+  std::string out;
+};
+
+[[noreturn]] void usage(const char* error) {
+  std::fprintf(stderr,
+               "error: %s\n"
+               "usage: mq_load_generator (--connect HOST:PORT | --embedded) [--nodes N]\n"
+               "       [--connections C] [--rate-hz R] [--grade-qps Q] [--duration-s S]\n"
+               "       [--report-s S] [--jitter-ms J] [--nodes-per-room K]\n"
+               "       [--door-opens-per-hour D] [--door-open-s S] [--burst-factor B]\n"
+               "       [--time-scale X] [--packed] [--cameras M --camera-fps F FRAME.ppm...]\n"
+               "       [--ring-prefix NAME] [--server-pid PID] [--seed S] [--out FILE]\n",
+               error);
+  std::exit(2);
+}
+
+template <typename T>
+bool parse_number(std::string_view s, T& out) {
+  const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+  return ec == std::errc{} && end == s.data() + s.size();
+}
+
+Options parse_args(int argc, char** argv) {
+  Options o;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const auto value = [&]() -> std::string_view {
+      if (i + 1 >= argc) usage("missing option value");
+      return argv[++i];
+    };
+    const auto number = [&](auto& out) {
+      if (!parse_number(value(), out)) usage("bad number");
+    };
+    if (arg == "--connect") {
+      const std::string_view v = value();
+      const std::size_t colon = v.rfind(':');
+      if (colon == std::string_view::npos || !parse_number(v.substr(colon + 1), o.port)) {
+        usage("--connect wants HOST:PORT");
+      }
+      o.host = std::string(v.substr(0, colon));
+    } else if (arg == "--embedded") {
+      o.embedded = true;
+    } else if (arg == "--nodes") {
+      number(o.nodes);
+    } else if (arg == "--connections") {
+      number(o.connections);
+    } else if (arg == "--rate-hz") {
+      number(o.rate_hz);
+    } else if (arg == "--grade-qps") {
+      number(o.grade_qps);
+    } else if (arg == "--duration-s") {
+      number(o.duration_s);
+    } else if (arg == "--report-s") {
+      number(o.report_s);
+    } else if (arg == "--jitter-ms") {
+      number(o.jitter_ms);
+    } else if (arg == "--nodes-per-room") {
+      number(o.nodes_per_room);
+    } else if (arg == "--door-opens-per-hour") {
+      number(o.door_opens_per_hour);
+    } else if (arg == "--door-open-s") {
+      number(o.door_open_s);
+    } else if (arg == "--burst-factor") {
+      number(o.burst_factor);
+    } else if (arg == "--time-scale") {
+      number(o.time_scale);
+    } else if (arg == "--packed") {
+      o.packed = true;
+    } else if (arg == "--cameras") {
+      number(o.cameras);
+    } else if (arg == "--camera-fps") {
+      number(o.camera_fps);
+    } else if (arg == "--ring-prefix") {
+      o.ring_prefix = std::string(value());
+    } else if (arg == "--server-pid") {
+      number(o.server_pid);
+    } else if (arg == "--seed") {
+      number(o.seed);
+    } else if (arg == "--out") {
+      o.out = std::string(value());
+    } else if (arg.starts_with("--")) {
+      usage("unknown option");
+    } else {
+      o.footage.emplace_back(arg);
+    }
+  }
+  if (o.embedded == !o.host.empty()) usage("give exactly one of --connect and --embedded");
+  if (o.nodes == 0 || o.nodes > std::numeric_limits<NodeId>::max()) usage("bad --nodes");
+  if (o.connections == 0 || o.nodes_per_room == 0) usage("zero connections or room size");
+  if (!(o.rate_hz > 0) || !(o.duration_s > 0) || !(o.report_s > 0) || !(o.burst_factor >= 1)) {
+    usage("rates, durations and the burst factor must be positive");
+  }
+  if (o.jitter_ms < 0 || o.grade_qps < 0 || o.door_opens_per_hour < 0 || o.door_open_s < 0) {
+    usage("negative jitter, query rate or door schedule");
+  }
+  if (o.cameras != 0 && (o.footage.empty() || !(o.camera_fps > 0))) {
+    usage("--cameras needs recorded frames and a positive --camera-fps");
+  }
+  return o;
+}
+
+bool read_ppm(const std::string& path, std::vector<std::uint8_t>& pixels, ImageView& view) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  std::uint32_t width = 0, height = 0, maxval = 0;
+  const auto skip_comments = [&] {
+    while (in >> std::ws && in.peek() == '#') in.ignore(1 << 20, '\n');
+  };
+  in >> magic;
+  skip_comments();
+  in >> width;
+  skip_comments();
+  in >> height;
+  skip_comments();
+  in >> maxval;
+  if (!in || magic != "P6" || maxval != 255 || width == 0 || height == 0) return false;
+  in.get();
+  pixels.resize(std::size_t{width} * height * 3);
+  in.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+  if (!in) return false;
+  view = {pixels.data(), width, height, std::size_t{width} * 3, PixelFormat::kRgb8};
+  return true;
+}
+
+int connect_tcp(const std::string& host, std::uint16_t port) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* found = nullptr;
+  const std::string service = std::to_string(port);
+  if (const int e = ::getaddrinfo(host.c_str(), service.c_str(), &hints, &found); e != 0) {
+    throw std::runtime_error("cannot resolve " + host + ": " + ::gai_strerror(e));
+  }
+  int fd = -1;
+  int error = 0;
+  for (addrinfo* a = found; a != nullptr && fd < 0; a = a->ai_next) {
+    fd = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+    if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      error = errno;
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  ::freeaddrinfo(found);
+  if (fd < 0) throw std::system_error(error, std::generic_category(), "connect " + host);
+  const int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+  return fd;
+}
+
+bool write_all(int fd, const std::uint8_t* p, std::size_t n) {
+  while (n != 0) {
+    const ssize_t k = ::send(fd, p, n, MSG_NOSIGNAL);
+    if (k < 0 && errno == EINTR) continue;
+    if (k <= 0) return false;
+    p += k;
+    n -= static_cast<std::size_t>(k);
+  }
+  return true;
+}
+
+// Whole frames received on a connection, read without blocking.
+class FrameReader {
+ public:
+  explicit FrameReader(int fd) : fd_(fd) {}
+
+  /// Reads what is available; false once the peer has closed.
+  bool poll_read() {
+    std::uint8_t chunk[16384];
+    for (;;) {
+      const ssize_t k = ::recv(fd_, chunk, sizeof chunk, MSG_DONTWAIT);
+      if (k > 0) {
+        buffer_.insert(buffer_.end(), chunk, chunk + k);
+        continue;
+      }
+      if (k < 0 && errno == EINTR) continue;
+      return k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+  }
+
+  /// Next complete frame, or false.
+  bool next(wire::FrameType& type, std::span<const std::uint8_t>& body) {
+    if (pos_ != 0 && pos_ == buffer_.size()) {
+      buffer_.clear();
+      pos_ = 0;
+    }
+    if (buffer_.size() - pos_ < wire::kFrameHeaderBytes) return false;
+    std::uint32_t length = 0;
+    wire::parse_frame_header(buffer_.data() + pos_, length, type);
+    if (length == 0 || buffer_.size() - pos_ < 4 + std::size_t{length}) return false;
+    body = {buffer_.data() + pos_ + wire::kFrameHeaderBytes, length - 1u};
+    pos_ += 4 + std::size_t{length};
+    return true;
+  }
+
+ private:
+  int fd_;
+  std::vector<std::uint8_t> buffer_;
+  std::size_t pos_ = 0;
+};
+
+// Uniform in [0, 1) from a hash, for schedules that must be the same
+// function of time on every thread.
+double unit_hash(std::uint64_t a, std::uint64_t b) noexcept {
+  return static_cast<double>(mix64(mix64(a) ^ b) >> 11) * 0x1p-53;
+}
+
+// Cold rooms, their doors and the nodes in them. Stateless after
+// construction, so every sender thread shares one.
+class ColdRooms {
+ public:
+  explicit ColdRooms(const Options& o) : o_(o), nodes_(o.nodes) {
+    std::mt19937_64 rng(o.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (Node& n : nodes_) {
+      n.age_hours = unit(rng) * kShelfLifeHours;
+      n.onset_hours = 12.0 + 36.0 * unit(rng);
+      n.rate = 0.05 + 0.1 * unit(rng);
+      n.temperature = 1.0 + 2.0 * unit(rng);
+    }
+  }
+
+  std::size_t room_of(NodeId node) const noexcept { return node / o_.nodes_per_room; }
+
+  /// Whether `room`'s door is open `t` seconds into the run. Every hour is
+  /// split into D windows with one opening each, at a hashed offset.
+  bool door_open(std::size_t room, double t) const noexcept {
+    if (o_.door_opens_per_hour <= 0 || o_.door_open_s <= 0) return false;
+    const double window = 3600.0 / o_.door_opens_per_hour;
+    const double k = std::floor(t / window);
+    const double start =
+        k * window + unit_hash(o_.seed ^ room, static_cast<std::uint64_t>(k)) *
+                         std::max(0.0, window - o_.door_open_s);
+    return t >= start && t < start + o_.door_open_s;
+  }
+
+  /// Seconds between `node`'s reports at `t`.
+  double interval(NodeId node, double t) const noexcept {
+    const double base = 1.0 / o_.rate_hz;
+    return door_open(room_of(node), t) ? base / o_.burst_factor : base;
+  }
+
+  SensorSample sample(NodeId node, double t, Timestamp timestamp, std::mt19937_64& rng) const {
+    std::normal_distribution<double> noise(0.0, 1.0);
+    const Node& n = nodes_[node];
+    const double age = std::fmod(n.age_hours + t * o_.time_scale / 3600.0, kShelfLifeHours);
+    const double spoil = std::expm1(n.rate * std::max(0.0, age - n.onset_hours));
+    const double door = door_open(room_of(node), t) ? 1.0 : 0.0;
+    SensorSample s;
+    s.timestamp = timestamp;
+    s[Channel::kNh3] = static_cast<float>(2.0 + 3.0 * spoil + noise(rng) * 0.2);
+    s[Channel::kH2s] = static_cast<float>(0.05 + 0.3 * spoil + noise(rng) * 0.01);
+    s[Channel::kVoc] = static_cast<float>(150.0 + 80.0 * spoil + 40.0 * door + noise(rng) * 5.0);
+    s[Channel::kTemperature] = static_cast<float>(n.temperature + 5.0 * door + noise(rng) * 0.3);
+    s[Channel::kHumidity] = static_cast<float>(88.0 - 15.0 * door + noise(rng));
+    s[Channel::kPh] = static_cast<float>(5.6 + 0.1 * spoil + noise(rng) * 0.02);
+    return s;
+  }
+
+ private:
+  struct Node {
+    double age_hours;
+    double onset_hours;
+    double rate;
+    double temperature;
+  };
+
+  const Options& o_;
+  std::vector<Node> nodes_;
+};
+
+struct SenderStats {
+  std::atomic<std::uint64_t> samples{0};
+  std::atomic<std::uint64_t> frames{0};
+  std::atomic<std::uint64_t> bytes{0};
+  std::atomic<std::uint64_t> hints{0};
+  std::atomic<std::uint64_t> errors{0};
+  telemetry::Histogram lag;  // ns a sample left after its due time
+};
+
+struct GradeStats {
+  std::atomic<std::uint64_t> sent{0};
+  std::atomic<std::uint64_t> ok{0};
+  std::atomic<std::uint64_t> unknown_node{0};
+  std::atomic<std::uint64_t> overloaded{0};
+  std::atomic<std::uint64_t> shutting_down{0};
+  std::atomic<std::uint64_t> errors{0};
+  telemetry::Histogram latency;  // ns from send to answer
+};
+
+struct CameraStats {
+  std::atomic<std::uint64_t> published{0};
+  std::atomic<std::uint64_t> busy{0};     // no free slot to capture into
+  std::atomic<std::uint64_t> dropped{0};  // overwritten unread, from the ring
+  std::atomic<std::uint64_t> graded{0};   // by the embedded grader
+};
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Timestamp wall_micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// Nodes `first, first + stride, ...` on one push connection.
+void run_sender(const Options& o, const ColdRooms& rooms, std::size_t first, int fd,
+                Clock::time_point start, Timestamp wall_start, const std::atomic<bool>& stop,
+                SenderStats& stats) {
+  struct Due {
+    double t;
+    NodeId node;
+    bool operator>(const Due& other) const noexcept { return t > other.t; }
+  };
+  struct InFlight {
+    double t;  // when it reaches the wire
+    double due;
+    IngestRecord record;
+    bool operator>(const InFlight& other) const noexcept { return t > other.t; }
+  };
+  std::mt19937_64 rng(o.seed * 0x9e3779b97f4a7c15ull + first);
+  std::exponential_distribution<double> delay(o.jitter_ms > 0 ? 1e3 / o.jitter_ms : 1.0);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  std::priority_queue<Due, std::vector<Due>, std::greater<>> reports;
+  std::priority_queue<InFlight, std::vector<InFlight>, std::greater<>> wire_queue;
+  std::vector<std::uint32_t> hinted_ms(o.nodes, 0);
+  for (std::size_t n = first; n < o.nodes; n += o.connections) {
+    // Spread the first reports over one interval.
+    reports.push({unit(rng) / o.rate_hz, static_cast<NodeId>(n)});
+  }
+
+  FrameReader reader(fd);
+  std::vector<IngestRecord> batch;
+  std::vector<std::uint8_t> frame;
+  while (!stop.load(std::memory_order_relaxed)) {
+    const double now = seconds_since(start);
+    while (!reports.empty() && reports.top().t <= now) {
+      const Due d = reports.top();
+      reports.pop();
+      const auto ts = wall_start + static_cast<Timestamp>(d.t * 1e6);
+      const IngestRecord record{d.node, rooms.sample(d.node, d.t, ts, rng)};
+      wire_queue.push({d.t + (o.jitter_ms > 0 ? delay(rng) : 0.0), d.t, record});
+      const double interval = hinted_ms[d.node] != 0 && !rooms.door_open(rooms.room_of(d.node), d.t)
+                                  ? hinted_ms[d.node] * 1e-3
+                                  : rooms.interval(d.node, d.t);
+      reports.push({d.t + interval, d.node});
+    }
+
+    batch.clear();
+    while (!wire_queue.empty() && wire_queue.top().t <= now && batch.size() < kMaxPushBatch) {
+      const InFlight& f = wire_queue.top();
+      stats.lag.record(static_cast<std::uint64_t>(std::max(0.0, now - f.t) * 1e9));
+      batch.push_back(f.record);
+      wire_queue.pop();
+    }
+    if (!batch.empty()) {
+      frame.clear();
+      if (o.packed) {
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const IngestRecord& a, const IngestRecord& b) { return a.node < b.node; });
+        wire::append_packed_push(frame, batch);
+      } else {
+        wire::append_sensor_push(frame, batch);
+      }
+      if (!write_all(fd, frame.data(), frame.size())) {
+        stats.errors.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      stats.samples.fetch_add(batch.size(), std::memory_order_relaxed);
+      stats.frames.fetch_add(1, std::memory_order_relaxed);
+      stats.bytes.fetch_add(frame.size(), std::memory_order_relaxed);
+    }
+
+    if (!reader.poll_read()) {
+      stats.errors.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    wire::FrameType type;
+    std::span<const std::uint8_t> body;
+    while (reader.next(type, body)) {
+      wire::RateHintFrame hint;
+      if (type == wire::FrameType::kRateHint && wire::parse_rate_hint(body, hint) &&
+          hint.node < o.nodes) {
+        hinted_ms[hint.node] = hint.interval_ms;
+        stats.hints.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    if (batch.size() == kMaxPushBatch) continue;
+    double next = now + std::chrono::duration<double>(kMaxSleep).count();
+    if (!reports.empty()) next = std::min(next, reports.top().t);
+    if (!wire_queue.empty()) next = std::min(next, wire_queue.top().t);
+    std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>(next)));
+  }
+}
+
+// Open-loop grade queries at o.grade_qps on one connection; answers come
+// back in order, so their send times queue up in order too.
+void run_grades(const Options& o, int fd, Clock::time_point start, const std::atomic<bool>& stop,
+                GradeStats& stats) {
+  std::mt19937_64 rng(o.seed + 7);
+  std::uniform_int_distribution<NodeId> node(0, static_cast<NodeId>(o.nodes - 1));
+  std::exponential_distribution<double> gap(o.grade_qps);
+  FrameReader reader(fd);
+  std::deque<Clock::time_point> outstanding;
+  std::vector<std::uint8_t> frame;
+  std::uint64_t id = 0;
+  double next = gap(rng);
+  while (!stop.load(std::memory_order_relaxed)) {
+    const double now = seconds_since(start);
+    frame.clear();
+    while (next <= now) {
+      wire::append_grade_request(frame, {id++, node(rng), 0});
+      outstanding.push_back(Clock::now());
+      next += gap(rng);
+    }
+    if (!frame.empty()) {
+      if (!write_all(fd, frame.data(), frame.size())) {
+        stats.errors.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      stats.sent.fetch_add(frame.size() / (wire::kFrameHeaderBytes + wire::kGradeRequestBytes),
+                           std::memory_order_relaxed);
+    }
+
+    pollfd p{fd, POLLIN, 0};
+    const double wait_ms = std::clamp((next - seconds_since(start)) * 1e3, 0.0, 5.0);
+    ::poll(&p, 1, static_cast<int>(wait_ms));
+    if (!reader.poll_read()) {
+      stats.errors.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    wire::FrameType type;
+    std::span<const std::uint8_t> body;
+    wire::GradeResponseFrame response;
+    while (reader.next(type, body)) {
+      if (type != wire::FrameType::kGradeResponse || !wire::parse_grade_response(body, response) ||
+          outstanding.empty()) {
+        stats.errors.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      const auto latency = Clock::now() - outstanding.front();
+      outstanding.pop_front();
+      stats.latency.record(static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+      switch (response.status) {
+        case wire::GradeStatus::kOk: stats.ok.fetch_add(1, std::memory_order_relaxed); break;
+        case wire::GradeStatus::kUnknownNode:
+          stats.unknown_node.fetch_add(1, std::memory_order_relaxed);
+          break;
+        case wire::GradeStatus::kOverloaded:
+          stats.overloaded.fetch_add(1, std::memory_order_relaxed);
+          break;
+        case wire::GradeStatus::kShuttingDown:
+          stats.shutting_down.fetch_add(1, std::memory_order_relaxed);
+          break;
+      }
+    }
+  }
+}
+
+// Replays the recorded frames into one ring at o.camera_fps.
+void run_camera(const Options& o, ShmFrameWriter& ring, std::span<const ImageView> frames,
+                Clock::time_point start, const std::atomic<bool>& stop, CameraStats& stats) {
+  const double period = 1.0 / o.camera_fps;
+  for (std::uint64_t k = 0; !stop.load(std::memory_order_relaxed); ++k) {
+    std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>(double(k) * period)));
+    std::uint8_t* dst = ring.begin_frame();
+    if (dst == nullptr) {
+      stats.busy.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    const ImageView& f = frames[k % frames.size()];
+    for (std::uint32_t y = 0; y < f.height; ++y) {
+      std::memcpy(dst + y * ring.stride(), f.row(y), f.row_bytes());
+    }
+    ring.publish(wall_micros());
+    stats.published.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// A grader behind a front end, as in the FrontEnd example, plus one thread
+// per camera ring computing color statistics of every frame.
+class EmbeddedGrader {
+ public:
+  explicit EmbeddedGrader(const Options& o)
+      : store_(o.nodes, 4096),
+        classifier_(ClassifierWeights::random(32, o.seed)),
+        pipeline_(store_, classifier_, converter_),
+        queue_(1 << 16, Backpressure::kReject),
+        front_end_(queue_, broker_, {.host = "127.0.0.1", .port = 0}) {
+    front_end_.start();
+    grader_ = std::thread([this] {
+      std::vector<IngestRecord> batch(1024);
+      while (running_.load(std::memory_order_relaxed)) {
+        drain_batch(queue_, store_, batch, std::chrono::microseconds{200});
+        broker_.serve(pipeline_);
+      }
+    });
+  }
+
+  ~EmbeddedGrader() {
+    // The grading thread keeps serving until every connection has closed.
+    front_end_.stop();
+    running_ = false;
+    grader_.join();
+    for (std::thread& t : cameras_) t.join();
+  }
+
+  std::uint16_t port() const noexcept { return front_end_.port(); }
+  FrontEndStats stats() const noexcept { return front_end_.stats(); }
+  std::uint64_t queue_dropped() const noexcept { return queue_.stats().dropped; }
+
+  void consume(const std::string& ring, CameraStats& stats) {
+    cameras_.emplace_back([this, ring, &stats] {
+      ShmFrameSource source(ring);
+      while (running_.load(std::memory_order_relaxed)) {
+        const FrameRef f = source.acquire(std::chrono::milliseconds{100});
+        if (!f) continue;
+        summarize_color({&f.image(), 1}, converter_);
+        stats.graded.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+ private:
+  SampleStore store_;
+  FreshnessClassifier classifier_;
+  LabConverter converter_;
+  GradingPipeline pipeline_;
+  IngestQueue queue_;
+  GradeBroker broker_;
+  FrontEnd front_end_;
+  std::atomic<bool> running_{true};
+  std::thread grader_;
+  std::vector<std::thread> cameras_;
+};
+
+struct Usage {
+  double rss_mb = 0;
+  double cpu_s = 0;
+};
+
+// Resident memory and CPU time of `pid` from /proc; zeros if unreadable.
+Usage process_usage(long pid) {
+  Usage u;
+  const std::string dir = "/proc/" + (pid == 0 ? std::string("self") : std::to_string(pid));
+  std::ifstream statm(dir + "/statm");
+  std::uint64_t size = 0, resident = 0;
+  if (statm >> size >> resident) {
+    u.rss_mb = double(resident) * double(::sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+  }
+  std::ifstream stat(dir + "/stat");
+  std::string line;
+  if (std::getline(stat, line)) {
+    // Fields after the parenthesized command name; utime and stime are the
+    // 12th and 13th of them.
+    const std::size_t close = line.rfind(')');
+    if (close != std::string::npos) {
+      std::istringstream rest(line.substr(close + 2));
+      std::string field;
+      std::uint64_t utime = 0, stime = 0;
+      for (int i = 0; i < 11 && rest >> field; ++i) {
+      }
+      if (rest >> utime >> stime) u.cpu_s = double(utime + stime) / double(::sysconf(_SC_CLK_TCK));
+    }
+  }
+  return u;
+}
+
+// Latency distribution of the interval between two cumulative snapshots.
+telemetry::HistogramSnapshot interval_of(const telemetry::HistogramSnapshot& now,
+                                         const telemetry::HistogramSnapshot& before) {
+  telemetry::HistogramSnapshot d;
+  for (std::size_t b = 0; b < telemetry::kBucketCount; ++b) {
+    d.counts[b] = now.counts[b] - before.counts[b];
+    if (d.counts[b] != 0) d.max = telemetry::bucket_lower(b) + telemetry::bucket_width(b) - 1;
+  }
+  d.count = now.count - before.count;
+  d.sum = now.sum - before.sum;
+  d.max = std::min(d.max, now.max);
+  return d;
+}
+
+int run(const Options& o) {
+  std::unique_ptr<EmbeddedGrader> embedded;
+  std::string host = o.host;
+  std::uint16_t port = o.port;
+  if (o.embedded) {
+    embedded = std::make_unique<EmbeddedGrader>(o);
+    host = "127.0.0.1";
+    port = embedded->port();
+  }
+  const long pid = o.embedded ? 0 : o.server_pid;
+
+  // Recorded footage, all frames the same size.
+  std::vector<std::vector<std::uint8_t>> pixels(o.cameras != 0 ? o.footage.size() : 0);
+  std::vector<ImageView> frames(pixels.size());
+  for (std::size_t i = 0; i < frames.size(); ++i) {
+    if (!read_ppm(o.footage[i], pixels[i], frames[i])) {
+      throw std::runtime_error("cannot read frame " + o.footage[i]);
+    }
+    if (frames[i].width != frames[0].width || frames[i].height != frames[0].height) {
+      throw std::runtime_error("frame " + o.footage[i] + " differs in size from the first");
+    }
+  }
+  std::vector<std::unique_ptr<ShmFrameWriter>> rings;
+  std::vector<CameraStats> camera_stats(o.cameras);
+  for (std::size_t c = 0; c < o.cameras; ++c) {
+    const std::string name = o.ring_prefix + std::to_string(c);
+    rings.push_back(std::make_unique<ShmFrameWriter>(name, frames[0].width, frames[0].height, 4));
+    if (embedded) embedded->consume(name, camera_stats[c]);
+  }
+
+  // Push connections, then the query connection.
+  std::vector<int> fds;
+  for (std::size_t c = 0; c < o.connections + (o.grade_qps > 0 ? 1 : 0); ++c) {
+    fds.push_back(connect_tcp(host, port));
+  }
+
+  std::FILE* out = stdout;
+  if (!o.out.empty()) {
+    out = std::fopen(o.out.c_str(), "w");
+    if (out == nullptr) throw std::system_error(errno, std::generic_category(), "open " + o.out);
+  }
+  std::fprintf(out,
+               "elapsed_s,samples_per_s,push_mb_per_s,send_lag_p99_ms,rate_hints,grades_per_s,"
+               "grade_p50_ms,grade_p99_ms,grade_p999_ms,grade_max_ms,overloaded,"
+               "unknown_node,frames_per_s,frames_busy,frames_dropped,errors,server_dropped,"
+               "rss_mb,cpu_cores\n");
+  std::fflush(out);
+
+  const ColdRooms rooms(o);
+  std::vector<SenderStats> senders(o.connections);
+  GradeStats grades;
+  std::atomic<bool> stop{false};
+  const Clock::time_point start = Clock::now();
+  const Timestamp wall_start = wall_micros();
+  std::vector<std::thread> threads;
+  for (std::size_t c = 0; c < o.connections; ++c) {
+    threads.emplace_back([&, c] {
+      run_sender(o, rooms, c, fds[c], start, wall_start, stop, senders[c]);
+    });
+  }
+  if (o.grade_qps > 0) {
+    threads.emplace_back([&] { run_grades(o, fds.back(), start, stop, grades); });
+  }
+  for (std::size_t c = 0; c < o.cameras; ++c) {
+    threads.emplace_back([&, c] {
+      run_camera(o, *rings[c], frames, start, stop, camera_stats[c]);
+    });
+  }
+
+  // Cumulative counters at the previous report.
+  struct Totals {
+    double t = 0;
+    std::uint64_t samples = 0, bytes = 0, hints = 0, grades = 0, frames = 0;
+    telemetry::HistogramSnapshot latency, lag;
+    Usage usage;
+  };
+  const auto totals = [&] {
+    Totals s;
+    s.t = seconds_since(start);
+    for (const SenderStats& st : senders) {
+      s.samples += st.samples.load();
+      s.bytes += st.bytes.load();
+      s.hints += st.hints.load();
+      st.lag.add_to(s.lag);
+    }
+    grades.latency.add_to(s.latency);
+    s.grades = s.latency.count;
+    for (const CameraStats& c : camera_stats) s.frames += c.published.load();
+    s.usage = process_usage(pid);
+    return s;
+  };
+  const Totals first = totals();
+  Totals previous = first;
+  double worst_p99_ms = 0;
+  // Resident memory at the first and latest report; the first interval is
+  // warm-up.
+  Usage warm{};
+  double warm_t = 0;
+  for (double next = o.report_s; previous.t < o.duration_s; next += o.report_s) {
+    std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>(
+                                                  std::min(next, o.duration_s))));
+    const Totals now = totals();
+    const double dt = now.t - previous.t;
+    const telemetry::HistogramSnapshot latency = interval_of(now.latency, previous.latency);
+    const telemetry::HistogramSnapshot lag = interval_of(now.lag, previous.lag);
+    std::uint64_t busy = 0, dropped = 0, errors = grades.errors.load();
+    for (std::size_t c = 0; c < o.cameras; ++c) {
+      camera_stats[c].dropped.store(rings[c]->dropped());
+      busy += camera_stats[c].busy.load();
+      dropped += camera_stats[c].dropped.load();
+    }
+    for (const SenderStats& st : senders) errors += st.errors.load();
+    const std::uint64_t server_dropped =
+        embedded ? embedded->stats().samples_dropped + embedded->queue_dropped() : 0;
+    const double p99_ms = double(latency.quantile(0.99)) / 1e6;
+    worst_p99_ms = std::max(worst_p99_ms, p99_ms);
+    if (warm_t == 0) {
+      warm = now.usage;
+      warm_t = now.t;
+    }
+    std::fprintf(out,
+                 "%.1f,%.0f,%.3f,%.2f,%llu,%.1f,%.2f,%.2f,%.2f,%.2f,%llu,%llu,%.1f,%llu,%llu,%llu,"
+                 "%llu,%.1f,%.2f\n",
+                 now.t, double(now.samples - previous.samples) / dt,
+                 double(now.bytes - previous.bytes) / dt / 1e6, double(lag.quantile(0.99)) / 1e6,
+                 static_cast<unsigned long long>(now.hints),
+                 double(now.grades - previous.grades) / dt,
+                 double(latency.quantile(0.50)) / 1e6, p99_ms,
+                 double(latency.quantile(0.999)) / 1e6, double(latency.max) / 1e6,
+                 static_cast<unsigned long long>(grades.overloaded.load()),
+                 static_cast<unsigned long long>(grades.unknown_node.load()),
+                 double(now.frames - previous.frames) / dt, static_cast<unsigned long long>(busy),
+                 static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(errors),
+                 static_cast<unsigned long long>(server_dropped), now.usage.rss_mb,
+                 (now.usage.cpu_s - previous.usage.cpu_s) / dt);
+    std::fflush(out);
+    previous = now;
+  }
+
+  stop = true;
+  for (std::thread& t : threads) t.join();
+  for (const int fd : fds) ::close(fd);
+  if (out != stdout) std::fclose(out);
+
+  const double growth = previous.usage.rss_mb - warm.rss_mb;
+  const double span_hours = (previous.t - warm_t) / 3600.0;
+  const double cores = (previous.usage.cpu_s - first.usage.cpu_s) / (previous.t - first.t);
+  std::fprintf(stderr,
+               "%zu nodes at %.2f Hz over %zu connections for %.0f s: %.0f samples/s, "
+               "%.1f grades/s, worst interval p99 %.2f ms\n",
+               o.nodes, o.rate_hz, o.connections, previous.t,
+               double(previous.samples - first.samples) / (previous.t - first.t),
+               double(previous.grades - first.grades) / (previous.t - first.t), worst_p99_ms);
+  if (pid != 0 || o.embedded) {
+    std::fprintf(stderr, "rss %.1f MB, growth %.1f MB (%.1f MB/h), %.2f busy cores",
+                 previous.usage.rss_mb, growth, span_hours > 0 ? growth / span_hours : 0.0,
+                 cores);
+    if (cores > 0) std::fprintf(stderr, ", %.0f nodes per core", double(o.nodes) / cores);
+    std::fprintf(stderr, "%s\n", o.embedded ? " (including the generator)" : "");
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace meat_quality
+
+int main(int argc, char** argv) {
+  const meat_quality::Options options = meat_quality::parse_args(argc, argv);
+  try {
+    return meat_quality::run(options);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "error: %s\n", e.what());
+    return 1;
+  }
+}